@@ -35,6 +35,7 @@ DEFINES+=-DDISABLE_TFTP
 DEFINES+=-DENABLE_HTTPD
 DEFINES+=-DCONFIG_STORE_USE_FILE 
 DEFINES+=-DCONFIG_MDNS_DOMAIN_REVERSE
+DEFINES+=-DCONFIG_MDNS_ENABLE_QUERIER
 DEFINES+=-DISABLE_INTERNAL_RTC
 DEFINES+=$(addprefix -I,$(EXTRA_INCLUDES))
 
@@ -17,6 +17,7 @@ DEFINES+=-DDISABLE_TFTP
 DEFINES+=-DENABLE_HTTPD
 DEFINES+=-DCONFIG_STORE_USE_FILE 
 DEFINES+=-DCONFIG_MDNS_DOMAIN_REVERSE
+DEFINES+=-DCONFIG_MDNS_ENABLE_QUERIER
 DEFINES+=-DDISABLE_INTERNAL_RTC
 
 ifeq ($(findstring ARTNET_VERSION=4,$(DEFINES)),ARTNET_VERSION=4)
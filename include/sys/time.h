@@ -52,6 +52,10 @@ extern "C" {
 
 extern int gettimeofday(struct timeval *tv, struct timezone *tz);
 extern int settimeofday(const struct timeval *tv, const struct timezone *tz);
+/*
+ * The clock is slewed by delta with at most 500 ppm, a new delta replaces the remaining one.
+ */
+extern int adjtime(const struct timeval *delta, struct timeval *olddelta);
 
 #ifdef __cplusplus
 }
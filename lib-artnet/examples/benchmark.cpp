@@ -0,0 +1,118 @@
+/**
+ * @file benchmark.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Transmit throughput of ArtNetController, reported in universes per second.
+ * Each frame is sent with HandleDmxOut() (one sendto() per datagram) and with
+ * HandleDmxOutQueued() + HandleDmxOutFlush() (one sendmmsg() per frame).
+ * Usage: benchmark ip_address|interface_name [universes] [frames] [subscribers]
+ * With subscribers > 0 the poll table is filled with simulated nodes at the
+ * addresses following the local IP, and the unicast path is measured.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+#include "hardware.h"
+#include "network.h"
+#include "artnetcontroller.h"
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+static void subscribers_add(ArtNetController& controller, uint32_t nSubscribers, uint32_t nUniverses) {
+	artnet::ArtPollReply reply;
+
+	for (uint32_t nNode = 0; nNode < nSubscribers; nNode++) {
+		const auto nIp = __builtin_bswap32(__builtin_bswap32(Network::Get()->GetIp()) + 1 + nNode);
+
+		for (uint32_t nUniverse = 0; nUniverse < nUniverses; nUniverse += artnet::PORTS) {
+			memset(&reply, 0, sizeof(reply));
+			memcpy(reply.IPAddress, &nIp, 4);
+			reply.BindIndex = static_cast<uint8_t>(1 + nUniverse / artnet::PORTS);
+			reply.NetSwitch = static_cast<uint8_t>((nUniverse >> 8) & 0x7F);
+			reply.SubSwitch = static_cast<uint8_t>((nUniverse >> 4) & 0x0F);
+
+			for (uint32_t nPort = 0; nPort < artnet::PORTS; nPort++) {
+				reply.PortTypes[nPort] = static_cast<uint8_t>(artnet::PortType::OUTPUT_ARTNET);
+				reply.SwOut[nPort] = static_cast<uint8_t>((nUniverse + nPort) & 0x0F);
+			}
+
+			controller.Add(&reply);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	Hardware hw;
+	Network nw(argc, argv);
+
+	const auto nUniverses = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 64U;
+	const auto nFrames = (argc > 3) ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 0)) : 1000U;
+	const auto nSubscribers = (argc > 4) ? static_cast<uint32_t>(strtoul(argv[4], nullptr, 0)) : 0U;
+
+	ArtNetController controller;
+
+	controller.SetUnicast(nSubscribers != 0);
+	controller.SetSynchronization(true);
+	controller.Start();
+
+	subscribers_add(controller, nSubscribers, nUniverses);
+
+	uint8_t dmxData[512];
+
+	printf("Art-Net %u universes, %u frames, %u subscriber(s)\n", nUniverses, nFrames, nSubscribers);
+
+	for (uint32_t nMode = 0; nMode < 2; nMode++) {
+		const auto nStart = micros();
+
+		for (uint32_t nFrame = 0; nFrame < nFrames; nFrame++) {
+			memset(dmxData, static_cast<int>(nFrame), sizeof(dmxData));
+
+			for (uint32_t nUniverse = 0; nUniverse < nUniverses; nUniverse++) {
+				if (nMode == 0) {
+					controller.HandleDmxOut(static_cast<uint16_t>(nUniverse), dmxData, sizeof(dmxData));
+				} else {
+					controller.HandleDmxOutQueued(static_cast<uint16_t>(nUniverse), dmxData, sizeof(dmxData));
+				}
+			}
+
+			controller.HandleSync();
+		}
+
+		const auto nElapsed = micros() - nStart;
+		const auto nTotal = static_cast<uint64_t>(nUniverses) * nFrames;
+
+		printf("%-10s %8.2f us/frame %10.0f universes/s\n", nMode == 0 ? "SendTo" : "Queued",
+				static_cast<double>(nElapsed) / nFrames, static_cast<double>(nTotal) * 1e6 / static_cast<double>(nElapsed));
+	}
+
+	return 0;
+}
@@ -0,0 +1,475 @@
+/**
+ * @file dmxin.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The DMX input of an Art-Net 4 node, port 0 is Art-Net and port 1 is sACN.
+ * Stand-ins for the DMX receiver, the UDP layer and the configuration store.
+ * The time is simulated, the node runs every 1 ms, a DMX frame is received every 23 ms.
+ *
+ * - Only the received slots are sent: ArtDmx with an even Length 2 - 512,
+ *   sACN with the START Code and the slots.
+ * - Changed data is sent at once. Unchanged data is sent as keep-alive
+ *   every second, also while the input is active.
+ * - When the input stops, the last data is sent as keep-alive.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "artnetnode.h"
+#include "e131packets.h"
+#include "dmx.h"
+#include "configstore.h"
+#include "network.h"
+#include "hardware.h"
+
+static constexpr uint32_t FRAME_MILLIS = 23;
+static constexpr uint32_t PORTS = 2;
+static constexpr uint32_t PORT_ARTNET = 0;
+static constexpr uint32_t PORT_SACN = 1;
+
+static constexpr uint32_t ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+	return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+
+static constexpr uint32_t IP_LOCAL = ip(192, 168, 2, 10);
+static constexpr uint32_t IP_NETMASK = ip(255, 255, 255, 0);
+
+/*
+ * The simulated time
+ */
+
+static uint32_t s_nMillis = 100000;
+
+Hardware *Hardware::s_pThis;
+
+Hardware::Hardware() {
+	s_pThis = this;
+}
+
+uint32_t Hardware::Millis() {
+	return s_nMillis;
+}
+
+void Hardware::SetMode(hardware::ledblink::Mode mode) {
+	m_Mode = mode;
+}
+
+void Hardware::SetModeWithLock(hardware::ledblink::Mode mode, [[maybe_unused]] bool doLock) {
+	m_Mode = mode;
+}
+
+const char *Hardware::GetSysName(uint8_t &nLength) {
+	nLength = 5;
+	return "Linux";
+}
+
+const char *Hardware::GetBoardName(uint8_t &nLength) {
+	nLength = 5;
+	return "dmxin";
+}
+
+bool Hardware::SetTime([[maybe_unused]] const struct tm *pTime) {
+	return true;
+}
+
+/*
+ * The DMX receiver, a frame is available once, the changed data is compared with the previous frame
+ */
+
+struct Input {
+	struct Data data;
+	uint8_t previous[dmx::buffer::SIZE];
+	uint32_t nPreviousLength;
+	uint32_t nFrames;
+	uint32_t nFramesPrevious;
+	uint32_t nUpdatesPerSecond;
+	uint32_t nMillisPrevious;
+	bool isAvailable;
+};
+
+static Input s_Input[PORTS];
+
+Dmx *Dmx::s_pThis;
+
+Dmx::Dmx() {
+	s_pThis = this;
+}
+
+void Dmx::SetPortDirection([[maybe_unused]] uint32_t nPortIndex, [[maybe_unused]] dmx::PortDirection portDirection, [[maybe_unused]] bool bEnableData) {}
+
+const uint8_t *Dmx::GetDmxChanged(uint32_t nPortIndex) {
+	auto &input = s_Input[nPortIndex];
+
+	if (!input.isAvailable) {
+		return nullptr;
+	}
+
+	input.isAvailable = false;
+
+	const auto nLength = 1U + input.data.Statistics.nSlotsInPacket;
+
+	if ((input.nPreviousLength == nLength) && (memcmp(input.previous, input.data.Data, nLength) == 0)) {
+		return nullptr;
+	}
+
+	memcpy(input.previous, input.data.Data, nLength);
+	input.nPreviousLength = nLength;
+
+	return input.data.Data;
+}
+
+const uint8_t *Dmx::GetDmxCurrentData(uint32_t nPortIndex) {
+	return s_Input[nPortIndex].data.Data;
+}
+
+uint32_t Dmx::GetDmxUpdatesPerSecond(uint32_t nPortIndex) {
+	auto &input = s_Input[nPortIndex];
+
+	if ((s_nMillis - input.nMillisPrevious) >= 1000U) {
+		input.nUpdatesPerSecond = input.nFrames - input.nFramesPrevious;
+		input.nFramesPrevious = input.nFrames;
+		input.nMillisPrevious = s_nMillis;
+	}
+
+	return input.nUpdatesPerSecond;
+}
+
+static void dmx_receive(uint32_t nPortIndex, const uint8_t *pSlots, uint32_t nSlots) {
+	auto &input = s_Input[nPortIndex];
+
+	input.data.Data[0] = 0;	// START Code
+	memcpy(&input.data.Data[1], pSlots, nSlots);
+	input.data.Statistics.nSlotsInPacket = nSlots;
+	input.isAvailable = true;
+	input.nFrames++;
+}
+
+/*
+ * The UDP layer, the sent ArtDmx and sACN data packets are kept
+ */
+
+struct Sent {
+	uint8_t data[1024];
+	uint16_t nLength;
+	uint32_t nToIp;
+	uint32_t nPackets;
+	uint32_t nMillis;
+	uint32_t nIntervalMax;		///< The longest time between two packets
+};
+
+static Sent s_Sent[PORTS];
+
+Network *Network::s_pThis;
+
+Network::Network([[maybe_unused]] int argc, [[maybe_unused]] char **argv) {
+	s_pThis = this;
+	m_nLocalIp = IP_LOCAL;
+	m_nNetmask = IP_NETMASK;
+}
+
+Network::~Network() {
+	s_pThis = nullptr;
+}
+
+int32_t Network::Begin(uint16_t nPort) {
+	return nPort;
+}
+
+void Network::JoinGroup([[maybe_unused]] int32_t nHandle, [[maybe_unused]] uint32_t nIp) {}
+void Network::LeaveGroup([[maybe_unused]] int32_t nHandle, [[maybe_unused]] uint32_t nIp) {}
+void Network::MacAddressCopyTo(uint8_t *pMacAddress) {
+	memset(pMacAddress, 0x02, 6);
+}
+void Network::SetIp(uint32_t nIp) {
+	m_nLocalIp = nIp;
+}
+void Network::SetNetmask(uint32_t nNetmask) {
+	m_nNetmask = nNetmask;
+}
+void Network::SetGatewayIp(uint32_t nGatewayIp) {
+	m_nGatewayIp = nGatewayIp;
+}
+
+uint16_t Network::RecvFrom([[maybe_unused]] int32_t nHandle, [[maybe_unused]] void *pBuffer, [[maybe_unused]] uint16_t nLength, [[maybe_unused]] uint32_t *pFromIp, [[maybe_unused]] uint16_t *pFromPort) {
+	return 0;
+}
+
+uint16_t Network::RecvFrom([[maybe_unused]] int32_t nHandle, [[maybe_unused]] const void **ppBuffer, [[maybe_unused]] uint32_t *pFromIp, [[maybe_unused]] uint16_t *pFromPort) {
+	return 0;
+}
+
+static void sent_add(uint32_t nPortIndex, const void *pBuffer, uint16_t nLength, uint32_t nToIp) {
+	auto &sent = s_Sent[nPortIndex];
+
+	if (sent.nPackets != 0) {
+		sent.nIntervalMax = std::max(sent.nIntervalMax, s_nMillis - sent.nMillis);
+	}
+
+	memcpy(sent.data, pBuffer, std::min(static_cast<size_t>(nLength), sizeof(sent.data)));
+	sent.nLength = nLength;
+	sent.nToIp = nToIp;
+	sent.nPackets++;
+	sent.nMillis = s_nMillis;
+}
+
+void Network::SendTo([[maybe_unused]] int32_t nHandle, const void *pBuffer, uint16_t nLength, uint32_t nToIp, uint16_t nRemotePort) {
+	if (nRemotePort == artnet::UDP_PORT) {
+		const auto *pArtDmx = reinterpret_cast<const artnet::ArtDmx *>(pBuffer);
+
+		if (pArtDmx->OpCode == static_cast<uint16_t>(artnet::OpCodes::OP_DMX)) {
+			sent_add(pArtDmx->Physical, pBuffer, nLength, nToIp);
+		}
+
+		return;
+	}
+
+	if (nRemotePort == e131::UDP_PORT) {
+		const auto *pPacket = reinterpret_cast<const TE131DataPacket *>(pBuffer);
+
+		if (pPacket->RootLayer.Vector == __builtin_bswap32(e131::vector::root::DATA)) {
+			sent_add(PORT_SACN, pBuffer, nLength, nToIp);
+		}
+	}
+}
+
+/*
+ * The configuration store and the display are not used
+ */
+
+StoreDevice::StoreDevice() {}
+StoreDevice::~StoreDevice() {}
+
+ConfigStore *ConfigStore::s_pThis;
+
+ConfigStore::ConfigStore() {
+	s_pThis = this;
+}
+
+bool ConfigStore::Flash() {
+	return false;
+}
+
+void ConfigStore::Update([[maybe_unused]] configstore::Store store, [[maybe_unused]] uint32_t nOffset, [[maybe_unused]] const void *pData, [[maybe_unused]] uint32_t nDataLength, [[maybe_unused]] uint32_t nSetList, [[maybe_unused]] uint32_t nOffsetSetList) {}
+void ConfigStore::Copy([[maybe_unused]] const configstore::Store store, [[maybe_unused]] void *pData, [[maybe_unused]] uint32_t nDataLength, [[maybe_unused]] uint32_t nOffset, [[maybe_unused]] const bool doUpdate) {}
+
+namespace artnetnode {
+namespace configstore {
+uint32_t DMXPORT_OFFSET = 0;
+}  // namespace configstore
+}  // namespace artnetnode
+
+namespace artnet {
+void display_longname([[maybe_unused]] const char *pLongName) {}
+void display_universe_switch([[maybe_unused]] uint32_t nPortIndex, [[maybe_unused]] uint8_t nAddress) {}
+void display_merge_mode([[maybe_unused]] uint32_t nPortIndex, [[maybe_unused]] lightset::MergeMode mergeMode) {}
+void display_port_protocol([[maybe_unused]] uint32_t nPortIndex, [[maybe_unused]] artnet::PortProtocol portProtocol) {}
+void display_failsafe([[maybe_unused]] uint8_t nFailsafe) {}
+}  // namespace artnet
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nPortIndex) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s port %u\n", pTest, nPortIndex);
+		}
+	}
+}
+
+/*
+ * The slots in the last sent packet
+ */
+
+static uint32_t sent_slots(uint32_t nPortIndex, const uint8_t **ppSlots) {
+	const auto &sent = s_Sent[nPortIndex];
+
+	if (nPortIndex == PORT_ARTNET) {
+		const auto *pArtDmx = reinterpret_cast<const artnet::ArtDmx *>(sent.data);
+		const auto nLength = (static_cast<uint32_t>(pArtDmx->LengthHi) << 8) | pArtDmx->Length;
+		check(sent.nLength == sizeof(struct artnet::ArtDmx) - artnet::DMX_LENGTH + nLength, "ArtDmx size", nPortIndex);
+		check((nLength >= 2) && (nLength <= artnet::DMX_LENGTH) && ((nLength & 0x1) == 0), "ArtDmx Length is even 2 - 512", nPortIndex);
+		check(sent.nToIp == (IP_LOCAL | ~IP_NETMASK), "ArtDmx broadcast", nPortIndex);
+		*ppSlots = pArtDmx->Data;
+		return nLength;
+	}
+
+	const auto *pPacket = reinterpret_cast<const TE131DataPacket *>(sent.data);
+	const auto nCount = __builtin_bswap16(pPacket->DMPLayer.PropertyValueCount);
+	check(sent.nLength == DATA_PACKET_SIZE(nCount), "sACN size", nPortIndex);
+	check(pPacket->DMPLayer.PropertyValues[0] == 0, "sACN START Code", nPortIndex);
+	check((sent.nToIp & 0xFFFF) == ip(239, 255, 0, 0), "sACN multicast", nPortIndex);
+	*ppSlots = &pPacket->DMPLayer.PropertyValues[1];
+	return nCount - 1U;
+}
+
+static void run(ArtNetNode& node, uint32_t nMillis, const uint8_t *pSlots[PORTS], uint32_t nSlots) {
+	for (uint32_t i = 0; i < nMillis; i++) {
+		if ((pSlots != nullptr) && ((s_nMillis % FRAME_MILLIS) == 0)) {
+			for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+				dmx_receive(nPortIndex, pSlots[nPortIndex], nSlots);
+			}
+		}
+
+		node.Run();
+		s_nMillis++;
+	}
+}
+
+int main() {
+	Hardware hw;
+	Network nw(0, nullptr);
+	ConfigStore configStore;
+	Dmx dmx;
+
+	ArtNetNode node;
+
+	node.SetPortProtocol4(PORT_ARTNET, artnet::PortProtocol::ARTNET);
+	node.SetUniverse(PORT_ARTNET, lightset::PortDir::INPUT, 1);
+	node.SetPortProtocol4(PORT_SACN, artnet::PortProtocol::SACN);
+	node.SetUniverse(PORT_SACN, lightset::PortDir::INPUT, 2);
+	node.Start();
+
+	uint8_t slots[PORTS][dmx::buffer::SIZE];
+	const uint8_t *pSlots[PORTS] = { slots[0], slots[1] };
+
+	/*
+	 * The packet holds the received slots only
+	 */
+
+	const uint32_t nSlotCounts[] = { 24, 25, 1, 0, 511, 512, 24 };
+	uint32_t nArtDmxBytes = 0;
+
+	for (uint32_t i = 0; i < sizeof(nSlotCounts) / sizeof(nSlotCounts[0]); i++) {
+		const auto nSlots = nSlotCounts[i];
+		uint32_t nPackets[PORTS];
+
+		for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+			memset(slots[nPortIndex], static_cast<int>(0x10 * (1 + i) + nPortIndex), dmx::buffer::SIZE);
+			dmx_receive(nPortIndex, slots[nPortIndex], nSlots);
+			nPackets[nPortIndex] = s_Sent[nPortIndex].nPackets;
+		}
+
+		node.Run();
+		s_nMillis++;
+
+		for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+			check(s_Sent[nPortIndex].nPackets == nPackets[nPortIndex] + 1, "changed data is sent at once", nPortIndex);
+
+			const uint8_t *pSent;
+			const auto nLength = sent_slots(nPortIndex, &pSent);
+
+			if (nPortIndex == PORT_ARTNET) {
+				const auto nExpected = (nSlots == 0) ? 2U : (nSlots + (nSlots & 0x1));
+				check(nLength == nExpected, "ArtDmx Length", nPortIndex);
+				check((nSlots == nExpected) || (pSent[nExpected - 1] == 0), "ArtDmx padding", nPortIndex);
+				nArtDmxBytes += s_Sent[nPortIndex].nLength;
+			} else {
+				check(nLength == nSlots, "sACN slots", nPortIndex);
+			}
+
+			check(memcmp(pSent, slots[nPortIndex], nSlots) == 0, "data", nPortIndex);
+		}
+
+		printf("%3u slots: ArtDmx %3u bytes, sACN %3u bytes\n", nSlots, s_Sent[PORT_ARTNET].nLength, s_Sent[PORT_SACN].nLength);
+	}
+
+	const auto& statistics = node.GetInputStatistics(PORT_ARTNET);
+	check(statistics.nBytes == nArtDmxBytes, "statistics bytes", PORT_ARTNET);
+
+	/*
+	 * Active input with unchanged data: the keep-alive only
+	 */
+
+	for (auto& sent : s_Sent) {
+		sent.nIntervalMax = 0;
+	}
+
+	const auto nKeepAlive = statistics.nKeepAlivePackets;
+	uint32_t nPackets[PORTS] = { s_Sent[0].nPackets, s_Sent[1].nPackets };
+
+	run(node, 5500, pSlots, 24);
+
+	for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+		const auto nSent = s_Sent[nPortIndex].nPackets - nPackets[nPortIndex];
+		printf("Active, unchanged, 5.5 s: port %u, %u packets sent, %u frames received\n", nPortIndex, nSent, 5500 / FRAME_MILLIS);
+		check(nSent == 5, "unchanged data, keep-alive every second", nPortIndex);
+		check(s_Sent[nPortIndex].nIntervalMax <= artnet::DMX_INPUT_KEEP_ALIVE_MILLIS, "keep-alive interval", nPortIndex);
+	}
+
+	check(statistics.nKeepAlivePackets - nKeepAlive == 5, "statistics keep-alive", PORT_ARTNET);
+
+	/*
+	 * A changed slot is sent in the same millisecond
+	 */
+
+	for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+		slots[nPortIndex][10] ^= 0xFF;
+		nPackets[nPortIndex] = s_Sent[nPortIndex].nPackets;
+	}
+
+	while (s_Sent[PORT_ARTNET].nPackets == nPackets[PORT_ARTNET]) {
+		run(node, 1, pSlots, 24);
+	}
+
+	for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+		check(s_Sent[nPortIndex].nPackets == nPackets[nPortIndex] + 1, "changed slot is sent", nPortIndex);
+		check((s_nMillis - 1 - s_Sent[nPortIndex].nMillis) == 0, "changed slot latency", nPortIndex);
+
+		const uint8_t *pSent;
+		sent_slots(nPortIndex, &pSent);
+		check(pSent[10] == slots[nPortIndex][10], "changed slot", nPortIndex);
+	}
+
+	/*
+	 * The input stops: the last data is kept alive
+	 */
+
+	for (auto& sent : s_Sent) {
+		sent.nIntervalMax = 0;
+		nPackets[&sent - s_Sent] = sent.nPackets;
+	}
+
+	run(node, 5500, nullptr, 0);
+
+	for (uint32_t nPortIndex = 0; nPortIndex < PORTS; nPortIndex++) {
+		const auto nSent = s_Sent[nPortIndex].nPackets - nPackets[nPortIndex];
+		printf("Stopped, 5.5 s: port %u, %u packets sent\n", nPortIndex, nSent);
+		check((nSent >= 5) && (nSent <= 6), "stopped input, keep-alive", nPortIndex);
+		check(s_Sent[nPortIndex].nIntervalMax <= artnet::DMX_INPUT_KEEP_ALIVE_MILLIS, "keep-alive interval", nPortIndex);
+
+		const uint8_t *pSent;
+		const auto nLength = sent_slots(nPortIndex, &pSent);
+		check((nLength >= 24) && (memcmp(pSent, slots[nPortIndex], 24) == 0), "last data", nPortIndex);
+	}
+
+	node.Stop();
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
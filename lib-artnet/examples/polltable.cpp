@@ -0,0 +1,172 @@
+/**
+ * @file polltable.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Synthetic ArtPollReply generator for ArtNetPollTable.
+ * Every node reports [universes] output universes, spread as ArtPollReply binds of 4 ports,
+ * over a Port-Address range of [nodes] * [universes] / 4. It reports the time for filling
+ * the table, refreshing it, the universe to subscriber lookup and a full Clean() cycle.
+ * Usage: polltable [nodes] [universes per node] [lookups]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <sys/time.h>
+
+#include "hardware.h"
+#include "artnetpolltable.h"
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+static uint32_t s_nRandom = 0x12345678;
+
+static uint32_t random_next() {
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return s_nRandom;
+}
+
+int main(int argc, char **argv) {
+	Hardware hw;
+
+	auto nNodes = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 0)) : 1000U;
+	auto nNodeUniverses = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 8U;
+	const auto nLookups = (argc > 3) ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 0)) : 1000000U;
+
+	if (nNodes > artnet::POLL_TABLE_SIZE_ENRIES) {
+		nNodes = artnet::POLL_TABLE_SIZE_ENRIES;
+	}
+
+	if (nNodeUniverses > artnet::POLL_TABLE_SIZE_NODE_UNIVERSES) {
+		nNodeUniverses = artnet::POLL_TABLE_SIZE_NODE_UNIVERSES;
+	}
+
+	nNodeUniverses = (nNodeUniverses + artnet::PORTS - 1) & ~(artnet::PORTS - 1);
+
+	auto nUniverseRange = (nNodes * nNodeUniverses) / 4;
+
+	if (nUniverseRange > artnet::POLL_TABLE_SIZE_UNIVERSES) {
+		nUniverseRange = artnet::POLL_TABLE_SIZE_UNIVERSES;
+	}
+
+	nUniverseRange &= ~(artnet::PORTS - 1);
+
+	const auto nBinds = nNodeUniverses / artnet::PORTS;
+	auto *pReplies = new artnet::ArtPollReply[nNodes * nBinds];
+	assert(pReplies != nullptr);
+
+	for (uint32_t nNode = 0; nNode < nNodes; nNode++) {
+		// 10.x.y.z, unique per node
+		const auto nIp = __builtin_bswap32(0x0A000000 | (((nNode * 2654435761U) ^ 0x5A5A5A) & 0x00FFFFFF));
+
+		for (uint32_t nBind = 0; nBind < nBinds; nBind++) {
+			auto *pReply = &pReplies[nNode * nBinds + nBind];
+			memset(pReply, 0, sizeof(artnet::ArtPollReply));
+			memcpy(pReply->IPAddress, &nIp, 4);
+			pReply->BindIndex = static_cast<uint8_t>(1 + nBind);
+
+			const auto nUniverse = (random_next() % nUniverseRange) & ~(artnet::PORTS - 1);
+			pReply->NetSwitch = static_cast<uint8_t>((nUniverse >> 8) & 0x7F);
+			pReply->SubSwitch = static_cast<uint8_t>((nUniverse >> 4) & 0x0F);
+
+			for (uint32_t nPort = 0; nPort < artnet::PORTS; nPort++) {
+				pReply->PortTypes[nPort] = static_cast<uint8_t>(artnet::PortType::OUTPUT_ARTNET);
+				pReply->SwOut[nPort] = static_cast<uint8_t>((nUniverse + nPort) & 0x0F);
+			}
+		}
+	}
+
+	ArtNetPollTable pollTable;
+
+	printf("%u nodes, %u universes per node, Port-Address range %u\n", nNodes, nNodeUniverses, nUniverseRange);
+
+	auto nStart = micros();
+
+	for (uint32_t nIndex = 0; nIndex < nNodes * nBinds; nIndex++) {
+		pollTable.Add(&pReplies[nIndex]);
+	}
+
+	auto nElapsed = micros() - nStart;
+	printf("Fill    : %8.3f ms, %6.3f us/reply\n", static_cast<double>(nElapsed) / 1000, static_cast<double>(nElapsed) / (nNodes * nBinds));
+
+	nStart = micros();
+
+	for (uint32_t nIndex = 0; nIndex < nNodes * nBinds; nIndex++) {
+		pollTable.Add(&pReplies[nIndex]);
+	}
+
+	nElapsed = micros() - nStart;
+	printf("Refresh : %8.3f ms, %6.3f us/reply\n", static_cast<double>(nElapsed) / 1000, static_cast<double>(nElapsed) / (nNodes * nBinds));
+
+	uint32_t nSubscribers = 0;
+	uint32_t nUniverses = 0;
+
+	for (uint32_t nUniverse = 0; nUniverse < nUniverseRange; nUniverse++) {
+		const auto *pUniverses = pollTable.GetIpAddress(static_cast<uint16_t>(nUniverse));
+
+		if (pUniverses != nullptr) {
+			nSubscribers += pUniverses->nCount;
+			nUniverses++;
+		}
+	}
+
+	printf("Table   : %u nodes, %u universes, %u subscriptions\n", pollTable.GetEntries(), nUniverses, nSubscribers);
+
+	uint32_t nChecksum = 0;
+
+	nStart = micros();
+
+	for (uint32_t nIndex = 0; nIndex < nLookups; nIndex++) {
+		const auto *pUniverses = pollTable.GetIpAddress(static_cast<uint16_t>(nIndex % nUniverseRange));
+
+		if (pUniverses != nullptr) {
+			nChecksum += pUniverses->nCount;
+		}
+	}
+
+	nElapsed = micros() - nStart;
+	printf("Lookup  : %8.3f ms, %6.1f ns/lookup [%u]\n", static_cast<double>(nElapsed) / 1000, static_cast<double>(nElapsed) * 1000 / nLookups, nChecksum);
+
+	// Nothing has timed out: a full cycle only visits
+	nStart = micros();
+
+	for (uint32_t nIndex = 0; nIndex < nNodes * artnet::POLL_TABLE_SIZE_NODE_UNIVERSES; nIndex++) {
+		pollTable.Clean();
+	}
+
+	nElapsed = micros() - nStart;
+	printf("Clean   : %8.3f ms, %6.3f us/node\n", static_cast<double>(nElapsed) / 1000, static_cast<double>(nElapsed) / nNodes);
+
+	delete[] pReplies;
+
+	return 0;
+}
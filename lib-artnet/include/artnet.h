@@ -56,6 +56,7 @@ static constexpr uint32_t ESTA_SIZE = 2;
 static constexpr char NODE_ID[] = "Art-Net";			///< Array of 8 characters, the final character is a null termination. Value = A r t - N e t 0x00
 static constexpr uint32_t MERGE_TIMEOUT_SECONDS = 10;
 static constexpr uint32_t NETWORK_DATA_LOSS_TIMEOUT = 10;	///< Seconds
+static constexpr uint32_t DMX_INPUT_KEEP_ALIVE_MILLIS = 1000;	///< Unchanged input data is re-transmitted with this interval
 
 enum class PortProtocol {
 	ARTNET,	///< Output both DMX512 and RDM packets from the Art-Net protocol (default).
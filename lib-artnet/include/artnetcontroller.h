@@ -41,6 +41,10 @@
 #define DMX_MAX_VALUE 255
 #endif
 
+namespace artnetcontroller {
+static constexpr uint32_t DMX_QUEUE_UNIVERSES = 64;	///< Staged ArtDmx packets before an implicit flush
+}  // namespace artnetcontroller
+
 struct TArtNetController {
 	uint32_t nIPAddressLocal;
 	uint32_t nIPAddressBroadcast;
@@ -59,6 +63,12 @@ public:
 	void Print();
 
 	void HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex = 0);
+	/**
+	 * Frame based transmit: stage the universes of a frame with HandleDmxOutQueued()
+	 * and send them all at once with HandleDmxOutFlush(). HandleSync() flushes first.
+	 */
+	void HandleDmxOutQueued(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex = 0);
+	void HandleDmxOutFlush();
 	void HandleSync();
 	void HandleBlackout();
 
@@ -109,6 +119,8 @@ private:
 	void HandlePoll();
 	void HandlePollReply();
 	void HandleTrigger();
+	void DmxFill(artnet::ArtDmx *pArtDmx, uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex);
+	bool DmxSend(const artnet::ArtDmx *pArtDmx, uint16_t nUniverse, bool bQueued);
 	void ActiveUniversesAdd(uint16_t nUniverse);
 	void ActiveUniversesClear();
 
@@ -128,6 +140,8 @@ private:
 	struct TArtNetPacket *m_pArtNetPacket;
 	artnet::ArtPoll m_ArtNetPoll;
 	artnet::ArtDmx *m_pArtDmx;
+	artnet::ArtDmx *m_pArtDmxQueue;
+	uint32_t m_nDmxQueued { 0 };
 	artnet::ArtSync *m_pArtSync;
 	ArtNetTrigger *m_pArtNetTrigger { nullptr }; // Trigger handler
 	uint32_t m_nLastPollMillis { 0 };
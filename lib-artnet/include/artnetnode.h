@@ -67,6 +67,7 @@
 #endif
 
 #include "lightset.h"
+#include "lightsetpresentation.h"
 #include "hardware.h"
 #include "network.h"
 
@@ -176,9 +177,16 @@ struct OutputPort {
 	bool IsDataPending;
 };
 
+struct InputStatistics {
+	uint32_t nDmxPackets;		///< ArtDmx packets sent, including the keep-alive packets
+	uint32_t nKeepAlivePackets;	///< ArtDmx packets sent with unchanged data
+	uint32_t nBytes;			///< UDP payload bytes sent
+};
+
 struct InputPort {
+	InputStatistics Statistics;
 	uint32_t nDestinationIp;
-	uint32_t nMillis;
+	uint32_t nMillis;			///< The latest time an ArtDmx was sent for this port
 	uint8_t nSequenceNumber;
 	uint8_t GoodInput;
 	uint8_t nPollReplyIndex;
@@ -214,6 +222,13 @@ public:
 	void Stop();
 
 	void Run() {
+#if (LIGHTSET_PORTS > 0)
+		if (__builtin_expect((m_Presentation.IsDue()), 0)) {
+			SyncOutput();
+			m_Presentation.Presented();
+		}
+#endif
+
 		uint16_t nForeignPort;
 		const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&m_pReceiveBuffer)), &m_nIpAddressFrom, &nForeignPort);
 		m_nCurrentPacketMillis = Hardware::Get()->Millis();
@@ -332,6 +347,34 @@ public:
 		return m_pLightSet;
 	}
 
+	/**
+	 * The output of ArtSync at a presentation time, the clock is Hardware::Micros when not given.
+	 * Mode::CLOCK takes the shared clock, without one it is Mode::LATENCY.
+	 */
+	void SetPresentation(lightset::presentation::Mode mode, const uint32_t nLatencyBudgetMicros, lightset::presentation::Clock pClock = nullptr) {
+		if ((pClock == nullptr) && (mode == lightset::presentation::Mode::CLOCK)) {
+			pClock = lightset::presentation::get_shared_clock();
+
+			if (pClock == nullptr) {
+				// Without a shared clock there is no grid
+				mode = lightset::presentation::Mode::LATENCY;
+			}
+		}
+
+		if (pClock == nullptr) {
+			pClock = []() { return Hardware::Get()->Micros(); };
+		}
+
+		m_Presentation.SetMode(mode, nLatencyBudgetMicros, pClock);
+#if (ARTNET_VERSION >= 4)
+		E131Bridge::SetPresentation(mode, nLatencyBudgetMicros, pClock);
+#endif
+	}
+
+	const LightSetPresentation& GetPresentation() const {
+		return m_Presentation;
+	}
+
 	uint32_t GetActiveInputPorts() const {
 		return m_State.nEnabledInputPorts;
 	}
@@ -425,14 +468,22 @@ public:
 		return 0;
 	}
 
-	uint32_t RdmCopyTod(const uint32_t nPortIndex, char *pOutBuffer, const uint32_t nOutBufferSize) {
+	uint32_t RdmGetUidCount(const uint32_t nPortIndex) {
 		if (m_pArtNetRdmController != nullptr) {
-			return m_pArtNetRdmController->CopyTod(nPortIndex, pOutBuffer, nOutBufferSize);
+			return m_pArtNetRdmController->GetTod(nPortIndex)->GetUidCount();
 		}
 
 		return 0;
 	}
 
+	bool RdmCopyTodEntry(const uint32_t nPortIndex, const uint32_t nIndex, uint8_t uid[RDM_UID_SIZE]) {
+		if (m_pArtNetRdmController != nullptr) {
+			return m_pArtNetRdmController->CopyTodEntry(nPortIndex, nIndex, uid);
+		}
+
+		return false;
+	}
+
 	bool RdmIsRunning(uint32_t nPortIndex, bool& bIsIncremental) {
 		uint32_t nRdmnPortIndex;
 		if (m_pArtNetRdmController->IsRunning(nRdmnPortIndex, bIsIncremental)) {
@@ -491,6 +542,11 @@ public:
 		return 0;
 	}
 
+	const artnetnode::InputStatistics& GetInputStatistics(const uint32_t nPortIndex) const {
+		assert(nPortIndex < artnetnode::MAX_PORTS);
+		return m_InputPort[nPortIndex].Statistics;
+	}
+
 	/**
 	 * LLRP
 	 */
@@ -609,6 +665,13 @@ private:
 	void HandlePoll();
 	void HandleDmx();
 	void HandleSync();
+	void SyncOutput();
+	void PresentPending() {
+		if (m_Presentation.IsPending()) {
+			SyncOutput();
+			m_Presentation.Presented(true);
+		}
+	}
 	void HandleAddress();
 	void HandleTimeCode();
 	void HandleTimeSync();
@@ -619,6 +682,7 @@ private:
 	void HandleRdmSub();
 	void HandleIpProg();
 	void HandleDmxIn();
+	void SendDmxIn(const uint32_t nPortIndex, const uint8_t *pDmxData, const bool bIsKeepAlive);
 	void HandleInput();
 	void SetLocalMerging();
 	void HandleRdmIn();
@@ -687,6 +751,7 @@ private:
 	uint32_t m_nPreviousLedpanelMillis { 0 };
 
 	LightSet *m_pLightSet { nullptr };
+	LightSetPresentation m_Presentation;
 
 	ArtNetTimeCode *m_pArtNetTimeCode { nullptr };
 	ArtNetTrigger *m_pArtNetTrigger { nullptr };
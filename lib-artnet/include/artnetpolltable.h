@@ -36,9 +36,14 @@
 namespace artnet {
 static constexpr uint32_t POLL_INTERVAL_SECONDS = 8;
 static constexpr uint32_t POLL_INTERVAL_MILLIS = (POLL_INTERVAL_SECONDS * 1000U);
+#if defined (BARE_METAL)
 static constexpr uint32_t POLL_TABLE_SIZE_ENRIES = 255;
-static constexpr uint32_t POLL_TABLE_SIZE_NODE_UNIVERSES = 64;
 static constexpr uint32_t POLL_TABLE_SIZE_UNIVERSES = 512;
+#else
+static constexpr uint32_t POLL_TABLE_SIZE_ENRIES = 1024;
+static constexpr uint32_t POLL_TABLE_SIZE_UNIVERSES = 2048;
+#endif
+static constexpr uint32_t POLL_TABLE_SIZE_NODE_UNIVERSES = 64;
 }  // namespace artnet
 
 struct TArtNetNodeEntryUniverse {
@@ -87,11 +92,21 @@ public:
 private:
 	void ProcessUniverse(uint32_t nIpAddress, uint16_t nUniverse);
 	void RemoveIpAddress(uint16_t nUniverse, uint32_t nIpAddress);
+	void RemoveNode(uint32_t nTableIndex);
 
 private:
+	/*
+	 * Nodes are kept dense in m_pPollTable, a removed node is replaced by the last one.
+	 * Universe entries, and their subscriber arrays, never move: a removed entry is put on a free list.
+	 * Both are found with an open-addressed hash index (linear probing, backward shift deletion),
+	 * keyed by IP address and by 15-bit Port-Address respectively.
+	 */
 	TArtNetNodeEntry *m_pPollTable;
+	uint16_t *m_pPollTableIndex;
 	uint32_t m_nPollTableEntries{0};
 	TArtNetPollTableUniverses *m_pTableUniverses;
+	uint16_t *m_pTableUniversesIndex;
+	uint16_t *m_pTableUniversesFree;
 	uint32_t m_nTableUniversesEntries{0};
 	TArtNetPollTableClean m_tTableClean;
 };
@@ -71,6 +71,13 @@ ArtNetController::ArtNetController() {
 	m_pArtDmx->OpCode = static_cast<uint16_t>(artnet::OpCodes::OP_DMX);
 	m_pArtDmx->ProtVerLo = artnet::PROTOCOL_REVISION;
 
+	m_pArtDmxQueue = new struct ArtDmx[artnetcontroller::DMX_QUEUE_UNIVERSES];
+	assert(m_pArtDmxQueue != nullptr);
+
+	for (uint32_t nIndex = 0; nIndex < artnetcontroller::DMX_QUEUE_UNIVERSES; nIndex++) {
+		memcpy(&m_pArtDmxQueue[nIndex], m_pArtDmx, sizeof(struct ArtDmx));
+	}
+
 	m_pArtSync = new struct ArtSync;
 	assert(m_pArtSync != nullptr);
 
@@ -90,6 +97,9 @@ ArtNetController::ArtNetController() {
 ArtNetController::~ArtNetController() {
 	DEBUG_ENTRY
 
+	delete[] m_pArtDmxQueue;
+	m_pArtDmxQueue = nullptr;
+
 	delete m_pArtNetPacket;
 	m_pArtNetPacket = nullptr;
 
@@ -113,20 +123,18 @@ void ArtNetController::Start() {
 void ArtNetController::Stop() {
 	DEBUG_ENTRY
 
+	HandleDmxOutFlush();
+
 	//FIXME ArtNetController::Stop
 
 	DEBUG_EXIT
 }
 
-void ArtNetController::HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex) {
-	DEBUG_ENTRY
-
-	ActiveUniversesAdd(nUniverse);
-
-	m_pArtDmx->Physical = nPortIndex & 0xFF;
-	m_pArtDmx->PortAddress = nUniverse;
-	m_pArtDmx->LengthHi = static_cast<uint8_t>((nLength & 0xFF00) >> 8);
-	m_pArtDmx->Length = static_cast<uint8_t>(nLength & 0xFF);
+void ArtNetController::DmxFill(struct ArtDmx *pArtDmx, uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex) {
+	pArtDmx->Physical = nPortIndex & 0xFF;
+	pArtDmx->PortAddress = nUniverse;
+	pArtDmx->LengthHi = static_cast<uint8_t>((nLength & 0xFF00) >> 8);
+	pArtDmx->Length = static_cast<uint8_t>(nLength & 0xFF);
 
 	// The sequence number is used to ensure that ArtDmx packets are used in the correct order.
 	// This field is incremented in the range 0x01 to 0xff to allow the receiving node to resequence packets.
@@ -136,51 +144,94 @@ void ArtNetController::HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData,
 		m_pArtDmx->Sequence = 1;
 	}
 
+	pArtDmx->Sequence = m_pArtDmx->Sequence;
+
 	if (__builtin_expect((m_nMaster == DMX_MAX_VALUE), 1)) {
-		memcpy(m_pArtDmx->Data, pDmxData, nLength);
+		memcpy(pArtDmx->Data, pDmxData, nLength);
 	} else if (m_nMaster == 0) {
-		memset(m_pArtDmx->Data, 0, nLength);
+		memset(pArtDmx->Data, 0, nLength);
 	} else {
 		for (uint32_t i = 0; i < nLength; i++) {
-			m_pArtDmx->Data[i] = ((m_nMaster * static_cast<uint32_t>(pDmxData[i])) / DMX_MAX_VALUE) & 0xFF;
+			pArtDmx->Data[i] = ((m_nMaster * static_cast<uint32_t>(pDmxData[i])) / DMX_MAX_VALUE) & 0xFF;
 		}
 	}
+}
 
+/**
+ * @return false when there is no subscriber for nUniverse
+ */
+bool ArtNetController::DmxSend(const struct ArtDmx *pArtDmx, uint16_t nUniverse, bool bQueued) {
 	uint32_t nCount = 0;
-	auto IpAddresses = const_cast<struct TArtNetPollTableUniverses*>(GetIpAddress(nUniverse));
+	const auto *IpAddresses = GetIpAddress(nUniverse);
 
 	if (m_bUnicast) {
 		if (IpAddresses != nullptr) {
 			nCount = IpAddresses->nCount;
 		} else {
-			DEBUG_EXIT
-			return;
+			return false;
 		}
 	}
 
+	m_bDmxHandled = true;
+
 	// If the number of universe subscribers exceeds 40 for a given universe, the transmitting device may broadcast.
 
 	if (m_bUnicast && (nCount <= 40)) {
 		for (uint32_t nIndex = 0; nIndex < nCount; nIndex++) {
-			Network::Get()->SendTo(m_nHandle, m_pArtDmx, sizeof(struct ArtDmx), IpAddresses->pIpAddresses[nIndex], artnet::UDP_PORT);
+			if (bQueued) {
+				Network::Get()->SendToQueued(m_nHandle, pArtDmx, sizeof(struct ArtDmx), IpAddresses->pIpAddresses[nIndex], artnet::UDP_PORT);
+			} else {
+				Network::Get()->SendTo(m_nHandle, pArtDmx, sizeof(struct ArtDmx), IpAddresses->pIpAddresses[nIndex], artnet::UDP_PORT);
+			}
 		}
 
-		m_bDmxHandled = true;
+		return true;
+	}
 
-		DEBUG_EXIT
-		return;
+	if (bQueued) {
+		Network::Get()->SendToQueued(m_nHandle, pArtDmx, sizeof(struct ArtDmx), m_tArtNetController.nIPAddressBroadcast, artnet::UDP_PORT);
+	} else {
+		Network::Get()->SendTo(m_nHandle, pArtDmx, sizeof(struct ArtDmx), m_tArtNetController.nIPAddressBroadcast, artnet::UDP_PORT);
 	}
 
-	if (!m_bUnicast || (nCount > 40)) {
-		Network::Get()->SendTo(m_nHandle, m_pArtDmx, sizeof(struct ArtDmx), m_tArtNetController.nIPAddressBroadcast, artnet::UDP_PORT);
+	return true;
+}
 
-		m_bDmxHandled = true;
-	}
+void ArtNetController::HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex) {
+	DEBUG_ENTRY
+
+	ActiveUniversesAdd(nUniverse);
+
+	DmxFill(m_pArtDmx, nUniverse, pDmxData, nLength, nPortIndex);
+	DmxSend(m_pArtDmx, nUniverse, false);
 
 	DEBUG_EXIT
 }
 
+void ArtNetController::HandleDmxOutQueued(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength, uint8_t nPortIndex) {
+	if (m_nDmxQueued == artnetcontroller::DMX_QUEUE_UNIVERSES) {
+		HandleDmxOutFlush();
+	}
+
+	ActiveUniversesAdd(nUniverse);
+
+	auto *pArtDmx = &m_pArtDmxQueue[m_nDmxQueued];
+
+	DmxFill(pArtDmx, nUniverse, pDmxData, nLength, nPortIndex);
+
+	if (DmxSend(pArtDmx, nUniverse, true)) {
+		m_nDmxQueued++;
+	}
+}
+
+void ArtNetController::HandleDmxOutFlush() {
+	Network::Get()->SendFlush();
+	m_nDmxQueued = 0;
+}
+
 void ArtNetController::HandleSync() {
+	HandleDmxOutFlush();
+
 	if (m_bSynchronization && m_bDmxHandled) {
 		m_bDmxHandled = false;
 		Network::Get()->SendTo(m_nHandle, m_pArtSync, sizeof(struct ArtSync), m_tArtNetController.nIPAddressBroadcast, artnet::UDP_PORT);
@@ -188,6 +239,8 @@ void ArtNetController::HandleSync() {
 }
 
 void ArtNetController::HandleBlackout() {
+	HandleDmxOutFlush();
+
 	m_pArtDmx->LengthHi = (512 & 0xFF00) >> 8;
 	m_pArtDmx->Length = (512 & 0xFF);
 
@@ -52,22 +52,100 @@ union uip {
 	uint8_t u8[4];
 } static ip;
 
+namespace polltable {
+static constexpr uint32_t index_bits(const uint32_t nEntries) {
+	uint32_t nBits = 1;
+	while ((1U << nBits) < (2 * nEntries)) {	// Load factor <= 0.5
+		nBits++;
+	}
+	return nBits;
+}
+
+static constexpr uint32_t NODE_INDEX_BITS = index_bits(POLL_TABLE_SIZE_ENRIES);
+static constexpr uint32_t UNIVERSE_INDEX_BITS = index_bits(POLL_TABLE_SIZE_UNIVERSES);
+static constexpr uint16_t EMPTY = 0xFFFF;
+
+static_assert(POLL_TABLE_SIZE_ENRIES < EMPTY);
+static_assert(POLL_TABLE_SIZE_UNIVERSES < EMPTY);
+
+// Fibonacci hashing
+inline uint32_t hash(const uint32_t nKey, const uint32_t nBits) {
+	return (nKey * 2654435769U) >> (32 - nBits);
+}
+
+/**
+ * @return the index position holding nKey, or the empty position where it is to be inserted
+ */
+template<typename KeyOf>
+inline uint32_t find(const uint16_t *pIndex, const uint32_t nBits, const uint32_t nKey, KeyOf keyOf) {
+	const auto nMask = (1U << nBits) - 1;
+	auto nPosition = hash(nKey, nBits);
+
+	while ((pIndex[nPosition] != EMPTY) && (keyOf(pIndex[nPosition]) != nKey)) {
+		nPosition = (nPosition + 1) & nMask;
+	}
+
+	return nPosition;
+}
+
+/**
+ * Backward shift deletion, so no tombstones are needed
+ */
+template<typename KeyOf>
+inline void remove(uint16_t *pIndex, const uint32_t nBits, uint32_t nPosition, KeyOf keyOf) {
+	const auto nMask = (1U << nBits) - 1;
+	auto nNext = nPosition;
+
+	for (;;) {
+		nNext = (nNext + 1) & nMask;
+
+		if (pIndex[nNext] == EMPTY) {
+			break;
+		}
+
+		const auto nHome = hash(keyOf(pIndex[nNext]), nBits);
+
+		if (((nNext - nHome) & nMask) >= ((nNext - nPosition) & nMask)) {
+			pIndex[nPosition] = pIndex[nNext];
+			nPosition = nNext;
+		}
+	}
+
+	pIndex[nPosition] = EMPTY;
+}
+}  // namespace polltable
+
 ArtNetPollTable::ArtNetPollTable() {
 	m_pPollTable = new TArtNetNodeEntry[POLL_TABLE_SIZE_ENRIES];
 	assert(m_pPollTable != nullptr);
 
 	memset(m_pPollTable, 0, sizeof(TArtNetNodeEntry[POLL_TABLE_SIZE_ENRIES]));
 
+	m_pPollTableIndex = new uint16_t[1U << polltable::NODE_INDEX_BITS];
+	assert(m_pPollTableIndex != nullptr);
+
+	memset(m_pPollTableIndex, 0xFF, sizeof(uint16_t) << polltable::NODE_INDEX_BITS);
+
 	m_pTableUniverses = new TArtNetPollTableUniverses[POLL_TABLE_SIZE_UNIVERSES];
 	assert(m_pTableUniverses != nullptr);
 
 	memset(m_pTableUniverses, 0, sizeof(TArtNetPollTableUniverses[POLL_TABLE_SIZE_UNIVERSES]));
 
+	m_pTableUniversesFree = new uint16_t[POLL_TABLE_SIZE_UNIVERSES];
+	assert(m_pTableUniversesFree != nullptr);
+
 	for (uint32_t nIndex = 0; nIndex < POLL_TABLE_SIZE_UNIVERSES; nIndex++) {
 		m_pTableUniverses[nIndex].pIpAddresses = new uint32_t[POLL_TABLE_SIZE_ENRIES];
 		assert(m_pTableUniverses[nIndex].pIpAddresses != nullptr);
+		// Pop order is ascending
+		m_pTableUniversesFree[nIndex] = static_cast<uint16_t>(POLL_TABLE_SIZE_UNIVERSES - 1 - nIndex);
 	}
 
+	m_pTableUniversesIndex = new uint16_t[1U << polltable::UNIVERSE_INDEX_BITS];
+	assert(m_pTableUniversesIndex != nullptr);
+
+	memset(m_pTableUniversesIndex, 0xFF, sizeof(uint16_t) << polltable::UNIVERSE_INDEX_BITS);
+
 //	DEBUG_PRINTF("TArtNetNodeEntry[%d] = %u bytes [%u Kb]", ARTNET_POLL_TABLE_SIZE_ENRIES, (sizeof(TArtNetNodeEntry[ARTNET_POLL_TABLE_SIZE_ENRIES])), (sizeof(TArtNetNodeEntry[ARTNET_POLL_TABLE_SIZE_ENRIES])) / 1024);
 //	DEBUG_PRINTF("TArtNetPollTableUniverses[%d] = %u bytes [%u Kb]", ARTNET_POLL_TABLE_SIZE_UNIVERSES, (sizeof(TArtNetPollTableUniverses[ARTNET_POLL_TABLE_SIZE_UNIVERSES])), (sizeof(TArtNetPollTableUniverses[ARTNET_POLL_TABLE_SIZE_UNIVERSES])) / 1024);
 
@@ -77,153 +155,128 @@ ArtNetPollTable::ArtNetPollTable() {
 }
 
 ArtNetPollTable::~ArtNetPollTable() {
+	delete[] m_pTableUniversesIndex;
+	m_pTableUniversesIndex = nullptr;
+
 	for (uint32_t nIndex = 0; nIndex < POLL_TABLE_SIZE_UNIVERSES; nIndex++) {
 		delete[] m_pTableUniverses[nIndex].pIpAddresses;
 		m_pTableUniverses[nIndex].pIpAddresses = nullptr;
 	}
 
+	delete[] m_pTableUniversesFree;
+	m_pTableUniversesFree = nullptr;
+
 	delete[] m_pTableUniverses;
 	m_pTableUniverses = nullptr;
 
+	delete[] m_pPollTableIndex;
+	m_pPollTableIndex = nullptr;
+
 	delete[] m_pPollTable;
 	m_pPollTable = nullptr;
 }
 
 const struct TArtNetPollTableUniverses *ArtNetPollTable::GetIpAddress(uint16_t nUniverse) const {
-	if (m_nTableUniversesEntries == 0) {
-		return nullptr;
-	}
+	const auto nPosition = polltable::find(m_pTableUniversesIndex, polltable::UNIVERSE_INDEX_BITS, nUniverse, [this](const uint16_t nEntry) {
+		return static_cast<uint32_t>(m_pTableUniverses[nEntry].nUniverse);
+	});
 
-	// FIXME Universe lookup
-	for (uint32_t nEntry = 0; nEntry < m_nTableUniversesEntries; nEntry++) {
-		TArtNetPollTableUniverses *pTableUniverses = &m_pTableUniverses[nEntry];
-		assert(pTableUniverses != nullptr);
+	const auto nEntry = m_pTableUniversesIndex[nPosition];
 
-		if (pTableUniverses->nUniverse == nUniverse) {
-			return &m_pTableUniverses[nEntry];
-		}
+	if (nEntry == polltable::EMPTY) {
+		return nullptr;
 	}
 
-	return nullptr;
+	return &m_pTableUniverses[nEntry];
 }
 
-
 void ArtNetPollTable::RemoveIpAddress(uint16_t nUniverse, uint32_t nIpAddress) {
-	if (m_nTableUniversesEntries == 0) {
-		return;
-	}
-
-	uint32_t nEntry = 0;
+	const auto keyOf = [this](const uint16_t nEntry) {
+		return static_cast<uint32_t>(m_pTableUniverses[nEntry].nUniverse);
+	};
 
-	// FIXME Universe lookup
-	for (nEntry = 0; nEntry < m_nTableUniversesEntries; nEntry++) {
-		TArtNetPollTableUniverses *pTableUniverses = &m_pTableUniverses[nEntry];
-		assert(pTableUniverses != nullptr);
+	const auto nPosition = polltable::find(m_pTableUniversesIndex, polltable::UNIVERSE_INDEX_BITS, nUniverse, keyOf);
+	const auto nEntry = m_pTableUniversesIndex[nPosition];
 
-		if (pTableUniverses->nUniverse == nUniverse) {
-			break;
-		}
-	}
-
-	if (nEntry == m_nTableUniversesEntries) {
+	if (nEntry == polltable::EMPTY) {
 		// Universe not found
 		return;
 	}
 
-	TArtNetPollTableUniverses *pTableUniverses = &m_pTableUniverses[nEntry];
+	auto *pTableUniverses = &m_pTableUniverses[nEntry];
 	assert(pTableUniverses->nCount > 0);
 
-	uint32_t nIpAddressIndex = 0;
+	auto *p32 = pTableUniverses->pIpAddresses;
+	uint32_t nIpAddressIndex;
 
-	// FIXME IP lookup
 	for (nIpAddressIndex = 0; nIpAddressIndex < pTableUniverses->nCount; nIpAddressIndex++) {
-		if (pTableUniverses->pIpAddresses[nIpAddressIndex] == nIpAddress) {
+		if (p32[nIpAddressIndex] == nIpAddress) {
 			break;
 		}
 	}
 
-	uint32_t *p32 = pTableUniverses->pIpAddresses;
-	int32_t i;
-
-	for (i = static_cast<int32_t>(nIpAddressIndex); i < static_cast<int32_t>(pTableUniverses->nCount) - 1; i++) {
-		p32[i] = p32[i + 1];
+	if (nIpAddressIndex == pTableUniverses->nCount) {
+		// IP not found
+		return;
 	}
 
-	p32[i] = 0;
-
+	// The order of the subscribers is not relevant
 	pTableUniverses->nCount--;
+	p32[nIpAddressIndex] = p32[pTableUniverses->nCount];
+	p32[pTableUniverses->nCount] = 0;
 
 	if (pTableUniverses->nCount == 0) {
 		DEBUG_PRINTF("Delete Universe -> m_nTableUniversesEntries=%u, nEntry=%u", m_nTableUniversesEntries, nEntry);
 
-		TArtNetPollTableUniverses *p = m_pTableUniverses;
-
-		for (i = static_cast<int32_t>(nEntry); i < static_cast<int32_t>(m_nTableUniversesEntries) - 1; i++) {
-			p[i].nUniverse = p[i + 1].nUniverse;
-			p[i].nCount = p[i + 1].nCount;
-			p[i].pIpAddresses = p[i + 1].pIpAddresses;
-		}
-
-		p[i].nUniverse = 0;
-		p[i].nCount = 0;
+		polltable::remove(m_pTableUniversesIndex, polltable::UNIVERSE_INDEX_BITS, nPosition, keyOf);
 
+		pTableUniverses->nUniverse = 0;
 		m_nTableUniversesEntries--;
+		m_pTableUniversesFree[POLL_TABLE_SIZE_UNIVERSES - 1 - m_nTableUniversesEntries] = nEntry;
 	}
 }
 
 void ArtNetPollTable::ProcessUniverse(uint32_t nIpAddress, uint16_t nUniverse) {
 	DEBUG_ENTRY
 
-	if (POLL_TABLE_SIZE_UNIVERSES == m_nTableUniversesEntries) {
-		DEBUG_PUTS("m_pTableUniverses is full");
-		DEBUG_EXIT
-		return;
-	}
-
-	// FIXME Universe lookup
-	bool bFoundUniverse = false;
-	uint32_t nEntry = 0;
+	const auto nPosition = polltable::find(m_pTableUniversesIndex, polltable::UNIVERSE_INDEX_BITS, nUniverse, [this](const uint16_t nEntry) {
+		return static_cast<uint32_t>(m_pTableUniverses[nEntry].nUniverse);
+	});
 
-	for (nEntry = 0; nEntry < m_nTableUniversesEntries; nEntry++) {
-		TArtNetPollTableUniverses *pTableUniverses = &m_pTableUniverses[nEntry];
-		assert(pTableUniverses != nullptr);
+	auto nEntry = m_pTableUniversesIndex[nPosition];
 
-		if (pTableUniverses->nUniverse == nUniverse) {
-			bFoundUniverse = true;
-			DEBUG_PRINTF("Universe found %u", nUniverse);
-			break;
+	if (nEntry == polltable::EMPTY) {
+		if (POLL_TABLE_SIZE_UNIVERSES == m_nTableUniversesEntries) {
+			DEBUG_PUTS("m_pTableUniverses is full");
+			DEBUG_EXIT
+			return;
 		}
-	}
-
-	TArtNetPollTableUniverses *pTableUniverses = &m_pTableUniverses[nEntry];
-
-	bool bFoundIp = false;
-	uint32_t nCount = 0;
 
-	if (bFoundUniverse) {
-		// FIXME IP lookup
-		for (nCount = 0; nCount < pTableUniverses->nCount; nCount++) {
-			if (pTableUniverses->pIpAddresses[nCount] == nIpAddress) {
-				bFoundIp = true;
-				DEBUG_PUTS("IP found");
-				break;
-			}
-		}
-	} else {
 		// New universe
-		pTableUniverses->nUniverse = nUniverse;
+		nEntry = m_pTableUniversesFree[POLL_TABLE_SIZE_UNIVERSES - 1 - m_nTableUniversesEntries];
 		m_nTableUniversesEntries++;
+
+		m_pTableUniverses[nEntry].nUniverse = nUniverse;
+		m_pTableUniverses[nEntry].nCount = 0;
+		m_pTableUniversesIndex[nPosition] = nEntry;
 		DEBUG_PRINTF("New Universe %d", static_cast<int>(nUniverse));
 	}
 
-	if (!bFoundIp) {
-		if (pTableUniverses->nCount < POLL_TABLE_SIZE_ENRIES) {
-			pTableUniverses->pIpAddresses[pTableUniverses->nCount] = nIpAddress;
-			pTableUniverses->nCount++;
-			DEBUG_PUTS("It is a new IP for the Universe");
-		} else {
-			DEBUG_PUTS("New IP does not fit");
-		}
+	auto *pTableUniverses = &m_pTableUniverses[nEntry];
+
+#ifndef NDEBUG
+	// The node table guarantees that an IP is added only once for a universe
+	for (uint32_t nCount = 0; nCount < pTableUniverses->nCount; nCount++) {
+		assert(pTableUniverses->pIpAddresses[nCount] != nIpAddress);
+	}
+#endif
+
+	if (pTableUniverses->nCount < POLL_TABLE_SIZE_ENRIES) {
+		pTableUniverses->pIpAddresses[pTableUniverses->nCount] = nIpAddress;
+		pTableUniverses->nCount++;
+		DEBUG_PUTS("It is a new IP for the Universe");
+	} else {
+		DEBUG_PUTS("New IP does not fit");
 	}
 
 	DEBUG_EXIT
@@ -232,63 +285,25 @@ void ArtNetPollTable::ProcessUniverse(uint32_t nIpAddress, uint16_t nUniverse) {
 void ArtNetPollTable::Add(const struct artnet::ArtPollReply *ptArtPollReply) {
 	DEBUG_ENTRY
 
-	bool bFound = false;
-
 	memcpy(ip.u8, ptArtPollReply->IPAddress, 4);
 
-	const auto nIpSwap = __builtin_bswap32(ip.u32);
-
-	int32_t i;
-	int32_t nLow = 0;
-	int32_t nMid;
-	auto nHigh = static_cast<int32_t>(m_nPollTableEntries);
+	const auto nPosition = polltable::find(m_pPollTableIndex, polltable::NODE_INDEX_BITS, ip.u32, [this](const uint16_t nEntry) {
+		return m_pPollTable[nEntry].IPAddress;
+	});
 
-	while (nLow <= nHigh) {
-		nMid = nLow + ((nHigh - nLow) / 2);
-		const auto nMidValue = __builtin_bswap32(m_pPollTable[nMid].IPAddress);
-
-		if (nMidValue < nIpSwap) {
-			nLow = nMid + 1;
-		} else if (nMidValue > nIpSwap) {
-			nHigh = nMid - 1;
-		} else {
-			i = nMid;
-			bFound = true;
-			break;
-		}
-	}
+	uint32_t i = m_pPollTableIndex[nPosition];
 
-	if (!bFound) {
+	if (i == polltable::EMPTY) {
 		if (m_nPollTableEntries == POLL_TABLE_SIZE_ENRIES) {
 			DEBUG_PUTS("Full");
 			return;
 		}
 
-		if (m_nPollTableEntries != static_cast<uint32_t>(nHigh)) {
-			DEBUG_PUTS("Move");
-
-			struct TArtNetNodeEntry *pArtNetNodeEntry = m_pPollTable; // TODO
-
-			assert(m_nPollTableEntries >= 1);
-			assert(nLow >= 0);
-
-			for (int32_t i = static_cast<int32_t>(m_nPollTableEntries) - 1;i >= nLow; i--) {
-				const struct TArtNetNodeEntry *pSrc = &pArtNetNodeEntry[i];
-				struct TArtNetNodeEntry *pDst = &pArtNetNodeEntry[i + 1];
-				memcpy(pDst, pSrc, sizeof(struct TArtNetNodeEntry));
-			}
-
-			struct TArtNetNodeEntry *pDst = &pArtNetNodeEntry[nLow];
-			memset(pDst, 0, sizeof(struct TArtNetNodeEntry));
-
-			i = nLow;
-		} else {
-			i = static_cast<int32_t>(m_nPollTableEntries);
-			DEBUG_PRINTF("Add -> i=%d", i);
-		}
+		i = m_nPollTableEntries++;
+		DEBUG_PRINTF("Add -> i=%u", i);
 
 		m_pPollTable[i].IPAddress = ip.u32;
-		m_nPollTableEntries++;
+		m_pPollTableIndex[nPosition] = static_cast<uint16_t>(i);
 	}
 
 #ifndef NDEBUG
@@ -327,6 +342,9 @@ void ArtNetPollTable::Add(const struct artnet::ArtPollReply *ptArtPollReply) {
 					// No room
 					continue;
 				}
+			} else if (m_pPollTable[i].Universe[nIndexUniverse].nLastUpdateMillis == 0) {
+				// Timed out before, subscribe again
+				ProcessUniverse(ip.u32, nUniverse);
 			}
 
 			m_pPollTable[i].Universe[nIndexUniverse].nLastUpdateMillis = nMillis;
@@ -336,6 +354,37 @@ void ArtNetPollTable::Add(const struct artnet::ArtPollReply *ptArtPollReply) {
 	DEBUG_EXIT;
 }
 
+void ArtNetPollTable::RemoveNode(uint32_t nTableIndex) {
+	const auto keyOf = [this](const uint16_t nEntry) {
+		return m_pPollTable[nEntry].IPAddress;
+	};
+
+	auto nPosition = polltable::find(m_pPollTableIndex, polltable::NODE_INDEX_BITS, m_pPollTable[nTableIndex].IPAddress, keyOf);
+	assert(m_pPollTableIndex[nPosition] == nTableIndex);
+
+	polltable::remove(m_pPollTableIndex, polltable::NODE_INDEX_BITS, nPosition, keyOf);
+
+	m_nPollTableEntries--;
+
+	if (nTableIndex != m_nPollTableEntries) {
+		// Move the last node into the hole
+		memcpy(&m_pPollTable[nTableIndex], &m_pPollTable[m_nPollTableEntries], sizeof(struct TArtNetNodeEntry));
+
+		nPosition = polltable::find(m_pPollTableIndex, polltable::NODE_INDEX_BITS, m_pPollTable[nTableIndex].IPAddress, keyOf);
+		assert(m_pPollTableIndex[nPosition] == m_nPollTableEntries);
+
+		m_pPollTableIndex[nPosition] = static_cast<uint16_t>(nTableIndex);
+	}
+
+	struct TArtNetNodeEntry *pDst = &m_pPollTable[m_nPollTableEntries];
+	pDst->IPAddress = 0;
+	pDst->nUniversesCount = 0;
+	memset(pDst->Universe, 0, sizeof(struct TArtNetNodeEntryUniverse[POLL_TABLE_SIZE_NODE_UNIVERSES]));
+#ifndef NDEBUG
+	memset(pDst->Mac, 0, artnet::MAC_SIZE + artnet::SHORT_NAME_LENGTH + artnet::LONG_NAME_LENGTH);
+#endif
+}
+
 void ArtNetPollTable::Clean() {
 	if (m_nPollTableEntries == 0) {
 		return;
@@ -362,32 +411,17 @@ void ArtNetPollTable::Clean() {
 	m_tTableClean.nUniverseIndex++;
 
 	if (m_tTableClean.nUniverseIndex == POLL_TABLE_SIZE_NODE_UNIVERSES) {
+		m_tTableClean.nUniverseIndex = 0;
+
 		if (m_tTableClean.bOffLine) {
 			DEBUG_PUTS("Node is off-line");
-
-			struct TArtNetNodeEntry *pArtNetNodeEntry = m_pPollTable;
-			// Move
-			for (uint32_t i = m_tTableClean.nTableIndex; i < (m_nPollTableEntries - 1); i++) {
-				const struct TArtNetNodeEntry *pSrc = &pArtNetNodeEntry[i + 1];
-				struct TArtNetNodeEntry *pDst = &pArtNetNodeEntry[i];
-
-				memcpy(pDst, pSrc, sizeof(struct TArtNetNodeEntry));
-			}
-
-			m_nPollTableEntries--;
-
-			struct TArtNetNodeEntry *pDst = &pArtNetNodeEntry[m_nPollTableEntries];
-			pDst->IPAddress = 0;
-			pDst->nUniversesCount = 0;
-			memset(pDst->Universe, 0, sizeof(struct TArtNetNodeEntryUniverse[POLL_TABLE_SIZE_NODE_UNIVERSES]));
-#ifndef NDEBUG
-			memset(pDst->Mac, 0, artnet::MAC_SIZE + artnet::SHORT_NAME_LENGTH + artnet::LONG_NAME_LENGTH);
-#endif
+			// The last node takes this index, it is checked next
+			RemoveNode(m_tTableClean.nTableIndex);
+		} else {
+			m_tTableClean.nTableIndex++;
 		}
 
-		m_tTableClean.nUniverseIndex = 0;
 		m_tTableClean.bOffLine = true;
-		m_tTableClean.nTableIndex++;
 
 		if (m_tTableClean.nTableIndex >= m_nPollTableEntries) {
 			m_tTableClean.nTableIndex = 0;
@@ -415,9 +449,12 @@ void ArtNetPollTable::DumpTableUniverses() {
 #ifndef NDEBUG
 	printf("Entries : %d\n", m_nTableUniversesEntries);
 
-	for (uint32_t nEntry = 0; nEntry < m_nTableUniversesEntries; nEntry++) {
+	for (uint32_t nEntry = 0; nEntry < POLL_TABLE_SIZE_UNIVERSES; nEntry++) {
 		const TArtNetPollTableUniverses *pTableUniverses = &m_pTableUniverses[nEntry];
-		assert(pTableUniverses != nullptr);
+
+		if (pTableUniverses->nCount == 0) {
+			continue;
+		}
 
 		printf("%3d |%4u | %d ", nEntry, pTableUniverses->nUniverse, pTableUniverses->nCount);
 
@@ -32,6 +32,7 @@
 #include "artnet.h"
 
 #include "lightsetdata.h"
+#include "lightsetpresentation.h"
 
 /**
  * When a node receives an ArtSync packet it should transfer to synchronous operation.
@@ -50,6 +51,21 @@ void ArtNetNode::HandleSync() {
 		return;
 	}
 
+	if (m_Presentation.IsEnabled()) {
+		const auto nArrival = m_Presentation.Now();
+		// The previous frame is not yet out
+		PresentPending();
+		m_Presentation.Latch(nArrival);
+		return;
+	}
+
+	SyncOutput();
+}
+
+/**
+ * The buffered ArtDmx data to the output, at the ArtSync or at the presentation time
+ */
+void ArtNetNode::SyncOutput() {
 	for (uint32_t nPortIndex = 0; nPortIndex < artnetnode::MAX_PORTS; nPortIndex++) {
 		if (m_OutputPort[nPortIndex].IsDataPending) {
 			m_pLightSet->Sync(nPortIndex);
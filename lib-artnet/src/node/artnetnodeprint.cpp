@@ -70,6 +70,10 @@ void ArtNetNode::Print() {
 		}
 	}
 
+	if (m_Presentation.IsEnabled()) {
+		m_Presentation.Print();
+	}
+
 #if defined (ARTNET_HAVE_DMXIN)
 	if (m_State.nEnabledInputPorts != 0) {
 		printf(" Input\n");
@@ -49,6 +49,7 @@
 
 #include "lightsetparamsconst.h"
 #include "lightset.h"
+#include "lightsetpresentation.h"
 
 #include "network.h"
 
@@ -96,6 +97,7 @@ ArtNetParams::ArtNetParams() {
 
 	pArtnetNode->GetLongNameDefault(reinterpret_cast<char *>(m_Params.aLongName));
 	m_Params.nFailSafe = static_cast<uint8_t>(lightset::FailSafe::HOLD);
+	m_Params.nSyncLatencyBudget = lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
 
 	DEBUG_PRINTF("s_nPortsMax=%u", s_nPortsMax);
 	DEBUG_EXIT
@@ -339,6 +341,35 @@ void ArtNetParams::callbackFunction(const char *pLine) {
 		SetBool(nValue8, Mask::DISABLE_MERGE_TIMEOUT);
 		return;
 	}
+
+	nLength = 9;
+
+	if (Sscan::Char(pLine, LightSetParamsConst::SYNC_PRESENTATION, aValue, nLength) == Sscan::OK) {
+		aValue[nLength] = '\0';
+		const auto mode = lightset::presentation::get_mode(aValue);
+
+		if (mode == lightset::presentation::Mode::IMMEDIATE) {
+			m_Params.nSetList &= ~Mask::SYNC_PRESENTATION;
+		} else {
+			m_Params.nSetList |= Mask::SYNC_PRESENTATION;
+		}
+
+		m_Params.nSyncPresentation = static_cast<uint8_t>(mode);
+		return;
+	}
+
+	uint16_t nValue16;
+
+	if (Sscan::Uint16(pLine, LightSetParamsConst::SYNC_LATENCY_BUDGET, nValue16) == Sscan::OK) {
+		if ((nValue16 != 0) && (nValue16 != lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS)) {
+			m_Params.nSetList |= Mask::SYNC_LATENCY_BUDGET;
+			m_Params.nSyncLatencyBudget = nValue16;
+		} else {
+			m_Params.nSetList &= ~Mask::SYNC_LATENCY_BUDGET;
+			m_Params.nSyncLatencyBudget = lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
+		}
+		return;
+	}
 }
 
 void ArtNetParams::Builder(const struct Params *pParams, char *pBuffer, uint32_t nLength, uint32_t& nSize) {
@@ -428,6 +459,13 @@ void ArtNetParams::Builder(const struct Params *pParams, char *pBuffer, uint32_t
 
 	builder.Add(LightSetParamsConst::DISABLE_MERGE_TIMEOUT, isMaskSet(Mask::DISABLE_MERGE_TIMEOUT));
 
+	if (!isMaskSet(Mask::SYNC_LATENCY_BUDGET)) {
+		m_Params.nSyncLatencyBudget = lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
+	}
+
+	builder.Add(LightSetParamsConst::SYNC_PRESENTATION, lightset::presentation::get_mode(static_cast<lightset::presentation::Mode>(m_Params.nSyncPresentation)), isMaskSet(Mask::SYNC_PRESENTATION));
+	builder.Add(LightSetParamsConst::SYNC_LATENCY_BUDGET, m_Params.nSyncLatencyBudget, isMaskSet(Mask::SYNC_LATENCY_BUDGET));
+
 	nSize = builder.GetSize();
 
 	DEBUG_PRINTF("nSize=%d", nSize);
@@ -509,6 +547,11 @@ void ArtNetParams::Set() {
 		p->SetDisableMergeTimeout(true);
 	}
 
+	if (isMaskSet(Mask::SYNC_PRESENTATION)) {
+		const auto nLatencyBudget = isMaskSet(Mask::SYNC_LATENCY_BUDGET) ? m_Params.nSyncLatencyBudget : lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
+		p->SetPresentation(static_cast<lightset::presentation::Mode>(m_Params.nSyncPresentation), nLatencyBudget);
+	}
+
 	DEBUG_EXIT
 }
 
@@ -574,4 +617,7 @@ void ArtNetParams::Dump() {
 	 */
 
 	printf(" %s=1 [Yes]\n", LightSetParamsConst::DISABLE_MERGE_TIMEOUT);
+
+	printf(" %s=%u [%s]\n", LightSetParamsConst::SYNC_PRESENTATION, m_Params.nSyncPresentation, lightset::presentation::get_mode(static_cast<lightset::presentation::Mode>(m_Params.nSyncPresentation)));
+	printf(" %s=%u\n", LightSetParamsConst::SYNC_LATENCY_BUDGET, m_Params.nSyncLatencyBudget);
 }
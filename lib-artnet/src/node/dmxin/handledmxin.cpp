@@ -44,111 +44,109 @@
 
 static uint32_t s_ReceivingMask = 0;
 
-void ArtNetNode::HandleDmxIn() {
-	for (uint32_t nPortIndex = 0; nPortIndex < artnetnode::MAX_PORTS; nPortIndex++) {
-		if  ((m_Node.Port[nPortIndex].direction == lightset::PortDir::INPUT)
-		 &&  (m_Node.Port[nPortIndex].protocol == artnet::PortProtocol::ARTNET)
-		 && ((m_InputPort[nPortIndex].GoodInput & artnet::GoodInput::DISABLED) != artnet::GoodInput::DISABLED)) {
-
-			const auto *const pDmxData = reinterpret_cast<const struct Data *>(Dmx::Get()->GetDmxChanged(nPortIndex));
-
-			if (pDmxData != nullptr) {
-				m_ArtDmx.Sequence = static_cast<uint8_t>(1U + m_InputPort[nPortIndex].nSequenceNumber++);
-				m_ArtDmx.Physical = static_cast<uint8_t>(nPortIndex);
-				m_ArtDmx.PortAddress = m_Node.Port[nPortIndex].PortAddress;
+/**
+ * Only the received slots are sent, the ArtDmx header plus an even Length in the range 2 – 512.
+ * Changed input data is sent immediately. Unchanged data is re-transmitted
+ * with the artnet::DMX_INPUT_KEEP_ALIVE_MILLIS interval.
+ */
 
-				auto nLength = pDmxData->Statistics.nSlotsInPacket;
+void ArtNetNode::SendDmxIn(const uint32_t nPortIndex, const uint8_t *pDmxData, const bool bIsKeepAlive) {
+	const auto *const pData = reinterpret_cast<const struct Data *>(pDmxData);
+	auto& inputPort = m_InputPort[nPortIndex];
 
-				memcpy(m_ArtDmx.Data, &pDmxData->Data[1], nLength);
+	m_ArtDmx.Sequence = static_cast<uint8_t>(1U + inputPort.nSequenceNumber++);
+	m_ArtDmx.Physical = static_cast<uint8_t>(nPortIndex);
+	m_ArtDmx.PortAddress = m_Node.Port[nPortIndex].PortAddress;
 
-				if ((nLength & 0x1) == 0x1) {
-					m_ArtDmx.Data[nLength] = 0x00;
-					nLength++;
-				}
+	auto nLength = pData->Statistics.nSlotsInPacket;
 
-				m_ArtDmx.LengthHi = static_cast<uint8_t>((nLength & 0xFF00) >> 8);
-				m_ArtDmx.Length = static_cast<uint8_t>(nLength & 0xFF);
+	if (nLength > artnet::DMX_LENGTH) {
+		nLength = artnet::DMX_LENGTH;
+	}
 
-				m_InputPort[nPortIndex].GoodInput = artnet::GoodInput::DATA_RECIEVED;
+	memcpy(m_ArtDmx.Data, &pData->Data[1], nLength);
 
-				Network::Get()->SendTo(m_nHandle, &m_ArtDmx, sizeof(struct artnet::ArtDmx), m_InputPort[nPortIndex].nDestinationIp, artnet::UDP_PORT);
+	if ((nLength & 0x1) == 0x1) {
+		m_ArtDmx.Data[nLength] = 0x00;
+		nLength++;
+	}
 
-				SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX sent", nPortIndex);
+	if (nLength == 0) {
+		m_ArtDmx.Data[0] = 0x00;
+		m_ArtDmx.Data[1] = 0x00;
+		nLength = 2;
+	}
 
-				if (m_Node.Port[nPortIndex].bLocalMerge) {
-					m_pReceiveBuffer = reinterpret_cast<uint8_t *>(&m_ArtDmx);
-					m_nIpAddressFrom = Network::Get()->GetIp();
-					HandleDmx();
+	m_ArtDmx.LengthHi = static_cast<uint8_t>((nLength & 0xFF00) >> 8);
+	m_ArtDmx.Length = static_cast<uint8_t>(nLength & 0xFF);
 
-					SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX local merge", nPortIndex);
-				}
+	const auto nSize = static_cast<uint16_t>(sizeof(struct artnet::ArtDmx) - artnet::DMX_LENGTH + nLength);
 
-				if ((s_ReceivingMask & (1U << nPortIndex)) != (1U << nPortIndex)) {
-					s_ReceivingMask |= (1U << nPortIndex);
-					m_State.nReceivingDmx |= (1U << static_cast<uint8_t>(lightset::PortDir::INPUT));
-					hal::panel_led_on(hal::panelled::PORT_A_RX << nPortIndex);
-				}
+	Network::Get()->SendTo(m_nHandle, &m_ArtDmx, nSize, inputPort.nDestinationIp, artnet::UDP_PORT);
 
-				continue;
-			} 
+	inputPort.nMillis = Hardware::Get()->Millis();
+	inputPort.Statistics.nDmxPackets++;
+	inputPort.Statistics.nBytes += nSize;
 
-			if (Dmx::Get()->GetDmxUpdatesPerSecond(nPortIndex) == 0) {
-				auto sendArtDmx = false;
+	if (bIsKeepAlive) {
+		inputPort.Statistics.nKeepAlivePackets++;
+		SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX sent (keep-alive)", nPortIndex);
+	} else {
+		SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX sent", nPortIndex);
+	}
 
-				if ((m_InputPort[nPortIndex].GoodInput & artnet::GoodInput::DATA_RECIEVED) == artnet::GoodInput::DATA_RECIEVED) {
-					m_InputPort[nPortIndex].GoodInput = static_cast<uint8_t>(m_InputPort[nPortIndex].GoodInput & ~artnet::GoodInput::DATA_RECIEVED);
-					m_InputPort[nPortIndex].nMillis = Hardware::Get()->Millis();
-					sendArtDmx = true;
+	if (m_Node.Port[nPortIndex].bLocalMerge) {
+		m_pReceiveBuffer = reinterpret_cast<uint8_t *>(&m_ArtDmx);
+		m_nIpAddressFrom = Network::Get()->GetIp();
+		HandleDmx();
 
-					s_ReceivingMask &= ~(1U << nPortIndex);
-					hal::panel_led_off(hal::panelled::PORT_A_RX << nPortIndex);
+		SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX local merge", nPortIndex);
+	}
+}
 
-					if (s_ReceivingMask == 0) {
-						m_State.nReceivingDmx &= static_cast<uint8_t>(~(1U << static_cast<uint8_t>(lightset::PortDir::INPUT)));
-					}
+void ArtNetNode::HandleDmxIn() {
+	const auto nMillis = Hardware::Get()->Millis();
 
-					SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX updates per second is 0", nPortIndex);
-				} else if (m_InputPort[nPortIndex].nMillis != 0) {
-					const auto nMillis = Hardware::Get()->Millis();
-					if ((nMillis - m_InputPort[nPortIndex].nMillis) > 1000) {
-						m_InputPort[nPortIndex].nMillis = nMillis;
-						sendArtDmx = true;
+	for (uint32_t nPortIndex = 0; nPortIndex < artnetnode::MAX_PORTS; nPortIndex++) {
+		if  ((m_Node.Port[nPortIndex].direction == lightset::PortDir::INPUT)
+		 &&  (m_Node.Port[nPortIndex].protocol == artnet::PortProtocol::ARTNET)
+		 && ((m_InputPort[nPortIndex].GoodInput & artnet::GoodInput::DISABLED) != artnet::GoodInput::DISABLED)) {
 
-						SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX timeout 1 second", nPortIndex);
-					}
-				}
+			const auto *const pDmxData = Dmx::Get()->GetDmxChanged(nPortIndex);
 
-				if (sendArtDmx) {
-					const auto *const pDmxData = reinterpret_cast<const struct Data *>(Dmx::Get()->GetDmxCurrentData(nPortIndex));
+			if (pDmxData != nullptr) {
+				m_InputPort[nPortIndex].GoodInput = artnet::GoodInput::DATA_RECIEVED;
 
-					m_ArtDmx.Sequence = static_cast<uint8_t>(1U + m_InputPort[nPortIndex].nSequenceNumber++);
-					m_ArtDmx.Physical = static_cast<uint8_t>(nPortIndex);
-					m_ArtDmx.PortAddress = m_Node.Port[nPortIndex].PortAddress;
+				SendDmxIn(nPortIndex, pDmxData, false);
 
-					auto nLength = pDmxData->Statistics.nSlotsInPacket;
+				if ((s_ReceivingMask & (1U << nPortIndex)) != (1U << nPortIndex)) {
+					s_ReceivingMask |= (1U << nPortIndex);
+					m_State.nReceivingDmx |= (1U << static_cast<uint8_t>(lightset::PortDir::INPUT));
+					hal::panel_led_on(hal::panelled::PORT_A_RX << nPortIndex);
+				}
 
-					memcpy(m_ArtDmx.Data, &pDmxData->Data[1], nLength);
+				continue;
+			}
 
-					if ((nLength & 0x1) == 0x1) {
-						m_ArtDmx.Data[nLength] = 0x00;
-						nLength++;
-					}
+			if (((m_InputPort[nPortIndex].GoodInput & artnet::GoodInput::DATA_RECIEVED) == artnet::GoodInput::DATA_RECIEVED)
+			  && (Dmx::Get()->GetDmxUpdatesPerSecond(nPortIndex) == 0)) {
+				m_InputPort[nPortIndex].GoodInput = static_cast<uint8_t>(m_InputPort[nPortIndex].GoodInput & ~artnet::GoodInput::DATA_RECIEVED);
 
-					m_ArtDmx.LengthHi = static_cast<uint8_t>((nLength & 0xFF00) >> 8);
-					m_ArtDmx.Length = static_cast<uint8_t>(nLength & 0xFF);
+				s_ReceivingMask &= ~(1U << nPortIndex);
+				hal::panel_led_off(hal::panelled::PORT_A_RX << nPortIndex);
 
-					Network::Get()->SendTo(m_nHandle, &m_ArtDmx, sizeof(struct artnet::ArtDmx), m_InputPort[nPortIndex].nDestinationIp, artnet::UDP_PORT);
+				if (s_ReceivingMask == 0) {
+					m_State.nReceivingDmx &= static_cast<uint8_t>(~(1U << static_cast<uint8_t>(lightset::PortDir::INPUT)));
+				}
 
-					SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX sent (timeout)", nPortIndex);
+				SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX updates per second is 0", nPortIndex);
 
-					if (m_Node.Port[nPortIndex].bLocalMerge) {
-						m_pReceiveBuffer = reinterpret_cast<uint8_t *>(&m_ArtDmx);
-						m_nIpAddressFrom = Network::Get()->GetIp();
-						HandleDmx();
+				SendDmxIn(nPortIndex, Dmx::Get()->GetDmxCurrentData(nPortIndex), true);
+				continue;
+			}
 
-						SendDiag(artnet::PriorityCodes::DIAG_LOW, "%u: Input DMX local merge", nPortIndex);
-					}
-				}
+			if ((m_InputPort[nPortIndex].nMillis != 0) && ((nMillis - m_InputPort[nPortIndex].nMillis) >= artnet::DMX_INPUT_KEEP_ALIVE_MILLIS)) {
+				SendDmxIn(nPortIndex, Dmx::Get()->GetDmxCurrentData(nPortIndex), true);
 			}
 		}
 	}
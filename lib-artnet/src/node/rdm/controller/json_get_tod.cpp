@@ -24,30 +24,56 @@
  */
 
 #include <cstdint>
-#include <cstdio>
-#include <cassert>
 
 #include "artnetnode.h"
+#include "jsonwriter.h"
 
 namespace remoteconfig {
 namespace rdm {
-uint32_t json_get_tod(const char cPort, char *pOutBuffer, const uint32_t nOutBufferSize) {
+/**
+ * The TOD can have more entries than fit in one buffer, it is streamed
+ */
+void json_get_tod(const char cPort, JsonWriter& writer) {
+	static constexpr char HEX[] = "0123456789abcdef";
 	const uint32_t nPortIndex = (cPort | 0x20) - 'a';
 
-	if (nPortIndex < artnetnode::MAX_PORTS) {
-		const auto nBufferSize = nOutBufferSize - 2U;
-		auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nBufferSize, "{\"port\":\"%c\",\"tod\":[" , (nPortIndex + 'A')));
+	if (nPortIndex >= artnetnode::MAX_PORTS) {
+		return;
+	}
+
+	const char port[1] = { static_cast<char>(nPortIndex + 'A') };
+
+	writer.ObjectBegin();
+	writer.Add("port", port, 1);
+	writer.ArrayBegin("tod");
+
+	const auto nUidCount = ArtNetNode::Get()->RdmGetUidCount(nPortIndex);
+
+	for (uint32_t nIndex = 0; nIndex < nUidCount; nIndex++) {
+		uint8_t uid[RDM_UID_SIZE];
+
+		if (!ArtNetNode::Get()->RdmCopyTodEntry(nPortIndex, nIndex, uid)) {
+			break;
+		}
+
+		// "mmmm:dddddddd"
+		char text[13];
+		auto *p = text;
 
-		nLength += ArtNetNode::Get()->RdmCopyTod(nPortIndex, &pOutBuffer[nLength], nBufferSize - nLength);
+		for (uint32_t i = 0; i < RDM_UID_SIZE; i++) {
+			*p++ = HEX[uid[i] >> 4];
+			*p++ = HEX[uid[i] & 0xF];
 
-		pOutBuffer[nLength++] = ']';
-		pOutBuffer[nLength++] = '}';
+			if (i == 1) {
+				*p++ = ':';
+			}
+		}
 
-		assert(nLength <= nOutBufferSize);
-		return nLength;
+		writer.Add(nullptr, text, sizeof(text));
 	}
 
-	return 0;
+	writer.ArrayEnd();
+	writer.ObjectEnd();
 }
 }  // namespace rdm
 }  // namespace remoteconfig
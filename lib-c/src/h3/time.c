@@ -23,7 +23,9 @@
  * THE SOFTWARE.
  */
 
+#include <stdint.h>
 #include <stddef.h>
+#include <errno.h>
 #include <sys/time.h>
 #include <assert.h>
 
@@ -33,42 +35,74 @@
 
 #include "debug.h"
 
-static uint32_t set_timer = 0;
-static struct timeval s_tv;
-
 /*
- * number of seconds and microseconds since the Epoch,
- *     1970-01-01 00:00:00 +0000 (UTC).
+ * The micros timer gives the resolution, the millis timer covers the
+ * wrap of the micros timer after 71 minutes without a call.
  */
+#define MICROS_TIMER_WRAP_MILLIS	(60U * 60U * 1000U)
+#define SLEW_DIVISOR				2000	/* 1 us for each 2000 us: 500 ppm */
 
-int gettimeofday(struct timeval *tv, __attribute__((unused))  struct timezone *tz) {
-	assert(tv != 0);
+static uint64_t s_micros;			/* since the Epoch */
+static uint32_t s_millis_timer;
+static uint32_t s_micros_timer;
+static int32_t s_adjust_micros;		/* left to slew */
+static uint32_t s_slew_remainder;
 
-	const uint32_t timer = H3_TIMER->AVS_CNT0; // Millis timer
+static void time_update(void) {
+	const uint32_t millis_timer = H3_TIMER->AVS_CNT0;
+	const uint32_t micros_timer = H3_TIMER->AVS_CNT1;
+	const uint32_t millis_elapsed = millis_timer - s_millis_timer;
 
-	uint32_t millis_elapsed;
+	uint64_t micros_elapsed;
 
-	if (set_timer >= timer) {
-		millis_elapsed = set_timer - timer;
+	if (millis_elapsed < MICROS_TIMER_WRAP_MILLIS) {
+		micros_elapsed = micros_timer - s_micros_timer;
 	} else {
-		millis_elapsed = timer - set_timer;
+		micros_elapsed = (uint64_t) millis_elapsed * 1000U;
 	}
 
-	set_timer = timer;
+	s_millis_timer = millis_timer;
+	s_micros_timer = micros_timer;
+
+	s_micros += micros_elapsed;
 
-	uint32_t sec = millis_elapsed / 1000U;
-	const uint32_t usec = (millis_elapsed - (sec * 1000U)) * 1000U;
+	if (s_adjust_micros == 0) {
+		return;
+	}
 
-	s_tv.tv_sec += (time_t)sec;
-	s_tv.tv_usec += (suseconds_t)usec;
+	const uint64_t slew_elapsed = micros_elapsed + s_slew_remainder;
+	uint64_t slew = slew_elapsed / SLEW_DIVISOR;
+	s_slew_remainder = (uint32_t) (slew_elapsed - (slew * SLEW_DIVISOR));
 
-	if (s_tv.tv_usec >= 1000000) {
-		s_tv.tv_sec++;
-		s_tv.tv_usec = 1000000 - s_tv.tv_usec;
+	if (s_adjust_micros > 0) {
+		if (slew > (uint64_t) s_adjust_micros) {
+			slew = (uint64_t) s_adjust_micros;
+		}
+		s_micros += slew;
+		s_adjust_micros -= (int32_t) slew;
+	} else {
+		if (slew > (uint64_t) -s_adjust_micros) {
+			slew = (uint64_t) -s_adjust_micros;
+		}
+		s_micros -= slew;
+		s_adjust_micros += (int32_t) slew;
 	}
+}
 
-	tv->tv_sec = s_tv.tv_sec;
-	tv->tv_usec = s_tv.tv_usec;
+/*
+ * number of seconds and microseconds since the Epoch,
+ *     1970-01-01 00:00:00 +0000 (UTC).
+ */
+
+int gettimeofday(struct timeval *tv, __attribute__((unused))  struct timezone *tz) {
+	assert(tv != 0);
+
+	time_update();
+
+	const uint64_t sec = s_micros / 1000000U;
+
+	tv->tv_sec = (time_t) sec;
+	tv->tv_usec = (suseconds_t) (s_micros - (sec * 1000000U));
 
 	return 0;
 }
@@ -76,10 +110,34 @@ int gettimeofday(struct timeval *tv, __attribute__((unused))  struct timezone *t
 int settimeofday(const struct timeval *tv, __attribute__((unused)) const struct timezone *tz) {
 	assert(tv != 0);
 
-	set_timer = H3_TIMER->AVS_CNT0;
+	time_update();
+
+	s_micros = ((uint64_t) tv->tv_sec * 1000000U) + (uint64_t) tv->tv_usec;
+	s_adjust_micros = 0;
+	s_slew_remainder = 0;
+
+	return 0;
+}
+
+int adjtime(const struct timeval *delta, struct timeval *olddelta) {
+	time_update();
+
+	if (olddelta != 0) {
+		olddelta->tv_sec = s_adjust_micros / 1000000;
+		olddelta->tv_usec = s_adjust_micros % 1000000;
+	}
 
-	s_tv.tv_sec = tv->tv_sec;
-	s_tv.tv_usec = tv->tv_usec;
+	if (delta != 0) {
+		const int64_t adjust_micros = ((int64_t) delta->tv_sec * 1000000) + delta->tv_usec;
+
+		if ((adjust_micros > INT32_MAX) || (adjust_micros < -INT32_MAX)) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		s_adjust_micros = (int32_t) adjust_micros;
+		s_slew_remainder = 0;
+	}
 
 	return 0;
 }
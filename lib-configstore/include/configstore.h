@@ -59,6 +59,7 @@ enum class Store {
 	RGBPANEL,
 	NODE,
 	PCA9685,
+	DHCP,
 	LAST
 };
 
@@ -252,6 +252,13 @@ public:
 
 	void ShowIpAddress() {
 		ClearEndOfLine();
+
+		// The lease is acquired in the background
+		if (Network::Get()->IsDhcpUsed() && (Network::Get()->GetIp() == 0)) {
+			Printf(m_aLabels[static_cast<uint32_t>(displayudf::Labels::IP)], "DHCP pending");
+			return;
+		}
+
 		Printf(m_aLabels[static_cast<uint32_t>(displayudf::Labels::IP)], "" IPSTR "/%d %c", IP2STR(Network::Get()->GetIp()), Network::Get()->GetNetmaskCIDR(), Network::Get()->GetAddressingMode());
 	}
 
@@ -49,6 +49,12 @@ static uint32_t micros(void) {
 	return static_cast<uint32_t>((tv.tv_sec * 1000000) + tv.tv_usec);
 }
 
+static uint32_t millis(void) {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return static_cast<uint32_t>((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+}
+
 #include "config.h"
 
 using namespace dmx;
@@ -57,7 +63,13 @@ static int s_nHandePortDmx[dmx::config::max::OUT];
 static int s_nHandePortRdm[dmx::config::max::OUT];
 static uint8_t rdmReceiveBuffer[1500];
 
-struct Data dmxDataRx;
+static struct Data s_DmxDataRx[dmx::config::max::IN];
+static uint8_t s_DmxDataPrevious[dmx::config::max::IN][dmx::buffer::SIZE];
+static uint32_t s_nLengthPrevious[dmx::config::max::IN];
+static uint32_t s_nDmxPackets[dmx::config::max::IN];
+static uint32_t s_nDmxPacketsPrevious[dmx::config::max::IN];
+static uint32_t s_nDmxUpdatesPerSecond[dmx::config::max::IN];
+static uint32_t s_nMillisPrevious[dmx::config::max::IN];
 
 static uint8_t dmxSendBuffer[513];
 
@@ -151,7 +163,7 @@ void Dmx::SetSendDataWithoutSC(uint32_t nPortIndex, const uint8_t *pData, uint32
 	dmxSendBuffer[0] = 0;
 	memcpy(&dmxSendBuffer[1], pData,  nLength);
 
-	Network::Get()->SendTo(s_nHandePortDmx[nPortIndex], dmxSendBuffer, nLength, Network::Get()->GetBroadcastIp(), UDP_PORT_DMX_START + nPortIndex);
+	Network::Get()->SendTo(s_nHandePortDmx[nPortIndex], dmxSendBuffer, 1U + nLength, Network::Get()->GetBroadcastIp(), UDP_PORT_DMX_START + nPortIndex);
 }
 
 void Dmx::Blackout() {
@@ -168,46 +180,73 @@ void Dmx::FullOn() {
 
 // DMX Receive
 
-const uint8_t *Dmx::GetDmxAvailable([[maybe_unused]] uint32_t nPortIndex)  {
-	assert(nPortIndex < dmx::config::max::OUT);
+/*
+ * The UDP packet is emulating the DMX frame: start code followed by the slots.
+ */
+
+const uint8_t *Dmx::GetDmxAvailable(uint32_t nPortIndex)  {
+	assert(nPortIndex < dmx::config::max::IN);
 
 	uint32_t fromIp;
 	uint16_t fromPort;
 
-	uint32_t nPackets = 0;
-	uint16_t nBytesReceived;
+	auto *pDmxData = &s_DmxDataRx[nPortIndex];
 
-//	do {
-		nBytesReceived = Network::Get()->RecvFrom(s_nHandePortDmx[nPortIndex], &dmxDataRx, sizeof(buffer::SIZE), &fromIp, &fromPort);
-		if ((nBytesReceived != 0) && (fromIp != Network::Get()->GetIp()) && (fromPort == (UDP_PORT_DMX_START + nPortIndex))) {
-			nPackets++;
-		}
-//	} while (nBytesReceived == 0);
+	const auto nBytesReceived = Network::Get()->RecvFrom(s_nHandePortDmx[nPortIndex], pDmxData->Data, sizeof(pDmxData->Data), &fromIp, &fromPort);
 
-	if (nPackets == 0) {
+	if ((nBytesReceived == 0) || (fromIp == Network::Get()->GetIp()) || (fromPort != (UDP_PORT_DMX_START + nPortIndex))) {
 		return nullptr;
 	}
 
-	dmxDataRx.Statistics.nSlotsInPacket = nBytesReceived;
-	return const_cast<const uint8_t *>(dmxDataRx.Data);
+	s_nDmxPackets[nPortIndex]++;
+
+	pDmxData->Statistics.nSlotsInPacket = std::min(static_cast<uint32_t>(nBytesReceived - 1U), dmx::max::CHANNELS);
+	return const_cast<const uint8_t *>(pDmxData->Data);
 }
 
 const uint8_t *Dmx::GetDmxChanged(uint32_t nPortIndex) {
 	const auto *p = GetDmxAvailable(nPortIndex);
-	// This function is not implemented
+
+	if (p == nullptr) {
+		return nullptr;
+	}
+
+	const auto *pDmxData = &s_DmxDataRx[nPortIndex];
+	const auto nLength = 1U + pDmxData->Statistics.nSlotsInPacket;
+	auto *pPrevious = s_DmxDataPrevious[nPortIndex];
+
+	if ((s_nLengthPrevious[nPortIndex] == nLength) && (memcmp(pPrevious, p, nLength) == 0)) {
+		return nullptr;
+	}
+
+	memcpy(pPrevious, p, nLength);
+	s_nLengthPrevious[nPortIndex] = nLength;
+
 	return p;
 }
 
-const uint8_t* Dmx::GetDmxCurrentData([[maybe_unused]] uint32_t nPortIndex) {
-	return const_cast<const uint8_t *>(dmxDataRx.Data);
+const uint8_t* Dmx::GetDmxCurrentData(uint32_t nPortIndex) {
+	assert(nPortIndex < dmx::config::max::IN);
+	return const_cast<const uint8_t *>(s_DmxDataRx[nPortIndex].Data);
 }
 
-uint32_t Dmx::GetDmxUpdatesPerSecond([[maybe_unused]] uint32_t nPortIndex) {
-	return 0;
+uint32_t Dmx::GetDmxUpdatesPerSecond(uint32_t nPortIndex) {
+	assert(nPortIndex < dmx::config::max::IN);
+
+	const auto nMillis = millis();
+
+	if ((nMillis - s_nMillisPrevious[nPortIndex]) >= 1000U) {
+		s_nDmxUpdatesPerSecond[nPortIndex] = s_nDmxPackets[nPortIndex] - s_nDmxPacketsPrevious[nPortIndex];
+		s_nDmxPacketsPrevious[nPortIndex] = s_nDmxPackets[nPortIndex];
+		s_nMillisPrevious[nPortIndex] = nMillis;
+	}
+
+	return s_nDmxUpdatesPerSecond[nPortIndex];
 }
 
-uint32_t GetDmxReceivedCount([[maybe_unused]] uint32_t nPortIndex) {
-	return 0;
+uint32_t Dmx::GetDmxReceivedCount(uint32_t nPortIndex) {
+	assert(nPortIndex < dmx::config::max::IN);
+	return s_nDmxPackets[nPortIndex];
 }
 
 // RDM Send
@@ -35,6 +35,7 @@ static constexpr auto MERGE_TIMEOUT_SECONDS = 10;
 static constexpr auto PRIORITY_TIMEOUT_SECONDS = 10;
 static constexpr auto UNIVERSE_DISCOVERY_INTERVAL_SECONDS = 10;
 static constexpr auto NETWORK_DATA_LOSS_TIMEOUT_SECONDS = 2.5f;
+static constexpr auto DMX_INPUT_KEEP_ALIVE_MILLIS = 1000U;	///< Unchanged input data is re-transmitted with this interval
 
 struct OptionsMask {
 	static constexpr auto PREVIEW_DATA = (1U << 7);			///< Preview Data: Bit 7 (most significant bit)
@@ -36,6 +36,7 @@
 
 #include "lightset.h"
 #include "lightsetdata.h"
+#include "lightsetpresentation.h"
 
 #if !(ARTNET_VERSION >= 4)
 # if defined(OUTPUT_DMX_SEND) || defined(OUTPUT_DMX_SEND_MULTI)
@@ -111,9 +112,16 @@ struct OutputPort {
 	bool IsTransmitting;
 };
 
+struct InputStatistics {
+	uint32_t nDmxPackets;		///< Data packets sent, including the keep-alive packets
+	uint32_t nKeepAlivePackets;	///< Data packets sent with unchanged data
+	uint32_t nBytes;			///< UDP payload bytes sent
+};
+
 struct InputPort {
+	InputStatistics Statistics;
 	uint32_t nMulticastIp;
-	uint32_t nMillis;
+	uint32_t nMillis;			///< The latest time a data packet was sent for this port
 	uint8_t nSequenceNumber;
 	uint8_t nPriority;
 	bool IsDisabled;
@@ -139,6 +147,31 @@ public:
 		return m_pLightSet;
 	}
 
+	/**
+	 * The output of the synchronization packet at a presentation time, the clock is Hardware::Micros when not given.
+	 * Mode::CLOCK takes the shared clock, without one it is Mode::LATENCY.
+	 */
+	void SetPresentation(lightset::presentation::Mode mode, const uint32_t nLatencyBudgetMicros, lightset::presentation::Clock pClock = nullptr) {
+		if ((pClock == nullptr) && (mode == lightset::presentation::Mode::CLOCK)) {
+			pClock = lightset::presentation::get_shared_clock();
+
+			if (pClock == nullptr) {
+				// Without a shared clock there is no grid
+				mode = lightset::presentation::Mode::LATENCY;
+			}
+		}
+
+		if (pClock == nullptr) {
+			pClock = []() { return Hardware::Get()->Micros(); };
+		}
+
+		m_Presentation.SetMode(mode, nLatencyBudgetMicros, pClock);
+	}
+
+	const LightSetPresentation& GetPresentation() const {
+		return m_Presentation;
+	}
+
 	void SetUniverse(const uint32_t nPortIndex, const lightset::PortDir portDir, const uint16_t nUniverse);
 	bool GetUniverse(const uint32_t nPortIndex, uint16_t &nUniverse, lightset::PortDir portDir) const {
 		assert(nPortIndex < e131bridge::MAX_PORTS);
@@ -256,6 +289,11 @@ public:
 		return m_InputPort[nPortIndex].IsDisabled;
 	}
 
+	const e131bridge::InputStatistics& GetInputStatistics(const uint32_t nPortIndex) const {
+		assert(nPortIndex < e131bridge::MAX_PORTS);
+		return m_InputPort[nPortIndex].Statistics;
+	}
+
 #if defined (OUTPUT_HAVE_STYLESWITCH)
 	void SetOutputStyle(const uint32_t nPortIndex, lightset::OutputStyle outputStyle) {
 		assert(nPortIndex < e131bridge::MAX_PORTS);
@@ -306,6 +344,11 @@ public:
 	void Stop();
 
 	void Run() {
+		if (__builtin_expect((m_Presentation.IsDue()), 0)) {
+			SyncOutput();
+			m_Presentation.Presented();
+		}
+
 		uint16_t nForeignPort;
 
 		const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&m_pReceiveBuffer)), &m_nIpAddressFrom, &nForeignPort) ;
@@ -394,10 +437,18 @@ private:
 
 	void HandleDmx();
 	void HandleSynchronization();
+	void SyncOutput();
+	void PresentPending() {
+		if (m_Presentation.IsPending()) {
+			SyncOutput();
+			m_Presentation.Presented(true);
+		}
+	}
 
 	void LeaveUniverse(uint32_t nPortIndex, uint16_t nUniverse);
 
 	void HandleDmxIn();
+	void SendDmxIn(const uint32_t nPortIndex, const uint8_t *pDmxData, const bool bIsKeepAlive);
 	void SetLocalMerging();
 	void FillDataPacket();
 	void FillDiscoveryPacket();
@@ -424,6 +475,8 @@ private:
 
 	bool m_bEnableDataIndicator { true };
 
+	LightSetPresentation m_Presentation;
+
 	uint8_t *m_pReceiveBuffer;
 	uint32_t m_nIpAddressFrom;
 	LightSet *m_pLightSet { nullptr };
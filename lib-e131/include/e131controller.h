@@ -39,6 +39,10 @@ enum {
 #define DMX_MAX_VALUE 255
 #endif
 
+namespace e131controller {
+static constexpr uint32_t DMX_QUEUE_UNIVERSES = 64;	///< Staged data packets before an implicit flush
+}  // namespace e131controller
+
 struct TE131ControllerState {
 	bool bIsRunning;
 	uint16_t nActiveUniverses;
@@ -63,6 +67,12 @@ public:
 	void Print();
 
 	void HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength);
+	/**
+	 * Frame based transmit: stage the universes of a frame with HandleDmxOutQueued()
+	 * and send them all at once with HandleDmxOutFlush(). HandleSync() flushes first.
+	 */
+	void HandleDmxOutQueued(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength);
+	void HandleDmxOutFlush();
 	void HandleSync();
 	void HandleBlackout();
 
@@ -96,6 +106,7 @@ public:
 
 private:
 	void FillDataPacket();
+	uint32_t DmxFill(TE131DataPacket *pE131DataPacket, uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength);
 	void FillDiscoveryPacket();
 	void FillSynchronizationPacket();
 	void SendDiscoveryPacket();
@@ -106,6 +117,8 @@ private:
 	uint32_t m_nCurrentPacketMillis { 0 };
 	struct TE131ControllerState m_State;
 	TE131DataPacket *m_pE131DataPacket { nullptr };
+	TE131DataPacket *m_pE131DataPacketQueue { nullptr };
+	uint32_t m_nDmxQueued { 0 };
 	TE131DiscoveryPacket *m_pE131DiscoveryPacket { nullptr };
 	TE131SynchronizationPacket *m_pE131SynchronizationPacket { nullptr };
 	uint32_t m_DiscoveryIpAddress { 0 };
@@ -84,6 +84,9 @@ E131Controller::E131Controller() {
 	m_pE131DataPacket = new struct TE131DataPacket;
 	assert(m_pE131DataPacket != nullptr);
 
+	m_pE131DataPacketQueue = new struct TE131DataPacket[e131controller::DMX_QUEUE_UNIVERSES];
+	assert(m_pE131DataPacketQueue != nullptr);
+
 	// TE131DiscoveryPacket
 	m_pE131DiscoveryPacket = new struct TE131DiscoveryPacket;
 	assert(m_pE131DiscoveryPacket != nullptr);
@@ -113,6 +116,11 @@ E131Controller::~E131Controller() {
 		m_pE131DiscoveryPacket = nullptr;
 	}
 
+	if (m_pE131DataPacketQueue != nullptr) {
+		delete[] m_pE131DataPacketQueue;
+		m_pE131DataPacketQueue = nullptr;
+	}
+
 	if (m_pE131DataPacket != nullptr) {
 		delete m_pE131DataPacket;
 		m_pE131DataPacket = nullptr;
@@ -134,6 +142,7 @@ void E131Controller::Start() {
 }
 
 void E131Controller::Stop() {
+	HandleDmxOutFlush();
 	m_State.bIsRunning = false;
 }
 
@@ -200,36 +209,67 @@ void E131Controller::FillSynchronizationPacket() {
 	m_pE131SynchronizationPacket->FrameLayer.UniverseNumber = __builtin_bswap16(m_State.SynchronizationPacket.nUniverseNumber);
 }
 
-void E131Controller::HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength) {
+/**
+ * @return the multicast address for nUniverse
+ */
+uint32_t E131Controller::DmxFill(TE131DataPacket *pE131DataPacket, uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength) {
 	uint32_t nIp;
 
 	// Root Layer (See Section 5)
-	m_pE131DataPacket->RootLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_ROOT_LAYER_LENGTH(1U + nLength))));
+	pE131DataPacket->RootLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_ROOT_LAYER_LENGTH(1U + nLength))));
 
 	// E1.31 Framing Layer (See Section 6)
-	m_pE131DataPacket->FrameLayer.FLagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_FRAME_LAYER_LENGTH(1U + nLength))));
-	m_pE131DataPacket->FrameLayer.SequenceNumber = GetSequenceNumber(nUniverse, nIp);
-	m_pE131DataPacket->FrameLayer.Universe = __builtin_bswap16(nUniverse);
+	pE131DataPacket->FrameLayer.FLagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_FRAME_LAYER_LENGTH(1U + nLength))));
+	pE131DataPacket->FrameLayer.SequenceNumber = GetSequenceNumber(nUniverse, nIp);
+	pE131DataPacket->FrameLayer.Universe = __builtin_bswap16(nUniverse);
 
 	// Data Layer
-	m_pE131DataPacket->DMPLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_LAYER_LENGTH(1U + nLength))));
+	pE131DataPacket->DMPLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_LAYER_LENGTH(1U + nLength))));
 
 	if (__builtin_expect((m_nMaster == DMX_MAX_VALUE), 1)) {
-		memcpy(&m_pE131DataPacket->DMPLayer.PropertyValues[1], pDmxData, nLength);
+		memcpy(&pE131DataPacket->DMPLayer.PropertyValues[1], pDmxData, nLength);
 	} else if (m_nMaster == 0) {
-		memset(&m_pE131DataPacket->DMPLayer.PropertyValues[1], 0, nLength);
+		memset(&pE131DataPacket->DMPLayer.PropertyValues[1], 0, nLength);
 	} else {
 		for (uint32_t i = 0; i < nLength; i++) {
-			m_pE131DataPacket->DMPLayer.PropertyValues[1 + i] = static_cast<uint8_t>((m_nMaster * pDmxData[i]) / DMX_MAX_VALUE);
+			pE131DataPacket->DMPLayer.PropertyValues[1 + i] = static_cast<uint8_t>((m_nMaster * pDmxData[i]) / DMX_MAX_VALUE);
 		}
 	}
 
-	m_pE131DataPacket->DMPLayer.PropertyValueCount = __builtin_bswap16(static_cast<uint16_t>(1 + nLength));
+	pE131DataPacket->DMPLayer.PropertyValueCount = __builtin_bswap16(static_cast<uint16_t>(1 + nLength));
+
+	return nIp;
+}
+
+void E131Controller::HandleDmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength) {
+	const auto nIp = DmxFill(m_pE131DataPacket, nUniverse, pDmxData, nLength);
 
 	Network::Get()->SendTo(m_nHandle, m_pE131DataPacket, static_cast<uint16_t>(DATA_PACKET_SIZE(1U + nLength)), nIp, e131::UDP_PORT);
 }
 
+void E131Controller::HandleDmxOutQueued(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength) {
+	if (m_nDmxQueued == e131controller::DMX_QUEUE_UNIVERSES) {
+		HandleDmxOutFlush();
+	}
+
+	auto *pE131DataPacket = &m_pE131DataPacketQueue[m_nDmxQueued++];
+
+	// The layers up to and including the START Code are shared by all universes
+	memcpy(pE131DataPacket, m_pE131DataPacket, DATA_PACKET_SIZE(1U));
+
+	const auto nIp = DmxFill(pE131DataPacket, nUniverse, pDmxData, nLength);
+
+	Network::Get()->SendToQueued(m_nHandle, pE131DataPacket, static_cast<uint16_t>(DATA_PACKET_SIZE(1U + nLength)), nIp, e131::UDP_PORT);
+}
+
+void E131Controller::HandleDmxOutFlush() {
+	Network::Get()->SendFlush();
+	m_nDmxQueued = 0;
+}
+
 void E131Controller::HandleSync() {
+	HandleDmxOutFlush();
+
 	if (m_State.SynchronizationPacket.nUniverseNumber != 0) {
 		m_pE131SynchronizationPacket->FrameLayer.SequenceNumber = m_State.SynchronizationPacket.nSequenceNumber++;
 		Network::Get()->SendTo(m_nHandle, m_pE131SynchronizationPacket, SYNCHRONIZATION_PACKET_SIZE, m_State.SynchronizationPacket.nIpAddress, e131::UDP_PORT);
@@ -237,6 +277,8 @@ void E131Controller::HandleSync() {
 }
 
 void E131Controller::HandleBlackout() {
+	HandleDmxOutFlush();
+
 	// Root Layer (See Section 5)
 	m_pE131DataPacket->RootLayer.FlagsLength = __builtin_bswap16((0x07 << 12) | (DATA_ROOT_LAYER_LENGTH(513)));
 
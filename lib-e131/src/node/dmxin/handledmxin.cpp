@@ -62,33 +62,63 @@ void E131Bridge::FillDataPacket() {
 
 static uint32_t s_ReceivingMask = 0;
 
+/**
+ * Only the received slots are sent.
+ * Changed input data is sent immediately. Unchanged data is re-transmitted
+ * with the e131::DMX_INPUT_KEEP_ALIVE_MILLIS interval.
+ */
+
+void E131Bridge::SendDmxIn(const uint32_t nPortIndex, const uint8_t *pDmxData, const bool bIsKeepAlive) {
+	const auto *const pData = reinterpret_cast<const struct Data *>(pDmxData);
+	auto& inputPort = m_InputPort[nPortIndex];
+
+	auto nLength = (1U + pData->Statistics.nSlotsInPacket); // Add 1 for SC
+
+	if (nLength > (1U + e131::DMX_LENGTH)) {
+		nLength = 1U + e131::DMX_LENGTH;
+	}
+
+	// Root Layer (See Section 5)
+	m_pE131DataPacket->RootLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_ROOT_LAYER_LENGTH(nLength))));
+	// E1.31 Framing Layer (See Section 6)
+	m_pE131DataPacket->FrameLayer.FLagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_FRAME_LAYER_LENGTH(nLength))));
+	m_pE131DataPacket->FrameLayer.Priority = inputPort.nPriority;
+	m_pE131DataPacket->FrameLayer.SequenceNumber = inputPort.nSequenceNumber++;
+	m_pE131DataPacket->FrameLayer.Universe = __builtin_bswap16(m_Bridge.Port[nPortIndex].nUniverse);
+	// Data Layer
+	m_pE131DataPacket->DMPLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_LAYER_LENGTH(nLength))));
+	memcpy(m_pE131DataPacket->DMPLayer.PropertyValues, pData->Data, nLength);
+	m_pE131DataPacket->DMPLayer.PropertyValueCount = __builtin_bswap16(static_cast<uint16_t>(nLength));
+
+	const auto nSize = static_cast<uint16_t>(DATA_PACKET_SIZE(nLength));
+
+	Network::Get()->SendTo(m_nHandle, m_pE131DataPacket, nSize, inputPort.nMulticastIp, e131::UDP_PORT);
+
+	inputPort.nMillis = Hardware::Get()->Millis();
+	inputPort.Statistics.nDmxPackets++;
+	inputPort.Statistics.nBytes += nSize;
+
+	if (bIsKeepAlive) {
+		inputPort.Statistics.nKeepAlivePackets++;
+	}
+
+	if (m_Bridge.Port[nPortIndex].bLocalMerge) {
+		m_pReceiveBuffer = reinterpret_cast<uint8_t *>(m_pE131DataPacket);
+		m_nIpAddressFrom = Network::Get()->GetIp();
+		HandleDmx();
+	}
+}
+
 void E131Bridge::HandleDmxIn() {
+	const auto nMillis = Hardware::Get()->Millis();
+
 	for (uint32_t nPortIndex = 0 ; nPortIndex < e131bridge::MAX_PORTS; nPortIndex++) {
 		if ((m_Bridge.Port[nPortIndex].direction == lightset::PortDir::INPUT) && (!m_InputPort[nPortIndex].IsDisabled)) {
 
-			const auto *const pDmxData = reinterpret_cast<const struct Data *>(Dmx::Get()->GetDmxChanged(nPortIndex));
+			const auto *const pDmxData = Dmx::Get()->GetDmxChanged(nPortIndex);
 
 			if (pDmxData != nullptr) {
-				// Root Layer (See Section 5)
-				auto nLength = (1U + pDmxData->Statistics.nSlotsInPacket); // Add 1 for SC
-				m_pE131DataPacket->RootLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_ROOT_LAYER_LENGTH(nLength))));
-				// E1.31 Framing Layer (See Section 6)
-				m_pE131DataPacket->FrameLayer.FLagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_FRAME_LAYER_LENGTH(nLength))));
-				m_pE131DataPacket->FrameLayer.Priority = m_InputPort[nPortIndex].nPriority;
-				m_pE131DataPacket->FrameLayer.SequenceNumber = m_InputPort[nPortIndex].nSequenceNumber++;
-				m_pE131DataPacket->FrameLayer.Universe = __builtin_bswap16(m_Bridge.Port[nPortIndex].nUniverse);
-				// Data Layer
-				m_pE131DataPacket->DMPLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_LAYER_LENGTH(nLength))));
-				memcpy(m_pE131DataPacket->DMPLayer.PropertyValues, pDmxData, nLength);
-				m_pE131DataPacket->DMPLayer.PropertyValueCount = __builtin_bswap16(static_cast<uint16_t>(nLength));
-
-				Network::Get()->SendTo(m_nHandle, m_pE131DataPacket, static_cast<uint16_t>(DATA_PACKET_SIZE(nLength)), m_InputPort[nPortIndex].nMulticastIp, e131::UDP_PORT);
-
-				if (m_Bridge.Port[nPortIndex].bLocalMerge) {
-					m_pReceiveBuffer = reinterpret_cast<uint8_t *>(m_pE131DataPacket);
-					m_nIpAddressFrom = Network::Get()->GetIp();
-					HandleDmx();
-				}
+				SendDmxIn(nPortIndex, pDmxData, false);
 
 				if ((s_ReceivingMask & (1U << nPortIndex)) != (1U << nPortIndex)) {
 					s_ReceivingMask |= (1U << nPortIndex);
@@ -97,52 +127,22 @@ void E131Bridge::HandleDmxIn() {
 				}
 
 				continue;
-			} 
-				
-			if (Dmx::Get()->GetDmxUpdatesPerSecond(nPortIndex) == 0) {
-				auto sendArtDmx = false;
-
-				if ((s_ReceivingMask & (1U << nPortIndex)) == (1U << nPortIndex)) {
-					sendArtDmx = true;
-
-					s_ReceivingMask &= ~(1U << nPortIndex);
-					hal::panel_led_off(hal::panelled::PORT_A_RX << nPortIndex);
-
-					if (s_ReceivingMask == 0) {
-						m_State.nReceivingDmx &= static_cast<uint8_t>(~(1U << static_cast<uint8_t>(lightset::PortDir::INPUT)));
-					}
-				} else if (m_InputPort[nPortIndex].nMillis != 0) {
-					const auto nMillis = Hardware::Get()->Millis();
-					if ((nMillis - m_InputPort[nPortIndex].nMillis) > 1000) {
-						m_InputPort[nPortIndex].nMillis = nMillis;
-						sendArtDmx = true;
-					}
-				}
+			}
+
+			if (((s_ReceivingMask & (1U << nPortIndex)) == (1U << nPortIndex)) && (Dmx::Get()->GetDmxUpdatesPerSecond(nPortIndex) == 0)) {
+				s_ReceivingMask &= ~(1U << nPortIndex);
+				hal::panel_led_off(hal::panelled::PORT_A_RX << nPortIndex);
 
-				if (sendArtDmx) {
-					const auto *const pDmxData = reinterpret_cast<const struct Data *>(Dmx::Get()->GetDmxCurrentData(nPortIndex));
-					// Root Layer (See Section 5)
-					auto nLength = (1U + pDmxData->Statistics.nSlotsInPacket); // Add 1 for SC
-					m_pE131DataPacket->RootLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_ROOT_LAYER_LENGTH(nLength))));
-					// E1.31 Framing Layer (See Section 6)
-					m_pE131DataPacket->FrameLayer.FLagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_FRAME_LAYER_LENGTH(nLength))));
-					m_pE131DataPacket->FrameLayer.Priority = m_InputPort[nPortIndex].nPriority;
-					m_pE131DataPacket->FrameLayer.SequenceNumber = m_InputPort[nPortIndex].nSequenceNumber++;
-					m_pE131DataPacket->FrameLayer.Universe = __builtin_bswap16(m_Bridge.Port[nPortIndex].nUniverse);
-					// Data Layer
-					m_pE131DataPacket->DMPLayer.FlagsLength = __builtin_bswap16(static_cast<uint16_t>((0x07 << 12) | (DATA_LAYER_LENGTH(nLength))));
-					memcpy(m_pE131DataPacket->DMPLayer.PropertyValues, pDmxData, nLength);
-					m_pE131DataPacket->DMPLayer.PropertyValueCount = __builtin_bswap16(static_cast<uint16_t>(nLength));
-
-					Network::Get()->SendTo(m_nHandle, m_pE131DataPacket, static_cast<uint16_t>(DATA_PACKET_SIZE(nLength)), m_InputPort[nPortIndex].nMulticastIp, e131::UDP_PORT);
-
-					if (m_Bridge.Port[nPortIndex].bLocalMerge) {
-						m_pReceiveBuffer = reinterpret_cast<uint8_t *>(&m_pE131DataPacket);
-						m_nIpAddressFrom = Network::Get()->GetIp();
-						HandleDmx();
-					}
+				if (s_ReceivingMask == 0) {
+					m_State.nReceivingDmx &= static_cast<uint8_t>(~(1U << static_cast<uint8_t>(lightset::PortDir::INPUT)));
 				}
 
+				SendDmxIn(nPortIndex, Dmx::Get()->GetDmxCurrentData(nPortIndex), true);
+				continue;
+			}
+
+			if ((m_InputPort[nPortIndex].nMillis != 0) && ((nMillis - m_InputPort[nPortIndex].nMillis) >= e131::DMX_INPUT_KEEP_ALIVE_MILLIS)) {
+				SendDmxIn(nPortIndex, Dmx::Get()->GetDmxCurrentData(nPortIndex), true);
 			}
 		}
 	}
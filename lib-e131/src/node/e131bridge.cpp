@@ -579,6 +579,8 @@ void E131Bridge::HandleDmx() {
 					m_State.IsChanged = true;
 				}
 			} else {
+				// The next frame, the previous frame must be out first
+				PresentPending();
 				lightset::Data::Set(m_pLightSet, nPortIndex);
 			}
 
@@ -28,6 +28,7 @@
 #include "e131bridge.h"
 
 #include "lightsetdata.h"
+#include "lightsetpresentation.h"
 #include "hardware.h"
 
 #include "debug.h"
@@ -51,6 +52,21 @@ void E131Bridge::HandleSynchronization() {
 
 	m_State.SynchronizationTime = m_nCurrentPacketMillis;
 
+	if (m_Presentation.IsEnabled()) {
+		const auto nArrival = m_Presentation.Now();
+		// The previous frame is not yet out
+		PresentPending();
+		m_Presentation.Latch(nArrival);
+		return;
+	}
+
+	SyncOutput();
+}
+
+/**
+ * The buffered data to the output, at the synchronization packet or at the presentation time
+ */
+void E131Bridge::SyncOutput() {
 	for (uint32_t nPortIndex = 0; nPortIndex < e131bridge::MAX_PORTS; nPortIndex++) {
 		if (m_Bridge.Port[nPortIndex].direction == lightset::PortDir::OUTPUT) {
 			m_pLightSet->Sync(nPortIndex);
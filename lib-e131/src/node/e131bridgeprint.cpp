@@ -77,4 +77,8 @@ void E131Bridge::Print() {
 	if (m_State.bDisableSynchronize) {
 		printf(" Synchronize is disabled\n");
 	}
+
+	if (m_Presentation.IsEnabled()) {
+		m_Presentation.Print();
+	}
 }
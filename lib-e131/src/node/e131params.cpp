@@ -45,6 +45,7 @@
 
 #include "lightset.h"
 #include "lightsetparamsconst.h"
+#include "lightsetpresentation.h"
 
 #include "debug.h"
 
@@ -84,6 +85,7 @@ E131Params::E131Params() {
 	}
 
 	m_Params.nFailSafe = static_cast<uint8_t>(lightset::FailSafe::HOLD);
+	m_Params.nSyncLatencyBudget = lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
 
 	DEBUG_PRINTF("s_nPortsMax=%u", s_nPortsMax);
 	DEBUG_EXIT
@@ -249,6 +251,33 @@ void E131Params::callbackFunction(const char *pLine) {
 		}
 		return;
 	}
+
+	nLength = 9;
+
+	if (Sscan::Char(pLine, LightSetParamsConst::SYNC_PRESENTATION, aValue, nLength) == Sscan::OK) {
+		aValue[nLength] = '\0';
+		const auto mode = lightset::presentation::get_mode(aValue);
+
+		if (mode == lightset::presentation::Mode::IMMEDIATE) {
+			m_Params.nSetList &= ~Mask::SYNC_PRESENTATION;
+		} else {
+			m_Params.nSetList |= Mask::SYNC_PRESENTATION;
+		}
+
+		m_Params.nSyncPresentation = static_cast<uint8_t>(mode);
+		return;
+	}
+
+	if (Sscan::Uint16(pLine, LightSetParamsConst::SYNC_LATENCY_BUDGET, value16) == Sscan::OK) {
+		if ((value16 != 0) && (value16 != lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS)) {
+			m_Params.nSetList |= Mask::SYNC_LATENCY_BUDGET;
+			m_Params.nSyncLatencyBudget = value16;
+		} else {
+			m_Params.nSetList &= ~Mask::SYNC_LATENCY_BUDGET;
+			m_Params.nSyncLatencyBudget = lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
+		}
+		return;
+	}
 }
 
 void E131Params::Builder(const struct Params *pParams, char *pBuffer, uint32_t nLength, uint32_t& nSize) {
@@ -300,6 +329,13 @@ void E131Params::Builder(const struct Params *pParams, char *pBuffer, uint32_t n
 	builder.AddComment("#");
 	builder.Add(LightSetParamsConst::DISABLE_MERGE_TIMEOUT, isMaskSet(Mask::DISABLE_MERGE_TIMEOUT));
 
+	if (!isMaskSet(Mask::SYNC_LATENCY_BUDGET)) {
+		m_Params.nSyncLatencyBudget = lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
+	}
+
+	builder.Add(LightSetParamsConst::SYNC_PRESENTATION, lightset::presentation::get_mode(static_cast<lightset::presentation::Mode>(m_Params.nSyncPresentation)), isMaskSet(Mask::SYNC_PRESENTATION));
+	builder.Add(LightSetParamsConst::SYNC_LATENCY_BUDGET, m_Params.nSyncLatencyBudget, isMaskSet(Mask::SYNC_LATENCY_BUDGET));
+
 	nSize = builder.GetSize();
 
 	DEBUG_PRINTF("nSize=%d", nSize);
@@ -348,6 +384,11 @@ void E131Params::Set() {
 	if (isMaskSet(Mask::DISABLE_MERGE_TIMEOUT)) {
 		p->SetDisableMergeTimeout(true);
 	}
+
+	if (isMaskSet(Mask::SYNC_PRESENTATION)) {
+		const auto nLatencyBudget = isMaskSet(Mask::SYNC_LATENCY_BUDGET) ? m_Params.nSyncLatencyBudget : lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS;
+		p->SetPresentation(static_cast<lightset::presentation::Mode>(m_Params.nSyncPresentation), nLatencyBudget);
+	}
 }
 
 void E131Params::staticCallbackFunction(void *p, const char *s) {
@@ -393,4 +434,12 @@ void E131Params::Dump() {
 	if (isMaskSet(e131params::Mask::DISABLE_MERGE_TIMEOUT)) {
 		printf(" %s=1 [Yes]\n", LightSetParamsConst::DISABLE_MERGE_TIMEOUT);
 	}
+
+	if (isMaskSet(e131params::Mask::SYNC_PRESENTATION)) {
+		printf(" %s=%u [%s]\n", LightSetParamsConst::SYNC_PRESENTATION, m_Params.nSyncPresentation, lightset::presentation::get_mode(static_cast<lightset::presentation::Mode>(m_Params.nSyncPresentation)));
+	}
+
+	if (isMaskSet(e131params::Mask::SYNC_LATENCY_BUDGET)) {
+		printf(" %s=%u\n", LightSetParamsConst::SYNC_LATENCY_BUDGET, m_Params.nSyncLatencyBudget);
+	}
 }
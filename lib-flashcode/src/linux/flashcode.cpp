@@ -0,0 +1,220 @@
+/**
+ * @file flashcode.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Simulated SPI flash, stored in the file flashcode.bin
+ * The timing follows the SPI flash driver used on the H3: the last sector erase or
+ * page program is not waited for, the next command waits until the flash is ready.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "flashcode.h"
+
+#include "debug.h"
+
+namespace flashcode {
+static constexpr char FILE_NAME[] = "flashcode.bin";
+static constexpr uint32_t FLASH_SIZE = 0x200000;	///< 2M, W25Q16
+static constexpr uint32_t SECTOR_SIZE = 4096;
+static constexpr uint32_t PAGE_SIZE = 256;
+
+namespace timing {
+// Winbond W25Q16JV typical values
+static constexpr uint32_t SECTOR_ERASE_MICROS = 45000;
+static constexpr uint32_t PAGE_PROGRAM_MICROS = 400;
+static constexpr uint32_t SPI_CLOCK_MHZ = 50;
+}  // namespace timing
+
+static uint8_t s_Flash[FLASH_SIZE];
+static FILE *s_pFile;
+static uint64_t s_nReadyMicros;
+}  // namespace flashcode
+
+using namespace flashcode;
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+static void wait_ready() {
+	const auto nNow = micros();
+
+	if (nNow < s_nReadyMicros) {
+		usleep(static_cast<useconds_t>(s_nReadyMicros - nNow));
+	}
+}
+
+static void spi_transfer(const uint32_t nBytes) {
+	usleep((nBytes * 8U) / timing::SPI_CLOCK_MHZ);
+}
+
+static bool store(const uint32_t nOffset, const uint32_t nLength) {
+	if (s_pFile == nullptr) {
+		return true;
+	}
+
+	if (fseek(s_pFile, static_cast<long>(nOffset), SEEK_SET) != 0) {
+		perror("fseek");
+		return false;
+	}
+
+	if (fwrite(&s_Flash[nOffset], 1, nLength, s_pFile) != nLength) {
+		perror("fwrite");
+		return false;
+	}
+
+	return (fflush(s_pFile) == 0);
+}
+
+FlashCode *FlashCode::s_pThis;
+
+FlashCode::FlashCode() {
+	DEBUG_ENTRY
+	assert(s_pThis == nullptr);
+	s_pThis = this;
+
+	memset(s_Flash, 0xFF, sizeof(s_Flash));
+
+	if ((s_pFile = fopen(FILE_NAME, "r+")) != nullptr) {
+		static_cast<void>(fread(s_Flash, 1, sizeof(s_Flash), s_pFile));
+	} else if ((s_pFile = fopen(FILE_NAME, "w+")) != nullptr) {
+		store(0, sizeof(s_Flash));
+	} else {
+		perror("fopen");
+	}
+
+	printf("Detected %s with sector size %d total %d bytes\n", GetName(), static_cast<int>(GetSectorSize()), static_cast<int>(GetSize()));
+	m_IsDetected = true;
+
+	DEBUG_EXIT
+}
+
+FlashCode::~FlashCode() {
+	DEBUG_ENTRY
+
+	if (s_pFile != nullptr) {
+		fclose(s_pFile);
+		s_pFile = nullptr;
+	}
+
+	DEBUG_EXIT
+}
+
+const char *FlashCode::GetName() const {
+	return "W25Q16JV (simulated)";
+}
+
+uint32_t FlashCode::GetSize() const {
+	return FLASH_SIZE;
+}
+
+uint32_t FlashCode::GetSectorSize() const {
+	return SECTOR_SIZE;
+}
+
+bool FlashCode::Read(uint32_t nOffset, uint32_t nLength, uint8_t *pBuffer, flashcode::result& nResult) {
+	DEBUG_ENTRY
+
+	if ((nOffset + nLength) > FLASH_SIZE) {
+		nResult = result::ERROR;
+		DEBUG_EXIT
+		return true;
+	}
+
+	wait_ready();
+	spi_transfer(nLength);
+
+	memcpy(pBuffer, &s_Flash[nOffset], nLength);
+	nResult = result::OK;
+
+	DEBUG_EXIT
+	return true;
+}
+
+bool FlashCode::Erase(uint32_t nOffset, uint32_t nLength, flashcode::result& nResult) {
+	DEBUG_ENTRY
+
+	if (((nOffset % SECTOR_SIZE) != 0) || ((nLength % SECTOR_SIZE) != 0) || ((nOffset + nLength) > FLASH_SIZE)) {
+		nResult = result::ERROR;
+		DEBUG_EXIT
+		return true;
+	}
+
+	wait_ready();
+
+	memset(&s_Flash[nOffset], 0xFF, nLength);
+	nResult = store(nOffset, nLength) ? result::OK : result::ERROR;
+
+	while (nLength != 0) {
+		wait_ready();
+		s_nReadyMicros = micros() + timing::SECTOR_ERASE_MICROS;
+		nLength -= SECTOR_SIZE;
+	}
+
+	DEBUG_EXIT
+	return true;
+}
+
+bool FlashCode::Write(uint32_t nOffset, uint32_t nLength, const uint8_t *pBuffer, flashcode::result& nResult) {
+	DEBUG_ENTRY
+
+	if ((nOffset + nLength) > FLASH_SIZE) {
+		nResult = result::ERROR;
+		DEBUG_EXIT
+		return true;
+	}
+
+	wait_ready();
+
+	// Programming can only clear bits
+	for (uint32_t i = 0; i < nLength; i++) {
+		s_Flash[nOffset + i] &= pBuffer[i];
+	}
+
+	nResult = store(nOffset, nLength) ? result::OK : result::ERROR;
+
+	while (nLength != 0) {
+		const auto nChunkLength = std::min(nLength, PAGE_SIZE - (nOffset % PAGE_SIZE));
+
+		wait_ready();
+		spi_transfer(nChunkLength);
+		s_nReadyMicros = micros() + timing::PAGE_PROGRAM_MICROS;
+
+		nOffset += nChunkLength;
+		nLength -= nChunkLength;
+	}
+
+	DEBUG_EXIT
+	return true;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file install.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Installs a file into the simulated SPI flash (flashcode.bin) and reports the time taken.
+ * Run it twice with the same file: the second run only reads the flash.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+
+#include "hardware.h"
+#include "display.h"
+#include "flashcode.h"
+#include "flashcodeinstall.h"
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <file> [offset]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const auto nOffset = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : static_cast<uint32_t>(OFFSET_UIMAGE);
+
+	Hardware hw;
+	Display display;
+	FlashCode flashCode;
+	FlashCodeInstall flashCodeInstall;
+
+	const auto nStart = micros();
+
+	flashCodeInstall.Process(argv[1], nOffset);
+
+	printf("%s installed at 0x%.6x in %u ms\n", argv[1], static_cast<unsigned>(nOffset), static_cast<unsigned>((micros() - nStart) / 1000U));
+
+	return EXIT_SUCCESS;
+}
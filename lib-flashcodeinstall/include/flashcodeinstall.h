@@ -29,7 +29,8 @@
 #include <cstdint>
 #include <cstdio>
 
-#if defined (H3)
+#if defined (H3) || defined (__linux__)
+// The Linux simulated FlashCode uses the H3 layout
 // nuc-i5:~/uboot-spi/u-boot$ grep CONFIG_BOOTCOMMAND include/configs/sunxi-common.h
 // #define CONFIG_BOOTCOMMAND "sf probe; sf read 48000000 180000 22000; bootm 48000000"
 # define FIRMWARE_MAX_SIZE	0x22000			// 136K
@@ -96,6 +97,11 @@ public:
 
 	bool WriteFirmware(const uint8_t *pBuffer, uint32_t nSize);
 
+	/**
+	 * Installs the file at nOffset. Only the sectors with a different CRC32 are erased and programmed.
+	 */
+	void Process(const char *pFileName, uint32_t nOffset);
+
 	static FlashCodeInstall* Get() {
 		return s_pThis;
 	}
@@ -103,15 +109,13 @@ public:
 private:
 	bool Open(const char *pFileName);
 	void Close();
-	bool BuffersCompare(uint32_t nSize);
-	bool Diff(uint32_t nOffset);
+	bool FlashCrc32(uint32_t nOffset, uint32_t nSize, uint32_t& nCrc32);
 	void Write(uint32_t nOffset);
-	void Process(const char *pFileName, uint32_t nOffset);
 
 private:
 	uint32_t m_nEraseSize { 0 };
 	uint32_t m_nFlashSize { 0 };
-	uint8_t *m_pFileBuffer { nullptr };
+	uint8_t *m_pFileBuffer { nullptr };		///< Double buffered, 2 x m_nEraseSize
 	uint8_t *m_pFlashBuffer { nullptr };
 	FILE *m_pFile { nullptr };
 
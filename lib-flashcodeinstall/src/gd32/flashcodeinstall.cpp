@@ -77,14 +77,7 @@ void FlashCodeInstall::Close() {
 	DEBUG_EXIT
 }
 
-bool FlashCodeInstall::BuffersCompare(__attribute__((unused)) uint32_t nSize) {
-	DEBUG_ENTRY
-	assert(0);
-	DEBUG_EXIT
-	return false;
-}
-
-bool FlashCodeInstall::Diff(__attribute__((unused)) uint32_t nOffset) {
+bool FlashCodeInstall::FlashCrc32(__attribute__((unused)) uint32_t nOffset, __attribute__((unused)) uint32_t nSize, __attribute__((unused)) uint32_t& nCrc32) {
 	DEBUG_ENTRY
 	assert(0);
 	DEBUG_EXIT
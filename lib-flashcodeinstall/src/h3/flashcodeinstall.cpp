@@ -36,7 +36,7 @@
 
 #include "debug.h"
 
-#define COMPARE_BYTES		1024
+#define READ_BYTES			1024
 
 #define FLASH_SIZE_MINIMUM	0x200000
 
@@ -48,6 +48,39 @@ constexpr char aCheckDifference[] = "Check difference";
 constexpr char aNoDifference[] = "No difference";
 constexpr char aDone[] = "Done";
 
+namespace crc32 {
+static constexpr uint32_t POLYNOMIAL = 0xEDB88320;	///< IEEE 802.3, reflected
+
+struct Table {
+	constexpr Table() : table() {
+		for (uint32_t i = 0; i < 256; i++) {
+			auto c = i;
+			for (uint32_t j = 0; j < 8; j++) {
+				c = (c & 1) ? (POLYNOMIAL ^ (c >> 1)) : (c >> 1);
+			}
+			table[i] = c;
+		}
+	}
+
+	uint32_t table[256];
+};
+
+static constexpr Table s_Table;
+
+/**
+ * Running CRC32, start with nCrc32 = 0
+ */
+static uint32_t update(uint32_t nCrc32, const uint8_t *pData, uint32_t nLength) {
+	nCrc32 = ~nCrc32;
+
+	while (nLength-- != 0) {
+		nCrc32 = s_Table.table[(nCrc32 ^ *pData++) & 0xFF] ^ (nCrc32 >> 8);
+	}
+
+	return ~nCrc32;
+}
+}  // namespace crc32
+
 FlashCodeInstall *FlashCodeInstall::s_pThis;
 
 FlashCodeInstall::FlashCodeInstall() {
@@ -64,6 +97,11 @@ FlashCodeInstall::FlashCodeInstall() {
 	} else {
 		m_nFlashSize = FlashCode::GetSize();
 		Display::Get()->Write(1, FlashCode::GetName());
+
+		if (m_nFlashSize >= FLASH_SIZE_MINIMUM) {
+			m_bHaveFlashChip = true;
+			m_nEraseSize = FlashCode::GetSectorSize();
+		}
 	}
 
 	if (Hardware::Get()->GetBootDevice() == hardware::BootDevice::MMC0) {
@@ -72,24 +110,12 @@ FlashCodeInstall::FlashCodeInstall() {
 		FlashCodeInstallParams params;
 
 		if (params.Load()) {
-			if (m_nFlashSize >= FLASH_SIZE_MINIMUM) {
-
-				m_bHaveFlashChip = true;
-				m_nEraseSize = FlashCode::GetSectorSize();
-
-				m_pFileBuffer = new uint8_t[m_nEraseSize];
-				assert(m_pFileBuffer != nullptr);
-
-				m_pFlashBuffer = new uint8_t[m_nEraseSize];
-				assert(m_pFlashBuffer != nullptr);
-
-				if (params.GetInstalluboot()) {
-					Process(aFileUbootSpi, OFFSET_UBOOT_SPI);
-				}
+			if (params.GetInstalluboot()) {
+				Process(aFileUbootSpi, OFFSET_UBOOT_SPI);
+			}
 
-				if (params.GetInstalluImage()) {
-					Process(aFileuImage, OFFSET_UIMAGE);
-				}
+			if (params.GetInstalluImage()) {
+				Process(aFileuImage, OFFSET_UIMAGE);
 			}
 		}
 	}
@@ -112,18 +138,23 @@ FlashCodeInstall::~FlashCodeInstall() {
 }
 
 void FlashCodeInstall::Process(const char *pFileName, uint32_t nOffset) {
+	if (!m_bHaveFlashChip) {
+		return;
+	}
+
+	if (m_pFileBuffer == nullptr) {
+		m_pFileBuffer = new uint8_t[2 * m_nEraseSize];
+		assert(m_pFileBuffer != nullptr);
+
+		m_pFlashBuffer = new uint8_t[READ_BYTES];
+		assert(m_pFlashBuffer != nullptr);
+	}
+
 	if (Open(pFileName)) {
 		Display::Get()->TextStatus(aCheckDifference, Display7SegmentMessage::INFO_SPI_CHECK);
 		puts(aCheckDifference);
 
-		if (Diff(nOffset)) {
-			Display::Get()->TextStatus(aWriting, Display7SegmentMessage::INFO_SPI_WRITING);
-			puts(aWriting);
-			Write(nOffset);
-		} else {
-			Display::Get()->TextStatus(aNoDifference, Display7SegmentMessage::INFO_SPI_NODIFF);
-			puts(aNoDifference);
-		}
+		Write(nOffset);
 		Close();
 	}
 }
@@ -162,74 +193,42 @@ void FlashCodeInstall::Close() {
 	DEBUG_EXIT
 }
 
-bool FlashCodeInstall::BuffersCompare(uint32_t nSize) {
+/**
+ * The flash contents are read in READ_BYTES chunks and added to the running nCrc32.
+ */
+bool FlashCodeInstall::FlashCrc32(uint32_t nOffset, uint32_t nSize, uint32_t& nCrc32) {
 	DEBUG1_ENTRY
 
-	assert(nSize <= m_nEraseSize);
+	assert(m_pFlashBuffer != nullptr);
 
-	const uint32_t *pSrc32 = reinterpret_cast<uint32_t*>(m_pFileBuffer);
-	assert((reinterpret_cast<uint32_t>(pSrc32) & 0x3) == 0);
+	while (nSize != 0) {
+		const auto nLength = nSize < READ_BYTES ? nSize : READ_BYTES;
 
-	const uint32_t *pDst32 = reinterpret_cast<uint32_t*>(m_pFlashBuffer);
-	assert((reinterpret_cast<uint32_t>(pDst32) & 0x3) == 0);
+		flashcode::result result;
+		FlashCode::Read(nOffset, nLength, m_pFlashBuffer, result);
 
-	while (nSize >= 4) {
-		if (*pSrc32++ != *pDst32++) {
+		if (flashcode::result::ERROR == result) {
 			DEBUG1_EXIT
 			return false;
 		}
-		nSize -= 4;
-	}
 
-	const auto *pSrc8 = reinterpret_cast<const uint8_t*>(pSrc32);
-	const auto *pDst8 = reinterpret_cast<const uint8_t*>(pDst32);
+		nCrc32 = crc32::update(nCrc32, m_pFlashBuffer, nLength);
 
-	while (nSize--) {
-		if (*pSrc8++ != *pDst8++) {
-			DEBUG1_EXIT
-			return false;
-		}
+		nOffset += nLength;
+		nSize -= nLength;
 	}
 
 	DEBUG1_EXIT
 	return true;
 }
 
-bool FlashCodeInstall::Diff(uint32_t nOffset) {
-	DEBUG_ENTRY
-
-	assert(m_pFile != nullptr);
-	assert(nOffset < m_nFlashSize);
-	assert(m_pFileBuffer != nullptr);
-	assert(m_pFlashBuffer != nullptr);
-
-	if (fseek(m_pFile, 0L, SEEK_SET) != 0) {
-		DEBUG_EXIT
-		return false;
-	}
-
-	if (fread(m_pFileBuffer, sizeof(uint8_t), COMPARE_BYTES,  m_pFile) != COMPARE_BYTES) {
-		DEBUG_EXIT
-		return false;
-	}
-
-	flashcode::result result;
-	FlashCode::Read(nOffset, COMPARE_BYTES, m_pFlashBuffer, result);
-
-	if (flashcode::result::ERROR == result) {
-		DEBUG_EXIT
-		return false;
-	}
-
-	if (!BuffersCompare(COMPARE_BYTES)) {
-		DEBUG_EXIT
-		return true;
-	}
-
-	DEBUG_EXIT
-	return false;
-}
-
+/**
+ * Sector by sector, the running CRC32 of the file is compared with the running CRC32 of the flash.
+ * As both start with the same value, a mismatch is a sector with different contents.
+ * Only those sectors are erased and programmed. The SPI flash driver does not wait for the
+ * completion of the last erase (page program), so the next sector is read from the file meanwhile.
+ * The programmed sector is verified with the CRC32 of the flash contents, no read-back buffer needed.
+ */
 void FlashCodeInstall::Write(uint32_t nOffset) {
 	DEBUG_ENTRY
 
@@ -237,64 +236,115 @@ void FlashCodeInstall::Write(uint32_t nOffset) {
 	assert(nOffset < m_nFlashSize);
 	assert(m_pFileBuffer != nullptr);
 
+	uint8_t *pBuffers[2] = { m_pFileBuffer, &m_pFileBuffer[m_nEraseSize] };
+	uint32_t nBufferIndex = 0;
+
 	auto bSuccess = false;
 
 	uint32_t n_Address = nOffset;
 	size_t nTotalBytes = 0;
+	size_t nBytesWritten = 0;
+	uint32_t nSectorsWritten = 0;
+	uint32_t nSectorsUnchanged = 0;
+	uint32_t nCrc32 = 0;
 
 	static_cast<void>(fseek(m_pFile, 0L, SEEK_SET));
 
+	auto nBytes = fread(pBuffers[nBufferIndex], sizeof(uint8_t), m_nEraseSize, m_pFile);
+
 	while (n_Address < m_nFlashSize) {
-		const auto nBytes = fread(m_pFileBuffer, sizeof(uint8_t), m_nEraseSize, m_pFile);
-		nTotalBytes += nBytes;
+		auto *pFileBuffer = pBuffers[nBufferIndex];
+		auto *pNextBuffer = pBuffers[nBufferIndex ^ 1];
+		const auto isLastSector = (nBytes != m_nEraseSize); // Error or end of file
+		size_t nNextBytes = 0;
 
-		flashcode::result result;
-		FlashCode::Erase(n_Address, m_nEraseSize, result);
+		const auto nCrc32File = crc32::update(nCrc32, pFileBuffer, static_cast<uint32_t>(nBytes));
+		auto nCrc32Flash = nCrc32;
 
-		if (flashcode::result::ERROR == result) {
-			puts("error: flash erase");
+		if (!FlashCrc32(n_Address, static_cast<uint32_t>(nBytes), nCrc32Flash)) {
+			puts("error: flash read");
 			break;
 		}
 
-		if (nBytes < m_nEraseSize) {
-			for (uint32_t i = nBytes; i < m_nEraseSize; i++) {
-				m_pFileBuffer[i] = 0xFF;
+		if (nCrc32Flash == nCrc32File) {
+			if (nBytes != 0) {
+				nSectorsUnchanged++;
 			}
-		}
 
-		FlashCode::Write(n_Address, m_nEraseSize, m_pFileBuffer, result);
+			if (!isLastSector) {
+				nNextBytes = fread(pNextBuffer, sizeof(uint8_t), m_nEraseSize, m_pFile);
+			}
+		} else {
+			if (nSectorsWritten == 0) {
+				Display::Get()->TextStatus(aWriting, Display7SegmentMessage::INFO_SPI_WRITING);
+				puts(aWriting);
+			}
 
-		if (flashcode::result::ERROR == result) {
-			puts("error: flash write");
-			break;
-		}
+			flashcode::result result;
+			FlashCode::Erase(n_Address, m_nEraseSize, result);
 
-		FlashCode::Read(n_Address, nBytes, m_pFlashBuffer, result);
+			if (flashcode::result::ERROR == result) {
+				puts("error: flash erase");
+				break;
+			}
 
-		if (flashcode::result::ERROR == result) {
-			puts("error: flash read");
-			break;
-		}
+			if (!isLastSector) {
+				nNextBytes = fread(pNextBuffer, sizeof(uint8_t), m_nEraseSize, m_pFile);
+			}
 
-		if (!BuffersCompare(nBytes)) {
-			puts("error: flash verify");
-			break;
+			for (auto i = nBytes; i < m_nEraseSize; i++) {
+				pFileBuffer[i] = 0xFF;
+			}
+
+			FlashCode::Write(n_Address, m_nEraseSize, pFileBuffer, result);
+
+			if (flashcode::result::ERROR == result) {
+				puts("error: flash write");
+				break;
+			}
+
+			nCrc32Flash = nCrc32;
+
+			if (!FlashCrc32(n_Address, static_cast<uint32_t>(nBytes), nCrc32Flash)) {
+				puts("error: flash read");
+				break;
+			}
+
+			if (nCrc32Flash != nCrc32File) {
+				puts("error: flash verify");
+				break;
+			}
+
+			nSectorsWritten++;
+			nBytesWritten += nBytes;
 		}
 
-		if (nBytes != m_nEraseSize) {
+		nCrc32 = nCrc32File;
+		nTotalBytes += nBytes;
+
+		if (isLastSector) {
 			if (ferror(m_pFile) == 0 ) {
 				bSuccess = true;
 			}
-			break; // Error or end of file
+			break;
 		}
 
+		nBytes = nNextBytes;
+		nBufferIndex ^= 1;
 		n_Address += m_nEraseSize;
 	}
 
 	if (bSuccess) {
-		Display::Get()->ClearEndOfLine();
-		Display::Get()->Printf(3, "%d", static_cast<int>(nTotalBytes));
-		printf("%d bytes written\n", static_cast<int>(nTotalBytes));
+		if (nSectorsWritten == 0) {
+			Display::Get()->TextStatus(aNoDifference, Display7SegmentMessage::INFO_SPI_NODIFF);
+			puts(aNoDifference);
+		} else {
+			Display::Get()->ClearEndOfLine();
+			Display::Get()->Printf(3, "%d", static_cast<int>(nBytesWritten));
+			printf("%d bytes written\n", static_cast<int>(nBytesWritten));
+		}
+
+		printf("%d bytes, sectors written %u, unchanged %u, CRC32 %08x\n", static_cast<int>(nTotalBytes), static_cast<unsigned>(nSectorsWritten), static_cast<unsigned>(nSectorsUnchanged), static_cast<unsigned>(nCrc32));
 	}
 
 	DEBUG_EXIT
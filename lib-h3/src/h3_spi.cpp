@@ -48,6 +48,8 @@ static constexpr uint32_t ALT_FUNCTION_MISO	= (EXT_SPI_NUMBER == 0 ? static_cast
 
 static bool s_ws28xx_mode = false;
 static uint32_t s_current_speed_hz = 0; // This forces an update
+static uint8_t s_current_mode = 0xFF;		// This forces an update
+static uint8_t s_current_chip_select = 0xFF;	// This forces an update
 
 struct spi_status {
 	bool		transfer_active;
@@ -286,6 +288,9 @@ void __attribute__((cold)) h3_spi_begin(void) {
 #endif
 
 	// Defaults
+	s_current_mode = 0xFF;
+	s_current_chip_select = 0xFF;
+
 	h3_spi_setBitOrder(H3_SPI_BIT_ORDER_MSBFIRST);
 	h3_spi_setDataMode(H3_SPI_MODE0);
 	h3_spi_chipSelect(H3_SPI_CS0);
@@ -351,7 +356,16 @@ void h3_spi_setBitOrder(h3_spi_bit_order_t bit_order) {
 	EXT_SPI->TC = value;
 }
 
+/*
+ * A shared bus is configured before each transfer, only a change is written.
+ */
 void h3_spi_setDataMode(uint8_t mode) {
+	if (__builtin_expect((s_current_mode == mode), 1)) {
+		return;
+	}
+
+	s_current_mode = mode;
+
 	uint32_t value = EXT_SPI->TC;
 	value &= static_cast<uint32_t>(~TC_CPHA);
 	value &= static_cast<uint32_t>(~TC_CPOL);
@@ -360,6 +374,12 @@ void h3_spi_setDataMode(uint8_t mode) {
 }
 
 void h3_spi_chipSelect(uint8_t chip_select) {
+	if (__builtin_expect((s_current_chip_select == chip_select), 1)) {
+		return;
+	}
+
+	s_current_chip_select = chip_select;
+
 	uint32_t value = EXT_SPI->TC;
 
 	if (chip_select < H3_SPI_CS_NONE) {
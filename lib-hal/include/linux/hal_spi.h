@@ -49,6 +49,20 @@
 # else
 #  include <stdint.h>
 # endif
+# if defined(LINUX_HAVE_SPI)
+  void spi_begin();
+  void spi_chipSelect(uint8_t);
+  void spi_setDataMode(uint8_t);
+  void spi_set_speed_hz(uint32_t);
+  void spi_write(uint16_t);
+  void spi_transfern(const char *, uint32_t);
+  void spi_writenb(const char *, uint32_t);
+  void spi_dma_begin();
+  void spi_dma_set_speed_hz(uint32_t);
+  const uint8_t *spi_dma_tx_prepare(uint32_t *);
+  void spi_dma_tx_start(const uint8_t *, uint32_t);
+  bool spi_dma_tx_is_active();
+# else
   inline static void spi_begin() {}
   inline static void spi_chipSelect(__attribute__((unused)) uint8_t _q) {}
   inline static void spi_setDataMode(__attribute__((unused)) uint8_t _q) {}
@@ -56,6 +70,7 @@
   inline static void spi_write(__attribute__((unused)) uint16_t _q) {}
   inline static void spi_transfern(__attribute__((unused)) const char *_p, __attribute__((unused)) uint32_t _q) {}
   inline static void spi_writenb(__attribute__((unused)) const char *_p, __attribute__((unused)) uint32_t _q) {}
+# endif
 # ifdef __cplusplus
  }
 # endif
@@ -0,0 +1,248 @@
+/**
+ * @file chain.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * LightSetChain with synthetic LightSet entries.
+ * - Verify: the output of each entry after each frame, also with port routing.
+ * - Benchmark: ns per frame, the chain against calling each entry with the universe.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "lightsetchain.h"
+
+/*
+ * As the PWM/servo outputs: the footprint is compared with the previous data
+ */
+class Element final: public LightSet {
+public:
+	Element(uint16_t nDmxStartAddress, uint16_t nDmxFootprint) : m_nDmxStartAddress(nDmxStartAddress), m_nDmxFootprint(nDmxFootprint) {
+		memset(m_Previous, 0, sizeof(m_Previous));
+		memset(m_Output, 0, sizeof(m_Output));
+	}
+
+	void Start([[maybe_unused]] const uint32_t nPortIndex) override {}
+	void Stop([[maybe_unused]] const uint32_t nPortIndex) override {}
+
+	void SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t *pData, uint32_t nLength, [[maybe_unused]] const bool doUpdate) override {
+		m_nCalls++;
+
+		for (uint32_t i = 0; i < m_nDmxFootprint; i++) {
+			const auto nSlot = m_nDmxStartAddress - 1U + i;
+
+			if (nSlot >= nLength) {
+				break;
+			}
+
+			if (pData[nSlot] != m_Previous[i]) {
+				m_Previous[i] = pData[nSlot];
+				m_Output[i] = pData[nSlot];
+			}
+		}
+	}
+
+	void Sync([[maybe_unused]] const uint32_t nPortIndex) override {}
+	void Sync([[maybe_unused]] const bool doForce) override {}
+
+	bool SetDmxStartAddress(uint16_t nDmxStartAddress) override {
+		m_nDmxStartAddress = nDmxStartAddress;
+		return true;
+	}
+
+	uint16_t GetDmxStartAddress() override {
+		return m_nDmxStartAddress;
+	}
+
+	uint16_t GetDmxFootprint() override {
+		return m_nDmxFootprint;
+	}
+
+	bool IsEqual(const uint8_t *pData) const {
+		return memcmp(m_Output, &pData[m_nDmxStartAddress - 1], m_nDmxFootprint) == 0;
+	}
+
+	uint32_t GetCalls() const {
+		return m_nCalls;
+	}
+
+private:
+	uint16_t m_nDmxStartAddress;
+	uint16_t m_nDmxFootprint;
+	uint32_t m_nCalls { 0 };
+	uint8_t m_Previous[lightset::dmx::UNIVERSE_SIZE];
+	uint8_t m_Output[lightset::dmx::UNIVERSE_SIZE];
+};
+
+static constexpr uint32_t ELEMENTS = 8;
+static constexpr uint16_t FOOTPRINT = 64;
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nFrame) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s frame %u\n", pTest, nFrame);
+		}
+	}
+}
+
+template<typename F>
+static double bench(F f, uint32_t nCount) {
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		f(i);
+	}
+
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) / nCount;
+}
+
+int main(int argc, char **argv) {
+	const uint32_t nFrames = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+
+	std::mt19937 rng(20240601);
+	static uint8_t data[2][lightset::dmx::UNIVERSE_SIZE];
+
+	/*
+	 * Verify, port 0: the odd elements. Port 1: the even elements.
+	 */
+
+	Element *pElements[ELEMENTS];
+	LightSetChain chain;
+
+	for (uint32_t i = 0; i < ELEMENTS; i++) {
+		pElements[i] = new Element(static_cast<uint16_t>(1 + i * FOOTPRINT), FOOTPRINT);
+		chain.Add(pElements[i], static_cast<int>(i), ((i & 1) == 0) ? 0x2U : 0x1U);
+	}
+
+	uint32_t nCallsExpected = 0;
+
+	for (uint32_t nFrame = 0; nFrame < nFrames; nFrame++) {
+		const auto nPortIndex = nFrame & 1;
+		auto *pData = data[nPortIndex];
+
+		// 0 to 3 random slots, sometimes a complete universe
+		const auto nChanges = ((rng() % 64) == 0) ? lightset::dmx::UNIVERSE_SIZE : rng() % 4;
+		bool isChanged[ELEMENTS] = {};
+
+		for (uint32_t i = 0; i < nChanges; i++) {
+			const auto nSlot = (nChanges == lightset::dmx::UNIVERSE_SIZE) ? i : rng() % lightset::dmx::UNIVERSE_SIZE;
+			const auto nValue = static_cast<uint8_t>(rng());
+
+			if (pData[nSlot] != nValue) {
+				pData[nSlot] = nValue;
+				isChanged[nSlot / FOOTPRINT] = true;
+			}
+		}
+
+		uint32_t nCallsBefore = 0;
+		for (uint32_t i = 0; i < ELEMENTS; i++) {
+			nCallsBefore += pElements[i]->GetCalls();
+		}
+
+		chain.SetData(nPortIndex, pData, lightset::dmx::UNIVERSE_SIZE);
+
+		uint32_t nCalls = 0;
+		for (uint32_t i = 0; i < ELEMENTS; i++) {
+			nCalls += pElements[i]->GetCalls();
+		}
+
+		// The first frame of a port goes to all entries of that port
+		uint32_t nCallsFrame = 0;
+		for (uint32_t i = 0; i < ELEMENTS; i++) {
+			if ((i & 1) != nPortIndex) {
+				nCallsFrame += (nFrame < 2 || isChanged[i]) ? 1 : 0;
+			}
+		}
+
+		nCallsExpected += nCallsFrame;
+		check((nCalls - nCallsBefore) == nCallsFrame, "calls", nFrame);
+
+		for (uint32_t i = 0; i < ELEMENTS; i++) {
+			check(pElements[i]->IsEqual(data[1 - (i & 1)]), "port routing", nFrame);
+		}
+	}
+
+	printf("Verify: %u frames, %u calls of %u\n", nFrames, nCallsExpected, nFrames * ELEMENTS / 2);
+
+	// A new DMX start address for the chain, then the slices are moved
+	chain.SetDmxStartAddress(11);
+
+	auto *pData = data[0];
+	for (uint32_t i = 0; i < lightset::dmx::UNIVERSE_SIZE; i++) {
+		pData[i] = static_cast<uint8_t>(rng());
+	}
+
+	chain.SetData(0, pData, lightset::dmx::UNIVERSE_SIZE);
+	pData[10 + FOOTPRINT * 3] ^= 0xFF;
+	chain.SetData(0, pData, lightset::dmx::UNIVERSE_SIZE);
+
+	for (uint32_t i = 1; i < ELEMENTS - 1; i += 2) {
+		check(pElements[i]->IsEqual(pData), "DMX start address", i);
+	}
+
+	/*
+	 * Benchmark, port 0 with the odd elements
+	 */
+
+	puts("\nns per frame            chain      each entry");
+
+	const char *pTests[] = { "unchanged", "1 slot", "64 slots", "512 slots" };
+	const uint32_t nSlotsChanged[] = { 0, 1, FOOTPRINT, lightset::dmx::UNIVERSE_SIZE };
+
+	for (uint32_t nTest = 0; nTest < 4; nTest++) {
+		const auto nSlots = nSlotsChanged[nTest];
+
+		const auto fChain = bench([&](uint32_t n) {
+			for (uint32_t i = 0; i < nSlots; i++) {
+				pData[(i + n) % lightset::dmx::UNIVERSE_SIZE]++;
+			}
+			chain.SetData(0, pData, lightset::dmx::UNIVERSE_SIZE);
+		}, 200000);
+
+		const auto fEach = bench([&](uint32_t n) {
+			for (uint32_t i = 0; i < nSlots; i++) {
+				pData[(i + n) % lightset::dmx::UNIVERSE_SIZE]++;
+			}
+			for (uint32_t i = 1; i < ELEMENTS; i += 2) {
+				pElements[i]->SetData(0, pData, lightset::dmx::UNIVERSE_SIZE, true);
+			}
+		}, 200000);
+
+		printf("%-20s %9.1f  %10.1f   x%.1f\n", pTests[nTest], fChain, fEach, fEach / fChain);
+	}
+
+	for (uint32_t i = 0; i < ELEMENTS; i++) {
+		delete pElements[i];
+	}
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
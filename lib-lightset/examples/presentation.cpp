@@ -0,0 +1,223 @@
+/**
+ * @file presentation.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The presentation time of the synchronous output, nodes on a simulated clock.
+ * A controller sends a sync every PERIOD, every node has its own network delay
+ * (a few switch hops, a busy link), a local clock with offset and drift, and a
+ * busy main loop: mostly short iterations, sometimes a long one (pixel output,
+ * RDM, a flash write).
+ * - IMMEDIATE: the output is when the main loop picks up the sync.
+ * - LATENCY: the output is at the presentation time, on the local clock.
+ * - CLOCK: the nodes and the controller share a PTP clock with an error of a few
+ *   us per node, the controller sends the sync at a grid point of that clock.
+ * The skew is the spread of the output times over the nodes, per frame.
+ * The output is by the main loop: an iteration longer than SPIN_MICROS which
+ * covers the target is late in all modes, this is the 99% of the skew.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "lightsetpresentation.h"
+
+static constexpr uint32_t NODES = 8;
+static constexpr uint32_t FRAMES = 4000;
+static constexpr uint64_t PERIOD_NANOS = 24000000;	// 41.7 Hz, a multiple of the grid of the shared clock
+static constexpr uint32_t LATENCY_BUDGET_MICROS = 4000;
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nValue) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s %u\n", pTest, nValue);
+		}
+	}
+}
+
+static uint32_t s_nRandom = 20240601;
+
+static uint32_t xorshift() {
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return s_nRandom;
+}
+
+/*
+ * The simulated time of the current node, a clock read costs 1 us
+ */
+static uint64_t s_nNanos;
+static int64_t s_nDriftPpm;
+static uint32_t s_nOffsetMicros;
+
+static uint32_t local_micros() {
+	s_nNanos += 1000;
+	const auto nLocalNanos = static_cast<uint64_t>(static_cast<int64_t>(s_nNanos) + (static_cast<int64_t>(s_nNanos) / 1000000) * s_nDriftPpm);
+	return static_cast<uint32_t>(nLocalNanos / 1000) + s_nOffsetMicros;
+}
+
+/*
+ * The PTP time of the current node, the error is per node
+ */
+static int32_t s_nPtpErrorMicros;
+
+static uint32_t shared_micros() {
+	s_nNanos += 1000;
+	return static_cast<uint32_t>(static_cast<int64_t>(s_nNanos / 1000) + s_nPtpErrorMicros);
+}
+
+static uint64_t main_loop_iteration() {
+	const auto n = xorshift() % 1000;
+
+	if (n < 1) {
+		return 1000000 + (xorshift() % 2000000);	// 1-3 ms
+	}
+
+	if (n < 50) {
+		return 100000 + (xorshift() % 400000);	// 0.1-0.5 ms
+	}
+
+	return 10000 + (xorshift() % 90000);		// 10-100 us
+}
+
+/*
+ * The output times of one node, in the simulated time (ns)
+ */
+static void run_node(lightset::presentation::Mode mode, uint64_t *pOutput, LightSetPresentation& presentation) {
+	s_nNanos = 0;
+	s_nDriftPpm = static_cast<int64_t>(xorshift() % 101) - 50;
+	s_nOffsetMicros = xorshift();
+	s_nPtpErrorMicros = static_cast<int32_t>(xorshift() % 21) - 10;
+
+	const auto nBaseDelayNanos = 20000 + (xorshift() % 600000);
+
+	presentation.SetMode(mode, LATENCY_BUDGET_MICROS, (mode == lightset::presentation::Mode::CLOCK) ? shared_micros : local_micros);
+	presentation.ResetStatistics();
+
+	uint32_t nFrame = 0;
+	uint32_t nOutput = 0;
+	uint64_t nArrival = nBaseDelayNanos;
+
+	while (nOutput < FRAMES) {
+		if (presentation.IsDue()) {
+			pOutput[nOutput++] = s_nNanos;
+			presentation.Presented();
+		}
+
+		if ((nFrame < FRAMES) && (s_nNanos >= nArrival)) {
+			// The main loop picks up the sync
+			if (presentation.IsEnabled()) {
+				const auto nNow = presentation.Now();
+				if (presentation.IsPending()) {
+					pOutput[nOutput++] = s_nNanos;
+					presentation.Presented(true);
+				}
+				presentation.Latch(nNow);
+			} else {
+				pOutput[nOutput++] = s_nNanos;
+			}
+
+			nFrame++;
+
+			// Sometimes a sync waits in a switch queue
+			const auto nJitter = ((xorshift() % 50) == 0) ? 200000 + (xorshift() % 800000) : (xorshift() % 100000);
+			nArrival = nFrame * PERIOD_NANOS + nBaseDelayNanos + nJitter;
+		}
+
+		s_nNanos += main_loop_iteration();
+	}
+}
+
+struct Result {
+	uint32_t nMedian;
+	uint32_t nPercentile99;
+	uint32_t nMax;
+};
+
+static Result skew(lightset::presentation::Mode mode) {
+	static uint64_t s_Output[NODES][FRAMES];
+	static uint32_t s_Skew[FRAMES];
+	LightSetPresentation presentation;
+	lightset::presentation::Histogram histogram;
+	histogram.Reset();
+
+	for (uint32_t nNode = 0; nNode < NODES; nNode++) {
+		run_node(mode, s_Output[nNode], presentation);
+	}
+
+	for (uint32_t nFrame = 0; nFrame < FRAMES; nFrame++) {
+		auto nMin = s_Output[0][nFrame];
+		auto nMax = s_Output[0][nFrame];
+
+		for (uint32_t nNode = 1; nNode < NODES; nNode++) {
+			nMin = std::min(nMin, s_Output[nNode][nFrame]);
+			nMax = std::max(nMax, s_Output[nNode][nFrame]);
+		}
+
+		s_Skew[nFrame] = static_cast<uint32_t>((nMax - nMin) / 1000);
+
+		// The first frames are for the filter
+		if (nFrame >= 32) {
+			histogram.Add(s_Skew[nFrame]);
+		}
+	}
+
+	printf("Mode %s, %u nodes, %u frames\n", lightset::presentation::get_mode(mode), NODES, FRAMES);
+	histogram.Print("Skew");
+
+	if (presentation.IsEnabled()) {
+		presentation.Print();
+	}
+
+	std::sort(&s_Skew[32], &s_Skew[FRAMES]);
+	const auto nFrames = FRAMES - 32;
+
+	return Result { s_Skew[32 + nFrames / 2], s_Skew[32 + (nFrames * 99) / 100], s_Skew[FRAMES - 1] };
+}
+
+int main() {
+	const auto immediate = skew(lightset::presentation::Mode::IMMEDIATE);
+	const auto latency = skew(lightset::presentation::Mode::LATENCY);
+	const auto clock = skew(lightset::presentation::Mode::CLOCK);
+
+	printf("Skew (us)   median  99%%     max\n");
+	printf("immediate  %6u %6u %6u\n", immediate.nMedian, immediate.nPercentile99, immediate.nMax);
+	printf("latency    %6u %6u %6u\n", latency.nMedian, latency.nPercentile99, latency.nMax);
+	printf("clock      %6u %6u %6u\n", clock.nMedian, clock.nPercentile99, clock.nMax);
+
+	check(latency.nMedian < immediate.nMedian, "latency median", latency.nMedian);
+	check(latency.nPercentile99 < immediate.nPercentile99, "latency 99%", latency.nPercentile99);
+	// The network delay of the nodes is not in the output time
+	check(clock.nMedian * 2 < latency.nMedian, "clock median", clock.nMedian);
+	check(clock.nPercentile99 <= latency.nPercentile99, "clock 99%", clock.nPercentile99);
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
@@ -32,9 +32,15 @@
 
 #define LIGHTSET_TYPE_UNDEFINED -1
 
+#define LIGHTSET_CHAIN_MAX_PORTS	4
+#define LIGHTSET_CHAIN_PORTS_ALL	0xFFFFFFFFU
+
 struct TLightSetEntry {
 	LightSet *pLightSet;
 	int	nType;
+	uint32_t nPortMask;		///< Bit n set, the entry is on port n
+	uint16_t nSlotFirst;	///< The slice of the universe [nSlotFirst, nSlotLast)
+	uint16_t nSlotLast;
 };
 
 class LightSetChain final: public LightSet {
@@ -67,7 +73,11 @@ public: // RDM
 	bool GetSlotInfo(uint16_t nSlotOffset, lightset::SlotInfo &tSlotInfo) override;
 
 public:
-	bool Add(LightSet *, int nType = LIGHTSET_TYPE_UNDEFINED);
+	/**
+	 * The entry gets the data of the ports in nPortMask, and only when its slots are changed.
+	 * The changes are with the previous frame of the same port.
+	 */
+	bool Add(LightSet *, int nType = LIGHTSET_TYPE_UNDEFINED, uint32_t nPortMask = LIGHTSET_CHAIN_PORTS_ALL);
 	bool IsEmpty() const;
 	bool Exist(LightSet *);
 	bool Exist(LightSet *, int, bool DoIgnoreType = false);
@@ -80,9 +90,20 @@ public:
 	void Dump(uint8_t);
 	void Dump();
 
+private:
+	bool IsRouted(const uint32_t nEntry, const uint32_t nPortIndex) const {
+		if (nPortIndex >= 32) {
+			return true;
+		}
+		return (m_pTable[nEntry].nPortMask & (1U << nPortIndex)) != 0;
+	}
+	void UpdateSlices();
+
 private:
 	uint8_t m_nSize { 0 };
 	TLightSetEntry *m_pTable;
+	uint8_t *m_pData;					///< Previous data, for each port
+	uint32_t m_nLength[LIGHTSET_CHAIN_MAX_PORTS];
 	uint16_t m_nDmxStartAddress { lightset::dmx::ADDRESS_INVALID };
 	uint16_t m_nDmxFootprint { 0 };
 };
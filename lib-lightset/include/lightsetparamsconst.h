@@ -51,6 +51,9 @@ struct LightSetParamsConst {
 
 	static const char FAILSAFE[];
 
+	static const char SYNC_PRESENTATION[];
+	static const char SYNC_LATENCY_BUDGET[];
+
 #if defined (CONFIG_PIXELDMX_MAX_PORTS)
 	static const char START_UNI_PORT[CONFIG_PIXELDMX_MAX_PORTS][20];
 #endif
@@ -0,0 +1,217 @@
+/**
+ * @file lightsetpresentation.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIGHTSETPRESENTATION_H_
+#define LIGHTSETPRESENTATION_H_
+
+#include <cstdint>
+
+/**
+ * Presentation time for the synchronous output (ArtSync, E1.31 synchronization).
+ * The output of a frame is not at the reception of the sync, but at a target time:
+ * the arrival of the sync plus a latency budget. Then the time of a busy main loop
+ * between the arrival and the output does not show up as a skew between nodes.
+ * - The arrival is predicted with the period of the syncs, a sync which arrives earlier
+ *   pulls the prediction down, a later sync raises it slowly (minimum filter).
+ *   The period is not measured per sync, it follows the corrections of the prediction.
+ *   So the late pick up of a sync by the main loop is filtered out as well.
+ * - CLOCK: the time base is a clock shared by the nodes (e.g. PTP), in microseconds.
+ *   The controller sends the sync at a grid point of the shared clock, a multiple of the
+ *   latency budget. The target is the first grid point after the predicted arrival,
+ *   which is the same on every node, whatever its network delay.
+ * The output is by the main loop, within SPIN_MICROS of the target it waits for the target.
+ */
+namespace lightset {
+namespace presentation {
+enum class Mode {
+	IMMEDIATE, LATENCY, CLOCK
+};
+
+using Clock = uint32_t (*)();
+
+static constexpr uint32_t LATENCY_BUDGET_DEFAULT_MICROS = 2000;
+static constexpr uint32_t SPIN_MICROS = 200;
+static constexpr uint32_t LEAK_SHIFT = 4;		///< A later sync raises the prediction with 1/16
+static constexpr uint32_t PERIOD_SHIFT = 3;		///< The period follows 1/8 of the adjustments of the prediction
+static constexpr uint32_t PERIOD_FRACTION_BITS = 8;
+static constexpr uint32_t PERIOD_MIN_MICROS = 1000;
+static constexpr uint32_t PERIOD_MAX_MICROS = 1000000;
+static constexpr uint32_t BUCKETS = 16;
+
+/**
+ * Bucket 0 is 0 us, bucket n is [2^(n-1), 2^n) us, the last bucket is all above
+ */
+struct Histogram {
+	uint32_t nCount[BUCKETS];
+	uint32_t nMax;
+
+	void Reset() {
+		for (auto& n : nCount) {
+			n = 0;
+		}
+		nMax = 0;
+	}
+
+	void Add(const uint32_t nMicros) {
+		auto nBucket = (nMicros == 0) ? 0 : 32U - static_cast<uint32_t>(__builtin_clz(nMicros));
+
+		if (nBucket >= BUCKETS) {
+			nBucket = BUCKETS - 1;
+		}
+
+		nCount[nBucket]++;
+
+		if (nMicros > nMax) {
+			nMax = nMicros;
+		}
+	}
+
+	void Print(const char *pName) const;
+};
+
+const char *get_mode(const Mode mode);
+Mode get_mode(const char *pMode);
+
+/**
+ * The clock shared by the nodes for Mode::CLOCK, nullptr when there is none.
+ * The default has none, an application with a PTP client provides the PTP time in microseconds.
+ */
+Clock get_shared_clock();
+}  // namespace presentation
+}  // namespace lightset
+
+class LightSetPresentation {
+public:
+	LightSetPresentation() {
+		m_Latency.Reset();
+		m_Lateness.Reset();
+	}
+
+	void SetMode(const lightset::presentation::Mode mode, const uint32_t nLatencyBudgetMicros, const lightset::presentation::Clock pClock) {
+		m_Mode = mode;
+		// The budget is the grid of the shared clock
+		m_nLatencyBudgetMicros = ((mode == lightset::presentation::Mode::CLOCK) && (nLatencyBudgetMicros == 0)) ? lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS : nLatencyBudgetMicros;
+		m_pClock = pClock;
+		m_bValid = false;
+		m_bPending = false;
+	}
+
+	lightset::presentation::Mode GetMode() const {
+		return m_Mode;
+	}
+
+	bool IsEnabled() const {
+		return (m_Mode != lightset::presentation::Mode::IMMEDIATE) && (m_pClock != nullptr);
+	}
+
+	uint32_t GetLatencyBudget() const {
+		return m_nLatencyBudgetMicros;
+	}
+
+	uint32_t Now() const {
+		return m_pClock();
+	}
+
+	/**
+	 * A sync has arrived: the output is pending until the target time
+	 */
+	void Latch(const uint32_t nArrival);
+
+	bool IsPending() const {
+		return m_bPending;
+	}
+
+	/**
+	 * @return true when the pending output is due, then the caller does the output and calls Presented
+	 */
+	bool IsDue() const {
+		if (!m_bPending) {
+			return false;
+		}
+
+		auto nRemaining = static_cast<int32_t>(m_nTarget - m_pClock());
+
+		if (nRemaining > static_cast<int32_t>(lightset::presentation::SPIN_MICROS)) {
+			return false;
+		}
+
+		while (nRemaining > 0) {
+			nRemaining = static_cast<int32_t>(m_nTarget - m_pClock());
+		}
+
+		return true;
+	}
+
+	/**
+	 * @param isForced The output was before the target, for new data or a new sync
+	 */
+	void Presented(const bool isForced = false);
+
+	uint32_t GetTarget() const {
+		return m_nTarget;
+	}
+
+	uint32_t GetPeriod() const {
+		return m_nPeriod >> lightset::presentation::PERIOD_FRACTION_BITS;
+	}
+
+	const lightset::presentation::Histogram& GetLatency() const {
+		return m_Latency;
+	}
+
+	const lightset::presentation::Histogram& GetLateness() const {
+		return m_Lateness;
+	}
+
+	void ResetStatistics() {
+		m_Latency.Reset();
+		m_Lateness.Reset();
+		m_nPresented = 0;
+		m_nForced = 0;
+	}
+
+	void Print() const;
+
+private:
+	lightset::presentation::Mode m_Mode { lightset::presentation::Mode::IMMEDIATE };
+	lightset::presentation::Clock m_pClock { nullptr };
+	uint32_t m_nLatencyBudgetMicros { lightset::presentation::LATENCY_BUDGET_DEFAULT_MICROS };
+	// The arrival filter
+	uint32_t m_nPredicted { 0 };
+	uint32_t m_nPeriod { 0 };		///< 1/256 us
+	uint32_t m_nArrivalPrevious { 0 };
+	bool m_bValid { false };
+	// The pending output
+	uint32_t m_nArrival { 0 };
+	uint32_t m_nTarget { 0 };
+	bool m_bPending { false };
+	// Statistics
+	uint32_t m_nPresented { 0 };
+	uint32_t m_nForced { 0 };
+	lightset::presentation::Histogram m_Latency;	///< From the arrival to the output
+	lightset::presentation::Histogram m_Lateness;	///< From the target to the output
+};
+
+#endif /* LIGHTSETPRESENTATION_H_ */
@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 
 #include "lightsetchain.h"
@@ -36,6 +37,54 @@ using namespace lightset;
 
 #define LIGHTSET_CHAIN_MAX_ENTRIES	16
 
+static constexpr uint32_t LENGTH_INVALID = UINT32_MAX;
+
+/*
+ * 4 slots at a time, the universe is not aligned
+ */
+static uint32_t first_changed(const uint8_t *pData, const uint8_t *pPrevious, uint32_t nFirst, const uint32_t nEnd) {
+	while ((nFirst + 4) <= nEnd) {
+		uint32_t nData, nPrevious;
+		memcpy(&nData, &pData[nFirst], 4);
+		memcpy(&nPrevious, &pPrevious[nFirst], 4);
+
+		if (nData != nPrevious) {
+			break;
+		}
+
+		nFirst += 4;
+	}
+
+	while ((nFirst < nEnd) && (pData[nFirst] == pPrevious[nFirst])) {
+		nFirst++;
+	}
+
+	return nFirst;
+}
+
+/*
+ * There is a changed slot at nFirst
+ */
+static uint32_t last_changed(const uint8_t *pData, const uint8_t *pPrevious, const uint32_t nFirst, uint32_t nLast) {
+	while (nLast >= (nFirst + 4)) {
+		uint32_t nData, nPrevious;
+		memcpy(&nData, &pData[nLast - 4], 4);
+		memcpy(&nPrevious, &pPrevious[nLast - 4], 4);
+
+		if (nData != nPrevious) {
+			break;
+		}
+
+		nLast -= 4;
+	}
+
+	while (pData[nLast - 1] == pPrevious[nLast - 1]) {
+		nLast--;
+	}
+
+	return nLast;
+}
+
 LightSetChain::LightSetChain() { // Invalidate DMX Start Address and DMX Footprint
 	m_pTable = new TLightSetEntry[LIGHTSET_CHAIN_MAX_ENTRIES];
 	assert(m_pTable != nullptr);
@@ -43,38 +92,120 @@ LightSetChain::LightSetChain() { // Invalidate DMX Start Address and DMX Footpri
 	for (unsigned i = 0; i < LIGHTSET_CHAIN_MAX_ENTRIES ; i++) {
 		m_pTable[i].pLightSet = nullptr;
 		m_pTable[i].nType = LIGHTSET_TYPE_UNDEFINED;
+		m_pTable[i].nPortMask = LIGHTSET_CHAIN_PORTS_ALL;
+		m_pTable[i].nSlotFirst = 0;
+		m_pTable[i].nSlotLast = 0;
+	}
+
+	m_pData = new uint8_t[LIGHTSET_CHAIN_MAX_PORTS * dmx::UNIVERSE_SIZE];
+	assert(m_pData != nullptr);
+
+	for (uint32_t nPortIndex = 0; nPortIndex < LIGHTSET_CHAIN_MAX_PORTS; nPortIndex++) {
+		m_nLength[nPortIndex] = LENGTH_INVALID;
 	}
 }
 
 LightSetChain::~LightSetChain() {
+	delete[] m_pData;
+	m_pData = nullptr;
+
 	delete[] m_pTable;
 	m_pTable = nullptr;
 	m_nSize = 0;
 }
 
 void LightSetChain::Start(const uint32_t nPortIndex) {
+	// The first frame goes to all entries
+	if (nPortIndex < LIGHTSET_CHAIN_MAX_PORTS) {
+		m_nLength[nPortIndex] = LENGTH_INVALID;
+	}
+
 	for (uint32_t i = 0; i < m_nSize; i++) {
-		m_pTable[i].pLightSet->Start(nPortIndex);
+		if (IsRouted(i, nPortIndex)) {
+			m_pTable[i].pLightSet->Start(nPortIndex);
+		}
 	}
 }
 
 void LightSetChain::Stop(const uint32_t nPortIndex) {
 	for (uint32_t i = 0; i < m_nSize; i++) {
-		m_pTable[i].pLightSet->Stop(nPortIndex);
+		if (IsRouted(i, nPortIndex)) {
+			m_pTable[i].pLightSet->Stop(nPortIndex);
+		}
 	}
 }
 
+/*
+ * The universe is compared once with the previous data of the port,
+ * an entry is called only when its slice has a changed slot.
+ * The entries keep their interface: the complete universe, they do their own addressing.
+ */
 void LightSetChain::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLength, const bool doUpdate) {
 	assert(pData != nullptr);
 
+	if (__builtin_expect((nPortIndex >= LIGHTSET_CHAIN_MAX_PORTS), 0)) {
+		for (uint32_t i = 0; i < m_nSize; i++) {
+			if (IsRouted(i, nPortIndex)) {
+				m_pTable[i].pLightSet->SetData(nPortIndex, pData, nLength, doUpdate);
+			}
+		}
+		return;
+	}
+
+	auto *pPrevious = &m_pData[nPortIndex * dmx::UNIVERSE_SIZE];
+	const auto nEnd = std::min(static_cast<uint32_t>(m_nDmxStartAddress - 1U + m_nDmxFootprint), std::min(nLength, dmx::UNIVERSE_SIZE));
+	uint32_t nFirst;
+	uint32_t nLast;
+	bool isAll = false;
+
+	if (m_nLength[nPortIndex] != nLength) {
+		m_nLength[nPortIndex] = nLength;
+		nFirst = 0;
+		nLast = nEnd;
+		isAll = true;
+	} else {
+		nFirst = first_changed(pData, pPrevious, m_nDmxStartAddress - 1U, nEnd);
+
+		if (nFirst >= nEnd) {
+			return;
+		}
+
+		nLast = last_changed(pData, pPrevious, nFirst, nEnd);
+	}
+
 	for (uint32_t i = 0; i < m_nSize; i++) {
-		m_pTable[i].pLightSet->SetData(nPortIndex, pData, nLength, doUpdate);
+		const auto& entry = m_pTable[i];
+
+		if (!IsRouted(i, nPortIndex)) {
+			continue;
+		}
+
+		if (!isAll) {
+			if ((entry.nSlotLast <= nFirst) || (entry.nSlotFirst >= nLast)) {
+				continue;
+			}
+
+			// An entry in between the first and the last changed slot can be unchanged
+			if ((entry.nSlotFirst > nFirst) && (entry.nSlotLast < nLast)) {
+				if (first_changed(pData, pPrevious, entry.nSlotFirst, entry.nSlotLast) == entry.nSlotLast) {
+					continue;
+				}
+			}
+		}
+
+		entry.pLightSet->SetData(nPortIndex, pData, nLength, doUpdate);
+	}
+
+	if (nFirst < nLast) {
+		memcpy(&pPrevious[nFirst], &pData[nFirst], nLast - nFirst);
 	}
 }
 
 void LightSetChain::Sync(const uint32_t nPortIndex) {
 	for (uint32_t i = 0; i < m_nSize; i++) {
-		m_pTable[i].pLightSet->Sync(nPortIndex);
+		if (IsRouted(i, nPortIndex)) {
+			m_pTable[i].pLightSet->Sync(nPortIndex);
+		}
 	}
 }
 
@@ -119,6 +250,8 @@ bool LightSetChain::SetDmxStartAddress(uint16_t nDmxStartAddress) {
 
 	m_nDmxStartAddress = nDmxStartAddress;
 
+	UpdateSlices();
+
 	DEBUG_EXIT
 	return true;
 }
@@ -163,7 +296,22 @@ bool LightSetChain::GetSlotInfo(uint16_t nSlotOffset, SlotInfo &tSlotInfo) {
 	return false;
 }
 
-bool LightSetChain::Add(LightSet *pLightSet, int nType) {
+void LightSetChain::UpdateSlices() {
+	for (uint32_t i = 0; i < m_nSize; i++) {
+		auto& entry = m_pTable[i];
+		const auto nDmxStartAddress = entry.pLightSet->GetDmxStartAddress();
+
+		entry.nSlotFirst = static_cast<uint16_t>(std::min(static_cast<uint32_t>(nDmxStartAddress - 1U), dmx::UNIVERSE_SIZE));
+		entry.nSlotLast = static_cast<uint16_t>(std::min(static_cast<uint32_t>(nDmxStartAddress - 1U + entry.pLightSet->GetDmxFootprint()), dmx::UNIVERSE_SIZE));
+	}
+
+	// The slices are changed, the next frame goes to all entries
+	for (uint32_t nPortIndex = 0; nPortIndex < LIGHTSET_CHAIN_MAX_PORTS; nPortIndex++) {
+		m_nLength[nPortIndex] = LENGTH_INVALID;
+	}
+}
+
+bool LightSetChain::Add(LightSet *pLightSet, int nType, uint32_t nPortMask) {
 	DEBUG_ENTRY
 
 	if (m_nSize == LIGHTSET_CHAIN_MAX_ENTRIES) {
@@ -184,11 +332,14 @@ bool LightSetChain::Add(LightSet *pLightSet, int nType) {
 
 				m_pTable[0].pLightSet = pLightSet;
 				m_pTable[0].nType = nType;
+				m_pTable[0].nPortMask = nPortMask;
 				m_nSize = 1;
 
 				m_nDmxStartAddress = pLightSet->GetDmxStartAddress();
 				m_nDmxFootprint = pLightSet->GetDmxFootprint();
 
+				UpdateSlices();
+
 #ifndef NDEBUG
 				printf("m_nDmxStartAddress=%d, m_nDmxFootprint=%d\n", m_nDmxStartAddress, m_nDmxFootprint);
 #endif
@@ -198,6 +349,7 @@ bool LightSetChain::Add(LightSet *pLightSet, int nType) {
 
 			m_pTable[m_nSize].pLightSet = pLightSet;
 			m_pTable[m_nSize].nType = nType;
+			m_pTable[m_nSize].nPortMask = nPortMask;
 			m_nSize++;
 
 #ifndef NDEBUG
@@ -209,6 +361,8 @@ bool LightSetChain::Add(LightSet *pLightSet, int nType) {
 			const auto nDmxChannelLast = static_cast<uint16_t>(pLightSet->GetDmxStartAddress() + pLightSet->GetDmxFootprint());
 			m_nDmxFootprint = static_cast<uint16_t>(std::max(nDmxChannelLastCurrent, nDmxChannelLast) - m_nDmxStartAddress);
 
+			UpdateSlices();
+
 #ifndef NDEBUG
 			printf("m_nDmxStartAddress=%d, m_nDmxFootprint=%d\n", m_nDmxStartAddress, m_nDmxFootprint);
 #endif
@@ -78,6 +78,9 @@ const char LightSetParamsConst::DISABLE_MERGE_TIMEOUT[] = "disable_merge_timeout
 
 const char LightSetParamsConst::FAILSAFE[] = "failsafe";
 
+const char LightSetParamsConst::SYNC_PRESENTATION[] = "sync_presentation";
+const char LightSetParamsConst::SYNC_LATENCY_BUDGET[] = "sync_latency_budget";
+
 #if defined (CONFIG_PIXELDMX_MAX_PORTS)
 const char LightSetParamsConst::START_UNI_PORT[CONFIG_PIXELDMX_MAX_PORTS][20] = {
 		"start_uni_port_1",
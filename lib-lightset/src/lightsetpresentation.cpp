@@ -0,0 +1,165 @@
+/**
+ * @file lightsetpresentation.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "lightsetpresentation.h"
+
+#include "debug.h"
+
+namespace lightset {
+namespace presentation {
+const char *get_mode(const Mode mode) {
+	if (mode == Mode::LATENCY) {
+		return "latency";
+	}
+
+	if (mode == Mode::CLOCK) {
+		return "clock";
+	}
+
+	return "immediate";
+}
+
+Mode get_mode(const char *pMode) {
+	if (strncmp(pMode, "latency", 7) == 0) {
+		return Mode::LATENCY;
+	}
+
+	if (strncmp(pMode, "clock", 5) == 0) {
+		return Mode::CLOCK;
+	}
+
+	return Mode::IMMEDIATE;
+}
+
+Clock __attribute__((weak)) get_shared_clock() {
+	return nullptr;
+}
+
+void Histogram::Print(const char *pName) const {
+	printf(" %s (us), max %u\n", pName, nMax);
+
+	for (uint32_t i = 0; i < BUCKETS; i++) {
+		if (nCount[i] == 0) {
+			continue;
+		}
+
+		if (i == 0) {
+			printf("  %6u        : %u\n", 0U, nCount[i]);
+		} else if (i == (BUCKETS - 1)) {
+			printf("  %6u -      : %u\n", 1U << (i - 1), nCount[i]);
+		} else {
+			printf("  %6u-%-6u : %u\n", 1U << (i - 1), (1U << i) - 1, nCount[i]);
+		}
+	}
+}
+}  // namespace presentation
+}  // namespace lightset
+
+using namespace lightset::presentation;
+
+void LightSetPresentation::Latch(const uint32_t nArrival) {
+	const auto nInterval = nArrival - m_nArrivalPrevious;
+
+	if ((!m_bValid) || (nInterval < PERIOD_MIN_MICROS) || (nInterval > PERIOD_MAX_MICROS)) {
+		// Not periodic
+		m_bValid = true;
+		m_nPeriod = 0;
+		m_nPredicted = nArrival;
+	} else if (m_nPeriod == 0) {
+		m_nPeriod = nInterval << PERIOD_FRACTION_BITS;
+		m_nPredicted = nArrival;
+	} else {
+		const auto nPrediction = m_nPredicted + (m_nPeriod >> PERIOD_FRACTION_BITS);
+		const auto nDifference = static_cast<int32_t>(nArrival - nPrediction);
+		const auto nHalfPeriod = static_cast<int32_t>(m_nPeriod >> (PERIOD_FRACTION_BITS + 1));
+
+		if ((nDifference < -nHalfPeriod) || (nDifference > nHalfPeriod)) {
+			// The period has changed
+			m_nPeriod = nInterval << PERIOD_FRACTION_BITS;
+			m_nPredicted = nArrival;
+		} else {
+			// Earlier: less latency, follow at once. Later: raise the prediction slowly.
+			const auto nAdjust = (nDifference < 0) ? nDifference : (nDifference >> LEAK_SHIFT);
+			m_nPredicted = nPrediction + static_cast<uint32_t>(nAdjust);
+			/*
+			 * The period follows the adjustments of the prediction (second order loop),
+			 * a period which is too short gives a rise every sync, too long a fall.
+			 */
+			m_nPeriod = static_cast<uint32_t>(static_cast<int32_t>(m_nPeriod) + (nAdjust * (1 << (PERIOD_FRACTION_BITS - PERIOD_SHIFT))));
+		}
+	}
+
+	m_nArrivalPrevious = nArrival;
+	m_nArrival = nArrival;
+
+	if (m_Mode == Mode::CLOCK) {
+		// The grid point after the predicted arrival, the same on all nodes
+		m_nTarget = ((m_nPredicted / m_nLatencyBudgetMicros) + 1) * m_nLatencyBudgetMicros;
+	} else {
+		m_nTarget = m_nPredicted + m_nLatencyBudgetMicros;
+	}
+
+	// Never before the arrival
+	if (static_cast<int32_t>(m_nTarget - nArrival) < 0) {
+		m_nTarget = nArrival;
+	}
+
+	m_bPending = true;
+}
+
+void LightSetPresentation::Presented(const bool isForced) {
+	const auto nNow = m_pClock();
+
+	m_Latency.Add(nNow - m_nArrival);
+
+	const auto nLateness = static_cast<int32_t>(nNow - m_nTarget);
+	m_Lateness.Add(nLateness > 0 ? static_cast<uint32_t>(nLateness) : 0);
+
+	m_nPresented++;
+
+	if (isForced) {
+		m_nForced++;
+	}
+
+	m_bPending = false;
+}
+
+void LightSetPresentation::Print() const {
+	printf("Presentation time : %s\n", get_mode(m_Mode));
+
+	if (!IsEnabled()) {
+		return;
+	}
+
+	printf(" Latency budget %u us, sync period %u us\n", m_nLatencyBudgetMicros, GetPeriod());
+	printf(" Presented %u, forced %u\n", m_nPresented, m_nForced);
+
+	m_Latency.Print("Latency");
+	m_Lateness.Print("Lateness");
+}
@@ -0,0 +1,392 @@
+/**
+ * @file jitter.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Loopback measurement of the RTP-MIDI playout buffer.
+ * A simulated AppleMIDI initiator invites the RtpMidi session, runs the CK clock
+ * synchronization and sends MIDI clock (24 ppqn) with random send jitter.
+ * The interval error of the dispatched clock messages is reported with the
+ * messages dispatched on arrival (latency 0) and with the playout buffer.
+ * Then the order is verified of a buffered note on followed by a late note off,
+ * and by a System Exclusive message too long for the playout buffer.
+ * Usage: jitter ip_address|interface_name [jitter_ms] [clocks] [latency_max_ms]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "hardware.h"
+#include "network.h"
+#include "mdns.h"
+#include "rtpmidi.h"
+#include "rtpmidihandler.h"
+#include "midibpm.h"
+
+static constexpr uint32_t BPM = 120;
+static constexpr uint32_t CLOCK_INTERVAL_US = 60000000U / (BPM * 24U);
+static constexpr uint32_t SENDER_SSRC = 0x11223344;
+static constexpr uint32_t SENDER_CLOCK_OFFSET = 0x40000000;
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+static uint64_t s_nStart;
+
+static uint32_t sender_now() {
+	return static_cast<uint32_t>((micros() - s_nStart) / 100U) + SENDER_CLOCK_OFFSET;
+}
+
+class Receiver final: public RtpMidiHandler {
+public:
+	Receiver(uint32_t nClocks) : m_pDispatch(new uint64_t[nClocks]), m_nClocksMax(nClocks) {}
+
+	~Receiver() override {
+		delete[] m_pDispatch;
+	}
+
+	void MidiMessage(const struct midi::Message *pMidiMessage) override {
+		if (pMidiMessage->tType != midi::Types::CLOCK) {
+			if (m_nTypes < sizeof(m_Types) / sizeof(m_Types[0])) {
+				m_Types[m_nTypes++] = pMidiMessage->tType;
+			}
+			return;
+		}
+
+		if (m_nClocks < m_nClocksMax) {
+			m_pDispatch[m_nClocks++] = micros();
+		}
+
+		uint32_t nBPM;
+		if (m_MidiBPM.Get(pMidiMessage->nTimestamp, nBPM)) {
+			m_nBpmChanges++;
+			m_nBPM = nBPM;
+		}
+	}
+
+	void Reset() {
+		m_nClocks = 0;
+		m_nBpmChanges = 0;
+		m_nTypes = 0;
+	}
+
+	bool IsOrder(midi::Types first, midi::Types second) const {
+		return (m_nTypes == 2) && (m_Types[0] == first) && (m_Types[1] == second);
+	}
+
+	void Report(const char *pLabel) {
+		if (m_nClocks < 2) {
+			printf("%-10s no clocks received\n", pLabel);
+			return;
+		}
+
+		double fSum = 0, fSumSquares = 0, fMax = 0;
+
+		for (uint32_t i = 1; i < m_nClocks; i++) {
+			const auto fError = static_cast<double>(m_pDispatch[i] - m_pDispatch[i - 1]) - CLOCK_INTERVAL_US;
+			fSum += fError;
+			fSumSquares += fError * fError;
+			fMax = std::max(fMax, std::fabs(fError));
+		}
+
+		const auto n = static_cast<double>(m_nClocks - 1);
+		const auto fDeviation = std::sqrt(fSumSquares / n - (fSum / n) * (fSum / n));
+
+		printf("%-10s %5u clocks, interval error stddev %8.1f us, max %8.1f us, BPM %u (%u changes)\n", pLabel, m_nClocks, fDeviation, fMax, m_nBPM, m_nBpmChanges);
+	}
+
+private:
+	MidiBPM m_MidiBPM;
+	uint64_t *m_pDispatch;
+	uint32_t m_nClocksMax;
+	uint32_t m_nClocks { 0 };
+	uint32_t m_nBpmChanges { 0 };
+	uint32_t m_nBPM { 0 };
+	midi::Types m_Types[8];
+	uint32_t m_nTypes { 0 };
+};
+
+/*
+ * The Linux Network sockets have a receive time-out, which is rounded up to a
+ * scheduler tick. Make them non-blocking so that Run() is polled at full rate.
+ */
+static void network_sockets_nonblocking() {
+	for (int nSocket = 3; nSocket < 64; nSocket++) {
+		int nType;
+		socklen_t nLength = sizeof(nType);
+
+		if ((getsockopt(nSocket, SOL_SOCKET, SO_TYPE, &nType, &nLength) == 0) && (nType == SOCK_DGRAM)) {
+			fcntl(nSocket, F_SETFL, fcntl(nSocket, F_GETFL) | O_NONBLOCK);
+		}
+	}
+}
+
+static int socket_open() {
+	const auto nSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	bind(nSocket, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+	return nSocket;
+}
+
+static void socket_send(int nSocket, const void *pBuffer, size_t nLength, uint16_t nPort) {
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = Network::Get()->GetIp();
+	addr.sin_port = htons(nPort);
+	sendto(nSocket, pBuffer, nLength, 0, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+}
+
+static ssize_t socket_receive(int nSocket, void *pBuffer, size_t nLength, RtpMidi& rtpMidi) {
+	for (uint32_t i = 0; i < 100000; i++) {
+		rtpMidi.Run();
+		const auto nBytes = recv(nSocket, pBuffer, nLength, MSG_DONTWAIT);
+		if (nBytes > 0) {
+			return nBytes;
+		}
+		usleep(10);
+	}
+	return -1;
+}
+
+struct Exchange {
+	uint16_t nSignature;
+	uint16_t nCommand;
+	uint32_t nProtocolVersion;
+	uint32_t nInitiatorToken;
+	uint32_t nSSRC;
+	char aName[8];
+}__attribute__((packed));
+
+struct Synchronization {
+	uint16_t nSignature;
+	uint16_t nCommand;
+	uint32_t nSSRC;
+	uint8_t nCount;
+	uint8_t padding[3];
+	uint64_t nTimestamps[3];
+}__attribute__((packed));
+
+static bool session_open(int nControl, int nMidi, RtpMidi& rtpMidi) {
+	Exchange exchange;
+	memset(&exchange, 0, sizeof(exchange));
+	exchange.nSignature = 0xFFFF;
+	exchange.nCommand = __builtin_bswap16(0x494e);	// IN
+	exchange.nProtocolVersion = __builtin_bswap32(2);
+	exchange.nInitiatorToken = 0x12345678;
+	exchange.nSSRC = SENDER_SSRC;
+	strcpy(exchange.aName, "jitter");
+
+	uint8_t buffer[256];
+
+	socket_send(nControl, &exchange, sizeof(exchange), applemidi::UPD_PORT_CONTROL_DEFAULT);
+	if (socket_receive(nControl, buffer, sizeof(buffer), rtpMidi) < 0) {
+		return false;
+	}
+
+	socket_send(nMidi, &exchange, sizeof(exchange), applemidi::UPD_PORT_MIDI_DEFAULT);
+	if (socket_receive(nMidi, buffer, sizeof(buffer), rtpMidi) < 0) {
+		return false;
+	}
+
+	Synchronization ck;
+	memset(&ck, 0, sizeof(ck));
+	ck.nSignature = 0xFFFF;
+	ck.nCommand = __builtin_bswap16(0x434b);		// CK
+	ck.nSSRC = SENDER_SSRC;
+	ck.nTimestamps[0] = __builtin_bswap64(sender_now());
+
+	socket_send(nMidi, &ck, sizeof(ck), applemidi::UPD_PORT_MIDI_DEFAULT);
+	if (socket_receive(nMidi, &ck, sizeof(ck), rtpMidi) < 0) {
+		return false;
+	}
+
+	ck.nSSRC = SENDER_SSRC;
+	ck.nCount = 2;
+	ck.nTimestamps[2] = __builtin_bswap64(sender_now());
+	socket_send(nMidi, &ck, sizeof(ck), applemidi::UPD_PORT_MIDI_DEFAULT);
+
+	return true;
+}
+
+static void clocks_send(int nMidi, RtpMidi& rtpMidi, uint32_t nClocks, uint32_t nJitterMax, uint16_t& nSequenceNumber) {
+	const auto nBegin = micros() + 100000U;
+	uint64_t nSendAt = 0;
+
+	for (uint32_t i = 0; i < nClocks; i++) {
+		const auto nIdeal = nBegin + static_cast<uint64_t>(i) * CLOCK_INTERVAL_US;
+		const auto nTimestamp = static_cast<uint32_t>((nIdeal - s_nStart) / 100U) + SENDER_CLOCK_OFFSET;
+
+		// Packets are not reordered, a late packet delays the following ones
+		nSendAt = std::max(nSendAt, nIdeal + (nJitterMax != 0 ? static_cast<uint64_t>(random()) % nJitterMax : 0));
+
+		while (micros() < nSendAt) {
+			rtpMidi.Run();
+		}
+
+		uint8_t packet[sizeof(struct rtpmidi::Header) + 2];
+		auto *pHeader = reinterpret_cast<rtpmidi::Header *>(packet);
+		pHeader->nStatic = 0x6180;
+		pHeader->nSequenceNumber = __builtin_bswap16(nSequenceNumber++);
+		pHeader->nTimestamp = __builtin_bswap32(nTimestamp);
+		pHeader->nSenderSSRC = SENDER_SSRC;
+		packet[rtpmidi::COMMAND_OFFSET] = 1;
+		packet[rtpmidi::COMMAND_OFFSET + 1] = static_cast<uint8_t>(midi::Types::CLOCK);
+
+		socket_send(nMidi, packet, sizeof(packet), applemidi::UPD_PORT_MIDI_DEFAULT);
+	}
+
+	const auto nEnd = micros() + 100000U;
+
+	while (micros() < nEnd) {
+		rtpMidi.Run();
+	}
+}
+
+static void packet_send(int nMidi, const uint8_t *pCommands, uint32_t nLength, uint32_t nTimestamp, uint16_t& nSequenceNumber) {
+	uint8_t packet[sizeof(struct rtpmidi::Header) + 2 + 64];
+	auto *pHeader = reinterpret_cast<rtpmidi::Header *>(packet);
+	pHeader->nStatic = 0x6180;
+	pHeader->nSequenceNumber = __builtin_bswap16(nSequenceNumber++);
+	pHeader->nTimestamp = __builtin_bswap32(nTimestamp);
+	pHeader->nSenderSSRC = SENDER_SSRC;
+
+	uint32_t nOffset = rtpmidi::COMMAND_OFFSET;
+
+	if (nLength > 0x0F) {
+		packet[nOffset++] = static_cast<uint8_t>(0x80 | (nLength >> 8));	// B flag, long header
+	}
+
+	packet[nOffset++] = static_cast<uint8_t>(nLength);
+	memcpy(&packet[nOffset], pCommands, nLength);
+
+	socket_send(nMidi, packet, nOffset + nLength, applemidi::UPD_PORT_MIDI_DEFAULT);
+}
+
+/*
+ * A note on is buffered, it is due 15 ms from now.
+ * The message that follows must not be dispatched before it.
+ */
+static bool order_check(int nMidi, RtpMidi& rtpMidi, Receiver& receiver, const uint8_t *pCommands, uint32_t nLength, int32_t nTimestampOffset, midi::Types second, uint16_t& nSequenceNumber) {
+	receiver.Reset();
+
+	static constexpr uint8_t NOTE_ON[] = { 0x90, 0x3C, 0x40 };
+	packet_send(nMidi, NOTE_ON, sizeof(NOTE_ON), sender_now() + 150U, nSequenceNumber);
+
+	auto nEnd = micros() + 2000U;
+
+	while (micros() < nEnd) {
+		rtpMidi.Run();
+	}
+
+	packet_send(nMidi, pCommands, nLength, sender_now() + static_cast<uint32_t>(nTimestampOffset), nSequenceNumber);
+
+	nEnd = micros() + 100000U;
+
+	while (micros() < nEnd) {
+		rtpMidi.Run();
+	}
+
+	return receiver.IsOrder(midi::Types::NOTE_ON, second);
+}
+
+int main(int argc, char **argv) {
+	Hardware hw;
+	Network nw(argc, argv);
+	MDNS mDns;
+
+	const auto nJitterMax = 1000U * ((argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 10U);
+	const auto nClocks = (argc > 3) ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 0)) : 480U;
+	const auto nLatencyMax = (argc > 4) ? static_cast<uint32_t>(strtoul(argv[4], nullptr, 0)) : rtpmidi::PLAYOUT_LATENCY_MAX_MILLIS;
+
+	s_nStart = micros();
+	srandom(1);
+
+	Receiver receiver(nClocks);
+
+	RtpMidi rtpMidi;
+	rtpMidi.SetHandler(&receiver);
+	rtpMidi.Start();
+
+	network_sockets_nonblocking();
+
+	const auto nControl = socket_open();
+	const auto nMidi = socket_open();
+
+	if (!session_open(nControl, nMidi, rtpMidi)) {
+		printf("Session not established\n");
+		return 1;
+	}
+
+	printf("MIDI clock %u BPM, send jitter 0..%u us, %u clocks\n", BPM, nJitterMax, nClocks);
+
+	uint16_t nSequenceNumber = 0;
+
+	for (uint32_t nMode = 0; nMode < 2; nMode++) {
+		rtpMidi.SetPlayoutLatencyMax(nMode == 0 ? 0 : nLatencyMax);
+		receiver.Reset();
+
+		clocks_send(nMidi, rtpMidi, nClocks, nJitterMax, nSequenceNumber);
+
+		char label[24];
+		snprintf(label, sizeof(label), "Latency %u", rtpMidi.GetPlayoutLatencyMax());
+		receiver.Report(label);
+	}
+
+	rtpMidi.SetPlayoutLatencyMax(rtpmidi::PLAYOUT_LATENCY_MAX_MILLIS);
+
+	// The note off has a time stamp 100 ms in the past
+	static constexpr uint8_t NOTE_OFF[] = { 0x80, 0x3C, 0x00 };
+	const auto isLateOk = order_check(nMidi, rtpMidi, receiver, NOTE_OFF, sizeof(NOTE_OFF), -1000, midi::Types::NOTE_OFF, nSequenceNumber);
+	printf("Late note off after buffered note on: %s\n", isLateOk ? "OK" : "FAIL");
+
+	uint8_t systemExclusive[rtpmidi::PLAYOUT_DATA_MAX + 5];
+	memset(systemExclusive, 0x01, sizeof(systemExclusive));
+	systemExclusive[0] = 0xF0;
+	systemExclusive[sizeof(systemExclusive) - 1] = 0xF7;
+	const auto isLongOk = order_check(nMidi, rtpMidi, receiver, systemExclusive, sizeof(systemExclusive), 0, midi::Types::SYSTEM_EXCLUSIVE, nSequenceNumber);
+	printf("Long System Exclusive after buffered note on: %s\n", isLongOk ? "OK" : "FAIL");
+
+	rtpMidi.Print();
+
+	close(nMidi);
+	close(nControl);
+
+	const auto isPass = isLateOk && isLongOk;
+	puts(isPass ? "PASS" : "FAIL");
+
+	return isPass ? 0 : 1;
+}
@@ -48,6 +48,13 @@ static constexpr auto UPD_PORT_CONTROL_DEFAULT = 5004U;
 static constexpr auto UPD_PORT_MIDI_DEFAULT = UPD_PORT_CONTROL_DEFAULT + 1U;
 static constexpr auto SESSION_NAME_LENGTH_MAX = 24;
 static constexpr auto VERSION = 2;
+#if defined (BARE_METAL)
+static constexpr auto MAX_SESSIONS = 4U;
+#else
+static constexpr auto MAX_SESSIONS = 8U;
+#endif
+static constexpr auto SESSION_TIMEOUT_MILLIS = 90U * 1000U;
+static constexpr auto RECEIVER_FEEDBACK_MILLIS = 1000U;
 
 struct ExchangePacket {
 	uint16_t nSignature;
@@ -65,8 +72,20 @@ enum class SessionState {
 struct SessionStatus {
 	SessionState sessionState;
 	uint32_t nRemoteIp;
+	uint32_t nRemoteSSRC;
+	uint16_t nRemotePortControl;
 	uint16_t nRemotePortMidi;
 	uint32_t nSynchronizationTimestamp;
+	uint32_t nReceiverFeedbackMillis;
+	int32_t nClockOffset;		///< Remote clock minus local clock, 100us units
+	int32_t nTransit;			///< Last packet arrival minus remote timestamp, local clock
+	int32_t nTransitAverage;
+	uint32_t nJitter;			///< RFC 3550 interarrival jitter, 1/16 of 100us units
+	uint16_t nSequenceNumber;	///< Last received RTP sequence number
+	bool bClockOffsetValid;		///< Offset measured with CK, else estimated from the first RTP packet
+	bool bTransitValid;
+	bool bSequenceNumberValid;
+	bool bReceiverFeedback;		///< New sequence number to acknowledge with RS
 };
 
 static constexpr auto EXCHANGE_PACKET_MIN_LENGTH = sizeof(struct applemidi::ExchangePacket) - applemidi::SESSION_NAME_LENGTH_MAX - 1;
@@ -130,6 +149,15 @@ public:
 		printf("AppleMIDI\n");
 		printf(" SSRC    : %x (%u)\n", nSSRC, nSSRC);
 		printf(" Session : %s\n", m_ExchangePacketReply.aName);
+
+		for (uint32_t i = 0; i < applemidi::MAX_SESSIONS; i++) {
+			const auto& session = m_Sessions[i];
+
+			if (session.sessionState == applemidi::SessionState::ESTABLISHED) {
+				printf("  %u " IPSTR ":%u %x offset=%d jitter=%u\n", i, IP2STR(session.nRemoteIp), session.nRemotePortMidi,
+						__builtin_bswap32(session.nRemoteSSRC), session.nClockOffset, session.nJitter >> 4);
+			}
+		}
 	}
 
 protected:
@@ -138,23 +166,45 @@ protected:
 		return (nElapsed * 10U);
 	}
 
+	/**
+	 * Sends the RTP-MIDI packet to all established sessions.
+	 * The buffer must stay valid until the function returns.
+	 */
 	bool Send(const uint8_t *pBuffer, uint32_t nLength) {
-		if (m_SessionStatus.sessionState != applemidi::SessionState::ESTABLISHED) {
-			return false;
-		}
+		auto bSend = false;
 
-		Network::Get()->SendTo(m_nHandleMidi, pBuffer, static_cast<uint16_t>(nLength), m_SessionStatus.nRemoteIp, m_SessionStatus.nRemotePortMidi);
+		for (auto& session : m_Sessions) {
+			if (session.sessionState == applemidi::SessionState::ESTABLISHED) {
+				Network::Get()->SendToQueued(m_nHandleMidi, pBuffer, static_cast<uint16_t>(nLength), session.nRemoteIp, session.nRemotePortMidi);
+				bSend = true;
+			}
+		}
 
-		debug_dump(&pBuffer, static_cast<uint16_t>(nLength));
+		if (bSend) {
+			Network::Get()->SendFlush();
+			debug_dump(pBuffer, static_cast<uint16_t>(nLength));
+		}
 
-		return true;
+		return bSend;
 	}
 
 private:
 	void HandleControlMessage();
 	void HandleMidiMessage();
+	void HandleSynchronization(applemidi::SessionStatus& session);
+	void HandleRtpMidiPacket(applemidi::SessionStatus& session);
+	void SendReceiverFeedback(applemidi::SessionStatus& session);
+	void ClockOffsetUpdate(applemidi::SessionStatus& session, int32_t nClockOffset);
+	void SessionReset(applemidi::SessionStatus& session);
+
+	applemidi::SessionStatus *SessionFind(uint32_t nSSRC, uint32_t nRemoteIp);
+	applemidi::SessionStatus *SessionFindFree();
 
-	virtual void HandleRtpMidi(const uint8_t *pBuffer)=0;
+	/**
+	 * Called for each in sequence (or later) RTP-MIDI packet.
+	 * bPacketLoss is set when one or more packets from this session were lost.
+	 */
+	virtual void HandleRtpMidi(const uint8_t *pBuffer, uint32_t nLength, const applemidi::SessionStatus& session, bool bPacketLoss)=0;
 
 private:
 	uint32_t m_nStartTime { 0 };
@@ -167,7 +217,7 @@ private:
 	uint16_t m_nRemotePort { 0 };
 	uint16_t m_nBytesReceived { 0 };
 	applemidi::ExchangePacket m_ExchangePacketReply;
-	applemidi::SessionStatus m_SessionStatus;
+	applemidi::SessionStatus m_Sessions[applemidi::MAX_SESSIONS];
 	uint8_t *m_pBuffer { nullptr };
 };
 
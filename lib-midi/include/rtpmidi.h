@@ -46,6 +46,17 @@ struct Header {
 }__attribute__((packed));
 
 static constexpr auto COMMAND_OFFSET = sizeof(struct Header);
+
+static constexpr auto PLAYOUT_ENTRIES = 32U;
+static constexpr auto PLAYOUT_DATA_MAX = 15U;		///< Longer System Exclusive messages are dispatched on arrival
+static constexpr auto PLAYOUT_LATENCY_MAX_MILLIS = 20U;
+
+struct PlayoutEntry {
+	uint32_t nDue;			///< Local clock, 100us units
+	uint32_t nTimestamp;	///< Remote clock, RTP timestamp + delta time
+	uint8_t nLength;
+	uint8_t aData[PLAYOUT_DATA_MAX];
+};
 }  // namespace rtpmidi
 
 class RtpMidi final: public AppleMidi {
@@ -84,6 +95,24 @@ public:
 
 	void Run() {
 		AppleMidi::Run();
+
+		if (m_nPlayoutCount != 0) {
+			PlayoutRun();
+		}
+	}
+
+	/**
+	 * Incoming messages are played out at their sender timestamp plus an adaptive latency:
+	 * the average transit time plus four times the interarrival jitter, limited to nMillis.
+	 * With 0 the messages are dispatched on arrival.
+	 */
+	void SetPlayoutLatencyMax(uint32_t nMillis) {
+		PlayoutFlush();
+		m_nPlayoutLatencyMax = nMillis * 10U;
+	}
+
+	uint32_t GetPlayoutLatencyMax() const {
+		return m_nPlayoutLatencyMax / 10U;
 	}
 
 	void SendRaw(uint8_t nByte) {
@@ -126,10 +155,19 @@ public:
 	}
 
 private:
-	void HandleRtpMidi(const uint8_t *pBuffer) override;
+	void HandleRtpMidi(const uint8_t *pBuffer, uint32_t nLength, const applemidi::SessionStatus& session, bool bPacketLoss) override;
 
-	int32_t DecodeTime(uint32_t nCommandLength, uint32_t nOffset);
-	int32_t DecodeMidi(uint32_t nCommandLength, uint32_t nOffset);
+	int32_t DecodeTime(const uint8_t *pData, uint32_t nLength, uint32_t& nDeltaTime);
+	int32_t DecodeMidi(const uint8_t *pData, uint32_t nLength);
+	void Dispatch();
+
+	void Schedule(const uint8_t *pData, uint32_t nLength, uint32_t nTimestamp, const applemidi::SessionStatus& session);
+	void PlayoutRun();
+	void PlayoutFlush();
+
+	void Recover(const uint8_t *pJournal, uint32_t nLength, uint32_t nTimestamp);
+	void RecoverChannel(const uint8_t *pChapters, uint32_t nLength, uint8_t nChannel, uint8_t nTableOfContents, uint32_t nTimestamp);
+	void RecoverMessage(uint8_t nStatus, uint8_t nData1, uint8_t nData2, uint32_t nTimestamp);
 
 	midi::Types GetTypeFromStatusByte(uint8_t nStatusByte) {
 		if ((nStatusByte < 0x80) || (nStatusByte == 0xf4) || (nStatusByte == 0xf5) || (nStatusByte == 0xf9) || (nStatusByte == 0xfD)) {
@@ -164,6 +202,12 @@ private:
 	uint8_t *m_pReceiveBuffer { nullptr };
 	uint8_t *m_pSendBuffer { nullptr };
 	uint16_t m_nSequenceNumber { 0 };
+	uint8_t m_nRunningStatus { 0 };
+
+	rtpmidi::PlayoutEntry m_PlayoutEntries[rtpmidi::PLAYOUT_ENTRIES];
+	uint32_t m_nPlayoutHead { 0 };
+	uint32_t m_nPlayoutCount { 0 };
+	uint32_t m_nPlayoutLatencyMax { rtpmidi::PLAYOUT_LATENCY_MAX_MILLIS * 10U };
 
 	static RtpMidi *s_pThis;
 };
@@ -37,6 +37,7 @@
 #endif
 
 #include "applemidi.h"
+#include "rtpmidi.h"
 
 #include "midi.h"
 
@@ -68,6 +69,13 @@ struct TTimestampSynchronization {
 	uint64_t nTimestamps[3];
 }__attribute__((packed));
 
+struct TReceiverFeedback {
+	uint16_t nSignature;
+	uint16_t nCommand;
+	uint32_t nSSRC;
+	uint32_t nSequenceNumber;
+}__attribute__((packed));
+
 AppleMidi::AppleMidi() : m_nSSRC(Network::Get()->GetIp()), m_nExchangePacketReplySize(applemidi::EXCHANGE_PACKET_MIN_LENGTH) {
 	DEBUG_ENTRY
 
@@ -77,12 +85,39 @@ AppleMidi::AppleMidi() : m_nSSRC(Network::Get()->GetIp()), m_nExchangePacketRepl
 
 	SetSessionName(Network::Get()->GetHostName());
 
-	memset(&m_SessionStatus, 0, sizeof (struct applemidi::SessionStatus));
+	for (auto& session : m_Sessions) {
+		SessionReset(session);
+	}
 
 	DEBUG_PRINTF("applemidi::EXCHANGE_PACKET_MIN_LENGTH = %u", static_cast<uint32_t>(applemidi::EXCHANGE_PACKET_MIN_LENGTH));
 	DEBUG_EXIT
 }
 
+void AppleMidi::SessionReset(applemidi::SessionStatus& session) {
+	memset(&session, 0, sizeof(struct applemidi::SessionStatus));
+	session.sessionState = applemidi::SessionState::WAITING_IN_CONTROL;
+}
+
+applemidi::SessionStatus *AppleMidi::SessionFind(uint32_t nSSRC, uint32_t nRemoteIp) {
+	for (auto& session : m_Sessions) {
+		if ((session.nRemoteIp == nRemoteIp) && (session.nRemoteSSRC == nSSRC)) {
+			return &session;
+		}
+	}
+
+	return nullptr;
+}
+
+applemidi::SessionStatus *AppleMidi::SessionFindFree() {
+	for (auto& session : m_Sessions) {
+		if (session.nRemoteIp == 0) {
+			return &session;
+		}
+	}
+
+	return nullptr;
+}
+
 void AppleMidi::HandleControlMessage() {
 	DEBUG_ENTRY
 	assert(m_pBuffer != nullptr);
@@ -90,56 +125,163 @@ void AppleMidi::HandleControlMessage() {
 	auto *pPacket = reinterpret_cast<struct applemidi::ExchangePacket*>(m_pBuffer);
 
 	debug_dump(m_pBuffer, m_nBytesReceived);
-	DEBUG_PRINTF("Command: %.4x, m_nSessionState=%u", pPacket->nCommand, static_cast<uint32_t>(m_SessionStatus.sessionState));
+	DEBUG_PRINTF("Command: %.4x", pPacket->nCommand);
 
-	if (m_SessionStatus.sessionState == applemidi::SessionState::WAITING_IN_CONTROL) {
-		DEBUG_PUTS("SESSION_STATE_WAITING_IN_CONTROL");
+	if (pPacket->nCommand == APPLEMIDI_COMMAND_INVITATION) {
+		auto *pSession = SessionFind(pPacket->nSSRC, m_nRemoteIp);
 
-		if ((m_SessionStatus.nRemoteIp == 0) && (pPacket->nCommand == APPLEMIDI_COMMAND_INVITATION)) {
- 			DEBUG_PUTS("Invitation");
+		if (pSession == nullptr) {
+			pSession = SessionFindFree();
+		}
+
+		m_ExchangePacketReply.nInitiatorToken = pPacket->nInitiatorToken;
 
+		if (pSession == nullptr) {
+			DEBUG_PUTS("Invitation rejected");
+			m_ExchangePacketReply.nCommand = APPLEMIDI_COMMAND_INVITATION_REJECTED;
+		} else {
+			DEBUG_PUTS("Invitation");
 			m_ExchangePacketReply.nCommand = APPLEMIDI_COMMAND_INVITATION_ACCEPTED;
-			m_ExchangePacketReply.nInitiatorToken = pPacket->nInitiatorToken;
 
-			Network::Get()->SendTo(m_nHandleControl, &m_ExchangePacketReply, m_nExchangePacketReplySize, m_nRemoteIp, m_nRemotePort);
+			SessionReset(*pSession);
+			pSession->sessionState = applemidi::SessionState::WAITING_IN_MIDI;
+			pSession->nRemoteIp = m_nRemoteIp;
+			pSession->nRemoteSSRC = pPacket->nSSRC;
+			pSession->nRemotePortControl = m_nRemotePort;
+			pSession->nSynchronizationTimestamp = Hardware::Get()->Millis();
+		}
 
-			debug_dump(&m_ExchangePacketReply, m_nExchangePacketReplySize);
+		Network::Get()->SendTo(m_nHandleControl, &m_ExchangePacketReply, m_nExchangePacketReplySize, m_nRemoteIp, m_nRemotePort);
 
-			m_SessionStatus.sessionState = applemidi::SessionState::WAITING_IN_MIDI;
-			m_SessionStatus.nRemoteIp = m_nRemoteIp;
+		debug_dump(&m_ExchangePacketReply, m_nExchangePacketReplySize);
 
-			return;
-		} else {
-			return;
-		}
+		DEBUG_EXIT
+		return;
 	}
 
-	if (m_SessionStatus.sessionState == applemidi::SessionState::ESTABLISHED) {
-		DEBUG_PUTS("SESSION_STATE_ESTABLISHED");
+	if (pPacket->nCommand == APPLEMIDI_COMMAND_ENDSESSION) {
+		auto *pSession = SessionFind(pPacket->nSSRC, m_nRemoteIp);
 
-		if ((m_SessionStatus.nRemoteIp == m_nRemoteIp) && (pPacket->nCommand == APPLEMIDI_COMMAND_ENDSESSION)) {
-			m_SessionStatus.sessionState = applemidi::SessionState::WAITING_IN_CONTROL;
-			m_SessionStatus.nRemoteIp = 0;
+		if (pSession != nullptr) {
+			SessionReset(*pSession);
 			DEBUG_PUTS("End Session");
-
-			return;
 		}
+	}
 
-		if (pPacket->nCommand == APPLEMIDI_COMMAND_INVITATION) {
-		 	DEBUG_PUTS("Invitation rejected");
+	DEBUG_EXIT
+}
 
-			m_ExchangePacketReply.nCommand = APPLEMIDI_COMMAND_INVITATION_REJECTED;
-			m_ExchangePacketReply.nInitiatorToken = pPacket->nInitiatorToken;
+void AppleMidi::ClockOffsetUpdate(applemidi::SessionStatus& session, int32_t nClockOffset) {
+	DEBUG_PRINTF("nClockOffset=%d", nClockOffset);
+
+	if (!session.bClockOffsetValid) {
+		/*
+		 * The first measurement replaces the estimate taken from the first RTP packet,
+		 * the transit statistics are relative to the offset and start again.
+		 */
+		session.nClockOffset = nClockOffset;
+		session.bClockOffsetValid = true;
+		session.bTransitValid = false;
+		return;
+	}
+
+	session.nClockOffset += (nClockOffset - session.nClockOffset) / 8;
+}
+
+void AppleMidi::HandleSynchronization(applemidi::SessionStatus& session) {
+	DEBUG_PUTS("Timestamp Synchronization");
+	auto *t = reinterpret_cast<struct TTimestampSynchronization*>(m_pBuffer);
+
+	session.nSynchronizationTimestamp = Hardware::Get()->Millis();
+
+	const auto nNow = Now();
+
+	if (t->nCount == 0) {
+		t->nSSRC = m_nSSRC;
+		t->nCount = 1;
+		t->nTimestamps[1] = __builtin_bswap64(nNow);
+
+		Network::Get()->SendTo(m_nHandleMidi, m_pBuffer, sizeof(struct TTimestampSynchronization), m_nRemoteIp, m_nRemotePort);
+	} else if (t->nCount == 1) {
+		// We are the initiator: t1 and t3 are local, t2 is remote
+		const auto t1 = static_cast<uint32_t>(__builtin_bswap64(t->nTimestamps[0]));
+		const auto t2 = static_cast<uint32_t>(__builtin_bswap64(t->nTimestamps[1]));
+
+		t->nSSRC = m_nSSRC;
+		t->nCount = 2;
+		t->nTimestamps[2] = __builtin_bswap64(nNow);
+
+		Network::Get()->SendTo(m_nHandleMidi, m_pBuffer, sizeof(struct TTimestampSynchronization), m_nRemoteIp, m_nRemotePort);
 
-			Network::Get()->SendTo(m_nHandleControl, &m_ExchangePacketReply, m_nExchangePacketReplySize, m_nRemoteIp, m_nRemotePort);
+		ClockOffsetUpdate(session, static_cast<int32_t>(t2 - (t1 + (nNow - t1) / 2)));
+	} else if (t->nCount == 2) {
+		// We are the responder: t1 and t3 are remote, t2 is local
+		const auto t1 = static_cast<uint32_t>(__builtin_bswap64(t->nTimestamps[0]));
+		const auto t2 = static_cast<uint32_t>(__builtin_bswap64(t->nTimestamps[1]));
+		const auto t3 = static_cast<uint32_t>(__builtin_bswap64(t->nTimestamps[2]));
 
-			debug_dump(&m_ExchangePacketReply, m_nExchangePacketReplySize);
+		ClockOffsetUpdate(session, static_cast<int32_t>((t1 + (t3 - t1) / 2) - t2));
 
+		t->nSSRC = m_nSSRC;
+		t->nCount = 0;
+		t->nTimestamps[0] = __builtin_bswap64(nNow);
+		t->nTimestamps[1] = 0;
+		t->nTimestamps[2] = 0;
+
+		Network::Get()->SendTo(m_nHandleMidi, m_pBuffer, sizeof(struct TTimestampSynchronization), m_nRemoteIp, m_nRemotePort);
+	}
+}
+
+void AppleMidi::HandleRtpMidiPacket(applemidi::SessionStatus& session) {
+	const auto *pHeader = reinterpret_cast<const rtpmidi::Header *>(m_pBuffer);
+	const auto nSequenceNumber = __builtin_bswap16(pHeader->nSequenceNumber);
+	const auto nTimestamp = __builtin_bswap32(pHeader->nTimestamp);
+
+	auto bPacketLoss = false;
+
+	if (session.bSequenceNumberValid) {
+		const auto nDelta = static_cast<int16_t>(nSequenceNumber - session.nSequenceNumber);
+
+		if (nDelta <= 0) {
+			DEBUG_PRINTF("Late or duplicate %u", nSequenceNumber);
 			return;
 		}
+
+		bPacketLoss = (nDelta != 1);
 	}
 
-	DEBUG_EXIT
+	session.nSequenceNumber = nSequenceNumber;
+	session.bSequenceNumberValid = true;
+	session.bReceiverFeedback = true;
+
+	/*
+	 * RFC 3550 A.8 interarrival jitter, in the local clock.
+	 * Without a CK measurement the offset is estimated from the first packet.
+	 */
+
+	const auto nArrival = Now();
+
+	if (!session.bClockOffsetValid && !session.bTransitValid) {
+		session.nClockOffset = static_cast<int32_t>(nTimestamp - nArrival);
+	}
+
+	const auto nTransit = static_cast<int32_t>(nArrival - nTimestamp + static_cast<uint32_t>(session.nClockOffset));
+
+	if (session.bTransitValid) {
+		const auto nDifference = nTransit - session.nTransit;
+		const auto nAbsolute = static_cast<uint32_t>(nDifference < 0 ? -nDifference : nDifference);
+
+		session.nJitter += nAbsolute - ((session.nJitter + 8) >> 4);
+		session.nTransitAverage += (nTransit - session.nTransitAverage) / 8;
+	} else {
+		session.nTransitAverage = nTransit;
+		session.nJitter = 0;
+		session.bTransitValid = true;
+	}
+
+	session.nTransit = nTransit;
+
+	HandleRtpMidi(m_pBuffer, m_nBytesReceived, session, bPacketLoss);
 }
 
 void AppleMidi::HandleMidiMessage() {
@@ -149,84 +291,77 @@ void AppleMidi::HandleMidiMessage() {
 	debug_dump(m_pBuffer, m_nBytesReceived);
 
 	if (*reinterpret_cast<uint16_t*>(m_pBuffer) == 0x6180) {
-		HandleRtpMidi(m_pBuffer);
-		return;
-	}
+		const auto *pHeader = reinterpret_cast<const rtpmidi::Header *>(m_pBuffer);
+		auto *pSession = SessionFind(pHeader->nSenderSSRC, m_nRemoteIp);
 
-	if (m_nBytesReceived >= applemidi::EXCHANGE_PACKET_MIN_LENGTH) {
-
-		if (*reinterpret_cast<uint16_t *>(m_pBuffer) == applemidi::SIGNATURE) {
+		if ((pSession != nullptr) && (pSession->sessionState == applemidi::SessionState::ESTABLISHED)) {
+			HandleRtpMidiPacket(*pSession);
+		}
 
-			if (m_SessionStatus.sessionState == applemidi::SessionState::WAITING_IN_MIDI) {
-				DEBUG_PUTS("SESSION_STATE_WAITING_IN_MIDI");
+		DEBUG_EXIT
+		return;
+	}
 
-				auto *pPacket = reinterpret_cast<struct applemidi::ExchangePacket*>(m_pBuffer);
+	if ((m_nBytesReceived < applemidi::EXCHANGE_PACKET_MIN_LENGTH) || (*reinterpret_cast<uint16_t *>(m_pBuffer) != applemidi::SIGNATURE)) {
+		DEBUG_EXIT
+		return;
+	}
 
-				DEBUG_PRINTF("Command: %.4x", pPacket->nCommand);
+	auto *pPacket = reinterpret_cast<struct applemidi::ExchangePacket*>(m_pBuffer);
 
-				if (pPacket->nCommand == APPLEMIDI_COMMAND_INVITATION) {
-					DEBUG_PUTS("Invitation");
+	DEBUG_PRINTF("Command: %.4x", pPacket->nCommand);
 
-					m_ExchangePacketReply.nCommand = APPLEMIDI_COMMAND_INVITATION_ACCEPTED;
-					m_ExchangePacketReply.nInitiatorToken = pPacket->nInitiatorToken;
+	if (pPacket->nCommand == APPLEMIDI_COMMAND_INVITATION) {
+		auto *pSession = SessionFind(pPacket->nSSRC, m_nRemoteIp);
 
-					Network::Get()->SendTo(m_nHandleMidi, &m_ExchangePacketReply, m_nExchangePacketReplySize, m_nRemoteIp, m_nRemotePort);
+		if ((pSession != nullptr) && (pSession->sessionState == applemidi::SessionState::WAITING_IN_MIDI)) {
+			DEBUG_PUTS("Invitation");
 
-					m_SessionStatus.sessionState = applemidi::SessionState::ESTABLISHED;
-					m_SessionStatus.nRemotePortMidi = m_nRemotePort;
-					m_SessionStatus.nSynchronizationTimestamp = Hardware::Get()->Millis();
-				}
+			m_ExchangePacketReply.nCommand = APPLEMIDI_COMMAND_INVITATION_ACCEPTED;
+			m_ExchangePacketReply.nInitiatorToken = pPacket->nInitiatorToken;
 
-				return;
-			}
+			Network::Get()->SendTo(m_nHandleMidi, &m_ExchangePacketReply, m_nExchangePacketReplySize, m_nRemoteIp, m_nRemotePort);
 
-			if (m_SessionStatus.sessionState == applemidi::SessionState::ESTABLISHED) {
-				DEBUG_PUTS("SESSION_STATE_ESTABLISHED");
+			pSession->sessionState = applemidi::SessionState::ESTABLISHED;
+			pSession->nRemotePortMidi = m_nRemotePort;
+			pSession->nSynchronizationTimestamp = Hardware::Get()->Millis();
+			pSession->nReceiverFeedbackMillis = pSession->nSynchronizationTimestamp;
+		}
 
-				auto *pPacket = reinterpret_cast<struct applemidi::ExchangePacket*>(m_pBuffer);
+		DEBUG_EXIT
+		return;
+	}
 
-				if (pPacket->nCommand == APPLEMIDI_COMMAND_SYNCHRONIZATION) {
-					DEBUG_PUTS("Timestamp Synchronization");
-					auto *t = reinterpret_cast<struct TTimestampSynchronization*>(m_pBuffer);
+	if ((pPacket->nCommand == APPLEMIDI_COMMAND_SYNCHRONIZATION) && (m_nBytesReceived >= sizeof(struct TTimestampSynchronization))) {
+		const auto *pSynchronization = reinterpret_cast<const struct TTimestampSynchronization *>(m_pBuffer);
+		auto *pSession = SessionFind(pSynchronization->nSSRC, m_nRemoteIp);
 
-					m_SessionStatus.nSynchronizationTimestamp = Hardware::Get()->Millis();
+		if ((pSession != nullptr) && (pSession->sessionState == applemidi::SessionState::ESTABLISHED)) {
+			HandleSynchronization(*pSession);
+		}
+	}
 
-					if (t->nCount == 0) {
-						t->nSSRC = m_nSSRC;
-						t->nCount = 1;
-						t->nTimestamps[1] = __builtin_bswap64(Now());
+	DEBUG_EXIT
+}
 
-						Network::Get()->SendTo(m_nHandleMidi, m_pBuffer, sizeof(struct TTimestampSynchronization), m_nRemoteIp, m_nRemotePort);
-					} else if (t->nCount == 1) {
-						t->nSSRC = m_nSSRC;
-						t->nCount = 2;
-						t->nTimestamps[2] = __builtin_bswap64(Now());
+void AppleMidi::SendReceiverFeedback(applemidi::SessionStatus& session) {
+	struct TReceiverFeedback feedback;
 
-						Network::Get()->SendTo(m_nHandleMidi, m_pBuffer, sizeof(struct TTimestampSynchronization), m_nRemoteIp, m_nRemotePort);
-					} else if (t->nCount == 2) {
-						t->nSSRC = m_nSSRC;
-						t->nCount = 0;
-						t->nTimestamps[0] = __builtin_bswap64(Now());
-						t->nTimestamps[1] = 0;
-						t->nTimestamps[2] = 0;
+	feedback.nSignature = applemidi::SIGNATURE;
+	feedback.nCommand = APPLEMIDI_COMMAND_RECEIVER_FEEDBACK;
+	feedback.nSSRC = m_nSSRC;
+	feedback.nSequenceNumber = __builtin_bswap32(static_cast<uint32_t>(session.nSequenceNumber) << 16);
 
-						Network::Get()->SendTo(m_nHandleMidi, m_pBuffer, sizeof(struct TTimestampSynchronization), m_nRemoteIp, m_nRemotePort);
-					}
-				}
-			}
-		}
-	}
+	Network::Get()->SendTo(m_nHandleControl, &feedback, sizeof(struct TReceiverFeedback), session.nRemoteIp, session.nRemotePortControl);
 
-	DEBUG_EXIT
+	session.bReceiverFeedback = false;
 }
 
 void AppleMidi::Run() {
 	m_nBytesReceived = Network::Get()->RecvFrom(m_nHandleMidi, const_cast<const void **>(reinterpret_cast<void **>(&m_pBuffer)), &m_nRemoteIp, &m_nRemotePort);
 
 	if (__builtin_expect((m_nBytesReceived >= 12), 0)) {
-		if (m_SessionStatus.nRemoteIp == m_nRemoteIp) {
-			HandleMidiMessage();
-		}
+		HandleMidiMessage();
 	}
 
 	m_nBytesReceived = Network::Get()->RecvFrom(m_nHandleControl, const_cast<const void **>(reinterpret_cast<void **>(&m_pBuffer)), &m_nRemoteIp, &m_nRemotePort);
@@ -237,11 +372,22 @@ void AppleMidi::Run() {
 		}
 	}
 
-	if (m_SessionStatus.sessionState == applemidi::SessionState::ESTABLISHED) {
-		if (__builtin_expect((Hardware::Get()->Millis() - m_SessionStatus.nSynchronizationTimestamp > (90 * 1000)), 0)) {
-			m_SessionStatus.sessionState = applemidi::SessionState::WAITING_IN_CONTROL;
-			m_SessionStatus.nRemoteIp = 0;
+	const auto nMillis = Hardware::Get()->Millis();
+
+	for (auto& session : m_Sessions) {
+		if (session.nRemoteIp == 0) {
+			continue;
+		}
+
+		if (__builtin_expect((nMillis - session.nSynchronizationTimestamp > applemidi::SESSION_TIMEOUT_MILLIS), 0)) {
+			SessionReset(session);
 			DEBUG_PUTS("End Session {time-out}");
+			continue;
+		}
+
+		if (session.bReceiverFeedback && (nMillis - session.nReceiverFeedbackMillis >= applemidi::RECEIVER_FEEDBACK_MILLIS)) {
+			session.nReceiverFeedbackMillis = nMillis;
+			SendReceiverFeedback(session);
 		}
 	}
 }
@@ -23,7 +23,10 @@
  * THE SOFTWARE.
  */
 
+#include <cstdint>
+#include <cstring>
 #include <cstdio>
+#include <algorithm>
 #include <cassert>
 
 #include "rtpmidi.h"
@@ -47,17 +50,38 @@
 #define RTP_MIDI_CS_MASK_SHORTLEN 		0x0f
 #define RTP_MIDI_CS_MASK_LONGLEN 		0x0fff
 
+/*
+ * RFC 6295 recovery journal
+ */
+
+#define RTP_MIDI_JS_FLAG_Y				0x40
+#define RTP_MIDI_JS_FLAG_A				0x20
+#define RTP_MIDI_JS_MASK_TOTCHAN		0x0f
+
+#define RTP_MIDI_CJ_CHAPTER_P			0x80
+#define RTP_MIDI_CJ_CHAPTER_C			0x40
+#define RTP_MIDI_CJ_CHAPTER_M			0x20
+#define RTP_MIDI_CJ_CHAPTER_W			0x10
+#define RTP_MIDI_CJ_CHAPTER_N			0x08
+
+static_assert((rtpmidi::PLAYOUT_ENTRIES & (rtpmidi::PLAYOUT_ENTRIES - 1)) == 0, "PLAYOUT_ENTRIES must be a power of 2");
+
 RtpMidi *RtpMidi::s_pThis = nullptr;
 
-int32_t RtpMidi::DecodeTime([[maybe_unused]] uint32_t nCommandLength, uint32_t nOffset) {
+int32_t RtpMidi::DecodeTime(const uint8_t *pData, uint32_t nLength, uint32_t& nDeltaTime) {
 	DEBUG_ENTRY
 
 	int32_t nSize = 0;
-	unsigned long deltatime = 0;
+	nDeltaTime = 0;
 
-	for (uint32_t i = 0; i < 4; i++ ) {
-		const auto nOctet = m_pReceiveBuffer[nOffset + static_cast<uint32_t>(nSize)];
-		deltatime = ( deltatime << 7 ) | ( nOctet & RTP_MIDI_DELTA_TIME_OCTET_MASK );
+	for (uint32_t i = 0; i < 4; i++) {
+		if (static_cast<uint32_t>(nSize) >= nLength) {
+			DEBUG_EXIT
+			return -1;
+		}
+
+		const auto nOctet = pData[nSize];
+		nDeltaTime = (nDeltaTime << 7) | (nOctet & RTP_MIDI_DELTA_TIME_OCTET_MASK);
 		nSize++;
 
 		if ((nOctet & RTP_MIDI_DELTA_TIME_EXTENSION) == 0) {
@@ -65,21 +89,24 @@ int32_t RtpMidi::DecodeTime([[maybe_unused]] uint32_t nCommandLength, uint32_t n
 		}
 	}
 
-	DEBUG_PRINTF("nSize=%d, deltatime=%x", nSize, static_cast<unsigned>(deltatime));
+	DEBUG_PRINTF("nSize=%d, nDeltaTime=%x", nSize, nDeltaTime);
 
 	DEBUG_EXIT
 	return nSize;
 }
 
-int32_t RtpMidi::DecodeMidi(uint32_t nCommandLength, uint32_t nOffset) {
+/**
+ * Decodes one MIDI command into m_tMidiMessage, the timestamp is not set.
+ * Returns the number of bytes used or -1 when the command is invalid.
+ */
+int32_t RtpMidi::DecodeMidi(const uint8_t *pData, uint32_t nLength) {
 	DEBUG_ENTRY
 
 	int32_t nSize = -1;
 
-	const auto nStatusByte = m_pReceiveBuffer[nOffset];
+	const auto nStatusByte = pData[0];
 	const auto nType = GetTypeFromStatusByte(nStatusByte);
 
-	m_tMidiMessage.nTimestamp = __builtin_bswap32(*reinterpret_cast<uint32_t *>(&m_pReceiveBuffer[4]));
 	m_tMidiMessage.tType = nType;
 	m_tMidiMessage.nChannel = 0;
 	m_tMidiMessage.nData1 = 0;
@@ -100,10 +127,12 @@ int32_t RtpMidi::DecodeMidi(uint32_t nCommandLength, uint32_t nOffset) {
 	case midi::Types::AFTER_TOUCH_CHANNEL:
 	case midi::Types::TIME_CODE_QUARTER_FRAME:
 	case midi::Types::SONG_SELECT:
-		m_tMidiMessage.nChannel = GetChannelFromStatusByte(nStatusByte);
-		m_tMidiMessage.nData1 = m_pReceiveBuffer[++nOffset];
-		m_tMidiMessage.nBytesCount = 2;
-		nSize = 2;
+		if (nLength >= 2) {
+			m_tMidiMessage.nChannel = GetChannelFromStatusByte(nStatusByte);
+			m_tMidiMessage.nData1 = pData[1];
+			m_tMidiMessage.nBytesCount = 2;
+			nSize = 2;
+		}
 		break;
 	case midi::Types::NOTE_ON:
 	case midi::Types::NOTE_OFF:
@@ -111,20 +140,26 @@ int32_t RtpMidi::DecodeMidi(uint32_t nCommandLength, uint32_t nOffset) {
 	case midi::Types::PITCH_BEND:
 	case midi::Types::AFTER_TOUCH_POLY:
 	case midi::Types::SONG_POSITION:
-		m_tMidiMessage.nChannel = GetChannelFromStatusByte(nStatusByte);
-		m_tMidiMessage.nData1 = m_pReceiveBuffer[++nOffset];
-		m_tMidiMessage.nData2 = m_pReceiveBuffer[++nOffset];
-		m_tMidiMessage.nBytesCount = 3;
-		nSize = 3;
+		if (nLength >= 3) {
+			m_tMidiMessage.nChannel = GetChannelFromStatusByte(nStatusByte);
+			m_tMidiMessage.nData1 = pData[1];
+			m_tMidiMessage.nData2 = pData[2];
+			m_tMidiMessage.nBytesCount = 3;
+			nSize = 3;
+		}
 		break;
 	case midi::Types::SYSTEM_EXCLUSIVE: {
-		for (nSize = 0; (static_cast<uint32_t>(nSize) < nCommandLength) && (static_cast<uint32_t>(nSize) < MIDI_SYSTEM_EXCLUSIVE_INDEX_ENTRIES); nSize++) {
-			m_tMidiMessage.aSystemExclusive[nSize] = m_pReceiveBuffer[nOffset++];
-			if (m_tMidiMessage.aSystemExclusive[nSize] == 0xF7) {
+		uint32_t i;
+
+		for (i = 0; (i < nLength) && (i < MIDI_SYSTEM_EXCLUSIVE_INDEX_ENTRIES); i++) {
+			m_tMidiMessage.aSystemExclusive[i] = pData[i];
+			if (pData[i] == 0xF7) {
+				i++;
 				break;
 			}
 		}
-		nSize++;
+
+		nSize = static_cast<int32_t>(i);
 		m_tMidiMessage.nData1 = static_cast<uint8_t>(nSize & 0xFF); // LSB
 		m_tMidiMessage.nData2 = static_cast<uint8_t>(nSize >> 8);   // MSB
 		m_tMidiMessage.nBytesCount = static_cast<uint8_t>(nSize);
@@ -136,63 +171,377 @@ int32_t RtpMidi::DecodeMidi(uint32_t nCommandLength, uint32_t nOffset) {
 
 	DEBUG_PRINTF("nSize=%d", nSize);
 
+	DEBUG_EXIT
+	return nSize;
+}
+
+void RtpMidi::Dispatch() {
 	if (m_pRtpMidiHandler != nullptr) {
 		m_pRtpMidiHandler->MidiMessage(&m_tMidiMessage);
-		DEBUG_PUTS("");
+	}
+}
+
+/*
+ * Playout buffer: entries are kept in arrival order in a ring, the due times are non-decreasing.
+ * A message is never dispatched before the messages that are still buffered.
+ */
+
+void RtpMidi::Schedule(const uint8_t *pData, uint32_t nLength, uint32_t nTimestamp, const applemidi::SessionStatus& session) {
+	if ((m_nPlayoutLatencyMax == 0) || (nLength > rtpmidi::PLAYOUT_DATA_MAX)) {
+		if (m_nPlayoutCount != 0) {
+			PlayoutFlush();
+			DecodeMidi(pData, nLength);
+		}
+
+		m_tMidiMessage.nTimestamp = nTimestamp;
+		Dispatch();
+		return;
+	}
+
+	const auto nJitter = std::min(4U * (session.nJitter >> 4), m_nPlayoutLatencyMax);
+	const auto nDue = nTimestamp - static_cast<uint32_t>(session.nClockOffset) + static_cast<uint32_t>(session.nTransitAverage) + nJitter;
+	const auto nNow = Now();
+	const auto nDelay = static_cast<int32_t>(nDue - nNow);
+
+	if ((nDelay <= 0) && (m_nPlayoutCount == 0)) {
+		m_tMidiMessage.nTimestamp = nTimestamp;
+		Dispatch();
+		return;
+	}
+
+	if (m_nPlayoutCount == rtpmidi::PLAYOUT_ENTRIES) {
+		PlayoutRun();
+
+		if (m_nPlayoutCount == rtpmidi::PLAYOUT_ENTRIES) {
+			auto& entry = m_PlayoutEntries[m_nPlayoutHead];
+			DecodeMidi(entry.aData, entry.nLength);
+			m_tMidiMessage.nTimestamp = entry.nTimestamp;
+			m_nPlayoutHead = (m_nPlayoutHead + 1) & (rtpmidi::PLAYOUT_ENTRIES - 1);
+			m_nPlayoutCount--;
+			Dispatch();
+		}
+	}
+
+	auto nPlayoutDue = nNow + std::min(static_cast<uint32_t>(std::max(nDelay, 0)), m_nPlayoutLatencyMax);
+
+	if (m_nPlayoutCount != 0) {
+		const auto& tail = m_PlayoutEntries[(m_nPlayoutHead + m_nPlayoutCount - 1) & (rtpmidi::PLAYOUT_ENTRIES - 1)];
+
+		if (static_cast<int32_t>(nPlayoutDue - tail.nDue) < 0) {
+			nPlayoutDue = tail.nDue;
+		}
+	}
+
+	auto& entry = m_PlayoutEntries[(m_nPlayoutHead + m_nPlayoutCount) & (rtpmidi::PLAYOUT_ENTRIES - 1)];
+	entry.nDue = nPlayoutDue;
+	entry.nTimestamp = nTimestamp;
+	entry.nLength = static_cast<uint8_t>(nLength);
+	memcpy(entry.aData, pData, nLength);
+
+	m_nPlayoutCount++;
+}
+
+void RtpMidi::PlayoutRun() {
+	const auto nNow = Now();
+
+	while (m_nPlayoutCount != 0) {
+		const auto& entry = m_PlayoutEntries[m_nPlayoutHead];
+
+		if (static_cast<int32_t>(nNow - entry.nDue) < 0) {
+			return;
+		}
+
+		DecodeMidi(entry.aData, entry.nLength);
+		m_tMidiMessage.nTimestamp = entry.nTimestamp;
+
+		m_nPlayoutHead = (m_nPlayoutHead + 1) & (rtpmidi::PLAYOUT_ENTRIES - 1);
+		m_nPlayoutCount--;
+
+		Dispatch();
+	}
+}
+
+void RtpMidi::PlayoutFlush() {
+	while (m_nPlayoutCount != 0) {
+		const auto& entry = m_PlayoutEntries[m_nPlayoutHead];
+
+		DecodeMidi(entry.aData, entry.nLength);
+		m_tMidiMessage.nTimestamp = entry.nTimestamp;
+
+		m_nPlayoutHead = (m_nPlayoutHead + 1) & (rtpmidi::PLAYOUT_ENTRIES - 1);
+		m_nPlayoutCount--;
+
+		Dispatch();
+	}
+}
+
+/*
+ * RFC 6295 recovery journal, applied when packets were lost.
+ * The system journal is skipped. For each channel journal the
+ * chapters P (program), C (controllers), W (pitch wheel) and N (notes) are replayed.
+ */
+
+void RtpMidi::RecoverMessage(uint8_t nStatus, uint8_t nData1, uint8_t nData2, uint32_t nTimestamp) {
+	const uint8_t aMessage[3] = { nStatus, nData1, nData2 };
+
+	if (DecodeMidi(aMessage, sizeof(aMessage)) > 0) {
+		m_tMidiMessage.nTimestamp = nTimestamp;
+		Dispatch();
+	}
+}
+
+void RtpMidi::RecoverChannel(const uint8_t *pChapters, uint32_t nLength, uint8_t nChannel, uint8_t nTableOfContents, uint32_t nTimestamp) {
+	DEBUG_PRINTF("nChannel=%u, nTableOfContents=%.2x", nChannel, nTableOfContents);
+
+	uint32_t nOffset = 0;
+
+	if (nTableOfContents & RTP_MIDI_CJ_CHAPTER_P) {
+		if (nOffset + 3 > nLength) {
+			return;
+		}
+
+		if (pChapters[nOffset + 1] & 0x80) {
+			RecoverMessage(static_cast<uint8_t>(0xB0 | nChannel), 0, pChapters[nOffset + 1] & 0x7F, nTimestamp);
+			RecoverMessage(static_cast<uint8_t>(0xB0 | nChannel), 32, pChapters[nOffset + 2] & 0x7F, nTimestamp);
+		}
+
+		RecoverMessage(static_cast<uint8_t>(0xC0 | nChannel), pChapters[nOffset] & 0x7F, 0, nTimestamp);
+		nOffset += 3;
+	}
+
+	if (nTableOfContents & RTP_MIDI_CJ_CHAPTER_C) {
+		if (nOffset + 1 > nLength) {
+			return;
+		}
+
+		const auto nEntries = static_cast<uint32_t>(pChapters[nOffset] & 0x7F) + 1;
+		nOffset++;
+
+		if (nOffset + 2 * nEntries > nLength) {
+			return;
+		}
+
+		for (uint32_t i = 0; i < nEntries; i++, nOffset += 2) {
+			// Only the value format (A = 0) is replayed
+			if ((pChapters[nOffset + 1] & 0x80) == 0) {
+				RecoverMessage(static_cast<uint8_t>(0xB0 | nChannel), pChapters[nOffset] & 0x7F, pChapters[nOffset + 1], nTimestamp);
+			}
+		}
+	}
+
+	if (nTableOfContents & RTP_MIDI_CJ_CHAPTER_M) {
+		if (nOffset + 2 > nLength) {
+			return;
+		}
+
+		const auto nChapterLength = static_cast<uint32_t>(((pChapters[nOffset] & 0x03) << 8) | pChapters[nOffset + 1]);
+
+		if (nChapterLength < 2) {
+			return;
+		}
+
+		nOffset += nChapterLength;
+	}
+
+	if (nTableOfContents & RTP_MIDI_CJ_CHAPTER_W) {
+		if (nOffset + 2 > nLength) {
+			return;
+		}
+
+		RecoverMessage(static_cast<uint8_t>(0xE0 | nChannel), pChapters[nOffset] & 0x7F, pChapters[nOffset + 1] & 0x7F, nTimestamp);
+		nOffset += 2;
+	}
+
+	if (nTableOfContents & RTP_MIDI_CJ_CHAPTER_N) {
+		if (nOffset + 2 > nLength) {
+			return;
+		}
+
+		auto nLogs = static_cast<uint32_t>(pChapters[nOffset] & 0x7F);
+		const auto nLow = static_cast<uint32_t>(pChapters[nOffset + 1] >> 4);
+		const auto nHigh = static_cast<uint32_t>(pChapters[nOffset + 1] & 0x0F);
+		nOffset += 2;
+
+		if ((nLogs == 127) && (nLow == 15) && (nHigh == 0)) {
+			nLogs = 128;
+		}
+
+		if (nOffset + 2 * nLogs > nLength) {
+			return;
+		}
+
+		for (uint32_t i = 0; i < nLogs; i++, nOffset += 2) {
+			const auto nVelocity = static_cast<uint8_t>(pChapters[nOffset + 1] & 0x7F);
+			// Y = 1 : the note should still be played
+			if ((pChapters[nOffset + 1] & 0x80) && (nVelocity != 0)) {
+				RecoverMessage(static_cast<uint8_t>(0x90 | nChannel), pChapters[nOffset] & 0x7F, nVelocity, nTimestamp);
+			}
+		}
+
+		for (auto nOctet = nLow; (nOctet <= nHigh) && (nOffset < nLength); nOctet++, nOffset++) {
+			const auto nBits = pChapters[nOffset];
+
+			for (uint32_t nBit = 0; nBit < 8; nBit++) {
+				if (nBits & (0x80U >> nBit)) {
+					RecoverMessage(static_cast<uint8_t>(0x80 | nChannel), static_cast<uint8_t>(nOctet * 8 + nBit), 0, nTimestamp);
+				}
+			}
+		}
+	}
+}
+
+void RtpMidi::Recover(const uint8_t *pJournal, uint32_t nLength, uint32_t nTimestamp) {
+	DEBUG_ENTRY
+
+	if (nLength < 3) {
+		DEBUG_EXIT
+		return;
+	}
+
+	// The journal holds the state before this packet, pending messages are older
+	PlayoutFlush();
+
+	const auto nHeader = pJournal[0];
+	uint32_t nOffset = 3;
+
+	if (nHeader & RTP_MIDI_JS_FLAG_Y) {
+		if (nOffset + 2 > nLength) {
+			DEBUG_EXIT
+			return;
+		}
+
+		nOffset += static_cast<uint32_t>(((pJournal[nOffset] & 0x03) << 8) | pJournal[nOffset + 1]);
+	}
+
+	if ((nHeader & RTP_MIDI_JS_FLAG_A) == 0) {
+		DEBUG_EXIT
+		return;
+	}
+
+	auto nChannels = static_cast<uint32_t>(nHeader & RTP_MIDI_JS_MASK_TOTCHAN) + 1;
+
+	while ((nChannels-- != 0) && (nOffset + 3 <= nLength)) {
+		const auto *pChannel = &pJournal[nOffset];
+		const auto nChannel = static_cast<uint8_t>((pChannel[0] >> 3) & 0x0F);
+		const auto nChannelLength = static_cast<uint32_t>(((pChannel[0] & 0x03) << 8) | pChannel[1]);
+
+		if ((nChannelLength < 3) || (nOffset + nChannelLength > nLength)) {
+			break;
+		}
+
+		RecoverChannel(&pChannel[3], nChannelLength - 3, nChannel, pChannel[2], nTimestamp);
+
+		nOffset += nChannelLength;
 	}
 
 	DEBUG_EXIT
-	return nSize;
 }
 
-void RtpMidi::HandleRtpMidi(const uint8_t *pBuffer) {
+void RtpMidi::HandleRtpMidi(const uint8_t *pBuffer, uint32_t nLength, const applemidi::SessionStatus& session, bool bPacketLoss) {
 	DEBUG_ENTRY
 
-	m_pReceiveBuffer = const_cast<uint8_t *>(pBuffer);
+	if (nLength <= rtpmidi::COMMAND_OFFSET) {
+		DEBUG_EXIT
+		return;
+	}
 
-	const auto nFlags = m_pReceiveBuffer[rtpmidi::COMMAND_OFFSET];
+	const auto *pHeader = reinterpret_cast<const rtpmidi::Header *>(pBuffer);
+	const auto nTimestamp = __builtin_bswap32(pHeader->nTimestamp);
+	const auto nFlags = pBuffer[rtpmidi::COMMAND_OFFSET];
 
-	int32_t nCommandLength = nFlags & RTP_MIDI_CS_MASK_SHORTLEN;
-	int32_t nOffset;
+	uint32_t nCommandLength = nFlags & RTP_MIDI_CS_MASK_SHORTLEN;
+	uint32_t nOffset;
 
 	if (nFlags & RTP_MIDI_CS_FLAG_B) {
-		const auto nOctet = m_pReceiveBuffer[rtpmidi::COMMAND_OFFSET + 1];
-		nCommandLength = (nCommandLength << 8) | nOctet;
+		if (nLength < rtpmidi::COMMAND_OFFSET + 2) {
+			DEBUG_EXIT
+			return;
+		}
+
+		nCommandLength = (nCommandLength << 8) | pBuffer[rtpmidi::COMMAND_OFFSET + 1];
 		nOffset = rtpmidi::COMMAND_OFFSET + 2;
 	} else {
 		nOffset = rtpmidi::COMMAND_OFFSET + 1;
 	}
 
-	DEBUG_PRINTF("nCommandLength=%d, nOffset=%d", nCommandLength, nOffset);
+	DEBUG_PRINTF("nCommandLength=%u, nOffset=%u, bPacketLoss=%d", nCommandLength, nOffset, bPacketLoss);
+
+	if (nOffset + nCommandLength > nLength) {
+		DEBUG_EXIT
+		return;
+	}
+
+	if (bPacketLoss && (nFlags & RTP_MIDI_CS_FLAG_J)) {
+		Recover(&pBuffer[nOffset + nCommandLength], nLength - nOffset - nCommandLength, nTimestamp);
+	}
 
-	debug_dump(&m_pReceiveBuffer[nOffset], static_cast<uint16_t>(nCommandLength));
+	debug_dump(&pBuffer[nOffset], static_cast<uint16_t>(nCommandLength));
 
+	const auto *pData = &pBuffer[nOffset];
+	uint32_t nDeltaTime = 0;
 	uint32_t nCommandCount = 0;
 
+	m_nRunningStatus = 0;
+
 	while (nCommandLength != 0) {
 
 		if ((nCommandCount != 0) || (nFlags & RTP_MIDI_CS_FLAG_Z)) {
-			int32_t nSize = DecodeTime(static_cast<uint32_t>(nCommandLength), static_cast<uint32_t>(nOffset));
+			uint32_t nDelta;
+			const auto nSize = DecodeTime(pData, nCommandLength, nDelta);
 
 			if (nSize < 0) {
+				DEBUG_EXIT
 				return;
 			}
 
-			nOffset += nSize;
-			nCommandLength -= nSize;
+			nDeltaTime += nDelta;
+			pData += nSize;
+			nCommandLength -= static_cast<uint32_t>(nSize);
+
+			if (nCommandLength == 0) {
+				break;
+			}
 		}
 
-		if (nCommandLength != 0) {
-			int32_t nSize = DecodeMidi(static_cast<uint32_t>(nCommandLength), static_cast<uint32_t>(nOffset));
+		const auto *pMessage = pData;
+		uint32_t nMessageLength = nCommandLength;
+		uint32_t nStatusOmitted = 0;
+		uint8_t aMessage[3];
 
-			if (nSize < 0) {
+		if (pData[0] < RTP_MIDI_COMMAND_STATUS_FLAG) {
+			// Running status
+			if (m_nRunningStatus == 0) {
+				DEBUG_EXIT
 				return;
 			}
 
-			nOffset += nSize;
-			nCommandLength -= nSize;
-			nCommandCount++;
+			aMessage[0] = m_nRunningStatus;
+			aMessage[1] = pData[0];
+			aMessage[2] = (nCommandLength > 1) ? pData[1] : 0;
+
+			pMessage = aMessage;
+			nMessageLength = std::min(nCommandLength + 1, static_cast<uint32_t>(sizeof(aMessage)));
+			nStatusOmitted = 1;
+		}
+
+		const auto nSize = DecodeMidi(pMessage, nMessageLength);
+
+		if (nSize <= static_cast<int32_t>(nStatusOmitted)) {
+			DEBUG_EXIT
+			return;
 		}
+
+		if (pMessage[0] < 0xF0) {
+			m_nRunningStatus = pMessage[0];
+		} else if (pMessage[0] < 0xF8) {
+			m_nRunningStatus = 0;
+		}
+
+		Schedule(pMessage, static_cast<uint32_t>(nSize), nTimestamp + nDeltaTime, session);
+
+		pData += static_cast<uint32_t>(nSize) - nStatusOmitted;
+		nCommandLength -= static_cast<uint32_t>(nSize) - nStatusOmitted;
+		nCommandCount++;
 	}
 
 	DEBUG_EXIT
@@ -15,7 +15,7 @@ ifneq ($(MAKE_FLAGS),)
 		endif
 	endif
 	ifndef COND
-		EXTRA_SRCDIR+=src/apps/mdns src/apps/ntp src/apps/tftp
+		EXTRA_SRCDIR+=src/apps/mdns src/apps/ntp src/apps/ptp src/apps/tftp
 		EXTRA_SRCDIR+=src/emac src/net src/emac/phy
 		EXTRA_SRCDIR+=src/params 
 		ifeq ($(findstring ENABLE_PHY_SWITCH,$(MAKE_FLAGS)), ENABLE_PHY_SWITCH)
@@ -39,7 +39,7 @@ ifneq ($(MAKE_FLAGS),)
 		endif
 	endif
 else
-	EXTRA_SRCDIR+=src/apps/mdns src/apps/ntp src/apps/tftp
+	EXTRA_SRCDIR+=src/apps/mdns src/apps/ntp src/apps/ptp src/apps/tftp
 	EXTRA_SRCDIR+=src/emac src/net
 	EXTRA_SRCDIR+=src/emac/phy
 	EXTRA_SRCDIR+=src/emac/phy/dp83848 src/emac/phy/lan8700 src/emac/phy/phygen src/emac/phy/rtl8201f
@@ -29,15 +29,20 @@
 #if defined (BARE_METAL)
 # if defined (H3)
 #  define MDNS_SERVICE_RECORDS_MAX	8
+#  define MDNS_SERVICE_INSTANCES_MAX	16
 # elif defined (GD32)
 #  if !defined(MDNS_SERVICE_RECORDS_MAX)
 #   define MDNS_SERVICE_RECORDS_MAX	2
 #  endif
+#  if !defined(MDNS_SERVICE_INSTANCES_MAX)
+#   define MDNS_SERVICE_INSTANCES_MAX	4
+#  endif
 # else
 #  error
 # endif
 #else
 # define MDNS_SERVICE_RECORDS_MAX	8
+# define MDNS_SERVICE_INSTANCES_MAX	16
 #endif
 
 #if !defined (MDNS_SERVICE_RECORDS_MAX)
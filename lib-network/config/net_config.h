@@ -27,8 +27,16 @@
 #define NET_CONFIG_H_
 
 #if defined (BARE_METAL)
-# define TCP_MAX_PORTS_ALLOWED			1
 # if defined (H3)
+#  if !defined (TCP_MAX_PORTS_ALLOWED)
+#   define TCP_MAX_PORTS_ALLOWED		4
+#  endif
+#  if !defined (TCP_RX_MAX_ENTRIES)
+#   define TCP_RX_MAX_ENTRIES			4	/* Segments per connection, power of 2 */
+#  endif
+#  if !defined (TCP_TX_BUFFER_SIZE)
+#   define TCP_TX_BUFFER_SIZE			4096	/* Bytes per connection, power of 2 */
+#  endif
 #  if !defined(HOST_NAME_PREFIX)
 #   define HOST_NAME_PREFIX				"allwinner_"
 #  endif
@@ -49,8 +57,47 @@
 #  if !defined (IGMP_MAX_JOINS_ALLOWED)
 #   define IGMP_MAX_JOINS_ALLOWED		(4 + (8 * 4)) /* 8 outputs x 4 Universes */
 #  endif
-#  if !defined (TCP_MAX_TCBS_ALLOWED)
-#   define TCP_MAX_TCBS_ALLOWED			6
+/*
+ * TCP RAM per connection: the TCB 128 bytes, the receive ring 4 + TCP_RX_MAX_ENTRIES x 1442 bytes
+ * and the transmit ring TCP_TX_BUFFER_SIZE bytes. The transmit frame adds 1494 bytes.
+ * tcp.cpp checks the total against TCP_RAM_SIZE_MAX.
+ */
+#  if !defined (TCP_MAX_PORTS_ALLOWED)
+#   define TCP_MAX_PORTS_ALLOWED		1
+#  endif
+#  if defined (GD32F207RG) || defined (GD32F4XX)
+/*
+ * In the .network section: 6 connections, 31888 bytes
+ */
+#   if !defined (TCP_MAX_TCBS_ALLOWED)
+#    define TCP_MAX_TCBS_ALLOWED		6
+#   endif
+#   if !defined (TCP_RX_MAX_ENTRIES)
+#    define TCP_RX_MAX_ENTRIES			2
+#   endif
+#   if !defined (TCP_TX_BUFFER_SIZE)
+#    define TCP_TX_BUFFER_SIZE			2048
+#   endif
+#   if !defined (TCP_RAM_SIZE_MAX)
+#    define TCP_RAM_SIZE_MAX			(32 * 1024)
+#   endif
+#  else
+/*
+ * In the main RAM: 2 connections, 5676 bytes. The receive queue shared by
+ * the connections was 4872 bytes, the transmit ring is for the retransmission.
+ */
+#   if !defined (TCP_MAX_TCBS_ALLOWED)
+#    define TCP_MAX_TCBS_ALLOWED		2
+#   endif
+#   if !defined (TCP_RX_MAX_ENTRIES)
+#    define TCP_RX_MAX_ENTRIES			1
+#   endif
+#   if !defined (TCP_TX_BUFFER_SIZE)
+#    define TCP_TX_BUFFER_SIZE			512
+#   endif
+#   if !defined (TCP_RAM_SIZE_MAX)
+#    define TCP_RAM_SIZE_MAX			(6 * 1024)
+#   endif
 #  endif
 # else
 #  error
@@ -60,6 +107,8 @@
 #  define IGMP_MAX_JOINS_ALLOWED		(4 + (8 * 4)) /* 8 outputs x 4 Universes */
 #  define TCP_MAX_TCBS_ALLOWED			16
 # define TCP_MAX_PORTS_ALLOWED			2
+# define TCP_RX_MAX_ENTRIES				4
+# define TCP_TX_BUFFER_SIZE				4096
 #endif
 
 #if !defined (UDP_MAX_PORTS_ALLOWED)
@@ -78,4 +127,12 @@
 # error
 #endif
 
+#if !defined (TCP_RX_MAX_ENTRIES)
+# error
+#endif
+
+#if !defined (TCP_TX_BUFFER_SIZE)
+# error
+#endif
+
 #endif /* NET_CONFIG_H_ */
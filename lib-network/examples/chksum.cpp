@@ -0,0 +1,213 @@
+/**
+ * @file chksum.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The Internet checksum of the bare-metal stack against the reference
+ * (the 16-bit word at a time implementation).
+ * - Fuzz: random data, length and alignment; a sum continued over two parts;
+ *   RFC 1624 updates of a 16-bit and a 32-bit field; the precomputed IPv4 header sum.
+ * - Benchmark: ns per checksum for the IPv4 header and typical payloads.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+#include "net_chksum.h"
+#include "net_packets.h"
+
+static uint16_t reference_chksum(const void *data, uint32_t len) {
+	auto *ptr = reinterpret_cast<const uint8_t *>(data);
+	uint32_t sum = 0;
+
+	while (len > 1) {
+		uint16_t word;
+		memcpy(&word, ptr, 2);
+		sum += word;
+		ptr += 2;
+		len -= 2;
+	}
+
+	if (len > 0) {
+		sum += *ptr;
+	}
+
+	while (sum >> 16) {
+		sum = (sum >> 16) + (sum & 0xFFFF);
+	}
+
+	return static_cast<uint16_t>(~sum);
+}
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nIteration) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s iteration %u\n", pTest, nIteration);
+		}
+	}
+}
+
+template<typename F>
+static double bench(F f, uint32_t nCount) {
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		f(i);
+	}
+
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) / nCount;
+}
+
+int main(int argc, char **argv) {
+	const uint32_t nIterations = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+
+	std::mt19937 rng(20240601);
+	alignas(8) static uint8_t buffer[2048];
+
+	/*
+	 * Fuzz
+	 */
+
+	for (uint32_t i = 0; i < nIterations; i++) {
+		const auto nOffset = rng() % 8;
+		const auto nLength = rng() % 1600;
+		auto *pData = &buffer[nOffset];
+
+		// Also the corner cases: all zero and all one
+		const auto nFill = rng() % 16;
+
+		for (uint32_t j = 0; j < nLength; j++) {
+			pData[j] = (nFill == 0) ? 0x00 : ((nFill == 1) ? 0xFF : static_cast<uint8_t>(rng()));
+		}
+
+		const auto nReference = reference_chksum(pData, nLength);
+
+		check(net_chksum(pData, nLength) == nReference, "net_chksum", i);
+
+		// A sum continued over two parts
+		const auto nSplit = (nLength == 0) ? 0 : (rng() % nLength) & ~1U;
+		const auto nSum = net_chksum_add(pData, nSplit, 0);
+		check(net_chksum_fold(net_chksum_add(pData + nSplit, nLength - nSplit, nSum)) == nReference, "net_chksum_add", i);
+
+		// RFC 1624 update of a 16-bit field, and of a 32-bit field
+		if (nLength >= 8) {
+			const auto nField = (rng() % ((nLength - 4) / 2)) * 2;
+			uint16_t nOld16, nNew16;
+			memcpy(&nOld16, &pData[nField], 2);
+			nNew16 = (nFill == 0) ? 0xFFFF : static_cast<uint16_t>(rng());
+			memcpy(&pData[nField], &nNew16, 2);
+			const auto nUpdated = net_chksum_update16(nReference, nOld16, nNew16);
+			const auto nRecomputed = reference_chksum(pData, nLength);
+			// 0x0000 and 0xFFFF are the same in one's complement
+			check((nUpdated == nRecomputed) || ((nUpdated ^ nRecomputed) == 0xFFFF), "net_chksum_update16", i);
+
+			uint32_t nOld32, nNew32;
+			memcpy(&nOld32, &pData[nField], 4);
+			nNew32 = static_cast<uint32_t>(rng());
+			memcpy(&pData[nField], &nNew32, 4);
+			const auto nUpdated32 = net_chksum_update32(nRecomputed, nOld32, nNew32);
+			const auto nRecomputed32 = reference_chksum(pData, nLength);
+			check((nUpdated32 == nRecomputed32) || ((nUpdated32 ^ nRecomputed32) == 0xFFFF), "net_chksum_update32", i);
+		}
+	}
+
+	// The precomputed IPv4 header sum, as in udp_prepare
+	uint32_t nZeroChecksums = 0;
+
+	for (uint32_t i = 0; i < nIterations; i++) {
+		struct ip4_header ip4;
+		ip4.ver_ihl = 0x45;
+		ip4.tos = 0;
+		ip4.flags_froff = __builtin_bswap16(IPv4_FLAG_DF);
+		ip4.ttl = 64;
+		ip4.proto = IPv4_PROTO_UDP;
+		const auto nSrc = static_cast<uint32_t>(rng());
+		memcpy(ip4.src, &nSrc, 4);
+
+		auto fixed = ip4;
+		fixed.len = 0;
+		fixed.id = 0;
+		fixed.chksum = 0;
+		memset(fixed.dst, 0, 4);
+		const auto nHeaderSum = net_chksum_add(&fixed, sizeof(struct ip4_header), 0);
+
+		ip4.id = static_cast<uint16_t>(rng());
+		ip4.len = __builtin_bswap16(static_cast<uint16_t>(28 + (rng() % 1472)));
+		const auto nDst = static_cast<uint32_t>(rng());
+		memcpy(ip4.dst, &nDst, 4);
+		ip4.chksum = 0;
+
+		const auto nReference = reference_chksum(&ip4, sizeof(struct ip4_header));
+		ip4.chksum = net_chksum_fold(net_chksum_add32(nHeaderSum + ip4.id + ip4.len, nDst));
+
+		check(ip4.chksum == nReference, "IPv4 header sum", i);
+		check(reference_chksum(&ip4, sizeof(struct ip4_header)) == 0, "IPv4 header verify", i);
+
+		nZeroChecksums += (ip4.chksum == 0);
+	}
+
+	printf("Fuzz: %u iterations, %u errors (%u IPv4 headers with checksum 0)\n", nIterations, s_nErrors, nZeroChecksums);
+
+	/*
+	 * Benchmark
+	 */
+
+	static constexpr uint32_t COUNT = 2000000;
+	static constexpr uint32_t LENGTHS[] = { 20, 64, 530, 638, 1472 };	// IPv4 header, -, ArtDmx, sACN, maximum UDP
+	uint32_t nSink = 0;
+
+	for (uint32_t j = 0; j < 1500; j++) {
+		buffer[j] = static_cast<uint8_t>(rng());
+	}
+
+	puts("Length    reference  net_chksum  (ns, IPv4 header 16-bit aligned)");
+
+	for (const auto nLength : LENGTHS) {
+		auto *pData = &buffer[14];
+		const auto fReference = bench([&](uint32_t i) { buffer[15] = static_cast<uint8_t>(i); nSink += reference_chksum(pData, nLength); }, COUNT);
+		const auto fNew = bench([&](uint32_t i) { buffer[15] = static_cast<uint8_t>(i); nSink += net_chksum(pData, nLength); }, COUNT);
+		printf("%6u    %9.1f  %10.1f   x%.1f\n", nLength, fReference, fNew, fReference / fNew);
+	}
+
+	uint16_t nChecksum = reference_chksum(&buffer[14], 20);
+	const auto fUpdate = bench([&](uint32_t i) {
+		uint16_t nOld;
+		memcpy(&nOld, &buffer[18], 2);
+		const auto nNew = static_cast<uint16_t>(i);
+		memcpy(&buffer[18], &nNew, 2);
+		nChecksum = net_chksum_update16(nChecksum, nOld, nNew);
+	}, COUNT);
+	nSink += nChecksum;
+
+	printf("IPv4 id changed, RFC 1624 update: %.1f ns (%x)\n", fUpdate, nSink);
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
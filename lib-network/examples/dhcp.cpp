@@ -0,0 +1,678 @@
+/**
+ * @file dhcp.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The bare-metal DHCP client on Linux, with a stand-in for the UDP layer and
+ * a DHCP server. The time is simulated, dhcp_client_timer runs every 10 ms.
+ *
+ * - Cold boot (INIT) against the fast reboot with the stored lease (INIT-REBOOT):
+ *   messages on the wire and the time to the BOUND event.
+ * - INIT-REBOOT on another network (NAK), and without an answer: back to INIT.
+ * - Renewing at T1 (unicast), rebinding at T2 (broadcast), expiry of the lease.
+ * - No server: the FAILED event, the retry, then a late server.
+ * - The spread of the first DISCOVER of 200 nodes powered on together.
+ * - Replies which are not for us, and random data, are ignored.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "net.h"
+#include "net_private.h"
+#include "hardware.h"
+
+namespace net {
+namespace globals {
+struct IpInfo ipInfo;
+uint8_t macAddress[ETH_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x12, 0x34, 0x56 };
+}  // namespace globals
+}  // namespace net
+
+/*
+ * The simulated time
+ */
+
+static uint32_t s_nMillis = 100000;
+
+Hardware *Hardware::s_pThis;
+
+Hardware::Hardware() {
+	s_pThis = this;
+}
+
+uint32_t Hardware::Millis() {
+	return s_nMillis;
+}
+
+uint32_t Hardware::Micros() {
+	return s_nMillis * 1000;
+}
+
+int console_error(const char *p) {
+	return printf("%s", p);
+}
+
+/*
+ * The DHCP message, the offsets of RFC 2131
+ */
+
+static constexpr uint32_t OFFSET_OP = 0;
+static constexpr uint32_t OFFSET_XID = 4;
+static constexpr uint32_t OFFSET_CIADDR = 12;
+static constexpr uint32_t OFFSET_YIADDR = 16;
+static constexpr uint32_t OFFSET_CHADDR = 28;
+static constexpr uint32_t OFFSET_COOKIE = 236;
+static constexpr uint32_t OFFSET_OPTIONS = 240;
+
+static constexpr uint8_t TYPE_DISCOVER = 1;
+static constexpr uint8_t TYPE_OFFER = 2;
+static constexpr uint8_t TYPE_REQUEST = 3;
+static constexpr uint8_t TYPE_ACK = 5;
+static constexpr uint8_t TYPE_NAK = 6;
+static constexpr uint8_t TYPE_RELEASE = 7;
+
+static constexpr uint32_t ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+	return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+	uint32_t n;
+	memcpy(&n, p, 4);
+	return n;
+}
+
+struct Request {
+	uint8_t nType;
+	uint32_t nXid;
+	uint32_t nClientIp;
+	uint32_t nRequestedIp;
+	uint32_t nServerId;
+	uint32_t nToIp;
+	bool hasHostname;
+	bool hasClientId;
+	uint8_t chaddr[ETH_ADDR_LEN];
+};
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest) {
+	if (!isOk) {
+		if (s_nErrors++ < 20) {
+			printf("FAIL %s\n", pTest);
+		}
+	}
+}
+
+static bool parse_request(const uint8_t *pData, uint32_t nSize, uint32_t nToIp, Request& request) {
+	memset(&request, 0, sizeof(Request));
+
+	if ((nSize < OFFSET_OPTIONS + 4) || (pData[OFFSET_OP] != 1) || (__builtin_bswap32(get_u32(&pData[OFFSET_COOKIE])) != 0x63825363)) {
+		return false;
+	}
+
+	request.nXid = get_u32(&pData[OFFSET_XID]);
+	request.nClientIp = get_u32(&pData[OFFSET_CIADDR]);
+	request.nToIp = nToIp;
+	memcpy(request.chaddr, &pData[OFFSET_CHADDR], ETH_ADDR_LEN);
+
+	for (uint32_t i = OFFSET_OPTIONS; i < nSize;) {
+		const auto nOption = pData[i];
+
+		if (nOption == 0) {
+			i++;
+			continue;
+		}
+
+		if (nOption == 255) {
+			return request.nType != 0;
+		}
+
+		if (i + 1 >= nSize) {
+			return false;
+		}
+
+		const auto nLength = pData[i + 1];
+		const auto *p = &pData[i + 2];
+
+		if (i + 2 + nLength > nSize) {
+			return false;
+		}
+
+		switch (nOption) {
+		case 53: request.nType = p[0]; break;
+		case 50: request.nRequestedIp = get_u32(p); break;
+		case 54: request.nServerId = get_u32(p); break;
+		case 12: request.hasHostname = true; break;
+		case 61: request.hasClientId = (nLength == 7) && (memcmp(&p[1], request.chaddr, ETH_ADDR_LEN) == 0); break;
+		default: break;
+		}
+
+		i += 2u + nLength;
+	}
+
+	return false;	// No END option
+}
+
+/*
+ * The DHCP server stand-in
+ */
+
+struct Server {
+	uint32_t nServerIp;
+	uint32_t nNetwork;
+	uint32_t nNextHost;
+	uint32_t nLeaseSeconds;
+	bool isDown;				///< Does not answer at all
+	bool isIgnoreUnicast;		///< Renewing has no answer, rebinding has
+	bool isIgnoreReboot;		///< INIT-REBOOT has no answer
+	uint8_t bindingMac[ETH_ADDR_LEN];
+	uint32_t nBindingIp;
+	uint32_t nReleased;
+};
+
+static Server s_server;
+
+struct Wire {
+	uint32_t nMessages;			///< Both directions
+	uint32_t nSent[8];			///< By type
+	uint32_t nUnicast;
+	Request last;
+	uint8_t reply[548];
+	uint32_t nReplySize;
+	bool hasReply;
+};
+
+static Wire s_wire;
+
+static void server_init(uint32_t nNetwork, uint32_t nLeaseSeconds) {
+	memset(&s_server, 0, sizeof(Server));
+	s_server.nNetwork = nNetwork;
+	s_server.nServerIp = nNetwork | ip(0, 0, 0, 1);
+	s_server.nNextHost = 100;
+	s_server.nLeaseSeconds = nLeaseSeconds;
+}
+
+static void server_reply(const Request& request, uint8_t nType, uint32_t nYourIp) {
+	auto *p = s_wire.reply;
+	memset(p, 0, sizeof(s_wire.reply));
+
+	p[OFFSET_OP] = 2;
+	p[1] = 1;
+	p[2] = ETH_ADDR_LEN;
+	memcpy(&p[OFFSET_XID], &request.nXid, 4);
+	memcpy(&p[OFFSET_YIADDR], &nYourIp, 4);
+	memcpy(&p[OFFSET_CHADDR], request.chaddr, ETH_ADDR_LEN);
+	const uint32_t nCookie = __builtin_bswap32(0x63825363);
+	memcpy(&p[OFFSET_COOKIE], &nCookie, 4);
+
+	auto i = OFFSET_OPTIONS;
+	auto option = [&](uint8_t nOption, uint32_t nValue) {
+		p[i++] = nOption;
+		p[i++] = 4;
+		memcpy(&p[i], &nValue, 4);
+		i += 4;
+	};
+
+	p[i++] = 53; p[i++] = 1; p[i++] = nType;
+	option(54, s_server.nServerIp);
+
+	if (nType != TYPE_NAK) {
+		option(1, ip(255, 255, 255, 0));
+		option(3, s_server.nServerIp);
+		option(51, __builtin_bswap32(s_server.nLeaseSeconds));
+	}
+
+	p[i++] = 0;		// A pad
+	p[i++] = 255;
+
+	s_wire.nReplySize = i;
+	s_wire.hasReply = true;
+	s_wire.nMessages++;
+}
+
+static bool is_on_network(uint32_t nIp) {
+	return (nIp & ip(255, 255, 255, 0)) == s_server.nNetwork;
+}
+
+static void server_handle(const Request& request) {
+	if (s_server.isDown) {
+		return;
+	}
+
+	const auto isUnicast = (request.nToIp != IP_BROADCAST);
+
+	if (isUnicast && (s_server.isIgnoreUnicast || (request.nToIp != s_server.nServerIp))) {
+		return;
+	}
+
+	const auto hasBinding = (memcmp(s_server.bindingMac, request.chaddr, ETH_ADDR_LEN) == 0) && (s_server.nBindingIp != 0);
+
+	switch (request.nType) {
+	case TYPE_DISCOVER: {
+		auto nIp = hasBinding ? s_server.nBindingIp : 0;
+
+		if ((nIp == 0) && is_on_network(request.nRequestedIp)) {
+			nIp = request.nRequestedIp;
+		}
+
+		if (nIp == 0) {
+			nIp = s_server.nNetwork | (s_server.nNextHost++ << 24);
+		}
+
+		server_reply(request, TYPE_OFFER, nIp);
+		break;
+	}
+	case TYPE_REQUEST:
+		if (request.nServerId != 0) {
+			// SELECTING
+			if (request.nServerId != s_server.nServerIp) {
+				return;
+			}
+			memcpy(s_server.bindingMac, request.chaddr, ETH_ADDR_LEN);
+			s_server.nBindingIp = request.nRequestedIp;
+			server_reply(request, TYPE_ACK, request.nRequestedIp);
+		} else if (request.nClientIp == 0) {
+			// INIT-REBOOT
+			if (s_server.isIgnoreReboot) {
+				return;
+			}
+			if (!is_on_network(request.nRequestedIp)) {
+				server_reply(request, TYPE_NAK, 0);
+				return;
+			}
+			memcpy(s_server.bindingMac, request.chaddr, ETH_ADDR_LEN);
+			s_server.nBindingIp = request.nRequestedIp;
+			server_reply(request, TYPE_ACK, request.nRequestedIp);
+		} else {
+			// RENEWING, REBINDING
+			if (!is_on_network(request.nClientIp)) {
+				server_reply(request, TYPE_NAK, 0);
+				return;
+			}
+			server_reply(request, TYPE_ACK, request.nClientIp);
+		}
+		break;
+	case TYPE_RELEASE:
+		s_server.nReleased = request.nClientIp;
+		s_server.nBindingIp = 0;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * The UDP stand-in
+ */
+
+int udp_begin(uint16_t nPort) {
+	check(nPort == 68, "udp_begin port");
+	return 0;
+}
+
+int udp_end(uint16_t) {
+	return 0;
+}
+
+int udp_send(int, const uint8_t *pData, uint16_t nSize, uint32_t nToIp, uint16_t nToPort) {
+	check(nToPort == 67, "udp_send port");
+
+	Request request;
+	const auto isValid = parse_request(pData, nSize, nToIp, request);
+	check(isValid, "request is valid");
+	check(request.hasClientId, "client identifier");
+
+	if (isValid) {
+		s_wire.nMessages++;
+		s_wire.nSent[request.nType & 7]++;
+		s_wire.nUnicast += (nToIp != IP_BROADCAST);
+		s_wire.last = request;
+
+		check((request.nType != TYPE_REQUEST) || request.hasHostname, "hostname in REQUEST");
+		check((nToIp == IP_BROADCAST) || (request.nClientIp != 0), "only a bound client sends unicast");
+
+		server_handle(request);
+	}
+
+	return 0;
+}
+
+static uint8_t s_received[548];
+
+uint16_t udp_recv2(int, const uint8_t **ppData, uint32_t *pFromIp, uint16_t *pFromPort) {
+	if (!s_wire.hasReply) {
+		return 0;
+	}
+
+	s_wire.hasReply = false;
+	memcpy(s_received, s_wire.reply, s_wire.nReplySize);
+	*ppData = s_received;
+	*pFromIp = s_server.nServerIp;
+	*pFromPort = 67;
+
+	return static_cast<uint16_t>(s_wire.nReplySize);
+}
+
+/*
+ * The network stand-in
+ */
+
+struct Events {
+	uint32_t nBound;
+	uint32_t nRenewed;
+	uint32_t nLost;
+	uint32_t nFailed;
+	uint32_t nBoundMillis;
+	uint32_t nLostMillis;
+	struct DhcpLease lease;
+};
+
+static Events s_events;
+
+void net_dhcp_event(const net::dhcp::Event event, const struct DhcpLease *pLease) {
+	switch (event) {
+	case net::dhcp::Event::BOUND:
+		s_events.nBound++;
+		s_events.nBoundMillis = s_nMillis;
+		net::globals::ipInfo.ip.addr = pLease->nIp;
+		break;
+	case net::dhcp::Event::RENEWED:
+		s_events.nRenewed++;
+		check(net::globals::ipInfo.ip.addr == pLease->nIp, "RENEWED keeps the address");
+		break;
+	case net::dhcp::Event::LOST:
+		s_events.nLost++;
+		s_events.nLostMillis = s_nMillis;
+		net::globals::ipInfo.ip.addr = 0;
+		break;
+	case net::dhcp::Event::FAILED:
+		s_events.nFailed++;
+		break;
+	default:
+		break;
+	}
+
+	memcpy(&s_events.lease, pLease, sizeof(struct DhcpLease));
+}
+
+static void run(uint32_t nMillis) {
+	for (uint32_t i = 0; i < nMillis; i += 10) {
+		s_nMillis += 10;
+		dhcp_client_timer();
+	}
+}
+
+static void start(const struct DhcpLease *pLease, uint32_t nRetrySeconds = 0) {
+	dhcp_client_stop();
+	memset(&s_events, 0, sizeof(Events));
+	memset(&s_wire, 0, sizeof(Wire));
+	net::globals::ipInfo.ip.addr = 0;
+	dhcp_client_start("node", pLease, nRetrySeconds);
+}
+
+int main() {
+	Hardware hw;
+
+	static constexpr uint32_t NETWORK = ip(192, 168, 2, 0);
+	static constexpr uint32_t RUNS = 100;
+
+	/*
+	 * Cold boot and fast reboot
+	 */
+
+	uint32_t nColdMillis = 0, nColdMessages = 0, nRebootMillis = 0, nRebootMessages = 0;
+	struct DhcpLease lease;
+
+	for (uint32_t i = 0; i < RUNS; i++) {
+		net::globals::macAddress[5] = static_cast<uint8_t>(i);
+		server_init(NETWORK, 3600);
+
+		const auto nStart = s_nMillis;
+		start(nullptr);
+		run(5000);
+
+		check(s_events.nBound == 1, "cold boot BOUND");
+		check(is_on_network(net::globals::ipInfo.ip.addr), "cold boot address");
+		check(dhcp_client_get_state() == net::dhcp::State::BOUND, "cold boot state");
+		nColdMillis += s_events.nBoundMillis - nStart;
+		nColdMessages += s_wire.nMessages;
+
+		// The network stores the lease, the node reboots
+		memcpy(&lease, &s_events.lease, sizeof(struct DhcpLease));
+		check(lease.nServerIp == s_server.nServerIp, "lease server");
+		check(lease.nLeaseTime == 3600, "lease time");
+
+		const auto nRebootStart = s_nMillis;
+		start(&lease);
+		run(1000);
+
+		check(s_events.nBound == 1, "reboot BOUND");
+		check(s_events.nRenewed == 0, "reboot is not RENEWED");
+		check(net::globals::ipInfo.ip.addr == lease.nIp, "reboot same address");
+		check(s_wire.nSent[TYPE_DISCOVER] == 0, "reboot without DISCOVER");
+		check(s_wire.last.nRequestedIp == lease.nIp, "reboot requested IP");
+		check(s_wire.last.nServerId == 0, "reboot without server identifier");
+		nRebootMillis += s_events.nBoundMillis - nRebootStart;
+		nRebootMessages += s_wire.nMessages;
+	}
+
+	printf("Cold boot (INIT)          : %2u messages, %4u ms to BOUND (average)\n", nColdMessages / RUNS, nColdMillis / RUNS);
+	printf("Fast reboot (INIT-REBOOT) : %2u messages, %4u ms to BOUND (average)\n", nRebootMessages / RUNS, nRebootMillis / RUNS);
+	check(nRebootMessages / RUNS == 2, "INIT-REBOOT is 2 messages");
+	check(nRebootMillis < nColdMillis, "INIT-REBOOT is faster");
+
+	/*
+	 * INIT-REBOOT on another network: NAK, then INIT
+	 */
+
+	server_init(ip(10, 0, 0, 0), 3600);
+	start(&lease);
+	run(5000);
+	check(s_wire.nSent[TYPE_DISCOVER] >= 1, "NAK then DISCOVER");
+	check(s_events.nBound == 1, "NAK then BOUND");
+	check(s_events.nLost == 0, "NAK on reboot is not LOST");
+	check(is_on_network(net::globals::ipInfo.ip.addr), "NAK then new address");
+	printf("INIT-REBOOT, other network: NAK, %u ms to BOUND on " IPSTR "\n", s_events.nBoundMillis - (s_nMillis - 5000), IP2STR(net::globals::ipInfo.ip.addr));
+
+	/*
+	 * INIT-REBOOT without an answer: INIT after 3 attempts
+	 */
+
+	server_init(NETWORK, 3600);
+	s_server.isIgnoreReboot = true;
+	start(&lease);
+	run(15000);
+	check(s_wire.nSent[TYPE_REQUEST] >= 4, "INIT-REBOOT retransmissions");
+	check(s_events.nBound == 1, "INIT-REBOOT no answer then BOUND");
+	printf("INIT-REBOOT, no answer   : %u REQUEST, then DISCOVER, BOUND " IPSTR "\n", s_wire.nSent[TYPE_REQUEST] - 1, IP2STR(net::globals::ipInfo.ip.addr));
+
+	/*
+	 * Renewing at T1, rebinding at T2, the lease expires
+	 */
+
+	server_init(NETWORK, 600);
+	start(nullptr);
+	run(5000);
+	check(s_events.nBound == 1, "lease BOUND");
+	const auto nBoundMillis = s_events.nBoundMillis;
+	memset(&s_wire.nSent, 0, sizeof(s_wire.nSent));
+	s_wire.nUnicast = 0;
+
+	run(299000 - (s_nMillis - nBoundMillis));
+	check(s_wire.nSent[TYPE_REQUEST] == 0, "no REQUEST before T1");
+	run(2000);
+	check(s_wire.nSent[TYPE_REQUEST] == 1, "REQUEST at T1");
+	check(s_wire.nUnicast == 1, "RENEWING is unicast");
+	check(s_wire.last.nClientIp == net::globals::ipInfo.ip.addr, "RENEWING ciaddr");
+	check(s_events.nRenewed == 1, "RENEWED");
+	check(s_events.nBound == 1, "RENEWED is not BOUND");
+
+	// The server does not answer unicast anymore: T1 300 s, T2 525 s after the renewal
+	s_server.isIgnoreUnicast = true;
+	const auto nRenewedMillis = s_nMillis;
+	memset(&s_wire.nSent, 0, sizeof(s_wire.nSent));
+	s_wire.nUnicast = 0;
+	run(520000);
+	check(s_wire.nUnicast >= 2, "RENEWING retransmission");
+	check(s_events.nRenewed == 1, "no answer on RENEWING");
+	run(530000 - (s_nMillis - nRenewedMillis));
+	check(s_events.nRenewed == 2, "REBINDING at T2");
+	check(s_wire.last.nToIp == IP_BROADCAST, "REBINDING is broadcast");
+	printf("Lease 600 s: renew at T1 300 s (unicast), %u unicast retransmissions, rebind at T2 525 s (broadcast)\n", s_wire.nUnicast - 1);
+
+	// The server is gone: the lease expires
+	s_server.isDown = true;
+	const auto nReboundMillis = s_nMillis;
+	run(600000 + 1000);
+	check(s_events.nLost == 1, "lease expired LOST");
+	check(net::globals::ipInfo.ip.addr == 0, "LOST no address");
+	check(dhcp_client_get_state() <= net::dhcp::State::REQUESTING, "LOST then INIT");
+	printf("Server gone: LOST after %u s, the lease expired\n", (s_events.nLostMillis - nReboundMillis) / 1000);
+
+	// And the server comes back, the previous address is offered again
+	const auto nPreviousIp = s_events.lease.nIp;
+	s_server.isDown = false;
+	s_server.nBindingIp = 0;
+	run(180000);
+	check(s_events.nBound == 2, "BOUND after LOST");
+	check(net::globals::ipInfo.ip.addr == nPreviousIp, "the previous address again");
+
+	// Release
+	dhcp_client_release();
+	check(s_server.nReleased == nPreviousIp, "RELEASE");
+	check(dhcp_client_get_state() == net::dhcp::State::OFF, "RELEASE then OFF");
+
+	/*
+	 * No server: FAILED, the retry, and a late server
+	 */
+
+	server_init(NETWORK, 3600);
+	s_server.isDown = true;
+	start(nullptr, 60);
+	run(60000);
+	check(s_events.nFailed == 1, "FAILED");
+	const auto nDiscovers = s_wire.nSent[TYPE_DISCOVER];
+	check(nDiscovers == 4, "FAILED after 4 DISCOVER");
+	printf("No server: FAILED after %u DISCOVER", nDiscovers);
+	s_server.isDown = false;
+	run(120000);
+	check(s_events.nBound == 1, "BOUND after the retry");
+	check(s_events.nFailed == 1, "FAILED once");
+	printf(", retry after 60 s: BOUND at %u s\n", (s_events.nBoundMillis - (s_nMillis - 180000)) / 1000);
+
+	start(nullptr, 0);
+	s_server.isDown = true;
+	run(120000);
+	check(dhcp_client_get_state() == net::dhcp::State::OFF, "no retry then OFF");
+
+	/*
+	 * The spread of 200 nodes powered on together
+	 */
+
+	static constexpr uint32_t NODES = 200;
+	uint32_t nBuckets[10] = {};
+	server_init(NETWORK, 3600);
+	s_server.isDown = true;
+
+	for (uint32_t i = 0; i < NODES; i++) {
+		net::globals::macAddress[4] = static_cast<uint8_t>(i >> 8);
+		net::globals::macAddress[5] = static_cast<uint8_t>(i);
+		s_nMillis += 7919;		// A different Micros() for the seed
+
+		start(nullptr);
+		uint32_t nMillis = 0;
+
+		while ((s_wire.nSent[TYPE_DISCOVER] == 0) && (nMillis < 2000)) {
+			run(10);
+			nMillis += 10;
+		}
+
+		check(nMillis <= 1010, "first DISCOVER within 1 s");
+		nBuckets[(nMillis / 100) < 10 ? (nMillis / 100) : 9]++;
+	}
+
+	uint32_t nMaxBucket = 0;
+	printf("First DISCOVER of %u nodes per 100 ms:", NODES);
+	for (const auto nBucket : nBuckets) {
+		printf(" %u", nBucket);
+		nMaxBucket = nBucket > nMaxBucket ? nBucket : nMaxBucket;
+	}
+	puts("");
+	check(nMaxBucket < NODES / 5, "spread of the first DISCOVER");
+
+	/*
+	 * Replies which are not for us, and random data
+	 */
+
+	server_init(NETWORK, 3600);
+	start(nullptr);
+	run(5000);
+	check(s_events.nBound == 1, "bound before fuzz");
+	const auto nBoundIp = net::globals::ipInfo.ip.addr;
+
+	uint32_t nRandom = 20240601;
+	auto rng = [&]() {
+		nRandom ^= nRandom << 13;
+		nRandom ^= nRandom >> 17;
+		nRandom ^= nRandom << 5;
+		return nRandom;
+	};
+
+	s_server.isDown = true;
+
+	for (uint32_t i = 0; i < 100000; i++) {
+		// A valid NAK with one error
+		Request request = s_wire.last;
+		server_reply(request, TYPE_NAK, 0);
+
+		switch (rng() % 4) {
+		case 0: s_wire.reply[OFFSET_XID] ^= 0x01; break;
+		case 1: s_wire.reply[OFFSET_CHADDR + 5] ^= 0x80; break;
+		case 2: s_wire.reply[OFFSET_OP] = 1; break;
+		default:
+			s_wire.nReplySize = rng() % sizeof(s_wire.reply);
+			for (uint32_t j = OFFSET_OPTIONS; j < s_wire.nReplySize; j++) {
+				s_wire.reply[j] = static_cast<uint8_t>(rng());
+			}
+			// Not a NAK anymore, but it must not be one either
+			s_wire.reply[OFFSET_OPTIONS] = 53;
+			s_wire.reply[OFFSET_OPTIONS + 1] = 1;
+			s_wire.reply[OFFSET_OPTIONS + 2] = TYPE_OFFER;
+			break;
+		}
+
+		dhcp_client_timer();
+	}
+
+	check(s_events.nLost == 0, "fuzz: no LOST");
+	check(net::globals::ipInfo.ip.addr == nBoundIp, "fuzz: address kept");
+	check(dhcp_client_get_state() == net::dhcp::State::BOUND, "fuzz: still BOUND");
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
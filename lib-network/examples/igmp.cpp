@@ -0,0 +1,453 @@
+/**
+ * @file igmp.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The bare-metal IGMP on Linux, with a stand-in for the EMAC.
+ * The stand-in checks every report which is sent, and models the multicast
+ * hash filter of the H3 and the GD32 EMAC.
+ *
+ * - The hash bins against the Linux stmmac reference, and a known vector.
+ * - The sACN universes 1..N are joined, the reports are checked.
+ * - The multicast traffic of 4 x N universes is passed through the hash filter
+ *   and igmp_is_member, as udp_handle does.
+ * - The state change records are retransmitted, not the current state (RFC 3376 5.1).
+ * - IGMPv3 General Query, Group-Specific Query, IGMPv2 fall back, source specific joins.
+ * - The cost of igmp_timer and igmp_is_member.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include "net.h"
+#include "net_private.h"
+
+namespace net {
+namespace globals {
+struct IpInfo ipInfo;
+uint8_t macAddress[ETH_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x12, 0x34, 0x56 };
+}  // namespace globals
+}  // namespace net
+
+static uint32_t s_nHashLow;
+static uint32_t s_nHashHigh;
+static uint32_t s_nHashSet;
+
+struct Sent {
+	uint32_t nPackets;
+	uint32_t nV2Reports;
+	uint32_t nV2Leaves;
+	uint32_t nV3Reports;
+	uint32_t nV3Records;
+	uint32_t nRecordTypes[7];
+	uint32_t nErrors;
+};
+
+static Sent s_sent;
+static constexpr uint32_t ROBUSTNESS = 2;	///< RFC 3376 8.1 Robustness Variable, as in igmp.cpp
+
+static uint32_t crc32_le(const uint8_t *pData, uint32_t nLength) {
+	uint32_t nCrc = 0xFFFFFFFF;
+
+	while (nLength-- != 0) {
+		nCrc ^= *pData++;
+
+		for (uint32_t i = 0; i < 8; i++) {
+			nCrc = (nCrc >> 1) ^ (0xEDB88320 & (0U - (nCrc & 1)));
+		}
+	}
+
+	return nCrc;
+}
+
+static uint32_t bitrev32(uint32_t n) {
+	uint32_t r = 0;
+
+	for (uint32_t i = 0; i < 32; i++) {
+		r = (r << 1) | ((n >> i) & 1);
+	}
+
+	return r;
+}
+
+static void multicast_mac(uint32_t nGroupAddress, uint8_t *pMac) {
+	pMac[0] = 0x01;
+	pMac[1] = 0x00;
+	pMac[2] = 0x5E;
+	pMac[3] = static_cast<uint8_t>((nGroupAddress >> 8) & 0x7F);
+	pMac[4] = static_cast<uint8_t>(nGroupAddress >> 16);
+	pMac[5] = static_cast<uint8_t>(nGroupAddress >> 24);
+}
+
+static uint32_t sacn_group(uint32_t nUniverse) {
+	return 239U | (255U << 8) | ((nUniverse >> 8) << 16) | ((nUniverse & 0xFF) << 24);
+}
+
+static uint32_t ip(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+	return a | (b << 8) | (c << 16) | (d << 24);
+}
+
+/*
+ * The stand-in for the EMAC
+ */
+
+extern "C" {
+int console_error(const char *s) {
+	return fputs(s, stderr);
+}
+
+void emac_multicast_hash_set(uint32_t nHashLow, uint32_t nHashHigh) {
+	s_nHashLow = nHashLow;
+	s_nHashHigh = nHashHigh;
+	s_nHashSet++;
+}
+
+void emac_eth_send(void *pPacket, int nLength) {
+	const auto *pFrame = reinterpret_cast<const uint8_t *>(pPacket);
+	const auto *pIp4 = reinterpret_cast<const struct ip4_header *>(pFrame + sizeof(struct ether_header));
+	const auto nHeaderLength = static_cast<uint32_t>(pIp4->ver_ihl & 0x0F) * 4;
+	const auto nIpLength = static_cast<uint32_t>(__builtin_bswap16(pIp4->len));
+	const auto *pIgmp = reinterpret_cast<const uint8_t *>(pIp4) + nHeaderLength;
+
+	s_sent.nPackets++;
+
+	if ((static_cast<uint32_t>(nLength) != sizeof(struct ether_header) + nIpLength) || (pIp4->proto != IPv4_PROTO_IGMP) || (pIp4->ttl != 1)) {
+		s_sent.nErrors++;
+		return;
+	}
+
+	if (net_chksum(pIp4, nHeaderLength) != 0) {
+		puts("IPv4 header checksum error");
+		s_sent.nErrors++;
+	}
+
+	if (net_chksum(pIgmp, nIpLength - nHeaderLength) != 0) {
+		puts("IGMP checksum error");
+		s_sent.nErrors++;
+	}
+
+	uint32_t nDestination;
+	memcpy(&nDestination, pIp4->dst, 4);
+	uint8_t mac[ETH_ADDR_LEN];
+	multicast_mac(nDestination, mac);
+
+	if (memcmp(mac, pFrame, ETH_ADDR_LEN) != 0) {
+		puts("Destination MAC error");
+		s_sent.nErrors++;
+	}
+
+	switch (pIgmp[0]) {
+	case IGMP_TYPE_REPORT:
+		s_sent.nV2Reports++;
+		break;
+	case IGMP_TYPE_LEAVE:
+		s_sent.nV2Leaves++;
+		break;
+	case IGMP_TYPE_V3_REPORT: {
+		s_sent.nV3Reports++;
+		const auto *pReport = reinterpret_cast<const struct t_igmp_v3_report *>(pIgmp);
+		const auto nRecords = __builtin_bswap16(pReport->number_of_records);
+		auto nOffset = static_cast<uint32_t>(sizeof(struct t_igmp_v3_report));
+
+		if (nDestination != ip(224, 0, 0, 22)) {
+			s_sent.nErrors++;
+		}
+
+		for (uint32_t i = 0; i < nRecords; i++) {
+			const auto *pRecord = reinterpret_cast<const struct t_igmp_v3_record *>(pIgmp + nOffset);
+
+			if ((pRecord->type == 0) || (pRecord->type > 6)) {
+				s_sent.nErrors++;
+				break;
+			}
+
+			s_sent.nRecordTypes[pRecord->type]++;
+			s_sent.nV3Records++;
+			nOffset += static_cast<uint32_t>(sizeof(struct t_igmp_v3_record)) + 4U * __builtin_bswap16(pRecord->number_of_sources);
+		}
+
+		if (nOffset != nIpLength - nHeaderLength) {
+			puts("IGMPv3 report length error");
+			s_sent.nErrors++;
+		}
+		break;
+	}
+	default:
+		s_sent.nErrors++;
+		break;
+	}
+}
+}
+
+/*
+ * Reference: Linux stmmac (dwmac1000 and sun8i), bitrev32(~crc32_le(~0, addr, 6)) >> 26
+ */
+static uint32_t reference_hash_bin(const uint8_t *pMac) {
+	return bitrev32(~crc32_le(pMac, 6)) >> 26;
+}
+
+static bool hash_filter_pass(uint32_t nGroupAddress) {
+	uint8_t mac[ETH_ADDR_LEN];
+	multicast_mac(nGroupAddress, mac);
+	const auto nBin = reference_hash_bin(mac);
+	return ((nBin < 32 ? s_nHashLow : s_nHashHigh) >> (nBin & 0x1F)) & 1;
+}
+
+/*
+ * A query from the querier, with the Router Alert option
+ */
+static void query(uint32_t nGroupAddress, uint8_t nMaxResponse, bool isV3) {
+	uint8_t buffer[sizeof(struct ether_header) + 24 + sizeof(struct t_igmp_v3_query)];
+	memset(buffer, 0, sizeof(buffer));
+
+	auto *pIp4 = reinterpret_cast<struct ip4_header *>(buffer + sizeof(struct ether_header));
+	auto *pQuery = reinterpret_cast<struct t_igmp_v3_query *>(buffer + sizeof(struct ether_header) + 24);
+	const auto nIgmpLength = isV3 ? sizeof(struct t_igmp_v3_query) : sizeof(struct t_igmp_packet);
+
+	pIp4->ver_ihl = 0x46;
+	pIp4->len = __builtin_bswap16(static_cast<uint16_t>(24 + nIgmpLength));
+	pIp4->proto = IPv4_PROTO_IGMP;
+	pIp4->ttl = 1;
+	pQuery->type = IGMP_TYPE_QUERY;
+	pQuery->max_resp_code = nMaxResponse;
+	memcpy(pQuery->group_address, &nGroupAddress, 4);
+
+	igmp_handle(reinterpret_cast<struct t_igmp *>(buffer));
+}
+
+static uint32_t run_timer(uint32_t nTicks) {
+	const auto nPackets = s_sent.nPackets;
+	uint32_t nLast = 0;
+
+	for (uint32_t i = 1; i <= nTicks; i++) {
+		const auto n = s_sent.nPackets;
+		igmp_timer();
+		if (s_sent.nPackets != n) {
+			nLast = i;
+		}
+	}
+
+	printf("  %u packets, last after %u.%u s\n", s_sent.nPackets - nPackets, nLast / 10, nLast % 10);
+	return s_sent.nPackets - nPackets;
+}
+
+static double nanos_since(std::chrono::steady_clock::time_point start, uint32_t nCount) {
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) / nCount;
+}
+
+int main(int argc, char **argv) {
+	uint32_t nUniverses = 512;
+
+	if (argc > 1) {
+		nUniverses = static_cast<uint32_t>(atoi(argv[1]));
+	}
+
+	if ((nUniverses == 0) || (nUniverses > 16384)) {
+		fprintf(stderr, "Usage: %s [universes 1..16384]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%u universes joined\n", nUniverses);
+
+	net::globals::ipInfo.ip.addr = ip(192, 168, 2, 120);
+
+	// The hash bins are checked against the Linux reference, and 239.255.0.1 (01:00:5e:7f:00:01) is bin 13
+	uint8_t mac[ETH_ADDR_LEN];
+	multicast_mac(ip(239, 255, 0, 1), mac);
+	auto isHashOk = (net_multicast_hash_bin(mac) == 13);
+	printf("239.255.0.1 bin %u\n", net_multicast_hash_bin(mac));
+
+	for (uint32_t nUniverse = 1; nUniverse <= 63999; nUniverse++) {
+		multicast_mac(sacn_group(nUniverse), mac);
+		isHashOk &= (net_multicast_hash_bin(mac) == reference_hash_bin(mac));
+	}
+
+	printf("Hash bins: %s\n", isHashOk ? "ok" : "FAIL");
+
+	igmp_init();
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t nUniverse = 1; nUniverse <= nUniverses; nUniverse++) {
+		igmp_join(sacn_group(nUniverse));
+	}
+
+	printf("Join: %.0f ns per group, %u reports (%u CHANGE_TO_EXCLUDE), hash set %u times\n", nanos_since(start, nUniverses), s_sent.nV3Reports, s_sent.nRecordTypes[IGMP_V3_CHANGE_TO_EXCLUDE], s_nHashSet);
+
+	puts("Join retransmission:");
+	const auto nChangeToExclude = s_sent.nRecordTypes[IGMP_V3_CHANGE_TO_EXCLUDE];
+	const auto nModeIsExclude = s_sent.nRecordTypes[IGMP_V3_MODE_IS_EXCLUDE];
+	run_timer(10);
+	const auto isRetransmitOk = (s_sent.nRecordTypes[IGMP_V3_CHANGE_TO_EXCLUDE] - nChangeToExclude == nUniverses) && (s_sent.nRecordTypes[IGMP_V3_MODE_IS_EXCLUDE] == nModeIsExclude);
+	printf("  %u CHANGE_TO_EXCLUDE, %u MODE_IS_EXCLUDE: %s\n", s_sent.nRecordTypes[IGMP_V3_CHANGE_TO_EXCLUDE] - nChangeToExclude, s_sent.nRecordTypes[IGMP_V3_MODE_IS_EXCLUDE] - nModeIsExclude, isRetransmitOk ? "ok" : "FAIL");
+
+	/*
+	 * Multicast traffic of 4 x N universes
+	 */
+
+	uint32_t nHardwarePass = 0, nSoftwarePass = 0, nMissed = 0;
+	const auto nTraffic = 4 * nUniverses;
+
+	for (uint32_t nUniverse = 1; nUniverse <= nTraffic; nUniverse++) {
+		const auto nGroup = sacn_group(nUniverse);
+
+		if (!hash_filter_pass(nGroup)) {
+			if (nUniverse <= nUniverses) {
+				nMissed++;
+			}
+			continue;
+		}
+
+		nHardwarePass++;
+
+		if (igmp_is_member(nGroup, ip(192, 168, 2, 10))) {
+			nSoftwarePass++;
+		}
+	}
+
+	printf("Traffic %u universes: all-multicast passes %u, hash filter passes %u, igmp_is_member passes %u, joined dropped %u\n",
+			nTraffic, nTraffic, nHardwarePass, nSoftwarePass, nMissed);
+
+	start = std::chrono::steady_clock::now();
+	uint32_t nMember = 0;
+	static constexpr uint32_t LOOKUPS = 10000000;
+
+	for (uint32_t i = 0; i < LOOKUPS; i++) {
+		nMember += igmp_is_member(sacn_group(1 + (i % nTraffic)), ip(192, 168, 2, 10));
+	}
+
+	printf("igmp_is_member: %.1f ns (%u)\n", nanos_since(start, LOOKUPS), nMember);
+
+	start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < LOOKUPS; i++) {
+		igmp_timer();
+	}
+
+	printf("igmp_timer idle: %.1f ns\n", nanos_since(start, LOOKUPS));
+
+	/*
+	 * IGMPv3 queries
+	 */
+
+	auto nReports = s_sent.nV3Reports;
+	auto nRecords = s_sent.nV3Records;
+	puts("IGMPv3 General Query, Max Resp 10 s:");
+	query(0, 100, true);
+	run_timer(110);
+	printf("  %u reports, %u records\n", s_sent.nV3Reports - nReports, s_sent.nV3Records - nRecords);
+
+	nReports = s_sent.nV3Reports;
+	puts("IGMPv3 Group-Specific Query, joined group and not joined group:");
+	query(sacn_group(1), 10, true);
+	query(sacn_group(nUniverses + 1), 10, true);
+	run_timer(20);
+
+	/*
+	 * Source specific joins
+	 */
+
+	const auto nSsmGroup = ip(232, 1, 1, 1);
+	const auto nSource1 = ip(192, 168, 2, 10);
+	const auto nSource2 = ip(192, 168, 2, 11);
+	const auto nAllow = s_sent.nRecordTypes[IGMP_V3_ALLOW_NEW_SOURCES];
+	const auto nBlock = s_sent.nRecordTypes[IGMP_V3_BLOCK_OLD_SOURCES];
+
+	igmp_join_source(nSsmGroup, nSource1);
+	const auto isSsmOk = igmp_is_member(nSsmGroup, nSource1) && !igmp_is_member(nSsmGroup, nSource2);
+	igmp_join_source(nSsmGroup, nSource2);
+	const auto isSsm2Ok = igmp_is_member(nSsmGroup, nSource2);
+	igmp_leave_source(nSsmGroup, nSource1);
+	const auto isSsmLeaveOk = !igmp_is_member(nSsmGroup, nSource1) && igmp_is_member(nSsmGroup, nSource2);
+	igmp_leave_source(nSsmGroup, nSource2);
+	const auto isSsmGoneOk = !igmp_is_member(nSsmGroup, nSource2);
+	run_timer(10);
+
+	printf("Source specific: include %s, second source %s, leave source %s, leave group %s, ALLOW %u, BLOCK %u\n",
+			isSsmOk ? "ok" : "FAIL", isSsm2Ok ? "ok" : "FAIL", isSsmLeaveOk ? "ok" : "FAIL", isSsmGoneOk ? "ok" : "FAIL",
+			s_sent.nRecordTypes[IGMP_V3_ALLOW_NEW_SOURCES] - nAllow, s_sent.nRecordTypes[IGMP_V3_BLOCK_OLD_SOURCES] - nBlock);
+
+	// The ALLOW_NEW_SOURCES record is retransmitted while the group is joined
+	const auto nAllowRetransmit = s_sent.nRecordTypes[IGMP_V3_ALLOW_NEW_SOURCES];
+	const auto nModeIsInclude = s_sent.nRecordTypes[IGMP_V3_MODE_IS_INCLUDE];
+	igmp_join_source(nSsmGroup, nSource1);
+	run_timer(10);
+	const auto isSsmRetransmitOk = (s_sent.nRecordTypes[IGMP_V3_ALLOW_NEW_SOURCES] - nAllowRetransmit == ROBUSTNESS) && (s_sent.nRecordTypes[IGMP_V3_MODE_IS_INCLUDE] == nModeIsInclude);
+	printf("Source specific join retransmission: ALLOW %u: %s\n", s_sent.nRecordTypes[IGMP_V3_ALLOW_NEW_SOURCES] - nAllowRetransmit, isSsmRetransmitOk ? "ok" : "FAIL");
+	igmp_leave_source(nSsmGroup, nSource1);
+
+	/*
+	 * IGMPv2 querier
+	 */
+
+	auto nV2Reports = s_sent.nV2Reports;
+	puts("IGMPv2 General Query, Max Resp 10 s:");
+	query(0, 100, false);
+	run_timer(110);
+	printf("  %u IGMPv2 reports\n", s_sent.nV2Reports - nV2Reports);
+
+	nReports = s_sent.nV3Reports;
+	nV2Reports = s_sent.nV2Reports;
+	igmp_join(ip(239, 1, 2, 3));
+	run_timer(10);
+	printf("Join in IGMPv2 compatibility mode: %u IGMPv2 reports, %u IGMPv3 reports\n", s_sent.nV2Reports - nV2Reports, s_sent.nV3Reports - nReports);
+
+	for (uint32_t i = 0; i < 2600; i++) {
+		igmp_timer();
+	}
+
+	nReports = s_sent.nV3Reports;
+	igmp_leave(ip(239, 1, 2, 3));
+	printf("Leave after the Older Version Querier Present Timeout: %u IGMPv3 reports\n", s_sent.nV3Reports - nReports);
+
+	/*
+	 * Leave all
+	 */
+
+	start = std::chrono::steady_clock::now();
+
+	for (uint32_t nUniverse = 1; nUniverse <= nUniverses; nUniverse++) {
+		igmp_leave(sacn_group(nUniverse));
+	}
+
+	const auto fLeave = nanos_since(start, nUniverses);
+	uint32_t nLeft = 0;
+
+	for (uint32_t nUniverse = 1; nUniverse <= nTraffic; nUniverse++) {
+		nLeft += igmp_is_member(sacn_group(nUniverse), 0);
+	}
+
+	printf("Leave: %.0f ns per group, members left %u, hash bins set %d\n", fLeave, nLeft, __builtin_popcount(s_nHashLow) + __builtin_popcount(s_nHashHigh));
+
+	printf("Sent %u packets, %u errors\n", s_sent.nPackets, s_sent.nErrors);
+
+	const auto isOk = (s_sent.nErrors == 0) && (nMissed == 0) && (nLeft == 0) && isRetransmitOk && isSsmRetransmitOk && isSsmOk && isSsm2Ok && isSsmLeaveOk && isSsmGoneOk && (nSoftwarePass == nUniverses) && isHashOk;
+
+	puts(isOk ? "PASS" : "FAIL");
+
+	return isOk ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file ntpclock.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The NTP clock discipline against a simulated server.
+ * The local clock has an offset and a frequency error, the network adds
+ * a delay with jitter and spikes in one direction. The era of the NTP
+ * seconds wraps during the run.
+ * - Verify: the first update steps a large offset, a small offset is slewed;
+ *   the error after settling and the estimated frequency.
+ * - Report: the error, compared with a single sample step each poll (as before).
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include "ntpclock.h"
+#include "ntp.h"
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nIteration) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s iteration %u\n", pTest, nIteration);
+		}
+	}
+}
+
+static uint32_t s_nRandom = 20240601;
+
+static uint32_t xorshift() {
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return s_nRandom;
+}
+
+// 2^32 - 1800: the NTP seconds wrap after 30 minutes
+static constexpr int64_t ERA_MICROS = (4294967296LL - 1800) * 1000000;
+
+static ntp::TimeStamp to_ntp(const int64_t nMicros) {
+	const auto nTotal = ERA_MICROS + nMicros;
+	ntp::TimeStamp timeStamp;
+	timeStamp.nSeconds = static_cast<uint32_t>(nTotal / 1000000);
+	timeStamp.nFraction = static_cast<uint32_t>((static_cast<uint64_t>(nTotal % 1000000) << 32) / 1000000);
+	return timeStamp;
+}
+
+struct Network {
+	uint32_t nBaseMicros;
+	uint32_t nJitterMicros;		///< Uniform
+	uint32_t nSpikePercent;
+	uint32_t nSpikeMicros;		///< Uniform, on the way out only
+
+	int64_t Delay(bool isOut) const {
+		int64_t nDelay = nBaseMicros;
+
+		if (nJitterMicros != 0) {
+			nDelay += xorshift() % nJitterMicros;
+		}
+
+		if (isOut && (nSpikePercent != 0) && ((xorshift() % 100) < nSpikePercent)) {
+			nDelay += xorshift() % nSpikeMicros;
+		}
+
+		return nDelay;
+	}
+};
+
+struct Scenario {
+	const char *pName;
+	int64_t nOffsetMicros;		///< Local minus true at the start
+	int32_t nDriftPpm;			///< Local runs fast
+	Network network;
+	uint32_t nSteps;			///< Expected
+	int64_t nErrorMaxMicros;	///< After settling
+};
+
+struct Result {
+	uint32_t nSteps;
+	uint32_t nPoll;
+	int32_t nFrequencyPpb;
+	int64_t nErrorMaxMicros;
+	double fErrorRmsMicros;
+};
+
+static constexpr uint32_t RUN_SECONDS = 8 * 3600;
+static constexpr uint32_t SETTLE_SECONDS = 2 * 3600;
+static constexpr int64_t SERVER_MICROS = 30;
+
+static Result simulate(const Scenario& scenario, const bool isDiscipline) {
+	NtpClock ntpClock;
+	auto nError = scenario.nOffsetMicros;	// Local minus true
+	uint32_t nMillisLastPoll = 0;
+	uint32_t nSteps = 0;
+	Result result {};
+	double fSum = 0;
+	uint32_t nCount = 0;
+
+	for (uint32_t nSecond = 0; nSecond < RUN_SECONDS; nSecond++) {
+		const auto nTrue = static_cast<int64_t>(nSecond) * 1000000;
+		const auto nMillis = nSecond * 1000;
+
+		const auto nPollMillis = isDiscipline ? ntpClock.GetPollMillis() : (1000U << ntpclock::MAXPOLL);
+
+		if ((nSecond == 0) || ((nMillis - nMillisLastPoll) >= nPollMillis)) {
+			nMillisLastPoll = nMillis;
+
+			const auto nOut = scenario.network.Delay(true);
+			const auto nBack = scenario.network.Delay(false);
+
+			const auto T1 = to_ntp(nTrue + nError);
+			const auto T2 = to_ntp(nTrue + nOut);
+			const auto T3 = to_ntp(nTrue + nOut + SERVER_MICROS);
+			const auto T4 = to_ntp(nTrue + nOut + SERVER_MICROS + nBack + nError);
+
+			int64_t nOffsetMicros;
+			int32_t nDelayMicros;
+			NtpClock::Compute(T1, T2, T3, T4, nOffsetMicros, nDelayMicros);
+
+			if (isDiscipline) {
+				if (ntpClock.Sample(nOffsetMicros, nDelayMicros, nMillis) == ntpclock::Action::STEP) {
+					nError += ntpClock.GetStepMicros();
+					nSteps++;
+				}
+			} else {
+				// One sample, the clock is set
+				nError += nOffsetMicros;
+				nSteps++;
+			}
+		}
+
+		// One second
+		nError += scenario.nDriftPpm;
+
+		if (isDiscipline) {
+			nError += ntpClock.Adjust();
+		}
+
+		if (nSecond >= SETTLE_SECONDS) {
+			const auto nAbs = std::llabs(nError);
+			if (nAbs > result.nErrorMaxMicros) {
+				result.nErrorMaxMicros = nAbs;
+			}
+			fSum += static_cast<double>(nError) * static_cast<double>(nError);
+			nCount++;
+		}
+	}
+
+	result.nSteps = nSteps;
+	result.nPoll = ntpClock.GetPoll();
+	result.nFrequencyPpb = ntpClock.GetFrequencyPpb();
+	result.fErrorRmsMicros = std::sqrt(fSum / nCount);
+
+	return result;
+}
+
+int main() {
+	static constexpr Scenario SCENARIOS[] = {
+		{ "Step, 40 ppm, jitter",	2500000,	40, { 200, 300, 5, 20000 }, 1, 1000 },
+		{ "Slew, -25 ppm, jitter",	-30000,		-25, { 200, 300, 5, 20000 }, 0, 1000 },
+		{ "Slew, 10 ppm, LAN",		5000,		10, { 100, 20, 0, 0 }, 0, 100 },
+		{ "Slew, 0 ppm, no jitter",	1000,		0, { 150, 0, 0, 0 }, 0, 10 },
+		{ "Step, -100 ppm, spikes", -600000,	-100, { 500, 1000, 20, 50000 }, 1, 3000 },
+	};
+
+	puts("Scenario                  Steps  Poll  Frequency(ppm)  Error max(us)  rms(us)   Single sample max(us)");
+
+	uint32_t nIteration = 0;
+
+	for (const auto& scenario : SCENARIOS) {
+		const auto result = simulate(scenario, true);
+		const auto baseline = simulate(scenario, false);
+
+		printf("%-24s %6u %5u %15.3f %14lld %8.1f %23lld\n", scenario.pName, result.nSteps, result.nPoll,
+				static_cast<double>(result.nFrequencyPpb) / 1000, static_cast<long long>(result.nErrorMaxMicros), result.fErrorRmsMicros,
+				static_cast<long long>(baseline.nErrorMaxMicros));
+
+		check(result.nSteps == scenario.nSteps, "steps", nIteration);
+		check(result.nErrorMaxMicros <= scenario.nErrorMaxMicros, "error", nIteration);
+		// The frequency correction is the opposite of the drift
+		check(std::abs(result.nFrequencyPpb + (scenario.nDriftPpm * 1000)) < 2000, "frequency", nIteration);
+		check((result.nErrorMaxMicros < baseline.nErrorMaxMicros) || (baseline.nErrorMaxMicros == 0), "better than a single sample", nIteration);
+
+		nIteration++;
+	}
+
+	// The NTP timestamp arithmetic over the era boundary
+	const auto a = to_ntp(1800LL * 1000000 + 250);
+	const auto b = to_ntp(1799LL * 1000000 + 999999);
+	check(a.nSeconds == 0, "era", 0);
+	check(ntp::difference_micros(a, b) == 251, "difference over the era", 0);
+	check(ntp::difference_micros(b, a) == -251, "difference over the era", 1);
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
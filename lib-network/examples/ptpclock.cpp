@@ -0,0 +1,283 @@
+/**
+ * @file ptpclock.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The PTP slave clock against a simulated grandmaster.
+ * The grandmaster sends a two-step Sync each second and answers the Delay_Req,
+ * the messages go over the wire format of ptp.h. A transparent clock adds
+ * a correction. The local timer has a frequency error, which changes, and wraps
+ * during the run. The software time stamps are late by the network jitter
+ * and by the main loop, with stalls of milliseconds.
+ * - Verify: the error of the PTP time of the local timer after settling, both
+ *   ways (GetNanos and GetMicros), the estimated frequency and the steps.
+ * - Report: the error, compared with the time set by each Sync.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include "ptpclock.h"
+#include "ptp.h"
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nIteration) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s iteration %u\n", pTest, nIteration);
+		}
+	}
+}
+
+static uint32_t s_nRandom = 20240601;
+
+static uint32_t xorshift() {
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return s_nRandom;
+}
+
+static int64_t random(const uint32_t nMax) {
+	return (nMax == 0) ? 0 : static_cast<int64_t>(xorshift() % nMax);
+}
+
+struct Scenario {
+	const char *pName;
+	int32_t nDriftStartPpm;		///< The local timer runs fast
+	int32_t nDriftEndPpm;
+	uint32_t nJitterNanos;		///< Network, uniform
+	uint32_t nLatencyNanos;		///< Main loop, uniform
+	uint32_t nStallPercent;
+	uint32_t nStallNanos;		///< Main loop, uniform
+	int64_t nJumpNanos;			///< The grandmaster time, after 1 hour
+	uint32_t nSteps;			///< Expected
+	int64_t nErrorMaxNanos;		///< After settling
+};
+
+struct Result {
+	uint32_t nSteps;
+	int32_t nFrequencyPpb;
+	int64_t nErrorMaxNanos;
+	int64_t nInverseMaxMicros;
+	double fErrorRmsNanos;
+	int64_t nBaselineMaxNanos;
+	bool bSynchronised;
+};
+
+static constexpr uint32_t RUN_SECONDS = 2 * 3600;
+static constexpr uint32_t SETTLE_SECONDS = 120;
+static constexpr uint32_t JUMP_SECONDS = 3600;
+static constexpr int64_t PATH_NANOS = 40000;
+static constexpr int64_t TAI_NANOS = 1717200000LL * 1000000000;
+// The local timer wraps after 10 minutes
+static constexpr double LOCAL_START_NANOS = (4294967296.0 - 600000000.0) * 1000.0;
+
+/*
+ * The grandmaster side: the messages as on the wire
+ */
+
+static ptp::Event s_Sync;
+static ptp::Event s_FollowUp;
+static ptp::DelayResp s_DelayResp;
+
+static void gm_sync(const int64_t nOriginNanos, const int64_t nResidenceNanos, const uint16_t nSequenceId) {
+	memset(&s_Sync, 0, sizeof(s_Sync));
+	s_Sync.Header.TransportSpecificMessageType = ptp::message::SYNC;
+	s_Sync.Header.Version = ptp::VERSION;
+	s_Sync.Header.MessageLength = __builtin_bswap16(sizeof(struct ptp::Event));
+	s_Sync.Header.FlagField = __builtin_bswap16(ptp::flag::TWO_STEP);
+	s_Sync.Header.SequenceId = __builtin_bswap16(nSequenceId);
+	// The transparent clock
+	s_Sync.Header.CorrectionField = ptp::nanos_to_correction(nResidenceNanos);
+
+	memset(&s_FollowUp, 0, sizeof(s_FollowUp));
+	s_FollowUp.Header.TransportSpecificMessageType = ptp::message::FOLLOW_UP;
+	s_FollowUp.Header.SequenceId = __builtin_bswap16(nSequenceId);
+	ptp::nanos_to_timestamp(nOriginNanos, s_FollowUp.Timestamp);
+}
+
+static void gm_delay_resp(const int64_t nReceiveNanos, const int64_t nResidenceNanos) {
+	memset(&s_DelayResp, 0, sizeof(s_DelayResp));
+	s_DelayResp.Header.TransportSpecificMessageType = ptp::message::DELAY_RESP;
+	s_DelayResp.Header.CorrectionField = ptp::nanos_to_correction(nResidenceNanos);
+	ptp::nanos_to_timestamp(nReceiveNanos, s_DelayResp.ReceiveTimestamp);
+}
+
+/*
+ * The local timer, Hardware::Micros
+ */
+
+struct Local {
+	double fNanos;		///< At the start of the second
+	double fRate;
+
+	uint32_t Micros(const int64_t nSinceSecond) const {
+		return static_cast<uint32_t>(static_cast<uint64_t>((fNanos + static_cast<double>(nSinceSecond) * fRate) / 1000.0));
+	}
+};
+
+static Result simulate(const Scenario& scenario) {
+	PtpClock ptpClock;
+	Local local { LOCAL_START_NANOS, 1.0 };
+	Result result {};
+	double fSum = 0;
+	uint32_t nCount = 0;
+	int64_t nJump = 0;
+	// Baseline: set with each Sync, the last mean path delay measured
+	int64_t nBaselineNanos = 0;
+	uint32_t nBaselineMicros = 0;
+	int64_t nBaselineDelay = 0;
+
+	for (uint32_t nSecond = 0; nSecond < RUN_SECONDS; nSecond++) {
+		const auto fDrift = scenario.nDriftStartPpm + ((scenario.nDriftEndPpm - scenario.nDriftStartPpm) * static_cast<double>(nSecond) / RUN_SECONDS);
+		local.fRate = 1.0 + (fDrift / 1e6);
+
+		if (nSecond == JUMP_SECONDS) {
+			nJump = scenario.nJumpNanos;
+		}
+
+		// The grandmaster time at the start of the second
+		const auto nMaster = TAI_NANOS + (static_cast<int64_t>(nSecond) * 1000000000) + nJump;
+
+		const auto late = [&]() {
+			auto nLate = random(scenario.nLatencyNanos);
+			if ((scenario.nStallPercent != 0) && (static_cast<uint32_t>(random(100)) < scenario.nStallPercent)) {
+				nLate += random(scenario.nStallNanos);
+			}
+			return nLate;
+		};
+
+		// Sync, sent at the start of the second
+		const auto nResidenceSync = random(2000);
+		gm_sync(nMaster, nResidenceSync, static_cast<uint16_t>(nSecond));
+		const auto nArrival = PATH_NANOS + nResidenceSync + random(scenario.nJitterNanos);
+		const auto nSyncMicros = local.Micros(nArrival + late());
+
+		// The slave side
+		const auto t1 = ptp::timestamp_to_nanos(s_FollowUp.Timestamp) + ptp::correction_to_nanos(s_Sync.Header.CorrectionField) + ptp::correction_to_nanos(s_FollowUp.Header.CorrectionField);
+
+		if (ptpClock.Sync(t1, nSyncMicros) == ptpclock::Action::STEP) {
+			result.nSteps++;
+		}
+
+		nBaselineNanos = t1 + nBaselineDelay;
+		nBaselineMicros = nSyncMicros;
+
+		// Delay_Req, after 500 ms, the time stamp is taken before the transmission
+		const auto nSend = 500000000 + late();
+		const auto t3 = local.Micros(nSend);
+		const auto nResidenceDelay = random(2000);
+		gm_delay_resp(nMaster + nSend + random(20000) + PATH_NANOS + nResidenceDelay + random(scenario.nJitterNanos), nResidenceDelay);
+
+		const auto t4 = ptp::timestamp_to_nanos(s_DelayResp.ReceiveTimestamp) - ptp::correction_to_nanos(s_DelayResp.Header.CorrectionField);
+		ptpClock.Delay(t3, t4);
+
+		nBaselineDelay = ptpClock.GetDelayNanos();
+
+		// The error during the second
+		const auto isSettled = (nSecond >= SETTLE_SECONDS) && ((nSecond < JUMP_SECONDS) || (nSecond >= (JUMP_SECONDS + SETTLE_SECONDS)));
+
+		if (isSettled) {
+			for (int64_t nAt = 250000000; nAt < 1000000000; nAt += 250000000) {
+				const auto nMicros = local.Micros(nAt);
+				const auto nError = ptpClock.GetNanos(nMicros) - (nMaster + nAt);
+				const auto nAbs = std::llabs(nError);
+
+				if (nAbs > result.nErrorMaxNanos) {
+					result.nErrorMaxNanos = nAbs;
+				}
+
+				fSum += static_cast<double>(nError) * static_cast<double>(nError);
+				nCount++;
+
+				// The local time for a PTP time, as for a scheduled output
+				const auto nInverse = std::llabs(static_cast<int32_t>(ptpClock.GetMicros(nMaster + nAt) - nMicros));
+				if (nInverse > result.nInverseMaxMicros) {
+					result.nInverseMaxMicros = nInverse;
+				}
+
+				const auto nBaseline = std::llabs(nBaselineNanos + static_cast<int64_t>(static_cast<int32_t>(nMicros - nBaselineMicros)) * 1000 - (nMaster + nAt));
+				if (nBaseline > result.nBaselineMaxNanos) {
+					result.nBaselineMaxNanos = nBaseline;
+				}
+			}
+		}
+
+		local.fNanos += 1e9 * local.fRate;
+	}
+
+	result.nFrequencyPpb = ptpClock.GetFrequencyPpb();
+	result.fErrorRmsNanos = std::sqrt(fSum / nCount);
+	result.bSynchronised = ptpClock.IsSynchronised();
+
+	return result;
+}
+
+int main() {
+	static constexpr Scenario SCENARIOS[] = {
+		{ "0 ppm, ideal",				0, 0, 0, 0, 0, 0, 0, 1, 10000 },
+		{ "40 ppm, LAN",				40, 40, 20000, 100000, 0, 0, 0, 1, 100000 },
+		{ "-100 ppm, stalls",			-100, -100, 20000, 200000, 10, 20000000, 0, 1, 250000 },
+		{ "20..60 ppm, temperature",	20, 60, 20000, 100000, 2, 5000000, 0, 1, 100000 },
+		{ "15 ppm, GM time +1 s",		15, 15, 20000, 100000, 2, 5000000, 1000000000, 2, 100000 },
+	};
+
+	puts("Scenario                  Steps  Frequency(ppm)  Error max(us)  rms(us)  Sync sets the time max(us)");
+
+	uint32_t nIteration = 0;
+
+	for (const auto& scenario : SCENARIOS) {
+		const auto result = simulate(scenario);
+
+		printf("%-25s %5u %15.3f %14.1f %8.1f %27.1f\n", scenario.pName, result.nSteps,
+				static_cast<double>(result.nFrequencyPpb) / 1000, static_cast<double>(result.nErrorMaxNanos) / 1000, result.fErrorRmsNanos / 1000,
+				static_cast<double>(result.nBaselineMaxNanos) / 1000);
+
+		check(result.nSteps == scenario.nSteps, "steps", nIteration);
+		check(result.nErrorMaxNanos <= scenario.nErrorMaxNanos, "error", nIteration);
+		check(result.nInverseMaxMicros <= (scenario.nErrorMaxNanos / 1000) + 1, "inverse", nIteration);
+		check(result.bSynchronised, "synchronised", nIteration);
+		// The frequency correction is the opposite of the drift
+		check(std::abs(result.nFrequencyPpb + (scenario.nDriftEndPpm * 1000)) < 2000, "frequency", nIteration);
+		check((result.nErrorMaxNanos < result.nBaselineMaxNanos) || (result.nBaselineMaxNanos <= 1000), "better than each Sync", nIteration);
+
+		nIteration++;
+	}
+
+	// The wire format
+	ptp::Timestamp timestamp;
+	ptp::nanos_to_timestamp(TAI_NANOS + 123456789, timestamp);
+	check(ptp::timestamp_to_nanos(timestamp) == TAI_NANOS + 123456789, "timestamp", 0);
+	check(__builtin_bswap32(timestamp.Nanoseconds) == 123456789, "timestamp", 1);
+	check(ptp::correction_to_nanos(ptp::nanos_to_correction(-1500)) == -1500, "correction", 0);
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
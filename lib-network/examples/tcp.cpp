@@ -0,0 +1,1139 @@
+/**
+ * @file tcp.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The bare-metal TCP on Linux, with a simulated wire and a peer TCP.
+ * The time is simulated: a 100 Mbit/s link per direction, 100 µs one-way
+ * delay, tcp_timer every 100 ms, as net_timers_run.
+ *
+ * - Upload (peer -> device) of 1 MB: throughput, the ACKs of the device (delayed ACK).
+ * - A slow reader: the window closes and opens, no data is lost.
+ * - A slow reader and 100 byte segments: the window counts the free entries, only the first window is dropped.
+ * - Download (device -> peer) of 1 MB, written in 1000 byte pieces: throughput, segment size.
+ * - 1% loss in both directions: the data is intact, the retransmissions.
+ * - 16 connections at the same time; the 17th SYN gets no TCB, it connects on the retry.
+ * - Two listening ports share the TCB pool; a port without a listener gets a RST.
+ * - Cork and Nagle: the number of segments for three small writes.
+ * - The peer disappears: the connection is reset after the retransmissions.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <deque>
+
+#include "net.h"
+#include "net_private.h"
+#include "net_packets.h"
+#include "net_chksum.h"
+#include "hardware.h"
+
+#include "../config/net_config.h"
+
+namespace net {
+namespace globals {
+struct IpInfo ipInfo;
+uint8_t macAddress[ETH_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x12, 0x34, 0x56 };
+}  // namespace globals
+}  // namespace net
+
+/*
+ * The simulated time
+ */
+
+static constexpr uint32_t STEP_MICROS = 10;
+static constexpr uint32_t TIMER_MICROS = 100000;	// net_timers_run
+
+static uint32_t s_nMicros = 1000000;
+static uint32_t s_nTimerMicros = 1000000;
+
+Hardware *Hardware::s_pThis;
+
+Hardware::Hardware() {
+	s_pThis = this;
+}
+
+uint32_t Hardware::Millis() {
+	return s_nMicros / 1000;
+}
+
+uint32_t Hardware::Micros() {
+	return s_nMicros;
+}
+
+int console_error(const char *p) {
+	return printf("%s", p);
+}
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest) {
+	if (!isOk) {
+		if (s_nErrors++ < 20) {
+			printf("FAIL %s\n", pTest);
+		}
+	}
+}
+
+static uint32_t s_nRandom = 20240601;
+
+static uint32_t random_next() {
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return s_nRandom;
+}
+
+/*
+ * The wire: 100 Mbit/s in each direction, a fixed delay, random loss
+ */
+
+static constexpr uint8_t DEVICE_IP[4] = { 192, 168, 2, 10 };
+static constexpr uint32_t FRAME_OVERHEAD = 8 + 4 + 12;	// Preamble, FCS, inter-frame gap
+
+struct Frame {
+	uint32_t nDueMicros;
+	uint16_t nLength;
+	uint8_t data[1518];
+};
+
+struct Link {
+	std::deque<Frame> frames;
+	uint32_t nBusyMicros;
+	uint32_t nLossPerMille;
+	uint32_t nDelayMicros;
+	bool isDown;
+};
+
+static Link s_ToDevice;
+static Link s_ToPeer;
+
+static void link_send(Link& link, const void *pData, uint32_t nLength) {
+	if (link.isDown || ((random_next() % 1000) < link.nLossPerMille)) {
+		return;
+	}
+
+	// 100 Mbit/s is 12.5 bytes per µs
+	const auto nStart = (static_cast<int32_t>(link.nBusyMicros - s_nMicros) > 0) ? link.nBusyMicros : s_nMicros;
+	link.nBusyMicros = nStart + ((nLength + FRAME_OVERHEAD) * 2 + 24) / 25;
+
+	Frame frame;
+	frame.nDueMicros = link.nBusyMicros + link.nDelayMicros;
+	frame.nLength = static_cast<uint16_t>(nLength);
+	memcpy(frame.data, pData, nLength);
+
+	link.frames.push_back(frame);
+}
+
+static uint32_t s_nResetsSent;
+
+void emac_eth_send(void *pBuffer, int nLength) {
+	if (reinterpret_cast<const t_tcp *>(pBuffer)->tcp.control & 0x04) {
+		s_nResetsSent++;
+	}
+
+	link_send(s_ToPeer, pBuffer, static_cast<uint32_t>(nLength));
+}
+
+/*
+ * The data of a connection, byte n of the stream
+ */
+
+static uint8_t pattern(uint32_t nId, uint32_t nOffset) {
+	return static_cast<uint8_t>((nOffset * 7) + (nOffset >> 8) + nId);
+}
+
+/*
+ * The peer TCP, a client: go-back-N with a fixed retransmission timeout,
+ * fast and early retransmit, NewReno, an out of order queue, an ACK for every segment.
+ */
+
+static constexpr uint32_t PEER_MSS = 1460;
+static constexpr uint32_t PEER_WINDOW = 65535;
+static constexpr uint32_t PEER_RTO_MICROS = 200000;
+static constexpr uint32_t PEER_SYN_RTO_MICROS = 1000000;
+static constexpr uint32_t MAX_PEERS = 20;
+
+enum class PeerState {
+	IDLE, SYN_SENT, ESTABLISHED, DONE, RESET
+};
+
+struct Peer {
+	PeerState state;
+	uint32_t nId;
+	uint8_t ip[4];
+	uint16_t nPort;
+	uint16_t nDevicePort;
+
+	// Send
+	uint32_t nISS;
+	uint32_t nSndUna;
+	uint32_t nSndNxt;
+	uint32_t nSndMax;
+	uint32_t nSndWnd;
+	uint32_t nSendMss;
+	uint32_t nSegmentSize;		// 0, else the peer sends segments of this size at most
+	uint32_t nUpload;			// Bytes to send, then the FIN
+	const uint8_t *pRequest;	// Or a request
+	uint32_t nRequestLength;
+	bool isFinHeld;
+	bool isFinSent;
+	bool isFinAcked;
+	uint32_t nRtoMicros;
+	uint32_t nDupAcks;
+	uint32_t nRecover;			// NewReno
+	bool isRecovery;
+
+	// Receive, with an out of order queue of ranges
+	struct {
+		uint32_t nBegin;
+		uint32_t nEnd;
+	} OutOfOrder[32];
+	uint32_t nIRS;
+	uint32_t nRcvNxt;
+	uint32_t nDownload;			// Bytes to receive, then the FIN
+	uint32_t nReceived;
+	uint32_t nHighest;			// The end of the data received
+	bool isFinReceived;
+
+	// Statistics
+	uint32_t nStartMicros;
+	uint32_t nDoneMicros;
+	uint32_t nSegmentsSent;
+	uint32_t nRetransmitsSent;
+	uint32_t nDataSegmentsReceived;
+	uint32_t nAcksReceived;			// Without data
+	uint32_t nRetransmitsReceived;
+	uint32_t nZeroWindows;
+	uint32_t nPatternErrors;
+	uint32_t nChecksumErrors;
+	uint32_t nLastAckMicros;
+};
+
+static Peer s_Peers[MAX_PEERS];
+
+static void peer_output_segment(Peer& peer, uint8_t nControl, uint32_t nSeq, uint32_t nLength) {
+	static t_tcp frame;
+
+	memset(&frame, 0, sizeof(struct ether_header) + sizeof(struct ip4_header) + TCP_HEADER_SIZE + 16);
+
+	memcpy(frame.ether.dst, net::globals::macAddress, ETH_ADDR_LEN);
+	const uint8_t mac[ETH_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, static_cast<uint8_t>(peer.nId) };
+	memcpy(frame.ether.src, mac, ETH_ADDR_LEN);
+	frame.ether.type = __builtin_bswap16(ETHER_TYPE_IPv4);
+
+	auto *pOptions = frame.tcp.data;
+	uint32_t nOptions;
+
+	if (nControl & 0x02) {
+		pOptions[0] = 2;
+		pOptions[1] = 4;
+		pOptions[2] = PEER_MSS >> 8;
+		pOptions[3] = PEER_MSS & 0xFF;
+		nOptions = 4;
+	} else {
+		pOptions[0] = 1;
+		pOptions[1] = 1;
+		pOptions[2] = 8;
+		pOptions[3] = 10;
+		const auto nTSval = __builtin_bswap32(s_nMicros / 1000);
+		memcpy(&pOptions[4], &nTSval, 4);
+		nOptions = 12;
+	}
+
+	for (uint32_t i = 0; i < nLength; i++) {
+		const auto nOffset = nSeq - peer.nISS - 1 + i;
+		pOptions[nOptions + i] = (peer.pRequest != nullptr) ? peer.pRequest[nOffset] : pattern(peer.nId, nOffset);
+	}
+
+	const auto nTcpLength = TCP_HEADER_SIZE + nOptions + nLength;
+
+	frame.ip4.ver_ihl = 0x45;
+	frame.ip4.len = __builtin_bswap16(static_cast<uint16_t>(sizeof(struct ip4_header) + nTcpLength));
+	frame.ip4.ttl = 64;
+	frame.ip4.proto = IPv4_PROTO_TCP;
+	memcpy(frame.ip4.src, peer.ip, 4);
+	memcpy(frame.ip4.dst, DEVICE_IP, 4);
+	frame.ip4.chksum = net_chksum(&frame.ip4, sizeof(struct ip4_header));
+
+	frame.tcp.srcpt = __builtin_bswap16(peer.nPort);
+	frame.tcp.dstpt = __builtin_bswap16(peer.nDevicePort);
+	frame.tcp.seqnum = __builtin_bswap32(nSeq);
+	frame.tcp.acknum = (nControl & 0x10) ? __builtin_bswap32(peer.nRcvNxt) : 0;
+	frame.tcp.offset = static_cast<uint8_t>(((TCP_HEADER_SIZE + nOptions) / 4) << 4);
+	frame.tcp.control = nControl;
+	frame.tcp.window = __builtin_bswap16(PEER_WINDOW);
+
+	uint8_t pseudo[12];
+	memcpy(&pseudo[0], peer.ip, 4);
+	memcpy(&pseudo[4], DEVICE_IP, 4);
+	pseudo[8] = 0;
+	pseudo[9] = IPv4_PROTO_TCP;
+	pseudo[10] = static_cast<uint8_t>(nTcpLength >> 8);
+	pseudo[11] = static_cast<uint8_t>(nTcpLength);
+	frame.tcp.checksum = net_chksum_fold(net_chksum_add(&frame.tcp, nTcpLength, net_chksum_add(pseudo, 12, 0)));
+
+	peer.nSegmentsSent++;
+
+	link_send(s_ToDevice, &frame, static_cast<uint32_t>(sizeof(struct ether_header) + sizeof(struct ip4_header) + nTcpLength));
+}
+
+static void peer_ack(Peer& peer) {
+	peer_output_segment(peer, 0x10, peer.nSndNxt, 0);
+}
+
+static uint32_t peer_send_length(const Peer& peer) {
+	return (peer.pRequest != nullptr) ? peer.nRequestLength : peer.nUpload;
+}
+
+static void peer_connect(Peer& peer) {
+	peer.state = PeerState::SYN_SENT;
+	peer.nISS = random_next();
+	peer.nSndUna = peer.nISS;
+	peer.nSndNxt = peer.nISS + 1;
+	peer.nSndMax = peer.nSndNxt;
+	peer.nStartMicros = s_nMicros;
+	peer.nRtoMicros = s_nMicros + PEER_SYN_RTO_MICROS;
+	peer_output_segment(peer, 0x02, peer.nISS, 0);
+}
+
+static void peer_output(Peer& peer) {
+	if (peer.state != PeerState::ESTABLISHED) {
+		return;
+	}
+
+	const auto nEnd = peer.nISS + 1 + peer_send_length(peer);
+
+	while (static_cast<int32_t>(nEnd - peer.nSndNxt) > 0) {
+		const auto nInFlight = peer.nSndNxt - peer.nSndUna;
+		const auto nWindow = (peer.nSndWnd > nInFlight) ? peer.nSndWnd - nInFlight : 0;
+		const auto nLength = std::min(std::min(nEnd - peer.nSndNxt, peer.nSendMss), nWindow);
+
+		// Silly window avoidance
+		if ((nLength == 0) || ((nLength < std::min(nEnd - peer.nSndNxt, peer.nSendMss)) && (nInFlight != 0))) {
+			return;
+		}
+
+		if (static_cast<int32_t>(peer.nSndNxt - peer.nSndMax) < 0) {
+			peer.nRetransmitsSent++;
+		}
+
+		peer_output_segment(peer, 0x18, peer.nSndNxt, nLength);
+		peer.nSndNxt += nLength;
+
+		if (static_cast<int32_t>(peer.nSndNxt - peer.nSndMax) > 0) {
+			peer.nSndMax = peer.nSndNxt;
+		}
+
+		peer.nRtoMicros = s_nMicros + PEER_RTO_MICROS;
+	}
+
+	// The FIN after the upload; for a request, after the download
+	const auto isFin = (peer.pRequest == nullptr) || (peer.nReceived == peer.nDownload);
+
+	if (isFin && !peer.isFinHeld && !peer.isFinSent && (peer.nSndNxt == nEnd)) {
+		peer.isFinSent = true;
+		peer_output_segment(peer, 0x11, peer.nSndNxt, 0);
+		peer.nSndNxt++;
+		peer.nSndMax = peer.nSndNxt;
+		peer.nRtoMicros = s_nMicros + PEER_RTO_MICROS;
+	}
+}
+
+static void peer_input(Peer& peer, const t_tcp *pFrame, uint32_t nFrameLength) {
+	const auto nIpLength = __builtin_bswap16(pFrame->ip4.len);
+	const auto nTcpLength = nIpLength - static_cast<uint32_t>(sizeof(struct ip4_header));
+
+	uint8_t pseudo[12];
+	memcpy(&pseudo[0], pFrame->ip4.src, 4);
+	memcpy(&pseudo[4], pFrame->ip4.dst, 4);
+	pseudo[8] = 0;
+	pseudo[9] = IPv4_PROTO_TCP;
+	pseudo[10] = static_cast<uint8_t>(nTcpLength >> 8);
+	pseudo[11] = static_cast<uint8_t>(nTcpLength);
+
+	if ((nFrameLength != sizeof(struct ether_header) + nIpLength)
+	 || (net_chksum(&pFrame->ip4, sizeof(struct ip4_header)) != 0)
+	 || (net_chksum_fold(net_chksum_add(&pFrame->tcp, nTcpLength, net_chksum_add(pseudo, 12, 0))) != 0)) {
+		peer.nChecksumErrors++;
+		return;
+	}
+
+	const auto nControl = pFrame->tcp.control;
+	const auto nSeq = __builtin_bswap32(pFrame->tcp.seqnum);
+	const auto nAck = __builtin_bswap32(pFrame->tcp.acknum);
+	const auto nWindow = __builtin_bswap16(pFrame->tcp.window);
+	const auto nDataOffset = static_cast<uint32_t>((pFrame->tcp.offset >> 4) * 4);
+	const auto nLength = nTcpLength - nDataOffset;
+	const auto *pData = reinterpret_cast<const uint8_t *>(&pFrame->tcp) + nDataOffset;
+
+	if (nControl & 0x04) {
+		peer.state = PeerState::RESET;
+		peer.nDoneMicros = s_nMicros;
+		return;
+	}
+
+	if (peer.state == PeerState::SYN_SENT) {
+		if (((nControl & 0x12) != 0x12) || (nAck != peer.nISS + 1)) {
+			return;
+		}
+
+		peer.nIRS = nSeq;
+		peer.nRcvNxt = nSeq + 1;
+		peer.nSndUna = nAck;
+		peer.nSndWnd = nWindow;
+		peer.nSendMss = 536;
+
+		// The MSS option
+		for (uint32_t i = TCP_HEADER_SIZE; i + 4 <= nDataOffset;) {
+			const auto *p = reinterpret_cast<const uint8_t *>(&pFrame->tcp) + i;
+			if (p[0] == 0) {
+				break;
+			}
+			if (p[0] == 1) {
+				i++;
+				continue;
+			}
+			if (p[0] == 2) {
+				peer.nSendMss = static_cast<uint32_t>((p[2] << 8) | p[3]) - 12;
+			}
+			i += p[1];
+		}
+
+		if (peer.nSegmentSize != 0) {
+			peer.nSendMss = std::min(peer.nSendMss, peer.nSegmentSize);
+		}
+
+		peer.state = PeerState::ESTABLISHED;
+		peer.nRtoMicros = 0;
+		peer_ack(peer);
+		peer_output(peer);
+		return;
+	}
+
+	if (peer.state != PeerState::ESTABLISHED) {
+		return;
+	}
+
+	// The acknowledgment
+	if (nControl & 0x10) {
+		if ((static_cast<int32_t>(nAck - peer.nSndUna) > 0) && (static_cast<int32_t>(nAck - peer.nSndMax) <= 0)) {
+			peer.nSndUna = nAck;
+			peer.nDupAcks = 0;
+
+			if (static_cast<int32_t>(peer.nSndNxt - nAck) < 0) {
+				peer.nSndNxt = nAck;
+			}
+
+			// A partial ACK: the device has no out of order queue, go back
+			if (peer.isRecovery) {
+				if (static_cast<int32_t>(nAck - peer.nRecover) >= 0) {
+					peer.isRecovery = false;
+				} else {
+					peer.nRetransmitsSent += (peer.nSndNxt != peer.nSndUna);
+					peer.nSndNxt = peer.nSndUna;
+					peer.isFinSent = false;
+				}
+			}
+
+			peer.nRtoMicros = (peer.nSndUna == peer.nSndMax) ? 0 : s_nMicros + PEER_RTO_MICROS;
+
+			if (peer.isFinSent && (peer.nSndUna == peer.nSndMax)) {
+				peer.isFinAcked = true;
+			}
+		} else if ((nAck == peer.nSndUna) && (nLength == 0) && (peer.nSndUna != peer.nSndMax) && (nWindow == peer.nSndWnd)) {
+			// Early retransmit (RFC 5827) when there are less than 4 segments in flight
+			const auto nSegments = (peer.nSndMax - peer.nSndUna + peer.nSendMss - 1) / peer.nSendMss;
+
+			if (++peer.nDupAcks == std::max(1U, std::min(3U, nSegments - 1))) {
+				peer.nRetransmitsSent++;
+				peer.isRecovery = true;
+				peer.nRecover = peer.nSndMax;
+				const auto nEnd = peer.nISS + 1 + peer_send_length(peer);
+				if (static_cast<int32_t>(nEnd - peer.nSndUna) > 0) {
+					peer_output_segment(peer, 0x18, peer.nSndUna, std::min(nEnd - peer.nSndUna, peer.nSendMss));
+				}
+			}
+		}
+
+		peer.nSndWnd = nWindow;
+
+		if (nWindow == 0) {
+			peer.nZeroWindows++;
+		}
+
+		if (nLength == 0) {
+			peer.nAcksReceived++;
+			peer.nLastAckMicros = s_nMicros;
+		}
+	}
+
+	// The data
+	auto isAckNeeded = false;
+
+	if (nLength != 0) {
+		peer.nDataSegmentsReceived++;
+		isAckNeeded = true;
+
+		// The data is checked where it arrives, the ranges tell what has arrived
+		const auto nBegin = nSeq - (peer.nIRS + 1);
+		const auto nEnd = nBegin + nLength;
+
+		for (uint32_t i = 0; i < nLength; i++) {
+			if (pData[i] != pattern(peer.nId, nBegin + i)) {
+				peer.nPatternErrors++;
+				break;
+			}
+		}
+
+		if (static_cast<int32_t>(nEnd - peer.nReceived) > 0) {
+			for (auto& range : peer.OutOfOrder) {
+				if (range.nEnd == range.nBegin) {
+					range.nBegin = nBegin;
+					range.nEnd = nEnd;
+					break;
+				}
+			}
+		}
+
+		// RCV.NXT moves over the ranges which are connected
+		const auto nReceived = peer.nReceived;
+
+		for (auto isMoved = true; isMoved;) {
+			isMoved = false;
+			for (auto& range : peer.OutOfOrder) {
+				if ((range.nEnd != range.nBegin) && (static_cast<int32_t>(range.nBegin - peer.nReceived) <= 0)) {
+					if (static_cast<int32_t>(range.nEnd - peer.nReceived) > 0) {
+						peer.nReceived = range.nEnd;
+						isMoved = true;
+					}
+					range.nBegin = range.nEnd = 0;
+				}
+			}
+		}
+
+		peer.nRcvNxt += peer.nReceived - nReceived;
+
+		if (static_cast<int32_t>(nBegin - peer.nHighest) < 0) {
+			peer.nRetransmitsReceived++;
+		} else {
+			peer.nHighest = nEnd;
+		}
+	}
+
+	if ((nControl & 0x01) && (nSeq + nLength == peer.nRcvNxt)) {
+		peer.nRcvNxt++;
+		peer.isFinReceived = true;
+		isAckNeeded = true;
+	}
+
+	if (isAckNeeded) {
+		peer_ack(peer);
+	}
+
+	peer_output(peer);
+
+	if (peer.isFinReceived && peer.isFinAcked) {
+		peer.state = PeerState::DONE;
+		peer.nDoneMicros = s_nMicros;
+	}
+}
+
+static void peer_timer(Peer& peer) {
+	if ((peer.nRtoMicros == 0) || (static_cast<int32_t>(s_nMicros - peer.nRtoMicros) < 0)) {
+		return;
+	}
+
+	if (peer.state == PeerState::SYN_SENT) {
+		peer.nRtoMicros = s_nMicros + PEER_SYN_RTO_MICROS;
+		peer_output_segment(peer, 0x02, peer.nISS, 0);
+		return;
+	}
+
+	if (peer.state != PeerState::ESTABLISHED) {
+		return;
+	}
+
+	// Go back N, or the window probe
+	if (peer.nSndUna != peer.nSndMax) {
+		peer.nSndNxt = peer.nSndUna;
+		if (peer.isFinSent && (peer.nSndUna == peer.nSndMax - 1) && (peer.nSndMax - 1 == peer.nISS + 1 + peer_send_length(peer))) {
+			peer.nRetransmitsSent++;
+			peer_output_segment(peer, 0x11, peer.nSndUna, 0);
+			peer.nSndNxt = peer.nSndMax;
+		} else {
+			peer.isFinSent = false;
+		}
+	}
+
+	if ((peer.nSndWnd == 0) && (peer.nSndNxt == peer.nSndUna) && (peer.nSndNxt != peer.nISS + 1 + peer_send_length(peer))) {
+		peer_output_segment(peer, 0x18, peer.nSndNxt, 1);
+		peer.nSndNxt++;
+		if (static_cast<int32_t>(peer.nSndNxt - peer.nSndMax) > 0) {
+			peer.nSndMax = peer.nSndNxt;
+		}
+	}
+
+	peer.nRtoMicros = s_nMicros + PEER_RTO_MICROS;
+	peer_output(peer);
+}
+
+/*
+ * The simulation step, the device side is as ip.cpp and net_timers_run
+ */
+
+static void sim_step() {
+	s_nMicros += STEP_MICROS;
+
+	while (!s_ToDevice.frames.empty() && (static_cast<int32_t>(s_nMicros - s_ToDevice.frames.front().nDueMicros) >= 0)) {
+		auto frame = s_ToDevice.frames.front();
+		s_ToDevice.frames.pop_front();
+		tcp_handle(reinterpret_cast<struct t_tcp *>(frame.data));
+		tcp_run();
+	}
+
+	while (!s_ToPeer.frames.empty() && (static_cast<int32_t>(s_nMicros - s_ToPeer.frames.front().nDueMicros) >= 0)) {
+		const auto frame = s_ToPeer.frames.front();
+		s_ToPeer.frames.pop_front();
+
+		const auto *pFrame = reinterpret_cast<const t_tcp *>(frame.data);
+		const auto nPort = __builtin_bswap16(pFrame->tcp.dstpt);
+
+		for (auto& peer : s_Peers) {
+			if ((peer.state != PeerState::IDLE) && (peer.nPort == nPort) && (memcmp(peer.ip, pFrame->ip4.dst, 4) == 0)) {
+				peer_input(peer, pFrame, frame.nLength);
+				break;
+			}
+		}
+	}
+
+	for (auto& peer : s_Peers) {
+		peer_timer(peer);
+	}
+
+	if (static_cast<int32_t>(s_nMicros - s_nTimerMicros) >= 0) {
+		s_nTimerMicros += TIMER_MICROS;
+		tcp_timer();
+	}
+}
+
+/*
+ * The application on the device
+ */
+
+struct Connection {
+	uint32_t nId;
+	uint32_t nReceived;
+	bool hasId;
+};
+
+static Connection s_Connections[TCP_MAX_TCBS_ALLOWED];
+static uint32_t s_nReceived;
+static uint32_t s_nPatternErrors;
+static uint32_t s_nReadIntervalMicros;
+static uint32_t s_nReadMicros;
+
+/*
+ * The first byte of an upload is pattern(nId, 0) == nId.
+ * A TCB is used again after the upload is complete.
+ */
+static void app_read(int32_t nHandle) {
+	if (s_nReadIntervalMicros != 0) {
+		if (static_cast<int32_t>(s_nMicros - s_nReadMicros) < 0) {
+			return;
+		}
+		s_nReadMicros = s_nMicros + s_nReadIntervalMicros;
+	}
+
+	const uint8_t *pData;
+	uint32_t nConnection;
+	uint16_t nLength;
+
+	while ((nLength = tcp_read(nHandle, &pData, nConnection)) > 0) {
+		auto& connection = s_Connections[nConnection];
+
+		if (!connection.hasId) {
+			connection.hasId = true;
+			connection.nId = pData[0];
+		}
+
+		for (uint32_t i = 0; i < nLength; i++) {
+			if (pData[i] != pattern(connection.nId, connection.nReceived + i)) {
+				s_nPatternErrors++;
+				break;
+			}
+		}
+
+		connection.nReceived += nLength;
+		s_nReceived += nLength;
+
+		if ((connection.nId < MAX_PEERS) && (connection.nReceived == s_Peers[connection.nId].nUpload)) {
+			memset(&connection, 0, sizeof(Connection));
+		}
+
+		if (s_nReadIntervalMicros != 0) {
+			return;
+		}
+	}
+}
+
+static void reset() {
+	for (uint32_t i = 0; i < 50000; i++) {
+		sim_step();	// The last ACKs
+	}
+
+	memset(s_Peers, 0, sizeof(s_Peers));
+	memset(s_Connections, 0, sizeof(s_Connections));
+	s_nReceived = 0;
+	s_nPatternErrors = 0;
+	s_ToDevice.frames.clear();
+	s_ToPeer.frames.clear();
+	s_ToDevice.nLossPerMille = s_ToPeer.nLossPerMille = 0;
+	s_ToDevice.isDown = s_ToPeer.isDown = false;
+	s_nReadIntervalMicros = 0;
+}
+
+static Peer& peer_new(uint32_t nId, uint16_t nDevicePort) {
+	auto& peer = s_Peers[nId];
+	memset(&peer, 0, sizeof(Peer));
+	peer.nId = nId;
+	peer.ip[0] = 192;
+	peer.ip[1] = 168;
+	peer.ip[2] = 2;
+	peer.ip[3] = static_cast<uint8_t>(100 + nId);
+	peer.nPort = static_cast<uint16_t>(40000 + (random_next() % 20000));
+	peer.nDevicePort = nDevicePort;
+	return peer;
+}
+
+static bool run_until(bool (*pDone)(), int32_t nHandle0, int32_t nHandle1, uint32_t nMaxSeconds) {
+	const auto nStart = s_nMicros;
+
+	while (!pDone()) {
+		sim_step();
+		app_read(nHandle0);
+		if (nHandle1 >= 0) {
+			app_read(nHandle1);
+		}
+		if ((s_nMicros - nStart) > nMaxSeconds * 1000000) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool all_done() {
+	for (const auto& peer : s_Peers) {
+		if ((peer.state == PeerState::SYN_SENT) || (peer.state == PeerState::ESTABLISHED)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static double mbits(uint32_t nBytes, uint32_t nMicros) {
+	return (nMicros == 0) ? 0 : (static_cast<double>(nBytes) * 8) / nMicros;
+}
+
+static void upload(int32_t nHandle, uint32_t nBytes, uint32_t nLossPerMille, const char *pName, uint32_t nSegmentSize = 0) {
+	auto& peer = peer_new(1, 80);
+	peer.nUpload = nBytes;
+	peer.nSegmentSize = nSegmentSize;
+	s_ToDevice.nLossPerMille = s_ToPeer.nLossPerMille = nLossPerMille;
+
+	peer_connect(peer);
+	const auto isDone = run_until(all_done, nHandle, -1, 120);
+
+	const auto nMicros = peer.nDoneMicros - peer.nStartMicros;
+	const auto nReceived = s_nReceived;
+	const auto nPatternErrors = s_nPatternErrors;
+
+	printf("%-22s %7u bytes %8.1f ms %6.1f Mbit/s  segments %u, ACKs from the device %u (%.2f per segment), retransmitted %u, zero windows %u\n",
+			pName, nReceived, nMicros / 1000.0, mbits(nReceived, nMicros),
+			peer.nSegmentsSent, peer.nAcksReceived, static_cast<double>(peer.nAcksReceived) / peer.nSegmentsSent, peer.nRetransmitsSent, peer.nZeroWindows);
+
+	check(isDone && (peer.state == PeerState::DONE), pName);
+	check(nReceived == nBytes, pName);
+	check(nPatternErrors == 0, pName);
+	check(peer.nChecksumErrors == 0, pName);
+
+	// The window is not larger than the free entries can queue. The first window is before a segment is queued.
+	if (nLossPerMille == 0) {
+		const auto nFirstWindow = (nSegmentSize == 0) ? 0 : (TCP_RX_MAX_ENTRIES * TCP_DATA_SIZE) / nSegmentSize;
+		check(peer.nRetransmitsSent <= nFirstWindow, pName);
+	}
+
+	reset();
+}
+
+/*
+ * The peer sends a request of 4 bytes, the device answers with nBytes
+ */
+static void download(int32_t nHandle, uint32_t nBytes, uint32_t nLossPerMille, const char *pName) {
+	static const uint8_t request[4] = { 'G', 'E', 'T', '\n' };
+
+	auto& peer = peer_new(2, 80);
+	peer.pRequest = request;
+	peer.nRequestLength = sizeof(request);
+	peer.nDownload = nBytes;
+	s_ToDevice.nLossPerMille = s_ToPeer.nLossPerMille = nLossPerMille;
+
+	peer_connect(peer);
+
+	const uint8_t *pData;
+	uint32_t nConnection = 0;
+
+	while (tcp_read(nHandle, &pData, nConnection) != sizeof(request)) {
+		sim_step();
+	}
+
+	static uint8_t buffer[1000];
+	uint32_t nOffset = 0;
+
+	while (nOffset < nBytes) {
+		const auto nLength = std::min(static_cast<uint32_t>(sizeof(buffer)), nBytes - nOffset);
+		for (uint32_t i = 0; i < nLength; i++) {
+			buffer[i] = pattern(peer.nId, nOffset + i);
+		}
+		// tcp_write does not wait, the rest is written in the next pass
+		nOffset += tcp_write(nHandle, buffer, static_cast<uint16_t>(nLength), nConnection);
+		sim_step();
+	}
+
+	const auto isDone = run_until(all_done, nHandle, -1, 120);
+	const auto nMicros = peer.nDoneMicros - peer.nStartMicros;
+
+	printf("%-22s %7u bytes %8.1f ms %6.1f Mbit/s  segments %u (%.0f bytes average), retransmitted %u\n",
+			pName, peer.nReceived, nMicros / 1000.0, mbits(peer.nReceived, nMicros),
+			peer.nDataSegmentsReceived, static_cast<double>(peer.nReceived) / peer.nDataSegmentsReceived, peer.nRetransmitsReceived);
+
+	check(isDone && (peer.state == PeerState::DONE), pName);
+	check(peer.nReceived == nBytes, pName);
+	check(peer.nPatternErrors == 0, pName);
+	check(peer.nChecksumErrors == 0, pName);
+
+	reset();
+}
+
+/*
+ * Three small writes: the number of data segments
+ */
+static uint32_t small_writes(int32_t nHandle, bool isCork, bool isNoDelay) {
+	static const uint8_t request[4] = { 'G', 'E', 'T', '\n' };
+	static constexpr uint32_t LENGTHS[] = { 200, 300, 400 };
+
+	auto& peer = peer_new(3, 80);
+	peer.pRequest = request;
+	peer.nRequestLength = sizeof(request);
+	peer.nDownload = 900;
+	s_ToDevice.nDelayMicros = s_ToPeer.nDelayMicros = 1000;
+
+	peer_connect(peer);
+
+	const uint8_t *pData;
+	uint32_t nConnection = 0;
+
+	while (tcp_read(nHandle, &pData, nConnection) != sizeof(request)) {
+		sim_step();
+	}
+
+	tcp_set_nodelay(nHandle, nConnection, isNoDelay);
+
+	if (isCork) {
+		tcp_set_cork(nHandle, nConnection, true);
+	}
+
+	uint32_t nOffset = 0;
+	uint8_t buffer[400];
+
+	for (const auto nLength : LENGTHS) {
+		for (uint32_t i = 0; i < nLength; i++) {
+			buffer[i] = pattern(peer.nId, nOffset + i);
+		}
+		tcp_write(nHandle, buffer, static_cast<uint16_t>(nLength), nConnection);
+		nOffset += nLength;
+		// The application is busy for 20 µs
+		sim_step();
+		sim_step();
+	}
+
+	if (isCork) {
+		tcp_set_cork(nHandle, nConnection, false);
+	}
+
+	run_until(all_done, nHandle, -1, 10);
+
+	check(peer.nReceived == 900, "small writes");
+	check(peer.nPatternErrors == 0, "small writes");
+
+	const auto nSegments = peer.nDataSegmentsReceived;
+
+	s_ToDevice.nDelayMicros = s_ToPeer.nDelayMicros = 100;
+	reset();
+
+	return nSegments;
+}
+
+int main(int argc, char **argv) {
+	Hardware hw;
+
+	if (argc > 1) {
+		s_nRandom = static_cast<uint32_t>(atoi(argv[1]));
+	}
+
+	s_ToDevice.nDelayMicros = s_ToPeer.nDelayMicros = 100;
+
+	tcp_init();
+
+	const auto nHandle80 = tcp_begin(80);
+	const auto nHandle5000 = tcp_begin(5000);
+
+	check(nHandle80 >= 0, "tcp_begin");
+	check(nHandle5000 >= 0, "tcp_begin");
+	check(tcp_begin(80) == nHandle80, "tcp_begin twice");
+
+	printf("TCP_MAX_TCBS_ALLOWED=%u, TCP_MAX_PORTS_ALLOWED=%u, TCP_RX_MAX_ENTRIES=%u, TCP_TX_BUFFER_SIZE=%u\n",
+			TCP_MAX_TCBS_ALLOWED, TCP_MAX_PORTS_ALLOWED, TCP_RX_MAX_ENTRIES, TCP_TX_BUFFER_SIZE);
+	puts("100 Mbit/s, 100 us one-way delay");
+
+	/*
+	 * Throughput
+	 */
+
+	upload(nHandle80, 1 << 20, 0, "Upload");
+
+	s_nReadIntervalMicros = 2000;
+	upload(nHandle80, 128 * 1024, 0, "Upload, slow reader");
+
+	s_nReadIntervalMicros = 2000;
+	upload(nHandle80, 16 * 1024, 0, "Upload, 100 byte segm.", 100);
+
+	download(nHandle80, 1 << 20, 0, "Download");
+
+	upload(nHandle80, 1 << 20, 10, "Upload, 1% loss");
+	download(nHandle80, 1 << 20, 10, "Download, 1% loss");
+
+	/*
+	 * Concurrency: 16 connections, and one more
+	 */
+
+	{
+		static constexpr uint32_t BYTES = 64 * 1024;
+
+		for (uint32_t i = 1; i <= TCP_MAX_TCBS_ALLOWED + 1; i++) {
+			auto& peer = peer_new(i, 80);
+			peer.nUpload = BYTES;
+		}
+
+		const auto nStart = s_nMicros;
+
+		for (uint32_t i = 1; i <= TCP_MAX_TCBS_ALLOWED; i++) {
+			peer_connect(s_Peers[i]);
+		}
+
+		// The SYN of the last one comes later, there is no TCB
+		for (uint32_t i = 0; i < 50; i++) {
+			sim_step();
+		}
+
+		auto& last = s_Peers[TCP_MAX_TCBS_ALLOWED + 1];
+		peer_connect(last);
+
+		const auto isDone = run_until(all_done, nHandle80, -1, 60);
+
+		uint32_t nDone = 0, nReceived = 0, nPatternErrors = 0, nEnd = 0, nSegments = 0;
+
+		for (uint32_t i = 1; i <= TCP_MAX_TCBS_ALLOWED + 1; i++) {
+			nDone += (s_Peers[i].state == PeerState::DONE);
+			nSegments += s_Peers[i].nSegmentsSent;
+			if (i <= TCP_MAX_TCBS_ALLOWED) {
+				nEnd = std::max(nEnd, s_Peers[i].nDoneMicros - nStart);
+			}
+		}
+
+		nReceived = s_nReceived;
+		nPatternErrors = s_nPatternErrors;
+
+		printf("%u connections x %u bytes: %.1f ms, %.1f Mbit/s aggregate, %u segments; the %uth connected after %.1f ms\n",
+				TCP_MAX_TCBS_ALLOWED, BYTES, nEnd / 1000.0, mbits(TCP_MAX_TCBS_ALLOWED * BYTES, nEnd), nSegments,
+				TCP_MAX_TCBS_ALLOWED + 1, (last.nDoneMicros - last.nStartMicros) / 1000.0);
+
+		check(isDone, "concurrency");
+		check(nDone == TCP_MAX_TCBS_ALLOWED + 1, "concurrency");
+		check(nPatternErrors == 0, "concurrency");
+		check(nReceived == (TCP_MAX_TCBS_ALLOWED + 1) * BYTES, "concurrency");
+		check(last.nSegmentsSent > 0 && (last.nDoneMicros - last.nStartMicros) >= 1000000, "SYN without TCB");
+
+		reset();
+	}
+
+	/*
+	 * Two listening ports, and a port without a listener
+	 */
+
+	{
+		auto& peer1 = peer_new(4, 80);
+		peer1.nUpload = 100000;
+		auto& peer2 = peer_new(5, 5000);
+		peer2.nUpload = 100000;
+		auto& peer3 = peer_new(6, 81);
+		peer3.nUpload = 1000;
+
+		peer_connect(peer1);
+		peer_connect(peer2);
+		peer_connect(peer3);
+
+		const auto isDone = run_until(all_done, nHandle80, nHandle5000, 10);
+
+		uint32_t nReceived = 0, nPatternErrors = 0;
+
+		nReceived = s_nReceived;
+		nPatternErrors = s_nPatternErrors;
+
+		printf("Port 80 and 5000: %u bytes, port 81: %s\n", nReceived, (peer3.state == PeerState::RESET) ? "RST" : "no RST");
+
+		check(isDone && (peer1.state == PeerState::DONE) && (peer2.state == PeerState::DONE), "two ports");
+		check(nReceived == 200000, "two ports");
+		check(nPatternErrors == 0, "two ports");
+		check(peer3.state == PeerState::RESET, "no listener");
+
+		reset();
+	}
+
+	/*
+	 * Cork and Nagle, 1 ms one-way delay
+	 */
+
+	const auto nCork = small_writes(nHandle80, true, false);
+	const auto nNagle = small_writes(nHandle80, false, false);
+	const auto nNoDelay = small_writes(nHandle80, false, true);
+
+	printf("Writes of 200, 300, 400 bytes: cork %u segment(s), Nagle %u, no delay %u\n", nCork, nNagle, nNoDelay);
+
+	check(nCork == 1, "cork");
+	check(nNagle == 2, "Nagle");
+	check(nNoDelay == 3, "no delay");
+
+	/*
+	 * The delayed ACK for a single segment
+	 */
+
+	{
+		auto& peer = peer_new(7, 80);
+		peer.nUpload = 100;
+		peer.isFinHeld = true;
+		peer_connect(peer);
+
+		// Up to the ACK of the handshake
+		while (peer.state != PeerState::ESTABLISHED) {
+			sim_step();
+		}
+
+		const auto nSent = s_nMicros;
+		const auto nAcks = peer.nAcksReceived;
+
+		while ((peer.nAcksReceived == nAcks) && ((s_nMicros - nSent) < 1000000)) {
+			sim_step();
+			app_read(nHandle80);
+		}
+
+		const auto nDelay = peer.nLastAckMicros - nSent;
+		printf("Delayed ACK of a single segment: %.1f ms\n", nDelay / 1000.0);
+
+		check((nDelay > 1000) && (nDelay <= 200000), "delayed ACK");
+
+		peer.isFinHeld = false;
+		peer_output(peer);
+
+		run_until(all_done, nHandle80, -1, 10);
+		check(peer.state == PeerState::DONE, "delayed ACK");
+
+		reset();
+	}
+
+	/*
+	 * The peer disappears during a download
+	 */
+
+	{
+		static const uint8_t request[4] = { 'G', 'E', 'T', '\n' };
+
+		auto& peer = peer_new(8, 80);
+		peer.pRequest = request;
+		peer.nRequestLength = sizeof(request);
+		peer.nDownload = 100000;
+
+		peer_connect(peer);
+
+		const uint8_t *pData;
+		uint32_t nConnection = 0;
+
+		while (tcp_read(nHandle80, &pData, nConnection) != sizeof(request)) {
+			sim_step();
+		}
+
+		static uint8_t buffer[1000];
+		tcp_write(nHandle80, buffer, sizeof(buffer), nConnection);
+		check(tcp_write_space(nHandle80, nConnection) == TCP_TX_BUFFER_SIZE - sizeof(buffer), "tcp_write_space");
+
+		s_ToDevice.isDown = s_ToPeer.isDown = true;
+
+		const auto nStart = s_nMicros;
+		const auto nResetsSent = s_nResetsSent;
+
+		// The ring is full, tcp_write returns at once with what is queued
+		uint32_t nQueued = 0;
+
+		for (uint32_t i = 0; i < 5; i++) {
+			nQueued += tcp_write(nHandle80, buffer, sizeof(buffer), nConnection);
+		}
+
+		check(nQueued == TCP_TX_BUFFER_SIZE - sizeof(buffer), "tcp_write queued");
+
+		const auto nWriteMillis = (s_nMicros - nStart) / 1000;
+
+		while ((s_nResetsSent == nResetsSent) && ((s_nMicros - nStart) < 300000000)) {
+			sim_step();
+		}
+
+		printf("The peer is gone: tcp_write returns after %u ms, the connection is reset after %.1f s\n", nWriteMillis, (s_nMicros - nStart) / 1000000.0);
+
+		check(nWriteMillis == 0, "tcp_write does not wait");
+
+		check(s_nResetsSent != nResetsSent, "dead peer");
+		check(tcp_write_space(nHandle80, nConnection) == 0, "dead peer");
+
+		reset();
+	}
+
+	check(tcp_end(nHandle5000) == -1, "tcp_end");
+	check(tcp_begin(5001) == nHandle5000, "tcp_begin after tcp_end");
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
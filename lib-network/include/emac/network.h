@@ -92,6 +92,7 @@ public:
 	}
 
 	bool EnableDhcp();
+	void HandleDhcpEvent(const net::dhcp::Event event, const struct DhcpLease *pLease);
 
 	bool IsDhcpUsed() const {
 		return m_IsDhcpUsed;
@@ -162,6 +163,17 @@ public:
 		udp_send(nHandle, reinterpret_cast<const uint8_t *>(pBuffer), nLength, to_ip, remote_port);
 	}
 
+	/**
+	 * Queue a datagram, the DMA is started once by SendFlush().
+	 */
+	void SendToQueued(int32_t nHandle, const void *pBuffer, uint16_t nLength, uint32_t to_ip, uint16_t remote_port) {
+		udp_send_queued(nHandle, reinterpret_cast<const uint8_t *>(pBuffer), nLength, to_ip, remote_port);
+	}
+
+	void SendFlush() {
+		udp_send_flush();
+	}
+
 	/*
 	 * TCP/IP
 	 */
@@ -170,14 +182,28 @@ public:
 		return tcp_begin(nLocalPort);
 	}
 
-	int32_t TcpEnd(const int32_t nHandle);
+	int32_t TcpEnd(const int32_t nHandle) {
+		return tcp_end(nHandle);
+	}
 
 	uint16_t TcpRead(const int32_t nHandleListen, const uint8_t **ppBuffer, uint32_t &HandleConnection) {
 		return tcp_read(nHandleListen, ppBuffer, HandleConnection);
 	}
 
-	void TcpWrite(const int32_t nHandleListen, const uint8_t *pBuffer, uint16_t nLength, const uint32_t HandleConnection) {
-		tcp_write(nHandleListen, pBuffer, nLength, HandleConnection);
+	uint32_t TcpWrite(const int32_t nHandleListen, const uint8_t *pBuffer, uint16_t nLength, const uint32_t HandleConnection) {
+		return tcp_write(nHandleListen, pBuffer, nLength, HandleConnection);
+	}
+
+	uint32_t TcpWriteSpace(const int32_t nHandleListen, const uint32_t HandleConnection) {
+		return tcp_write_space(nHandleListen, HandleConnection);
+	}
+
+	void TcpSetNoDelay(const int32_t nHandleListen, const uint32_t HandleConnection, const bool isNoDelay) {
+		tcp_set_nodelay(nHandleListen, HandleConnection, isNoDelay);
+	}
+
+	void TcpSetCork(const int32_t nHandleListen, const uint32_t HandleConnection, const bool isCorked) {
+		tcp_set_cork(nHandleListen, HandleConnection, isCorked);
 	}
 
 	/*
@@ -192,6 +218,17 @@ public:
 		igmp_leave(nIp);
 	}
 
+	/**
+	 * IGMPv3 source specific multicast, a host can join up to 2 sources of a group.
+	 */
+	void JoinGroupSource(__attribute__((unused)) int32_t nHandle, uint32_t nIp, uint32_t nSourceIp) {
+		igmp_join_source(nIp, nSourceIp);
+	}
+
+	void LeaveGroupSource(__attribute__((unused)) int32_t nHandle, uint32_t nIp, uint32_t nSourceIp) {
+		igmp_leave_source(nIp, nSourceIp);
+	}
+
 	void SetQueuedStaticIp(uint32_t nLocalIp = 0, uint32_t nNetmask = 0);
 	void SetQueuedDhcp() {
 		m_QueuedConfig.nMask |= QueuedConfig::DHCP;
@@ -264,6 +301,7 @@ private:
 	bool m_IsDhcpUsed { false };
 	bool m_IsZeroconfCapable { true };
 	bool m_IsZeroconfUsed { false };
+	uint8_t m_nDhcpRetryTime { 0 };	///< Minutes
 	uint32_t m_nIfIndex { 1 };
 	uint32_t m_nNtpServerIp { 0 };
 	float m_fNtpUtcOffset { 0 };
@@ -93,6 +93,13 @@ public:
 	uint16_t RecvFrom(int32_t nHandle, const void **ppBuffer, uint32_t *pFromIp, uint16_t *pFromPort);
 	void SendTo(int32_t nHandle, const void *pBuffer, uint16_t nLength, uint32_t nToIp, uint16_t nRemotePort) ;
 
+	void SendToQueued(int32_t nHandle, const void *pBuffer, uint16_t nLength, uint32_t nToIp, uint16_t nRemotePort) {
+		SendTo(nHandle, pBuffer, nLength, nToIp, nRemotePort);
+	}
+
+	void SendFlush() {
+	}
+
 	void Print() {
 	}
 
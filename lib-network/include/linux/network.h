@@ -52,10 +52,18 @@ public:
 
 	void JoinGroup(int32_t nHandle, uint32_t nIp);
 	void LeaveGroup(int32_t nHandle, uint32_t nIp);
+	void JoinGroupSource(int32_t nHandle, uint32_t nIp, uint32_t nSourceIp);
+	void LeaveGroupSource(int32_t nHandle, uint32_t nIp, uint32_t nSourceIp);
 
 	uint16_t RecvFrom(int32_t nHandle, void *pBuffer, uint16_t nLength, uint32_t *pFromIp, uint16_t *pFromPort);
 	uint16_t RecvFrom(int32_t nHandle, const void **ppBuffer, uint32_t *pFromIp, uint16_t *pFromPort);
 	void SendTo(int32_t nHandle, const void *pBuffer, uint16_t nLength, uint32_t nToIp, uint16_t nRemotePort);
+	/**
+	 * The datagram is not copied: pBuffer must stay valid and unchanged until SendFlush().
+	 * Consecutive datagrams for the same handle are sent with a single sendmmsg().
+	 */
+	void SendToQueued(int32_t nHandle, const void *pBuffer, uint16_t nLength, uint32_t nToIp, uint16_t nRemotePort);
+	void SendFlush();
 
 	void SetIp(uint32_t nIp);
 	void SetNetmask(uint32_t nNetmask);
@@ -197,8 +205,11 @@ public:
 
 	int32_t TcpBegin(uint16_t nLocalPort);
 	uint16_t TcpRead(const int32_t nHandle, const uint8_t **ppBuffer, uint32_t &HandleConnection);
-	void TcpWrite(const int32_t nHandle, const uint8_t *pBuffer, uint16_t nLength, const uint32_t HandleConnection);
+	uint32_t TcpWrite(const int32_t nHandle, const uint8_t *pBuffer, uint16_t nLength, const uint32_t HandleConnection);
 	int32_t TcpEnd(const int32_t nHandle);
+	uint32_t TcpWriteSpace(const int32_t nHandle, const uint32_t HandleConnection);
+	void TcpSetNoDelay(const int32_t nHandle, const uint32_t HandleConnection, const bool isNoDelay);
+	void TcpSetCork(const int32_t nHandle, const uint32_t HandleConnection, const bool isCorked);
 
 private:
 	uint32_t GetDefaultGateway();
@@ -54,6 +54,21 @@ struct ServiceRecord {
 	uint16_t nPort;
 	mdns::Services services;
 };
+
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+/**
+ * A service instance discovered on the network, kept until its TTL has expired.
+ */
+struct ServiceInstance {
+	char aName[network::HOSTNAME_SIZE];		///< Instance name
+	char aHostName[network::HOSTNAME_SIZE];	///< SRV target, without .local
+	uint32_t nIp;							///< 0 when the A record is not received yet
+	uint32_t nTTL;							///< PTR record TTL (in seconds)
+	uint32_t nExpireMillis;
+	uint16_t nPort;							///< 0 when the SRV record is not received yet
+	mdns::Services services;
+};
+#endif
 }  // namespace mdns
 
 class MDNS {
@@ -68,6 +83,19 @@ public:
 
 	void SendAnnouncement(const uint32_t nTTL);
 
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+	/**
+	 * Multicasts a PTR question for the service type, the cached instances are included as known answers.
+	 * The responses are handled in Run().
+	 */
+	void ServiceQuery(const mdns::Services service);
+	/**
+	 * @param nIndex 0 .. n-1
+	 * @return the nIndex-th service instance in the cache, nullptr when there are no more
+	 */
+	const mdns::ServiceInstance *ServiceInstanceGet(const mdns::Services service, const uint32_t nIndex);
+#endif
+
 	void Run() {
 		s_nBytesReceived = Network::Get()->RecvFrom(s_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&s_pReceiveBuffer)), &s_nRemoteIp, &s_nRemotePort);
 
@@ -82,6 +110,13 @@ public:
 			return;
 		}
 
+		if (nFlag1 & 0x80) {
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+			HandleResponse();
+#endif
+			return;
+		}
+
 		HandleQuestions(__builtin_bswap16(pHeader->nQueryCount));
 	}
 
@@ -92,9 +127,15 @@ public:
 private:
 	void Parse();
 	void HandleQuestions(const uint32_t nQuestions);
+	void HandleKnownAnswers(uint32_t nOffset, const uint32_t nAnswers);
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+	void HandleResponse();
+#endif
 	void SendAnswerLocalIpAddress(const uint16_t nTransActionID, const uint32_t nTTL);
+	uint16_t CreateMessage(mdns::ServiceRecord const& serviceRecord, const uint16_t nTransActionID, const uint32_t nTTL);
 	void SendMessage(mdns::ServiceRecord const& serviceRecord, const uint16_t nTransActionID, const uint32_t nTTL);
-	void SendTo(const uint16_t nLength);
+	void SendCachedMessage(const uint32_t nIndex);
+	void SendTo(const uint8_t *pData, const uint16_t nLength);
 
 private:
 	static int32_t s_nHandle;
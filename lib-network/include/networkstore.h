@@ -32,6 +32,7 @@
 
 #include "networkparams.h"
 #include "configstore.h"
+#include "dhcplease.h"
 
 class NetworkStore {
 public:
@@ -55,6 +56,17 @@ public:
 	static void SaveDhcp(bool bIsDhcpUsed) {
 		ConfigStore::Get()->Update(configstore::Store::NETWORK, offsetof(struct networkparams::Params, bIsDhcpUsed), &bIsDhcpUsed, sizeof(bool), networkparams::Mask::DHCP);
 	}
+
+	/**
+	 * Only a changed lease is written, not every renewal
+	 */
+	static void SaveDhcpLease(const struct DhcpLease *pLease) {
+		ConfigStore::Get()->Update(configstore::Store::DHCP, pLease, sizeof(struct DhcpLease));
+	}
+
+	static void CopyDhcpLease(struct DhcpLease *pLease) {
+		ConfigStore::Get()->Copy(configstore::Store::DHCP, pLease, sizeof(struct DhcpLease), 0, false);
+	}
 };
 
 #endif /* NETWORKSTORE_H_ */
@@ -27,6 +27,7 @@
 #define NTP_H_
 
 #include <cstdint>
+#include <sys/time.h>
 
 namespace ntp {
 static constexpr uint32_t LOCAL_TIME_YEAR_OFFSET = 1900;
@@ -35,6 +36,8 @@ static constexpr uint16_t UDP_PORT = 123;
 static constexpr uint8_t  VERSION = (4U << 3);
 static constexpr uint8_t  MODE_CLIENT = (3U << 0);
 static constexpr uint8_t  MODE_SERVER = (4U << 0);
+static constexpr uint8_t  MODE_MASK = 0x07;
+static constexpr uint8_t  LI_ALARM = (3U << 6);	///< Clock not synchronised
 static constexpr uint8_t  STRATUM = 2;
 static constexpr uint8_t  MINPOLL = 4;
 
@@ -55,6 +58,33 @@ struct Packet {
 	uint32_t TransmitTimestamp_s;
 	uint32_t TransmitTimestamp_f;
 }__attribute__((packed));
+
+struct TimeStamp {
+	uint32_t nSeconds;	///< Since 01.01.1900
+	uint32_t nFraction;
+};
+
+/**
+ * The system clock (local time) in NTP format (UTC)
+ */
+inline void get_time_ntp_format(const int32_t nUtcOffset, struct TimeStamp& timeStamp) {
+	struct timeval now;
+	gettimeofday(&now, nullptr);
+	timeStamp.nSeconds = static_cast<uint32_t>(now.tv_sec - nUtcOffset) + NTP_TIMESTAMP_DELTA;
+	timeStamp.nFraction = static_cast<uint32_t>((static_cast<uint64_t>(now.tv_usec) << 32) / 1000000U);
+}
+
+inline uint32_t fraction_to_micros(const uint32_t nFraction) {
+	return static_cast<uint32_t>((static_cast<uint64_t>(nFraction) * 1000000U) >> 32);
+}
+
+/**
+ * @return (a - b) in microseconds, also over the era boundary
+ */
+inline int64_t difference_micros(const struct TimeStamp& a, const struct TimeStamp& b) {
+	const auto nSeconds = static_cast<int32_t>(a.nSeconds - b.nSeconds);
+	return (static_cast<int64_t>(nSeconds) * 1000000) + static_cast<int64_t>(fraction_to_micros(a.nFraction)) - static_cast<int64_t>(fraction_to_micros(b.nFraction));
+}
 }  // namespace ntp
 
 #endif /* NTP_H_ */
@@ -31,13 +31,13 @@
 #include <time.h>
 
 #include "ntp.h"
+#include "ntpclock.h"
 #include "hardware.h"
 
 #include "debug.h"
 
 namespace ntpclient {
 static constexpr uint32_t TIMEOUT_MILLIS = 3000; 	// 3 seconds
-static constexpr uint32_t POLL_SECONDS = 1024;		// 2ˆ10
 
 enum class Status {
 	STOPPED, IDLE, WAITING, FAILED
@@ -46,6 +46,11 @@ enum class Status {
 void display_status(const Status status);
 }  // namespace ntpclient
 
+/**
+ * The system clock is disciplined by NtpClock: stepped once, then slewed with adjtime.
+ * Nothing blocks, the requests are sent by Run with the poll interval of NtpClock.
+ * The status is IDLE when the clock is synchronised and no request is waiting for the reply.
+ */
 class NtpClient {
 public:
 	NtpClient(const uint32_t nServerIp = 0);
@@ -58,55 +63,57 @@ public:
 		return m_Status;
 	}
 
+	bool IsSynchronised() const {
+		return m_NtpClock.IsSynchronised();
+	}
+
+	uint32_t GetServerIp() const {
+		return m_nServerIp;
+	}
+
+	uint8_t GetStratum() const {
+		return m_nStratum;
+	}
+
+	const NtpClock& GetClock() const {
+		return m_NtpClock;
+	}
+
+	/**
+	 * The last update of the clock, for the reference time stamp of SntpServer
+	 */
+	const struct ntp::TimeStamp& GetReferenceTime() const {
+		return m_ReferenceTime;
+	}
+
 	void Run() {
 		if (m_Status == ntpclient::Status::STOPPED) {
 			return;
 		}
 
-		if ((m_Status == ntpclient::Status::IDLE) || (m_Status == ntpclient::Status::FAILED)) {
-			if (__builtin_expect(((Hardware::Get()->Millis() - m_MillisLastPoll) > (1000 * ntpclient::POLL_SECONDS)), 0)) {
-				Send();
-				m_MillisRequest = Hardware::Get()->Millis();
-				m_Status = ntpclient::Status::WAITING;
-				ntpclient::display_status(ntpclient::Status::WAITING);
-				DEBUG_PUTS("ntpclient::Status::WAITING");
-			}
+		const auto nMillis = Hardware::Get()->Millis();
 
-			return;
+		if (__builtin_expect(((nMillis - m_nMillisAdjust) >= 1000), 0)) {
+			m_nMillisAdjust += 1000;
+			Adjust();
 		}
 
-		if (m_Status == ntpclient::Status::WAITING) {
-			uint8_t LiVnMode;
-
-			if (!Receive(LiVnMode)) {
-				if (__builtin_expect(((Hardware::Get()->Millis() - m_MillisRequest) > ntpclient::TIMEOUT_MILLIS), 0)) {
-					m_Status = ntpclient::Status::FAILED;
-					ntpclient::display_status(ntpclient::Status::FAILED);
-					DEBUG_PUTS("ntpclient::Status::FAILED");
-				}
+		Receive(nMillis);
 
-				return;
+		if (!m_bRequest) {
+			if (__builtin_expect(((nMillis - m_MillisLastPoll) >= m_NtpClock.GetPollMillis()), 0)) {
+				m_MillisLastPoll = nMillis;
+				m_bRequest = true;
+				Send();
+				SetStatus(ntpclient::Status::WAITING);
 			}
 
-			if (__builtin_expect(((LiVnMode & ntp::MODE_SERVER) == ntp::MODE_SERVER), 1)) {
-				m_MillisLastPoll = Hardware::Get()->Millis();
-
-				if (SetTimeOfDay() == 0) {
-#ifndef NDEBUG
-					const auto nTime = time(nullptr);
-					const auto *pLocalTime = localtime(&nTime);
-					DEBUG_PRINTF("localtime: %.4d/%.2d/%.2d %.2d:%.2d:%.2d", pLocalTime->tm_year, pLocalTime->tm_mon, pLocalTime->tm_mday, pLocalTime->tm_hour, pLocalTime->tm_min, pLocalTime->tm_sec);
-#endif
-				} else {
-					// Error
-				}
-			} else {
-				DEBUG_PUTS("!>> Invalid reply <<!");
-			}
+			return;
+		}
 
-			m_Status = ntpclient::Status::IDLE;
-			ntpclient::display_status(ntpclient::Status::IDLE);
-			DEBUG_PUTS("ntpclient::Status::IDLE");
+		if (__builtin_expect(((nMillis - m_MillisLastPoll) > ntpclient::TIMEOUT_MILLIS), 0)) {
+			m_bRequest = false;
+			SetStatus(ntpclient::Status::FAILED);
 		}
 	}
 
@@ -115,36 +122,40 @@ public:
 	}
 
 private:
-	void GetTimeNtpFormat(uint32_t &nSeconds, uint32_t &nFraction);
 	void Send();
-	bool Receive(uint8_t& LiVnMode);
-
-	struct TimeStamp {
-		uint32_t nSeconds;
-		uint32_t nFraction;
-	};
-
-	void Difference(const struct TimeStamp *Start, const struct TimeStamp *Stop, int32_t &nDiffSeconds, uint32_t &nDiffFraction);
-	int SetTimeOfDay();
+	void Receive(const uint32_t nMillis);
+	void Update(const uint32_t nMillis);
+	void Adjust();
+	void Step(const int64_t nStepMicros);
+
+	void SetStatus(const ntpclient::Status status) {
+		if (m_Status != status) {
+			m_Status = status;
+			ntpclient::display_status(status);
+		}
+	}
 
-	void PrintNtpTime(const char *pText, const struct TimeStamp *pNtpTime);
+	void PrintNtpTime(const char *pText, const struct ntp::TimeStamp *pNtpTime);
 
 private:
 	uint32_t m_nServerIp;
 	int32_t m_nUtcOffset;
 	int32_t m_nHandle { -1 };
-	int32_t m_nOffsetSeconds { 0 };
-	uint32_t m_nOffsetMicros { 0 };
-	uint32_t m_MillisRequest { 0 };
 	uint32_t m_MillisLastPoll { 0 };
+	uint32_t m_nMillisAdjust { 0 };
+	uint8_t m_nStratum { 0 };
+	bool m_bRequest { false };
 
-	struct TimeStamp T1 { 0, 0 };	// time request sent by client
-	struct TimeStamp T2 { 0, 0 };	// time request received by server
-	struct TimeStamp T3 { 0, 0 };	// time reply sent by server
-	struct TimeStamp T4 { 0, 0 };	// time reply received by client
+	struct ntp::TimeStamp T1 { 0, 0 };	// time request sent by client
+	struct ntp::TimeStamp T2 { 0, 0 };	// time request received by server
+	struct ntp::TimeStamp T3 { 0, 0 };	// time reply sent by server
+	struct ntp::TimeStamp T4 { 0, 0 };	// time reply received by client
+	struct ntp::TimeStamp m_ReferenceTime { 0, 0 };
 
 	struct ntp::Packet m_Request;
 
+	NtpClock m_NtpClock;
+
 	ntpclient::Status m_Status { ntpclient::Status::STOPPED };
 
 	static NtpClient *s_pThis;
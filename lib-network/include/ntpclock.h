@@ -0,0 +1,164 @@
+/**
+ * @file ntpclock.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef NTPCLOCK_H_
+#define NTPCLOCK_H_
+
+#include <cstdint>
+
+#include "ntp.h"
+
+/**
+ * The discipline of the system clock with the samples of an NTP server.
+ * - Filter: the sample with the least delay of the last FILTER_SIZE is selected,
+ *   the delay of a sample grows with its age (PHI, as in RFC 5905). A selected
+ *   sample with a delay far above the least delay in the filter is a spike.
+ * - A large offset is stepped, a small offset is slewed.
+ * - Frequency: the offset left after the phase correction, divided by the time.
+ * The clock itself is not touched: the caller applies the step and the slew.
+ */
+namespace ntpclock {
+static constexpr uint32_t FILTER_SIZE = 8;
+static constexpr uint32_t BURST = 4;							///< Samples before the first update
+static constexpr uint32_t BURST_MILLIS = 2000;
+static constexpr int64_t STEP_THRESHOLD_MICROS = 128000;		///< As ntpd
+static constexpr int32_t DELAY_MAX_MICROS = 1000000;
+static constexpr uint32_t PHI_MICROS_PER_SECOND = 15;		///< Frequency tolerance, 15 ppm
+static constexpr int32_t DELAY_GATE_MICROS = 500;			///< A delay above 2 * the least delay + gate is a spike
+static constexpr int32_t SLEW_MAX_MICROS = 500;				///< In one second, 500 ppm
+static constexpr int32_t FREQUENCY_MAX = (500 << 16);		///< ppm * 2^16
+static constexpr uint32_t FREQUENCY_SECONDS_MIN = 8;
+static constexpr uint32_t FREQUENCY_SHIFT = 1;				///< Gain 1/2
+static constexpr int32_t PHASE_DIVISOR = 8;					///< Each second 1/8 of the phase
+static constexpr uint32_t MINPOLL = ntp::MINPOLL;			///< 16 seconds
+static constexpr uint32_t MAXPOLL = 10;						///< 1024 seconds
+static constexpr int64_t POLL_STABLE_MICROS = 1000;
+static constexpr int64_t POLL_UNSTABLE_MICROS = 4000;
+static constexpr uint32_t POLL_STABLE_COUNT = 4;
+
+enum class Action {
+	NONE, UPDATE, STEP
+};
+
+struct Sample {
+	int64_t nOffsetMicros;
+	int32_t nDelayMicros;
+	uint32_t nMillis;
+};
+}  // namespace ntpclock
+
+class NtpClock {
+public:
+	NtpClock() {
+		Reset();
+	}
+
+	void Reset();
+
+	/**
+	 * @param T1 Request sent by the client
+	 * @param T2 Request received by the server
+	 * @param T3 Reply sent by the server
+	 * @param T4 Reply received by the client
+	 */
+	static void Compute(const struct ntp::TimeStamp& T1, const struct ntp::TimeStamp& T2, const struct ntp::TimeStamp& T3, const struct ntp::TimeStamp& T4, int64_t& nOffsetMicros, int32_t& nDelayMicros) {
+		const auto nOut = ntp::difference_micros(T2, T1);
+		const auto nBack = ntp::difference_micros(T3, T4);
+		nOffsetMicros = (nOut + nBack) / 2;
+		nDelayMicros = static_cast<int32_t>(nOut - nBack);
+	}
+
+	/**
+	 * @param nMillis The time of the sample, Hardware::Millis
+	 * @return Action::STEP, the clock must be set with GetStepMicros
+	 */
+	ntpclock::Action Sample(const int64_t nOffsetMicros, const int32_t nDelayMicros, const uint32_t nMillis);
+
+	/**
+	 * To be called once a second
+	 * @return The microseconds to slew the clock in the next second
+	 */
+	int32_t Adjust();
+
+	int64_t GetStepMicros() const {
+		return m_nStepMicros;
+	}
+
+	bool IsSynchronised() const {
+		return m_bSynchronised;
+	}
+
+	uint32_t GetPollMillis() const {
+		if (!m_bSynchronised) {
+			return ntpclock::BURST_MILLIS;
+		}
+		return 1000U << m_nPoll;
+	}
+
+	uint32_t GetPoll() const {
+		return m_nPoll;
+	}
+
+	int64_t GetOffsetMicros() const {
+		return m_nOffsetMicros;
+	}
+
+	int32_t GetDelayMicros() const {
+		return m_nDelayMicros;
+	}
+
+	/**
+	 * @return The frequency correction in ppb
+	 */
+	int32_t GetFrequencyPpb() const {
+		return static_cast<int32_t>((static_cast<int64_t>(m_nFrequency) * 1000) / (1 << 16));
+	}
+
+	uint32_t GetSteps() const {
+		return m_nSteps;
+	}
+
+private:
+	int32_t Select(const uint32_t nMillis, int32_t& nDelayMin) const;
+	ntpclock::Action Step(const int64_t nOffsetMicros, const uint32_t nMillis);
+
+private:
+	ntpclock::Sample m_Filter[ntpclock::FILTER_SIZE];
+	uint32_t m_nFilterIndex;
+	uint32_t m_nSamples;
+	uint32_t m_nMillisLastUsed;
+	int64_t m_nOffsetMicros;
+	int64_t m_nStepMicros;
+	int64_t m_nPhaseMicros;		///< Left to slew
+	int32_t m_nDelayMicros;
+	int32_t m_nFrequency;		///< ppm * 2^16
+	int32_t m_nFrequencyRemainder;
+	uint32_t m_nPoll;
+	uint32_t m_nPollStable;
+	uint32_t m_nSteps;
+	bool m_bSynchronised;
+};
+
+#endif /* NTPCLOCK_H_ */
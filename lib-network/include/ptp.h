@@ -0,0 +1,152 @@
+/**
+ * @file ptp.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PTP_H_
+#define PTP_H_
+
+#include <cstdint>
+
+/**
+ * IEEE 1588-2008 (PTPv2), UDP over IPv4, the messages of an end-to-end ordinary clock.
+ * All the fields are big endian.
+ */
+namespace ptp {
+static constexpr uint16_t UDP_PORT_EVENT = 319;
+static constexpr uint16_t UDP_PORT_GENERAL = 320;
+static constexpr uint32_t MULTICAST_IP = (224U << 0) | (0U << 8) | (1U << 16) | (129U << 24);	///< 224.0.1.129
+static constexpr uint8_t VERSION = 2;
+static constexpr uint8_t DOMAIN = 0;
+static constexpr uint32_t CLOCK_IDENTITY_LENGTH = 8;
+
+namespace message {
+static constexpr uint8_t SYNC = 0x0;
+static constexpr uint8_t DELAY_REQ = 0x1;
+static constexpr uint8_t FOLLOW_UP = 0x8;
+static constexpr uint8_t DELAY_RESP = 0x9;
+static constexpr uint8_t ANNOUNCE = 0xB;
+static constexpr uint8_t TYPE_MASK = 0x0F;
+}  // namespace message
+
+namespace control {
+static constexpr uint8_t SYNC = 0;
+static constexpr uint8_t DELAY_REQ = 1;
+static constexpr uint8_t FOLLOW_UP = 2;
+static constexpr uint8_t DELAY_RESP = 3;
+static constexpr uint8_t OTHER = 5;
+}  // namespace control
+
+namespace flag {
+static constexpr uint16_t TWO_STEP = 0x0200;
+static constexpr uint16_t UNICAST = 0x0400;
+static constexpr uint16_t UTC_OFFSET_VALID = 0x0004;
+}  // namespace flag
+
+static constexpr int8_t LOG_MESSAGE_INTERVAL_UNUSED = 0x7F;
+
+struct Timestamp {
+	uint16_t SecondsHigh;
+	uint32_t SecondsLow;
+	uint32_t Nanoseconds;
+} __attribute__((packed));
+
+struct Header {
+	uint8_t TransportSpecificMessageType;
+	uint8_t Version;
+	uint16_t MessageLength;
+	uint8_t DomainNumber;
+	uint8_t Reserved1;
+	uint16_t FlagField;
+	int64_t CorrectionField;	///< ns * 2^16
+	uint32_t Reserved2;
+	uint8_t ClockIdentity[CLOCK_IDENTITY_LENGTH];
+	uint16_t PortNumber;
+	uint16_t SequenceId;
+	uint8_t ControlField;
+	int8_t LogMessageInterval;
+} __attribute__((packed));
+
+/**
+ * Sync, Delay_Req and Follow_Up
+ */
+struct Event {
+	struct Header Header;
+	struct Timestamp Timestamp;
+} __attribute__((packed));
+
+struct DelayResp {
+	struct Header Header;
+	struct Timestamp ReceiveTimestamp;
+	uint8_t RequestingClockIdentity[CLOCK_IDENTITY_LENGTH];
+	uint16_t RequestingPortNumber;
+} __attribute__((packed));
+
+struct Announce {
+	struct Header Header;
+	struct Timestamp OriginTimestamp;
+	int16_t CurrentUtcOffset;
+	uint8_t Reserved;
+	uint8_t GrandmasterPriority1;
+	uint8_t GrandmasterClockClass;
+	uint8_t GrandmasterClockAccuracy;
+	uint16_t GrandmasterClockVariance;
+	uint8_t GrandmasterPriority2;
+	uint8_t GrandmasterIdentity[CLOCK_IDENTITY_LENGTH];
+	uint16_t StepsRemoved;
+	uint8_t TimeSource;
+} __attribute__((packed));
+
+static_assert(sizeof(struct Header) == 34, "");
+static_assert(sizeof(struct Event) == 44, "");
+static_assert(sizeof(struct DelayResp) == 54, "");
+static_assert(sizeof(struct Announce) == 64, "");
+
+/**
+ * @return The PTP time (TAI) in nanoseconds, valid until the year 2262
+ */
+inline int64_t timestamp_to_nanos(const struct Timestamp& timestamp) {
+	const auto nSeconds = (static_cast<uint64_t>(__builtin_bswap16(timestamp.SecondsHigh)) << 32) | __builtin_bswap32(timestamp.SecondsLow);
+	return static_cast<int64_t>(nSeconds * 1000000000U) + __builtin_bswap32(timestamp.Nanoseconds);
+}
+
+inline void nanos_to_timestamp(const int64_t nNanos, struct Timestamp& timestamp) {
+	const auto nSeconds = static_cast<uint64_t>(nNanos / 1000000000);
+	timestamp.SecondsHigh = __builtin_bswap16(static_cast<uint16_t>(nSeconds >> 32));
+	timestamp.SecondsLow = __builtin_bswap32(static_cast<uint32_t>(nSeconds));
+	timestamp.Nanoseconds = __builtin_bswap32(static_cast<uint32_t>(nNanos % 1000000000));
+}
+
+/**
+ * @return The correction field in nanoseconds, the sub-nanoseconds are dropped
+ */
+inline int64_t correction_to_nanos(const int64_t nCorrectionField) {
+	return static_cast<int64_t>(__builtin_bswap64(static_cast<uint64_t>(nCorrectionField))) >> 16;
+}
+
+inline int64_t nanos_to_correction(const int64_t nNanos) {
+	return static_cast<int64_t>(__builtin_bswap64(static_cast<uint64_t>(nNanos * 65536)));
+}
+}  // namespace ptp
+
+#endif /* PTP_H_ */
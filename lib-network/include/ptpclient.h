@@ -0,0 +1,169 @@
+/**
+ * @file ptpclient.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PTPCLIENT_H_
+#define PTPCLIENT_H_
+
+#include <cstdint>
+
+#include "ptp.h"
+#include "ptpclock.h"
+
+#include "hardware.h"
+
+/**
+ * PTPv2 ordinary clock, slave only, end-to-end delay mechanism, UDP over IPv4.
+ * The time stamps are Hardware::Micros, taken in Run at the reception of Sync
+ * and before the transmission of Delay_Req. The EMAC drivers have no time stamp unit.
+ */
+namespace ptpclient {
+static constexpr uint32_t ANNOUNCE_RECEIPT_TIMEOUT = 3;		///< Announce intervals
+static constexpr int8_t LOG_DELAY_REQ_INTERVAL = 0;			///< Until the master tells, 1 second
+
+enum class State {
+	DISABLED, LISTENING, UNCALIBRATED, SLAVE
+};
+
+struct Master {
+	uint8_t ClockIdentity[ptp::CLOCK_IDENTITY_LENGTH];
+	uint16_t nPortNumber;
+	uint32_t nIp;
+	uint8_t nPriority1;
+	uint8_t nClockClass;
+	uint8_t nClockAccuracy;
+	uint16_t nClockVariance;
+	uint8_t nPriority2;
+	uint8_t GrandmasterIdentity[ptp::CLOCK_IDENTITY_LENGTH];
+	uint16_t nStepsRemoved;
+	int16_t nUtcOffset;
+	bool bUtcOffsetValid;
+	uint32_t nMillisAnnounce;
+	uint32_t nAnnounceTimeoutMillis;
+};
+}  // namespace ptpclient
+
+class PtpClient {
+public:
+	PtpClient(const uint8_t nDomain = ptp::DOMAIN);
+
+	void Start();
+	void Stop();
+	void Print();
+
+	void Run() {
+		if (__builtin_expect((m_State == ptpclient::State::DISABLED), 0)) {
+			return;
+		}
+
+		HandleEvent();
+		HandleGeneral();
+
+		const auto nMillis = Hardware::Get()->Millis();
+
+		if (m_State == ptpclient::State::LISTENING) {
+			return;
+		}
+
+		if (__builtin_expect(((nMillis - m_Master.nMillisAnnounce) > m_Master.nAnnounceTimeoutMillis), 0)) {
+			Listening();
+			return;
+		}
+
+		if (__builtin_expect((m_PtpClock.IsValid() && ((nMillis - m_nMillisDelayReq) >= m_nDelayReqMillis)), 0)) {
+			m_nMillisDelayReq = nMillis;
+			SendDelayReq();
+		}
+	}
+
+	ptpclient::State GetState() const {
+		return m_State;
+	}
+
+	bool IsSynchronised() const {
+		return (m_State == ptpclient::State::SLAVE);
+	}
+
+	const PtpClock& GetClock() const {
+		return m_PtpClock;
+	}
+
+	/**
+	 * @return The PTP time (TAI) now, in nanoseconds
+	 */
+	int64_t GetNanos() const {
+		return m_PtpClock.GetNanos(Hardware::Get()->Micros());
+	}
+
+	/**
+	 * @return TAI - UTC in seconds, 0 when the master does not tell
+	 */
+	int16_t GetUtcOffset() const {
+		return m_Master.bUtcOffsetValid ? m_Master.nUtcOffset : 0;
+	}
+
+	static PtpClient *Get() {
+		return s_pThis;
+	}
+
+private:
+	void HandleEvent();
+	void HandleGeneral();
+	void HandleAnnounce(const ptp::Announce *pAnnounce, const uint32_t nFromIp, const uint32_t nMillis);
+	void HandleSync(const ptp::Event *pSync, const uint32_t nMicros);
+	void HandleFollowUp(const ptp::Event *pFollowUp);
+	void HandleDelayResp(const ptp::DelayResp *pDelayResp);
+	void SendDelayReq();
+	void Listening();
+	void Update(const ptpclock::Action action);
+	bool IsFromMaster(const ptp::Header *pHeader) const;
+
+private:
+	uint8_t m_nDomain;
+	int32_t m_nHandleEvent { -1 };
+	int32_t m_nHandleGeneral { -1 };
+	uint8_t m_ClockIdentity[ptp::CLOCK_IDENTITY_LENGTH];
+	ptpclient::Master m_Master;
+	// Sync, waiting for Follow_Up
+	uint32_t m_nSyncMicros { 0 };
+	int64_t m_nSyncCorrectionNanos { 0 };
+	uint16_t m_nSyncSequenceId { 0 };
+	bool m_bSyncPending { false };
+	// Delay_Req, waiting for Delay_Resp
+	uint32_t m_nDelayReqMicros { 0 };
+	uint32_t m_nMillisDelayReq { 0 };
+	uint32_t m_nDelayReqMillis { 1000 };
+	uint16_t m_nDelayReqSequenceId { 0 };
+	bool m_bDelayReqPending { false };
+	// Statistics
+	uint32_t m_nSyncs { 0 };
+	uint32_t m_nDelayResps { 0 };
+	ptpclient::State m_State { ptpclient::State::DISABLED };
+	PtpClock m_PtpClock;
+
+	static ptp::Event s_DelayReq;
+	static PtpClient *s_pThis;
+};
+
+#endif /* PTPCLIENT_H_ */
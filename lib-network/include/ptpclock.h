@@ -0,0 +1,151 @@
+/**
+ * @file ptpclock.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PTPCLOCK_H_
+#define PTPCLOCK_H_
+
+#include <cstdint>
+
+/**
+ * The PTP time as a function of the local time, Hardware::Micros.
+ * - Filter: the time stamps are taken in software, so a late Run only makes a
+ *   Sync later. The sample with the least offset of the last SYNC_FILTER_SIZE
+ *   is used, an older sample counts PHI more for each second of its age,
+ *   with a larger PHI before the frequency is known.
+ * - The mean path delay is the least of the last DELAY_FILTER_SIZE measurements.
+ * - A large offset is stepped, a small offset goes to a PI servo: the phase is
+ *   corrected with 1/2^PHASE_SHIFT, the frequency with 1/2^FREQUENCY_SHIFT of the offset.
+ * The local timer is not touched, the model is rebased with each update.
+ */
+namespace ptpclock {
+static constexpr uint32_t SYNC_FILTER_SIZE = 8;
+static constexpr uint32_t DELAY_FILTER_SIZE = 8;
+static constexpr int64_t STEP_THRESHOLD_NANOS = 10000000;	///< 10 ms
+static constexpr int64_t DELAY_MAX_NANOS = 100000000;
+static constexpr int64_t PHI_NANOS_PER_SECOND = 1000;			///< 1 ppm, synchronised
+static constexpr int64_t PHI_ACQUIRE_NANOS_PER_SECOND = 100000;	///< 100 ppm
+static constexpr uint32_t PHASE_SHIFT = 2;
+static constexpr uint32_t FREQUENCY_SHIFT = 5;
+static constexpr int32_t FREQUENCY_MAX_PPB = 500000;			///< 500 ppm
+static constexpr int64_t LOCKED_NANOS = 100000;					///< 100 us
+static constexpr uint32_t LOCKED_COUNT = 4;
+
+enum class Action {
+	NONE, UPDATE, STEP
+};
+
+struct Sample {
+	int64_t nOffsetNanos;
+	uint32_t nMicros;
+};
+}  // namespace ptpclock
+
+class PtpClock {
+public:
+	PtpClock() {
+		Reset();
+	}
+
+	void Reset();
+
+	/**
+	 * @param nMasterNanos t1, the precise origin time stamp plus the corrections
+	 * @param nMicros t2, the local time of the reception
+	 */
+	ptpclock::Action Sync(const int64_t nMasterNanos, const uint32_t nMicros);
+
+	/**
+	 * The mean path delay
+	 * @param nMicros t3, the local time of the transmission of Delay_Req
+	 * @param nMasterNanos t4, the receive time stamp minus the correction
+	 */
+	void Delay(const uint32_t nMicros, const int64_t nMasterNanos);
+
+	/**
+	 * @return The PTP time in nanoseconds of the local time nMicros
+	 */
+	int64_t GetNanos(const uint32_t nMicros) const {
+		const auto nElapsed = static_cast<int64_t>(static_cast<int32_t>(nMicros - m_nBaseMicros));
+		return m_nBaseNanos + (nElapsed * 1000) + ((nElapsed * m_nFrequencyPpb) / 1000000);
+	}
+
+	/**
+	 * @return The local time of the PTP time nNanos, up to 35 minutes away from the last sample
+	 */
+	uint32_t GetMicros(const int64_t nNanos) const {
+		const auto nElapsed = nNanos - m_nBaseNanos;
+		return m_nBaseMicros + static_cast<uint32_t>((nElapsed * 1000000) / (1000000000 + m_nFrequencyPpb));
+	}
+
+	bool IsValid() const {
+		return m_bValid;
+	}
+
+	bool IsSynchronised() const {
+		return m_bSynchronised;
+	}
+
+	int64_t GetOffsetNanos() const {
+		return m_nOffsetNanos;
+	}
+
+	int64_t GetDelayNanos() const {
+		return m_nDelayNanos;
+	}
+
+	int32_t GetFrequencyPpb() const {
+		return m_nFrequencyPpb;
+	}
+
+	uint32_t GetSteps() const {
+		return m_nSteps;
+	}
+
+private:
+	int32_t Select(const uint32_t nMicros) const;
+	void Rebase(const uint32_t nMicros);
+
+private:
+	ptpclock::Sample m_SyncFilter[ptpclock::SYNC_FILTER_SIZE];
+	int64_t m_DelayFilter[ptpclock::DELAY_FILTER_SIZE];
+	uint32_t m_nSyncIndex;
+	uint32_t m_nSyncSamples;
+	uint32_t m_nDelayIndex;
+	uint32_t m_nDelaySamples;
+	uint32_t m_nMicrosLastUsed;
+	uint32_t m_nMicrosLastUpdate;
+	uint32_t m_nLocked;
+	uint32_t m_nSteps;
+	// The model
+	int64_t m_nBaseNanos;
+	uint32_t m_nBaseMicros;
+	int32_t m_nFrequencyPpb;	///< > 0, the local timer is slow
+	int64_t m_nOffsetNanos;
+	int64_t m_nDelayNanos;
+	bool m_bValid;
+	bool m_bSynchronised;
+};
+
+#endif /* PTPCLOCK_H_ */
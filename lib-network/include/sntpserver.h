@@ -0,0 +1,101 @@
+/**
+ * @file sntpserver.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SNTPSERVER_H_
+#define SNTPSERVER_H_
+
+#include <cstdint>
+
+#include "ntp.h"
+#include "network.h"
+
+/**
+ * SNTP server (RFC 4330) with the system clock, a node can be the time master of a site.
+ * With a running NtpClient the port is shared: the requests are passed by NtpClient.
+ */
+namespace sntpserver {
+static constexpr uint8_t STRATUM_LOCAL = 10;	///< Free running, as the local clock of ntpd
+static constexpr uint8_t STRATUM_UNSYNCHRONISED = 16;
+static constexpr int8_t PRECISION = -20;		///< 1 us
+}  // namespace sntpserver
+
+class SntpServer {
+public:
+	SntpServer();
+	~SntpServer();
+
+	void Start();
+	void Stop();
+	void Print();
+
+	void Run() {
+		if (__builtin_expect((m_nHandle < 0), 0)) {
+			return;
+		}
+
+		if (IsShared()) {
+			return;
+		}
+
+		uint32_t nFromIp;
+		uint16_t nFromPort;
+		ntp::Packet *pRequest;
+
+		const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&pRequest)), &nFromIp, &nFromPort);
+
+		if (__builtin_expect((nBytesReceived < sizeof(struct ntp::Packet)), 1)) {
+			return;
+		}
+
+		if (__builtin_expect(((pRequest->LiVnMode & ntp::MODE_MASK) != ntp::MODE_CLIENT), 0)) {
+			return;
+		}
+
+		Reply(pRequest, nFromIp, nFromPort);
+	}
+
+	void Reply(const ntp::Packet *pRequest, const uint32_t nFromIp, const uint16_t nFromPort);
+
+	uint32_t GetRequests() const {
+		return m_nRequests;
+	}
+
+	static SntpServer *Get() {
+		return s_pThis;
+	}
+
+private:
+	bool IsShared() const;
+
+private:
+	int32_t m_nUtcOffset;
+	int32_t m_nHandle { -1 };
+	uint32_t m_nRequests { 0 };
+
+	static ntp::Packet s_Reply;
+	static SntpServer *s_pThis;
+};
+
+#endif /* SNTPSERVER_H_ */
@@ -32,6 +32,16 @@ namespace tftp {
 enum class Mode {
 	BINARY, ASCII
 };
+
+namespace blksize {
+static constexpr uint16_t DEFAULT = 512;	///< RFC 1350
+static constexpr uint16_t MIN = 8;			///< RFC 2348
+}  // namespace blksize
+
+namespace windowsize {
+static constexpr uint16_t DEFAULT = 1;		///< RFC 1350 lock-step
+static constexpr uint16_t MAX = 16;			///< RFC 7440
+}  // namespace windowsize
 }  // namespace tftp
 
 class TFTPDaemon {
@@ -46,11 +56,27 @@ public:
 	virtual bool FileClose()=0;
 	virtual size_t FileRead(void *pBuffer, size_t nCount, unsigned nBlockNumber)=0;
 	virtual size_t FileWrite(const void *pBuffer, size_t nCount, unsigned nBlockNumber)=0;
+	/**
+	 * Used for the RFC 2349 tsize option of a read request.
+	 * @return file size in bytes, 0 when not known
+	 */
+	virtual uint32_t FileSize() {
+		return 0;
+	}
+
+	/**
+	 * @return negotiated (RFC 2348) data block size of the current transfer
+	 */
+	uint16_t GetBlockSize() const {
+		return m_nBlockSize;
+	}
 
 	virtual void Exit()=0;
 
 private:
 	void HandleRequest();
+	void ParseOptions(const char *pOptions, const uint32_t nLength, const uint16_t nOpCode);
+	void SendOptionAck();
 	void HandleRecvAck();
 	void HandleRecvData();
 	void SendError (const uint16_t nsErrorCode, const char *pErrorMessage);
@@ -76,6 +102,12 @@ private:
 	size_t m_nDataLength { 0 };
 	uint16_t m_nPacketLength { 0 };
 	bool m_bIsLastBlock { false };
+	bool m_bIsOutOfOrder { false };
+	uint16_t m_nBlockSize { tftp::blksize::DEFAULT };
+	uint16_t m_nWindowSize { tftp::windowsize::DEFAULT };
+	uint16_t m_nWindowCount { 0 };
+	uint32_t m_nOptions { 0 };
+	uint32_t m_nTransferSize { 0 };
 
 	static TFTPDaemon* Get() {
 		return s_pThis;
@@ -42,12 +42,21 @@ static constexpr auto SERVICE_RECORDS_MAX = 8;
 #else
 static constexpr auto SERVICE_RECORDS_MAX = MDNS_SERVICE_RECORDS_MAX;
 #endif
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+# if !defined (MDNS_SERVICE_INSTANCES_MAX)
+static constexpr auto SERVICE_INSTANCES_MAX = 16;
+# else
+static constexpr auto SERVICE_INSTANCES_MAX = MDNS_SERVICE_INSTANCES_MAX;
+# endif
+static constexpr uint32_t SERVICE_INSTANCE_TTL_MAX = 24 * 3600;	///< (in seconds), keeps the expiry in range of Millis()
+#endif
 
 static constexpr uint32_t MULTICAST_MESSAGE_SIZE = 512;	///< The 1987 DNS specification [RFC1035] restricts DNS messages carried by UDP to no more than 512 bytes
 static constexpr uint32_t MULTICAST_ADDRESS = network::convert_to_uint(224, 0, 0, 251);
 static constexpr uint16_t UDP_PORT = 5353;
 
 static constexpr uint32_t MDNS_RESPONSE_TTL = 3600;		///< (in seconds)
+static constexpr uint32_t MDNS_KNOWN_ANSWER_TTL_MIN = MDNS_RESPONSE_TTL / 2;	///< RFC 6762, 7.1 Known-Answer Suppression
 
 static constexpr size_t DOMAIN_MAXLEN = 256;
 static constexpr size_t LABEL_MAXLEN = 63;
@@ -203,9 +212,27 @@ static constexpr Domain DOMAIN_DNSSD {
 	10 + 8 + 5 + 6 + 1
 };
 
+/**
+ * The last response sent for a service record, with the records it answers.
+ * Invalidated (nLength is 0) when the record, the IP address or the host name changes.
+ * The buffer is static, there is no allocation in the receive path.
+ */
+struct CachedMessage {
+	uint8_t data[MULTICAST_MESSAGE_SIZE];
+	uint16_t nLength;
+	ServiceReply serviceReplies;
+};
+
 static ServiceRecord s_ServiceRecords[mdns::SERVICE_RECORDS_MAX];
+static CachedMessage s_CachedMessages[mdns::SERVICE_RECORDS_MAX];
+static uint32_t s_nCachedIp;
+static char s_aCachedHostName[network::HOSTNAME_SIZE];
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+static ServiceInstance s_ServiceInstances[mdns::SERVICE_INSTANCES_MAX];
+#endif
 static HostReply s_HostReplies;
 static ServiceReply s_ServiceReplies;
+static ServiceReply s_RecordReplies[mdns::SERVICE_RECORDS_MAX];
 static uint8_t s_RecordsData[MULTICAST_MESSAGE_SIZE];
 static bool s_isUnicast;
 static bool s_bLegacyQuery;
@@ -236,6 +263,14 @@ static constexpr mdns::ServiceReply operator& (mdns::ServiceReply a, mdns::Servi
 	return static_cast<mdns::ServiceReply>((static_cast<uint32_t>(a) & static_cast<uint32_t>(b)));
 }
 
+static constexpr mdns::HostReply operator~ (mdns::HostReply a) {
+	return static_cast<mdns::HostReply>(~static_cast<uint32_t>(a));
+}
+
+static constexpr mdns::ServiceReply operator~ (mdns::ServiceReply a) {
+	return static_cast<mdns::ServiceReply>(~static_cast<uint32_t>(a));
+}
+
 int32_t MDNS::s_nHandle;
 uint32_t MDNS::s_nRemoteIp;
 uint16_t MDNS::s_nRemotePort;
@@ -249,7 +284,12 @@ namespace network {
 void mdns_announcement() {
 	DEBUG_ENTRY
 
-	assert(MDNS::Get() != nullptr);
+	// A DHCP lease can be bound before MDNS is started
+	if (MDNS::Get() == nullptr) {
+		DEBUG_EXIT
+		return;
+	}
+
 	MDNS::Get()->SendAnnouncement(MDNS_RESPONSE_TTL);
 
 	DEBUG_ENTRY
@@ -265,6 +305,16 @@ void mdns_shutdown() {
 }
 }  // namespace network
 
+static void add_service_type(Domain& domain, const mdns::Services services) {
+	const auto nIndex = static_cast<uint32_t>(services);
+
+	memcpy(&domain.aName[domain.nLength], s_Services[nIndex].pDomain, s_Services[nIndex].nLength);
+	domain.nLength += s_Services[nIndex].nLength;
+
+	domain.AddProtocol(s_Services[nIndex].protocols);
+	domain.AddDotLocal();
+}
+
 static void create_service_domain(Domain& domain, ServiceRecord const& serviceRecord, const bool bIncludeName) {
 	DEBUG_ENTRY
 
@@ -278,13 +328,7 @@ static void create_service_domain(Domain& domain, ServiceRecord const& serviceRe
 		}
 	}
 
-	const auto nIndex = static_cast<uint32_t>(serviceRecord.services);
-
-	memcpy(&domain.aName[domain.nLength], s_Services[nIndex].pDomain, s_Services[nIndex].nLength);
-	domain.nLength += s_Services[nIndex].nLength;
-
-	domain.AddProtocol(s_Services[nIndex].protocols);
-	domain.AddDotLocal();
+	add_service_type(domain, serviceRecord.services);
 
 	DEBUG_EXIT
 }
@@ -671,6 +715,86 @@ const uint8_t *get_domain_name(const uint8_t *const msg, const uint8_t *ptr, con
 		return (ptr);
 }
 
+/**
+ * Reads the (compressed) name at nOffset. The domain length is the length of the expanded name.
+ * @return the offset of the first byte after the name in the message, 0 when the name is malformed
+ */
+static uint32_t get_domain(Domain& domain, const uint8_t *pMessage, const uint32_t nOffset, const uint32_t nBytes) {
+	const auto *pResult = get_domain_name(pMessage, &pMessage[nOffset], &pMessage[nBytes], domain.aName);
+
+	if (pResult == nullptr) {
+		return 0;
+	}
+
+	const auto *pName = domain.aName;
+
+	while (*pName != 0) {
+		pName += 1 + *pName;
+	}
+
+	domain.nLength = static_cast<uint16_t>(1 + pName - domain.aName);
+
+	return static_cast<uint32_t>(pResult - pMessage);
+}
+
+/**
+ * The fixed part of a resource record, following the name.
+ */
+struct ResourceRecord {
+	Types type;
+	uint32_t nTTL;
+	uint32_t nDataOffset;
+	uint16_t nDataLength;
+};
+
+/**
+ * @return the offset of the next resource record, 0 when the record does not fit in the message
+ */
+static uint32_t get_resource_record(Domain& domain, ResourceRecord& record, const uint8_t *pMessage, uint32_t nOffset, const uint32_t nBytes) {
+	nOffset = get_domain(domain, pMessage, nOffset, nBytes);
+
+	if ((nOffset == 0) || (nOffset + 10 > nBytes)) {
+		return 0;
+	}
+
+	uint16_t nValue16;
+	uint32_t nValue32;
+
+	memcpy(&nValue16, &pMessage[nOffset], 2);
+	record.type = static_cast<Types>(__builtin_bswap16(nValue16));
+	memcpy(&nValue32, &pMessage[nOffset + 4], 4);
+	record.nTTL = __builtin_bswap32(nValue32);
+	memcpy(&nValue16, &pMessage[nOffset + 8], 2);
+	record.nDataLength = __builtin_bswap16(nValue16);
+	record.nDataOffset = nOffset + 10;
+
+	if (record.nDataOffset + record.nDataLength > nBytes) {
+		return 0;
+	}
+
+	return record.nDataOffset + record.nDataLength;
+}
+
+/**
+ * @return the offset of the first resource record, 0 when a question is malformed
+ */
+static uint32_t skip_questions(const uint8_t *pMessage, const uint32_t nQuestions, const uint32_t nBytes) {
+	uint32_t nOffset = sizeof(struct Header);
+
+	for (uint32_t i = 0; i < nQuestions; i++) {
+		Domain domain;
+		nOffset = get_domain(domain, pMessage, nOffset, nBytes);
+
+		if ((nOffset == 0) || (nOffset + 4 > nBytes)) {
+			return 0;
+		}
+
+		nOffset += 4;
+	}
+
+	return nOffset;
+}
+
 void MDNS::SendAnswerLocalIpAddress(const uint16_t nTransActionID, const uint32_t nTTL) {
 	DEBUG_ENTRY
 
@@ -713,11 +837,198 @@ void MDNS::SendAnswerLocalIpAddress(const uint16_t nTransActionID, const uint32_
 	pHeader->nAdditionalCount = 0;
 
 	const auto nSize = static_cast<uint16_t>(pDst - reinterpret_cast<uint8_t *>(pHeader));
-	SendTo(nSize);
+	SendTo(s_RecordsData, nSize);
 
 	DEBUG_EXIT
 }
 
+static void cached_message_invalidate(const uint32_t nIndex) {
+	s_CachedMessages[nIndex].nLength = 0;
+}
+
+static void cached_messages_invalidate() {
+	for (uint32_t nIndex = 0; nIndex < mdns::SERVICE_RECORDS_MAX; nIndex++) {
+		cached_message_invalidate(nIndex);
+	}
+
+	s_nCachedIp = Network::Get()->GetIp();
+	strncpy(s_aCachedHostName, Network::Get()->GetHostName(), sizeof(s_aCachedHostName) - 1);
+	s_aCachedHostName[sizeof(s_aCachedHostName) - 1] = '\0';
+}
+
+static void cached_messages_validate() {
+	if ((s_nCachedIp != Network::Get()->GetIp()) || (strcmp(s_aCachedHostName, Network::Get()->GetHostName()) != 0)) {
+		DEBUG_PUTS("IP address or host name changed");
+		cached_messages_invalidate();
+	}
+}
+
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+static bool is_expired(ServiceInstance const& instance, const uint32_t nNow) {
+	return static_cast<int32_t>(instance.nExpireMillis - nNow) <= 0;
+}
+
+static void create_instance_domain(Domain &domain, ServiceInstance const& instance) {
+	domain.nLength = 0;
+	domain.AddLabel(instance.aName, strlen(instance.aName));
+	add_service_type(domain, instance.services);
+}
+
+/**
+ * @param pLabel length prefixed instance name
+ */
+static ServiceInstance *service_instance_find(const mdns::Services services, const uint8_t *pLabel) {
+	const auto nLength = static_cast<size_t>(pLabel[0]);
+
+	for (auto &instance : s_ServiceInstances) {
+		if ((instance.services == services) && (strlen(instance.aName) == nLength) && (strncasecmp(instance.aName, reinterpret_cast<const char *>(&pLabel[1]), nLength) == 0)) {
+			return &instance;
+		}
+	}
+
+	return nullptr;
+}
+
+/**
+ * @return a free entry, or else the entry which expires first
+ */
+static ServiceInstance *service_instance_new(const uint32_t nNow) {
+	ServiceInstance *pInstance = nullptr;
+
+	for (auto &instance : s_ServiceInstances) {
+		if ((instance.services == Services::LAST_NOT_USED) || is_expired(instance, nNow)) {
+			return &instance;
+		}
+
+		if ((pInstance == nullptr) || (static_cast<int32_t>(instance.nExpireMillis - pInstance->nExpireMillis) < 0)) {
+			pInstance = &instance;
+		}
+	}
+
+	return pInstance;
+}
+
+static void service_instance_ptr(Domain const& domain, ResourceRecord const& record, const uint8_t *pMessage, const uint32_t nBytes, const uint32_t nNow) {
+	for (uint32_t nIndex = 0; nIndex < static_cast<uint32_t>(Services::LAST_NOT_USED); nIndex++) {
+		const auto services = static_cast<Services>(nIndex);
+
+		Domain domainType;
+		domainType.nLength = 0;
+		add_service_type(domainType, services);
+
+		if (!(domainType == domain)) {
+			continue;
+		}
+
+		Domain domainInstance;
+
+		if (get_domain(domainInstance, pMessage, record.nDataOffset, nBytes) == 0) {
+			return;
+		}
+
+		const auto nLabelLength = domainInstance.aName[0];
+
+		if ((nLabelLength == 0) || (nLabelLength >= network::HOSTNAME_SIZE)) {
+			return;
+		}
+
+		Domain domainSuffix;
+		domainSuffix.nLength = static_cast<uint16_t>(domainInstance.nLength - 1U - nLabelLength);
+		memcpy(domainSuffix.aName, &domainInstance.aName[1 + nLabelLength], domainSuffix.nLength);
+
+		if (!(domainSuffix == domainType)) {
+			return;
+		}
+
+		auto *pInstance = service_instance_find(services, domainInstance.aName);
+
+		if (record.nTTL == 0) {
+			if (pInstance != nullptr) {
+				DEBUG_PRINTF("Goodbye %s", pInstance->aName);
+				pInstance->services = Services::LAST_NOT_USED;
+			}
+			return;
+		}
+
+		if (pInstance == nullptr) {
+			pInstance = service_instance_new(nNow);
+			assert(pInstance != nullptr);
+
+			memcpy(pInstance->aName, &domainInstance.aName[1], nLabelLength);
+			pInstance->aName[nLabelLength] = '\0';
+			pInstance->aHostName[0] = '\0';
+			pInstance->nIp = 0;
+			pInstance->nPort = 0;
+			pInstance->services = services;
+		}
+
+		pInstance->nTTL = std::min(record.nTTL, SERVICE_INSTANCE_TTL_MAX);
+		pInstance->nExpireMillis = nNow + pInstance->nTTL * 1000U;
+		return;
+	}
+}
+
+static void service_instance_srv(Domain const& domain, ResourceRecord const& record, const uint8_t *pMessage, const uint32_t nBytes) {
+	if (record.nDataLength < 7) {
+		return;
+	}
+
+	for (auto &instance : s_ServiceInstances) {
+		if (instance.services == Services::LAST_NOT_USED) {
+			continue;
+		}
+
+		Domain domainInstance;
+		create_instance_domain(domainInstance, instance);
+
+		if (!(domainInstance == domain)) {
+			continue;
+		}
+
+		Domain domainTarget;
+
+		if (get_domain(domainTarget, pMessage, record.nDataOffset + 6, nBytes) == 0) {
+			return;
+		}
+
+		const auto nLabelLength = domainTarget.aName[0];
+
+		if ((nLabelLength == 0) || (nLabelLength >= network::HOSTNAME_SIZE)) {
+			return;
+		}
+
+		uint16_t nPort;
+		memcpy(&nPort, &pMessage[record.nDataOffset + 4], 2);
+
+		instance.nPort = __builtin_bswap16(nPort);
+		memcpy(instance.aHostName, &domainTarget.aName[1], nLabelLength);
+		instance.aHostName[nLabelLength] = '\0';
+		return;
+	}
+}
+
+static void service_instance_a(Domain const& domain, ResourceRecord const& record, const uint8_t *pMessage) {
+	if (record.nDataLength != 4) {
+		return;
+	}
+
+	for (auto &instance : s_ServiceInstances) {
+		if ((instance.services == Services::LAST_NOT_USED) || (instance.aHostName[0] == '\0')) {
+			continue;
+		}
+
+		Domain domainHost;
+		domainHost.nLength = 0;
+		domainHost.AddLabel(instance.aHostName, strlen(instance.aHostName));
+		domainHost.AddDotLocal();
+
+		if (domainHost == domain) {
+			memcpy(&instance.nIp, &pMessage[record.nDataOffset], 4);
+		}
+	}
+}
+#endif
+
 MDNS::MDNS() {
 	assert(s_pThis == nullptr);
 	s_pThis = this;
@@ -726,6 +1037,12 @@ MDNS::MDNS() {
 		record.services = Services::LAST_NOT_USED;
 	}
 
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+	for (auto &instance : s_ServiceInstances) {
+		instance.services = Services::LAST_NOT_USED;
+	}
+#endif
+
 	s_nHandle = Network::Get()->Begin(mdns::UDP_PORT);
 	assert(s_nHandle != -1);
 
@@ -748,6 +1065,8 @@ MDNS::~MDNS() {
 		}
 	}
 
+	cached_messages_invalidate();
+
 	Network::Get()->LeaveGroup(s_nHandle, mdns::MULTICAST_ADDRESS);
 	Network::Get()->End(mdns::UDP_PORT);
 	s_nHandle = -1;
@@ -756,7 +1075,10 @@ MDNS::~MDNS() {
 void MDNS::SendAnnouncement(const uint32_t nTTL) {
 	DEBUG_ENTRY
 
-	s_nRemotePort = mdns::UDP_PORT; //FIXME Hack ;-)
+	cached_messages_invalidate();
+
+	s_isUnicast = false;
+	s_bLegacyQuery = false;
 	s_HostReplies = HostReply::A;
 
 	SendAnswerLocalIpAddress(0, nTTL);
@@ -778,7 +1100,9 @@ bool MDNS::ServiceRecordAdd(const char *pName, const mdns::Services services, co
 	DEBUG_ENTRY
 	assert(services < mdns::Services::LAST_NOT_USED);
 
-	for (auto &record : s_ServiceRecords) {
+	for (uint32_t nIndex = 0; nIndex < mdns::SERVICE_RECORDS_MAX; nIndex++) {
+		auto &record = s_ServiceRecords[nIndex];
+
 		if (record.services == Services::LAST_NOT_USED) {
 			if (pName != nullptr) {
 				const auto nLength = std::min(LABEL_MAXLEN, strlen(pName));
@@ -812,14 +1136,14 @@ bool MDNS::ServiceRecordAdd(const char *pName, const mdns::Services services, co
 				record.nTextContentLength = static_cast<uint16_t>(nLength);
 			}
 
-			s_nRemotePort = mdns::UDP_PORT; //FIXME Hack ;-)
+			cached_message_invalidate(nIndex);
 
+			s_isUnicast = false;
 			s_ServiceReplies = ServiceReply::TYPE_PTR
-					| ServiceReply::NAME_PTR
-					| ServiceReply::SRV
-					| ServiceReply::TXT;
-
-			SendMessage(record, 0, MDNS_RESPONSE_TTL);
+							 | ServiceReply::NAME_PTR
+							 | ServiceReply::SRV
+							 | ServiceReply::TXT;
+			SendCachedMessage(nIndex);
 			return true;
 		}
 	}
@@ -832,18 +1156,32 @@ bool MDNS::ServiceRecordDelete(const mdns::Services service) {
 	DEBUG_ENTRY
 	assert(service < mdns::Services::LAST_NOT_USED);
 
-	for (auto &record : s_ServiceRecords) {
+	for (uint32_t nIndex = 0; nIndex < mdns::SERVICE_RECORDS_MAX; nIndex++) {
+		auto &record = s_ServiceRecords[nIndex];
+
 		if (record.services == service) {
+			s_isUnicast = false;
+			s_ServiceReplies = ServiceReply::TYPE_PTR
+							 | ServiceReply::NAME_PTR
+							 | ServiceReply::SRV
+							 | ServiceReply::TXT;
 			SendMessage(record, 0, 0);
 
+			cached_message_invalidate(nIndex);
+
 			if (record.pName != nullptr) {
 				delete[] record.pName;
+				record.pName = nullptr;
 			}
 
 			if (record.pTextContent != nullptr) {
 				delete[] record.pTextContent;
+				record.pTextContent = nullptr;
 			}
 
+			record.nTextContentLength = 0;
+			record.services = Services::LAST_NOT_USED;
+
 			DEBUG_EXIT
 			return true;
 		}
@@ -853,16 +1191,16 @@ bool MDNS::ServiceRecordDelete(const mdns::Services service) {
 	return false;
 }
 
-void MDNS::SendTo(const uint16_t nLength) {
+void MDNS::SendTo(const uint8_t *pData, const uint16_t nLength) {
 	if (!s_isUnicast) {
-		Network::Get()->SendTo(s_nHandle, s_RecordsData, nLength, mdns::MULTICAST_ADDRESS, mdns::UDP_PORT);
+		Network::Get()->SendTo(s_nHandle, pData, nLength, mdns::MULTICAST_ADDRESS, mdns::UDP_PORT);
 		return;
 	}
 
-	Network::Get()->SendTo(s_nHandle, s_RecordsData, nLength, s_nRemoteIp, s_nRemotePort);
+	Network::Get()->SendTo(s_nHandle, pData, nLength, s_nRemoteIp, s_nRemotePort);
 }
 
-void MDNS::SendMessage(mdns::ServiceRecord const& serviceRecord, const uint16_t nTransActionID, const uint32_t nTT) {
+uint16_t MDNS::CreateMessage(mdns::ServiceRecord const& serviceRecord, const uint16_t nTransActionID, const uint32_t nTT) {
 	DEBUG_ENTRY
 
 	uint32_t nAnswers = 0;
@@ -900,10 +1238,40 @@ void MDNS::SendMessage(mdns::ServiceRecord const& serviceRecord, const uint16_t
 	pHeader->nAuthorityCount = __builtin_bswap16(1);
 	pHeader->nAdditionalCount = __builtin_bswap16(0);
 
-	const auto nSize = static_cast<uint16_t>(pDst - reinterpret_cast<uint8_t*>(pHeader));
-	SendTo(nSize);
-
 	DEBUG_EXIT
+	return static_cast<uint16_t>(pDst - reinterpret_cast<uint8_t*>(pHeader));
+}
+
+void MDNS::SendMessage(mdns::ServiceRecord const& serviceRecord, const uint16_t nTransActionID, const uint32_t nTTL) {
+	const auto nSize = CreateMessage(serviceRecord, nTransActionID, nTTL);
+	SendTo(s_RecordsData, nSize);
+}
+
+/**
+ * The multicast response with the records in s_ServiceReplies (TTL MDNS_RESPONSE_TTL) is created once
+ * and then sent from the cache, until other records are asked for, or the record, the IP address or the host name changes.
+ */
+void MDNS::SendCachedMessage(const uint32_t nIndex) {
+	assert(nIndex < mdns::SERVICE_RECORDS_MAX);
+
+	cached_messages_validate();
+
+	auto &message = s_CachedMessages[nIndex];
+
+	if ((message.nLength != 0) && (message.serviceReplies != s_ServiceReplies)) {
+		cached_message_invalidate(nIndex);
+	}
+
+	if (message.nLength == 0) {
+		const auto nSize = CreateMessage(s_ServiceRecords[nIndex], 0, MDNS_RESPONSE_TTL);
+		assert(nSize <= sizeof(message.data));
+
+		memcpy(message.data, s_RecordsData, nSize);
+		message.nLength = nSize;
+		message.serviceReplies = s_ServiceReplies;
+	}
+
+	SendTo(message.data, message.nLength);
 }
 
 void MDNS::HandleQuestions(const uint32_t nQuestions) {
@@ -914,6 +1282,10 @@ void MDNS::HandleQuestions(const uint32_t nQuestions) {
 	s_isUnicast = (s_nRemotePort != mdns::UDP_PORT);
 	s_bLegacyQuery = s_isUnicast && (nQuestions == 1);
 
+	for (auto &serviceReply : s_RecordReplies) {
+		serviceReply = static_cast<mdns::ServiceReply>(0);
+	}
+
 	const auto nTransactionID = s_bLegacyQuery ? *reinterpret_cast<uint16_t *>(&s_pReceiveBuffer[0]) : static_cast<uint16_t>(0);
 
 	uint32_t nOffset = sizeof(struct Header);
@@ -921,15 +1293,13 @@ void MDNS::HandleQuestions(const uint32_t nQuestions) {
 	for (uint32_t i = 0; i < nQuestions; i++) {
 		Domain resourceDomain;
 
-		auto *pResult = get_domain_name(s_pReceiveBuffer, &s_pReceiveBuffer[nOffset], &s_pReceiveBuffer[s_nBytesReceived], resourceDomain.aName);
-		if (pResult == nullptr) {
+		nOffset = get_domain(resourceDomain, s_pReceiveBuffer, nOffset, s_nBytesReceived);
+
+		if ((nOffset == 0) || (nOffset + 4 > s_nBytesReceived)) {
 			DEBUG_EXIT
 			return;
 		}
 
-		resourceDomain.nLength = static_cast<uint16_t>(pResult - &s_pReceiveBuffer[nOffset]);
-		nOffset += resourceDomain.nLength;
-
 		const auto nType = static_cast<Types>(__builtin_bswap16(*reinterpret_cast<uint16_t*>(&s_pReceiveBuffer[nOffset])));
 		nOffset += 2;
 
@@ -972,24 +1342,26 @@ void MDNS::HandleQuestions(const uint32_t nQuestions) {
 		}
 #endif
 
-		for (auto &record : s_ServiceRecords) {
+		for (uint32_t nIndex = 0; nIndex < mdns::SERVICE_RECORDS_MAX; nIndex++) {
+			auto &record = s_ServiceRecords[nIndex];
+
 			if (record.services < Services::LAST_NOT_USED) {
 				/*
 				 * Check service
 				 */
 
-				s_ServiceReplies = static_cast<mdns::ServiceReply>(0);
+				auto &serviceReply = s_RecordReplies[nIndex];
 				Domain serviceDomain;
 
 				if (nType == Types::PTR || nType == Types::ALL) {
 					if (DOMAIN_DNSSD == resourceDomain) {
-						s_ServiceReplies = s_ServiceReplies | ServiceReply::TYPE_PTR;
+						serviceReply = serviceReply | ServiceReply::TYPE_PTR;
 					}
 
 					create_service_domain(serviceDomain, record, false);
 
 					if (serviceDomain == resourceDomain) {
-						s_ServiceReplies = s_ServiceReplies | ServiceReply::NAME_PTR;
+						serviceReply = serviceReply | ServiceReply::NAME_PTR;
 					}
 				}
 
@@ -997,21 +1369,41 @@ void MDNS::HandleQuestions(const uint32_t nQuestions) {
 
 				if (serviceDomain == resourceDomain) {
 					if ((nType == Types::SRV) || (nType == Types::ALL)) {
-						s_ServiceReplies = s_ServiceReplies | ServiceReply::SRV;
+						serviceReply = serviceReply | ServiceReply::SRV;
 					}
 
 					if ((nType == Types::TXT) || (nType == Types::ALL)) {
-						s_ServiceReplies = s_ServiceReplies | ServiceReply::TXT;
+						serviceReply = serviceReply | ServiceReply::TXT;
 					}
 				}
-
-				if (s_ServiceReplies != static_cast<mdns::ServiceReply>(0)) {
-					SendMessage(record, nTransactionID, MDNS_RESPONSE_TTL);
-				}
 			}
 		}
 	}
 
+	const auto nKnownAnswers = __builtin_bswap16(reinterpret_cast<Header *>(s_pReceiveBuffer)->nAnswerCount);
+
+	if (nKnownAnswers != 0) {
+		HandleKnownAnswers(nOffset, nKnownAnswers);
+	}
+
+	/*
+	 * One response per service record, for all the questions in the message.
+	 */
+
+	for (uint32_t nIndex = 0; nIndex < mdns::SERVICE_RECORDS_MAX; nIndex++) {
+		if (s_RecordReplies[nIndex] == static_cast<mdns::ServiceReply>(0)) {
+			continue;
+		}
+
+		s_ServiceReplies = s_RecordReplies[nIndex];
+
+		if (!s_bLegacyQuery && (nKnownAnswers == 0)) {
+			SendCachedMessage(nIndex);
+		} else {
+			SendMessage(s_ServiceRecords[nIndex], nTransactionID, MDNS_RESPONSE_TTL);
+		}
+	}
+
 	if (s_HostReplies != static_cast<mdns::HostReply>(0)) {
 		DEBUG_PUTS("");
 		SendAnswerLocalIpAddress(nTransactionID, MDNS_RESPONSE_TTL);
@@ -1020,6 +1412,274 @@ void MDNS::HandleQuestions(const uint32_t nQuestions) {
 	DEBUG_EXIT
 }
 
+/*
+ * The TXT RDATA as add_answer_txt writes it: one string, the length byte and the text content
+ */
+static bool is_text_content(mdns::ServiceRecord const& serviceRecord, const uint8_t *pData, const uint16_t nDataLength) {
+	const auto nSize = serviceRecord.nTextContentLength;
+
+	if ((nDataLength != 1U + nSize) || (pData[0] != nSize)) {
+		return false;
+	}
+
+	return (nSize == 0) || (memcmp(&pData[1], serviceRecord.pTextContent, nSize) == 0);
+}
+
+/**
+ * RFC 6762, 7.1 Known-Answer Suppression
+ * An answer is not sent when the querier already has it, with at least half of the TTL remaining.
+ */
+void MDNS::HandleKnownAnswers(uint32_t nOffset, const uint32_t nAnswers) {
+	DEBUG_ENTRY
+	DEBUG_PRINTF("nAnswers=%u", nAnswers);
+
+	for (uint32_t i = 0; i < nAnswers; i++) {
+		Domain domain;
+		ResourceRecord resourceRecord;
+
+		nOffset = get_resource_record(domain, resourceRecord, s_pReceiveBuffer, nOffset, s_nBytesReceived);
+
+		if (nOffset == 0) {
+			DEBUG_EXIT
+			return;
+		}
+
+		if (resourceRecord.nTTL < MDNS_KNOWN_ANSWER_TTL_MIN) {
+			continue;
+		}
+
+		if (resourceRecord.type == Types::A) {
+			if (resourceRecord.nDataLength == 4) {
+				Domain domainHost;
+				create_host_domain(domainHost);
+
+				uint32_t nIp;
+				memcpy(&nIp, &s_pReceiveBuffer[resourceRecord.nDataOffset], 4);
+
+				if ((domainHost == domain) && (nIp == Network::Get()->GetIp())) {
+					s_HostReplies = s_HostReplies & ~HostReply::A;
+				}
+			}
+
+			continue;
+		}
+
+		Domain domainData;
+
+		if (resourceRecord.type == Types::PTR) {
+			if (get_domain(domainData, s_pReceiveBuffer, resourceRecord.nDataOffset, s_nBytesReceived) == 0) {
+				continue;
+			}
+		}
+
+		for (uint32_t nIndex = 0; nIndex < mdns::SERVICE_RECORDS_MAX; nIndex++) {
+			auto &serviceReply = s_RecordReplies[nIndex];
+
+			if (serviceReply == static_cast<mdns::ServiceReply>(0)) {
+				continue;
+			}
+
+			auto const& record = s_ServiceRecords[nIndex];
+			Domain serviceDomain;
+
+			switch (resourceRecord.type) {
+			case Types::PTR:
+				create_service_domain(serviceDomain, record, false);
+
+				if (DOMAIN_DNSSD == domain) {
+					if (serviceDomain == domainData) {
+						serviceReply = serviceReply & ~ServiceReply::TYPE_PTR;
+					}
+				} else if (serviceDomain == domain) {
+					create_service_domain(serviceDomain, record, true);
+
+					if (serviceDomain == domainData) {
+						serviceReply = serviceReply & ~ServiceReply::NAME_PTR;
+					}
+				}
+				break;
+			case Types::SRV:
+				create_service_domain(serviceDomain, record, true);
+
+				if ((serviceDomain == domain) && (resourceRecord.nDataLength > 6) && (memcmp(&s_pReceiveBuffer[resourceRecord.nDataOffset + 4], &record.nPort, 2) == 0)) {
+					serviceReply = serviceReply & ~ServiceReply::SRV;
+				}
+				break;
+			case Types::TXT:
+				create_service_domain(serviceDomain, record, true);
+
+				if ((serviceDomain == domain) && is_text_content(record, &s_pReceiveBuffer[resourceRecord.nDataOffset], resourceRecord.nDataLength)) {
+					serviceReply = serviceReply & ~ServiceReply::TXT;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	DEBUG_EXIT
+}
+
+#if defined (CONFIG_MDNS_ENABLE_QUERIER)
+void MDNS::ServiceQuery(const mdns::Services services) {
+	DEBUG_ENTRY
+	assert(services < mdns::Services::LAST_NOT_USED);
+
+	Domain domain;
+	domain.nLength = 0;
+	add_service_type(domain, services);
+
+	auto *pDst = add_question(reinterpret_cast<uint8_t *>(&s_RecordsData) + sizeof(struct Header), domain, Types::PTR, false);
+
+	/*
+	 * Known answers, only when more than half of the TTL is remaining (RFC 6762, 7.1)
+	 */
+
+	const auto nNow = Hardware::Get()->Millis();
+	const auto *pEnd = &s_RecordsData[MULTICAST_MESSAGE_SIZE];
+	uint32_t nAnswers = 0;
+
+	for (auto const& instance : s_ServiceInstances) {
+		if ((instance.services != services) || is_expired(instance, nNow)) {
+			continue;
+		}
+
+		const auto nRemaining = (instance.nExpireMillis - nNow) / 1000U;
+
+		if (nRemaining <= (instance.nTTL / 2)) {
+			continue;
+		}
+
+		if (pDst + 2 + 10 + 1 + LABEL_MAXLEN + 2 > pEnd) {
+			break;
+		}
+
+		pDst = add_question(pDst, domain, Types::PTR, false);
+
+		*reinterpret_cast<uint32_t*>(pDst) = __builtin_bswap32(nRemaining);
+		pDst += 4;
+		auto *lengtPointer = pDst;
+		pDst += 2;
+		auto *pBegin = pDst;
+
+		Domain domainInstance;
+		create_instance_domain(domainInstance, instance);
+		pDst = put_domain_name_as_labels(pDst, domainInstance);
+
+		*reinterpret_cast<uint16_t*>(lengtPointer) = __builtin_bswap16(static_cast<uint16_t>(pDst - pBegin));
+
+		nAnswers++;
+	}
+
+	auto *pHeader = reinterpret_cast<Header *>(&s_RecordsData);
+
+	pHeader->xid = 0;
+	pHeader->nFlag1 = 0;
+	pHeader->nFlag2 = 0;
+	pHeader->nQueryCount = __builtin_bswap16(1);
+	pHeader->nAnswerCount = __builtin_bswap16(static_cast<uint16_t>(nAnswers));
+	pHeader->nAuthorityCount = 0;
+	pHeader->nAdditionalCount = 0;
+
+	DEBUG_PRINTF("nAnswers=%u", nAnswers);
+
+	s_isUnicast = false;
+	SendTo(s_RecordsData, static_cast<uint16_t>(pDst - reinterpret_cast<uint8_t *>(pHeader)));
+
+	DEBUG_EXIT
+}
+
+const mdns::ServiceInstance *MDNS::ServiceInstanceGet(const mdns::Services services, const uint32_t nIndex) {
+	const auto nNow = Hardware::Get()->Millis();
+	uint32_t nCount = 0;
+
+	for (auto &instance : s_ServiceInstances) {
+		if (instance.services == Services::LAST_NOT_USED) {
+			continue;
+		}
+
+		if (is_expired(instance, nNow)) {
+			instance.services = Services::LAST_NOT_USED;
+			continue;
+		}
+
+		if (instance.services != services) {
+			continue;
+		}
+
+		if (nCount == nIndex) {
+			return &instance;
+		}
+
+		nCount++;
+	}
+
+	return nullptr;
+}
+
+/**
+ * The PTR records create the service instances, the SRV and A records complete them.
+ * This is independent of the order of the records in the message.
+ */
+void MDNS::HandleResponse() {
+	DEBUG_ENTRY
+
+	if (s_nRemoteIp == Network::Get()->GetIp()) {
+		DEBUG_EXIT
+		return;
+	}
+
+	const auto *pHeader = reinterpret_cast<Header *>(s_pReceiveBuffer);
+	const auto nRecords = static_cast<uint32_t>(__builtin_bswap16(pHeader->nAnswerCount) + __builtin_bswap16(pHeader->nAuthorityCount) + __builtin_bswap16(pHeader->nAdditionalCount));
+	const auto nFirstRecord = skip_questions(s_pReceiveBuffer, __builtin_bswap16(pHeader->nQueryCount), s_nBytesReceived);
+
+	if (nFirstRecord == 0) {
+		DEBUG_EXIT
+		return;
+	}
+
+	const auto nNow = Hardware::Get()->Millis();
+	static constexpr Types TYPES[] = { Types::PTR, Types::SRV, Types::A };
+
+	for (const auto type : TYPES) {
+		auto nOffset = nFirstRecord;
+
+		for (uint32_t i = 0; i < nRecords; i++) {
+			Domain domain;
+			ResourceRecord resourceRecord;
+
+			nOffset = get_resource_record(domain, resourceRecord, s_pReceiveBuffer, nOffset, s_nBytesReceived);
+
+			if (nOffset == 0) {
+				DEBUG_EXIT
+				return;
+			}
+
+			if (resourceRecord.type != type) {
+				continue;
+			}
+
+			switch (type) {
+			case Types::PTR:
+				service_instance_ptr(domain, resourceRecord, s_pReceiveBuffer, s_nBytesReceived, nNow);
+				break;
+			case Types::SRV:
+				service_instance_srv(domain, resourceRecord, s_pReceiveBuffer, s_nBytesReceived);
+				break;
+			case Types::A:
+				service_instance_a(domain, resourceRecord, s_pReceiveBuffer);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	DEBUG_EXIT
+}
+#endif
+
 void MDNS::Print() {
 	printf("mDNS\n");
 
@@ -30,7 +30,9 @@
 #include <cassert>
 
 #include "ntpclient.h"
+#include "ntpclock.h"
 #include "ntp.h"
+#include "sntpserver.h"
 
 #include "utc.h"
 
@@ -39,22 +41,6 @@
 
 #include "debug.h"
 
-static constexpr auto RETRIES = 3;
-static constexpr auto JAN_1970 = 0x83aa7e80; 	// 2208988800 1970 - 1900 in seconds
-
-/* How to multiply by 4294.967296 quickly (and not quite exactly)
- * without using floating point or greater than 32-bit integers.
- * If you want to fix the last 12 microseconds of error, add in
- * (2911*(x))>>28)
- */
-#define NTPFRAC(x) ( 4294U*static_cast<uint32_t>(x) + ( (1981U*static_cast<uint32_t>(x))>>11 ) +  ((2911U*static_cast<uint32_t>(x))>>28) )
-
-/* The reverse of the above, needed if we want to set our microsecond
- * clock (via clock_settime) based on the incoming time in NTP format.
- * Basically exact.
- */
-#define USEC(x) ( ( (x) >> 12 ) - 759 * ( ( ( (x) >> 10 ) + 32768 ) >> 16 ) )
-
 /*
 Timestamp Name        ID   When Generated
 ----------------------------------------------------------------
@@ -79,115 +65,139 @@ NtpClient::NtpClient(const uint32_t nServerIp):
 	memset(&m_Request, 0, sizeof m_Request);
 
 	m_Request.LiVnMode = ntp::VERSION | ntp::MODE_CLIENT;
-	m_Request.Poll = 10; // Poll: 1024 seconds
 	m_Request.ReferenceID = ('A' << 0) | ('V' << 8) | ('S' << 16);
 
 	DEBUG_EXIT
 }
 
-/*
- * Seconds and Fractions since 01.01.1900
- */
-void NtpClient::GetTimeNtpFormat(uint32_t &nSeconds, uint32_t &nFraction) {
-	struct timeval now;
-	gettimeofday(&now, nullptr);
-	nSeconds = static_cast<uint32_t>(now.tv_sec - m_nUtcOffset) + JAN_1970;
-	nFraction = NTPFRAC(now.tv_usec);
-}
-
 void NtpClient::Send() {
-	GetTimeNtpFormat(T1.nSeconds, T1.nFraction);
+	ntp::get_time_ntp_format(m_nUtcOffset, T1);
 
-	m_Request.OriginTimestamp_s = __builtin_bswap32(T1.nSeconds);
-	m_Request.OriginTimestamp_f = __builtin_bswap32(T1.nFraction);
+	m_Request.Poll = static_cast<uint8_t>(m_NtpClock.GetPoll());
+	m_Request.TransmitTimestamp_s = __builtin_bswap32(T1.nSeconds);
+	m_Request.TransmitTimestamp_f = __builtin_bswap32(T1.nFraction);
 
 	Network::Get()->SendTo(m_nHandle, &m_Request, sizeof m_Request, m_nServerIp, ntp::UDP_PORT);
 }
 
-bool NtpClient::Receive(uint8_t& LiVnMode) {
+void NtpClient::Receive(const uint32_t nMillis) {
 	uint32_t nFromIp;
 	uint16_t nFromPort;
-	ntp::Packet *pReply;
+	ntp::Packet *pPacket;
 
-	const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&pReply)), &nFromIp, &nFromPort);
+	const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&pPacket)), &nFromIp, &nFromPort);
 
-	if (__builtin_expect((nBytesReceived != sizeof(struct ntp::Packet)), 1)) {
-		return false;
+	if (__builtin_expect((nBytesReceived < sizeof(struct ntp::Packet)), 1)) {
+		return;
 	}
 
-	GetTimeNtpFormat(T4.nSeconds, T4.nFraction);
+	const auto nMode = pPacket->LiVnMode & ntp::MODE_MASK;
+
+	// The port is shared with the SNTP server
+	if (nMode == ntp::MODE_CLIENT) {
+		if (SntpServer::Get() != nullptr) {
+			SntpServer::Get()->Reply(pPacket, nFromIp, nFromPort);
+		}
+		return;
+	}
+
+	ntp::get_time_ntp_format(m_nUtcOffset, T4);
+
+	if (__builtin_expect((!m_bRequest), 0)) {
+		return;
+	}
 
 	if (__builtin_expect((nFromIp != m_nServerIp), 0)) {
 		DEBUG_PUTS("nFromIp != m_nServerIp");
-		return false;
+		return;
 	}
 
-	LiVnMode = pReply->LiVnMode;
+	// A reply to the last request only: the originate time stamp is the transmit time stamp of the request
+	if ((nMode != ntp::MODE_SERVER) || (__builtin_bswap32(pPacket->OriginTimestamp_s) != T1.nSeconds) || (__builtin_bswap32(pPacket->OriginTimestamp_f) != T1.nFraction)) {
+		DEBUG_PUTS("!>> Invalid reply <<!");
+		return;
+	}
 
-	T2.nSeconds = __builtin_bswap32(pReply->ReceiveTimestamp_s);
-	T2.nFraction = __builtin_bswap32(pReply->ReceiveTimestamp_f);
+	if (((pPacket->LiVnMode & ntp::LI_ALARM) == ntp::LI_ALARM) || (pPacket->Stratum == 0) || (pPacket->Stratum >= 16)) {
+		DEBUG_PUTS("Server is not synchronised");
+		m_bRequest = false;
+		SetStatus(ntpclient::Status::FAILED);
+		return;
+	}
 
-	T3.nSeconds = __builtin_bswap32(pReply->TransmitTimestamp_s);
-	T3.nFraction = __builtin_bswap32(pReply->TransmitTimestamp_f);
+	m_nStratum = pPacket->Stratum;
+
+	T2.nSeconds = __builtin_bswap32(pPacket->ReceiveTimestamp_s);
+	T2.nFraction = __builtin_bswap32(pPacket->ReceiveTimestamp_f);
+
+	T3.nSeconds = __builtin_bswap32(pPacket->TransmitTimestamp_s);
+	T3.nFraction = __builtin_bswap32(pPacket->TransmitTimestamp_f);
 
 	PrintNtpTime("Originate", &T1);
 	PrintNtpTime("Receive", &T2);
 	PrintNtpTime("Transmit", &T3);
 	PrintNtpTime("Destination", &T4);
 
-	return true;
+	m_bRequest = false;
+
+	Update(nMillis);
+
+	SetStatus(m_NtpClock.IsSynchronised() ? ntpclient::Status::IDLE : ntpclient::Status::WAITING);
 }
 
-void NtpClient::Difference(const struct TimeStamp *Start, const struct TimeStamp *Stop, int32_t &nDiffSeconds, uint32_t &nDiffMicros) {
-	nDiffSeconds = static_cast<int32_t>(Stop->nSeconds - Start->nSeconds);
-	uint32_t nDiffFraction;
+void NtpClient::Update(const uint32_t nMillis) {
+	int64_t nOffsetMicros;
+	int32_t nDelayMicros;
 
-	if (Stop->nFraction >= Start->nFraction) {
-		nDiffFraction = Stop->nFraction - Start->nFraction;
-	} else {
-		nDiffFraction = Start->nFraction - Stop->nFraction;
-		nDiffFraction = ~nDiffFraction;
-		nDiffSeconds -= 1;
+	NtpClock::Compute(T1, T2, T3, T4, nOffsetMicros, nDelayMicros);
+
+	DEBUG_PRINTF("offset=%d, delay=%d", static_cast<int>(nOffsetMicros), nDelayMicros);
+
+	const auto action = m_NtpClock.Sample(nOffsetMicros, nDelayMicros, nMillis);
+
+	if (action == ntpclock::Action::NONE) {
+		return;
 	}
 
-	nDiffMicros = USEC(nDiffFraction);
+	if (action == ntpclock::Action::STEP) {
+		Step(m_NtpClock.GetStepMicros());
+	}
 
-	DEBUG_PRINTF("Seconds  %u - %u = %d", Stop->nSeconds, Start->nSeconds, nDiffSeconds);
-	DEBUG_PRINTF("Micros   %u - %u = %u", USEC(Stop->nFraction), USEC(Start->nFraction), nDiffMicros);
+	ntp::get_time_ntp_format(m_nUtcOffset, m_ReferenceTime);
 }
 
-int NtpClient::SetTimeOfDay() {
-	int32_t nDiffSeconds1, nDiffSeconds2 ;
-	uint32_t nDiffFraction1, nDiffFraction2;
+void NtpClient::Step(const int64_t nStepMicros) {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
 
-	Difference(&T1, &T2, nDiffSeconds1, nDiffFraction1);
-	Difference(&T4, &T3, nDiffSeconds2, nDiffFraction2);
+	const auto nMicros = (static_cast<int64_t>(tv.tv_sec) * 1000000) + tv.tv_usec + nStepMicros;
 
-	m_nOffsetSeconds = nDiffSeconds1 + nDiffSeconds2;
-	m_nOffsetMicros = nDiffFraction1 + nDiffFraction2;
+	tv.tv_sec = static_cast<time_t>(nMicros / 1000000);
+	tv.tv_usec = static_cast<suseconds_t>(nMicros % 1000000);
 
-	if (m_nOffsetMicros >= 1000000u) {
-		m_nOffsetMicros -= 1000000u;
-		m_nOffsetSeconds += 1;
-	}
+	settimeofday(&tv, nullptr);
 
-	m_nOffsetSeconds /= 2;
-	m_nOffsetMicros /= 2;
+#if !defined(DISABLE_RTC)
+	printf("Set RTC from System Clock\n");
+	HwClock::Get()->SysToHc();
+#endif
 
-	struct timeval tv;
+#ifndef NDEBUG
+	const auto nTime = time(nullptr);
+	const auto *pLocalTime = localtime(&nTime);
+	DEBUG_PRINTF("localtime: %.4d/%.2d/%.2d %.2d:%.2d:%.2d", pLocalTime->tm_year, pLocalTime->tm_mon, pLocalTime->tm_mday, pLocalTime->tm_hour, pLocalTime->tm_min, pLocalTime->tm_sec);
+#endif
+}
 
-	tv.tv_sec =	static_cast<time_t>(T4.nSeconds - JAN_1970)  + m_nOffsetSeconds + m_nUtcOffset;
-	tv.tv_usec = (static_cast<int32_t>(USEC(T4.nFraction)) + static_cast<int32_t>(m_nOffsetMicros));
+void NtpClient::Adjust() {
+	const auto nAdjustMicros = m_NtpClock.Adjust();
 
-	if (tv.tv_usec >= 1000000) {
-		tv.tv_sec++;
-		tv.tv_usec = 1000000 - tv.tv_usec;
+	if (nAdjustMicros == 0) {
+		return;
 	}
 
-	DEBUG_PRINTF("(%ld, %d) %s ", tv.tv_sec, static_cast<int>(tv.tv_usec) , tv.tv_usec  >= 1E6 ? "!" : "");
-	DEBUG_PRINTF("%d %u",m_nOffsetSeconds, m_nOffsetMicros);
-
-	return settimeofday(&tv, nullptr);
+	const struct timeval delta = { 0, nAdjustMicros };
+	adjtime(&delta, nullptr);
 }
 
 void NtpClient::Start() {
@@ -204,59 +214,15 @@ void NtpClient::Start() {
 	m_nHandle = Network::Get()->Begin(ntp::UDP_PORT);
 	assert(m_nHandle != -1);
 
-	ntpclient::display_status(m_Status);
-
-	const auto nNow = Hardware::Get()->Millis();
-	uint32_t nRetries;
-
-	for (nRetries = 0; nRetries < RETRIES; nRetries++) {
-		Send();
-
-		uint8_t LiVnMode = 0;
-
-		while (!Receive(LiVnMode)) {
-#if defined (HAVE_NET_HANDLE)
-			net_handle();
-#endif
-			if ((Hardware::Get()->Millis() - nNow) > ntpclient::TIMEOUT_MILLIS) {
-				break;
-			}
-		}
-
-		if ((LiVnMode & ntp::MODE_SERVER) == ntp::MODE_SERVER) {
-			if (SetTimeOfDay() == 0) {
-				m_Status = ntpclient::Status::IDLE;
-			} else {
-				// Error
-			}
-		} else {
-			m_Status = ntpclient::Status::FAILED;
-			DEBUG_PUTS("!>> Invalid reply <<!");
-		}
-
-		break;
-	}
-
-	m_MillisLastPoll = Hardware::Get()->Millis();
+	m_NtpClock.Reset();
 
-	if (nRetries == RETRIES) {
-		m_Status = ntpclient::Status::FAILED;
-	}
+	// The first request is sent by the next Run
+	const auto nMillis = Hardware::Get()->Millis();
+	m_MillisLastPoll = nMillis - m_NtpClock.GetPollMillis();
+	m_nMillisAdjust = nMillis;
+	m_bRequest = false;
 
-	DEBUG_PRINTF("nRetries=%d, m_Status=%d", nRetries, static_cast<int>(m_Status));
-
-#if !defined(DISABLE_RTC)
-	if (m_Status != ntpclient::Status::FAILED) {
-		printf("Set RTC from System Clock\n");
-		HwClock::Get()->SysToHc();
-#ifndef NDEBUG
-		const auto rawtime = time(nullptr);
-		printf(asctime(localtime(&rawtime)));
-#endif
-	}
-#endif
-
-	ntpclient::display_status(m_Status);
+	SetStatus(ntpclient::Status::WAITING);
 
 	DEBUG_EXIT
 }
@@ -269,21 +235,25 @@ void NtpClient::Stop() {
 	}
 
 	assert(m_nHandle != -1);
-	Network::Get()->End(ntp::UDP_PORT);
-	m_nHandle = -1;
 
-	m_Status = ntpclient::Status::STOPPED;
+	// The port is shared with the SNTP server
+	if (SntpServer::Get() == nullptr) {
+		Network::Get()->End(ntp::UDP_PORT);
+	}
+
+	m_nHandle = -1;
+	m_bRequest = false;
 
-	ntpclient::display_status(ntpclient::Status::STOPPED);
+	SetStatus(ntpclient::Status::STOPPED);
 
 	DEBUG_EXIT
 }
 
-void NtpClient::PrintNtpTime([[maybe_unused]] const char *pText, [[maybe_unused]] const struct TimeStamp *pNtpTime) {
+void NtpClient::PrintNtpTime([[maybe_unused]] const char *pText, [[maybe_unused]] const struct ntp::TimeStamp *pNtpTime) {
 #ifndef NDEBUG
-	const auto nSeconds = static_cast<time_t>(pNtpTime->nSeconds - JAN_1970);
+	const auto nSeconds = static_cast<time_t>(pNtpTime->nSeconds - ntp::NTP_TIMESTAMP_DELTA);
 	const auto *pTm = localtime(&nSeconds);
-	printf("%s %02d:%02d:%02d.%06d %04d [%u]\n", pText, pTm->tm_hour, pTm->tm_min,  pTm->tm_sec, USEC(pNtpTime->nFraction), pTm->tm_year + 1900, pNtpTime->nSeconds);
+	printf("%s %02d:%02d:%02d.%06d %04d [%u]\n", pText, pTm->tm_hour, pTm->tm_min,  pTm->tm_sec, ntp::fraction_to_micros(pNtpTime->nFraction), pTm->tm_year + 1900, pNtpTime->nSeconds);
 #endif
 }
 
@@ -298,6 +268,13 @@ void NtpClient::Print() {
 	printf(" Server : " IPSTR ":%d\n", IP2STR(m_nServerIp), ntp::UDP_PORT);
 	auto rawtime = time(nullptr);
 	printf(" %s UTC offset : %d (seconds)\n", asctime(localtime(&rawtime)), m_nUtcOffset);
+
+	if (m_NtpClock.IsSynchronised()) {
+		printf(" Stratum %u, poll %u s\n", m_nStratum, 1U << m_NtpClock.GetPoll());
+		printf(" Offset %d us, delay %d us, frequency %d ppb, steps %u\n", static_cast<int>(m_NtpClock.GetOffsetMicros()), m_NtpClock.GetDelayMicros(), m_NtpClock.GetFrequencyPpb(), m_NtpClock.GetSteps());
+	} else {
+		printf(" Not synchronised\n");
+	}
 #ifndef NDEBUG
 	PrintNtpTime("Originate", &T1);
 	PrintNtpTime("Receive", &T2);
@@ -0,0 +1,220 @@
+/**
+ * @file ntpclock.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "ntpclock.h"
+
+#include "debug.h"
+
+using namespace ntpclock;
+
+static_assert((FILTER_SIZE & (FILTER_SIZE - 1)) == 0, "FILTER_SIZE must be a power of 2");
+
+void NtpClock::Reset() {
+	memset(m_Filter, 0, sizeof(m_Filter));
+	m_nFilterIndex = 0;
+	m_nSamples = 0;
+	m_nMillisLastUsed = 0;
+	m_nOffsetMicros = 0;
+	m_nStepMicros = 0;
+	m_nPhaseMicros = 0;
+	m_nDelayMicros = 0;
+	m_nFrequency = 0;
+	m_nFrequencyRemainder = 0;
+	m_nPoll = MINPOLL;
+	m_nPollStable = 0;
+	m_nSteps = 0;
+	m_bSynchronised = false;
+}
+
+int32_t NtpClock::Select(const uint32_t nMillis, int32_t& nDelayMin) const {
+	const auto nValid = (m_nSamples < FILTER_SIZE) ? m_nSamples : FILTER_SIZE;
+	int32_t nSelected = -1;
+	int64_t nDistanceMin = INT64_MAX;
+
+	nDelayMin = INT32_MAX;
+
+	for (uint32_t i = 0; i < nValid; i++) {
+		if (m_Filter[i].nDelayMicros < nDelayMin) {
+			nDelayMin = m_Filter[i].nDelayMicros;
+		}
+
+		const auto nAgeSeconds = (nMillis - m_Filter[i].nMillis) / 1000U;
+		const auto nDistance = static_cast<int64_t>(m_Filter[i].nDelayMicros) + (static_cast<int64_t>(nAgeSeconds) * PHI_MICROS_PER_SECOND);
+
+		if (nDistance < nDistanceMin) {
+			nDistanceMin = nDistance;
+			nSelected = static_cast<int32_t>(i);
+		}
+	}
+
+	return nSelected;
+}
+
+Action NtpClock::Step(const int64_t nOffsetMicros, const uint32_t nMillis) {
+	DEBUG_PRINTF("Step %d ms", static_cast<int>(nOffsetMicros / 1000));
+
+	m_nStepMicros = nOffsetMicros;
+	m_nSteps++;
+
+	// The samples in the filter are still valid after the step
+	for (auto& sample : m_Filter) {
+		sample.nOffsetMicros -= nOffsetMicros;
+	}
+
+	m_nPhaseMicros = 0;
+	m_nMillisLastUsed = nMillis;
+	m_nPoll = MINPOLL;
+	m_nPollStable = 0;
+	m_bSynchronised = true;
+
+	return Action::STEP;
+}
+
+Action NtpClock::Sample(const int64_t nOffsetMicros, const int32_t nDelayMicros, const uint32_t nMillis) {
+	if ((nDelayMicros < 0) || (nDelayMicros > DELAY_MAX_MICROS)) {
+		DEBUG_PRINTF("Delay %d", nDelayMicros);
+		return Action::NONE;
+	}
+
+	m_Filter[m_nFilterIndex].nOffsetMicros = nOffsetMicros;
+	m_Filter[m_nFilterIndex].nDelayMicros = nDelayMicros;
+	m_Filter[m_nFilterIndex].nMillis = nMillis;
+	m_nFilterIndex = (m_nFilterIndex + 1) & (FILTER_SIZE - 1);
+	m_nSamples++;
+
+	if (!m_bSynchronised && (m_nSamples < BURST)) {
+		return Action::NONE;
+	}
+
+	int32_t nDelayMin;
+	const auto nSelected = Select(nMillis, nDelayMin);
+
+	if (nSelected < 0) {
+		return Action::NONE;
+	}
+
+	const auto& selected = m_Filter[nSelected];
+
+	if (selected.nDelayMicros > ((2 * nDelayMin) + DELAY_GATE_MICROS)) {
+		DEBUG_PRINTF("Spike %d %d", selected.nDelayMicros, nDelayMin);
+		return Action::NONE;
+	}
+
+	// Only a sample newer than the one used before gives new information
+	if (m_bSynchronised && (static_cast<int32_t>(selected.nMillis - m_nMillisLastUsed) <= 0)) {
+		return Action::NONE;
+	}
+
+	m_nOffsetMicros = selected.nOffsetMicros;
+	m_nDelayMicros = selected.nDelayMicros;
+
+	if ((selected.nOffsetMicros > STEP_THRESHOLD_MICROS) || (selected.nOffsetMicros < -STEP_THRESHOLD_MICROS)) {
+		return Step(selected.nOffsetMicros, selected.nMillis);
+	}
+
+	if (!m_bSynchronised) {
+		m_nPhaseMicros = selected.nOffsetMicros;
+		m_nMillisLastUsed = selected.nMillis;
+		m_bSynchronised = true;
+		return Action::UPDATE;
+	}
+
+	/*
+	 * The phase of the previous update is corrected,
+	 * the offset that is left is caused by the frequency error.
+	 */
+
+	const auto nSeconds = (selected.nMillis - m_nMillisLastUsed) / 1000U;
+	const auto nResidualMicros = selected.nOffsetMicros - m_nPhaseMicros;
+
+	if (nSeconds >= FREQUENCY_SECONDS_MIN) {
+		auto nFrequency = static_cast<int64_t>(m_nFrequency) + (((nResidualMicros * (1 << 16)) / nSeconds) / (1 << FREQUENCY_SHIFT));
+
+		if (nFrequency > FREQUENCY_MAX) {
+			nFrequency = FREQUENCY_MAX;
+		} else if (nFrequency < -FREQUENCY_MAX) {
+			nFrequency = -FREQUENCY_MAX;
+		}
+
+		m_nFrequency = static_cast<int32_t>(nFrequency);
+	}
+
+	m_nPhaseMicros = selected.nOffsetMicros;
+	m_nMillisLastUsed = selected.nMillis;
+
+	// A stable clock is polled less often
+	const auto nResidualAbs = (nResidualMicros < 0) ? -nResidualMicros : nResidualMicros;
+
+	if (nResidualAbs < POLL_STABLE_MICROS) {
+		if ((++m_nPollStable >= POLL_STABLE_COUNT) && (m_nPoll < MAXPOLL)) {
+			m_nPoll++;
+			m_nPollStable = 0;
+		}
+	} else if (nResidualAbs > POLL_UNSTABLE_MICROS) {
+		m_nPollStable = 0;
+
+		if (m_nPoll > MINPOLL) {
+			m_nPoll--;
+		}
+	}
+
+	return Action::UPDATE;
+}
+
+int32_t NtpClock::Adjust() {
+	if (!m_bSynchronised) {
+		return 0;
+	}
+
+	auto nPhase = static_cast<int32_t>(m_nPhaseMicros / PHASE_DIVISOR);
+
+	if (nPhase == 0) {
+		nPhase = static_cast<int32_t>(m_nPhaseMicros);
+	}
+
+	m_nFrequencyRemainder += m_nFrequency;
+	const auto nFrequency = m_nFrequencyRemainder / (1 << 16);
+	m_nFrequencyRemainder -= nFrequency * (1 << 16);
+
+	auto nAdjust = nPhase + nFrequency;
+
+	if (nAdjust > SLEW_MAX_MICROS) {
+		nAdjust = SLEW_MAX_MICROS;
+	} else if (nAdjust < -SLEW_MAX_MICROS) {
+		nAdjust = -SLEW_MAX_MICROS;
+	}
+
+	m_nPhaseMicros -= (nAdjust - nFrequency);
+
+	// The clock is moved, so is the offset of the samples
+	for (auto& sample : m_Filter) {
+		sample.nOffsetMicros -= nAdjust;
+	}
+
+	return nAdjust;
+}
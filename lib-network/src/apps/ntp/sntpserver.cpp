@@ -0,0 +1,157 @@
+/**
+ * @file sntpserver.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * https://tools.ietf.org/html/rfc4330
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+#include "sntpserver.h"
+#include "ntpclient.h"
+#include "ntp.h"
+
+#include "utc.h"
+
+#include "network.h"
+
+#include "debug.h"
+
+ntp::Packet SntpServer::s_Reply;
+SntpServer *SntpServer::s_pThis;
+
+SntpServer::SntpServer() {
+	DEBUG_ENTRY
+
+	assert(s_pThis == nullptr);
+	s_pThis = this;
+
+	m_nUtcOffset = hal::utc_validate((Network::Get()->GetNtpUtcOffset()));
+
+	DEBUG_EXIT
+}
+
+SntpServer::~SntpServer() {
+	Stop();
+
+	s_pThis = nullptr;
+}
+
+bool SntpServer::IsShared() const {
+	const auto *pNtpClient = NtpClient::Get();
+	return (pNtpClient != nullptr) && (pNtpClient->GetStatus() != ntpclient::Status::STOPPED);
+}
+
+void SntpServer::Start() {
+	DEBUG_ENTRY
+
+	assert(m_nHandle == -1);
+	m_nHandle = Network::Get()->Begin(ntp::UDP_PORT);
+	assert(m_nHandle != -1);
+
+	memset(&s_Reply, 0, sizeof(struct ntp::Packet));
+
+	s_Reply.Precision = static_cast<uint8_t>(sntpserver::PRECISION);
+
+	DEBUG_EXIT
+}
+
+void SntpServer::Stop() {
+	DEBUG_ENTRY
+
+	if (m_nHandle == -1) {
+		DEBUG_EXIT
+		return;
+	}
+
+	// The port is shared with the NTP client
+	if (!IsShared()) {
+		Network::Get()->End(ntp::UDP_PORT);
+	}
+
+	m_nHandle = -1;
+
+	DEBUG_EXIT
+}
+
+void SntpServer::Reply(const ntp::Packet *pRequest, const uint32_t nFromIp, const uint16_t nFromPort) {
+	struct ntp::TimeStamp receive;
+	ntp::get_time_ntp_format(m_nUtcOffset, receive);
+
+	m_nRequests++;
+
+	const auto *pNtpClient = NtpClient::Get();
+	const auto isClient = IsShared();
+	const auto nVersion = pRequest->LiVnMode & (0x7 << 3);
+
+	if (!isClient) {
+		// Free running, this node is the time master
+		s_Reply.LiVnMode = static_cast<uint8_t>(nVersion | ntp::MODE_SERVER);
+		s_Reply.Stratum = sntpserver::STRATUM_LOCAL;
+		s_Reply.RootDelay = 0;
+		s_Reply.ReferenceID = ('L' << 0) | ('O' << 8) | ('C' << 16) | ('L' << 24);
+		s_Reply.ReferenceTimestamp_s = __builtin_bswap32(receive.nSeconds);
+		s_Reply.ReferenceTimestamp_f = 0;
+	} else if (pNtpClient->IsSynchronised()) {
+		s_Reply.LiVnMode = static_cast<uint8_t>(nVersion | ntp::MODE_SERVER);
+		s_Reply.Stratum = static_cast<uint8_t>(pNtpClient->GetStratum() + 1);
+		// Seconds 16.16
+		s_Reply.RootDelay = __builtin_bswap32(static_cast<uint32_t>((static_cast<uint64_t>(pNtpClient->GetClock().GetDelayMicros()) << 16) / 1000000U));
+		s_Reply.ReferenceID = pNtpClient->GetServerIp();
+		s_Reply.ReferenceTimestamp_s = __builtin_bswap32(pNtpClient->GetReferenceTime().nSeconds);
+		s_Reply.ReferenceTimestamp_f = __builtin_bswap32(pNtpClient->GetReferenceTime().nFraction);
+	} else {
+		s_Reply.LiVnMode = static_cast<uint8_t>(ntp::LI_ALARM | nVersion | ntp::MODE_SERVER);
+		s_Reply.Stratum = sntpserver::STRATUM_UNSYNCHRONISED;
+		s_Reply.RootDelay = 0;
+		s_Reply.ReferenceID = 0;
+		s_Reply.ReferenceTimestamp_s = 0;
+		s_Reply.ReferenceTimestamp_f = 0;
+	}
+
+	s_Reply.Poll = pRequest->Poll;
+	s_Reply.OriginTimestamp_s = pRequest->TransmitTimestamp_s;
+	s_Reply.OriginTimestamp_f = pRequest->TransmitTimestamp_f;
+	s_Reply.ReceiveTimestamp_s = __builtin_bswap32(receive.nSeconds);
+	s_Reply.ReceiveTimestamp_f = __builtin_bswap32(receive.nFraction);
+
+	struct ntp::TimeStamp transmit;
+	ntp::get_time_ntp_format(m_nUtcOffset, transmit);
+
+	s_Reply.TransmitTimestamp_s = __builtin_bswap32(transmit.nSeconds);
+	s_Reply.TransmitTimestamp_f = __builtin_bswap32(transmit.nFraction);
+
+	Network::Get()->SendTo(m_nHandle, &s_Reply, sizeof(struct ntp::Packet), nFromIp, nFromPort);
+}
+
+void SntpServer::Print() {
+	printf("SNTP v%d Server\n", ntp::VERSION >> 3);
+	printf(" Port : %d\n", ntp::UDP_PORT);
+	printf(" %s\n", IsShared() ? "NTP client" : "Local clock");
+	printf(" Requests : %u\n", m_nRequests);
+}
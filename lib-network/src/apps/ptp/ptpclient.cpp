@@ -0,0 +1,390 @@
+/**
+ * @file ptpclient.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * IEEE 1588-2008
+ * Sync            t1 master to slave, the precise time in Follow_Up when two-step
+ * Delay_Req       t3 slave to master
+ * Delay_Resp      t4 the reception of Delay_Req by the master
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+#include "ptpclient.h"
+#include "ptpclock.h"
+#include "ptp.h"
+
+#include "network.h"
+#include "hardware.h"
+
+#include "debug.h"
+
+using namespace ptpclient;
+
+ptp::Event PtpClient::s_DelayReq;
+PtpClient *PtpClient::s_pThis;
+
+static constexpr uint16_t PORT_NUMBER = 1;
+
+static uint32_t log_interval_to_millis(const int8_t nLogInterval) {
+	// 1/8 second up to 16 seconds
+	if (nLogInterval < -3) {
+		return 125;
+	}
+
+	if (nLogInterval > 4) {
+		return 16000;
+	}
+
+	return (nLogInterval >= 0) ? (1000U << nLogInterval) : (1000U >> -nLogInterval);
+}
+
+/**
+ * The data set comparison of the best master clock algorithm, without the topology
+ * @return true when the Announce is from a better grandmaster
+ */
+static bool is_better(const ptp::Announce *pAnnounce, const Master& master) {
+	if (pAnnounce->GrandmasterPriority1 != master.nPriority1) {
+		return pAnnounce->GrandmasterPriority1 < master.nPriority1;
+	}
+
+	if (pAnnounce->GrandmasterClockClass != master.nClockClass) {
+		return pAnnounce->GrandmasterClockClass < master.nClockClass;
+	}
+
+	if (pAnnounce->GrandmasterClockAccuracy != master.nClockAccuracy) {
+		return pAnnounce->GrandmasterClockAccuracy < master.nClockAccuracy;
+	}
+
+	const auto nClockVariance = __builtin_bswap16(pAnnounce->GrandmasterClockVariance);
+
+	if (nClockVariance != master.nClockVariance) {
+		return nClockVariance < master.nClockVariance;
+	}
+
+	if (pAnnounce->GrandmasterPriority2 != master.nPriority2) {
+		return pAnnounce->GrandmasterPriority2 < master.nPriority2;
+	}
+
+	const auto nCompare = memcmp(pAnnounce->GrandmasterIdentity, master.GrandmasterIdentity, ptp::CLOCK_IDENTITY_LENGTH);
+
+	if (nCompare != 0) {
+		return nCompare < 0;
+	}
+
+	return __builtin_bswap16(pAnnounce->StepsRemoved) < master.nStepsRemoved;
+}
+
+PtpClient::PtpClient(const uint8_t nDomain): m_nDomain(nDomain) {
+	DEBUG_ENTRY
+	assert(s_pThis == nullptr);
+	s_pThis = this;
+
+	memset(&m_Master, 0, sizeof(m_Master));
+
+	// EUI-64 of the MAC address
+	uint8_t aMacAddress[6];
+	Network::Get()->MacAddressCopyTo(aMacAddress);
+
+	m_ClockIdentity[0] = aMacAddress[0];
+	m_ClockIdentity[1] = aMacAddress[1];
+	m_ClockIdentity[2] = aMacAddress[2];
+	m_ClockIdentity[3] = 0xFF;
+	m_ClockIdentity[4] = 0xFE;
+	m_ClockIdentity[5] = aMacAddress[3];
+	m_ClockIdentity[6] = aMacAddress[4];
+	m_ClockIdentity[7] = aMacAddress[5];
+
+	memset(&s_DelayReq, 0, sizeof(struct ptp::Event));
+
+	s_DelayReq.Header.TransportSpecificMessageType = ptp::message::DELAY_REQ;
+	s_DelayReq.Header.Version = ptp::VERSION;
+	s_DelayReq.Header.MessageLength = __builtin_bswap16(sizeof(struct ptp::Event));
+	s_DelayReq.Header.DomainNumber = m_nDomain;
+	memcpy(s_DelayReq.Header.ClockIdentity, m_ClockIdentity, ptp::CLOCK_IDENTITY_LENGTH);
+	s_DelayReq.Header.PortNumber = __builtin_bswap16(PORT_NUMBER);
+	s_DelayReq.Header.ControlField = ptp::control::DELAY_REQ;
+	s_DelayReq.Header.LogMessageInterval = ptp::LOG_MESSAGE_INTERVAL_UNUSED;
+
+	DEBUG_EXIT
+}
+
+void PtpClient::Start() {
+	DEBUG_ENTRY
+
+	assert(m_nHandleEvent == -1);
+	assert(m_nHandleGeneral == -1);
+
+	m_nHandleEvent = Network::Get()->Begin(ptp::UDP_PORT_EVENT);
+	assert(m_nHandleEvent != -1);
+
+	m_nHandleGeneral = Network::Get()->Begin(ptp::UDP_PORT_GENERAL);
+	assert(m_nHandleGeneral != -1);
+
+	Network::Get()->JoinGroup(m_nHandleEvent, ptp::MULTICAST_IP);
+	Network::Get()->JoinGroup(m_nHandleGeneral, ptp::MULTICAST_IP);
+
+	Listening();
+
+	DEBUG_EXIT
+}
+
+void PtpClient::Stop() {
+	DEBUG_ENTRY
+
+	if (m_State == State::DISABLED) {
+		DEBUG_EXIT
+		return;
+	}
+
+	Network::Get()->LeaveGroup(m_nHandleGeneral, ptp::MULTICAST_IP);
+	Network::Get()->LeaveGroup(m_nHandleEvent, ptp::MULTICAST_IP);
+
+	Network::Get()->End(ptp::UDP_PORT_GENERAL);
+	Network::Get()->End(ptp::UDP_PORT_EVENT);
+
+	m_nHandleGeneral = -1;
+	m_nHandleEvent = -1;
+
+	m_State = State::DISABLED;
+
+	DEBUG_EXIT
+}
+
+void PtpClient::Listening() {
+	DEBUG_ENTRY
+
+	memset(&m_Master, 0, sizeof(m_Master));
+	m_PtpClock.Reset();
+	m_bSyncPending = false;
+	m_bDelayReqPending = false;
+	m_nDelayReqMillis = log_interval_to_millis(LOG_DELAY_REQ_INTERVAL);
+	m_State = State::LISTENING;
+
+	DEBUG_EXIT
+}
+
+bool PtpClient::IsFromMaster(const ptp::Header *pHeader) const {
+	return (m_State != State::LISTENING)
+			&& (pHeader->PortNumber == __builtin_bswap16(m_Master.nPortNumber))
+			&& (memcmp(pHeader->ClockIdentity, m_Master.ClockIdentity, ptp::CLOCK_IDENTITY_LENGTH) == 0);
+}
+
+void PtpClient::HandleEvent() {
+	const uint8_t *pBuffer;
+	uint32_t nFromIp;
+	uint16_t nFromPort;
+
+	const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandleEvent, reinterpret_cast<const void **>(&pBuffer), &nFromIp, &nFromPort);
+	// t2, as early as possible
+	const auto nMicros = Hardware::Get()->Micros();
+
+	if (__builtin_expect((nBytesReceived < sizeof(struct ptp::Event)), 1)) {
+		return;
+	}
+
+	const auto *pHeader = reinterpret_cast<const ptp::Header *>(pBuffer);
+
+	if (((pHeader->Version & 0x0F) != ptp::VERSION) || (pHeader->DomainNumber != m_nDomain)) {
+		return;
+	}
+
+	if ((pHeader->TransportSpecificMessageType & ptp::message::TYPE_MASK) == ptp::message::SYNC) {
+		HandleSync(reinterpret_cast<const ptp::Event *>(pBuffer), nMicros);
+	}
+}
+
+void PtpClient::HandleGeneral() {
+	const uint8_t *pBuffer;
+	uint32_t nFromIp;
+	uint16_t nFromPort;
+
+	const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandleGeneral, reinterpret_cast<const void **>(&pBuffer), &nFromIp, &nFromPort);
+
+	if (__builtin_expect((nBytesReceived < sizeof(struct ptp::Event)), 1)) {
+		return;
+	}
+
+	const auto *pHeader = reinterpret_cast<const ptp::Header *>(pBuffer);
+
+	if (((pHeader->Version & 0x0F) != ptp::VERSION) || (pHeader->DomainNumber != m_nDomain)) {
+		return;
+	}
+
+	switch (pHeader->TransportSpecificMessageType & ptp::message::TYPE_MASK) {
+	case ptp::message::ANNOUNCE:
+		if (nBytesReceived >= sizeof(struct ptp::Announce)) {
+			HandleAnnounce(reinterpret_cast<const ptp::Announce *>(pBuffer), nFromIp, Hardware::Get()->Millis());
+		}
+		break;
+	case ptp::message::FOLLOW_UP:
+		HandleFollowUp(reinterpret_cast<const ptp::Event *>(pBuffer));
+		break;
+	case ptp::message::DELAY_RESP:
+		if (nBytesReceived >= sizeof(struct ptp::DelayResp)) {
+			HandleDelayResp(reinterpret_cast<const ptp::DelayResp *>(pBuffer));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void PtpClient::HandleAnnounce(const ptp::Announce *pAnnounce, const uint32_t nFromIp, const uint32_t nMillis) {
+	if (memcmp(pAnnounce->Header.ClockIdentity, m_ClockIdentity, ptp::CLOCK_IDENTITY_LENGTH) == 0) {
+		return;
+	}
+
+	if (__builtin_bswap16(pAnnounce->StepsRemoved) >= 255) {
+		return;
+	}
+
+	if (!IsFromMaster(&pAnnounce->Header)) {
+		if ((m_State != State::LISTENING) && !is_better(pAnnounce, m_Master)) {
+			return;
+		}
+
+		DEBUG_PRINTF("Master " IPSTR, IP2STR(nFromIp));
+
+		// A new master, the time can be different
+		m_PtpClock.Reset();
+		m_bSyncPending = false;
+		m_bDelayReqPending = false;
+		m_State = State::UNCALIBRATED;
+
+		memcpy(m_Master.ClockIdentity, pAnnounce->Header.ClockIdentity, ptp::CLOCK_IDENTITY_LENGTH);
+		m_Master.nPortNumber = __builtin_bswap16(pAnnounce->Header.PortNumber);
+		m_Master.nIp = nFromIp;
+	}
+
+	m_Master.nPriority1 = pAnnounce->GrandmasterPriority1;
+	m_Master.nClockClass = pAnnounce->GrandmasterClockClass;
+	m_Master.nClockAccuracy = pAnnounce->GrandmasterClockAccuracy;
+	m_Master.nClockVariance = __builtin_bswap16(pAnnounce->GrandmasterClockVariance);
+	m_Master.nPriority2 = pAnnounce->GrandmasterPriority2;
+	memcpy(m_Master.GrandmasterIdentity, pAnnounce->GrandmasterIdentity, ptp::CLOCK_IDENTITY_LENGTH);
+	m_Master.nStepsRemoved = __builtin_bswap16(pAnnounce->StepsRemoved);
+	m_Master.nUtcOffset = static_cast<int16_t>(__builtin_bswap16(static_cast<uint16_t>(pAnnounce->CurrentUtcOffset)));
+	m_Master.bUtcOffsetValid = (__builtin_bswap16(pAnnounce->Header.FlagField) & ptp::flag::UTC_OFFSET_VALID) == ptp::flag::UTC_OFFSET_VALID;
+	m_Master.nMillisAnnounce = nMillis;
+	m_Master.nAnnounceTimeoutMillis = ANNOUNCE_RECEIPT_TIMEOUT * log_interval_to_millis(pAnnounce->Header.LogMessageInterval);
+}
+
+void PtpClient::HandleSync(const ptp::Event *pSync, const uint32_t nMicros) {
+	if (!IsFromMaster(&pSync->Header)) {
+		return;
+	}
+
+	const auto nCorrectionNanos = ptp::correction_to_nanos(pSync->Header.CorrectionField);
+
+	if ((__builtin_bswap16(pSync->Header.FlagField) & ptp::flag::TWO_STEP) == ptp::flag::TWO_STEP) {
+		m_nSyncMicros = nMicros;
+		m_nSyncCorrectionNanos = nCorrectionNanos;
+		m_nSyncSequenceId = pSync->Header.SequenceId;
+		m_bSyncPending = true;
+		return;
+	}
+
+	Update(m_PtpClock.Sync(ptp::timestamp_to_nanos(pSync->Timestamp) + nCorrectionNanos, nMicros));
+}
+
+void PtpClient::HandleFollowUp(const ptp::Event *pFollowUp) {
+	if (!m_bSyncPending || (pFollowUp->Header.SequenceId != m_nSyncSequenceId) || !IsFromMaster(&pFollowUp->Header)) {
+		return;
+	}
+
+	m_bSyncPending = false;
+
+	const auto nMasterNanos = ptp::timestamp_to_nanos(pFollowUp->Timestamp) + m_nSyncCorrectionNanos + ptp::correction_to_nanos(pFollowUp->Header.CorrectionField);
+
+	Update(m_PtpClock.Sync(nMasterNanos, m_nSyncMicros));
+}
+
+void PtpClient::Update(const ptpclock::Action action) {
+	m_nSyncs++;
+
+	if (action == ptpclock::Action::STEP) {
+		DEBUG_PUTS("Step");
+		// The first Delay_Req with the new time
+		m_bDelayReqPending = false;
+		m_nMillisDelayReq = Hardware::Get()->Millis() - m_nDelayReqMillis;
+	}
+
+	m_State = m_PtpClock.IsSynchronised() ? State::SLAVE : State::UNCALIBRATED;
+}
+
+void PtpClient::SendDelayReq() {
+	m_nDelayReqSequenceId++;
+	s_DelayReq.Header.SequenceId = __builtin_bswap16(m_nDelayReqSequenceId);
+	m_bDelayReqPending = true;
+
+	// t3, the frame leaves a little later
+	m_nDelayReqMicros = Hardware::Get()->Micros();
+
+	Network::Get()->SendTo(m_nHandleEvent, &s_DelayReq, sizeof(struct ptp::Event), ptp::MULTICAST_IP, ptp::UDP_PORT_EVENT);
+}
+
+void PtpClient::HandleDelayResp(const ptp::DelayResp *pDelayResp) {
+	if (!m_bDelayReqPending
+			|| (pDelayResp->Header.SequenceId != __builtin_bswap16(m_nDelayReqSequenceId))
+			|| (pDelayResp->RequestingPortNumber != __builtin_bswap16(PORT_NUMBER))
+			|| (memcmp(pDelayResp->RequestingClockIdentity, m_ClockIdentity, ptp::CLOCK_IDENTITY_LENGTH) != 0)
+			|| !IsFromMaster(&pDelayResp->Header)) {
+		return;
+	}
+
+	m_bDelayReqPending = false;
+	m_nDelayResps++;
+
+	// logMinDelayReqInterval
+	m_nDelayReqMillis = log_interval_to_millis(pDelayResp->Header.LogMessageInterval);
+
+	const auto nMasterNanos = ptp::timestamp_to_nanos(pDelayResp->ReceiveTimestamp) - ptp::correction_to_nanos(pDelayResp->Header.CorrectionField);
+
+	m_PtpClock.Delay(m_nDelayReqMicros, nMasterNanos);
+}
+
+void PtpClient::Print() {
+	static constexpr const char *STATE[] = { "Disabled", "Listening", "Uncalibrated", "Slave" };
+
+	printf("PTP v%d Slave\n", ptp::VERSION);
+	printf(" Domain : %u\n", m_nDomain);
+	printf(" State  : %s\n", STATE[static_cast<uint32_t>(m_State)]);
+
+	if ((m_State == State::DISABLED) || (m_State == State::LISTENING)) {
+		return;
+	}
+
+	const auto *p = m_Master.GrandmasterIdentity;
+	printf(" Grandmaster : %.2x%.2x%.2x.%.2x%.2x.%.2x%.2x%.2x, class %u\n", p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], m_Master.nClockClass);
+	printf(" Master      : " IPSTR "\n", IP2STR(m_Master.nIp));
+	printf(" Offset      : %d ns\n", static_cast<int>(m_PtpClock.GetOffsetNanos()));
+	printf(" Delay       : %d ns\n", static_cast<int>(m_PtpClock.GetDelayNanos()));
+	printf(" Frequency   : %d ppb\n", static_cast<int>(m_PtpClock.GetFrequencyPpb()));
+	printf(" Steps       : %u, Sync %u, Delay_Resp %u\n", m_PtpClock.GetSteps(), m_nSyncs, m_nDelayResps);
+}
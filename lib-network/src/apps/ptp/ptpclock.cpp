@@ -0,0 +1,231 @@
+/**
+ * @file ptpclock.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "ptpclock.h"
+
+#include "debug.h"
+
+using namespace ptpclock;
+
+static_assert((SYNC_FILTER_SIZE & (SYNC_FILTER_SIZE - 1)) == 0, "SYNC_FILTER_SIZE must be a power of 2");
+static_assert((DELAY_FILTER_SIZE & (DELAY_FILTER_SIZE - 1)) == 0, "DELAY_FILTER_SIZE must be a power of 2");
+
+void PtpClock::Reset() {
+	memset(m_SyncFilter, 0, sizeof(m_SyncFilter));
+	memset(m_DelayFilter, 0, sizeof(m_DelayFilter));
+	m_nSyncIndex = 0;
+	m_nSyncSamples = 0;
+	m_nDelayIndex = 0;
+	m_nDelaySamples = 0;
+	m_nMicrosLastUsed = 0;
+	m_nMicrosLastUpdate = 0;
+	m_nLocked = 0;
+	m_nSteps = 0;
+	m_nBaseNanos = 0;
+	m_nBaseMicros = 0;
+	m_nFrequencyPpb = 0;
+	m_nOffsetNanos = 0;
+	m_nDelayNanos = 0;
+	m_bValid = false;
+	m_bSynchronised = false;
+}
+
+void PtpClock::Rebase(const uint32_t nMicros) {
+	m_nBaseNanos = GetNanos(nMicros);
+	m_nBaseMicros = nMicros;
+}
+
+int32_t PtpClock::Select(const uint32_t nMicros) const {
+	const auto nValid = (m_nSyncSamples < SYNC_FILTER_SIZE) ? m_nSyncSamples : SYNC_FILTER_SIZE;
+	const auto nPhi = m_bSynchronised ? PHI_NANOS_PER_SECOND : PHI_ACQUIRE_NANOS_PER_SECOND;
+	int32_t nSelected = -1;
+	int64_t nDistanceMin = INT64_MAX;
+
+	for (uint32_t i = 0; i < nValid; i++) {
+		const auto nAgeMicros = nMicros - m_SyncFilter[i].nMicros;
+		const auto nDistance = m_SyncFilter[i].nOffsetNanos + ((static_cast<int64_t>(nAgeMicros) * nPhi) / 1000000);
+
+		if (nDistance < nDistanceMin) {
+			nDistanceMin = nDistance;
+			nSelected = static_cast<int32_t>(i);
+		}
+	}
+
+	return nSelected;
+}
+
+Action PtpClock::Sync(const int64_t nMasterNanos, const uint32_t nMicros) {
+	if (!m_bValid) {
+		m_nBaseNanos = nMasterNanos + m_nDelayNanos;
+		m_nBaseMicros = nMicros;
+		m_nMicrosLastUsed = nMicros;
+		m_nMicrosLastUpdate = nMicros;
+		m_nOffsetNanos = 0;
+		m_bValid = true;
+		m_nSteps++;
+		return Action::STEP;
+	}
+
+	const auto nOffset = GetNanos(nMicros) - (nMasterNanos + m_nDelayNanos);
+
+	if ((nOffset > STEP_THRESHOLD_NANOS) || (nOffset < -STEP_THRESHOLD_NANOS)) {
+		// A single late sample is not a step, all the samples in the filter must agree
+		m_SyncFilter[m_nSyncIndex].nOffsetNanos = nOffset;
+		m_SyncFilter[m_nSyncIndex].nMicros = nMicros;
+		m_nSyncIndex = (m_nSyncIndex + 1) & (SYNC_FILTER_SIZE - 1);
+		m_nSyncSamples++;
+
+		const auto nSelected = Select(nMicros);
+		const auto nSelectedOffset = m_SyncFilter[nSelected].nOffsetNanos;
+
+		if ((m_nSyncSamples < SYNC_FILTER_SIZE) || ((nSelectedOffset <= STEP_THRESHOLD_NANOS) && (nSelectedOffset >= -STEP_THRESHOLD_NANOS))) {
+			return Action::NONE;
+		}
+
+		DEBUG_PRINTF("Step %d us", static_cast<int>(nSelectedOffset / 1000));
+
+		m_nBaseNanos = nMasterNanos + m_nDelayNanos;
+		m_nBaseMicros = nMicros;
+		m_nMicrosLastUsed = nMicros;
+		m_nMicrosLastUpdate = nMicros;
+		m_nOffsetNanos = 0;
+		m_nSyncIndex = 0;
+		m_nSyncSamples = 0;
+		m_nLocked = 0;
+		m_bSynchronised = false;
+		m_nSteps++;
+		return Action::STEP;
+	}
+
+	m_SyncFilter[m_nSyncIndex].nOffsetNanos = nOffset;
+	m_SyncFilter[m_nSyncIndex].nMicros = nMicros;
+	m_nSyncIndex = (m_nSyncIndex + 1) & (SYNC_FILTER_SIZE - 1);
+	m_nSyncSamples++;
+
+	// The popcorn rule: only a sample newer than the one used last
+	const auto nSelected = Select(nMicros);
+
+	if (static_cast<int32_t>(m_SyncFilter[nSelected].nMicros - m_nMicrosLastUsed) <= 0) {
+		return Action::NONE;
+	}
+
+	const auto nSelectedOffset = m_SyncFilter[nSelected].nOffsetNanos;
+	const auto nSelectedMicros = m_SyncFilter[nSelected].nMicros;
+	auto nElapsedMicros = static_cast<int64_t>(nSelectedMicros - m_nMicrosLastUpdate);
+
+	if (nElapsedMicros < 1000) {
+		nElapsedMicros = 1000;
+	}
+
+	m_nMicrosLastUsed = nSelectedMicros;
+	m_nMicrosLastUpdate = nSelectedMicros;
+	m_nOffsetNanos = nSelectedOffset;
+
+	// PI: the offset in ns divided by the seconds is the frequency error in ppb
+	auto nFrequency = static_cast<int64_t>(m_nFrequencyPpb) - ((nSelectedOffset * 1000000) / nElapsedMicros) / (1 << FREQUENCY_SHIFT);
+
+	if (nFrequency > FREQUENCY_MAX_PPB) {
+		nFrequency = FREQUENCY_MAX_PPB;
+	} else if (nFrequency < -FREQUENCY_MAX_PPB) {
+		nFrequency = -FREQUENCY_MAX_PPB;
+	}
+
+	const auto nPhase = nSelectedOffset / (1 << PHASE_SHIFT);
+
+	Rebase(nMicros);
+	m_nBaseNanos -= nPhase;
+	m_nFrequencyPpb = static_cast<int32_t>(nFrequency);
+
+	for (auto& sample : m_SyncFilter) {
+		sample.nOffsetNanos -= nPhase;
+	}
+
+	if ((nSelectedOffset < LOCKED_NANOS) && (nSelectedOffset > -LOCKED_NANOS)) {
+		if (m_nLocked < LOCKED_COUNT) {
+			m_nLocked++;
+		}
+	} else {
+		m_nLocked = 0;
+	}
+
+	if (m_nLocked == LOCKED_COUNT) {
+		m_bSynchronised = true;
+	} else if (m_nLocked == 0) {
+		m_bSynchronised = false;
+	}
+
+	return Action::UPDATE;
+}
+
+void PtpClock::Delay(const uint32_t nMicros, const int64_t nMasterNanos) {
+	if (!m_bValid) {
+		return;
+	}
+
+	/*
+	 * Master to slave: the servo holds the least offset at the mean path delay,
+	 * so it is the delay plus the least offset in the filter. Slave to master
+	 * with the local clock. Then the late time stamps of Sync do not count.
+	 */
+	auto nMasterToSlave = m_nDelayNanos;
+	const auto nSelected = Select(nMicros);
+
+	if (nSelected >= 0) {
+		nMasterToSlave += m_SyncFilter[nSelected].nOffsetNanos;
+	}
+
+	const auto nSlaveToMaster = nMasterNanos - GetNanos(nMicros);
+	const auto nDelay = (nMasterToSlave + nSlaveToMaster) / 2;
+
+	if ((nDelay < 0) || (nDelay > DELAY_MAX_NANOS)) {
+		DEBUG_PRINTF("Delay %d ns", static_cast<int>(nDelay));
+		return;
+	}
+
+	m_DelayFilter[m_nDelayIndex] = nDelay;
+	m_nDelayIndex = (m_nDelayIndex + 1) & (DELAY_FILTER_SIZE - 1);
+	m_nDelaySamples++;
+
+	const auto nValid = (m_nDelaySamples < DELAY_FILTER_SIZE) ? m_nDelaySamples : DELAY_FILTER_SIZE;
+	auto nDelayMin = m_DelayFilter[0];
+
+	for (uint32_t i = 1; i < nValid; i++) {
+		if (m_DelayFilter[i] < nDelayMin) {
+			nDelayMin = m_DelayFilter[i];
+		}
+	}
+
+	// The offsets in the filter are with the previous delay
+	const auto nDifference = nDelayMin - m_nDelayNanos;
+
+	for (auto& sample : m_SyncFilter) {
+		sample.nOffsetNanos -= nDifference;
+	}
+
+	m_nDelayNanos = nDelayMin;
+}
@@ -25,10 +25,15 @@
 
 /*
  * https://tools.ietf.org/html/rfc1350
+ * https://tools.ietf.org/html/rfc2347 Option Extension
+ * https://tools.ietf.org/html/rfc2348 Blocksize Option
+ * https://tools.ietf.org/html/rfc2349 Timeout Interval and Transfer Size Options
+ * https://tools.ietf.org/html/rfc7440 Windowsize Option
  */
 
 #include <cstdint>
 #include <cstring>
+#include <cstdio>
 #include <cassert>
 
 #include "tftpdaemon.h"
@@ -42,7 +47,8 @@ enum TOpCode {
 	OP_CODE_WRQ = 2,			///< Write request (WRQ)
 	OP_CODE_DATA = 3,			///< Data (DATA)
 	OP_CODE_ACK = 4,			///< Acknowledgment (ACK)
-	OP_CODE_ERROR = 5			///< Error (ERROR)
+	OP_CODE_ERROR = 5,			///< Error (ERROR)
+	OP_CODE_OACK = 6			///< Option Acknowledgment (OACK)
 };
 
 enum TErrorCode {
@@ -53,7 +59,8 @@ enum TErrorCode {
 	ERROR_CODE_ILL_OPER = 4,	///< Illegal TFTP operation.
 	ERROR_CODE_INV_ID = 5,		///< Unknown transfer ID.
 	ERROR_CODE_EXISTS = 6,		///< File already exists.
-	ERROR_CODE_INV_USER = 7		///< No such user.
+	ERROR_CODE_INV_USER = 7,	///< No such user.
+	ERROR_CODE_OPTION = 8		///< Option negotiation failed.
 };
 
 namespace tftp {
@@ -67,8 +74,19 @@ namespace max {
 	static constexpr auto FILENAME_LEN = 128;
 	static constexpr auto MODE_LEN = 16;
 	static constexpr auto FILENAME_MODE_LEN = (FILENAME_LEN + 1 + MODE_LEN + 1);
-	static constexpr auto DATA_LEN = 512;
+#if defined (BARE_METAL)
+	static constexpr uint16_t DATA_LEN = 1468;	///< UDP payload 1472 - TFTP header 4
+#else
+	static constexpr uint16_t DATA_LEN = 1396;	///< Network::RecvFrom buffer 1400 - TFTP header 4
+#endif
 	static constexpr auto ERRMSG_LEN = 128;
+	static constexpr auto OACK_LEN = 64;
+}
+
+namespace option {
+	static constexpr uint32_t BLKSIZE = (1U << 0);
+	static constexpr uint32_t TSIZE = (1U << 1);
+	static constexpr uint32_t WINDOWSIZE = (1U << 2);
 }
 
 #if  !defined (PACKED)
@@ -96,6 +114,54 @@ struct DataPacket {
 	uint16_t BlockNumber;
 	uint8_t Data[max::DATA_LEN];
 } PACKED;
+
+struct OackPacket {
+	uint16_t OpCode;
+	char Options[max::OACK_LEN];
+} PACKED;
+
+static constexpr uint32_t HEADER_LEN = 4;	///< OpCode + BlockNumber
+
+/**
+ * RFC 2347: the option names are case-insensitive.
+ */
+static bool is_option(const char *pOption, const char *pName) {
+	while (*pName != '\0') {
+		auto c = *pOption++;
+
+		if ((c >= 'A') && (c <= 'Z')) {
+			c = static_cast<char>(c + ('a' - 'A'));
+		}
+
+		if (c != *pName++) {
+			return false;
+		}
+	}
+
+	return (*pOption == '\0');
+}
+
+static bool get_value(const char *pValue, uint32_t& nValue) {
+	if (*pValue == '\0') {
+		return false;
+	}
+
+	nValue = 0;
+
+	while (*pValue != '\0') {
+		if ((*pValue < '0') || (*pValue > '9')) {
+			return false;
+		}
+
+		if (nValue > ((UINT32_MAX - 9U) / 10U)) {
+			return false;
+		}
+
+		nValue = (nValue * 10U) + static_cast<uint32_t>(*pValue++ - '0');
+	}
+
+	return true;
+}
 }  // namespace tftp
 
 TFTPDaemon *TFTPDaemon::s_pThis;
@@ -139,6 +205,12 @@ void TFTPDaemon::Run() {
 		m_nBlockNumber = 0;
 		m_nState = TFTPState::WAITING_RQ;
 		m_bIsLastBlock = false;
+		m_bIsOutOfOrder = false;
+		m_nBlockSize = tftp::blksize::DEFAULT;
+		m_nWindowSize = tftp::windowsize::DEFAULT;
+		m_nWindowCount = 0;
+		m_nOptions = 0;
+		m_nTransferSize = 0;
 	} else {
 		m_nLength = Network::Get()->RecvFrom(m_nIdx, const_cast<const void **>(reinterpret_cast<void **>(&m_pBuffer)), &m_nFromIp, &m_nFromPort);
 
@@ -152,14 +224,26 @@ void TFTPDaemon::Run() {
 			DoRead();
 			break;
 		case TFTPState::RRQ_RECV_ACK:
-			if (m_nLength == sizeof(struct tftp::AckPacket)) {
+			if (m_nLength >= sizeof(struct tftp::AckPacket)) {
 				HandleRecvAck();
 			}
 			break;
-		case TFTPState::WRQ_RECV_PACKET:
-			if (m_nLength <= sizeof(struct tftp::DataPacket)) {
-				HandleRecvData();
+		case TFTPState::WRQ_RECV_PACKET: {
+			// The blocks of a window are sent back-to-back, handle the ones already received
+			auto nWindowCount = m_nWindowSize;
+
+			while (m_nLength != 0) {
+				if ((m_nLength >= tftp::HEADER_LEN) && (m_nLength <= (tftp::HEADER_LEN + m_nBlockSize))) {
+					HandleRecvData();
+				}
+
+				if ((--nWindowCount == 0) || (m_nState != TFTPState::WRQ_RECV_PACKET)) {
+					break;
+				}
+
+				m_nLength = Network::Get()->RecvFrom(m_nIdx, const_cast<const void **>(reinterpret_cast<void **>(&m_pBuffer)), &m_nFromIp, &m_nFromPort);
 			}
+		}
 			break;
 		default:
 			assert(0);
@@ -202,6 +286,13 @@ void TFTPDaemon::HandleRequest() {
 
 	DEBUG_PRINTF("Incoming %s request from " IPSTR " %s %s", nOpCode == OP_CODE_RRQ ? "read" : "write", IP2STR(m_nFromIp), pFileName, pMode);
 
+	const auto *const pOptions = pMode + strlen(pMode) + 1;
+	const auto nOffset = static_cast<uint32_t>(pOptions - reinterpret_cast<const char *>(m_pBuffer));
+
+	if (nOffset < m_nLength) {
+		ParseOptions(pOptions, static_cast<uint32_t>(m_nLength - nOffset), nOpCode);
+	}
+
 	switch (nOpCode) {
 		case OP_CODE_RRQ:
 			if(!FileOpen(pFileName, mode)) {
@@ -210,8 +301,23 @@ void TFTPDaemon::HandleRequest() {
 			} else {
 				Network::Get()->End(tftp::UDP_PORT);
 				m_nIdx = Network::Get()->Begin(m_nFromPort);
-				m_nState = TFTPState::RRQ_SEND_PACKET;
-				DoRead();
+
+				if (m_nOptions & tftp::option::TSIZE) {
+					m_nTransferSize = FileSize();
+
+					if (m_nTransferSize == 0) {
+						m_nOptions &= ~tftp::option::TSIZE;
+					}
+				}
+
+				if (m_nOptions != 0) {
+					// The client acknowledges the OACK with block number 0
+					SendOptionAck();
+					m_nState = TFTPState::RRQ_RECV_ACK;
+				} else {
+					m_nState = TFTPState::RRQ_SEND_PACKET;
+					DoRead();
+				}
 			}
 			break;
 		case OP_CODE_WRQ:
@@ -221,8 +327,15 @@ void TFTPDaemon::HandleRequest() {
 			} else {
 				Network::Get()->End(tftp::UDP_PORT);
 				m_nIdx = Network::Get()->Begin(m_nFromPort);
-				m_nState = TFTPState::WRQ_SEND_ACK;
-				DoWriteAck();
+
+				if (m_nOptions != 0) {
+					// The OACK replaces the ACK for block number 0
+					SendOptionAck();
+					m_nState = TFTPState::WRQ_RECV_PACKET;
+				} else {
+					m_nState = TFTPState::WRQ_SEND_ACK;
+					DoWriteAck();
+				}
 			}
 			break;
 		default:
@@ -232,6 +345,88 @@ void TFTPDaemon::HandleRequest() {
 	}
 }
 
+/**
+ * Options which are not recognized, or have an invalid value, are ignored (RFC 2347).
+ * The window size is only negotiated for write requests; read requests are lock-step.
+ */
+void TFTPDaemon::ParseOptions(const char *pOptions, const uint32_t nLength, const uint16_t nOpCode) {
+	const auto *const pEnd = pOptions + nLength;
+
+	while (pOptions < pEnd) {
+		const auto *const pName = pOptions;
+		const auto nNameLength = strnlen(pName, static_cast<size_t>(pEnd - pName));
+
+		if ((nNameLength == 0) || ((pName + nNameLength) >= pEnd)) {
+			return;
+		}
+
+		const auto *const pValue = pName + nNameLength + 1;
+		const auto nValueLength = strnlen(pValue, static_cast<size_t>(pEnd - pValue));
+
+		if ((pValue + nValueLength) >= pEnd) {
+			return;
+		}
+
+		pOptions = pValue + nValueLength + 1;
+
+		uint32_t nValue;
+
+		if (!tftp::get_value(pValue, nValue)) {
+			continue;
+		}
+
+		DEBUG_PRINTF("%s=%u", pName, nValue);
+
+		if (tftp::is_option(pName, "blksize")) {
+			if (nValue >= tftp::blksize::MIN) {
+				m_nBlockSize = static_cast<uint16_t>(nValue < tftp::max::DATA_LEN ? nValue : tftp::max::DATA_LEN);
+				m_nOptions |= tftp::option::BLKSIZE;
+			}
+		} else if (tftp::is_option(pName, "tsize")) {
+			if ((nOpCode == OP_CODE_WRQ) || (nValue == 0)) {
+				m_nTransferSize = nValue;
+				m_nOptions |= tftp::option::TSIZE;
+			}
+		} else if (tftp::is_option(pName, "windowsize")) {
+			if ((nOpCode == OP_CODE_WRQ) && (nValue != 0)) {
+				m_nWindowSize = static_cast<uint16_t>(nValue < tftp::windowsize::MAX ? nValue : tftp::windowsize::MAX);
+				m_nOptions |= tftp::option::WINDOWSIZE;
+			}
+		}
+	}
+}
+
+void TFTPDaemon::SendOptionAck() {
+	auto *const pOackPacket = reinterpret_cast<struct tftp::OackPacket *>(m_pBuffer);
+	assert(pOackPacket != nullptr);
+
+	pOackPacket->OpCode = __builtin_bswap16(OP_CODE_OACK);
+
+	auto *p = pOackPacket->Options;
+	const auto *const pEnd = pOackPacket->Options + sizeof(pOackPacket->Options);
+
+	if (m_nOptions & tftp::option::BLKSIZE) {
+		p += 1 + snprintf(p, static_cast<size_t>(pEnd - p), "blksize%c%u", '\0', static_cast<unsigned>(m_nBlockSize));
+	}
+
+	if (m_nOptions & tftp::option::TSIZE) {
+		p += 1 + snprintf(p, static_cast<size_t>(pEnd - p), "tsize%c%u", '\0', static_cast<unsigned>(m_nTransferSize));
+	}
+
+	if (m_nOptions & tftp::option::WINDOWSIZE) {
+		p += 1 + snprintf(p, static_cast<size_t>(pEnd - p), "windowsize%c%u", '\0', static_cast<unsigned>(m_nWindowSize));
+	}
+
+	assert(p <= pEnd);
+
+	m_nBlockNumber = 0;
+	m_nPacketLength = static_cast<uint16_t>(sizeof pOackPacket->OpCode + static_cast<uint32_t>(p - pOackPacket->Options));
+
+	DEBUG_PRINTF("Sending OACK to " IPSTR ":%d, m_nBlockSize=%u, m_nWindowSize=%u, m_nTransferSize=%u", IP2STR(m_nFromIp), m_nFromPort, m_nBlockSize, m_nWindowSize, m_nTransferSize);
+
+	Network::Get()->SendTo(m_nIdx, m_pBuffer, m_nPacketLength, m_nFromIp, m_nFromPort);
+}
+
 void TFTPDaemon::SendError (const uint16_t nErrorCode, const char *pErrorMessage) {
 	tftp::ErrorPacket ErrorPacket;
 
@@ -247,13 +442,13 @@ void TFTPDaemon::DoRead() {
 	assert(pDataPacket != nullptr);
 
 	if (m_nState == TFTPState::RRQ_SEND_PACKET) {
-		m_nDataLength = FileRead(pDataPacket->Data, tftp::max::DATA_LEN, ++m_nBlockNumber);
+		m_nDataLength = FileRead(pDataPacket->Data, m_nBlockSize, ++m_nBlockNumber);
 
 		pDataPacket->OpCode = __builtin_bswap16(OP_CODE_DATA);
 		pDataPacket->BlockNumber = __builtin_bswap16(m_nBlockNumber);
 
 		m_nPacketLength = static_cast<uint16_t>(sizeof pDataPacket->OpCode + sizeof pDataPacket->BlockNumber + m_nDataLength);
-		m_bIsLastBlock = m_nDataLength < tftp::max::DATA_LEN;
+		m_bIsLastBlock = m_nDataLength < m_nBlockSize;
 
 		if (m_bIsLastBlock) {
 			FileClose();
@@ -278,8 +473,19 @@ void TFTPDaemon::HandleRecvAck() {
 		DEBUG_PRINTF("Incoming from " IPSTR ", BlockNumber=%d, m_nBlockNumber=%d", IP2STR(m_nFromIp), __builtin_bswap16(pAckPacket->BlockNumber), m_nBlockNumber	);
 
 		if (pAckPacket->BlockNumber == __builtin_bswap16(m_nBlockNumber)) {
-			m_nState = m_bIsLastBlock ? TFTPState::INIT : TFTPState::RRQ_SEND_PACKET;
+			if (m_bIsLastBlock) {
+				m_nState = TFTPState::INIT;
+			} else {
+				// Do not wait for the next Run, send the next block right away
+				m_nState = TFTPState::RRQ_SEND_PACKET;
+				DoRead();
+			}
 		}
+	} else if (pAckPacket->OpCode == __builtin_bswap16(OP_CODE_ERROR)) {
+		// For example, the client did not accept the OACK
+		DEBUG_PRINTF("Error from " IPSTR ", ErrorCode=%d", IP2STR(m_nFromIp), __builtin_bswap16(pAckPacket->BlockNumber));
+		FileClose();
+		m_nState = TFTPState::INIT;
 	}
 }
 
@@ -300,23 +506,45 @@ void TFTPDaemon::HandleRecvData() {
 	const auto *const pDataPacket = reinterpret_cast<struct tftp::DataPacket *>(m_pBuffer);
 	assert(pDataPacket != nullptr);
 
-	if (pDataPacket->OpCode == __builtin_bswap16(OP_CODE_DATA)) {
-		m_nDataLength = m_nLength - 4;
-		m_nBlockNumber = __builtin_bswap16(pDataPacket->BlockNumber);
+	if (pDataPacket->OpCode != __builtin_bswap16(OP_CODE_DATA)) {
+		return;
+	}
 
-		DEBUG_PRINTF("Incoming from " IPSTR ", m_nLength=%u, m_nBlockNumber=%d, m_nDataLength=%u", IP2STR(m_nFromIp), static_cast<uint32_t>(m_nLength), m_nBlockNumber, static_cast<uint32_t>(m_nDataLength));
+	const auto nBlockNumber = __builtin_bswap16(pDataPacket->BlockNumber);
 
-		if (m_nDataLength == FileWrite(pDataPacket->Data, m_nDataLength, m_nBlockNumber)) {
+	DEBUG_PRINTF("Incoming from " IPSTR ", m_nLength=%u, nBlockNumber=%d, m_nBlockNumber=%d", IP2STR(m_nFromIp), static_cast<uint32_t>(m_nLength), nBlockNumber, m_nBlockNumber);
 
-			if (m_nDataLength < tftp::max::DATA_LEN) {
-				m_bIsLastBlock = true;
-				FileClose();
-			}
+	/*
+	 * Only the next block in sequence is written, the block number wraps around to 0.
+	 * A duplicate or out of order block is answered with an ACK for the last block received in order,
+	 * once per window, so that the client restarts the window from there (RFC 7440).
+	 */
+	if (nBlockNumber != static_cast<uint16_t>(m_nBlockNumber + 1)) {
+		if (!m_bIsOutOfOrder) {
+			m_bIsOutOfOrder = true;
+			m_nWindowCount = 0;
+			DoWriteAck();
+		}
+		return;
+	}
+
+	m_bIsOutOfOrder = false;
+	m_nDataLength = m_nLength - tftp::HEADER_LEN;
 
+	if (m_nDataLength == FileWrite(pDataPacket->Data, m_nDataLength, nBlockNumber)) {
+		m_nBlockNumber = nBlockNumber;
+
+		if (m_nDataLength < m_nBlockSize) {
+			m_bIsLastBlock = true;
+			FileClose();
+		}
+
+		if (m_bIsLastBlock || (++m_nWindowCount == m_nWindowSize)) {
+			m_nWindowCount = 0;
 			DoWriteAck();
-		} else {
-			SendError(ERROR_CODE_DISK_FULL, "Write failed");
-			m_nState = TFTPState::INIT;
 		}
+	} else {
+		SendError(ERROR_CODE_DISK_FULL, "Write failed");
+		m_nState = TFTPState::INIT;
 	}
 }
@@ -47,3 +47,25 @@ void emac_free_pkt(void) {
 void emac_eth_send(void *packet, int len) {
 	enet_frame_transmit((uint8_t *) packet, len);
 }
+
+/*
+ * enet_frame_transmit resumes the DMA for each frame, there is nothing to batch.
+ */
+
+void emac_eth_send_queued(void *packet, int len) {
+	emac_eth_send(packet, len);
+}
+
+void emac_eth_send_flush(void) {
+}
+
+/*
+ * Multicast hash filter, the bins are computed by igmp
+ */
+
+void emac_multicast_hash_set(uint32_t hash_low, uint32_t hash_high) {
+	ENET_MAC_HLH = hash_high;
+	ENET_MAC_HLL = hash_low;
+	enet_filter_feature_disable(ENET_MULTICAST_FILTER_PASS);
+	enet_filter_feature_enable(ENET_MULTICAST_FILTER_HASH_MODE);
+}
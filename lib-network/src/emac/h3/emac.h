@@ -41,6 +41,7 @@
 #define RX_CTL0_RX_EN				(1U << 31)
 #define RX_CTL1_RX_DMA_EN			(1 << 30)
 
+#define RX_FRM_FLT_HASH_MULTICAST	(1 << 9)
 #define RX_FRM_FLT_RX_ALL_MULTICAST	(1 << 16)
 
 #define PHY_ADDR		1
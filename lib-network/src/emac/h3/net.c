@@ -63,8 +63,11 @@ __attribute__((hot)) int emac_eth_recv(uint8_t **packetp) {
 	return -1;
 }
 
-void emac_eth_send(void *packet, int len) {
-	uint32_t value;
+#define TX_DESCR_TIMEOUT_MICROS	1000U	///< A full size frame is sent in 123 us at 100 Mbit/s
+
+static uint32_t s_nTxQueued;
+
+static void tx_descriptor_fill(void *packet, int len) {
 	uint32_t desc_num = p_coherent_region->tx_currdescnum;
 	struct emac_dma_desc *desc_p = &p_coherent_region->tx_chain[desc_num];
 	uintptr_t data_start = (uintptr_t) desc_p->buf_addr;
@@ -91,14 +94,56 @@ void emac_eth_send(void *packet, int len) {
 	}
 
 	p_coherent_region->tx_currdescnum = desc_num;
+}
 
-	/* Start the DMA */
-	value = H3_EMAC->TX_CTL1;
+static void tx_dma_start(void) {
+	uint32_t value = H3_EMAC->TX_CTL1;
 	value |= (1U << 31);/* mandatory */
 	value |= (1 << 30);/* mandatory */
 	H3_EMAC->TX_CTL1 = value;
 }
 
+void emac_eth_send(void *packet, int len) {
+	tx_descriptor_fill(packet, len);
+	/* Start the DMA */
+	tx_dma_start();
+}
+
+/*
+ * Burst transmit: descriptors are filled back-to-back and the DMA is
+ * (re)started once per half ring, and once more by emac_eth_send_flush.
+ */
+
+void emac_eth_send_queued(void *packet, int len) {
+	volatile struct emac_dma_desc *desc_p = &p_coherent_region->tx_chain[p_coherent_region->tx_currdescnum];
+
+	/* The ring is full, wait for the DMA to release the descriptor.
+	 * When the DMA is stuck, the descriptor is taken as emac_eth_send does. */
+	if (desc_p->status & (1U << 31)) {
+		tx_dma_start();
+		s_nTxQueued = 0;
+
+		const uint32_t nMicros = H3_TIMER->AVS_CNT1;
+
+		while ((desc_p->status & (1U << 31)) && ((H3_TIMER->AVS_CNT1 - nMicros) < TX_DESCR_TIMEOUT_MICROS)) {
+		}
+	}
+
+	tx_descriptor_fill(packet, len);
+
+	if (++s_nTxQueued == (CONFIG_TX_DESCR_NUM / 2)) {
+		tx_dma_start();
+		s_nTxQueued = 0;
+	}
+}
+
+void emac_eth_send_flush(void) {
+	if (s_nTxQueued != 0) {
+		tx_dma_start();
+		s_nTxQueued = 0;
+	}
+}
+
 void emac_free_pkt(void) {
 	uint32_t desc_num = p_coherent_region->rx_currdescnum;
 	struct emac_dma_desc *desc_p = &p_coherent_region->rx_chain[desc_num];
@@ -113,3 +158,13 @@ void emac_free_pkt(void) {
 
 	p_coherent_region->rx_currdescnum = desc_num;
 }
+
+/*
+ * Multicast hash filter, the bins are computed by igmp
+ */
+
+void emac_multicast_hash_set(uint32_t hash_low, uint32_t hash_high) {
+	H3_EMAC->RX_HASH0 = hash_high;
+	H3_EMAC->RX_HASH1 = hash_low;
+	H3_EMAC->RX_FRM_FLT = (H3_EMAC->RX_FRM_FLT & ~RX_FRM_FLT_RX_ALL_MULTICAST) | RX_FRM_FLT_HASH_MULTICAST;
+}
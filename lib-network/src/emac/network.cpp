@@ -25,7 +25,6 @@
 
 #include <cstdint>
 #include <cstring>
-#include <time.h>
 #include <cassert>
 
 #include "network.h"
@@ -83,6 +82,7 @@ Network::Network() {
 	m_IpInfo.netmask.addr = params.GetNetMask();
 	m_IpInfo.gw.addr = params.GetDefaultGateway();
 	m_IsDhcpUsed = params.isDhcpUsed();
+	m_nDhcpRetryTime = params.GetDhcpRetryTime();
 	m_nNtpServerIp = params.GetNtpServer();
 	m_fNtpUtcOffset = params.GetNtpUtcOffset();
 
@@ -133,41 +133,31 @@ Network::Network() {
 			}
 		}
 
+		struct DhcpLease lease;
+		lease.nIp = 0;
+
 		if (m_IsDhcpUsed) {
 			network::display_dhcp_status(network::dhcp::ClientStatus::RENEW);
+			NetworkStore::CopyDhcpLease(&lease);
 		}
 
-		net_init(m_aNetMacaddr, &m_IpInfo, m_aHostName, &m_IsDhcpUsed, &m_IsZeroconfUsed);
-
-		if (m_IsZeroconfUsed) {
-			network::display_dhcp_status(network::dhcp::ClientStatus::FAILED);
-		}
-
-		const auto nRetryTime = params.GetDhcpRetryTime();
-		const auto bUseDhcp = params.isDhcpUsed();
+		net_init(m_aNetMacaddr, &m_IpInfo, m_aHostName, m_IsDhcpUsed, &lease, m_nDhcpRetryTime * 60U);
 
-		while (m_IsZeroconfUsed && (nRetryTime != 0) && bUseDhcp) {
-			Hardware::Get()->SetMode(hardware::ledblink::Mode::FAST);
-
-			network::display_dhcp_status(network::dhcp::ClientStatus::RETRYING);
+		/*
+		 * The INIT-REBOOT takes a few 100 ms. A DHCP server which is stormed
+		 * does not hold the startup, the lease is acquired in the background.
+		 */
+		if (m_IsDhcpUsed) {
+			const auto nMillis = Hardware::Get()->Millis();
 
-			DEBUG_PUTS("");
-			auto nTime = time(nullptr);
-			while ((time(nullptr) - nTime) < (nRetryTime * 60)) {
+			while ((m_IpInfo.ip.addr == 0) && !m_IsZeroconfUsed && ((Hardware::Get()->Millis() - nMillis) < net::dhcp::BOOT_WAIT_MILLIS)) {
+				net_handle();
 				Hardware::Get()->Run();
 			}
 
-			network::display_dhcp_status(network::dhcp::ClientStatus::RENEW);
-
-			Hardware::Get()->SetMode(hardware::ledblink::Mode::OFF_ON);
-
-			m_IsDhcpUsed = true;
-			m_IsZeroconfUsed = false;
-
-			net_init(m_aNetMacaddr, &m_IpInfo, m_aHostName, &m_IsDhcpUsed, &m_IsZeroconfUsed);
-
-			if (m_IsDhcpUsed) {
-				break;
+			// The display_ip below shows "DHCP pending"
+			if (m_IpInfo.ip.addr == 0) {
+				network::display_dhcp_status(network::dhcp::ClientStatus::RETRYING);
 			}
 		}
 	} else {
@@ -180,9 +170,7 @@ Network::Network() {
 			m_IpInfo.gw.addr = 0;
 		}
 
-		auto bFalse = false;
-
-		net_init(m_aNetMacaddr, &m_IpInfo, m_aHostName, &bFalse, &bFalse);
+		net_init(m_aNetMacaddr, &m_IpInfo, m_aHostName, false, nullptr, 0);
 	}
 
 	network::display_ip();
@@ -195,10 +183,9 @@ Network::Network() {
 void Network::SetIp(uint32_t nIp) {
 	DEBUG_ENTRY
 
-	if (m_IsDhcpUsed) {
-		m_IsDhcpUsed = false;
-		net_dhcp_release();
-	}
+	// Also a DHCP client which retries in the background
+	m_IsDhcpUsed = false;
+	net_dhcp_release();
 
 	m_IsZeroconfUsed = false;
 
@@ -283,6 +270,8 @@ bool Network::SetZeroconf() {
 		Hardware::Get()->WatchdogStop();
 	}
 
+	net_dhcp_release();
+
 	m_IsZeroconfUsed = net_set_zeroconf(&m_IpInfo);
 
 	if (m_IsZeroconfUsed) {
@@ -303,42 +292,83 @@ bool Network::SetZeroconf() {
 	return m_IsZeroconfUsed;
 }
 
+/**
+ * The lease is acquired in the background, see HandleDhcpEvent
+ */
 bool Network::EnableDhcp() {
 	DEBUG_ENTRY
 
-	const auto bWatchdog = Hardware::Get()->IsWatchdog();
-
-	if (bWatchdog) {
-		Hardware::Get()->WatchdogStop();
-	}
-
 	network::display_dhcp_status(network::dhcp::ClientStatus::RENEW);
 
-	m_IsDhcpUsed = net_set_dhcp(&m_IpInfo, m_aHostName, &m_IsZeroconfUsed);
+	struct DhcpLease lease;
+	NetworkStore::CopyDhcpLease(&lease);
 
-	if (m_IsZeroconfUsed) {
-		network::display_dhcp_status(network::dhcp::ClientStatus::FAILED);
-	} else {
-		network::display_dhcp_status(network::dhcp::ClientStatus::GOT_IP);
-	}
+	m_IsDhcpUsed = true;
+	m_IsZeroconfUsed = false;
 
-	DEBUG_PRINTF("m_IsDhcpUsed=%d, m_IsZeroconfUsed=%d", m_IsDhcpUsed, m_IsZeroconfUsed);
+	net_set_dhcp(&m_IpInfo, m_aHostName, &lease, m_nDhcpRetryTime * 60U);
 
 	NetworkStore::SaveDhcp(m_IsDhcpUsed);
 
-	network::mdns_announcement();
 	network::display_ip();
 	network::display_netmask();
 	network::display_gateway();
 
-	if (bWatchdog) {
-		Hardware::Get()->WatchdogInit();
+	DEBUG_EXIT
+	return m_IsDhcpUsed;
+}
+
+void Network::HandleDhcpEvent(const net::dhcp::Event event, const struct DhcpLease *pLease) {
+	DEBUG_ENTRY
+	DEBUG_PRINTF("event=%u, " IPSTR, static_cast<uint32_t>(event), IP2STR(m_IpInfo.ip.addr));
+
+	switch (event) {
+	case net::dhcp::Event::BOUND:
+		m_IsDhcpUsed = true;
+		m_IsZeroconfUsed = false;
+		NetworkStore::SaveDhcpLease(pLease);
+		network::display_dhcp_status(network::dhcp::ClientStatus::GOT_IP);
+		network::mdns_announcement();
+		network::display_ip();
+		network::display_netmask();
+		network::display_gateway();
+		break;
+	case net::dhcp::Event::RENEWED:
+		NetworkStore::SaveDhcpLease(pLease);
+		break;
+	case net::dhcp::Event::LOST: {
+		// No INIT-REBOOT with this lease at the next boot
+		struct DhcpLease lease;
+		memset(&lease, 0, sizeof(struct DhcpLease));
+		NetworkStore::SaveDhcpLease(&lease);
+		network::display_dhcp_status(network::dhcp::ClientStatus::RENEW);
+		network::display_ip();
+		break;
+	}
+	case net::dhcp::Event::FAILED:
+		// The DHCP client keeps retrying when dhcp_retry_time is set
+		network::display_dhcp_status(network::dhcp::ClientStatus::FAILED);
+		m_IsZeroconfUsed = net_set_zeroconf(&m_IpInfo);
+		m_IsDhcpUsed = false;
+		network::mdns_announcement();
+		network::display_ip();
+		network::display_netmask();
+		break;
+	default:
+		break;
 	}
 
 	DEBUG_EXIT
-	return m_IsDhcpUsed;
 }
 
+namespace net {
+namespace dhcp {
+void handle_event(const Event event, const struct DhcpLease *pLease) {
+	Network::Get()->HandleDhcpEvent(event, pLease);
+}
+}  // namespace dhcp
+}  // namespace net
+
 void Network::SetQueuedStaticIp(uint32_t nLocalIp, uint32_t nNetmask) {
 	DEBUG_ENTRY
 	DEBUG_PRINTF(IPSTR ", nNetmask=" IPSTR, IP2STR(nLocalIp), IP2STR(nNetmask));
@@ -398,7 +428,11 @@ void Network::Print() {
 	printf("Network [%c]\n", GetAddressingMode());
 	printf(" Hostname  : %s\n", m_aHostName);
 	printf(" IfName    : %d: %s " MACSTR "\n", m_nIfIndex, m_aIfName, MAC2STR(m_aNetMacaddr));
-	printf(" Primary   : " IPSTR "/%d (HTTP only " IPSTR ")\n", IP2STR(m_IpInfo.ip.addr), GetNetmaskCIDR(), IP2STR(m_IpInfo.secondary_ip.addr));
+	if (m_IsDhcpUsed && (m_IpInfo.ip.addr == 0)) {
+		printf(" Primary   : DHCP pending (HTTP only " IPSTR ")\n", IP2STR(m_IpInfo.secondary_ip.addr));
+	} else {
+		printf(" Primary   : " IPSTR "/%d (HTTP only " IPSTR ")\n", IP2STR(m_IpInfo.ip.addr), GetNetmaskCIDR(), IP2STR(m_IpInfo.secondary_ip.addr));
+	}
 	printf(" Gateway   : " IPSTR "\n", IP2STR(m_IpInfo.gw.addr));
 	printf(" Broadcast : " IPSTR "\n", IP2STR(GetBroadcastIp()));
 }
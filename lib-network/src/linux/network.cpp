@@ -31,6 +31,8 @@
 #include <arpa/inet.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <net/if.h>
 #include <ifaddrs.h>
 #include <errno.h>
@@ -58,6 +60,22 @@ namespace max {
 static int s_ports_allowed[max::PORTS_ALLOWED];
 static int snHandles[max::PORTS_ALLOWED];
 
+namespace sendqueue {
+static constexpr uint32_t SIZE = 256;
+}
+
+struct SendQueue {
+#if defined (__linux__)
+	struct mmsghdr msg[sendqueue::SIZE];
+#endif
+	struct iovec iov[sendqueue::SIZE];
+	struct sockaddr_in addr[sendqueue::SIZE];
+	int32_t nHandle;
+	uint32_t nCount;
+};
+
+static SendQueue s_SendQueue;
+
 /**
  * END
  */
@@ -262,6 +280,9 @@ void Network::MacAddressCopyTo(uint8_t* pMacAddress) {
 int32_t Network::End(uint16_t nPort) {
 	DEBUG_ENTRY
 	DEBUG_PRINTF("nPort = %d", nPort);
+
+	SendFlush();
+
 /**
  * BEGIN - needed H3 code compatibility
  */
@@ -380,6 +401,35 @@ void Network::LeaveGroup(int32_t nHandle, uint32_t ip) {
 	}
 }
 
+void Network::JoinGroupSource(int32_t nHandle, uint32_t nIp, uint32_t nSourceIp) {
+	DEBUG_ENTRY
+	DEBUG_PRINTF("nHandle=%d, ip=%x, source=%x", nHandle, nIp, nSourceIp);
+
+	struct ip_mreq_source mreq;
+
+	mreq.imr_multiaddr.s_addr = nIp;
+	mreq.imr_sourceaddr.s_addr = nSourceIp;
+	mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+
+	if (setsockopt(nHandle, IPPROTO_IP, IP_ADD_SOURCE_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+		perror("setsockopt(IP_ADD_SOURCE_MEMBERSHIP)");
+	}
+
+	DEBUG_EXIT
+}
+
+void Network::LeaveGroupSource(int32_t nHandle, uint32_t nIp, uint32_t nSourceIp) {
+	struct ip_mreq_source mreq;
+
+	mreq.imr_multiaddr.s_addr = nIp;
+	mreq.imr_sourceaddr.s_addr = nSourceIp;
+	mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+
+	if (setsockopt(nHandle, IPPROTO_IP, IP_DROP_SOURCE_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+		perror("setsockopt(IP_DROP_SOURCE_MEMBERSHIP)");
+	}
+}
+
 uint16_t Network::RecvFrom(int32_t nHandle, void *pPacket, uint16_t nSize, uint32_t *pFromIp, uint16_t *pFromPort) {
 	assert(pPacket != nullptr);
 	assert(pFromIp != nullptr);
@@ -428,6 +478,66 @@ void Network::SendTo(int32_t nHandle, const void *pPacket, uint16_t nSize, uint3
 	}
 }
 
+void Network::SendToQueued(int32_t nHandle, const void *pPacket, uint16_t nSize, uint32_t nToIp, uint16_t nRemotePort) {
+	if ((s_SendQueue.nCount == sendqueue::SIZE) || ((s_SendQueue.nCount != 0) && (s_SendQueue.nHandle != nHandle))) {
+		SendFlush();
+	}
+
+	const auto nIndex = s_SendQueue.nCount++;
+
+	s_SendQueue.nHandle = nHandle;
+
+	auto &addr = s_SendQueue.addr[nIndex];
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = nToIp;
+	addr.sin_port = htons(nRemotePort);
+
+	auto &iov = s_SendQueue.iov[nIndex];
+	iov.iov_base = const_cast<void *>(pPacket);
+	iov.iov_len = nSize;
+
+#if defined (__linux__)
+	auto &hdr = s_SendQueue.msg[nIndex].msg_hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.msg_name = &addr;
+	hdr.msg_namelen = sizeof(addr);
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+#endif
+}
+
+void Network::SendFlush() {
+	if (s_SendQueue.nCount == 0) {
+		return;
+	}
+
+#if defined (__linux__)
+	uint32_t nSent = 0;
+
+	while (nSent < s_SendQueue.nCount) {
+		const auto nResult = sendmmsg(s_SendQueue.nHandle, &s_SendQueue.msg[nSent], s_SendQueue.nCount - nSent, 0);
+
+		if (nResult < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("sendmmsg");
+			break;
+		}
+
+		nSent += static_cast<uint32_t>(nResult);
+	}
+#else
+	for (uint32_t nIndex = 0; nIndex < s_SendQueue.nCount; nIndex++) {
+		if (sendto(s_SendQueue.nHandle, s_SendQueue.iov[nIndex].iov_base, s_SendQueue.iov[nIndex].iov_len, 0, reinterpret_cast<struct sockaddr*>(&s_SendQueue.addr[nIndex]), sizeof(struct sockaddr_in)) == -1) {
+			perror("sendto");
+		}
+	}
+#endif
+
+	s_SendQueue.nCount = 0;
+}
+
 #if defined(__linux__)
 bool Network::IsDhclient(const char* if_name) {
 	char cmd[255];
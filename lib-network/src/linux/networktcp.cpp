@@ -27,6 +27,8 @@
 #include <cstdio>
 #include <string.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -189,7 +191,7 @@ uint16_t Network::TcpRead(const int32_t nHandle, const uint8_t **ppBuffer, uint3
 	return 0;
 }
 
-void Network::TcpWrite(const int32_t nHandle, const uint8_t *pBuffer, uint16_t nLength, const uint32_t HandleConnectionIndex) {
+uint32_t Network::TcpWrite(const int32_t nHandle, const uint8_t *pBuffer, uint16_t nLength, const uint32_t HandleConnectionIndex) {
 	assert(nHandle < MAX_PORTS_ALLOWED);
 
 	DEBUG_PRINTF("Write client on fd %d [%u]", poll_set[nHandle][HandleConnectionIndex].fd, HandleConnectionIndex);
@@ -198,6 +200,53 @@ void Network::TcpWrite(const int32_t nHandle, const uint8_t *pBuffer, uint16_t n
 
 	if (c < 0) {
 		perror("write");
+		return 0;
 	}
+
+	return static_cast<uint32_t>(c);
+}
+
+uint32_t Network::TcpWriteSpace(const int32_t nHandle, const uint32_t HandleConnectionIndex) {
+	assert(nHandle < MAX_PORTS_ALLOWED);
+
+	int nSendBuffer;
+	socklen_t nOptionLength = sizeof(nSendBuffer);
+
+	if (getsockopt(poll_set[nHandle][HandleConnectionIndex].fd, SOL_SOCKET, SO_SNDBUF, &nSendBuffer, &nOptionLength) < 0) {
+		return 0;
+	}
+
+	int nQueued = 0;
+#if defined (TIOCOUTQ)
+	ioctl(poll_set[nHandle][HandleConnectionIndex].fd, TIOCOUTQ, &nQueued);
+#endif
+
+	return (nSendBuffer > nQueued) ? static_cast<uint32_t>(nSendBuffer - nQueued) : 0;
+}
+
+void Network::TcpSetNoDelay(const int32_t nHandle, const uint32_t HandleConnectionIndex, const bool isNoDelay) {
+	assert(nHandle < MAX_PORTS_ALLOWED);
+
+	int flag = isNoDelay ? 1 : 0;
+
+	if (setsockopt(poll_set[nHandle][HandleConnectionIndex].fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) < 0) {
+		perror("setsockopt(TCP_NODELAY)");
+	}
+}
+
+void Network::TcpSetCork(const int32_t nHandle, const uint32_t HandleConnectionIndex, const bool isCorked) {
+	assert(nHandle < MAX_PORTS_ALLOWED);
+
+#if defined (TCP_CORK)
+	int flag = isCorked ? 1 : 0;
+
+	if (setsockopt(poll_set[nHandle][HandleConnectionIndex].fd, IPPROTO_TCP, TCP_CORK, &flag, sizeof(flag)) < 0) {
+		perror("setsockopt(TCP_CORK)");
+	}
+#else
+	// macOS has TCP_NOPUSH, the kernel coalesces the writes anyway
+	(void)HandleConnectionIndex;
+	(void)isCorked;
+#endif
 }
 #endif
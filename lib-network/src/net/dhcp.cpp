@@ -48,7 +48,15 @@ typedef union pcast32 {
 	uint8_t u8[4];
 } _pcast32;
 
-// https://tools.ietf.org/html/rfc1541
+/*
+ * https://www.rfc-editor.org/rfc/rfc2131
+ * The client does not block: the state machine runs from net_timers_run.
+ * - INIT-REBOOT with the lease of the previous boot: REQUEST, ACK, 2 messages.
+ * - The first message after a random delay, the retransmissions with an
+ *   exponential randomized backoff. Then 200 nodes powered on together do not
+ *   send in the same 100 ms.
+ * - Renewing at T1 (unicast to the server), rebinding at T2 (broadcast).
+ */
 
 namespace dhcp {
 struct Message {
@@ -68,6 +76,15 @@ struct Message {
 	uint8_t file[128];
 	uint8_t options[DHCP_OPT_SIZE];
 }PACKED;
+
+static constexpr uint32_t INIT_DELAY_MAX_MILLIS = 1000;		///< Before the first DISCOVER
+static constexpr uint32_t REBOOT_DELAY_MAX_MILLIS = 100;		///< Before the INIT-REBOOT REQUEST
+static constexpr uint32_t RETRANSMIT_MIN_MILLIS = 1000;
+static constexpr uint32_t RETRANSMIT_MAX_MILLIS = 64000;
+static constexpr uint32_t RETRANSMIT_RENEW_MIN_MILLIS = 60000;	///< RFC 2131 4.4.5
+static constexpr uint32_t REBOOT_ATTEMPTS = 3;
+static constexpr uint32_t SELECTING_ATTEMPTS = 4;				///< Then the FAILED event
+static constexpr uint32_t LEASE_MAX_SECONDS = 0x7FFFFFFF / 1000;
 }  // namespace dhcp
 
 enum OPTIONS {
@@ -78,6 +95,7 @@ enum OPTIONS {
 	OPTIONS_HOSTNAME = 12,
 	OPTIONS_DOMAIN_NAME = 15,
 	OPTIONS_REQUESTED_IP = 50,
+	OPTIONS_LEASE_TIME = 51,
 	OPTIONS_MESSAGE_TYPE = 53,
 	OPTIONS_SERVER_IDENTIFIER = 54,
 	OPTIONS_PARAM_REQUEST = 55,
@@ -87,24 +105,69 @@ enum OPTIONS {
 	OPTIONS_END_OPTION = 255
 };
 
+struct Reply {
+	uint32_t nType;
+	uint32_t nIp;
+	uint32_t nNetmask;
+	uint32_t nGatewayIp;
+	uint32_t nServerIp;
+	uint32_t nLeaseTime;
+	uint32_t nT1;
+	uint32_t nT2;
+};
+
 static dhcp::Message s_dhcp_message ALIGNED;
 
-static uint8_t s_dhcp_server_ip[IPv4_ADDR_LEN] ALIGNED = { 0, };
-static uint8_t s_dhcp_allocated_ip[IPv4_ADDR_LEN] ALIGNED = { 0, };
-static uint8_t s_dhcp_allocated_gw[IPv4_ADDR_LEN] ALIGNED = { 0, };
-static uint8_t s_dhcp_allocated_netmask[IPv4_ADDR_LEN] ALIGNED = { 0, };
+static int s_nHandle = -1;
+static const char *s_pHostname;
+static net::dhcp::State s_State = net::dhcp::State::OFF;
+static struct DhcpLease s_Lease;		///< The lease which is bound, or requested
+static uint32_t s_nOfferedIp;
+static uint32_t s_nOfferedServerIp;
+static uint32_t s_nXid;
+static uint32_t s_nRandom;
+static uint32_t s_nAttempts;
+static uint32_t s_nRetransmitMillis;
+static uint32_t s_nTimerMillis;			///< The next action
+static uint32_t s_nRequestMillis;		///< The lease starts when the REQUEST is sent
+static uint32_t s_nLeaseStartMillis;
+static uint32_t s_nT1Millis;
+static uint32_t s_nT2Millis;
+static uint32_t s_nLeaseMillis;
+static uint32_t s_nRetrySeconds;
+static bool s_isFailed;
+static bool s_isBound;				///< The network has the address of s_Lease
+static bool s_isBusy;
+
+static uint32_t get_random() {
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return s_nRandom;
+}
 
-static void message_init(const uint8_t *pMacAddress) {
-	auto *p = reinterpret_cast<uint8_t *>(&s_dhcp_message);
+/**
+ * @return nMillis randomized with +/- 25%
+ */
+static uint32_t randomize(const uint32_t nMillis) {
+	return nMillis - (nMillis / 4) + (get_random() % ((nMillis / 2) + 1));
+}
 
-	for (uint32_t i = 0; i < sizeof(dhcp::Message); i++) {
-		*p++ = 0;
-	}
+static bool is_before(const uint32_t nMillis, const uint32_t nDeadline) {
+	return static_cast<int32_t>(nMillis - nDeadline) < 0;
+}
+
+static uint32_t s_nOptionsLength;
+
+static void message_init(const uint8_t nType, const uint32_t nClientIp) {
+	memset(&s_dhcp_message, 0, sizeof(dhcp::Message) - DHCP_OPT_SIZE);
 
 	s_dhcp_message.op = DHCP_OP_BOOTREQUEST;
 	s_dhcp_message.htype = DHCP_HTYPE_10MB;	// This is the current default
 	s_dhcp_message.hlen = ETH_ADDR_LEN;
-	memcpy(s_dhcp_message.chaddr, pMacAddress, ETH_ADDR_LEN);
+	s_dhcp_message.xid = s_nXid;
+	memcpy(s_dhcp_message.ciaddr, &nClientIp, IPv4_ADDR_LEN);
+	memcpy(s_dhcp_message.chaddr, net::globals::macAddress, ETH_ADDR_LEN);
 
 	s_dhcp_message.options[0] = static_cast<uint8_t>((MAGIC_COOKIE & 0xFF000000) >> 24);
 	s_dhcp_message.options[1] = static_cast<uint8_t>((MAGIC_COOKIE & 0x00FF0000) >> 16);
@@ -113,281 +176,498 @@ static void message_init(const uint8_t *pMacAddress) {
 
 	s_dhcp_message.options[4] = OPTIONS_MESSAGE_TYPE;
 	s_dhcp_message.options[5] = 0x01;
+	s_dhcp_message.options[6] = nType;
+
+	s_nOptionsLength = 7;
+
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_CLIENT_IDENTIFIER;
+	s_dhcp_message.options[s_nOptionsLength++] = 0x07;
+	s_dhcp_message.options[s_nOptionsLength++] = 0x01;
+
+	for (uint32_t i = 0; i < ETH_ADDR_LEN; i++) {
+		s_dhcp_message.options[s_nOptionsLength++] = net::globals::macAddress[i];
+	}
 }
 
-static void send_discover(int nHandle, const uint8_t *pMacAddress) {
-	DEBUG_ENTRY
+static void option_ip(const uint8_t nOption, const uint32_t nIp) {
+	s_dhcp_message.options[s_nOptionsLength++] = nOption;
+	s_dhcp_message.options[s_nOptionsLength++] = 0x04;
+	memcpy(&s_dhcp_message.options[s_nOptionsLength], &nIp, IPv4_ADDR_LEN);
+	s_nOptionsLength += IPv4_ADDR_LEN;
+}
 
-	uint32_t k = 6;
+static void option_hostname() {
+	const auto nLength = static_cast<uint32_t>(strlen(s_pHostname));
 
-	s_dhcp_message.options[k++] = DCHP_TYPE_DISCOVER;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_HOSTNAME;
+	s_dhcp_message.options[s_nOptionsLength++] = static_cast<uint8_t>(nLength);
+	memcpy(&s_dhcp_message.options[s_nOptionsLength], s_pHostname, nLength);
+	s_nOptionsLength += nLength;
+}
+
+static void option_param_request() {
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_PARAM_REQUEST;
+	s_dhcp_message.options[s_nOptionsLength++] = 0x07;	// length of request
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_SUBNET_MASK;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_ROUTERS_ON_SUBNET;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_DNS;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_DOMAIN_NAME;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_LEASE_TIME;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_DHCP_T1_VALUE;
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_DHCP_T2_VALUE;
+}
 
-	s_dhcp_message.options[k++] = OPTIONS_CLIENT_IDENTIFIER;
-	s_dhcp_message.options[k++] = 0x07;
-	s_dhcp_message.options[k++] = 0x01;
-	s_dhcp_message.options[k++] = pMacAddress[0];
-	s_dhcp_message.options[k++] = pMacAddress[1];
-	s_dhcp_message.options[k++] = pMacAddress[2];
-	s_dhcp_message.options[k++] = pMacAddress[3];
-	s_dhcp_message.options[k++] = pMacAddress[4];
-	s_dhcp_message.options[k++] = pMacAddress[5];
+static void send(const uint32_t nToIp) {
+	s_dhcp_message.options[s_nOptionsLength++] = OPTIONS_END_OPTION;
+
+	udp_send(s_nHandle, reinterpret_cast<uint8_t *>(&s_dhcp_message), static_cast<uint16_t>(s_nOptionsLength + sizeof(dhcp::Message) - DHCP_OPT_SIZE), nToIp, DHCP_PORT_SERVER);
+}
 
-	s_dhcp_message.options[k++] = OPTIONS_PARAM_REQUEST;
-	s_dhcp_message.options[k++] = 0x06;	// length of request
-	s_dhcp_message.options[k++] = OPTIONS_SUBNET_MASK;
-	s_dhcp_message.options[k++] = OPTIONS_ROUTERS_ON_SUBNET;
-	s_dhcp_message.options[k++] = OPTIONS_DNS;
-	s_dhcp_message.options[k++] = OPTIONS_DOMAIN_NAME;
-	s_dhcp_message.options[k++] = OPTIONS_DHCP_T1_VALUE;
-	s_dhcp_message.options[k++] = OPTIONS_DHCP_T2_VALUE;
-	s_dhcp_message.options[k++] = OPTIONS_END_OPTION;
+static void send_discover() {
+	DEBUG_ENTRY
+
+	message_init(DCHP_TYPE_DISCOVER, 0);
+
+	// A hint, the server may offer the previous address again
+	if (s_Lease.nIp != 0) {
+		option_ip(OPTIONS_REQUESTED_IP, s_Lease.nIp);
+	}
 
-	udp_send(nHandle, reinterpret_cast<uint8_t *>(&s_dhcp_message), static_cast<uint16_t>(k + sizeof(dhcp::Message) - DHCP_OPT_SIZE), IP_BROADCAST, DHCP_PORT_SERVER);
+	option_param_request();
+	send(IP_BROADCAST);
 
 	DEBUG_EXIT
 }
 
-static void _send_request(int idx, const uint8_t *pMacAddress, const char *pHostname) {
+/**
+ * SELECTING: requested IP and server identifier
+ * INIT-REBOOT: requested IP
+ * RENEWING, REBINDING: ciaddr
+ */
+static void send_request() {
 	DEBUG_ENTRY
 
-	uint32_t i;
-	uint32_t k = 6;
-
-	s_dhcp_message.options[k++] = DCHP_TYPE_REQUEST;
-
-	s_dhcp_message.options[k++] = OPTIONS_CLIENT_IDENTIFIER;
-	s_dhcp_message.options[k++] = 0x07;
-	s_dhcp_message.options[k++] = 0x01;
-	s_dhcp_message.options[k++] = pMacAddress[0];
-	s_dhcp_message.options[k++] = pMacAddress[1];
-	s_dhcp_message.options[k++] = pMacAddress[2];
-	s_dhcp_message.options[k++] = pMacAddress[3];
-	s_dhcp_message.options[k++] = pMacAddress[4];
-	s_dhcp_message.options[k++] = pMacAddress[5];
-
-	s_dhcp_message.options[k++] = OPTIONS_REQUESTED_IP;
-	s_dhcp_message.options[k++] = 0x04;
-	s_dhcp_message.options[k++] = s_dhcp_allocated_ip[0];
-	s_dhcp_message.options[k++] = s_dhcp_allocated_ip[1];
-	s_dhcp_message.options[k++] = s_dhcp_allocated_ip[2];
-	s_dhcp_message.options[k++] = s_dhcp_allocated_ip[3];
-
-	s_dhcp_message.options[k++] = OPTIONS_SERVER_IDENTIFIER;
-	s_dhcp_message.options[k++] = 0x04;
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[0];
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[1];
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[2];
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[3];
-
-	s_dhcp_message.options[k++] = OPTIONS_HOSTNAME;
-	s_dhcp_message.options[k++] = 0; // length of hostname
-	for (i = 0; pHostname[i] != 0; i++) {
-		s_dhcp_message.options[k++] = pHostname[i];
+	const auto isBound = (s_State == net::dhcp::State::RENEWING) || (s_State == net::dhcp::State::REBINDING);
+
+	message_init(DCHP_TYPE_REQUEST, isBound ? s_Lease.nIp : 0);
+
+	if (s_State == net::dhcp::State::REQUESTING) {
+		option_ip(OPTIONS_REQUESTED_IP, s_nOfferedIp);
+		option_ip(OPTIONS_SERVER_IDENTIFIER, s_nOfferedServerIp);
+	} else if (s_State == net::dhcp::State::REBOOTING) {
+		option_ip(OPTIONS_REQUESTED_IP, s_Lease.nIp);
 	}
-	s_dhcp_message.options[k - (i + 1)] = static_cast<uint8_t>(i); // length of hostname
 
-	s_dhcp_message.options[k++] = OPTIONS_PARAM_REQUEST;
-	s_dhcp_message.options[k++] = 0x06;	// length of request
-	s_dhcp_message.options[k++] = OPTIONS_SUBNET_MASK;
-	s_dhcp_message.options[k++] = OPTIONS_ROUTERS_ON_SUBNET;
-	s_dhcp_message.options[k++] = OPTIONS_DNS;
-	s_dhcp_message.options[k++] = OPTIONS_DOMAIN_NAME;
-	s_dhcp_message.options[k++] = OPTIONS_DHCP_T1_VALUE;
-	s_dhcp_message.options[k++] = OPTIONS_DHCP_T2_VALUE;
-	s_dhcp_message.options[k++] = OPTIONS_END_OPTION;
+	option_hostname();
+	option_param_request();
 
-	udp_send(idx, reinterpret_cast<uint8_t *>(&s_dhcp_message), static_cast<uint16_t>(k + sizeof(dhcp::Message) - DHCP_OPT_SIZE), IP_BROADCAST, DHCP_PORT_SERVER);
+	s_nRequestMillis = Hardware::Get()->Millis();
+
+	send(s_State == net::dhcp::State::RENEWING ? s_Lease.nServerIp : IP_BROADCAST);
 
 	DEBUG_EXIT
 }
 
-static int parse_response(int nHandle, const uint8_t *pMacAddress) {
-	uint8_t *pResponse;
-	const auto nMillis = Hardware::Get()->Millis();
-	uint32_t nSize = 0;
+static uint32_t get_ip(const uint8_t *p) {
+	uint32_t nIp;
+	memcpy(&nIp, p, IPv4_ADDR_LEN);
+	return nIp;
+}
 
-	do {
-		net_handle();
+static uint32_t get_seconds(const uint8_t *p) {
+	return __builtin_bswap32(get_ip(p));
+}
 
-		uint32_t nFromIp;
-		uint16_t nFromPort;
+static bool parse_reply(const uint8_t *pResponse, const uint32_t nSize, Reply& reply) {
+	const auto *const pDhcpMessage = reinterpret_cast<const dhcp::Message *>(pResponse);
+	const auto nOptionsOffset = sizeof(dhcp::Message) - DHCP_OPT_SIZE;
 
-		nSize = udp_recv2(nHandle, const_cast<const uint8_t **>(&pResponse), &nFromIp, &nFromPort);
+	if ((nSize < nOptionsOffset + 4) || (pDhcpMessage->op != DHCP_OP_BOOTREPLY) || (pDhcpMessage->xid != s_nXid)) {
+		return false;
+	}
 
-		if ((nSize > 0) && (nFromPort == DHCP_PORT_SERVER)) {
+	if (memcmp(pDhcpMessage->chaddr, net::globals::macAddress, ETH_ADDR_LEN) != 0) {
+		return false;
+	}
 
-			const auto *const pDhcpMessage = reinterpret_cast<dhcp::Message *>(pResponse);
+	if (get_seconds(&pResponse[nOptionsOffset]) != MAGIC_COOKIE) {
+		return false;
+	}
 
-			if (memcmp(pDhcpMessage->chaddr, pMacAddress, ETH_ADDR_LEN) == 0) {
-				break;
-			}
-		}
-	} while ((Hardware::Get()->Millis() - nMillis) < 500);
+	memset(&reply, 0, sizeof(Reply));
+	reply.nIp = get_ip(pDhcpMessage->yiaddr);
 
-	DEBUG_PRINTF("timeout %u", Hardware::Get()->Millis() - nMillis);
+	const auto *p = &pResponse[nOptionsOffset + 4];
+	const auto *const e = &pResponse[nSize];
 
-	int type = 0;
-	uint8_t opt_len = 0;
+	while (p < e) {
+		const auto nOption = *p++;
 
-	if (nSize > 0) {
-		auto *p = pResponse;
-		p = p + sizeof(dhcp::Message) - DHCP_OPT_SIZE + 4;
-		auto *e = pResponse + nSize;
+		if (nOption == OPTIONS_PAD_OPTION) {
+			continue;
+		}
 
-		while (p < e) {
-			switch (*p) {
-			case OPTIONS_END_OPTION:
-				p = e;
-				break;
-			case OPTIONS_PAD_OPTION:
-				p++;
-				break;
-			case OPTIONS_MESSAGE_TYPE:
-				p++;
-				p++;
-				type = *p++;
-				break;
-   			case OPTIONS_SUBNET_MASK:
-   				p++;
-   				p++;
-   				s_dhcp_allocated_netmask[0] = *p++;
-   				s_dhcp_allocated_netmask[1] = *p++;
-   				s_dhcp_allocated_netmask[2] = *p++;
-   				s_dhcp_allocated_netmask[3] = *p++;
-   				break;
-   			case OPTIONS_ROUTERS_ON_SUBNET:
-   				p++;
-   				opt_len = *p++;
-   				s_dhcp_allocated_gw[0] = *p++;
-   				s_dhcp_allocated_gw[1] = *p++;
-   				s_dhcp_allocated_gw[2] = *p++;
-   				s_dhcp_allocated_gw[3] = *p++;
-   				p = p + (opt_len - 4);
-   				break;
-   			case OPTIONS_SERVER_IDENTIFIER :
-   				p++;
-   				opt_len = *p++;
-   				s_dhcp_server_ip[0] = *p++;
-   				s_dhcp_server_ip[1] = *p++;
-   				s_dhcp_server_ip[2] = *p++;
-   				s_dhcp_server_ip[3] = *p++;
-   				break;
-			default:
-				p++;
-				opt_len = *p++;
-				p += opt_len;
-				break;
-			}
+		if ((nOption == OPTIONS_END_OPTION) || (p >= e)) {
+			break;
 		}
 
-		if (type == DCHP_TYPE_OFFER) {
-			const auto *const pDhcpMessage = reinterpret_cast<dhcp::Message *>(pResponse);
-            s_dhcp_allocated_ip[0] = pDhcpMessage->yiaddr[0];
-            s_dhcp_allocated_ip[1] = pDhcpMessage->yiaddr[1];
-            s_dhcp_allocated_ip[2] = pDhcpMessage->yiaddr[2];
-            s_dhcp_allocated_ip[3] = pDhcpMessage->yiaddr[3];
+		const auto nLength = *p++;
+
+		if ((p + nLength) > e) {
+			return false;
+		}
+
+		switch (nOption) {
+		case OPTIONS_MESSAGE_TYPE:
+			reply.nType = p[0];
+			break;
+		case OPTIONS_SUBNET_MASK:
+			reply.nNetmask = get_ip(p);
+			break;
+		case OPTIONS_ROUTERS_ON_SUBNET:
+			reply.nGatewayIp = get_ip(p);
+			break;
+		case OPTIONS_SERVER_IDENTIFIER:
+			reply.nServerIp = get_ip(p);
+			break;
+		case OPTIONS_LEASE_TIME:
+			reply.nLeaseTime = get_seconds(p);
+			break;
+		case OPTIONS_DHCP_T1_VALUE:
+			reply.nT1 = get_seconds(p);
+			break;
+		case OPTIONS_DHCP_T2_VALUE:
+			reply.nT2 = get_seconds(p);
+			break;
+		default:
+			break;
 		}
 
-		return type;
+		p += nLength;
 	}
 
-	return -1;
+	return reply.nType != 0;
 }
 
-int dhcp_client(const char *pHostname) {
-	DEBUG_ENTRY
+static void new_xid() {
+	s_nXid = get_random();
+}
+
+static void set_state(const net::dhcp::State state, const uint32_t nDelayMillis) {
+	DEBUG_PRINTF("%u -> %u", static_cast<uint32_t>(s_State), static_cast<uint32_t>(state));
+	s_State = state;
+	s_nTimerMillis = Hardware::Get()->Millis() + nDelayMillis;
+}
+
+static void init(const uint32_t nDelayMillis) {
+	new_xid();
+	s_nAttempts = 0;
+	s_nRetransmitMillis = dhcp::RETRANSMIT_MIN_MILLIS;
+	set_state(net::dhcp::State::INIT, nDelayMillis);
+}
+
+/**
+ * The client has no address anymore
+ */
+static void lost() {
+	if (s_isBound) {
+		s_isBound = false;
+		net_dhcp_event(net::dhcp::Event::LOST, &s_Lease);
+	}
 
-	auto bHaveIp = false;
-	int32_t retries = 20;
+	init(get_random() % dhcp::INIT_DELAY_MAX_MILLIS);
+}
+
+static void retransmit(const net::dhcp::State state) {
+	s_nAttempts++;
+	set_state(state, randomize(s_nRetransmitMillis));
+
+	if (s_nRetransmitMillis < dhcp::RETRANSMIT_MAX_MILLIS) {
+		s_nRetransmitMillis *= 2;
+	}
+}
 
-	message_init(net::globals::macAddress);
+static void bind(const Reply& reply) {
+	const auto nPreviousIp = s_Lease.nIp;
 
-	auto nHandle = udp_begin(DHCP_PORT_CLIENT);
+	s_Lease.nIp = reply.nIp;
+	s_Lease.nNetmask = reply.nNetmask;
+	s_Lease.nGatewayIp = reply.nGatewayIp;
 
-	if (nHandle < 0) {
-		return -1;
+	if (reply.nServerIp != 0) {
+		s_Lease.nServerIp = reply.nServerIp;
 	}
 
-	net::globals::ipInfo.ip.addr = 0;
-	ip_set_ip();
+	auto nLeaseTime = reply.nLeaseTime;
 
-	while (!bHaveIp && (retries-- > 0)) {
-		DEBUG_PRINTF("retries=%d", retries);
+	if ((nLeaseTime == 0) || (nLeaseTime > dhcp::LEASE_MAX_SECONDS)) {
+		nLeaseTime = dhcp::LEASE_MAX_SECONDS;
+	}
 
-		send_discover(static_cast<uint8_t>(nHandle), net::globals::macAddress);
+	s_Lease.nLeaseTime = nLeaseTime;
 
-		int type;
+	const auto nT1 = ((reply.nT1 != 0) && (reply.nT1 < nLeaseTime)) ? reply.nT1 : nLeaseTime / 2;
+	const auto nT2 = ((reply.nT2 > nT1) && (reply.nT2 < nLeaseTime)) ? reply.nT2 : (nLeaseTime / 8) * 7;
 
-		if ((type = parse_response(static_cast<uint8_t>(nHandle), net::globals::macAddress)) < 0) {
-			continue;
+	s_nLeaseStartMillis = s_nRequestMillis;
+	s_nT1Millis = nT1 * 1000;
+	s_nT2Millis = nT2 * 1000;
+	s_nLeaseMillis = nLeaseTime * 1000;
+	s_isFailed = false;
+
+	DEBUG_PRINTF(IPSTR " lease %u, T1 %u, T2 %u", IP2STR(s_Lease.nIp), nLeaseTime, nT1, nT2);
+
+	s_State = net::dhcp::State::BOUND;
+
+	const auto isRenewed = s_isBound && (nPreviousIp == s_Lease.nIp);
+	s_isBound = true;
+
+	net_dhcp_event(isRenewed ? net::dhcp::Event::RENEWED : net::dhcp::Event::BOUND, &s_Lease);
+}
+
+static void handle_reply(const Reply& reply) {
+	DEBUG_PRINTF("state=%u, type=%u", static_cast<uint32_t>(s_State), reply.nType);
+
+	switch (s_State) {
+	case net::dhcp::State::SELECTING:
+		if ((reply.nType == DCHP_TYPE_OFFER) && (reply.nIp != 0) && (reply.nServerIp != 0)) {
+			// The first offer is taken
+			s_nOfferedIp = reply.nIp;
+			s_nOfferedServerIp = reply.nServerIp;
+			s_State = net::dhcp::State::REQUESTING;
+			send_request();
+			retransmit(net::dhcp::State::REQUESTING);
 		}
+		break;
+	case net::dhcp::State::REQUESTING:
+	case net::dhcp::State::REBOOTING:
+	case net::dhcp::State::RENEWING:
+	case net::dhcp::State::REBINDING:
+		if (reply.nType == DCHP_TYPE_ACK) {
+			bind(reply);
+		} else if (reply.nType == DCHP_TYPE_NAK) {
+			DEBUG_PUTS("NAK");
+			if (s_State == net::dhcp::State::REQUESTING) {
+				init(get_random() % dhcp::INIT_DELAY_MAX_MILLIS);
+			} else {
+				lost();
+				s_Lease.nIp = 0;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
 
-		DEBUG_PRINTF("type=%d", type);
+static void handle_timer(const uint32_t nMillis) {
+	switch (s_State) {
+	case net::dhcp::State::INIT:
+		if (!is_before(nMillis, s_nTimerMillis)) {
+			s_State = net::dhcp::State::SELECTING;
+			send_discover();
+			retransmit(net::dhcp::State::SELECTING);
+		}
+		break;
+	case net::dhcp::State::SELECTING:
+	case net::dhcp::State::REQUESTING:
+		if (!is_before(nMillis, s_nTimerMillis)) {
+			if (s_nAttempts >= dhcp::SELECTING_ATTEMPTS) {
+				if (!s_isFailed) {
+					s_isFailed = true;
+					net_dhcp_event(net::dhcp::Event::FAILED, &s_Lease);
+				}
+
+				if (s_nRetrySeconds == 0) {
+					DEBUG_PUTS("No retry");
+					s_State = net::dhcp::State::OFF;
+					break;
+				}
+
+				init(s_nRetrySeconds * 1000 + (get_random() % dhcp::INIT_DELAY_MAX_MILLIS));
+				break;
+			}
 
-		if (type != DCHP_TYPE_OFFER) {
-			continue;
+			s_State = net::dhcp::State::SELECTING;
+			send_discover();
+			retransmit(net::dhcp::State::SELECTING);
 		}
+		break;
+	case net::dhcp::State::INIT_REBOOT:
+		if (!is_before(nMillis, s_nTimerMillis)) {
+			s_State = net::dhcp::State::REBOOTING;
+			send_request();
+			retransmit(net::dhcp::State::REBOOTING);
+		}
+		break;
+	case net::dhcp::State::REBOOTING:
+		if (!is_before(nMillis, s_nTimerMillis)) {
+			if (s_nAttempts >= dhcp::REBOOT_ATTEMPTS) {
+				DEBUG_PUTS("No reply on INIT-REBOOT");
+				init(0);
+				break;
+			}
 
-		DEBUG_PRINTF(IPSTR, s_dhcp_server_ip[0],s_dhcp_server_ip[1],s_dhcp_server_ip[2],s_dhcp_server_ip[3]);
+			send_request();
+			retransmit(net::dhcp::State::REBOOTING);
+		}
+		break;
+	case net::dhcp::State::BOUND:
+	case net::dhcp::State::RENEWING:
+	case net::dhcp::State::REBINDING: {
+		const auto nElapsed = nMillis - s_nLeaseStartMillis;
+
+		if (nElapsed >= s_nLeaseMillis) {
+			DEBUG_PUTS("Lease expired");
+			lost();
+			break;
+		}
 
-		_send_request(static_cast<uint8_t>(nHandle), net::globals::macAddress, pHostname);
+		if (nElapsed < s_nT1Millis) {
+			break;
+		}
 
-		if ((type =parse_response(static_cast<uint8_t>(nHandle), net::globals::macAddress)) < 0) {
-			continue;
+		auto nDeadline = s_nLeaseMillis;
+
+		if (nElapsed < s_nT2Millis) {
+			if (s_State == net::dhcp::State::BOUND) {
+				new_xid();
+				s_State = net::dhcp::State::RENEWING;
+				s_nTimerMillis = nMillis;
+			}
+			nDeadline = s_nT2Millis;
+		} else if (s_State != net::dhcp::State::REBINDING) {
+			new_xid();
+			s_State = net::dhcp::State::REBINDING;
+			s_nTimerMillis = nMillis;
 		}
 
-		DEBUG_PRINTF("type=%d", type);
+		if (!is_before(nMillis, s_nTimerMillis)) {
+			send_request();
+			// RFC 2131 4.4.5: one-half of the remaining time, down to a minimum of 60 seconds
+			auto nWait = (nDeadline - nElapsed) / 2;
 
-		if (type == DCHP_TYPE_ACK) {
-			bHaveIp = true;
-			break;
+			if (nWait < dhcp::RETRANSMIT_RENEW_MIN_MILLIS) {
+				nWait = dhcp::RETRANSMIT_RENEW_MIN_MILLIS;
+			}
+
+			s_nTimerMillis = nMillis + nWait;
 		}
+		break;
 	}
+	default:
+		break;
+	}
+}
 
-	udp_end(DHCP_PORT_CLIENT);
+/**
+ * @param pLease The lease of the previous boot, then INIT-REBOOT. Can be nullptr.
+ * @param nRetrySeconds After the FAILED event, 0 is no retry.
+ */
+void dhcp_client_start(const char *pHostname, const struct DhcpLease *pLease, const uint32_t nRetrySeconds) {
+	DEBUG_ENTRY
 
-	if (bHaveIp) {
-		_pcast32 ip;
+	if (s_nHandle < 0) {
+		s_nHandle = udp_begin(DHCP_PORT_CLIENT);
 
-		memcpy(ip.u8, s_dhcp_allocated_ip, IPv4_ADDR_LEN);
-		net::globals::ipInfo.ip.addr = ip.u32;
+		if (s_nHandle < 0) {
+			console_error("dhcp_client_start\n");
+			DEBUG_EXIT
+			return;
+		}
+	}
 
-		memcpy(ip.u8, s_dhcp_allocated_gw, IPv4_ADDR_LEN);
-		net::globals::ipInfo.gw.addr = ip.u32;
+	s_pHostname = pHostname;
+	s_nRetrySeconds = nRetrySeconds;
+	s_isFailed = false;
+	s_isBound = false;
+	s_nRandom = get_ip(&net::globals::macAddress[2]) ^ Hardware::Get()->Micros();
+
+	if (s_nRandom == 0) {
+		s_nRandom = 1;
+	}
 
-		memcpy(ip.u8, s_dhcp_allocated_netmask, IPv4_ADDR_LEN);
-		net::globals::ipInfo.netmask.addr = ip.u32;
+	if ((pLease != nullptr) && (pLease->nIp != 0)) {
+		memcpy(&s_Lease, pLease, sizeof(struct DhcpLease));
+		new_xid();
+		s_nAttempts = 0;
+		s_nRetransmitMillis = dhcp::RETRANSMIT_MIN_MILLIS;
+		set_state(net::dhcp::State::INIT_REBOOT, get_random() % dhcp::REBOOT_DELAY_MAX_MILLIS);
+	} else {
+		memset(&s_Lease, 0, sizeof(struct DhcpLease));
+		init(get_random() % dhcp::INIT_DELAY_MAX_MILLIS);
 	}
 
 	DEBUG_EXIT
-	return bHaveIp ? 0 : -2;
 }
 
-void dhcp_client_release() {
+void dhcp_client_stop() {
 	DEBUG_ENTRY
 
-	auto nHandle = udp_begin(DHCP_PORT_CLIENT);
+	s_State = net::dhcp::State::OFF;
+
+	if (s_nHandle >= 0) {
+		udp_end(DHCP_PORT_CLIENT);
+		s_nHandle = -1;
+	}
+
+	DEBUG_EXIT
+}
+
+net::dhcp::State dhcp_client_get_state() {
+	return s_State;
+}
 
-	if (nHandle < 0) {
-		console_error("dhcp_client_release\n");
+/**
+ * From net_timers_run, every 100 ms
+ */
+void dhcp_client_timer() {
+	if ((s_State == net::dhcp::State::OFF) || s_isBusy) {
 		return;
 	}
 
-	uint32_t k = 6;
+	// A unicast send can do an ARP lookup which runs net_handle
+	s_isBusy = true;
+
+	const uint8_t *pResponse;
+	uint32_t nFromIp;
+	uint16_t nFromPort;
 
-	s_dhcp_message.options[k++] = DCHP_TYPE_RELEASE;
+	const auto nSize = udp_recv2(s_nHandle, &pResponse, &nFromIp, &nFromPort);
 
-	s_dhcp_message.options[k++] = OPTIONS_SERVER_IDENTIFIER;
-	s_dhcp_message.options[k++] = 0x04;
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[0];
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[1];
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[2];
-	s_dhcp_message.options[k++] = s_dhcp_server_ip[3];
+	if ((nSize > 0) && (nFromPort == DHCP_PORT_SERVER)) {
+		Reply reply;
+
+		if (parse_reply(pResponse, nSize, reply)) {
+			handle_reply(reply);
+		}
+	}
+
+	handle_timer(Hardware::Get()->Millis());
+
+	s_isBusy = false;
+}
+
+void dhcp_client_release() {
+	DEBUG_ENTRY
+
+	if ((s_Lease.nIp != 0) && (s_State >= net::dhcp::State::BOUND)) {
+		if (s_nHandle < 0) {
+			s_nHandle = udp_begin(DHCP_PORT_CLIENT);
+		}
+
+		if (s_nHandle >= 0) {
+			new_xid();
+			message_init(DCHP_TYPE_RELEASE, s_Lease.nIp);
+			option_ip(OPTIONS_SERVER_IDENTIFIER, s_Lease.nServerIp);
+			send(IP_BROADCAST);
+		}
+	}
 
-	s_dhcp_message.options[k++] = OPTIONS_END_OPTION;
+	s_Lease.nIp = 0;
+	s_isBound = false;
 
-	udp_send(static_cast<uint8_t>(nHandle), reinterpret_cast<uint8_t *>(&s_dhcp_message), static_cast<uint16_t>(k + sizeof(dhcp::Message) - DHCP_OPT_SIZE), IP_BROADCAST, DHCP_PORT_SERVER);
-	udp_end(DHCP_PORT_CLIENT);
+	dhcp_client_stop();
 
 	DEBUG_EXIT
 }
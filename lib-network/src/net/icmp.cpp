@@ -48,21 +48,30 @@ __attribute__((hot)) void icmp_handle(struct t_icmp *p_icmp) {
 			// Ethernet
 			memcpy(p_icmp->ether.dst, p_icmp->ether.src, ETH_ADDR_LEN);
 			memcpy(p_icmp->ether.src, net::globals::macAddress, ETH_ADDR_LEN);
+			/*
+			 * The checksums of the request are updated (RFC 1624).
+			 * Swapping the source and destination does not change the sum.
+			 */
 			// IPv4
-			p_icmp->ip4.id = static_cast<uint16_t>(~p_icmp->ip4.id);
+			const auto nId = p_icmp->ip4.id;
+			p_icmp->ip4.id = static_cast<uint16_t>(~nId);
 			uint8_t dst[IPv4_ADDR_LEN];
 			memcpy(dst, p_icmp->ip4.dst, IPv4_ADDR_LEN);
 			memcpy(p_icmp->ip4.dst, p_icmp->ip4.src, IPv4_ADDR_LEN);
 			memcpy(p_icmp->ip4.src, dst, IPv4_ADDR_LEN);
+#if defined (CHECKSUM_BY_HARDWARE)
 			p_icmp->ip4.chksum = 0;
-#if !defined (CHECKSUM_BY_HARDWARE)
-			p_icmp->ip4.chksum = net_chksum(reinterpret_cast<void *>(&p_icmp->ip4), 20); //TODO
+#else
+			p_icmp->ip4.chksum = net_chksum_update16(p_icmp->ip4.chksum, nId, p_icmp->ip4.id);
 #endif
 			// ICMP
+#if defined (CHECKSUM_BY_HARDWARE)
 			p_icmp->icmp.type = ICMP_TYPE_ECHO_REPLY;
 			p_icmp->icmp.checksum = 0;
-#if !defined (CHECKSUM_BY_HARDWARE)
-			p_icmp->icmp.checksum = net_chksum(reinterpret_cast<void *>(&p_icmp->ip4), static_cast<uint32_t>(__builtin_bswap16(p_icmp->ip4.len)));
+#else
+			const auto nTypeCode = *reinterpret_cast<uint16_t *>(&p_icmp->icmp);
+			p_icmp->icmp.type = ICMP_TYPE_ECHO_REPLY;
+			p_icmp->icmp.checksum = net_chksum_update16(p_icmp->icmp.checksum, nTypeCode, *reinterpret_cast<uint16_t *>(&p_icmp->icmp));
 #endif
 			emac_eth_send(reinterpret_cast<void *>(p_icmp), (sizeof(struct ether_header) + __builtin_bswap16(p_icmp->ip4.len)));
 		}
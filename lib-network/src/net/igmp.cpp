@@ -35,16 +35,41 @@
 /*
  * https://www.rfc-editor.org/rfc/rfc2236.html
  * Internet Group Management Protocol, Version 2
+ *
+ * https://www.rfc-editor.org/rfc/rfc3376.html
+ * Internet Group Management Protocol, Version 3
+ *
+ * The host is running in IGMPv3 mode. When an IGMPv2 (or IGMPv1) query is heard,
+ * it falls back to IGMPv2 for the Older Version Querier Present Timeout.
+ * A source specific join is then reported as a join of the whole group, and
+ * the sources are filtered in igmp_is_member.
  */
 
-enum State {
+namespace igmp {
+static constexpr uint32_t ALL_SYSTEMS = 0x010000e0;			///< 224.0.0.1
+static constexpr uint32_t ALL_V3_ROUTERS = 0x160000e0;		///< 224.0.0.22
+static constexpr uint32_t MAX_SOURCES = 2;					///< Source specific joins per group
+static constexpr uint32_t TABLE_SHIFT_MIN = 4;
+static constexpr uint8_t ROBUSTNESS = 2;					///< RFC 3376 8.1 Robustness Variable, a state change report is sent this many times
+static constexpr uint16_t JOIN_TIMER = 2;					///< The state change report retransmission interval, 1/10 seconds
+static constexpr uint16_t OLDER_VERSION_QUERIER_TIMEOUT = 2600;	///< 2 x 125 s + 10 s, 1/10 seconds
+static constexpr uint16_t V1_MAX_RESPONSE_TIME = 100;		///< 1/10 seconds
+static constexpr uint32_t FIBONACCI = 2654435761U;
+}  // namespace igmp
+
+enum State : uint8_t {
 	NON_MEMBER, DELAYING_MEMBER, IDLE_MEMBER
 };
 
 struct t_group_info {
-	uint32_t nGroupAddress;
-	uint16_t nTimer;		// 1/10 seconds
+	uint32_t nGroupAddress;						///< 0 is a free slot
+	uint32_t nSourceAddress[igmp::MAX_SOURCES];	///< INCLUDE mode when nSources != 0, else EXCLUDE {}
+	uint16_t nTimer;							///< 1/10 seconds
+	uint8_t nSources;
 	State state;
+	uint16_t nChangeTimer;						///< 1/10 seconds
+	uint8_t nChangeType;						///< The pending state change record, CHANGE_TO_EXCLUDE or ALLOW_NEW_SOURCES
+	uint8_t nRetransmissions;					///< The pending state change record is sent again when != 0
 };
 
 typedef union pcast32 {
@@ -54,9 +79,35 @@ typedef union pcast32 {
 
 static struct t_igmp s_report SECTION_NETWORK ALIGNED;
 static struct t_igmp s_leave SECTION_NETWORK ALIGNED;
+static struct t_igmp_v3 s_report_v3 SECTION_NETWORK ALIGNED;
 static uint8_t s_multicast_mac[ETH_ADDR_LEN] SECTION_NETWORK ALIGNED;
-static struct t_group_info s_groups[IGMP_MAX_JOINS_ALLOWED] SECTION_NETWORK ALIGNED;
 static uint16_t s_id SECTION_NETWORK ALIGNED;
+/*
+ * The sums of the fields which do not change, the ids and the addresses are added for each packet
+ */
+static uint32_t s_nReportIp4Sum SECTION_NETWORK ALIGNED;
+static uint32_t s_nReportIgmpSum SECTION_NETWORK ALIGNED;
+static uint32_t s_nLeaveIp4Sum SECTION_NETWORK ALIGNED;
+static uint32_t s_nLeaveIgmpSum SECTION_NETWORK ALIGNED;
+static uint32_t s_nReportV3Ip4Sum SECTION_NETWORK ALIGNED;
+
+/*
+ * Open addressing with linear probing, the table size is a power of 2.
+ * The table grows when it is 3/4 full.
+ */
+static struct t_group_info *s_pGroups SECTION_NETWORK ALIGNED;
+static uint32_t s_nTableShift SECTION_NETWORK ALIGNED;
+static uint32_t s_nTableMask SECTION_NETWORK ALIGNED;
+static uint32_t s_nGroups SECTION_NETWORK ALIGNED;
+static uint32_t s_nDelaying SECTION_NETWORK ALIGNED;			///< Groups with a running timer
+static uint32_t s_nChanging SECTION_NETWORK ALIGNED;			///< Groups with a pending state change record
+static uint32_t s_nHashTable[2] SECTION_NETWORK ALIGNED;		///< EMAC multicast hash filter
+static uint16_t s_nBinCount[64] SECTION_NETWORK ALIGNED;
+
+static uint16_t s_nGeneralTimer SECTION_NETWORK ALIGNED;		///< IGMPv3 response to a General Query, 1/10 seconds
+static uint16_t s_nV2QuerierTimer SECTION_NETWORK ALIGNED;		///< IGMPv2 compatibility mode when != 0, 1/10 seconds
+static uint32_t s_nV3RecordsLength SECTION_NETWORK ALIGNED;
+static uint16_t s_nV3Records SECTION_NETWORK ALIGNED;
 
 namespace net {
 namespace globals {
@@ -66,6 +117,355 @@ extern uint8_t macAddress[ETH_ADDR_LEN];
 }  // namespace net
 
 static void _send_report(uint32_t nGroupAddress);
+static void _send_leave(uint32_t nGroupAddress);
+
+static uint32_t hash(const uint32_t nGroupAddress) {
+	return (nGroupAddress * igmp::FIBONACCI) >> (32U - s_nTableShift);
+}
+
+static void multicast_mac(const uint32_t nGroupAddress, uint8_t *pMacAddress) {
+	_pcast32 multicast_ip;
+
+	multicast_ip.u32 = nGroupAddress;
+
+	pMacAddress[0] = 0x01;
+	pMacAddress[1] = 0x00;
+	pMacAddress[2] = 0x5E;
+	pMacAddress[3] = multicast_ip.u8[1] & 0x7F;
+	pMacAddress[4] = multicast_ip.u8[2];
+	pMacAddress[5] = multicast_ip.u8[3];
+}
+
+/*
+ * The multicast hash bin, the same for the H3 and the GD32 EMAC:
+ * the 6 most significant bits of the bit reversed CRC-32 of the destination MAC address.
+ * As Linux stmmac, bitrev32(~crc32_le(~0, addr, 6)) >> 26.
+ */
+
+uint32_t net_multicast_hash_bin(const uint8_t *pMacAddress) {
+	uint32_t nCrc = 0xFFFFFFFF;
+
+	for (uint32_t i = 0; i < ETH_ADDR_LEN; i++) {
+		nCrc ^= pMacAddress[i];
+
+		for (uint32_t j = 0; j < 8; j++) {
+			nCrc = (nCrc >> 1) ^ (0xEDB88320 & (0U - (nCrc & 1)));
+		}
+	}
+
+	nCrc = ~nCrc;
+
+	uint32_t nBin = 0;
+
+	for (uint32_t i = 0; i < 6; i++) {
+		nBin = (nBin << 1) | ((nCrc >> i) & 1);
+	}
+
+	return nBin;
+}
+
+/*
+ * EMAC multicast hash filter, the groups in a bin are counted.
+ * The EMAC is only written when a bin is set or cleared.
+ */
+
+static uint32_t filter_bin(const uint32_t nGroupAddress) {
+	uint8_t macAddress[ETH_ADDR_LEN];
+	multicast_mac(nGroupAddress, macAddress);
+
+	return net_multicast_hash_bin(macAddress);
+}
+
+static void filter_add(const uint32_t nGroupAddress) {
+	const auto nBin = filter_bin(nGroupAddress);
+
+	if (s_nBinCount[nBin]++ == 0) {
+		s_nHashTable[nBin >> 5] |= (1U << (nBin & 0x1F));
+		emac_multicast_hash_set(s_nHashTable[0], s_nHashTable[1]);
+	}
+}
+
+static void filter_remove(const uint32_t nGroupAddress) {
+	const auto nBin = filter_bin(nGroupAddress);
+
+	if (--s_nBinCount[nBin] == 0) {
+		s_nHashTable[nBin >> 5] &= ~(1U << (nBin & 0x1F));
+		emac_multicast_hash_set(s_nHashTable[0], s_nHashTable[1]);
+	}
+}
+
+static void filter_reset() {
+	memset(s_nBinCount, 0, sizeof(s_nBinCount));
+	s_nHashTable[0] = 0;
+	s_nHashTable[1] = 0;
+
+	filter_add(igmp::ALL_SYSTEMS);
+}
+
+/*
+ * Group table
+ */
+
+static bool table_resize(const uint32_t nTableShift) {
+	const auto nSize = 1U << nTableShift;
+	auto *pGroups = new struct t_group_info[nSize];
+
+	if (pGroups == nullptr) {
+		return false;
+	}
+
+	memset(pGroups, 0, nSize * sizeof(struct t_group_info));
+
+	auto *pGroupsOld = s_pGroups;
+	const auto nSizeOld = (pGroupsOld == nullptr) ? 0 : s_nTableMask + 1;
+
+	s_pGroups = pGroups;
+	s_nTableShift = nTableShift;
+	s_nTableMask = nSize - 1;
+
+	for (uint32_t i = 0; i < nSizeOld; i++) {
+		if (pGroupsOld[i].nGroupAddress != 0) {
+			auto nIndex = hash(pGroupsOld[i].nGroupAddress);
+
+			while (s_pGroups[nIndex].nGroupAddress != 0) {
+				nIndex = (nIndex + 1) & s_nTableMask;
+			}
+
+			s_pGroups[nIndex] = pGroupsOld[i];
+		}
+	}
+
+	delete[] pGroupsOld;
+
+	DEBUG_PRINTF("nSize=%u", nSize);
+	return true;
+}
+
+static struct t_group_info *group_find(const uint32_t nGroupAddress) {
+	auto nIndex = hash(nGroupAddress);
+
+	while (s_pGroups[nIndex].nGroupAddress != 0) {
+		if (s_pGroups[nIndex].nGroupAddress == nGroupAddress) {
+			return &s_pGroups[nIndex];
+		}
+
+		nIndex = (nIndex + 1) & s_nTableMask;
+	}
+
+	return nullptr;
+}
+
+static struct t_group_info *group_insert(const uint32_t nGroupAddress) {
+	if (((s_nGroups + 1) * 4) > ((s_nTableMask + 1) * 3)) {
+		// When there is no memory, the table can still be used until there is one free slot left
+		if (!table_resize(s_nTableShift + 1) && ((s_nGroups + 1) >= s_nTableMask)) {
+			return nullptr;
+		}
+	}
+
+	auto nIndex = hash(nGroupAddress);
+
+	while (s_pGroups[nIndex].nGroupAddress != 0) {
+		nIndex = (nIndex + 1) & s_nTableMask;
+	}
+
+	auto *pGroup = &s_pGroups[nIndex];
+
+	memset(pGroup, 0, sizeof(struct t_group_info));
+	pGroup->nGroupAddress = nGroupAddress;
+	pGroup->state = IDLE_MEMBER;
+
+	s_nGroups++;
+
+	return pGroup;
+}
+
+/**
+ * Backward shift deletion, there are no tombstones
+ */
+static void group_remove(struct t_group_info *pGroup) {
+	if (pGroup->state == DELAYING_MEMBER) {
+		s_nDelaying--;
+	}
+
+	if (pGroup->nRetransmissions != 0) {
+		s_nChanging--;
+	}
+
+	auto nHole = static_cast<uint32_t>(pGroup - s_pGroups);
+	auto nIndex = nHole;
+
+	for (;;) {
+		nIndex = (nIndex + 1) & s_nTableMask;
+
+		if (s_pGroups[nIndex].nGroupAddress == 0) {
+			break;
+		}
+
+		const auto nHome = hash(s_pGroups[nIndex].nGroupAddress);
+
+		// The entry can move to the hole when the hole is between its home slot and its slot
+		if (((nIndex - nHome) & s_nTableMask) >= ((nIndex - nHole) & s_nTableMask)) {
+			s_pGroups[nHole] = s_pGroups[nIndex];
+			nHole = nIndex;
+		}
+	}
+
+	memset(&s_pGroups[nHole], 0, sizeof(struct t_group_info));
+
+	s_nGroups--;
+}
+
+/**
+ * A timer which is already running is only made shorter.
+ */
+static void group_delay(struct t_group_info *pGroup, const uint16_t nTimer) {
+	if (pGroup->state != DELAYING_MEMBER) {
+		pGroup->state = DELAYING_MEMBER;
+		pGroup->nTimer = nTimer;
+		s_nDelaying++;
+	} else if (nTimer < pGroup->nTimer) {
+		pGroup->nTimer = nTimer;
+	}
+}
+
+/**
+ * RFC 3376 5.1, the state change record is retransmitted [Robustness Variable] - 1 times.
+ * A new change replaces the pending record, and the count starts again.
+ */
+static void group_change(struct t_group_info *pGroup, const uint8_t nRecordType) {
+	if (pGroup->nRetransmissions == 0) {
+		s_nChanging++;
+	}
+
+	pGroup->nChangeType = nRecordType;
+	pGroup->nChangeTimer = igmp::JOIN_TIMER;
+	pGroup->nRetransmissions = igmp::ROBUSTNESS - 1;
+}
+
+/**
+ * The responses of the groups, and of the hosts, are spread over the Max Response Time.
+ */
+static uint16_t response_delay(const uint32_t nKey, const uint32_t nMaxResponseTime) {
+	if (nMaxResponseTime <= 1) {
+		return 1;
+	}
+
+	return static_cast<uint16_t>(1 + (((nKey ^ net::globals::ipInfo.ip.addr) * igmp::FIBONACCI) >> 16) % nMaxResponseTime);
+}
+
+/*
+ * IGMPv3 reports
+ */
+
+static void v3_flush() {
+	if (s_nV3Records == 0) {
+		return;
+	}
+
+	const auto nIgmpLength = static_cast<uint32_t>(sizeof(struct t_igmp_v3_report)) + s_nV3RecordsLength;
+	const auto nIpLength = static_cast<uint32_t>(sizeof(struct ip4_header)) + 4U + nIgmpLength;
+
+	// IPv4
+	s_report_v3.ip4.len = __builtin_bswap16(static_cast<uint16_t>(nIpLength));
+	s_report_v3.ip4.id = s_id;
+#if defined (CHECKSUM_BY_HARDWARE)
+	s_report_v3.ip4.chksum = 0;
+#else
+	s_report_v3.ip4.chksum = net_chksum_fold(s_nReportV3Ip4Sum + s_report_v3.ip4.id + s_report_v3.ip4.len);
+#endif
+	// IGMP, there is no hardware offload
+	s_report_v3.report.number_of_records = __builtin_bswap16(s_nV3Records);
+	s_report_v3.report.checksum = 0;
+	s_report_v3.report.checksum = net_chksum(reinterpret_cast<void *>(&s_report_v3.report), nIgmpLength);
+
+	emac_eth_send(reinterpret_cast<void *>(&s_report_v3), static_cast<int>(sizeof(struct ether_header) + nIpLength));
+
+	s_id++;
+
+	s_nV3RecordsLength = 0;
+	s_nV3Records = 0;
+}
+
+static void v3_add_record(const uint8_t nRecordType, const uint32_t nGroupAddress, const uint32_t *pSourceAddress, const uint32_t nSources) {
+	const auto nLength = static_cast<uint32_t>(sizeof(struct t_igmp_v3_record)) + nSources * IPv4_ADDR_LEN;
+
+	auto nOffset = s_nV3RecordsLength;
+
+	if ((nOffset + nLength) > IGMP_V3_RECORDS_SIZE) {
+		v3_flush();
+		nOffset = 0;
+	}
+
+	auto *pRecord = reinterpret_cast<struct t_igmp_v3_record *>(&s_report_v3.records[nOffset]);
+
+	pRecord->type = nRecordType;
+	pRecord->aux_data_len = 0;
+	pRecord->number_of_sources = __builtin_bswap16(static_cast<uint16_t>(nSources));
+	memcpy(pRecord->multicast_address, &nGroupAddress, IPv4_ADDR_LEN);
+
+	if (nSources != 0) {
+		memcpy(&s_report_v3.records[nOffset + sizeof(struct t_igmp_v3_record)], pSourceAddress, nSources * IPv4_ADDR_LEN);
+	}
+
+	s_nV3RecordsLength = nOffset + nLength;
+	s_nV3Records++;
+}
+
+static void v3_add_current_state(const struct t_group_info *pGroup) {
+	if (pGroup->nSources == 0) {
+		v3_add_record(IGMP_V3_MODE_IS_EXCLUDE, pGroup->nGroupAddress, nullptr, 0);
+	} else {
+		v3_add_record(IGMP_V3_MODE_IS_INCLUDE, pGroup->nGroupAddress, pGroup->nSourceAddress, pGroup->nSources);
+	}
+}
+
+/**
+ * The allowed sources are the sources of the group, a source which is blocked in the meantime is not allowed again.
+ */
+static void v3_add_change(const struct t_group_info *pGroup) {
+	if (pGroup->nChangeType == IGMP_V3_CHANGE_TO_EXCLUDE) {
+		v3_add_record(IGMP_V3_CHANGE_TO_EXCLUDE, pGroup->nGroupAddress, nullptr, 0);
+	} else {
+		v3_add_record(IGMP_V3_ALLOW_NEW_SOURCES, pGroup->nGroupAddress, pGroup->nSourceAddress, pGroup->nSources);
+	}
+}
+
+static void send_state_change(const uint8_t nRecordType, const uint32_t nGroupAddress, const uint32_t *pSourceAddress, const uint32_t nSources, const bool isLeave) {
+	if (s_nV2QuerierTimer != 0) {
+		if (isLeave) {
+			_send_leave(nGroupAddress);
+		} else {
+			_send_report(nGroupAddress);
+		}
+		return;
+	}
+
+	v3_add_record(nRecordType, nGroupAddress, pSourceAddress, nSources);
+	v3_flush();
+}
+
+static void chksum_precompute() {
+	s_report.ip4.id = 0;
+	s_report.ip4.chksum = 0;
+	memset(s_report.ip4.dst, 0, IPv4_ADDR_LEN);
+	s_nReportIp4Sum = net_chksum_add(&s_report.ip4, 24, 0);
+	s_report.igmp.report.igmp.checksum = 0;
+	memset(s_report.igmp.report.igmp.group_address, 0, IPv4_ADDR_LEN);
+	s_nReportIgmpSum = net_chksum_add(&s_report.igmp.report.igmp, sizeof(struct t_igmp_packet), 0);
+
+	s_leave.ip4.id = 0;
+	s_leave.ip4.chksum = 0;
+	s_nLeaveIp4Sum = net_chksum_add(&s_leave.ip4, 24, 0);
+	s_leave.igmp.report.igmp.checksum = 0;
+	memset(s_leave.igmp.report.igmp.group_address, 0, IPv4_ADDR_LEN);
+	s_nLeaveIgmpSum = net_chksum_add(&s_leave.igmp.report.igmp, sizeof(struct t_igmp_packet), 0);
+
+	s_report_v3.ip4.len = 0;
+	s_report_v3.ip4.id = 0;
+	s_report_v3.ip4.chksum = 0;
+	s_nReportV3Ip4Sum = net_chksum_add(&s_report_v3.ip4, 24, 0);
+}
 
 void igmp_set_ip() {
 	_pcast32 src;
@@ -74,6 +474,9 @@ void igmp_set_ip() {
 
 	memcpy(s_report.ip4.src, src.u8, IPv4_ADDR_LEN);
 	memcpy(s_leave.ip4.src, src.u8, IPv4_ADDR_LEN);
+	memcpy(s_report_v3.ip4.src, src.u8, IPv4_ADDR_LEN);
+
+	chksum_precompute();
 }
 
 void __attribute__((cold)) igmp_init() {
@@ -129,6 +532,42 @@ void __attribute__((cold)) igmp_init() {
 	s_leave.igmp.report.igmp.type = IGMP_TYPE_LEAVE;
 	s_leave.igmp.report.igmp.max_resp_time = 0;
 
+	// Ethernet
+	multicast_mac(igmp::ALL_V3_ROUTERS, s_report_v3.ether.dst);
+	memcpy(s_report_v3.ether.src, net::globals::macAddress, ETH_ADDR_LEN);
+	s_report_v3.ether.type = __builtin_bswap16(ETHER_TYPE_IPv4);
+
+	// IPv4
+	s_report_v3.ip4.ver_ihl = 0x46;
+	s_report_v3.ip4.tos = 0xC0;	// Internetwork Control
+	s_report_v3.ip4.flags_froff = __builtin_bswap16(IPv4_FLAG_DF);
+	s_report_v3.ip4.ttl = 1;
+	s_report_v3.ip4.proto = IPv4_PROTO_IGMP;
+	memcpy(s_report_v3.ip4.dst, &igmp::ALL_V3_ROUTERS, IPv4_ADDR_LEN);
+	// IPv4 options: Router Alert
+	s_report_v3.ip4_options = 0x00000494;
+
+	// IGMP
+	s_report_v3.report.type = IGMP_TYPE_V3_REPORT;
+	s_report_v3.report.reserved1 = 0;
+	s_report_v3.report.reserved2 = 0;
+
+	chksum_precompute();
+
+	if (s_pGroups == nullptr) {
+		auto nTableShift = igmp::TABLE_SHIFT_MIN;
+
+		while (((1U << nTableShift) * 3) < (IGMP_MAX_JOINS_ALLOWED * 4)) {
+			nTableShift++;
+		}
+
+		if (!table_resize(nTableShift)) {
+			console_error("igmp_init\n");
+		}
+	}
+
+	filter_reset();
+
 	/*
 	 * https://tldp.org/HOWTO/Multicast-HOWTO-2.html
 	 * 224.0.0.1 is the all-hosts group. If you ping that group,
@@ -136,20 +575,43 @@ void __attribute__((cold)) igmp_init() {
 	 * as every multicast capable host must join that group
 	 * at start-up on all it's multicast capable interfaces.
 	 */
-	_send_report(0x010000e0);
+	_send_report(igmp::ALL_SYSTEMS);
 }
 
 void __attribute__((cold)) igmp_shutdown() {
 	DEBUG_ENTRY
 
-	for (auto& group : s_groups) {
-		if (group.nGroupAddress != 0) {
-			DEBUG_PRINTF(IPSTR, IP2STR(group.nGroupAddress));
+	if (s_pGroups == nullptr) {
+		DEBUG_EXIT
+		return;
+	}
+
+	for (uint32_t i = 0; i <= s_nTableMask; i++) {
+		const auto *pGroup = &s_pGroups[i];
 
-			igmp_leave(group.nGroupAddress);
+		if (pGroup->nGroupAddress != 0) {
+			DEBUG_PRINTF(IPSTR, IP2STR(pGroup->nGroupAddress));
+
+			if (s_nV2QuerierTimer != 0) {
+				_send_leave(pGroup->nGroupAddress);
+			} else if (pGroup->nSources == 0) {
+				v3_add_record(IGMP_V3_CHANGE_TO_INCLUDE, pGroup->nGroupAddress, nullptr, 0);
+			} else {
+				v3_add_record(IGMP_V3_BLOCK_OLD_SOURCES, pGroup->nGroupAddress, pGroup->nSourceAddress, pGroup->nSources);
+			}
 		}
 	}
 
+	v3_flush();
+
+	memset(s_pGroups, 0, (s_nTableMask + 1) * sizeof(struct t_group_info));
+	s_nGroups = 0;
+	s_nDelaying = 0;
+	s_nChanging = 0;
+	s_nGeneralTimer = 0;
+
+	filter_reset();
+
 	DEBUG_EXIT
 }
 
@@ -159,9 +621,7 @@ static void _send_report(const uint32_t nGroupAddress) {
 
 	multicast_ip.u32 = nGroupAddress;
 
-	s_multicast_mac[3] = multicast_ip.u8[1] & 0x7F;
-	s_multicast_mac[4] = multicast_ip.u8[2];
-	s_multicast_mac[5] = multicast_ip.u8[3];
+	multicast_mac(nGroupAddress, s_multicast_mac);
 
 	DEBUG_PRINTF(IPSTR " " MACSTR, IP2STR(nGroupAddress),MAC2STR(s_multicast_mac));
 
@@ -170,12 +630,14 @@ static void _send_report(const uint32_t nGroupAddress) {
 	// IPv4
 	s_report.ip4.id = s_id;
 	memcpy(s_report.ip4.dst, multicast_ip.u8, IPv4_ADDR_LEN);
+#if defined (CHECKSUM_BY_HARDWARE)
 	s_report.ip4.chksum = 0;
-	s_report.ip4.chksum = net_chksum(reinterpret_cast<void *>(&s_report.ip4), 24); //TODO
+#else
+	s_report.ip4.chksum = net_chksum_fold(net_chksum_add32(s_nReportIp4Sum + s_id, nGroupAddress));
+#endif
 	// IGMP
 	memcpy(s_report.igmp.report.igmp.group_address, multicast_ip.u8, IPv4_ADDR_LEN);
-	s_report.igmp.report.igmp.checksum = 0;
-	s_report.igmp.report.igmp.checksum = net_chksum(reinterpret_cast<void *>(&s_report.ip4), IPv4_IGMP_REPORT_HEADERS_SIZE);
+	s_report.igmp.report.igmp.checksum = net_chksum_fold(net_chksum_add32(s_nReportIgmpSum, nGroupAddress));
 
 	emac_eth_send(reinterpret_cast<void *>(&s_report), IGMP_REPORT_PACKET_SIZE);
 
@@ -194,16 +656,14 @@ static void _send_leave(const uint32_t nGroupAddress) {
 
 	// IPv4
 	s_leave.ip4.id = s_id;
+#if defined (CHECKSUM_BY_HARDWARE)
 	s_leave.ip4.chksum = 0;
-#if !defined (CHECKSUM_BY_HARDWARE)
-	s_leave.ip4.chksum = net_chksum(reinterpret_cast<void *>(&s_leave.ip4), 24); //TODO
+#else
+	s_leave.ip4.chksum = net_chksum_fold(s_nLeaveIp4Sum + s_id);
 #endif
-	// IGMP
+	// IGMP, there is no hardware offload
 	memcpy(s_leave.igmp.report.igmp.group_address, multicast_ip.u8, IPv4_ADDR_LEN);
-	s_leave.igmp.report.igmp.checksum = 0;
-#if !defined (CHECKSUM_BY_HARDWARE)
-	s_leave.igmp.report.igmp.checksum = net_chksum(reinterpret_cast<void *>(&s_leave.ip4), IPv4_IGMP_REPORT_HEADERS_SIZE);
-#endif
+	s_leave.igmp.report.igmp.checksum = net_chksum_fold(net_chksum_add32(s_nLeaveIgmpSum, nGroupAddress));
 
 	emac_eth_send(reinterpret_cast<void *>(&s_leave), IGMP_REPORT_PACKET_SIZE);
 
@@ -212,116 +672,320 @@ static void _send_leave(const uint32_t nGroupAddress) {
 	DEBUG_EXIT
 }
 
+/**
+ * RFC 3376 4.1.1 Maximum Response Code
+ */
+static uint32_t max_response_time(const uint8_t nMaxResponseCode) {
+	if (nMaxResponseCode < 128) {
+		return nMaxResponseCode;
+	}
+
+	const uint32_t nMantissa = nMaxResponseCode & 0x0F;
+	const uint32_t nExponent = (nMaxResponseCode >> 4) & 0x07;
+
+	return (nMantissa | 0x10) << (nExponent + 3);
+}
+
 __attribute__((hot)) void igmp_handle(struct t_igmp *p_igmp) {
 	DEBUG_ENTRY
 
-	if ((p_igmp->ip4.ver_ihl == 0x45) && (p_igmp->igmp.igmp.type == IGMP_TYPE_QUERY)) {
-		DEBUG_PRINTF(IPSTR, p_igmp->ip4.dst[0], p_igmp->ip4.dst[1], p_igmp->ip4.dst[2], p_igmp->ip4.dst[3]);
+	const auto nHeaderLength = static_cast<uint32_t>(p_igmp->ip4.ver_ihl & 0x0F) * 4U;
+	const auto nLength = static_cast<uint32_t>(__builtin_bswap16(p_igmp->ip4.len)) - nHeaderLength;
+	const auto *pQuery = reinterpret_cast<const struct t_igmp_v3_query *>(reinterpret_cast<const uint8_t *>(&p_igmp->ip4) + nHeaderLength);
 
-		auto isGeneralRequest = false;
+	if ((pQuery->type != IGMP_TYPE_QUERY) || (s_pGroups == nullptr)) {
+		DEBUG_EXIT
+		return;
+	}
 
-		_pcast32 igmp_generic_address;
-		igmp_generic_address.u32 = 0x010000e0;
+	DEBUG_PRINTF(IPSTR, p_igmp->ip4.dst[0], p_igmp->ip4.dst[1], p_igmp->ip4.dst[2], p_igmp->ip4.dst[3]);
 
-		if (memcmp(p_igmp->ip4.dst, igmp_generic_address.u8, 4) == 0) {
-			isGeneralRequest = true;
+	uint32_t nGroupAddress;
+	memcpy(&nGroupAddress, pQuery->group_address, IPv4_ADDR_LEN);
+
+	uint32_t nMaxResponseTime;
+
+	if (nLength >= sizeof(struct t_igmp_v3_query)) {
+		nMaxResponseTime = max_response_time(pQuery->max_resp_code);
+	} else if (nLength == sizeof(struct t_igmp_packet)) {
+		if (pQuery->max_resp_code == 0) {
+			nMaxResponseTime = igmp::V1_MAX_RESPONSE_TIME;
+		} else {
+			nMaxResponseTime = pQuery->max_resp_code;
 		}
 
-		for (auto& group : s_groups) {
-			if (group.nGroupAddress == 0) {
-				continue;
-			}
+		s_nV2QuerierTimer = igmp::OLDER_VERSION_QUERIER_TIMEOUT;
+	} else {
+		DEBUG_EXIT
+		return;
+	}
 
-			_pcast32 group_address;
-			group_address.u32 = group.nGroupAddress;
-
-			if (isGeneralRequest || ( memcmp(p_igmp->ip4.dst, group_address.u8, IPv4_ADDR_LEN) == 0)) {
-				if (group.state == DELAYING_MEMBER) {
-					if (p_igmp->igmp.igmp.max_resp_time  < group.nTimer) {
-						group.nTimer = (1 + p_igmp->igmp.igmp.max_resp_time / 2);
-					}
-				} else { // s_groups[s_joins_allowed_index].state == IDLE_MEMBER
-					group.state = DELAYING_MEMBER;
-					group.nTimer = (1 + p_igmp->igmp.igmp.max_resp_time / 2);
-				}
+	const auto isGeneralQuery = (nGroupAddress == 0);
+
+	if (isGeneralQuery && (s_nV2QuerierTimer == 0)) {
+		// One report with the current state of all groups
+		const auto nTimer = response_delay(0, nMaxResponseTime);
+
+		if ((s_nGeneralTimer == 0) || (nTimer < s_nGeneralTimer)) {
+			s_nGeneralTimer = nTimer;
+		}
+
+		DEBUG_EXIT
+		return;
+	}
+
+	if (isGeneralQuery) {
+		for (uint32_t i = 0; i <= s_nTableMask; i++) {
+			auto *pGroup = &s_pGroups[i];
+
+			if (pGroup->nGroupAddress != 0) {
+				group_delay(pGroup, response_delay(pGroup->nGroupAddress, nMaxResponseTime));
 			}
 		}
+
+		DEBUG_EXIT
+		return;
+	}
+
+	// Group-Specific Query, a Group-and-Source-Specific Query is answered with the group state
+	auto *pGroup = group_find(nGroupAddress);
+
+	if (pGroup != nullptr) {
+		group_delay(pGroup, response_delay(nGroupAddress, nMaxResponseTime));
 	}
 
 	DEBUG_EXIT
 }
 
 void igmp_timer() {
-	for (auto& group : s_groups) {
-		if ((group.state == DELAYING_MEMBER) && (group.nTimer > 0)) {
-			group.nTimer--;
+	if (s_nV2QuerierTimer != 0) {
+		s_nV2QuerierTimer--;
+	}
 
-			if (group.nTimer == 0) {
-				_send_report(group.nGroupAddress);
-				group.state = IDLE_MEMBER;
+	if (s_nGeneralTimer != 0) {
+		s_nGeneralTimer--;
+
+		if (s_nGeneralTimer == 0) {
+			for (uint32_t i = 0; i <= s_nTableMask; i++) {
+				if (s_pGroups[i].nGroupAddress != 0) {
+					v3_add_current_state(&s_pGroups[i]);
+				}
 			}
+
+			v3_flush();
 		}
 	}
-}
 
-// --> Public
+	if (__builtin_expect(((s_nDelaying | s_nChanging) == 0), 1)) {
+		return;
+	}
 
-void igmp_join(uint32_t nGroupAddress) {
-	DEBUG_ENTRY
-	DEBUG_PRINTF(IPSTR, IP2STR(nGroupAddress));
+	for (uint32_t i = 0; i <= s_nTableMask; i++) {
+		auto *pGroup = &s_pGroups[i];
 
-	if ((nGroupAddress & 0xE0) != 0xE0) {
-		DEBUG_ENTRY
+		if ((pGroup->nRetransmissions != 0) && (--pGroup->nChangeTimer == 0)) {
+			if (s_nV2QuerierTimer != 0) {
+				_send_report(pGroup->nGroupAddress);
+			} else {
+				v3_add_change(pGroup);
+			}
+
+			if (--pGroup->nRetransmissions != 0) {
+				pGroup->nChangeTimer = igmp::JOIN_TIMER;
+			} else {
+				s_nChanging--;
+			}
+		}
+
+		if ((pGroup->state == DELAYING_MEMBER) && (--pGroup->nTimer == 0)) {
+			pGroup->state = IDLE_MEMBER;
+			s_nDelaying--;
+
+			if (s_nV2QuerierTimer != 0) {
+				_send_report(pGroup->nGroupAddress);
+			} else {
+				v3_add_current_state(pGroup);
+			}
+		}
+
+		if ((s_nDelaying | s_nChanging) == 0) {
+			break;
+		}
+	}
+
+	v3_flush();
+}
+
+static void join(const uint32_t nGroupAddress, const uint32_t nSourceAddress) {
+	if (((nGroupAddress & 0xE0) != 0xE0) || (s_pGroups == nullptr)) {
 		return;
 	}
 
-	for (int i = 0; i < IGMP_MAX_JOINS_ALLOWED; i++) {
-		if (s_groups[i].nGroupAddress == nGroupAddress) {
-			DEBUG_EXIT
+	auto *pGroup = group_find(nGroupAddress);
+
+	if (pGroup == nullptr) {
+		pGroup = group_insert(nGroupAddress);
+
+		if (pGroup == nullptr) {
+#ifndef NDEBUG
+			console_error("igmp_join\n");
+#endif
 			return;
 		}
 
-		if (s_groups[i].nGroupAddress == 0) {
-			s_groups[i].nGroupAddress = nGroupAddress;
-			s_groups[i].state = DELAYING_MEMBER;
-			s_groups[i].nTimer = 2; // TODO
+		filter_add(nGroupAddress);
 
-			_send_report(nGroupAddress);
+		if (nSourceAddress == 0) {
+			send_state_change(IGMP_V3_CHANGE_TO_EXCLUDE, nGroupAddress, nullptr, 0, false);
+			group_change(pGroup, IGMP_V3_CHANGE_TO_EXCLUDE);
+		} else {
+			pGroup->nSourceAddress[0] = nSourceAddress;
+			pGroup->nSources = 1;
+			send_state_change(IGMP_V3_ALLOW_NEW_SOURCES, nGroupAddress, &nSourceAddress, 1, false);
+			group_change(pGroup, IGMP_V3_ALLOW_NEW_SOURCES);
+		}
 
-			DEBUG_EXIT
+		return;
+	}
+
+	// Any source is a superset of the source specific joins
+	if (pGroup->nSources == 0) {
+		return;
+	}
+
+	if (nSourceAddress == 0) {
+		pGroup->nSources = 0;
+		send_state_change(IGMP_V3_CHANGE_TO_EXCLUDE, nGroupAddress, nullptr, 0, false);
+		group_change(pGroup, IGMP_V3_CHANGE_TO_EXCLUDE);
+		return;
+	}
+
+	for (uint32_t i = 0; i < pGroup->nSources; i++) {
+		if (pGroup->nSourceAddress[i] == nSourceAddress) {
 			return;
 		}
 	}
 
+	if (pGroup->nSources == igmp::MAX_SOURCES) {
+#ifndef NDEBUG
+		console_error("igmp_join_source\n");
+#endif
+		return;
+	}
+
+	pGroup->nSourceAddress[pGroup->nSources++] = nSourceAddress;
+
+	send_state_change(IGMP_V3_ALLOW_NEW_SOURCES, nGroupAddress, &nSourceAddress, 1, false);
+	group_change(pGroup, IGMP_V3_ALLOW_NEW_SOURCES);
+}
+
+static void leave(const uint32_t nGroupAddress, const uint32_t nSourceAddress) {
+	auto *pGroup = (s_pGroups == nullptr) ? nullptr : group_find(nGroupAddress);
 
+	if (pGroup == nullptr) {
 #ifndef NDEBUG
-	console_error("igmp_join\n");
+		console_error("igmp_leave: ");
+		printf(IPSTR "\n", IP2STR(nGroupAddress));
 #endif
+		return;
+	}
+
+	if (nSourceAddress != 0) {
+		// The any source join is not changed
+		if (pGroup->nSources == 0) {
+			return;
+		}
+
+		uint32_t i;
+
+		for (i = 0; i < pGroup->nSources; i++) {
+			if (pGroup->nSourceAddress[i] == nSourceAddress) {
+				break;
+			}
+		}
+
+		if (i == pGroup->nSources) {
+			return;
+		}
+
+		pGroup->nSources--;
+		pGroup->nSourceAddress[i] = pGroup->nSourceAddress[pGroup->nSources];
+
+		send_state_change(IGMP_V3_BLOCK_OLD_SOURCES, nGroupAddress, &nSourceAddress, 1, pGroup->nSources == 0);
+
+		if (pGroup->nSources != 0) {
+			return;
+		}
+	} else if (pGroup->nSources == 0) {
+		send_state_change(IGMP_V3_CHANGE_TO_INCLUDE, nGroupAddress, nullptr, 0, true);
+	} else {
+		send_state_change(IGMP_V3_BLOCK_OLD_SOURCES, nGroupAddress, pGroup->nSourceAddress, pGroup->nSources, true);
+	}
+
+	group_remove(pGroup);
+	filter_remove(nGroupAddress);
+}
+
+// --> Public
+
+void igmp_join(uint32_t nGroupAddress) {
 	DEBUG_ENTRY
+	DEBUG_PRINTF(IPSTR, IP2STR(nGroupAddress));
+
+	join(nGroupAddress, 0);
+
+	DEBUG_EXIT
 }
 
 void igmp_leave(uint32_t nGroupAddress) {
 	DEBUG_ENTRY
 	DEBUG_PRINTF(IPSTR, IP2STR(nGroupAddress));
 
-	for (auto& group : s_groups) {
-		if (group.nGroupAddress == nGroupAddress) {
-			_send_leave(group.nGroupAddress);
+	leave(nGroupAddress, 0);
 
-			group.nGroupAddress = 0;
-			group.state = NON_MEMBER;
-			group.nTimer = 0;
+	DEBUG_EXIT
+}
 
-			DEBUG_EXIT
-			return;
+void igmp_join_source(uint32_t nGroupAddress, uint32_t nSourceAddress) {
+	DEBUG_ENTRY
+	DEBUG_PRINTF(IPSTR " " IPSTR, IP2STR(nGroupAddress), IP2STR(nSourceAddress));
+
+	join(nGroupAddress, nSourceAddress);
+
+	DEBUG_EXIT
+}
+
+void igmp_leave_source(uint32_t nGroupAddress, uint32_t nSourceAddress) {
+	DEBUG_ENTRY
+	DEBUG_PRINTF(IPSTR " " IPSTR, IP2STR(nGroupAddress), IP2STR(nSourceAddress));
+
+	leave(nGroupAddress, nSourceAddress);
+
+	DEBUG_EXIT
+}
+
+__attribute__((hot)) bool igmp_is_member(uint32_t nGroupAddress, uint32_t nSourceAddress) {
+	if (__builtin_expect((s_pGroups == nullptr), 0)) {
+		return false;
+	}
+
+	const auto *pGroup = group_find(nGroupAddress);
+
+	if (pGroup == nullptr) {
+		return false;
+	}
+
+	if (pGroup->nSources == 0) {
+		return true;
+	}
+
+	for (uint32_t i = 0; i < pGroup->nSources; i++) {
+		if (pGroup->nSourceAddress[i] == nSourceAddress) {
+			return true;
 		}
 	}
 
-#ifndef NDEBUG
-	console_error("igmp_leave: ");
-	printf(IPSTR "\n", IP2STR(nGroupAddress));
-#endif
-	DEBUG_EXIT
+	return false;
 }
 
 // <---
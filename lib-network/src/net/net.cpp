@@ -44,6 +44,7 @@ uint8_t macAddress[ETH_ADDR_LEN]  ALIGNED;
 
 static uint8_t *s_p;
 static bool s_isDhcp = false;
+static struct IpInfo *s_pIpInfo;
 
 static void refresh_and_init(struct IpInfo *pIpInfo, bool doInit) {
 	net::globals::ipInfo.broadcast_ip.addr = net::globals::ipInfo.ip.addr | ~net::globals::ipInfo.netmask.addr;
@@ -62,13 +63,36 @@ static void refresh_and_init(struct IpInfo *pIpInfo, bool doInit) {
 	memcpy(pDst, pSrc, sizeof(struct IpInfo));
 }
 
+static void probe_and_announce() {
+	if (!arp_do_probe()) {
+		DEBUG_PRINTF(IPSTR " " MACSTR, IP2STR(net::globals::ipInfo.ip.addr), MAC2STR(net::globals::macAddress));
+		arp_send_announcement();
+	} else {
+		console_error("IP Conflict!\n");
+	}
+}
+
+/**
+ * While the DHCP client has no lease, the source address is 0.0.0.0
+ */
+static void set_no_ip() {
+	net::globals::ipInfo.ip.addr = 0;
+	net::globals::ipInfo.netmask.addr = 0;
+	net::globals::ipInfo.gw.addr = 0;
+}
+
 void set_secondary_ip() {
 	net::globals::ipInfo.ip.addr = net::globals::ipInfo.secondary_ip.addr;
 	net::globals::ipInfo.netmask.addr = 255;
 	net::globals::ipInfo.gw.addr = net::globals::ipInfo.ip.addr;
 }
 
-void __attribute__((cold)) net_init(const uint8_t *const pMacAddress, struct IpInfo *pIpInfo, const char *pHostname, bool *bUseDhcp, bool *isZeroconfUsed) {
+/**
+ * With DHCP the function does not wait for the lease, net::dhcp::handle_event is called
+ * @param pLease The lease of the previous boot, for the INIT-REBOOT. Can be nullptr.
+ * @param nDhcpRetrySeconds The DHCP client retries after the FAILED event, 0 is no retry.
+ */
+void __attribute__((cold)) net_init(const uint8_t *const pMacAddress, struct IpInfo *pIpInfo, const char *pHostname, const bool bUseDhcp, const struct DhcpLease *pLease, const uint32_t nDhcpRetrySeconds) {
 	DEBUG_ENTRY
 
 	memcpy(net::globals::macAddress, pMacAddress, ETH_ADDR_LEN);
@@ -78,13 +102,16 @@ void __attribute__((cold)) net_init(const uint8_t *const pMacAddress, struct IpI
 
 	memcpy(pDst, pSrc, sizeof(struct IpInfo));
 
+	s_pIpInfo = pIpInfo;
+
 	net::globals::ipInfo.secondary_ip.addr = 2
 			+ ((static_cast<uint32_t>(net::globals::macAddress[3])) << 8)
 			+ ((static_cast<uint32_t>(net::globals::macAddress[4])) << 16)
 			+ ((static_cast<uint32_t>(net::globals::macAddress[5])) << 24);
 
-
-	if (net::globals::ipInfo.ip.addr == 0) {
+	if (bUseDhcp) {
+		set_no_ip();
+	} else if (net::globals::ipInfo.ip.addr == 0) {
 		set_secondary_ip();
 	}
 	/*
@@ -92,27 +119,18 @@ void __attribute__((cold)) net_init(const uint8_t *const pMacAddress, struct IpI
 	 */
 	ip_init();
 
-	*isZeroconfUsed = false;
-
-	if (*bUseDhcp) {
-		if (dhcp_client(pHostname) < 0) {
-			*bUseDhcp = false;
-			DEBUG_PUTS("DHCP Client failed");
-			*isZeroconfUsed = rfc3927();
-		}
-	}
-
 	refresh_and_init(pIpInfo, true);
 
-	s_isDhcp = *bUseDhcp;
+	s_isDhcp = bUseDhcp;
 
-	if (!arp_do_probe()) {
-		DEBUG_PRINTF(IPSTR " " MACSTR, IP2STR(net::globals::ipInfo.ip.addr), MAC2STR(net::globals::macAddress));
-		arp_send_announcement();
-	} else {
-		console_error("IP Conflict!\n");
+	if (bUseDhcp) {
+		dhcp_client_start(pHostname, pLease, nDhcpRetrySeconds);
+		DEBUG_EXIT
+		return;
 	}
 
+	probe_and_announce();
+
 	DEBUG_EXIT
 }
 
@@ -133,12 +151,7 @@ void net_set_ip(struct IpInfo *pIpInfo) {
 
 	refresh_and_init(pIpInfo, true);
 
-	if (!arp_do_probe()) {
-		DEBUG_PRINTF(IPSTR " " MACSTR, IP2STR(net::globals::ipInfo.ip.addr), MAC2STR(net::globals::macAddress));
-		arp_send_announcement();
-	} else {
-		console_error("IP Conflict!\n");
-	}
+	probe_and_announce();
 }
 
 void net_set_netmask(struct IpInfo *pIpInfo) {
@@ -153,29 +166,18 @@ void net_set_gw(struct IpInfo *pIpInfo) {
 	ip_set_ip();
 }
 
-bool net_set_dhcp(struct IpInfo *pIpInfo, const char *const pHostname, bool *isZeroconfUsed) {
-	bool isDhcp = false;
-	*isZeroconfUsed = false;
-
-	if (dhcp_client(pHostname) < 0) {
-		DEBUG_PUTS("DHCP Client failed");
-		*isZeroconfUsed = rfc3927();
-	} else {
-		isDhcp = true;
-	}
+/**
+ * The function does not wait for the lease, net::dhcp::handle_event is called
+ */
+void net_set_dhcp(struct IpInfo *pIpInfo, const char *const pHostname, const struct DhcpLease *pLease, const uint32_t nDhcpRetrySeconds) {
+	dhcp_client_stop();
 
+	set_no_ip();
 	refresh_and_init(pIpInfo, true);
 
-	s_isDhcp = isDhcp;
+	s_isDhcp = true;
 
-	if (!arp_do_probe()) {
-		DEBUG_PRINTF(IPSTR " " MACSTR, IP2STR(net::globals::ipInfo.ip.addr), MAC2STR(net::globals::macAddress));
-		arp_send_announcement();
-	} else {
-		console_error("IP Conflict!\n");
-	}
-
-	return isDhcp;
+	dhcp_client_start(pHostname, pLease, nDhcpRetrySeconds);
 }
 
 void net_dhcp_release() {
@@ -183,6 +185,41 @@ void net_dhcp_release() {
 	s_isDhcp = false;
 }
 
+/**
+ * From the DHCP client, the IP address is set before the network is told
+ */
+void net_dhcp_event(const net::dhcp::Event event, const struct DhcpLease *pLease) {
+	DEBUG_ENTRY
+	DEBUG_PRINTF("event=%u", static_cast<uint32_t>(event));
+
+	switch (event) {
+	case net::dhcp::Event::BOUND:
+		net::globals::ipInfo.ip.addr = pLease->nIp;
+		net::globals::ipInfo.netmask.addr = pLease->nNetmask;
+		net::globals::ipInfo.gw.addr = (pLease->nGatewayIp != 0) ? pLease->nGatewayIp : pLease->nIp;
+		refresh_and_init(s_pIpInfo, true);
+		s_isDhcp = true;
+		probe_and_announce();
+		break;
+	case net::dhcp::Event::RENEWED:
+		net::globals::ipInfo.netmask.addr = pLease->nNetmask;
+		net::globals::ipInfo.gw.addr = (pLease->nGatewayIp != 0) ? pLease->nGatewayIp : pLease->nIp;
+		refresh_and_init(s_pIpInfo, false);
+		ip_set_ip();
+		break;
+	case net::dhcp::Event::LOST:
+		set_no_ip();
+		refresh_and_init(s_pIpInfo, true);
+		break;
+	default:
+		break;
+	}
+
+	net::dhcp::handle_event(event, pLease);
+
+	DEBUG_EXIT
+}
+
 bool net_set_zeroconf(struct IpInfo *pIpInfo) {
 	const auto b = rfc3927();
 
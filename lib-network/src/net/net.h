@@ -28,6 +28,8 @@
 
 #include <cstdint>
 
+#include "dhcplease.h"
+
 struct ip_addr {
     uint32_t addr;
 };
@@ -42,10 +44,29 @@ struct IpInfo {
     struct ip_addr secondary_ip;
 };
 
+namespace net {
+namespace dhcp {
+static constexpr uint32_t BOOT_WAIT_MILLIS = 2000;	///< The startup waits for the lease at most
+
+enum class State : uint8_t {
+	OFF, INIT, SELECTING, REQUESTING, INIT_REBOOT, REBOOTING, BOUND, RENEWING, REBINDING
+};
+
+enum class Event : uint8_t {
+	BOUND, RENEWED, LOST, FAILED
+};
+
+/**
+ * Implemented by the network, the IP address is already set
+ */
+void handle_event(const Event event, const struct DhcpLease *pLease);
+}  // namespace dhcp
+}  // namespace net
+
 #define IP_BROADCAST	(0xFFFFFFFF)
 #define HOST_NAME_MAX 	64	/* including a terminating null byte. */
 
-void net_init(const uint8_t *const, struct IpInfo *, const char *, bool *, bool *);
+void net_init(const uint8_t *const, struct IpInfo *, const char *, const bool, const struct DhcpLease *, const uint32_t);
 void net_shutdown();
 void net_handle();
 
@@ -54,7 +75,7 @@ void net_set_netmask(struct IpInfo *);
 void net_set_gw(struct IpInfo *);
 bool net_set_zeroconf(struct IpInfo *);
 
-bool net_set_dhcp(struct IpInfo *, const char *const, bool *);
+void net_set_dhcp(struct IpInfo *, const char *const, const struct DhcpLease *, const uint32_t);
 void net_dhcp_release();
 
 int udp_begin(uint16_t);
@@ -62,12 +83,20 @@ int udp_end(uint16_t);
 uint16_t udp_recv1(int, uint8_t *, uint16_t, uint32_t *, uint16_t *);
 uint16_t udp_recv2(int, const uint8_t **, uint32_t *, uint16_t *);
 int udp_send(int, const uint8_t *, uint16_t, uint32_t, uint16_t);
+int udp_send_queued(int, const uint8_t *, uint16_t, uint32_t, uint16_t);
+void udp_send_flush();
 
 void igmp_join(uint32_t);
 void igmp_leave(uint32_t);
+void igmp_join_source(uint32_t, uint32_t);
+void igmp_leave_source(uint32_t, uint32_t);
 
 int tcp_begin(const uint16_t);
+int tcp_end(const int32_t);
 uint16_t tcp_read(const int32_t, const uint8_t **, uint32_t &);
-void tcp_write(const int32_t, const uint8_t *, uint16_t, const uint32_t);
+uint32_t tcp_write(const int32_t, const uint8_t *, uint16_t, const uint32_t);
+uint32_t tcp_write_space(const int32_t, const uint32_t);
+void tcp_set_nodelay(const int32_t, const uint32_t, const bool);
+void tcp_set_cork(const int32_t, const uint32_t, const bool);
 
 #endif /* NET_H_ */
@@ -24,28 +24,75 @@
  */
 
 #include <cstdint>
+#include <cstring>
 
-#include "net_private.h"
+#include "net_chksum.h"
 
-uint16_t net_chksum(const void *data, uint32_t len) {
-	auto *ptr = reinterpret_cast<const uint16_t *>(data);
-	uint32_t sum = 0;
+/*
+ * The 32-bit words are summed in a 64-bit accumulator, the carries are
+ * folded at the end. The 32-bit sum of two 16-bit words gives the same
+ * one's complement sum as the two 16-bit words.
+ */
+__attribute__((hot)) uint32_t net_chksum_add(const void *pData, uint32_t nLength, uint32_t nSum) {
+	const auto *pByte = reinterpret_cast<const uint8_t *>(pData);
+	uint64_t nSum64 = nSum;
+
+	if ((reinterpret_cast<uintptr_t>(pByte) & 0x1) == 0) {
+		// The IPv4 header is 16-bit aligned, after the 14 bytes Ethernet header
+		if (((reinterpret_cast<uintptr_t>(pByte) & 0x2) != 0) && (nLength >= 2)) {
+			nSum64 += *reinterpret_cast<const uint16_t *>(pByte);
+			pByte += 2;
+			nLength -= 2;
+		}
+
+		const auto *pWord = reinterpret_cast<const uint32_t *>(pByte);
+
+		while (nLength >= 32) {
+			nSum64 += pWord[0];
+			nSum64 += pWord[1];
+			nSum64 += pWord[2];
+			nSum64 += pWord[3];
+			nSum64 += pWord[4];
+			nSum64 += pWord[5];
+			nSum64 += pWord[6];
+			nSum64 += pWord[7];
+			pWord += 8;
+			nLength -= 32;
+		}
+
+		while (nLength >= 4) {
+			nSum64 += *pWord++;
+			nLength -= 4;
+		}
 
-	while (len > 1) {
-		sum += *ptr;
-		ptr++;
-		len -= 2;
+		pByte = reinterpret_cast<const uint8_t *>(pWord);
 	}
 
-	/* Add left-over byte, if any */
-	if (len > 0) {
-		sum += __builtin_bswap16(static_cast<uint16_t>(*(reinterpret_cast<const uint8_t *>(ptr)) << 8));
+	while (nLength >= 2) {
+		uint16_t nWord;
+		memcpy(&nWord, pByte, 2);
+		nSum64 += nWord;
+		pByte += 2;
+		nLength -= 2;
 	}
 
-	/* Fold 32-bit sum into 16 bits */
-	while (sum >> 16) {
-		sum = (sum >> 16) + (sum & 0xFFFF);
+	/* Add left-over byte, if any (little endian) */
+	if (nLength > 0) {
+		nSum64 += *pByte;
 	}
 
-	return static_cast<uint16_t>(~sum);
+	/* Fold 64-bit sum into 16 bits */
+	nSum64 = (nSum64 & 0xFFFFFFFF) + (nSum64 >> 32);
+	nSum64 = (nSum64 & 0xFFFFFFFF) + (nSum64 >> 32);
+
+	auto nSum32 = static_cast<uint32_t>(nSum64);
+
+	nSum32 = (nSum32 & 0xFFFF) + (nSum32 >> 16);
+	nSum32 = (nSum32 & 0xFFFF) + (nSum32 >> 16);
+
+	return nSum32;
+}
+
+uint16_t net_chksum(const void *pData, uint32_t nLength) {
+	return net_chksum_fold(net_chksum_add(pData, nLength, 0));
 }
@@ -0,0 +1,70 @@
+/**
+ * @file net_chksum.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef NET_CHKSUM_H_
+#define NET_CHKSUM_H_
+
+#include <cstdint>
+
+/*
+ * https://www.rfc-editor.org/rfc/rfc1071.html Computing the Internet Checksum
+ * https://www.rfc-editor.org/rfc/rfc1624.html Incremental Update
+ *
+ * The 16-bit words are summed in the byte order of the host, the checksum
+ * is then in network byte order when it is stored in the packet.
+ * The values of the fields are as stored in the packet.
+ */
+
+/**
+ * One's complement sum of the data added to nSum, folded to 16 bits.
+ * A sum can be continued with the next part of the data,
+ * when the length of the previous part is even.
+ */
+uint32_t net_chksum_add(const void *pData, uint32_t nLength, uint32_t nSum);
+
+uint16_t net_chksum(const void *pData, uint32_t nLength);
+
+inline uint16_t net_chksum_fold(uint32_t nSum) {
+	nSum = (nSum & 0xFFFF) + (nSum >> 16);
+	nSum = (nSum & 0xFFFF) + (nSum >> 16);
+	return static_cast<uint16_t>(~nSum);
+}
+
+inline uint32_t net_chksum_add32(const uint32_t nSum, const uint32_t nValue) {
+	return nSum + (nValue & 0xFFFF) + (nValue >> 16);
+}
+
+/**
+ * RFC 1624 eqn. 3: HC' = ~(~HC + ~m + m')
+ */
+inline uint16_t net_chksum_update16(const uint16_t nChecksum, const uint16_t nOld, const uint16_t nNew) {
+	return net_chksum_fold(static_cast<uint32_t>(static_cast<uint16_t>(~nChecksum)) + static_cast<uint16_t>(~nOld) + nNew);
+}
+
+inline uint16_t net_chksum_update32(const uint16_t nChecksum, const uint32_t nOld, const uint32_t nNew) {
+	return net_chksum_fold(net_chksum_add32(net_chksum_add32(static_cast<uint16_t>(~nChecksum), ~nOld), nNew));
+}
+
+#endif /* NET_CHKSUM_H_ */
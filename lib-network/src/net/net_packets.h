@@ -88,7 +88,17 @@ enum ARP_OPCODE {
 enum IGMP_TYPE {
 	IGMP_TYPE_QUERY = 0x11,
 	IGMP_TYPE_REPORT = 0x16,
-	IGMP_TYPE_LEAVE = 0x17
+	IGMP_TYPE_LEAVE = 0x17,
+	IGMP_TYPE_V3_REPORT = 0x22
+};
+
+enum IGMP_V3_RECORD_TYPE {
+	IGMP_V3_MODE_IS_INCLUDE = 1,
+	IGMP_V3_MODE_IS_EXCLUDE = 2,
+	IGMP_V3_CHANGE_TO_INCLUDE = 3,
+	IGMP_V3_CHANGE_TO_EXCLUDE = 4,
+	IGMP_V3_ALLOW_NEW_SOURCES = 5,
+	IGMP_V3_BLOCK_OLD_SOURCES = 6
 };
 
 enum ICMP_TYPE {
@@ -139,6 +149,31 @@ struct t_igmp_packet {
 	uint8_t group_address[IPv4_ADDR_LEN];
 } PACKED;
 
+struct t_igmp_v3_query {
+	uint8_t type;					/*  1 */
+	uint8_t max_resp_code;			/*  2 */
+	uint16_t checksum;				/*  4 */
+	uint8_t group_address[IPv4_ADDR_LEN];	/*  8 */
+	uint8_t s_qrv;					/*  9 */
+	uint8_t qqic;					/* 10 */
+	uint16_t number_of_sources;		/* 12 */
+} PACKED;
+
+struct t_igmp_v3_report {
+	uint8_t type;					/* 1 */
+	uint8_t reserved1;				/* 2 */
+	uint16_t checksum;				/* 4 */
+	uint16_t reserved2;				/* 6 */
+	uint16_t number_of_records;		/* 8 */
+} PACKED;
+
+struct t_igmp_v3_record {
+	uint8_t type;					/* 1 */
+	uint8_t aux_data_len;			/* 2 */
+	uint16_t number_of_sources;		/* 4 */
+	uint8_t multicast_address[IPv4_ADDR_LEN];	/* 8 */
+} PACKED;
+
 struct t_icmp_packet {
 	uint8_t type;					/* 1 */
 	uint8_t code;					/* 2 */
@@ -196,6 +231,15 @@ struct t_igmp {
 	} igmp;
 } PACKED;
 
+struct t_igmp_v3 {
+	struct ether_header ether;
+	struct ip4_header ip4;
+	uint32_t ip4_options;
+	struct t_igmp_v3_report report;
+#define IGMP_V3_RECORDS_SIZE	(MTU_SIZE - sizeof(struct ip4_header) - 4U - sizeof(struct t_igmp_v3_report))
+	uint8_t records[IGMP_V3_RECORDS_SIZE];
+} PACKED;
+
 struct t_icmp {
 	struct ether_header ether;
 	struct ip4_header ip4;
@@ -28,7 +28,9 @@
 
 #include <cstdint>
 
+#include "net.h"
 #include "net_packets.h"
+#include "net_chksum.h"
 #include "net_platform.h"
 #include "net_debug.h"
 
@@ -43,13 +45,17 @@
 extern "C" {
 int console_error(const char *);
 void emac_eth_send(void *, int);
+void emac_eth_send_queued(void *, int);
+void emac_eth_send_flush(void);
 int emac_eth_recv(uint8_t **);
 void emac_free_pkt(void);
+void emac_multicast_hash_set(uint32_t, uint32_t);
 }
 
 void net_handle();
 
-uint16_t net_chksum(const void *, uint32_t);
+uint32_t net_multicast_hash_bin(const uint8_t *pMacAddress);
+
 void net_timers_run();
 
 void arp_init();
@@ -67,8 +73,12 @@ void ip_set_ip();
 void ip_shutdown();
 void ip_handle(struct t_ip4 *);
 
-int dhcp_client(const char *);
+void dhcp_client_start(const char *, const struct DhcpLease *, const uint32_t);
+void dhcp_client_stop();
 void dhcp_client_release();
+void dhcp_client_timer();
+net::dhcp::State dhcp_client_get_state();
+void net_dhcp_event(const net::dhcp::Event, const struct DhcpLease *);
 
 bool rfc3927();
 
@@ -82,12 +92,14 @@ void igmp_set_ip();
 void igmp_handle(struct t_igmp *);
 void igmp_shutdown();
 void igmp_timer();
+bool igmp_is_member(uint32_t, uint32_t);
 
 void icmp_handle(struct t_icmp *);
 void icmp_shutdown();
 
 void tcp_init();
 void tcp_run();
+void tcp_timer();
 void tcp_handle(struct t_tcp *);
 void tcp_shutdown();
 
@@ -45,6 +45,8 @@ void net_timers_run() {
 	if (__builtin_expect((nMillis >= s_ticker), 0)) {
 		s_ticker = nMillis + INTERVAL_MS;
 		igmp_timer();
+		dhcp_client_timer();
+		tcp_timer();
 #ifndef NDEBUG
 		arp_cache_timer();
 #endif
@@ -47,14 +47,42 @@
 
 #include "../config/net_config.h"
 
+/*
+ * The transmission control blocks are a pool shared by the listening ports.
+ * Each connection has a receive ring with TCP_RX_MAX_ENTRIES segments, the
+ * window advertised is the free entries in this ring. Each connection has a
+ * transmit ring of TCP_TX_BUFFER_SIZE bytes, the data is kept until it is
+ * acknowledged.
+ * - Delayed ACK: every second segment, else from the 100 ms timer.
+ * - RFC 6298 retransmission timer, the RTT is measured with one segment at
+ *   a time (Karn). Fast retransmit after 3 duplicate ACKs, less with less
+ *   than 4 segments in flight (RFC 5827). A partial ACK retransmits the next
+ *   segment (RFC 6582).
+ * - One segment out of order is kept: the one right after a single lost
+ *   segment, in the ring entry behind the gap. Later segments are dropped,
+ *   the peer sends these again.
+ * - Nagle, which can be disabled per connection, and cork.
+ */
+
 #define TCP_RX_MSS						(TCP_DATA_SIZE)
-#define TCP_RX_MAX_ENTRIES				(1U << 1) // Must always be a power of 2
 #define TCP_RX_MAX_ENTRIES_MASK			(TCP_RX_MAX_ENTRIES - 1)
-#define TCP_MAX_RX_WND 					(TCP_RX_MAX_ENTRIES * TCP_RX_MSS);
-#define TCP_TX_MSS						(TCP_DATA_SIZE)
+#define TCP_TX_MSS						(TCP_DATA_SIZE - OPTION_TIMESTAMP_SPACE)
+#define TCP_TX_BUFFER_MASK				(TCP_TX_BUFFER_SIZE - 1)
+
+static_assert((TCP_RX_MAX_ENTRIES & TCP_RX_MAX_ENTRIES_MASK) == 0, "TCP_RX_MAX_ENTRIES must be a power of 2");
+static_assert((TCP_TX_BUFFER_SIZE & TCP_TX_BUFFER_MASK) == 0, "TCP_TX_BUFFER_SIZE must be a power of 2");
+static_assert((TCP_RX_MAX_ENTRIES * TCP_RX_MSS) <= 0xFFFF, "There is no window scaling");
 
 namespace net {
 namespace tcp {
+static constexpr uint32_t RTO_INITIAL_MILLIS = 1000;
+static constexpr uint32_t RTO_MIN_MILLIS = 200;
+static constexpr uint32_t RTO_MAX_MILLIS = 60000;
+static constexpr uint32_t TIMER_GRANULARITY_MILLIS = 100;	///< tcp_timer
+static constexpr uint32_t MAX_RETRIES = 8;					///< Then the connection is reset
+static constexpr uint32_t DUP_ACK_THRESHOLD = 3;
+static constexpr uint32_t CORK_MAX_MILLIS = 200;
+static constexpr uint32_t MSS_DEFAULT = 536;				///< RFC 9293 3.7.1
 }  // namespace tcp
 namespace globals {
 extern uint8_t macAddress[ETH_ADDR_LEN];
@@ -91,20 +119,42 @@ struct tcb {
 
 	uint16_t SendMSS;
 
-	struct {
-		uint8_t *data;
-		uint16_t size;
-	} TX;
-
 	/* Receive Sequence Variables */
 	struct {
 		uint32_t NXT; 	/* receive next */
-		uint16_t WND; 	/* receive window */
+		uint16_t WND; 	/* receive window, as last advertised */
 		uint16_t UP; 	/* receive urgent pointer */
 	} RCV;
 
 	uint32_t IRS;		/* initial receive sequence number */
 
+	/* RFC 6298 */
+	struct {
+		uint32_t nSRTT8;		///< Smoothed round-trip time x 8
+		uint32_t nRTTVAR4;		///< Round-trip time variation x 4
+		uint32_t nRTO;
+		uint32_t nTimerMillis;	///< The retransmission timer expires
+		uint32_t nTimedSeq;		///< The segment which is timed
+		uint32_t nTimedMillis;
+		uint32_t nRecover;		///< RFC 6582, SND.NXT at the retransmission
+		bool isTimerRunning;
+		bool isTiming;
+		bool isRecovery;
+		uint8_t nRetries;
+		uint8_t nDupAcks;
+	} RTX;
+
+	uint32_t nWriteSeq;		///< The end of the data in the transmit ring
+	uint32_t nOutOfOrderSeq;	///< The segment kept behind the gap
+	uint16_t nOutOfOrderSize;	///< 0 when there is none
+	uint16_t nReceiveSize;		///< The last segment queued, the size of a free entry in the window
+	uint32_t nCorkMillis;
+	uint8_t nUnackedSegments;
+	bool isAckPending;
+	bool isNoDelay;
+	bool isCorked;
+
+	uint8_t nPort;			///< Index of the listening port
 	uint8_t state;
 };
 
@@ -117,25 +167,39 @@ struct SendInfo {
 struct QueueEntry {
 	uint8_t data[TCP_RX_MSS];
 	uint16_t nSize;
-	uint16_t nHandleConnection;
 };
 
+/**
+ * The entry returned by tcp_read is valid until the next tcp_read
+ */
 struct ReceiveQueue {
 	uint16_t nHead;
 	uint16_t nTail;
 	QueueEntry Entries[TCP_RX_MAX_ENTRIES];
 };
 
+struct TransmitBuffer {
+	uint8_t data[TCP_TX_BUFFER_SIZE];
+};
+
 struct Port {
-	tcb TCB[TCP_MAX_TCBS_ALLOWED];
-	ReceiveQueue receiveQueue;
 	uint16_t nLocalPort;
+	uint16_t nEntries;		///< In the receive rings of the connections
+	uint16_t nReadTCB;		///< Round robin
+	bool isEntryInUse;		///< The entry of nReadTCB which is returned by tcp_read
 };
 
+static struct tcb s_TCB[TCP_MAX_TCBS_ALLOWED] SECTION_NETWORK ALIGNED;
+static struct ReceiveQueue s_ReceiveQueue[TCP_MAX_TCBS_ALLOWED] SECTION_NETWORK ALIGNED;
+static struct TransmitBuffer s_TransmitBuffer[TCP_MAX_TCBS_ALLOWED] SECTION_NETWORK ALIGNED;
 static struct Port s_Port[TCP_MAX_PORTS_ALLOWED] SECTION_NETWORK ALIGNED;
 static uint16_t s_id SECTION_NETWORK ALIGNED;
 static struct t_tcp s_tcp SECTION_NETWORK ALIGNED;
 
+#if defined (TCP_RAM_SIZE_MAX)
+static_assert((sizeof(s_TCB) + sizeof(s_ReceiveQueue) + sizeof(s_TransmitBuffer) + sizeof(s_Port) + sizeof(s_id) + sizeof(s_tcp)) <= TCP_RAM_SIZE_MAX, "The TCP RAM is larger than TCP_RAM_SIZE_MAX");
+#endif
+
 #if !defined (NDEBUG)
 static const char *s_aStateName[] = {
 		"CLOSED",
@@ -202,6 +266,7 @@ enum Option {
 
 static constexpr auto OPTION_MSS_LENGTH = 4U;
 static constexpr auto OPTION_TIMESTAMP_LENGTH = 10U;
+static constexpr auto OPTION_TIMESTAMP_SPACE = 12U;	///< NOP, NOP, Timestamp
 
 /*
  * RFC 793, Page 21
@@ -301,19 +366,48 @@ static void _bswap32(struct t_tcp *p_tcp) {
 	memcpy(&p_tcp->tcp.seqnum, src.u8, 4);
 }
 
-static void _init_tcb(struct tcb *pTcb, const uint16_t nLocalPort) {
+static uint32_t index_of(const struct tcb *pTcb) {
+	return static_cast<uint32_t>(pTcb - s_TCB);
+}
+
+/**
+ * Enter the CLOSED state and delete the TCB
+ */
+static void _close_tcb(struct tcb *pTcb) {
+	const auto nIndex = index_of(pTcb);
+	auto *pQueue = &s_ReceiveQueue[nIndex];
+	auto *pPort = &s_Port[pTcb->nPort];
+
+	pPort->nEntries = static_cast<uint16_t>(pPort->nEntries - static_cast<uint16_t>(pQueue->nHead - pQueue->nTail));
+
+	if (pPort->nReadTCB == nIndex) {
+		pPort->isEntryInUse = false;
+	}
+
+	pQueue->nHead = 0;
+	pQueue->nTail = 0;
+
+	NEW_STATE(pTcb, STATE_CLOSED);
 	memset(pTcb, 0, sizeof(struct tcb));
+}
 
-	pTcb->nLocalPort = nLocalPort;
+static void _listen_tcb(struct tcb *pTcb, const uint32_t nPort) {
+	memset(pTcb, 0, sizeof(struct tcb));
 
-	pTcb->ISS = Hardware::Get()->Millis();
+	pTcb->nPort = static_cast<uint8_t>(nPort);
+	pTcb->nLocalPort = s_Port[nPort].nLocalPort;
 
-	pTcb->RCV.WND = TCP_MAX_RX_WND;
+	pTcb->ISS = Hardware::Get()->Millis();
 
 	pTcb->SND.UNA = pTcb->ISS;
 	pTcb->SND.NXT = pTcb->ISS;
 	pTcb->SND.WL2 = pTcb->ISS;
 
+	pTcb->nWriteSeq = pTcb->ISS + 1;
+	pTcb->SendMSS = net::tcp::MSS_DEFAULT - OPTION_TIMESTAMP_SPACE;
+	pTcb->nReceiveSize = TCP_RX_MSS;
+	pTcb->RTX.nRTO = net::tcp::RTO_INITIAL_MILLIS;
+
 	NEW_STATE(pTcb, STATE_LISTEN);
 }
 
@@ -350,35 +444,31 @@ struct tcpPseudo {
 
 static constexpr auto TCP_PSEUDO_LEN = 12;
 
-static uint16_t _chksum(struct t_tcp *pTcp, const struct tcb *pTcb, uint16_t nLength) {
-	uint8_t buf[TCP_PSEUDO_LEN];
-	uint16_t nSum;
-
-	// Store current data before TCP header in temporary buffer
-	auto *pseu = reinterpret_cast<struct tcpPseudo *>(reinterpret_cast<uint8_t *>(&pTcp->tcp) - TCP_PSEUDO_LEN);
-	memcpy(buf, pseu, TCP_PSEUDO_LEN);
-
-	// Generate TCP psuedo header
-	memcpy(pseu->srcIp, pTcb->localIp, IPv4_ADDR_LEN);
-	memcpy(pseu->dstIp, pTcb->remoteIp, IPv4_ADDR_LEN);
-	pseu->zero = 0;
-	pseu->proto = IPv4_PROTO_TCP;
-	pseu->length = __builtin_bswap16(nLength);
+static uint16_t _chksum(const struct t_tcp *pTcp, const struct tcb *pTcb, uint16_t nLength) {
+	struct tcpPseudo pseu;
 
-	nSum = net_chksum(pseu, static_cast<uint32_t>(nLength + TCP_PSEUDO_LEN));
+	memcpy(pseu.srcIp, pTcb->localIp, IPv4_ADDR_LEN);
+	memcpy(pseu.dstIp, pTcb->remoteIp, IPv4_ADDR_LEN);
+	pseu.zero = 0;
+	pseu.proto = IPv4_PROTO_TCP;
+	pseu.length = __builtin_bswap16(nLength);
 
-	// Restore data before TCP header from temporary buffer
-	memcpy(pseu, buf, TCP_PSEUDO_LEN);
+	// The pseudo header has an even length, the sum continues with the TCP segment
+	const auto nSum = net_chksum_add(&pseu, TCP_PSEUDO_LEN, 0);
 
-	return nSum;
+	return net_chksum_fold(net_chksum_add(&pTcp->tcp, nLength, nSum));
 }
 
-static void send_package(const struct tcb *pTcb, const struct SendInfo &sendInfo) {
+/**
+ * @param nLength The data is in the transmit ring at sendInfo.SEQ
+ */
+static void send_package(const struct tcb *pTcb, const struct SendInfo &sendInfo, const uint32_t nLength = 0) {
 	uint32_t nDataOffset = 5; /*  Data Offset:  4 bits
 	The number of 32 bit words in the TCP Header.  This indicates where
     the data begins.  The TCP header (even one including options) is an
     integral number of 32 bits long. */
 	assert(nDataOffset * 4 == TCP_HEADER_SIZE);
+	assert(nLength <= TCP_TX_MSS);
 
 	if (sendInfo.CTL & Control::SYN) {
 		nDataOffset++;
@@ -387,7 +477,7 @@ static void send_package(const struct tcb *pTcb, const struct SendInfo &sendInfo
 	nDataOffset += 3; // Option::KIND_TIMESTAMP
 
 	const auto nHeaderLength = nDataOffset * 4;
-	const auto tcplen = nHeaderLength + pTcb->TX.size;
+	const auto tcplen = nHeaderLength + nLength;
 
 	/* Ethernet */
 	memcpy(s_tcp.ether.dst, pTcb->remoteEthAddr, ETH_ADDR_LEN);
@@ -431,12 +521,16 @@ static void send_package(const struct tcb *pTcb, const struct SendInfo &sendInfo
 	memcpy(pData, &pTcb->TS.Recent, 4);
 	pData += 4;
 
-	DEBUG_PRINTF("SEQ=%u, ACK=%u, tcplen=%u, data_offset=%u, p_tcb->TX.size=%u", s_tcp.tcp.seqnum, s_tcp.tcp.acknum, tcplen, nDataOffset, pTcb->TX.size);
+	DEBUG_PRINTF("SEQ=%u, ACK=%u, tcplen=%u, data_offset=%u, nLength=%u", s_tcp.tcp.seqnum, s_tcp.tcp.acknum, tcplen, nDataOffset, nLength);
 
-	if (pTcb->TX.data != nullptr) {
-		for (auto i = 0; i < pTcb->TX.size; i++) {
-			*pData++ = pTcb->TX.data[i];
-		}
+	if (nLength != 0) {
+		// The transmit ring is indexed with the sequence number
+		const auto *pBuffer = s_TransmitBuffer[index_of(pTcb)].data;
+		const auto nOffset = sendInfo.SEQ & TCP_TX_BUFFER_MASK;
+		const auto nFirst = std::min(nLength, TCP_TX_BUFFER_SIZE - nOffset);
+
+		memcpy(pData, &pBuffer[nOffset], nFirst);
+		memcpy(pData + nFirst, pBuffer, nLength - nFirst);
 	}
 
 	s_tcp.tcp.srcpt = __builtin_bswap16(s_tcp.tcp.srcpt);
@@ -450,6 +544,220 @@ static void send_package(const struct tcb *pTcb, const struct SendInfo &sendInfo
 	emac_eth_send(reinterpret_cast<void *>(&s_tcp), static_cast<int>(tcplen + sizeof(struct ip4_header) + sizeof(struct ether_header)));
 }
 
+/**
+ * The window is the free entries in the receive ring. An entry holds one
+ * segment whatever its size, so a free entry counts as the last segment
+ * queued: a peer sending short segments is offered no more segments than
+ * there are free entries.
+ */
+static uint16_t receive_window(const struct tcb *pTcb) {
+	const auto *pQueue = &s_ReceiveQueue[index_of(pTcb)];
+	const auto nUsed = static_cast<uint16_t>(pQueue->nHead - pQueue->nTail);
+
+	return static_cast<uint16_t>((TCP_RX_MAX_ENTRIES - nUsed) * pTcb->nReceiveSize);
+}
+
+/**
+ * Every segment of a connection carries the ACK and the window
+ */
+static void send_segment(struct tcb *pTcb, const struct SendInfo &sendInfo, const uint32_t nLength = 0) {
+	pTcb->RCV.WND = receive_window(pTcb);
+	pTcb->isAckPending = false;
+	pTcb->nUnackedSegments = 0;
+
+	send_package(pTcb, sendInfo, nLength);
+}
+
+static void send_ack(struct tcb *pTcb) {
+	struct SendInfo info;
+	info.SEQ = pTcb->SND.NXT;
+	info.ACK = pTcb->RCV.NXT;
+	info.CTL = Control::ACK;
+
+	send_segment(pTcb, info);
+}
+
+/**
+ * RFC 5681 2, the window is as last advertised: else the peer does not count the duplicate ACK
+ */
+static void send_dup_ack(struct tcb *pTcb) {
+	struct SendInfo info;
+	info.SEQ = pTcb->SND.NXT;
+	info.ACK = pTcb->RCV.NXT;
+	info.CTL = Control::ACK;
+
+	pTcb->isAckPending = false;
+	pTcb->nUnackedSegments = 0;
+
+	send_package(pTcb, info, 0);
+}
+
+static void start_timer(struct tcb *pTcb, const uint32_t nMillis) {
+	pTcb->RTX.isTimerRunning = true;
+	pTcb->RTX.nTimerMillis = nMillis + pTcb->RTX.nRTO;
+}
+
+/**
+ * https://www.rfc-editor.org/rfc/rfc6298#section-2
+ */
+static void rtt_update(struct tcb *pTcb, const uint32_t nRTT) {
+	auto& rtx = pTcb->RTX;
+
+	if ((rtx.nSRTT8 == 0) && (rtx.nRTTVAR4 == 0)) {
+		rtx.nSRTT8 = nRTT << 3;
+		rtx.nRTTVAR4 = nRTT << 1;
+	} else {
+		const auto nDelta = static_cast<int32_t>(nRTT) - static_cast<int32_t>(rtx.nSRTT8 >> 3);
+		rtx.nSRTT8 = static_cast<uint32_t>(static_cast<int32_t>(rtx.nSRTT8) + nDelta);
+		const auto nAbsDelta = static_cast<uint32_t>(nDelta < 0 ? -nDelta : nDelta);
+		rtx.nRTTVAR4 = rtx.nRTTVAR4 + nAbsDelta - (rtx.nRTTVAR4 >> 2);
+	}
+
+	auto nRTO = (rtx.nSRTT8 >> 3) + std::max(net::tcp::TIMER_GRANULARITY_MILLIS, rtx.nRTTVAR4);
+	rtx.nRTO = std::min(std::max(nRTO, net::tcp::RTO_MIN_MILLIS), net::tcp::RTO_MAX_MILLIS);
+
+	DEBUG_PRINTF("RTT=%u, SRTT=%u, RTO=%u", nRTT, rtx.nSRTT8 >> 3, rtx.nRTO);
+}
+
+/**
+ * There is data in the receive ring, or the application has the last entry
+ */
+static bool is_receive_pending(const struct tcb *pTcb) {
+	const auto nIndex = index_of(pTcb);
+	const auto *pQueue = &s_ReceiveQueue[nIndex];
+	const auto *pPort = &s_Port[pTcb->nPort];
+
+	return (pQueue->nHead != pQueue->nTail) || (pPort->isEntryInUse && (pPort->nReadTCB == nIndex));
+}
+
+static bool is_sending(const struct tcb *pTcb) {
+	return (pTcb->state == STATE_ESTABLISHED) || (pTcb->state == STATE_CLOSE_WAIT);
+}
+
+/**
+ * The data in the transmit ring, as far as the send window allows.
+ * A segment which is not full waits for the uncork, and with Nagle for
+ * the ACK of the data in flight.
+ */
+static void send_data(struct tcb *pTcb, const bool isForced) {
+	if (!is_sending(pTcb)) {
+		return;
+	}
+
+	const auto nMillis = Hardware::Get()->Millis();
+
+	for (;;) {
+		const auto nInFlight = pTcb->SND.NXT - pTcb->SND.UNA;
+		const auto nUnsent = pTcb->nWriteSeq - pTcb->SND.NXT;
+
+		if (nUnsent == 0) {
+			return;
+		}
+
+		// A zero window is probed by tcp_timer
+		const auto nWindow = (pTcb->SND.WND > nInFlight) ? pTcb->SND.WND - nInFlight : 0;
+		const auto nLength = std::min(std::min(nUnsent, static_cast<uint32_t>(pTcb->SendMSS)), nWindow);
+
+		if (nLength == 0) {
+			return;
+		}
+
+		if ((nLength < pTcb->SendMSS) && !isForced) {
+			if (pTcb->isCorked) {
+				return;
+			}
+
+			// RFC 896
+			if (!pTcb->isNoDelay && (nInFlight != 0)) {
+				return;
+			}
+		}
+
+		struct SendInfo info;
+		info.SEQ = pTcb->SND.NXT;
+		info.ACK = pTcb->RCV.NXT;
+		info.CTL = static_cast<uint8_t>(Control::ACK | ((nLength == nUnsent) ? Control::PSH : 0));
+
+		send_segment(pTcb, info, nLength);
+
+		pTcb->SND.NXT += nLength;
+
+		if (!pTcb->RTX.isTiming) {
+			pTcb->RTX.isTiming = true;
+			pTcb->RTX.nTimedSeq = pTcb->SND.NXT;
+			pTcb->RTX.nTimedMillis = nMillis;
+		}
+
+		if (!pTcb->RTX.isTimerRunning) {
+			start_timer(pTcb, nMillis);
+		}
+	}
+}
+
+/**
+ * The first segment which is not acknowledged, the SYN, or the FIN.
+ * Without data in flight and a zero window: one byte, the window probe.
+ */
+static void retransmit(struct tcb *pTcb) {
+	struct SendInfo info;
+	info.ACK = pTcb->RCV.NXT;
+
+	// Karn: a retransmitted segment is not timed
+	pTcb->RTX.isTiming = false;
+
+	if (pTcb->state == STATE_SYN_RECEIVED) {
+		info.SEQ = pTcb->ISS;
+		info.CTL = Control::SYN | Control::ACK;
+		send_segment(pTcb, info);
+		return;
+	}
+
+	const auto nInFlight = pTcb->SND.NXT - pTcb->SND.UNA;
+	const auto nDataInFlight = SEQ_LT(pTcb->SND.UNA, pTcb->nWriteSeq) ? std::min(nInFlight, pTcb->nWriteSeq - pTcb->SND.UNA) : 0;
+
+	info.SEQ = pTcb->SND.UNA;
+
+	if (nDataInFlight != 0) {
+		info.CTL = Control::ACK | Control::PSH;
+		send_segment(pTcb, info, std::min(nDataInFlight, static_cast<uint32_t>(pTcb->SendMSS)));
+		return;
+	}
+
+	if (nInFlight != 0) {
+		// The FIN is after the data
+		info.CTL = Control::FIN | Control::ACK;
+		send_segment(pTcb, info);
+		return;
+	}
+
+	if ((pTcb->nWriteSeq != pTcb->SND.NXT) && is_sending(pTcb)) {
+		info.CTL = Control::ACK;
+		send_segment(pTcb, info, 1);
+		pTcb->SND.NXT++;
+	}
+}
+
+/**
+ * RFC 5827 Early Retransmit, the small transmit ring gives less than 4 segments in flight
+ */
+static uint32_t dup_ack_threshold(const struct tcb *pTcb) {
+	const auto nSegments = (pTcb->SND.NXT - pTcb->SND.UNA + pTcb->SendMSS - 1U) / pTcb->SendMSS;
+
+	if (nSegments > net::tcp::DUP_ACK_THRESHOLD) {
+		return net::tcp::DUP_ACK_THRESHOLD;
+	}
+
+	return (nSegments > 1) ? nSegments - 1 : 1;
+}
+
+/**
+ * The segments sent before the retransmission are recovered one per round-trip
+ */
+static void start_recovery(struct tcb *pTcb) {
+	pTcb->RTX.isRecovery = true;
+	pTcb->RTX.nRecover = pTcb->SND.NXT;
+}
+
 static void send_reset(struct t_tcp *pTcp, const struct tcb *pTcb) {
 	DEBUG_ENTRY
 
@@ -495,7 +803,11 @@ static void scan_options(struct t_tcp *pTcp, struct tcb *pTcb, const int32_t nDa
 
 	auto *pOptions = reinterpret_cast<struct Options *>(pTcp->tcp.data);
 
-	while (reinterpret_cast<uint8_t *>(pOptions + 2) <= pTcpHeaderEnd) {
+	while (reinterpret_cast<uint8_t *>(pOptions) < pTcpHeaderEnd) {
+		if ((pOptions->nKind > Option::KIND_NOP) && (((reinterpret_cast<uint8_t *>(pOptions) + 2) > pTcpHeaderEnd) || (pOptions->nLength < 2))) {
+			return;	// Malformed
+		}
+
 		switch (pOptions->nKind) {
 		case Option::KIND_END:
 			return;
@@ -506,10 +818,11 @@ static void scan_options(struct t_tcp *pTcp, struct tcb *pTcb, const int32_t nDa
 		case Option::KIND_MSS:
 			if ((pOptions->nLength == OPTION_MSS_LENGTH) && ((reinterpret_cast<uint8_t *>(pOptions) + OPTION_MSS_LENGTH) <= pTcpHeaderEnd)) {
 				const auto *p = &pOptions->Data;
-				auto nMSS = (p[0] << 8) + p[1];
-				// RFC 1122 section 4.2.2.6
-				nMSS = std::min(static_cast<int32_t>(nMSS + 20), static_cast<int32_t>(TCP_TX_MSS)) - TCP_HEADER_SIZE; // - IP_OPTION_SIZE;
-				pTcb->SendMSS = static_cast<uint16_t>(nMSS);
+				const auto nMSS = static_cast<uint32_t>((p[0] << 8) + p[1]);
+				// RFC 1122 section 4.2.2.6, the timestamp option is in every segment
+				if (nMSS > (OPTION_TIMESTAMP_SPACE + 64)) {
+					pTcb->SendMSS = static_cast<uint16_t>(std::min(nMSS - OPTION_TIMESTAMP_SPACE, static_cast<uint32_t>(TCP_TX_MSS)));
+				}
 			}
 			pOptions = reinterpret_cast<struct Options *>(reinterpret_cast<uint8_t *>(pOptions) + pOptions->nLength);
 			break;
@@ -543,27 +856,220 @@ static void scan_options(struct t_tcp *pTcp, struct tcb *pTcb, const int32_t nDa
 	}
 }
 
+/**
+ * The peer has closed. The FIN is sent after all the data, and when the
+ * application has read all the data.
+ */
+static void send_fin(struct tcb *pTCB) {
+	if ((pTCB->state != STATE_CLOSE_WAIT) || (pTCB->nWriteSeq != pTCB->SND.NXT) || is_receive_pending(pTCB)) {
+		return;
+	}
+
+	struct SendInfo info;
+	info.SEQ = pTCB->SND.NXT;
+	info.ACK = pTCB->RCV.NXT;
+	info.CTL = Control::FIN | Control::ACK;
+
+	send_segment(pTCB, info);
+
+	NEW_STATE(pTCB, STATE_LAST_ACK);
+
+	pTCB->SND.NXT++;
+
+	if (!pTCB->RTX.isTimerRunning) {
+		start_timer(pTCB, Hardware::Get()->Millis());
+	}
+}
+
 __attribute__((hot)) void tcp_run() {
-	for (auto nIndexPort = 0; nIndexPort < TCP_MAX_PORTS_ALLOWED; nIndexPort++) {
-		for (auto nIndexTCB = 0; nIndexTCB < TCP_MAX_TCBS_ALLOWED; nIndexTCB++) {
-			auto *pTCB = &s_Port[nIndexPort].TCB[nIndexTCB];
+	for (uint32_t nIndexTCB = 0; nIndexTCB < TCP_MAX_TCBS_ALLOWED; nIndexTCB++) {
+		auto *pTCB = &s_TCB[nIndexTCB];
 
-			if (pTCB->state == STATE_CLOSE_WAIT) {
-				struct SendInfo info;
-				info.SEQ = pTCB->SND.NXT;
-				info.ACK = pTCB->RCV.NXT;
-				info.CTL = Control::FIN | Control::ACK;
+		if (pTCB->state == STATE_CLOSED) {
+			continue;
+		}
 
-				send_package(pTCB, info);
+		send_data(pTCB, false);
 
-				NEW_STATE(pTCB, STATE_LAST_ACK);
+		send_fin(pTCB);
+	}
+}
 
-				pTCB->SND.NXT++;
-			}
+/**
+ * From net_timers_run, every 100 ms
+ */
+void tcp_timer() {
+	const auto nMillis = Hardware::Get()->Millis();
+
+	for (uint32_t nIndexTCB = 0; nIndexTCB < TCP_MAX_TCBS_ALLOWED; nIndexTCB++) {
+		auto *pTCB = &s_TCB[nIndexTCB];
+
+		if ((pTCB->state == STATE_CLOSED) || (pTCB->state == STATE_LISTEN)) {
+			continue;
+		}
+
+		if (pTCB->isAckPending) {
+			send_ack(pTCB);
 		}
+
+		if (pTCB->isCorked && ((nMillis - pTCB->nCorkMillis) >= net::tcp::CORK_MAX_MILLIS)) {
+			send_data(pTCB, true);
+			pTCB->nCorkMillis = nMillis;
+		}
+
+		// The zero window probe
+		if (!pTCB->RTX.isTimerRunning && (pTCB->SND.WND == 0) && (pTCB->nWriteSeq != pTCB->SND.NXT) && is_sending(pTCB)) {
+			start_timer(pTCB, nMillis);
+		}
+
+		if (!pTCB->RTX.isTimerRunning || (static_cast<int32_t>(nMillis - pTCB->RTX.nTimerMillis) < 0)) {
+			continue;
+		}
+
+		if (++pTCB->RTX.nRetries > net::tcp::MAX_RETRIES) {
+			DEBUG_PRINTF("%u: too many retransmissions", nIndexTCB);
+			struct SendInfo info;
+			info.SEQ = pTCB->SND.NXT;
+			info.ACK = pTCB->RCV.NXT;
+			info.CTL = Control::RST | Control::ACK;
+			send_segment(pTCB, info);
+			_close_tcb(pTCB);
+			continue;
+		}
+
+		retransmit(pTCB);
+		start_recovery(pTCB);
+
+		pTCB->RTX.nRTO = std::min(pTCB->RTX.nRTO * 2, net::tcp::RTO_MAX_MILLIS);
+		start_timer(pTCB, nMillis);
 	}
 }
 
+/**
+ * The acknowledgment of new data
+ */
+static void acknowledge(struct tcb *pTCB, const uint32_t SEG_ACK) {
+	const auto nMillis = Hardware::Get()->Millis();
+
+	pTCB->SND.UNA = SEG_ACK;
+
+	if (pTCB->RTX.isTiming && SEQ_GEQ(SEG_ACK, pTCB->RTX.nTimedSeq)) {
+		pTCB->RTX.isTiming = false;
+		rtt_update(pTCB, nMillis - pTCB->RTX.nTimedMillis);
+	}
+
+	pTCB->RTX.nRetries = 0;
+	pTCB->RTX.nDupAcks = 0;
+
+	// RFC 6582 3.2, a partial acknowledgment: the next segment is lost too
+	if (pTCB->RTX.isRecovery) {
+		if (SEQ_GEQ(SEG_ACK, pTCB->RTX.nRecover)) {
+			pTCB->RTX.isRecovery = false;
+		} else {
+			retransmit(pTCB);
+		}
+	}
+
+	if (pTCB->SND.UNA == pTCB->SND.NXT) {
+		pTCB->RTX.isTimerRunning = false;
+	} else {
+		start_timer(pTCB, nMillis);
+	}
+}
+
+/**
+ * The segment text is queued in the receive ring of the connection.
+ * An ACK for every second segment, else the delayed ACK from tcp_timer.
+ * @return false when the segment is not queued, an ACK is sent.
+ */
+static bool receive_text(struct tcb *pTCB, const uint8_t *pText, uint32_t nLength, uint32_t nSeq, const bool isFin) {
+	// The part which is already received, RFC 9293 3.10.7.4
+	if (SEQ_LT(nSeq, pTCB->RCV.NXT)) {
+		const auto nSkip = pTCB->RCV.NXT - nSeq;
+
+		if (nSkip >= nLength) {
+			DEBUG_PUTS("Duplicate");
+			send_ack(pTCB);
+			return false;
+		}
+
+		pText += nSkip;
+		nLength -= nSkip;
+		nSeq = pTCB->RCV.NXT;
+	}
+
+	const auto nIndex = index_of(pTCB);
+	auto *pQueue = &s_ReceiveQueue[nIndex];
+	const auto nFree = static_cast<uint16_t>(TCP_RX_MAX_ENTRIES - static_cast<uint16_t>(pQueue->nHead - pQueue->nTail));
+
+	if (nSeq != pTCB->RCV.NXT) {
+		// Right after a single lost segment: kept in the entry behind the gap, the entry for the gap stays free
+		if (!isFin && (nLength <= TCP_RX_MSS) && ((nSeq - pTCB->RCV.NXT) <= TCP_RX_MSS) && (nFree >= 2)) {
+			auto *pQueueEntry = &pQueue->Entries[(pQueue->nHead + 1U) & TCP_RX_MAX_ENTRIES_MASK];
+			memcpy(pQueueEntry->data, pText, nLength);
+			pQueueEntry->nSize = static_cast<uint16_t>(nLength);
+
+			pTCB->nOutOfOrderSeq = nSeq;
+			pTCB->nOutOfOrderSize = static_cast<uint16_t>(nLength);
+		}
+
+		// The duplicate ACK repeats RCV.NXT, RFC 5681 4.2
+		DEBUG_PUTS("Out of order");
+		send_dup_ack(pTCB);
+		return false;
+	}
+
+	if (nFree == 0) {
+		DEBUG_PUTS("No space");
+		send_ack(pTCB);
+		return false;
+	}
+
+	nLength = std::min(nLength, static_cast<uint32_t>(TCP_RX_MSS));
+
+	auto *pQueueEntry = &pQueue->Entries[pQueue->nHead & TCP_RX_MAX_ENTRIES_MASK];
+	memcpy(pQueueEntry->data, pText, nLength);
+	pQueueEntry->nSize = static_cast<uint16_t>(nLength);
+
+	pQueue->nHead++;
+	pTCB->nReceiveSize = static_cast<uint16_t>(nLength);
+	s_Port[pTCB->nPort].nEntries++;
+
+	pTCB->RCV.NXT += nLength;
+
+	if (pTCB->nOutOfOrderSize != 0) {
+		const auto isGapFilled = !isFin && (pTCB->RCV.NXT == pTCB->nOutOfOrderSeq);
+
+		if (isGapFilled) {
+			// The kept segment is the next entry already
+			pQueue->nHead++;
+			s_Port[pTCB->nPort].nEntries++;
+
+			pTCB->RCV.NXT += pTCB->nOutOfOrderSize;
+		}
+
+		// Else the gap is not filled exactly, the entry is reused
+		pTCB->nOutOfOrderSize = 0;
+
+		// RFC 5681 4.2, a segment which fills a gap is acknowledged at once
+		if (isGapFilled) {
+			send_ack(pTCB);
+			return true;
+		}
+	}
+
+	// RFC 5681 4.2, the FIN is acknowledged at once
+	if (!isFin) {
+		if (++pTCB->nUnackedSegments >= 2) {
+			send_ack(pTCB);
+		} else {
+			pTCB->isAckPending = true;
+		}
+	}
+
+	return true;
+}
+
 /**
  * https://www.rfc-editor.org/rfc/rfc9293.html#name-segment-arrives
  */
@@ -576,52 +1082,53 @@ __attribute__((hot)) void tcp_handle(struct t_tcp *pTcp) {
 	DEBUG_PRINTF(IPSTR ":%d[%d] -> %d", pTcp->ip4.src[0], pTcp->ip4.src[1], pTcp->ip4.src[2], pTcp->ip4.src[3], pTcp->tcp.dstpt, pTcp->tcp.srcpt, tcplen);
 
 	uint32_t nIndexPort;
-	/*
-	  src/net/tcp.cpp: In function 'void tcp_handle(t_tcp*)':
-src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this function [-Werror=maybe-uninitialized]
-  871 |                 switch (pTCB->state) {
-	 */
-	uint32_t nIndexTCB = 0;
-
-	// Find a TCB
+
 	for (nIndexPort = 0; nIndexPort < TCP_MAX_PORTS_ALLOWED; nIndexPort++) {
 		if (s_Port[nIndexPort].nLocalPort == pTcp->tcp.dstpt) {
-			// Find an active TCB
-			for (nIndexTCB = 0; nIndexTCB < TCP_MAX_TCBS_ALLOWED; nIndexTCB++) {
-				auto *pTCB = &s_Port[nIndexPort].TCB[nIndexTCB];
-				if (pTCB->state != STATE_LISTEN) {
-					if ((pTCB->nRemotePort == pTcp->tcp.srcpt) && (memcmp(pTCB->remoteIp, pTcp->ip4.src, IPv4_ADDR_LEN) == 0)) {
-						break;
-					}
-				}
-			}
+			break;
+		}
+	}
 
-			if (nIndexTCB == TCP_MAX_TCBS_ALLOWED) {
-				// Find an available TCB
-				for (nIndexTCB = 0; nIndexTCB < TCP_MAX_TCBS_ALLOWED; nIndexTCB++) {
-					auto *pTCB = &s_Port[nIndexPort].TCB[nIndexTCB];
-					if (pTCB->state == STATE_LISTEN) {
-						break;
-					}
-				}
+	const auto nDataOffset = offset2octets(pTcp->tcp.offset);
 
-				if (nIndexTCB == TCP_MAX_TCBS_ALLOWED) {
-					DEBUG_PUTS("MAX_TCB_ALLOWED -> Force retransmission");
-					DEBUG_EXIT
-					return;
+	if ((nDataOffset < TCP_HEADER_SIZE) || (nDataOffset > tcplen)) {
+		DEBUG_PUTS("Malformed");
+		return;
+	}
+
+	// Find the TCB of the connection
+	uint32_t nIndexTCB = TCP_MAX_TCBS_ALLOWED;
+
+	if (nIndexPort != TCP_MAX_PORTS_ALLOWED) {
+		for (uint32_t i = 0; i < TCP_MAX_TCBS_ALLOWED; i++) {
+			const auto *pTCB = &s_TCB[i];
+			if ((pTCB->state != STATE_CLOSED) && (pTCB->nPort == nIndexPort) && (pTCB->nRemotePort == pTcp->tcp.srcpt) && (memcmp(pTCB->remoteIp, pTcp->ip4.src, IPv4_ADDR_LEN) == 0)) {
+				nIndexTCB = i;
+				break;
+			}
+		}
+
+		// A connection request gets a TCB from the pool
+		if ((nIndexTCB == TCP_MAX_TCBS_ALLOWED) && ((pTcp->tcp.control & (Control::SYN | Control::ACK | Control::RST)) == Control::SYN)) {
+			for (uint32_t i = 0; i < TCP_MAX_TCBS_ALLOWED; i++) {
+				if (s_TCB[i].state == STATE_CLOSED) {
+					nIndexTCB = i;
+					_listen_tcb(&s_TCB[i], nIndexPort);
+					break;
 				}
 			}
 
-			break;
+			if (nIndexTCB == TCP_MAX_TCBS_ALLOWED) {
+				DEBUG_PUTS("MAX_TCB_ALLOWED -> Force retransmission");
+				return;
+			}
 		}
 	}
 
-	const auto nDataOffset = offset2octets(pTcp->tcp.offset);
-
 	// https://www.rfc-editor.org/rfc/rfc9293.html#name-closed-state
 	// CLOSED (i.e., TCB does not exist)
-	if (nIndexPort == TCP_MAX_PORTS_ALLOWED) {
-		DEBUG_PUTS("TCP_MAX_PORTS_ALLOWED");
+	if (nIndexTCB == TCP_MAX_TCBS_ALLOWED) {
+		DEBUG_PUTS("No TCB");
 		struct tcb TCB;
 
 		memset(&TCB, 0, sizeof(struct tcb));
@@ -648,19 +1155,6 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 	pTcp->tcp.window = __builtin_bswap16(pTcp->tcp.window);
 	pTcp->tcp.urgent = __builtin_bswap16(pTcp->tcp.urgent);
 
-	DEBUG_PRINTF("%c%c%c%c%c%c SEQ=%u, ACK=%u, tcplen=%u, data_offset=%u, data_length=%u",
-			pTcp->tcp.control & Control::URG ? 'U' : '-',
-			pTcp->tcp.control & Control::ACK ? 'A' : '-',
-			pTcp->tcp.control & Control::PSH ? 'P' : '-',
-			pTcp->tcp.control & Control::RST ? 'R' : '-',
-			pTcp->tcp.control & Control::SYN ? 'S' : '-',
-			pTcp->tcp.control & Control::FIN ? 'F' : '-',
-			_get_seqnum(pTcp),
-			_get_acknum(pTcp),
-			tcplen,
-			nDataOffset,
-			nDataLength);
-
 	SendInfo sendInfo;
 
 	const auto SEG_LEN = nDataLength;
@@ -668,7 +1162,7 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 	const auto SEG_SEQ = _get_seqnum(pTcp);
 	const auto SEG_WND = pTcp->tcp.window;
 
-	auto *pTCB = &s_Port[nIndexPort].TCB[nIndexTCB];
+	auto *pTCB = &s_TCB[nIndexTCB];
 
 	DEBUG_PRINTF("%u:%u:[%s] %c%c%c%c%c%c SEQ=%u, ACK=%u, tcplen=%u, data_offset=%u, data_length=%u",
 			nIndexPort,
@@ -680,8 +1174,8 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 			pTcp->tcp.control & Control::RST ? 'R' : '-',
 			pTcp->tcp.control & Control::SYN ? 'S' : '-',
 			pTcp->tcp.control & Control::FIN ? 'F' : '-',
-			_get_seqnum(pTcp),
-			_get_acknum(pTcp),
+			SEG_SEQ,
+			SEG_ACK,
 			tcplen,
 			nDataOffset,
 			nDataLength);
@@ -696,48 +1190,29 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 		memcpy(pTCB->remoteIp, pTcp->ip4.src, IPv4_ADDR_LEN);
 		memcpy(pTCB->remoteEthAddr, pTcp->ether.src, ETH_ADDR_LEN);
 
-		// First, check for a RST
-		// An incoming RST should be ignored.
-		if (pTcp->tcp.control & Control::RST) {
-
-			DEBUG_EXIT
-			return;
-		}
-
-		// Second, check for an ACK
-		// Any acknowledgment is bad if it arrives on a connection still in the LISTEN state.
-		// RST -> <SEQ=SEG.ACK><CTL=RST>
-		if (pTcp->tcp.control & Control::ACK) {
-			send_reset(pTcp, pTCB);
-
-			DEBUG_EXIT
-			return;
-		}
-
-		// Third, check for a SYN
+		// Third, check for a SYN (the RST and the ACK do not get a TCB)
 		// We skip security check
-		if (pTcp->tcp.control & Control::SYN) {
-			// Set RCV.NXT to SEG.SEQ+1, IRS is set to SEG.SEQ
-			pTCB->RCV.NXT = SEG_SEQ + 1;
-			pTCB->IRS = SEG_SEQ;
+		// Set RCV.NXT to SEG.SEQ+1, IRS is set to SEG.SEQ
+		pTCB->RCV.NXT = SEG_SEQ + 1;
+		pTCB->IRS = SEG_SEQ;
 
-			// <SEQ=ISS><ACK=RCV.NXT><CTL=SYN,ACK>
-			sendInfo.SEQ = pTCB->ISS;
-			sendInfo.ACK = pTCB->RCV.NXT;
-			sendInfo.CTL = Control::SYN | Control::ACK;
-			send_package(pTCB, sendInfo);
+		// <SEQ=ISS><ACK=RCV.NXT><CTL=SYN,ACK>
+		sendInfo.SEQ = pTCB->ISS;
+		sendInfo.ACK = pTCB->RCV.NXT;
+		sendInfo.CTL = Control::SYN | Control::ACK;
+		send_segment(pTCB, sendInfo);
 
-			// SND.NXT is set to ISS+1 and SND.UNA to ISS. The connection state should be changed to SYN-RECEIVED.
-			pTCB->SND.NXT = pTCB->ISS + 1;
-			pTCB->SND.UNA = pTCB->ISS;
+		// SND.NXT is set to ISS+1 and SND.UNA to ISS. The connection state should be changed to SYN-RECEIVED.
+		pTCB->SND.NXT = pTCB->ISS + 1;
+		pTCB->SND.UNA = pTCB->ISS;
 
-			NEW_STATE(pTCB, STATE_SYN_RECEIVED);
-			DEBUG_EXIT
-			return;
-		}
+		const auto nMillis = Hardware::Get()->Millis();
+		pTCB->RTX.isTiming = true;
+		pTCB->RTX.nTimedSeq = pTCB->SND.NXT;
+		pTCB->RTX.nTimedMillis = nMillis;
+		start_timer(pTCB, nMillis);
 
-		// Fourth, other data or control
-		DEBUG_PUTS("This should not be reached.");
+		NEW_STATE(pTCB, STATE_SYN_RECEIVED);
 		DEBUG_EXIT
 		return;
 	}
@@ -754,15 +1229,25 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 	case STATE_CLOSING:
 	case STATE_LAST_ACK:
 	case STATE_TIME_WAIT: {
+		// The SYN-ACK is lost, the SYN is retransmitted
+		if ((pTCB->state == STATE_SYN_RECEIVED) && ((pTcp->tcp.control & (Control::SYN | Control::ACK)) == Control::SYN) && (SEG_SEQ == pTCB->IRS)) {
+			retransmit(pTCB);
+			DEBUG_EXIT
+			return;
+		}
+
 		// There are four cases for the acceptability test for an incoming segment
 		auto isAcceptable = false;
 
-		DEBUG_PRINTF("RCV.WND=%u, SEG_LEN=%u, RCV.NXT=%u, SEG_SEQ=%u", pTCB->RCV.WND, SEG_LEN, pTCB->RCV.NXT, SEG_SEQ);
+		// RCV.WND stays as last advertised, the test is with the current free space
+		const uint32_t nReceiveWindow = receive_window(pTCB);
+
+		DEBUG_PRINTF("nReceiveWindow=%u, SEG_LEN=%u, RCV.NXT=%u, SEG_SEQ=%u", nReceiveWindow, SEG_LEN, pTCB->RCV.NXT, SEG_SEQ);
 
-		if (pTCB->RCV.WND > 0) {
+		if (nReceiveWindow > 0) {
 			if (SEG_LEN == 0) {
 				// Case 2: SEG_LEN = 0 RCV.WND > 0 -> RCV.NXT =< SEG.SEQ < RCV.NXT+RCV.WND
-				if (SEQ_BETWEEN_L(pTCB->RCV.NXT, SEG_SEQ, pTCB->RCV.NXT + pTCB->RCV.WND)) {
+				if (SEQ_BETWEEN_L(pTCB->RCV.NXT, SEG_SEQ, pTCB->RCV.NXT + nReceiveWindow)) {
 					isAcceptable = true;
 				}
 			} else {
@@ -770,8 +1255,8 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 				// RCV.NXT =< SEG.SEQ < RCV.NXT+RCV.WND
 				// or
 				// RCV.NXT =< SEG.SEQ+SEG.LEN-1 < RCV.NXT+RCV.WND
-				if ( SEQ_BETWEEN_L(pTCB->RCV.NXT, SEG_SEQ, pTCB->RCV.NXT + pTCB->RCV.WND)
-				  || SEQ_BETWEEN_L(pTCB->RCV.NXT, SEG_SEQ + SEG_LEN-1, pTCB->RCV.NXT+pTCB->RCV.WND)) {
+				if ( SEQ_BETWEEN_L(pTCB->RCV.NXT, SEG_SEQ, pTCB->RCV.NXT + nReceiveWindow)
+				  || SEQ_BETWEEN_L(pTCB->RCV.NXT, SEG_SEQ + SEG_LEN-1, pTCB->RCV.NXT + nReceiveWindow)) {
 					isAcceptable = true;
 				}
 			}
@@ -792,15 +1277,11 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 			// (unless the RST bit is set, if so drop the segment and return)
 			// <SEQ=SND.NXT><ACK=RCV.NXT><CTL=ACK>
 			if (pTcp->tcp.control & Control::RST) {
-				_init_tcb(pTCB, pTCB->nLocalPort);
 				DEBUG_EXIT
 				return;
 			}
 
-			sendInfo.SEQ = pTCB->SND.NXT;
-			sendInfo.ACK = pTCB->RCV.NXT;
-			sendInfo.CTL = Control::ACK;
-			send_package(pTCB, sendInfo);
+			send_ack(pTCB);
 
 			DEBUG_EXIT
 			return;
@@ -808,32 +1289,12 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 
 		// second check the RST bit, *//* Page 70 */
 		if (pTcp->tcp.control & Control::RST) {
-			switch (pTCB->state) {
-			case STATE_SYN_RECEIVED:
-				_init_tcb(pTCB, pTCB->nLocalPort);
-				break;
-			case STATE_ESTABLISHED:
-			case STATE_FIN_WAIT_1:
-			case STATE_FIN_WAIT_2:
-			case STATE_CLOSE_WAIT:
-				/* If the RST bit is set then, any outstanding RECEIVEs and SEND
-				 * should receive "reset" responses.  All segment queues should be
-				 * flushed.  Users should also receive an unsolicited general
-				 * "connection reset" signal.  Enter the CLOSED state, delete the
-				 * TCB, and return. */
-				_init_tcb(pTCB, pTCB->nLocalPort);
-				break;
-			case STATE_CLOSING:
-			case STATE_LAST_ACK:
-			case STATE_TIME_WAIT:
-				/* If the RST bit is set then, enter the CLOSED state, delete the
-				 * TCB, and return. */
-				_init_tcb(pTCB, pTCB->nLocalPort);
-				break;
-			default:
-				assert(0);
-				break;
-			}
+			/* If the RST bit is set then, any outstanding RECEIVEs and SEND
+			 * should receive "reset" responses.  All segment queues should be
+			 * flushed.  Users should also receive an unsolicited general
+			 * "connection reset" signal.  Enter the CLOSED state, delete the
+			 * TCB, and return. */
+			_close_tcb(pTCB);
 			return;
 		}
 
@@ -843,7 +1304,7 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 		if (pTcp->tcp.control & Control::SYN) {
 			// RFC 1122 section 4.2.2.20 (e)
 			if (pTCB->state == STATE_SYN_RECEIVED) {
-				_init_tcb(pTCB, pTCB->nLocalPort);
+				_close_tcb(pTCB);
 				return;
 			}
 
@@ -867,14 +1328,15 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 				pTCB->SND.WL1 = SEG_SEQ;
 				pTCB->SND.WL2 = SEG_ACK;
 
-				pTCB->SND.UNA = SEG_ACK;		// got ACK for SYN
+				acknowledge(pTCB, SEG_ACK);		// got ACK for SYN
 
 				NEW_STATE(pTCB, STATE_ESTABLISHED);
-				return;
+				// The request can be in this segment
 			} else {
 				// <SEQ=SEG.ACK><CTL=RST>
 				DEBUG_PUTS("_send_reset");
 				send_reset(pTcp, pTCB);
+				return;
 			}
 			break;
 		case STATE_ESTABLISHED:
@@ -885,22 +1347,7 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 			DEBUG_PRINTF("SND.UNA=%u, SEG_ACK=%u, SND.NXT=%u", pTCB->SND.UNA, SEG_ACK, pTCB->SND.NXT);
 
 			if (SEQ_BETWEEN_H(pTCB->SND.UNA, SEG_ACK, pTCB->SND.NXT)) {
-
-				auto nBytesAck = SEG_ACK - pTCB->SND.UNA;
-				pTCB->SND.UNA = SEG_ACK;
-
-				if (SEG_ACK == pTCB->SND.NXT) {
-					DEBUG_PUTS("/* all segments are acknowledged */");
-				}
-
-				if (pTCB->state == STATE_FIN_WAIT_1 || pTCB->state == STATE_CLOSING) {
-					nBytesAck--;
-					DEBUG_PUTS("/* acknowledged FIN does not count */");
-				}
-
-				if (pTCB->state == STATE_ESTABLISHED && nBytesAck == 1) {
-					nBytesAck--;
-				}
+				acknowledge(pTCB, SEG_ACK);
 
 				// update send window
 				if ( SEQ_LT(pTCB->SND.WL1, SEG_SEQ) || (pTCB->SND.WL1 == SEG_SEQ && SEQ_LEQ(pTCB->SND.WL2, SEG_ACK))) {
@@ -910,6 +1357,15 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 				}
 			} else if (SEQ_LEQ(SEG_ACK, pTCB->SND.UNA)) { /* RFC 1122 section 4.2.2.20 (g) */
 				DEBUG_PUTS("/* ignore duplicate ACK */");
+				// RFC 5681 3.2 fast retransmit
+				if ((SEG_ACK == pTCB->SND.UNA) && (SEG_LEN == 0) && (SEG_WND == pTCB->SND.WND) && (pTCB->SND.UNA != pTCB->SND.NXT)) {
+					if ((++pTCB->RTX.nDupAcks == dup_ack_threshold(pTCB)) && !pTCB->RTX.isRecovery) {
+						DEBUG_PUTS("Fast retransmit");
+						retransmit(pTCB);
+						start_recovery(pTCB);
+					}
+				}
+
 				if (SEQ_BETWEEN_LH(pTCB->SND.UNA, SEG_ACK, pTCB->SND.NXT)) {
 					// ... but update send window
 					if ( SEQ_LT(pTCB->SND.WL1, SEG_SEQ) || (pTCB->SND.WL1 == SEG_SEQ && SEQ_LEQ(pTCB->SND.WL2, SEG_ACK))) {
@@ -921,26 +1377,22 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 			} else if (SEQ_GT(SEG_ACK, pTCB->SND.NXT)) {
 				DEBUG_PRINTF("SEG_ACK=%u, SND.NXT=%u", SEG_ACK,pTCB->SND.NXT);
 
-				sendInfo.SEQ = pTCB->SND.NXT;
-				sendInfo.ACK = pTCB->RCV.NXT;
-				sendInfo.CTL = Control::ACK;
-
-				send_package(pTCB, sendInfo);
+				send_ack(pTCB);
 				return;
 			}
 			break;
 		case STATE_LAST_ACK:
 			if (SEG_ACK == pTCB->SND.NXT) { 	// if our FIN is now acknowledged
-				_init_tcb(pTCB, pTCB->nLocalPort);
+				_close_tcb(pTCB);
+				return;
+			}
+			if (SEQ_BETWEEN_H(pTCB->SND.UNA, SEG_ACK, pTCB->SND.NXT)) {
+				acknowledge(pTCB, SEG_ACK);
 			}
 			break;
 		case STATE_TIME_WAIT:
 			if (SEG_ACK == pTCB->SND.NXT) {		// if our FIN is now acknowledged
-				sendInfo.SEQ = pTCB->SND.NXT;
-				sendInfo.ACK = pTCB->RCV.NXT;
-				sendInfo.CTL = Control::ACK;
-
-				send_package(pTCB, sendInfo);
+				send_ack(pTCB);
 				CLIENT_NOT_IMPLEMENTED;
 			}
 			break;
@@ -952,37 +1404,14 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 		// sixth, check the URG bit. No code needed here
 
 		// seventh, process the segment text
+		const auto isFin = (pTcp->tcp.control & Control::FIN) != 0;
+
 		switch (pTCB->state) {
 		case STATE_ESTABLISHED:
 		case STATE_FIN_WAIT_1:
 		case STATE_FIN_WAIT_2:
 			if (nDataLength > 0) {
-				if (SEG_SEQ == pTCB->RCV.NXT) {
-					auto *pQueue = &s_Port[nIndexPort].receiveQueue;
-					auto *pQueueEntry = &pQueue->Entries[pQueue->nHead];
-
-					pQueueEntry->nHandleConnection = static_cast<uint16_t>(nIndexTCB);
-					memcpy(pQueueEntry->data, reinterpret_cast<uint8_t *>(&pTcp->tcp) + nDataOffset, nDataLength);
-					pQueueEntry->nSize = nDataLength;
-
-					pTCB->RCV.NXT += nDataLength;
-					pTCB->RCV.WND -= static_cast<uint16_t>(TCP_DATA_SIZE);
-
-					sendInfo.SEQ = pTCB->SND.NXT;
-					sendInfo.ACK = pTCB->RCV.NXT;
-					sendInfo.CTL = Control::ACK;
-
-					send_package(pTCB, sendInfo);
-
-					pQueue->nHead = (pQueue->nHead + 1) & TCP_RX_MAX_ENTRIES_MASK;
-				} else {
-					sendInfo.SEQ = pTCB->SND.NXT;
-					sendInfo.ACK = pTCB->RCV.NXT;
-					sendInfo.CTL = Control::ACK;
-
-					send_package(pTCB, sendInfo);
-
-					DEBUG_PUTS("Out of order");
+				if (!receive_text(pTCB, reinterpret_cast<uint8_t *>(&pTcp->tcp) + nDataOffset, nDataLength, SEG_SEQ, isFin)) {
 					DEBUG_EXIT
 					return;
 				}
@@ -1003,11 +1432,18 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 			return;
 		}
 
-		if (!(pTcp->tcp.control & Control::FIN)) {
+		if (!isFin) {
 			DEBUG_EXIT
 			return ;
 		}
 
+		// The FIN must be the next in sequence, else it is out of order or retransmitted
+		if ((SEG_SEQ + SEG_LEN) != pTCB->RCV.NXT) {
+			send_ack(pTCB);
+			DEBUG_EXIT
+			return;
+		}
+
 		/*
 		 If the FIN bit is set, signal the user "connection closing" and
 		 return any pending RECEIVEs with same message, advance RCV.NXT
@@ -1017,11 +1453,8 @@ src/net/tcp.cpp:871:31: error: 'nIndexTCB' may be used uninitialized in this fun
 		 */
 
 		pTCB->RCV.NXT = pTCB->RCV.NXT + 1;
-		sendInfo.SEQ = pTCB->SND.NXT;
-		sendInfo.ACK = pTCB->RCV.NXT;
-		sendInfo.CTL = Control::ACK;
 
-		send_package(pTCB, sendInfo);
+		send_ack(pTCB);
 
 		switch (pTCB->state) {
 		case STATE_SYN_RECEIVED:
@@ -1078,15 +1511,13 @@ int tcp_begin(const uint16_t nLocalPort) {
 		if (s_Port[i].nLocalPort == nLocalPort) {
 			return i;
 		}
+	}
 
+	for (int i = 0; i < TCP_MAX_PORTS_ALLOWED; i++) {
 		if (s_Port[i].nLocalPort == 0) {
+			memset(&s_Port[i], 0, sizeof(struct Port));
 			s_Port[i].nLocalPort = nLocalPort;
 
-			for (uint32_t nIndexTCB = 0; nIndexTCB < TCP_MAX_TCBS_ALLOWED; nIndexTCB++) {
-				// create transmission control block's (TCB)
-				_init_tcb(&s_Port[i].TCB[nIndexTCB], nLocalPort);
-			}
-
 			DEBUG_PRINTF("i=%d, nLocalPort=%d[%x]", i, nLocalPort, nLocalPort);
 			return i;
 		}
@@ -1096,58 +1527,203 @@ int tcp_begin(const uint16_t nLocalPort) {
 	console_error("tcp_begin\n");
 #endif
 	return -1;
+}
+
+/**
+ * The connections of the port are reset, the TCBs return to the pool.
+ */
+int tcp_end(const int32_t nHandleListen) {
+	assert(nHandleListen >= 0);
+	assert(nHandleListen < TCP_MAX_PORTS_ALLOWED);
+
+	for (uint32_t i = 0; i < TCP_MAX_TCBS_ALLOWED; i++) {
+		auto *pTCB = &s_TCB[i];
 
+		if ((pTCB->state == STATE_CLOSED) || (pTCB->nPort != static_cast<uint32_t>(nHandleListen))) {
+			continue;
+		}
+
+		if (pTCB->state != STATE_LISTEN) {
+			struct SendInfo info;
+			info.SEQ = pTCB->SND.NXT;
+			info.ACK = pTCB->RCV.NXT;
+			info.CTL = Control::RST | Control::ACK;
+			send_package(pTCB, info);
+		}
+
+		_close_tcb(pTCB);
+	}
+
+	s_Port[nHandleListen].nLocalPort = 0;
+
+	return -1;
 }
 
+/**
+ * The data returned is valid until the next tcp_read for the port.
+ * The connections of the port are served round robin.
+ */
 uint16_t tcp_read(const int32_t nHandleListen, const uint8_t **pData, uint32_t &nHandleConnection) {
 	assert(nHandleListen >= 0);
 	assert(nHandleListen < TCP_MAX_PORTS_ALLOWED);
 
-	auto *pQueue = &s_Port[nHandleListen].receiveQueue;
+	auto *pPort = &s_Port[nHandleListen];
+
+	// Release the entry returned by the previous call, and open the window
+	if (pPort->isEntryInUse) {
+		pPort->isEntryInUse = false;
+
+		auto *pTCB = &s_TCB[pPort->nReadTCB];
+		auto *pQueue = &s_ReceiveQueue[pPort->nReadTCB];
+
+		pQueue->nTail++;
+		pPort->nEntries--;
 
-	if (__builtin_expect((pQueue->nHead == pQueue->nTail), 1)) {
+		if (pTCB->state != STATE_CLOSED) {
+			// RFC 1122 4.2.3.3, a window update when the right edge moves enough
+			const uint32_t nWindow = receive_window(pTCB);
+			const uint32_t nThreshold = std::min(2U * pTCB->nReceiveSize, (TCP_RX_MAX_ENTRIES * pTCB->nReceiveSize) / 2U);
+
+			if (nWindow >= (pTCB->RCV.WND + nThreshold)) {
+				send_ack(pTCB);
+			}
+
+			send_fin(pTCB);
+		}
+	}
+
+	if (__builtin_expect((pPort->nEntries == 0), 1)) {
 		return 0;
 	}
 
-	const auto nEntry = pQueue->nTail;
-	const auto *const pQueueEntry = &pQueue->Entries[nEntry];
+	for (uint32_t i = 1; i <= TCP_MAX_TCBS_ALLOWED; i++) {
+		const auto nIndexTCB = (pPort->nReadTCB + i) % TCP_MAX_TCBS_ALLOWED;
+		const auto *pTCB = &s_TCB[nIndexTCB];
 
-	nHandleConnection = pQueueEntry->nHandleConnection;
-	*pData = pQueueEntry->data;
+		if ((pTCB->state == STATE_CLOSED) || (pTCB->nPort != static_cast<uint32_t>(nHandleListen))) {
+			continue;
+		}
+
+		const auto *pQueue = &s_ReceiveQueue[nIndexTCB];
+
+		if (pQueue->nHead != pQueue->nTail) {
+			const auto *pQueueEntry = &pQueue->Entries[pQueue->nTail & TCP_RX_MAX_ENTRIES_MASK];
 
-	auto *pTCB = &s_Port[nHandleListen].TCB[nHandleConnection];
+			pPort->nReadTCB = static_cast<uint16_t>(nIndexTCB);
+			pPort->isEntryInUse = true;
 
-	pTCB->RCV.WND += TCP_DATA_SIZE;
+			nHandleConnection = nIndexTCB;
+			*pData = pQueueEntry->data;
 
-	pQueue->nTail = (pQueue->nTail + 1) & TCP_RX_MAX_ENTRIES_MASK;
+			return pQueueEntry->nSize;
+		}
+	}
 
-	return pQueueEntry->nSize;
+	assert(0);
+	return 0;
 }
 
-void tcp_write(const int32_t nHandleListen, const uint8_t *pBuffer, uint16_t nLength, uint32_t nHandleConnection) {
+/**
+ * The data is copied into the transmit ring of the connection, as far as it fits.
+ * There is no waiting for the peer, the caller writes the rest when tcp_write_space allows.
+ * @return The number of bytes queued, less than nLength when the ring is full or when the connection is gone.
+ */
+uint32_t tcp_write(const int32_t nHandleListen, const uint8_t *pBuffer, uint16_t nLength, const uint32_t nHandleConnection) {
 	assert(nHandleListen >= 0);
 	assert(nHandleListen < TCP_MAX_PORTS_ALLOWED);
 	assert(pBuffer != nullptr);
 	assert(nHandleConnection < TCP_MAX_TCBS_ALLOWED);
 
-	nLength = std::min(nLength, static_cast<uint16_t>(TCP_DATA_SIZE));
+	auto *pTCB = &s_TCB[nHandleConnection];
 
-	auto *pTCB = &s_Port[nHandleListen].TCB[nHandleConnection];
+	if ((pTCB->nPort != static_cast<uint32_t>(nHandleListen)) || !is_sending(pTCB)) {
+		DEBUG_PUTS("Not connected");
+		return 0;
+	}
 
-	pTCB->TX.data = const_cast<uint8_t *>(pBuffer);
-	pTCB->TX.size = nLength;
+	auto *pTransmitBuffer = s_TransmitBuffer[nHandleConnection].data;
+	uint32_t nQueued = 0;
 
-	struct SendInfo info;
-	info.SEQ = pTCB->SND.NXT;
-	info.ACK = pTCB->RCV.NXT;
-	info.CTL = Control::ACK | Control::PSH;
+	// At most two copies, the second one after the wrap around
+	while (nQueued < nLength) {
+		const auto nSpace = TCP_TX_BUFFER_SIZE - (pTCB->nWriteSeq - pTCB->SND.UNA);
 
-	send_package(pTCB, info);
+		if (nSpace == 0) {
+			DEBUG_PUTS("Ring full");
+			break;
+		}
+
+		const auto nOffset = pTCB->nWriteSeq & TCP_TX_BUFFER_MASK;
+		const auto nCopy = std::min(std::min(nLength - nQueued, nSpace), TCP_TX_BUFFER_SIZE - nOffset);
+
+		memcpy(&pTransmitBuffer[nOffset], &pBuffer[nQueued], nCopy);
 
-	pTCB->TX.data = nullptr;
-	pTCB->TX.size = 0;
+		pTCB->nWriteSeq += nCopy;
+		nQueued += nCopy;
+	}
+
+	// With a full ring the application cannot fill the segment, Nagle would wait for the ACK
+	send_data(pTCB, nQueued < nLength);
+	return nQueued;
+}
 
-	pTCB->SND.NXT += nLength;
+uint32_t tcp_write_space(const int32_t nHandleListen, const uint32_t nHandleConnection) {
+	assert(nHandleListen >= 0);
+	assert(nHandleListen < TCP_MAX_PORTS_ALLOWED);
+	assert(nHandleConnection < TCP_MAX_TCBS_ALLOWED);
+
+	const auto *pTCB = &s_TCB[nHandleConnection];
+
+	if ((pTCB->nPort != static_cast<uint32_t>(nHandleListen)) || !is_sending(pTCB)) {
+		return 0;
+	}
+
+	return TCP_TX_BUFFER_SIZE - (pTCB->nWriteSeq - pTCB->SND.UNA);
+}
+
+/**
+ * Nagle (RFC 896) is on by default, a small segment waits for the ACK of the data in flight.
+ */
+void tcp_set_nodelay(const int32_t nHandleListen, const uint32_t nHandleConnection, const bool isNoDelay) {
+	assert(nHandleListen >= 0);
+	assert(nHandleListen < TCP_MAX_PORTS_ALLOWED);
+	assert(nHandleConnection < TCP_MAX_TCBS_ALLOWED);
+
+	auto *pTCB = &s_TCB[nHandleConnection];
+
+	if (pTCB->nPort != static_cast<uint32_t>(nHandleListen)) {
+		return;
+	}
+
+	pTCB->isNoDelay = isNoDelay;
+
+	if (isNoDelay && is_sending(pTCB)) {
+		send_data(pTCB, false);
+	}
+}
+
+/**
+ * When corked, only full segments are sent. Uncork sends the remainder,
+ * a cork is released after net::tcp::CORK_MAX_MILLIS.
+ */
+void tcp_set_cork(const int32_t nHandleListen, const uint32_t nHandleConnection, const bool isCorked) {
+	assert(nHandleListen >= 0);
+	assert(nHandleListen < TCP_MAX_PORTS_ALLOWED);
+	assert(nHandleConnection < TCP_MAX_TCBS_ALLOWED);
+
+	auto *pTCB = &s_TCB[nHandleConnection];
+
+	if (pTCB->nPort != static_cast<uint32_t>(nHandleListen)) {
+		return;
+	}
+
+	pTCB->isCorked = isCorked;
+
+	if (isCorked) {
+		pTCB->nCorkMillis = Hardware::Get()->Millis();
+	} else if (is_sending(pTCB)) {
+		send_data(pTCB, true);
+	}
 }
 
 // <---
@@ -52,6 +52,7 @@ static struct data_entry s_data[UDP_MAX_PORTS_ALLOWED] SECTION_NETWORK ALIGNED;
 static struct t_udp s_send_packet SECTION_NETWORK ALIGNED;
 static uint16_t s_id SECTION_NETWORK ALIGNED;
 static uint8_t s_multicast_mac[ETH_ADDR_LEN] SECTION_NETWORK ALIGNED;
+static uint32_t s_nIp4HeaderSum SECTION_NETWORK ALIGNED;	///< Without the id, len and dst
 
 namespace net {
 namespace globals {
@@ -67,6 +68,13 @@ void udp_set_ip() {
 
 	src.u32 = net::globals::ipInfo.ip.addr;
 	memcpy(s_send_packet.ip4.src, src.u8, IPv4_ADDR_LEN);
+
+	auto ip4 = s_send_packet.ip4;
+	ip4.len = 0;
+	ip4.id = 0;
+	ip4.chksum = 0;
+	memset(ip4.dst, 0, IPv4_ADDR_LEN);
+	s_nIp4HeaderSum = net_chksum_add(&ip4, sizeof(struct ip4_header), 0);
 }
 
 void __attribute__((cold)) udp_init() {
@@ -95,6 +103,22 @@ void __attribute__((cold)) udp_shutdown() {
 }
 
 __attribute__((hot)) void udp_handle(struct t_udp *pUdp) {
+	/*
+	 * The EMAC hash filter passes the groups which share a bin with a joined group.
+	 * Local Network Control Block 224.0.0.0/24 is always passed.
+	 */
+	if (((pUdp->ip4.dst[0] & 0xF0) == 0xE0) && !((pUdp->ip4.dst[0] == 224) && (pUdp->ip4.dst[1] == 0) && (pUdp->ip4.dst[2] == 0))) {
+		_pcast32 dst;
+		_pcast32 src;
+
+		memcpy(dst.u8, pUdp->ip4.dst, IPv4_ADDR_LEN);
+		memcpy(src.u8, pUdp->ip4.src, IPv4_ADDR_LEN);
+
+		if (!igmp_is_member(dst.u32, src.u32)) {
+			return;
+		}
+	}
+
 	const auto nDestinationPort = __builtin_bswap16(pUdp->udp.destination_port);
 
 	for (uint32_t nPortIndex = 0; nPortIndex < UDP_MAX_PORTS_ALLOWED; nPortIndex++) {
@@ -205,7 +229,7 @@ uint16_t udp_recv2(int nIndex, const uint8_t **pData, uint32_t *pFromIp, uint16_
 	return nSize;
 }
 
-int udp_send(int nIndex, const uint8_t *pData, uint16_t nSize, uint32_t RemoteIp, uint16_t RemotePort) {
+static int udp_prepare(int nIndex, const uint8_t *pData, uint16_t nSize, uint32_t RemoteIp, uint16_t RemotePort) {
 	assert(nIndex >= 0);
 	assert(nIndex < UDP_MAX_PORTS_ALLOWED);
 	_pcast32 dst;
@@ -266,9 +290,11 @@ int udp_send(int nIndex, const uint8_t *pData, uint16_t nSize, uint32_t RemoteIp
 	//IPv4
 	s_send_packet.ip4.id = s_id;
 	s_send_packet.ip4.len = __builtin_bswap16((nSize + IPv4_UDP_HEADERS_SIZE));
+#if defined (CHECKSUM_BY_HARDWARE)
 	s_send_packet.ip4.chksum = 0;
-#if !defined (CHECKSUM_BY_HARDWARE)
-	s_send_packet.ip4.chksum = net_chksum(reinterpret_cast<void *>(&s_send_packet.ip4), sizeof(s_send_packet.ip4));
+#else
+	memcpy(dst.u8, s_send_packet.ip4.dst, IPv4_ADDR_LEN);
+	s_send_packet.ip4.chksum = net_chksum_fold(net_chksum_add32(s_nIp4HeaderSum + s_send_packet.ip4.id + s_send_packet.ip4.len, dst.u32));
 #endif
 	//UDP
 	s_send_packet.udp.source_port = __builtin_bswap16( s_Port[nIndex]);
@@ -277,11 +303,33 @@ int udp_send(int nIndex, const uint8_t *pData, uint16_t nSize, uint32_t RemoteIp
 
 	net_memcpy(s_send_packet.udp.data, pData, std::min(static_cast<uint16_t>(UDP_DATA_SIZE), nSize));
 
-	emac_eth_send(reinterpret_cast<void *>(&s_send_packet), nSize + UDP_PACKET_HEADERS_SIZE);
-
 	s_id++;
 
 	return 0;
 }
 
+int udp_send(int nIndex, const uint8_t *pData, uint16_t nSize, uint32_t RemoteIp, uint16_t RemotePort) {
+	const auto nResult = udp_prepare(nIndex, pData, nSize, RemoteIp, RemotePort);
+
+	if (__builtin_expect((nResult == 0), 1)) {
+		emac_eth_send(reinterpret_cast<void *>(&s_send_packet), nSize + UDP_PACKET_HEADERS_SIZE);
+	}
+
+	return nResult;
+}
+
+int udp_send_queued(int nIndex, const uint8_t *pData, uint16_t nSize, uint32_t RemoteIp, uint16_t RemotePort) {
+	const auto nResult = udp_prepare(nIndex, pData, nSize, RemoteIp, RemotePort);
+
+	if (__builtin_expect((nResult == 0), 1)) {
+		emac_eth_send_queued(reinterpret_cast<void *>(&s_send_packet), nSize + UDP_PACKET_HEADERS_SIZE);
+	}
+
+	return nResult;
+}
+
+void udp_send_flush() {
+	emac_eth_send_flush();
+}
+
 // <---
@@ -0,0 +1,115 @@
+/**
+ * @file oscaddressspace.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef OSCADDRESSSPACE_H_
+#define OSCADDRESSSPACE_H_
+
+#include <cstdint>
+
+namespace osc {
+namespace addressspace {
+static constexpr auto NODES = 48U;
+static constexpr auto NAMES_SIZE = 512U;
+static constexpr auto PATTERN_LENGTH = 128U;
+static constexpr auto SEGMENTS = 8U;
+static constexpr uint16_t NONE = 0xFFFF;
+static constexpr uint8_t METHOD_NONE = 0xFF;
+
+struct Node {
+	uint16_t nName;			///< Offset in the name pool
+	uint16_t nChild;
+	uint16_t nSibling;
+	uint16_t nNumbered;		///< When not 0, the node matches the numbers 1..nNumbered
+	uint8_t nMethod;
+	uint8_t nArgument;
+};
+}  // namespace addressspace
+}  // namespace osc
+
+/**
+ * The OSC address space as a tree of containers and methods.
+ * An incoming address pattern is split into segments once; literal segments are
+ * compared with the children of a node, only segments with wildcards use pattern matching.
+ */
+class OscAddressSpace {
+public:
+	typedef void (*Callback)(void *pContext, uint32_t nMethod, uint32_t nArgument, uint32_t nNumber);
+
+	OscAddressSpace() {
+		Clear();
+	}
+
+	void Clear();
+
+	/**
+	 * @param pAddress The address of the method, "/container/method"
+	 */
+	bool Add(const char *pAddress, uint8_t nMethod, uint8_t nArgument);
+
+	/**
+	 * Adds the methods pAddress/1 .. pAddress/nNumbered. The callback gets the number.
+	 */
+	bool AddNumbered(const char *pAddress, uint16_t nNumbered, uint8_t nMethod, uint8_t nArgument);
+
+	/**
+	 * Calls the callback for each method matching the address pattern.
+	 * @return The number of methods invoked
+	 */
+	uint32_t Dispatch(const char *pPattern, Callback callback, void *pContext);
+
+	uint32_t GetNodes() const {
+		return m_nNodes;
+	}
+
+private:
+	uint16_t Insert(const char *pAddress);
+	uint16_t NodeAdd(uint16_t nParent, const char *pName, uint32_t nLength, uint16_t nNumbered);
+	void Match(uint16_t nParent, uint32_t nSegment);
+	void Invoke(const osc::addressspace::Node& node, uint32_t nNumber) {
+		m_Callback(m_pContext, node.nMethod, node.nArgument, nNumber);
+		m_nMatches++;
+	}
+
+private:
+	osc::addressspace::Node m_Nodes[osc::addressspace::NODES];
+	uint32_t m_nNodes;
+	uint32_t m_nNamesSize;
+	char m_aNames[osc::addressspace::NAMES_SIZE];
+
+	struct Segment {
+		const char *pName;
+		bool bWildcard;
+	};
+
+	char m_aPattern[osc::addressspace::PATTERN_LENGTH];
+	Segment m_Segments[osc::addressspace::SEGMENTS];
+	uint32_t m_nSegments;
+
+	Callback m_Callback;
+	void *m_pContext;
+	uint32_t m_nMatches;
+};
+
+#endif /* OSCADDRESSSPACE_H_ */
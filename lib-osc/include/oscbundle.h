@@ -0,0 +1,61 @@
+/**
+ * @file oscbundle.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef OSCBUNDLE_H_
+#define OSCBUNDLE_H_
+
+#include <cstdint>
+#include <cstring>
+
+/*
+ * OSC Bundle
+ * "#bundle" OSC-string, OSC Time Tag, followed by zero or more bundle elements.
+ * Each element is an int32 size followed by the contents: an OSC Message or an OSC Bundle.
+ */
+
+namespace osc {
+namespace bundle {
+static constexpr char TAG[8] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', '\0' };
+static constexpr auto TIMETAG_OFFSET = 8U;
+static constexpr auto ELEMENTS_OFFSET = 16U;
+
+/**
+ * The time tag is in NTP format: seconds since 1900 in the upper 32 bits, the fraction of a second in the lower 32 bits.
+ */
+static constexpr uint64_t TIMETAG_IMMEDIATELY = 1;
+
+inline static bool is_bundle(const void *pData, uint32_t nLength) {
+	return (nLength >= ELEMENTS_OFFSET) && (memcmp(pData, TAG, sizeof(TAG)) == 0);
+}
+
+inline static uint64_t get_timetag(const void *pData) {
+	uint64_t nTimeTag;
+	memcpy(&nTimeTag, reinterpret_cast<const uint8_t *>(pData) + TIMETAG_OFFSET, sizeof(uint64_t));
+	return __builtin_bswap64(nTimeTag);
+}
+}  // namespace bundle
+}  // namespace osc
+
+#endif /* OSCBUNDLE_H_ */
@@ -0,0 +1,281 @@
+/**
+ * @file oscaddressspace.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cassert>
+
+#include "oscaddressspace.h"
+#include "osc.h"
+
+#include "debug.h"
+
+using namespace osc::addressspace;
+
+void OscAddressSpace::Clear() {
+	m_nNodes = 1;
+	m_nNamesSize = 1;
+	m_aNames[0] = '\0';
+
+	auto& root = m_Nodes[0];
+	root.nName = 0;
+	root.nChild = NONE;
+	root.nSibling = NONE;
+	root.nNumbered = 0;
+	root.nMethod = METHOD_NONE;
+	root.nArgument = 0;
+}
+
+uint16_t OscAddressSpace::NodeAdd(uint16_t nParent, const char *pName, uint32_t nLength, uint16_t nNumbered) {
+	if ((m_nNodes == NODES) || ((m_nNamesSize + nLength + 1) > NAMES_SIZE)) {
+		DEBUG_PUTS("Address space is full");
+		return NONE;
+	}
+
+	const auto nNode = static_cast<uint16_t>(m_nNodes++);
+	auto& node = m_Nodes[nNode];
+
+	node.nName = static_cast<uint16_t>(m_nNamesSize);
+	node.nChild = NONE;
+	node.nNumbered = nNumbered;
+	node.nMethod = METHOD_NONE;
+	node.nArgument = 0;
+
+	memcpy(&m_aNames[m_nNamesSize], pName, nLength);
+	m_nNamesSize += nLength;
+	m_aNames[m_nNamesSize++] = '\0';
+
+	// Append, the children keep the order in which they were added
+	node.nSibling = NONE;
+
+	auto *pLink = &m_Nodes[nParent].nChild;
+
+	while (*pLink != NONE) {
+		pLink = &m_Nodes[*pLink].nSibling;
+	}
+
+	*pLink = nNode;
+
+	return nNode;
+}
+
+uint16_t OscAddressSpace::Insert(const char *pAddress) {
+	assert(pAddress != nullptr);
+
+	if (*pAddress != '/') {
+		return NONE;
+	}
+
+	uint16_t nParent = 0;
+
+	while (*pAddress == '/') {
+		const auto *pName = ++pAddress;
+
+		while ((*pAddress != '/') && (*pAddress != '\0')) {
+			pAddress++;
+		}
+
+		const auto nLength = static_cast<uint32_t>(pAddress - pName);
+
+		if (nLength == 0) {
+			return NONE;
+		}
+
+		auto nNode = m_Nodes[nParent].nChild;
+
+		while (nNode != NONE) {
+			const auto& node = m_Nodes[nNode];
+
+			if ((node.nNumbered == 0) && (strncmp(&m_aNames[node.nName], pName, nLength) == 0) && (m_aNames[node.nName + nLength] == '\0')) {
+				break;
+			}
+
+			nNode = node.nSibling;
+		}
+
+		if (nNode == NONE) {
+			nNode = NodeAdd(nParent, pName, nLength, 0);
+
+			if (nNode == NONE) {
+				return NONE;
+			}
+		}
+
+		nParent = nNode;
+	}
+
+	return nParent;
+}
+
+bool OscAddressSpace::Add(const char *pAddress, uint8_t nMethod, uint8_t nArgument) {
+	const auto nNode = Insert(pAddress);
+
+	if (nNode == NONE) {
+		return false;
+	}
+
+	m_Nodes[nNode].nMethod = nMethod;
+	m_Nodes[nNode].nArgument = nArgument;
+
+	return true;
+}
+
+bool OscAddressSpace::AddNumbered(const char *pAddress, uint16_t nNumbered, uint8_t nMethod, uint8_t nArgument) {
+	assert(nNumbered != 0);
+
+	const auto nParent = Insert(pAddress);
+
+	if (nParent == NONE) {
+		return false;
+	}
+
+	const auto nNode = NodeAdd(nParent, "", 0, nNumbered);
+
+	if (nNode == NONE) {
+		return false;
+	}
+
+	m_Nodes[nNode].nMethod = nMethod;
+	m_Nodes[nNode].nArgument = nArgument;
+
+	return true;
+}
+
+static uint32_t number_parse(const char *pSegment) {
+	uint32_t nNumber = 0;
+	uint32_t i;
+
+	for (i = 0; (i < 5) && (pSegment[i] >= '0') && (pSegment[i] <= '9'); i++) {
+		nNumber = nNumber * 10 + static_cast<uint32_t>(pSegment[i] - '0');
+	}
+
+	if ((i == 0) || (pSegment[i] != '\0')) {
+		return 0;
+	}
+
+	return nNumber;
+}
+
+void OscAddressSpace::Match(uint16_t nParent, uint32_t nSegment) {
+	const auto& segment = m_Segments[nSegment];
+	const auto bLast = ((nSegment + 1) == m_nSegments);
+
+	for (auto nNode = m_Nodes[nParent].nChild; nNode != NONE; nNode = m_Nodes[nNode].nSibling) {
+		const auto& node = m_Nodes[nNode];
+
+		if (node.nNumbered != 0) {
+			if (!bLast || (node.nMethod == METHOD_NONE)) {
+				continue;
+			}
+
+			if (!segment.bWildcard) {
+				const auto nNumber = number_parse(segment.pName);
+
+				if ((nNumber != 0) && (nNumber <= node.nNumbered)) {
+					Invoke(node, nNumber);
+				}
+
+				continue;
+			}
+
+			const auto bAll = (segment.pName[0] == '*') && (segment.pName[1] == '\0');
+
+			for (uint32_t nNumber = 1; nNumber <= node.nNumbered; nNumber++) {
+				char aNumber[8];
+				snprintf(aNumber, sizeof(aNumber), "%u", static_cast<unsigned int>(nNumber));
+
+				if (bAll || osc::is_match(aNumber, segment.pName)) {
+					Invoke(node, nNumber);
+				}
+			}
+
+			continue;
+		}
+
+		const auto *pName = &m_aNames[node.nName];
+
+		if (segment.bWildcard ? osc::is_match(pName, segment.pName) : (strcmp(pName, segment.pName) == 0)) {
+			if (!bLast) {
+				Match(nNode, nSegment + 1);
+			} else if (node.nMethod != METHOD_NONE) {
+				Invoke(node, 0);
+			}
+		}
+	}
+}
+
+uint32_t OscAddressSpace::Dispatch(const char *pPattern, Callback callback, void *pContext) {
+	assert(pPattern != nullptr);
+	assert(callback != nullptr);
+
+	if (*pPattern != '/') {
+		return 0;
+	}
+
+	/*
+	 * Compile: the separators are replaced by '\0', so that each segment is a string
+	 */
+
+	m_nSegments = 0;
+
+	uint32_t i;
+
+	for (i = 0; (i < (PATTERN_LENGTH - 1)) && (pPattern[i] != '\0'); i++) {
+		const auto c = pPattern[i];
+
+		if (c == '/') {
+			if (m_nSegments == SEGMENTS) {
+				return 0;
+			}
+
+			m_aPattern[i] = '\0';
+			m_Segments[m_nSegments].pName = &m_aPattern[i + 1];
+			m_Segments[m_nSegments].bWildcard = false;
+			m_nSegments++;
+			continue;
+		}
+
+		if ((c == '*') || (c == '?') || (c == '[') || (c == '{')) {
+			m_Segments[m_nSegments - 1].bWildcard = true;
+		}
+
+		m_aPattern[i] = c;
+	}
+
+	if (pPattern[i] != '\0') {
+		return 0;
+	}
+
+	m_aPattern[i] = '\0';
+
+	m_Callback = callback;
+	m_pContext = pContext;
+	m_nMatches = 0;
+
+	Match(0, 0);
+
+	return m_nMatches;
+}
@@ -0,0 +1,286 @@
+/**
+ * @file benchmark.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * OscServer throughput, reported in messages per second.
+ * Dispatch : address lookup only, the linear osc::is_match() scan as used before
+ *            compared with OscAddressSpace::Dispatch().
+ * Server   : frames of 512 channel updates received over the loopback interface,
+ *            sent as one message per packet, as bundles and as one blob.
+ *            SetData calls per frame shows the coalescing of the updates.
+ * Usage: benchmark ip_address|interface_name [frames]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "hardware.h"
+#include "network.h"
+#include "oscserver.h"
+#include "oscaddressspace.h"
+#include "oscbundle.h"
+#include "osc.h"
+#include "lightset.h"
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+class Output final: public LightSet {
+public:
+	void Start([[maybe_unused]] const uint32_t nPortIndex) override {}
+	void Stop([[maybe_unused]] const uint32_t nPortIndex) override {}
+
+	void SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t *pData, uint32_t nLength, [[maybe_unused]] const bool doUpdate = true) override {
+		memcpy(m_Data, pData, nLength);
+		m_nSetData++;
+	}
+
+	void Sync([[maybe_unused]] const uint32_t nPortIndex) override {}
+	void Sync([[maybe_unused]] const bool doForce = false) override {}
+
+	bool IsFrame(uint8_t nValue) const {
+		return (m_Data[0] == nValue) && (m_Data[lightset::dmx::UNIVERSE_SIZE - 1] == nValue);
+	}
+
+	uint32_t m_nSetData { 0 };
+
+private:
+	uint8_t m_Data[lightset::dmx::UNIVERSE_SIZE];
+};
+
+/*
+ * The Linux Network sockets have a receive time-out, which is rounded up to a
+ * scheduler tick. Make them non-blocking so that Run() is polled at full rate.
+ */
+static void network_sockets_prepare() {
+	for (int nSocket = 3; nSocket < 64; nSocket++) {
+		int nType;
+		socklen_t nLength = sizeof(nType);
+
+		if ((getsockopt(nSocket, SOL_SOCKET, SO_TYPE, &nType, &nLength) == 0) && (nType == SOCK_DGRAM)) {
+			fcntl(nSocket, F_SETFL, fcntl(nSocket, F_GETFL) | O_NONBLOCK);
+			int nSize = 8 * 1024 * 1024;
+			setsockopt(nSocket, SOL_SOCKET, SO_RCVBUFFORCE, &nSize, sizeof(nSize));
+		}
+	}
+}
+
+static uint32_t message_channel(uint8_t *pBuffer, uint32_t nChannel, uint8_t nValue) {
+	memset(pBuffer, 0, 24);
+	const auto nPathLength = static_cast<uint32_t>(snprintf(reinterpret_cast<char *>(pBuffer), 12, "/dmx1/%u", static_cast<unsigned int>(nChannel)));
+	// The OSC-string is padded to a multiple of 4 bytes, with at least one '\0'
+	auto nLength = (nPathLength + 4) & ~3U;
+	memcpy(&pBuffer[nLength], ",i", 2);
+	nLength += 4;
+	const auto nData = __builtin_bswap32(nValue);
+	memcpy(&pBuffer[nLength], &nData, 4);
+	return nLength + 4;
+}
+
+static uint32_t message_blob(uint8_t *pBuffer, uint8_t nValue) {
+	memset(pBuffer, 0, 16);
+	memcpy(pBuffer, "/dmx1", 5);
+	memcpy(&pBuffer[8], ",b", 2);
+	const auto nSize = __builtin_bswap32(lightset::dmx::UNIVERSE_SIZE);
+	memcpy(&pBuffer[12], &nSize, 4);
+	memset(&pBuffer[16], nValue, lightset::dmx::UNIVERSE_SIZE);
+	return 16 + lightset::dmx::UNIVERSE_SIZE;
+}
+
+static void dispatch_callback(void *p, uint32_t nMethod, uint32_t nArgument, uint32_t nNumber) {
+	*reinterpret_cast<uint32_t *>(p) += nMethod + nArgument + nNumber;
+}
+
+/*
+ * The address space of a server with all the ports active.
+ * The linear scan matches the patterns in order, as one is_match() per method.
+ */
+
+static void benchmark_dispatch(uint32_t nCount) {
+	constexpr uint32_t PORTS = osc::server::Max::PORTS;
+	constexpr uint32_t PATTERNS = (2 * PORTS) + 3;
+
+	OscAddressSpace addressSpace;
+	char aPatterns[PATTERNS][24];
+	uint32_t nPatterns = 0;
+
+	for (uint32_t nPort = 0; nPort < PORTS; nPort++) {
+		snprintf(aPatterns[nPatterns++], sizeof(aPatterns[0]), "/dmx%u", static_cast<unsigned int>(nPort + 1));
+		snprintf(aPatterns[nPatterns++], sizeof(aPatterns[0]), "/dmx%u/*", static_cast<unsigned int>(nPort + 1));
+		addressSpace.Add(aPatterns[nPatterns - 2], 0, static_cast<uint8_t>(nPort));
+		addressSpace.AddNumbered(aPatterns[nPatterns - 2], lightset::dmx::UNIVERSE_SIZE, 1, static_cast<uint8_t>(nPort));
+	}
+
+	strcpy(aPatterns[nPatterns++], "/dmx1/blackout");
+	strcpy(aPatterns[nPatterns++], "/ping");
+	strcpy(aPatterns[nPatterns++], "/2");
+	addressSpace.Add("/dmx1/blackout", 2, 0);
+	addressSpace.Add("/ping", 3, 0);
+	addressSpace.Add("/2", 4, 0);
+
+	static char aPaths[PORTS * lightset::dmx::UNIVERSE_SIZE][16];
+
+	for (uint32_t i = 0; i < (PORTS * lightset::dmx::UNIVERSE_SIZE); i++) {
+		snprintf(aPaths[i], sizeof(aPaths[i]), "/dmx%u/%u", static_cast<unsigned int>(1 + (i / lightset::dmx::UNIVERSE_SIZE)), static_cast<unsigned int>(1 + (i % lightset::dmx::UNIVERSE_SIZE)));
+	}
+
+	uint32_t nCheckLinear = 0;
+	auto nStart = micros();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		const auto *pPath = aPaths[i % (PORTS * lightset::dmx::UNIVERSE_SIZE)];
+
+		for (uint32_t nPattern = 0; nPattern < nPatterns; nPattern++) {
+			if (osc::is_match(pPath, aPatterns[nPattern])) {
+				nCheckLinear += nPattern + static_cast<uint32_t>(atoi(strrchr(pPath, '/') + 1));
+				break;
+			}
+		}
+	}
+
+	auto nElapsed = micros() - nStart;
+	printf("%-16s %10.0f messages/s\n", "is_match", static_cast<double>(nCount) * 1e6 / static_cast<double>(nElapsed));
+
+	uint32_t nCheck = 0;
+	nStart = micros();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		addressSpace.Dispatch(aPaths[i % (PORTS * lightset::dmx::UNIVERSE_SIZE)], dispatch_callback, &nCheck);
+	}
+
+	nElapsed = micros() - nStart;
+	printf("%-16s %10.0f messages/s\n", "OscAddressSpace", static_cast<double>(nCount) * 1e6 / static_cast<double>(nElapsed));
+
+	if ((nCheck == 0) || (nCheckLinear == 0)) {
+		puts("No matches");
+	}
+}
+
+int main(int argc, char **argv) {
+	Hardware hw;
+	Network nw(argc, argv);
+
+	const auto nFrames = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 200U;
+
+	benchmark_dispatch(1000000);
+
+	Output output;
+	OscServer server;
+
+	server.SetOutput(&output);
+	server.SetPartialTransmission(true);
+	server.Start();
+
+	network_sockets_prepare();
+
+	const auto nSocket = socket(AF_INET, SOCK_DGRAM, 0);
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = Network::Get()->GetIp();
+	addr.sin_port = htons(server.GetPortIncoming());
+
+	// Messages per bundle, the bundle must fit in one segment
+	constexpr uint32_t BUNDLE_MESSAGES = 56;
+	uint8_t buffer[1400];
+
+	for (uint32_t nMode = 0; nMode < 3; nMode++) {
+		const auto nSetData = output.m_nSetData;
+		uint32_t nMessages = 0;
+		uint32_t nPackets = 0;
+		uint32_t nTimeouts = 0;
+
+		const auto nStart = micros();
+
+		for (uint32_t nFrame = 0; nFrame < nFrames; nFrame++) {
+			const auto nValue = static_cast<uint8_t>(1 + (nFrame % 250));
+
+			if (nMode == 0) {
+				for (uint32_t nChannel = 1; nChannel <= lightset::dmx::UNIVERSE_SIZE; nChannel++) {
+					const auto nLength = message_channel(buffer, nChannel, nValue);
+					sendto(nSocket, buffer, nLength, 0, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+					nPackets++;
+				}
+				nMessages += lightset::dmx::UNIVERSE_SIZE;
+			} else if (nMode == 1) {
+				for (uint32_t nChannel = 1; nChannel <= lightset::dmx::UNIVERSE_SIZE;) {
+					memcpy(buffer, osc::bundle::TAG, sizeof(osc::bundle::TAG));
+					const auto nTimeTag = __builtin_bswap64(osc::bundle::TIMETAG_IMMEDIATELY);
+					memcpy(&buffer[osc::bundle::TIMETAG_OFFSET], &nTimeTag, sizeof(nTimeTag));
+
+					uint32_t nLength = osc::bundle::ELEMENTS_OFFSET;
+
+					for (uint32_t i = 0; (i < BUNDLE_MESSAGES) && (nChannel <= lightset::dmx::UNIVERSE_SIZE); i++, nChannel++) {
+						const auto nSize = message_channel(&buffer[nLength + 4], nChannel, nValue);
+						const auto nSizeBigEndian = __builtin_bswap32(nSize);
+						memcpy(&buffer[nLength], &nSizeBigEndian, 4);
+						nLength += 4 + nSize;
+					}
+
+					sendto(nSocket, buffer, nLength, 0, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+					nPackets++;
+				}
+				nMessages += lightset::dmx::UNIVERSE_SIZE;
+			} else {
+				const auto nLength = message_blob(buffer, nValue);
+				sendto(nSocket, buffer, nLength, 0, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+				nPackets++;
+				nMessages++;
+			}
+
+			uint32_t nRun;
+
+			for (nRun = 0; !output.IsFrame(nValue) && (nRun < 1000000); nRun++) {
+				server.Run();
+			}
+
+			if (nRun == 1000000) {
+				nTimeouts++;
+			}
+		}
+
+		const auto nElapsed = micros() - nStart;
+		static constexpr const char *pMode[] = { "Message/packet", "Bundle", "Blob" };
+
+		printf("%-16s %10.0f messages/s %8.0f packets/s %6.2f SetData/frame %u time-outs\n", pMode[nMode],
+				static_cast<double>(nMessages) * 1e6 / static_cast<double>(nElapsed),
+				static_cast<double>(nPackets) * 1e6 / static_cast<double>(nElapsed),
+				static_cast<double>(output.m_nSetData - nSetData) / nFrames, nTimeouts);
+	}
+
+	close(nSocket);
+
+	return 0;
+}
@@ -29,6 +29,7 @@
 #include <cstdint>
 #include <cassert>
 
+#include "oscaddressspace.h"
 #include "lightset.h"
 
 namespace osc {
@@ -40,6 +41,34 @@ struct DefaultPort {
 
 struct Max {
 	static constexpr auto PATH_LENGTH = 128U;
+#if defined (BARE_METAL)
+	static constexpr auto PORTS = 4U;
+	static constexpr auto BUNDLES_PENDING = 2U;
+#else
+	static constexpr auto PORTS = 8U;
+	static constexpr auto BUNDLES_PENDING = 8U;
+#endif
+	static constexpr auto BUNDLE_SIZE = 1472U;
+	static constexpr auto BUNDLE_DEPTH = 4U;
+	static constexpr auto PACKETS_PER_RUN = 32U;
+	static constexpr auto BUNDLE_DELAY_SECONDS = 10U;	///< A time tag further ahead means no synchronized clock, the bundle is applied immediately
+};
+
+enum class Method : uint8_t {
+	DMX, DMX_CHANNEL, BLACKOUT, PING, INFO
+};
+
+struct Port {
+	uint16_t nLastChannel;
+	bool bUpdate;
+	bool bIsRunning;
+};
+
+struct Bundle {
+	uint64_t nTimeTag;
+	uint32_t nRemoteIp;
+	uint32_t nLength;
+	uint8_t aData[Max::BUNDLE_SIZE];
 };
 }  // namespace server
 }  // namespace osc
@@ -111,6 +140,19 @@ public:
 		return m_bPartialTransmission;
 	}
 
+	/**
+	 * Port 0 uses the DMX path, port n the path with its trailing number incremented by n.
+	 * When the path has no trailing number, n + 1 is appended.
+	 */
+	void SetPorts(uint32_t nPorts) {
+		m_nPorts = (nPorts == 0) ? 1 : ((nPorts > osc::server::Max::PORTS) ? osc::server::Max::PORTS : nPorts);
+		AddressSpaceBuild();
+	}
+
+	uint32_t GetPorts() const {
+		return m_nPorts;
+	}
+
 	void SetEnableNoChangeUpdate(bool bEnableNoChangeUpdate) {
 		m_bEnableNoChangeUpdate = bEnableNoChangeUpdate;
 	}
@@ -130,20 +172,46 @@ public:
 	}
 
 private:
-	int GetChannel(const char *p);
-	bool IsDmxDataChanged(const uint8_t *pData, uint16_t nStartChannel, uint32_t nLength);
+	void AddressSpaceBuild();
+	void PortPath(uint32_t nPort, char *pPath, uint32_t nLength);
+
+	void Handle(const uint8_t *pBuffer, uint32_t nLength);
+	void HandleBundle(const uint8_t *pBuffer, uint32_t nLength, uint32_t nDepth);
+	void HandleMessage(const uint8_t *pBuffer, uint32_t nLength);
+	void HandleDmx(uint32_t nPort);
+	void HandleDmxChannel(uint32_t nPort, uint32_t nChannel);
+	void HandleBlackout();
+	void HandleInfo();
+
+	bool BundleIsDue(uint64_t nTimeTag);
+	void BundleSchedule(const uint8_t *pBuffer, uint32_t nLength, uint64_t nTimeTag);
+	void BundlesRun();
+
+	void DataUpdate(uint32_t nPort, const uint8_t *pData, uint32_t nStartChannel, uint32_t nLength);
+	bool IsDmxDataChanged(uint32_t nPort, const uint8_t *pData, uint32_t nStartChannel, uint32_t nLength);
+	void Commit();
+
+	void callbackFunction(uint32_t nMethod, uint32_t nArgument, uint32_t nNumber);
+	static void staticCallbackFunction(void *p, uint32_t nMethod, uint32_t nArgument, uint32_t nNumber);
 
 private:
 	uint16_t m_nPortIncoming { osc::server::DefaultPort::INCOMING };
 	uint16_t m_nPortOutgoing { osc::server::DefaultPort::OUTGOING };
 	int32_t m_nHandle { -1 };
-	uint16_t m_nLastChannel { 0 };
+	uint32_t m_nPorts { 1 };
+	uint32_t m_nRemoteIp { 0 };
+	uint32_t m_nBundlesPending { 0 };
+
+	const uint8_t *m_pMessage { nullptr };
+	uint32_t m_nMessageLength { 0 };
 
 	bool m_bPartialTransmission { false };
 	bool m_bEnableNoChangeUpdate { false };
-	bool m_bIsRunning { false };
 	char m_Os[32];
 
+	osc::server::Port m_Ports[osc::server::Max::PORTS];
+	OscAddressSpace m_AddressSpace;
+
 	OscServerHandler *m_pOscServerHandler { nullptr };
 	LightSet *m_pLightSet { nullptr };
 
@@ -155,9 +223,11 @@ private:
 	static char s_aPathInfo[osc::server::Max::PATH_LENGTH];
 	static char s_aPathBlackOut[osc::server::Max::PATH_LENGTH];
 
-	static uint8_t s_pData[lightset::dmx::UNIVERSE_SIZE];
+	static uint8_t s_pData[osc::server::Max::PORTS][lightset::dmx::UNIVERSE_SIZE];
 	static uint8_t s_pOsc[lightset::dmx::UNIVERSE_SIZE];
 
+	static osc::server::Bundle s_Bundles[osc::server::Max::BUNDLES_PENDING];
+
 	static char *s_pUdpBuffer;
 	static OscServer *s_pThis;
 };
@@ -43,6 +43,7 @@ struct Params {
 	char aPath[osc::server::Max::PATH_LENGTH];
 	char aPathInfo[osc::server::Max::PATH_LENGTH];
 	char aPathBlackOut[osc::server::Max::PATH_LENGTH];
+	uint8_t nPorts;
 } __attribute__((packed));
 
 struct ParamsMask {
@@ -53,6 +54,7 @@ struct ParamsMask {
 	static constexpr uint32_t OUTPUT = (1U << 4);
 	static constexpr uint32_t PATH_INFO = (1U << 5);
 	static constexpr uint32_t PATH_BLACKOUT = (1U << 6);
+	static constexpr uint32_t PORTS = (1U << 7);
 };
 }  // namespace server
 }  // namespace osc
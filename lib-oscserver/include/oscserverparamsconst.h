@@ -34,6 +34,8 @@ struct OscServerParamsConst {
 	static const char PATH_BLACKOUT[];
 
 	static const char TRANSMISSION[];
+
+	static const char PORTS[];
 };
 
 #endif /* OSCSERVERPARAMSCONST_H_ */
@@ -24,8 +24,10 @@
  */
 
 #include <cstdint>
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
+#include <sys/time.h>
 #include <cassert>
 
 #include "oscserver.h"
@@ -33,9 +35,12 @@
 #include "oscsimplemessage.h"
 #include "oscsimplesend.h"
 #include "oscblob.h"
+#include "oscbundle.h"
+#include "oscaddressspace.h"
 
 #include "lightset.h"
 #include "network.h"
+#include "ntp.h"
 
 #include "hardware.h"
 
@@ -54,8 +59,9 @@ char OscServer::s_aPathInfo[osc::server::Max::PATH_LENGTH];
 char OscServer::s_aPathBlackOut[osc::server::Max::PATH_LENGTH];
 
 char *OscServer::s_pUdpBuffer;
-uint8_t OscServer::s_pData[lightset::dmx::UNIVERSE_SIZE];
+uint8_t OscServer::s_pData[osc::server::Max::PORTS][lightset::dmx::UNIVERSE_SIZE];
 uint8_t OscServer::s_pOsc[lightset::dmx::UNIVERSE_SIZE];
+osc::server::Bundle OscServer::s_Bundles[osc::server::Max::BUNDLES_PENDING];
 
 OscServer *OscServer::s_pThis;
 
@@ -76,6 +82,8 @@ OscServer::OscServer() {
 	memset(s_aPathBlackOut, 0, sizeof(s_aPathBlackOut));
 	strcpy(s_aPathBlackOut, OSCSERVER_DEFAULT_PATH_BLACKOUT);
 
+	memset(m_Ports, 0, sizeof(m_Ports));
+
 	snprintf(m_Os, sizeof(m_Os) - 1, "[V%s] %s", SOFTWARE_VERSION, __DATE__);
 
 	uint8_t nHwTextLength;
@@ -86,6 +94,8 @@ OscServer::OscServer() {
 		m_pSoC = Hardware::Get()->GetCpuName(nHwTextLength);
 	}
 
+	AddressSpaceBuild();
+
 	DEBUG_EXIT
 }
 
@@ -110,8 +120,54 @@ void OscServer::Start() {
 
 void OscServer::Stop() {
 	if (m_pLightSet != nullptr) {
-		m_pLightSet->Stop(0);
+		for (uint32_t nPort = 0; nPort < m_nPorts; nPort++) {
+			m_pLightSet->Stop(nPort);
+		}
+	}
+}
+
+void OscServer::PortPath(uint32_t nPort, char *pPath, uint32_t nLength) {
+	const auto nPathLength = static_cast<uint32_t>(strlen(s_aPath));
+	auto nDigits = nPathLength;
+
+	while ((nDigits > 0) && (s_aPath[nDigits - 1] >= '0') && (s_aPath[nDigits - 1] <= '9')) {
+		nDigits--;
+	}
+
+	if (nPort == 0) {
+		snprintf(pPath, nLength, "%s", s_aPath);
+	} else if (nDigits < nPathLength) {
+		uint32_t nNumber = 0;
+
+		for (auto i = nDigits; i < nPathLength; i++) {
+			nNumber = nNumber * 10 + static_cast<uint32_t>(s_aPath[i] - '0');
+		}
+
+		snprintf(pPath, nLength, "%.*s%u", static_cast<int>(nDigits), s_aPath, static_cast<unsigned int>(nNumber + nPort));
+	} else {
+		snprintf(pPath, nLength, "%s%u", s_aPath, static_cast<unsigned int>(nPort + 1));
+	}
+}
+
+void OscServer::AddressSpaceBuild() {
+	DEBUG_ENTRY
+
+	m_AddressSpace.Clear();
+
+	char aPath[osc::server::Max::PATH_LENGTH + 8];
+
+	for (uint32_t nPort = 0; nPort < m_nPorts; nPort++) {
+		PortPath(nPort, aPath, sizeof(aPath));
+		m_AddressSpace.Add(aPath, static_cast<uint8_t>(osc::server::Method::DMX), static_cast<uint8_t>(nPort));
+		m_AddressSpace.AddNumbered(aPath, lightset::dmx::UNIVERSE_SIZE, static_cast<uint8_t>(osc::server::Method::DMX_CHANNEL), static_cast<uint8_t>(nPort));
 	}
+
+	m_AddressSpace.Add(s_aPathBlackOut, static_cast<uint8_t>(osc::server::Method::BLACKOUT), 0);
+	m_AddressSpace.Add("/ping", static_cast<uint8_t>(osc::server::Method::PING), 0);
+	m_AddressSpace.Add(s_aPathInfo, static_cast<uint8_t>(osc::server::Method::INFO), 0);
+
+	DEBUG_PRINTF("Nodes=%u", m_AddressSpace.GetNodes());
+	DEBUG_EXIT
 }
 
 void OscServer::SetPath(const char* pPath) {
@@ -134,6 +190,8 @@ void OscServer::SetPath(const char* pPath) {
 		s_aPathSecond[nLength++] = '/';
 		s_aPathSecond[nLength++] = '*';
 		s_aPathSecond[nLength] = '\0';
+
+		AddressSpaceBuild();
 	}
 
 	DEBUG_PUTS(s_aPath);
@@ -150,6 +208,8 @@ void OscServer::SetPathInfo(const char* pPathInfo) {
 		if (s_aPathInfo[nLength - 1] == '/') {
 			s_aPathInfo[nLength - 1] = '\0';
 		}
+
+		AddressSpaceBuild();
 	}
 
 	DEBUG_PUTS(s_aPathInfo);
@@ -165,43 +225,20 @@ void OscServer::SetPathBlackOut(const char* pPathBlackOut) {
 		if (s_aPathBlackOut[nLength - 1] == '/') {
 			s_aPathBlackOut[nLength - 1] = '\0';
 		}
-	}
-
-	DEBUG_PUTS(s_aPathBlackOut);
-}
-
-int OscServer::GetChannel(const char* p) {
-	assert(p != nullptr);
-
-	auto *s = const_cast<char *>(p) + strlen(s_aPath) + 1;
-	int nChannel = 0;
-	int i;
-
-	for (i = 0; (i < 3) && (*s != '\0'); i++) {
-		int c = *s;
-
-		if ((c < '0') || (c > '9')) {
-			return -1;
-		}
-
-		nChannel = nChannel * 10 + c - '0';
-		s++;
-	}
 
-	if (nChannel > static_cast<int32_t>(lightset::dmx::UNIVERSE_SIZE)) {
-		return -1;
+		AddressSpaceBuild();
 	}
 
-	return nChannel;
+	DEBUG_PUTS(s_aPathBlackOut);
 }
 
-bool OscServer::IsDmxDataChanged(const uint8_t* pData, uint16_t nStartChannel, uint32_t nLength) {
+bool OscServer::IsDmxDataChanged(uint32_t nPort, const uint8_t* pData, uint32_t nStartChannel, uint32_t nLength) {
 	assert(pData != nullptr);
 	assert(nLength <= lightset::dmx::UNIVERSE_SIZE);
 
 	auto isChanged = false;
 	const auto *src = pData;
-	auto *dst = &s_pData[--nStartChannel];
+	auto *dst = &s_pData[nPort][--nStartChannel];
 	const auto nEnd = nStartChannel + nLength;
 
 	assert(nEnd <= lightset::dmx::UNIVERSE_SIZE);
@@ -218,176 +255,336 @@ bool OscServer::IsDmxDataChanged(const uint8_t* pData, uint16_t nStartChannel, u
 	return isChanged;
 }
 
-void OscServer::Run() {
-	uint32_t nRemoteIp;
-	uint16_t nRemotePort;
+/*
+ * The data is only copied, the output is updated with Commit():
+ * once for all the messages in a bundle and in the packets received in one Run().
+ */
 
-	const auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&s_pUdpBuffer)), &nRemoteIp, &nRemotePort);
+void OscServer::DataUpdate(uint32_t nPort, const uint8_t *pData, uint32_t nStartChannel, uint32_t nLength) {
+	if (IsDmxDataChanged(nPort, pData, nStartChannel, nLength) || m_bEnableNoChangeUpdate) {
+		auto& port = m_Ports[nPort];
+		const auto nLastChannel = static_cast<uint16_t>(nStartChannel + nLength - 1);
+
+		port.bUpdate = true;
+		port.nLastChannel = nLastChannel > port.nLastChannel ? nLastChannel : port.nLastChannel;
+	}
+}
+
+void OscServer::Commit() {
+	for (uint32_t nPort = 0; nPort < m_nPorts; nPort++) {
+		auto& port = m_Ports[nPort];
+
+		if (!port.bUpdate) {
+			continue;
+		}
+
+		port.bUpdate = false;
+
+		if (!m_bPartialTransmission) {
+			m_pLightSet->SetData(nPort, s_pData[nPort], lightset::dmx::UNIVERSE_SIZE);
+		} else {
+			m_pLightSet->SetData(nPort, s_pData[nPort], port.nLastChannel);
+		}
+
+		if (!port.bIsRunning) {
+			port.bIsRunning = true;
+			m_pLightSet->Start(nPort);
+		}
+	}
+}
+
+void OscServer::HandleDmx(uint32_t nPort) {
+	OscSimpleMessage Msg(const_cast<uint8_t *>(m_pMessage), m_nMessageLength);
+
+	const auto nArgc = Msg.GetArgc();
+
+	if ((nArgc == 1) && (Msg.GetType(0) == osc::type::BLOB)) {
+		DEBUG_PUTS("Blob received");
+
+		OSCBlob blob = Msg.GetBlob(0);
+		const auto size = static_cast<uint16_t>(blob.GetDataSize());
+
+		if (size <= lightset::dmx::UNIVERSE_SIZE) {
+			DataUpdate(nPort, blob.GetDataPtr(), 1, size);
+		} else {
+			DEBUG_PUTS("Too many channels");
+		}
 
-	if (__builtin_expect((nBytesReceived == 0), 1)) {
 		return;
 	}
 
-	auto bIsDmxDataChanged = false;
+	if ((nArgc == 2) && (Msg.GetType(0) == osc::type::INT32)) {
+		const auto nChannel = static_cast<uint16_t>(1 + Msg.GetInt(0));
 
-	OscSimpleMessage Msg(s_pUdpBuffer, nBytesReceived);
+		if ((nChannel < 1) || (nChannel > lightset::dmx::UNIVERSE_SIZE)) {
+			DEBUG_PRINTF("Invalid channel [%d]", nChannel);
+			return;
+		}
 
-	debug_dump(s_pUdpBuffer, nBytesReceived);
+		uint8_t nData;
 
-	DEBUG_PRINTF("[%d] path : %s", nBytesReceived, osc::get_path(s_pUdpBuffer, nBytesReceived));
+		if (Msg.GetType(1) == osc::type::INT32) {
+			DEBUG_PUTS("ii received");
+			nData = static_cast<uint8_t>(Msg.GetInt(1));
+		} else if (Msg.GetType(1) == osc::type::FLOAT) {
+			DEBUG_PUTS("if received");
+			nData = static_cast<uint8_t>(Msg.GetFloat(1) * lightset::dmx::MAX_VALUE);
+		} else {
+			return;
+		}
 
-	if (osc::is_match(s_pUdpBuffer, s_aPath)) {
-		const auto nArgc = Msg.GetArgc();
+		DEBUG_PRINTF("Channel = %d, Data = %.2x", nChannel, nData);
 
-		if ((nArgc == 1) && (Msg.GetType(0) == osc::type::BLOB)) {
-			DEBUG_PUTS("Blob received");
+		DataUpdate(nPort, &nData, nChannel, 1);
+	}
+}
 
-			OSCBlob blob = Msg.GetBlob(0);
-			const auto size = static_cast<uint16_t>(blob.GetDataSize());
+void OscServer::HandleDmxChannel(uint32_t nPort, uint32_t nChannel) {
+	OscSimpleMessage Msg(const_cast<uint8_t *>(m_pMessage), m_nMessageLength);
 
-			if (size <= lightset::dmx::UNIVERSE_SIZE) {
-				const auto *ptr = blob.GetDataPtr();
+	if (Msg.GetArgc() != 1) { // /path/N 'i' or 'f'
+		return;
+	}
 
-				bIsDmxDataChanged = IsDmxDataChanged(ptr, 1, size);
+	uint8_t nData;
 
-				if (bIsDmxDataChanged || m_bEnableNoChangeUpdate) {
-					if ((!m_bPartialTransmission) || (size == lightset::dmx::UNIVERSE_SIZE)) {
-						m_pLightSet->SetData(0, s_pData, lightset::dmx::UNIVERSE_SIZE);
-					} else {
-						m_nLastChannel = static_cast<uint16_t>(size > m_nLastChannel ? size : m_nLastChannel);
-						m_pLightSet->SetData(0, s_pData, m_nLastChannel);
-					}
+	if (Msg.GetType(0) == osc::type::INT32) {
+		DEBUG_PUTS("i received");
+		nData = static_cast<uint8_t>(Msg.GetInt(0));
+	} else if (Msg.GetType(0) == osc::type::FLOAT) {
+		DEBUG_PRINTF("f received %f", Msg.GetFloat(0));
+		nData = static_cast<uint8_t>(Msg.GetFloat(0) * lightset::dmx::MAX_VALUE);
+	} else {
+		return;
+	}
 
-					if (!m_bIsRunning) {
-						m_bIsRunning = true;
-						m_pLightSet->Start(0);
-					}
-				}
-			} else {
-				DEBUG_PUTS("Too many channels");
-				return;
-			}
-		} else if ((nArgc == 2) && (Msg.GetType(0) == osc::type::INT32)) {
-			auto nChannel = static_cast<uint16_t>(1 + Msg.GetInt(0));
+	DEBUG_PRINTF("Channel = %d, Data = %.2x", nChannel, nData);
 
-			if ((nChannel < 1) || (nChannel > lightset::dmx::UNIVERSE_SIZE)) {
-				DEBUG_PRINTF("Invalid channel [%d]", nChannel);
-				return;
-			}
+	DataUpdate(nPort, &nData, nChannel, 1);
+}
 
-			uint8_t nData;
+void OscServer::HandleBlackout() {
+	if (m_pOscServerHandler == nullptr) {
+		return;
+	}
 
-			if (Msg.GetType(1) == osc::type::INT32) {
-				DEBUG_PUTS("ii received");
-				nData = static_cast<uint8_t>(Msg.GetInt(1));
-			} else if (Msg.GetType(1) == osc::type::FLOAT) {
-				DEBUG_PUTS("if received");
-				nData = static_cast<uint8_t>(Msg.GetFloat(1) * lightset::dmx::MAX_VALUE);
-			} else {
-				return;
-			}
+	OscSimpleMessage Msg(const_cast<uint8_t *>(m_pMessage), m_nMessageLength);
+
+	if (Msg.GetType(0) != osc::type::FLOAT) {
+		DEBUG_PUTS("No float");
+		return;
+	}
 
-			DEBUG_PRINTF("Channel = %d, Data = %.2x", nChannel, nData);
+	if (Msg.GetFloat(0) != 0) {
+		m_pOscServerHandler->Blackout();
+		DEBUG_PUTS("Blackout");
+	} else {
+		m_pOscServerHandler->Update();
+		DEBUG_PUTS("Update");
+	}
+}
 
-			bIsDmxDataChanged = IsDmxDataChanged(&nData, nChannel, 1);
+void OscServer::HandleInfo() {
+	OscSimpleSend MsgSendInfo(m_nHandle, m_nRemoteIp, m_nPortOutgoing, "/info/os", "s", m_Os);
+	OscSimpleSend MsgSendModel(m_nHandle, m_nRemoteIp, m_nPortOutgoing, "/info/model", "s", m_pModel);
+	OscSimpleSend MsgSendSoc(m_nHandle, m_nRemoteIp, m_nPortOutgoing, "/info/soc", "s", m_pSoC);
 
-			if (bIsDmxDataChanged || m_bEnableNoChangeUpdate) {
-				if (!m_bPartialTransmission) {
-					m_pLightSet->SetData(0, s_pData, lightset::dmx::UNIVERSE_SIZE);
-				} else {
-					m_nLastChannel = nChannel > m_nLastChannel ? nChannel : m_nLastChannel;
-					m_pLightSet->SetData(0, s_pData, m_nLastChannel);
-				}
+	if (m_pOscServerHandler != nullptr) {
+		m_pOscServerHandler->Info(m_nHandle, m_nRemoteIp, m_nPortOutgoing);
+	}
+}
 
-				if (!m_bIsRunning) {
-					m_bIsRunning = true;
-					m_pLightSet->Start(0);
-				}
-			}
-		}
+void OscServer::staticCallbackFunction(void *p, uint32_t nMethod, uint32_t nArgument, uint32_t nNumber) {
+	(static_cast<OscServer *>(p))->callbackFunction(nMethod, nArgument, nNumber);
+}
+
+void OscServer::callbackFunction(uint32_t nMethod, uint32_t nArgument, uint32_t nNumber) {
+	switch (static_cast<osc::server::Method>(nMethod)) {
+	case osc::server::Method::DMX:
+		HandleDmx(nArgument);
+		break;
+	case osc::server::Method::DMX_CHANNEL:
+		HandleDmxChannel(nArgument, nNumber);
+		break;
+	case osc::server::Method::BLACKOUT:
+		HandleBlackout();
+		break;
+	case osc::server::Method::PING: {
+		DEBUG_PUTS("ping received");
+		OscSimpleSend MsgSend(m_nHandle, m_nRemoteIp, m_nPortOutgoing, "/pong", nullptr);
+	}
+		break;
+	case osc::server::Method::INFO:
+		HandleInfo();
+		break;
+	default:
+		break;
+	}
+}
 
+void OscServer::HandleMessage(const uint8_t *pBuffer, uint32_t nLength) {
+	const auto *pPath = osc::get_path(const_cast<uint8_t *>(pBuffer), nLength);
+
+	if (pPath == nullptr) {
 		return;
 	}
 
-	if ((m_pOscServerHandler != nullptr) && (osc::is_match(s_pUdpBuffer, s_aPathBlackOut))) {
-		OscSimpleMessage Msg(s_pUdpBuffer, nBytesReceived);
+	DEBUG_PRINTF("[%u] path : %s", nLength, pPath);
+
+	m_pMessage = pBuffer;
+	m_nMessageLength = nLength;
+
+	m_AddressSpace.Dispatch(pPath, OscServer::staticCallbackFunction, this);
+}
+
+void OscServer::HandleBundle(const uint8_t *pBuffer, uint32_t nLength, uint32_t nDepth) {
+	DEBUG_PRINTF("nLength=%u, nDepth=%u", nLength, nDepth);
+
+	uint32_t nOffset = osc::bundle::ELEMENTS_OFFSET;
 
-		if (Msg.GetType(0) != osc::type::FLOAT) {
-			DEBUG_PUTS("No float");
+	while ((nOffset + 4) <= nLength) {
+		uint32_t nSize;
+		memcpy(&nSize, &pBuffer[nOffset], sizeof(uint32_t));
+		nSize = __builtin_bswap32(nSize);
+		nOffset += 4;
+
+		if ((nSize == 0) || ((nSize & 0x3) != 0) || (nSize > (nLength - nOffset))) {
+			DEBUG_PUTS("Invalid bundle element");
 			return;
 		}
 
-		if (Msg.GetFloat(0) != 0) {
-			m_pOscServerHandler->Blackout();
-			DEBUG_PUTS("Blackout");
+		const auto *pElement = &pBuffer[nOffset];
+
+		if (osc::bundle::is_bundle(pElement, nSize)) {
+			// A nested bundle is applied together with the enclosing bundle
+			if (nDepth < osc::server::Max::BUNDLE_DEPTH) {
+				HandleBundle(pElement, nSize, nDepth + 1);
+			}
 		} else {
-			m_pOscServerHandler->Update();
-			DEBUG_PUTS("Update");
+			HandleMessage(pElement, nSize);
 		}
 
+		nOffset += nSize;
+	}
+}
+
+static uint64_t ntp_now() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+
+	const auto nSeconds = static_cast<uint64_t>(static_cast<uint32_t>(tv.tv_sec) + ntp::NTP_TIMESTAMP_DELTA);
+	const auto nFraction = (static_cast<uint64_t>(tv.tv_usec) << 32) / 1000000U;
+
+	return (nSeconds << 32) | nFraction;
+}
+
+bool OscServer::BundleIsDue(uint64_t nTimeTag) {
+	if (nTimeTag <= osc::bundle::TIMETAG_IMMEDIATELY) {
+		return true;
+	}
+
+	const auto nNow = ntp_now();
+
+	if (nTimeTag <= nNow) {
+		return true;
+	}
+
+	return (nTimeTag - nNow) > (static_cast<uint64_t>(osc::server::Max::BUNDLE_DELAY_SECONDS) << 32);
+}
+
+void OscServer::BundleSchedule(const uint8_t *pBuffer, uint32_t nLength, uint64_t nTimeTag) {
+	if ((m_nBundlesPending == osc::server::Max::BUNDLES_PENDING) || (nLength > osc::server::Max::BUNDLE_SIZE)) {
+		DEBUG_PUTS("Bundle is applied immediately");
+		HandleBundle(pBuffer, nLength, 0);
 		return;
 	}
 
-	if (osc::is_match(s_pUdpBuffer, s_aPathSecond)) {
-		const auto nArgc = Msg.GetArgc();
+	auto& bundle = s_Bundles[m_nBundlesPending++];
 
-		if (nArgc == 1) { // /path/N 'i' or 'f'
-			const auto nChannel = static_cast<uint16_t>(GetChannel(s_pUdpBuffer));
+	bundle.nTimeTag = nTimeTag;
+	bundle.nRemoteIp = m_nRemoteIp;
+	bundle.nLength = nLength;
+	memcpy(bundle.aData, pBuffer, nLength);
+}
 
-			if (nChannel >= 1 && nChannel <= lightset::dmx::UNIVERSE_SIZE) {
-				uint8_t nData;
+void OscServer::BundlesRun() {
+	const auto nRemoteIp = m_nRemoteIp;
+	uint32_t i = 0;
 
-				if (Msg.GetType(0) == osc::type::INT32) {
-					DEBUG_PUTS("i received");
-					nData = static_cast<uint8_t>(Msg.GetInt(0));
-				} else if (Msg.GetType(0) == osc::type::FLOAT) {
-					DEBUG_PRINTF("f received %f", Msg.GetFloat(0));
-					nData = static_cast<uint8_t>(Msg.GetFloat(0) * lightset::dmx::MAX_VALUE);
-				} else {
-					return;
-				}
+	while (i < m_nBundlesPending) {
+		auto& bundle = s_Bundles[i];
 
-				DEBUG_PRINTF("Channel = %d, Data = %.2x", nChannel, nData);
+		if (!BundleIsDue(bundle.nTimeTag)) {
+			i++;
+			continue;
+		}
 
-				bIsDmxDataChanged = IsDmxDataChanged(&nData, nChannel, 1);
+		m_nRemoteIp = bundle.nRemoteIp;
+		HandleBundle(bundle.aData, bundle.nLength, 0);
 
-				if (bIsDmxDataChanged || m_bEnableNoChangeUpdate) {
-					if (!m_bPartialTransmission) {
-						m_pLightSet->SetData(0, s_pData, lightset::dmx::UNIVERSE_SIZE);
-					} else {
-						m_nLastChannel = nChannel > m_nLastChannel ? nChannel : m_nLastChannel;
-						m_pLightSet->SetData(0, s_pData, m_nLastChannel);
-					}
+		// Keep the order of arrival for the remaining bundles
+		m_nBundlesPending--;
 
-					if (!m_bIsRunning) {
-						m_bIsRunning = true;
-						m_pLightSet->Start(0);
-					}
-				}
-			}
+		for (auto j = i; j < m_nBundlesPending; j++) {
+			memcpy(&s_Bundles[j], &s_Bundles[j + 1], offsetof(osc::server::Bundle, aData) + s_Bundles[j + 1].nLength);
+		}
+	}
+
+	m_nRemoteIp = nRemoteIp;
+}
+
+void OscServer::Handle(const uint8_t *pBuffer, uint32_t nLength) {
+	debug_dump(pBuffer, static_cast<uint16_t>(nLength));
+
+	if (osc::bundle::is_bundle(pBuffer, nLength)) {
+		const auto nTimeTag = osc::bundle::get_timetag(pBuffer);
+
+		if (BundleIsDue(nTimeTag)) {
+			HandleBundle(pBuffer, nLength, 0);
+		} else {
+			BundleSchedule(pBuffer, nLength, nTimeTag);
 		}
 
 		return;
 	}
 
-	if (osc::is_match(s_pUdpBuffer, "/ping")) {
-		DEBUG_PUTS("ping received");
-		OscSimpleSend MsgSend(m_nHandle, nRemoteIp, m_nPortOutgoing, "/pong", nullptr);
+	HandleMessage(pBuffer, nLength);
+}
+
+void OscServer::Run() {
+	if (m_nBundlesPending != 0) {
+		BundlesRun();
+		Commit();
+	}
+
+	uint16_t nRemotePort;
+
+	auto nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&s_pUdpBuffer)), &m_nRemoteIp, &nRemotePort);
 
+	if (__builtin_expect((nBytesReceived == 0), 1)) {
 		return;
 	}
 
-	if (osc::is_match(s_pUdpBuffer, s_aPathInfo)) {
-		OscSimpleSend MsgSendInfo(m_nHandle, nRemoteIp, m_nPortOutgoing, "/info/os", "s", m_Os);
-		OscSimpleSend MsgSendModel(m_nHandle, nRemoteIp, m_nPortOutgoing, "/info/model", "s", m_pModel);
-		OscSimpleSend MsgSendSoc(m_nHandle, nRemoteIp, m_nPortOutgoing, "/info/soc", "s", m_pSoC);
+	/*
+	 * Drain the packets which are already received, so that
+	 * a burst of per channel messages gives one output update per port.
+	 */
+
+	for (uint32_t nPackets = 1; ; nPackets++) {
+		Handle(reinterpret_cast<uint8_t *>(s_pUdpBuffer), nBytesReceived);
 
-		if (m_pOscServerHandler != nullptr) {
-			m_pOscServerHandler->Info(m_nHandle, nRemoteIp, m_nPortOutgoing);
+		if (nPackets == osc::server::Max::PACKETS_PER_RUN) {
+			break;
 		}
 
-		return;
+		nBytesReceived = Network::Get()->RecvFrom(m_nHandle, const_cast<const void **>(reinterpret_cast<void **>(&s_pUdpBuffer)), &m_nRemoteIp, &nRemotePort);
+
+		if (nBytesReceived == 0) {
+			break;
+		}
 	}
+
+	Commit();
 }
 
 void OscServer::Print() {
@@ -397,4 +594,10 @@ void OscServer::Print() {
 	printf(" DMX Path             : [%s][%s]\n", s_aPath, s_aPathSecond);
 	printf("  Blackout Path       : [%s]\n", s_aPathBlackOut);
 	printf(" Partial Transmission : %s\n", m_bPartialTransmission ? "Yes" : "No");
+
+	if (m_nPorts > 1) {
+		char aPath[osc::server::Max::PATH_LENGTH + 8];
+		PortPath(m_nPorts - 1, aPath, sizeof(aPath));
+		printf(" Ports                : %u [%s .. %s]\n", static_cast<unsigned int>(m_nPorts), s_aPath, aPath);
+	}
 }
@@ -139,6 +139,17 @@ void OSCServerParams::callbackFunction(const char *pLine) {
 		return;
 	}
 
+	if (Sscan::Uint8(pLine, OscServerParamsConst::PORTS, nValue8) == Sscan::OK) {
+		if ((nValue8 > 1) && (nValue8 <= osc::server::Max::PORTS)) {
+			m_Params.nPorts = nValue8;
+			m_Params.nSetList |= ParamsMask::PORTS;
+		} else {
+			m_Params.nPorts = 1;
+			m_Params.nSetList &= ~ParamsMask::PORTS;
+		}
+		return;
+	}
+
 	uint32_t nLength = sizeof(m_Params.aPath) - 1;
 	if (Sscan::Char(pLine, OscServerParamsConst::PATH, m_Params.aPath, nLength) == Sscan::OK) {
 		m_Params.nSetList |= ParamsMask::PATH;
@@ -184,6 +195,10 @@ void OSCServerParams::Set(OscServer *pOscServer) {
 	if (isMaskSet(ParamsMask::TRANSMISSION)) {
 		pOscServer->SetPartialTransmission(m_Params.bPartialTransmission);
 	}
+
+	if (isMaskSet(ParamsMask::PORTS)) {
+		pOscServer->SetPorts(m_Params.nPorts);
+	}
 }
 
 void OSCServerParams::Builder(const osc::server::Params *ptOSCServerParams, char *pBuffer, uint32_t nLength, uint32_t& nSize) {
@@ -218,6 +233,12 @@ void OSCServerParams::Builder(const osc::server::Params *ptOSCServerParams, char
 	builder.Add(OscServerParamsConst::PATH_BLACKOUT, m_Params.aPathBlackOut, isMaskSet(ParamsMask::PATH_BLACKOUT));
 	builder.Add(OscServerParamsConst::TRANSMISSION, m_Params.bPartialTransmission, isMaskSet(ParamsMask::TRANSMISSION));
 
+	if (!isMaskSet(ParamsMask::PORTS)) {
+		m_Params.nPorts = static_cast<uint8_t>(OscServer::Get()->GetPorts());
+	}
+
+	builder.Add(OscServerParamsConst::PORTS, m_Params.nPorts, isMaskSet(ParamsMask::PORTS));
+
 	nSize = builder.GetSize();
 
 	DEBUG_EXIT
@@ -238,4 +259,5 @@ void OSCServerParams::Dump() {
 	printf(" %s=%s\n", OscServerParamsConst::PATH_INFO, m_Params.aPathInfo);
 	printf(" %s=%s\n", OscServerParamsConst::PATH_BLACKOUT, m_Params.aPathBlackOut);
 	printf(" %s=%d\n", OscServerParamsConst::TRANSMISSION, m_Params.bPartialTransmission);
+	printf(" %s=%d\n", OscServerParamsConst::PORTS, m_Params.nPorts);
 }
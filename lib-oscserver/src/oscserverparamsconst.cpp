@@ -32,3 +32,5 @@ const char OscServerParamsConst::PATH_INFO[] = "path_info";
 const char OscServerParamsConst::PATH_BLACKOUT[] = "path_blackout";
 
 const char OscServerParamsConst::TRANSMISSION[] = "partial_transmission";
+
+const char OscServerParamsConst::PORTS[] = "active_ports";
@@ -27,6 +27,7 @@
 #define PCA9685_H_
 
 #include <cstdint>
+#include <cassert>
 
 namespace pca9685 {
 static constexpr uint8_t I2C_ADDRESS_DEFAULT = 0x40;
@@ -92,6 +93,24 @@ public:
 	void SetFullOn(const uint32_t nChannel, const bool bMode);
 	void SetFullOff(const uint32_t nChannel, const bool bMode);
 
+	/**
+	 * The channel is written with the next Update(), only when it is changed.
+	 */
+	void Stage(const uint32_t nChannel, const uint16_t nOn, const uint16_t nOff) {
+		assert(nChannel < pca9685::PWM_CHANNELS);
+
+		if ((m_nOn[nChannel] != nOn) || (m_nOff[nChannel] != nOff)) {
+			m_nOn[nChannel] = nOn;
+			m_nOff[nChannel] = nOff;
+			m_nDirty |= static_cast<uint16_t>(1U << nChannel);
+		}
+	}
+
+	/**
+	 * Each run of contiguous staged channels is written in one I2C transfer (Auto-Increment).
+	 */
+	void Update();
+
 	void Dump();
 
 private:
@@ -115,6 +134,15 @@ private:
 
 private:
 	uint8_t m_nAddress;
+	/*
+	 * Shadow registers, there is no need to read the device.
+	 */
+	uint8_t m_nMode1;
+	uint8_t m_nMode2;
+	uint8_t m_nPreScale;
+	uint16_t m_nDirty { 0 };
+	uint16_t m_nOn[pca9685::PWM_CHANNELS];
+	uint16_t m_nOff[pca9685::PWM_CHANNELS];
 };
 
 #endif /* PCA9685_H_ */
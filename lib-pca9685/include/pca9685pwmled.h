@@ -43,24 +43,49 @@ public:
 	}
 
 	void Set(const uint32_t nChannel, const uint16_t nData) {
-		if (nData >= 0xFFF) {
-			SetFullOn(nChannel, true);
-		} else if (nData == 0) {
-			SetFullOff(nChannel, true);
-		} else {
-			Write(nChannel, nData);
-		}
+		Write(nChannel, On(nData), Off(nData));
 	}
 
 	void Set(const uint32_t nChannel, const uint8_t nData) {
-		if (nData == 0xFF) {
-			SetFullOn(nChannel, true);
-		} else if (nData == 0) {
-			SetFullOff(nChannel, true);
-		} else {
-			const auto nValue = static_cast<uint16_t>((nData << 4) | (nData >> 4));
-			Write(nChannel, nValue);
+		Set(nChannel, Expand(nData));
+	}
+
+	using PCA9685::Stage;
+
+	/**
+	 * Written with Update()
+	 */
+	void Stage(const uint32_t nChannel, const uint16_t nData) {
+		Stage(nChannel, On(nData), Off(nData));
+	}
+
+	void Stage(const uint32_t nChannel, const uint8_t nData) {
+		Stage(nChannel, Expand(nData));
+	}
+
+private:
+	/*
+	 * Full on is bit 4 of LEDn_ON_H, full off is bit 4 of LEDn_OFF_H (full off has precedence).
+	 * The complete registers are written, no read-modify-write needed.
+	 */
+	static uint16_t On(const uint16_t nData) {
+		return (nData >= 0xFFF) ? static_cast<uint16_t>(0x1000) : static_cast<uint16_t>(0);
+	}
+
+	static uint16_t Off(const uint16_t nData) {
+		if (nData >= 0xFFF) {
+			return 0;
+		}
+
+		if (nData == 0) {
+			return 0x1000;
 		}
+
+		return nData;
+	}
+
+	static uint16_t Expand(const uint8_t nData) {
+		return static_cast<uint16_t>((nData << 4) | (nData >> 4));
 	}
 };
 
@@ -82,27 +82,25 @@ public:
 		return m_nCenterUs;
 	}
 
-	void Set(const uint32_t nChannel, uint16_t nData) {
-		if (nData > m_nRightCount) {
-			nData = m_nRightCount;
-		} else if (nData < m_nLeftCount) {
-			nData = m_nLeftCount;
-		}
-
-		Write(nChannel, nData);
+	void Set(const uint32_t nChannel, const uint16_t nData) {
+		Write(nChannel, Clamp(nData));
 	}
 
 	void Set(const uint32_t nChannel, const uint8_t nData) {
-		if (nData == 0) {
-			Write(nChannel, m_nLeftCount);
-		} else if (nData == (0xFF + 1) / 2) {
-			Write(nChannel, m_nCenterCount);
-		}  else if (nData == 0xFF) {
-			Write(nChannel, m_nRightCount);
-		} else {
-			const auto nCount = static_cast<uint16_t>(m_nLeftCount + (.5f + (static_cast<float>((m_nRightCount - m_nLeftCount)) / 0xFF) * nData));
-			Write(nChannel, nCount);
-		}
+		Write(nChannel, Count(nData));
+	}
+
+	using PCA9685::Stage;
+
+	/**
+	 * Written with Update()
+	 */
+	void Stage(const uint32_t nChannel, const uint16_t nData) {
+		Stage(nChannel, static_cast<uint16_t>(0), Clamp(nData));
+	}
+
+	void Stage(const uint32_t nChannel, const uint8_t nData) {
+		Stage(nChannel, static_cast<uint16_t>(0), Count(nData));
 	}
 
 	void SetAngle(const uint32_t nChannel, const uint8_t nAngle) {
@@ -122,6 +120,34 @@ public:
 	}
 
 private:
+	uint16_t Clamp(const uint16_t nData) const {
+		if (nData > m_nRightCount) {
+			return m_nRightCount;
+		}
+
+		if (nData < m_nLeftCount) {
+			return m_nLeftCount;
+		}
+
+		return nData;
+	}
+
+	uint16_t Count(const uint8_t nData) const {
+		if (nData == 0) {
+			return m_nLeftCount;
+		}
+
+		if (nData == (0xFF + 1) / 2) {
+			return m_nCenterCount;
+		}
+
+		if (nData == 0xFF) {
+			return m_nRightCount;
+		}
+
+		return static_cast<uint16_t>(m_nLeftCount + (.5f + (static_cast<float>((m_nRightCount - m_nLeftCount)) / 0xFF) * nData));
+	}
+
 	void CalcLeftCount() {
 		m_nLeftCount = static_cast<uint16_t>((.5f + ((204.8f * m_nLeftUs) / 1000U)));
 	}
@@ -87,17 +87,30 @@ enum TPCA9685Och {
 PCA9685::PCA9685(uint8_t nAddress) : m_nAddress(nAddress) {
 	FUNC_PREFIX(i2c_begin());
 
+	/*
+	 * The only reads, from here the shadow registers are used.
+	 * Writing a logic 1 to RESTART is a restart of the PWM channels, it is not kept.
+	 */
+	m_nMode1 = static_cast<uint8_t>(I2cReadReg(PCA9685_REG_MODE1) & ~PCA9685_MODE1_RESTART);
+	m_nMode2 = I2cReadReg(PCA9685_REG_MODE2);
+	m_nPreScale = I2cReadReg(PCA9685_REG_PRE_SCALE);
+
 	AutoIncrement(true);
 
-	for (uint32_t i = 0; i < 16; i ++) {
-		Write(static_cast<uint8_t>(i), static_cast<uint16_t>(0), static_cast<uint16_t>(0x1000));
+	for (uint32_t i = 0; i < pca9685::PWM_CHANNELS; i++) {
+		m_nOn[i] = 0;
+		m_nOff[i] = 0x1000;
 	}
 
+	m_nDirty = 0xFFFF;
+
+	Update();
+
 	Sleep(false);
 }
 
 void PCA9685::Sleep(bool bMode) {
-	auto nData = I2cReadReg(PCA9685_REG_MODE1);
+	auto nData = m_nMode1;
 
 	nData &= static_cast<uint8_t>(~PCA9685_MODE1_SLEEP);
 
@@ -105,6 +118,7 @@ void PCA9685::Sleep(bool bMode) {
 		nData |= PCA9685_MODE1_SLEEP;
 	}
 
+	m_nMode1 = nData;
 	I2cWriteReg(PCA9685_REG_MODE1, nData);
 
 //	if (nData & ~PCA9685_MODE1_RESTART) {
@@ -117,12 +131,13 @@ void PCA9685::SetPreScaller(uint8_t nPrescale) {
 	nPrescale = nPrescale < PCA9685_PRE_SCALE_MIN ? PCA9685_PRE_SCALE_MIN : nPrescale;
 
 	Sleep(true);
+	m_nPreScale = nPrescale;
 	I2cWriteReg(PCA9685_REG_PRE_SCALE, nPrescale);
 	Sleep(false);
 }
 
 uint8_t PCA9685::GetPreScaller() {
-	return 	I2cReadReg(PCA9685_REG_PRE_SCALE);
+	return m_nPreScale;
 }
 
 void PCA9685::SetFrequency(uint16_t nFreq) {
@@ -134,7 +149,7 @@ uint16_t PCA9685::GetFrequency() {
 }
 
 void PCA9685::SetOCH(pca9685::Och och) {
-	auto nData = I2cReadReg(PCA9685_REG_MODE2);
+	auto nData = m_nMode2;
 
 	nData &= static_cast<uint8_t>(~PCA9685_MODE2_OCH);
 
@@ -142,43 +157,46 @@ void PCA9685::SetOCH(pca9685::Och och) {
 		nData |= PCA9685_OCH_ACK;
 	} // else, default Outputs change on STOP command
 
+	m_nMode2 = nData;
 	I2cWriteReg(PCA9685_REG_MODE2, nData);
 }
 
 pca9685::Och PCA9685::GetOCH() {
-	const auto isOchACK = (I2cReadReg(PCA9685_REG_MODE2) & PCA9685_MODE2_OCH) == PCA9685_MODE2_OCH;
+	const auto isOchACK = (m_nMode2 & PCA9685_MODE2_OCH) == PCA9685_MODE2_OCH;
 	return isOchACK ? pca9685::Och::PCA9685_OCH_ACK : pca9685::Och::PCA9685_OCH_STOP;
 }
 
 void PCA9685::SetInvert(const pca9685::Invert invert) {
-	auto Data = I2cReadReg(PCA9685_REG_MODE2);
+	auto Data = m_nMode2;
 	Data &= static_cast<uint8_t>(~PCA9685_MODE2_INVRT);
 
 	if (invert == pca9685::Invert::OUTPUT_INVERTED) {
 		Data |= PCA9685_MODE2_INVRT;
 	}
 
+	m_nMode2 = Data;
 	I2cWriteReg(PCA9685_REG_MODE2, Data);
 }
 
 pca9685::Invert PCA9685::GetInvert() {
-	const auto nData = I2cReadReg(PCA9685_REG_MODE2) & PCA9685_MODE2_INVRT;
+	const auto nData = m_nMode2 & PCA9685_MODE2_INVRT;
 	return (nData == PCA9685_MODE2_INVRT) ? pca9685::Invert::OUTPUT_INVERTED : pca9685::Invert::OUTPUT_NOT_INVERTED;
 }
 
 void PCA9685::SetOutDriver(const pca9685::Output output) {
-	auto nData = I2cReadReg(PCA9685_REG_MODE2);
+	auto nData = m_nMode2;
 	nData &= static_cast<uint8_t>(~PCA9685_MODE2_OUTDRV);
 
 	if (output == pca9685::Output::DRIVER_TOTEMPOLE) {
 		nData |= PCA9685_MODE2_OUTDRV;
 	}
 
+	m_nMode2 = nData;
 	I2cWriteReg(PCA9685_REG_MODE2, nData);
 }
 
 pca9685::Output PCA9685::GetOutDriver() {
-	const auto nData = I2cReadReg(PCA9685_REG_MODE2) & PCA9685_MODE2_OUTDRV;
+	const auto nData = m_nMode2 & PCA9685_MODE2_OUTDRV;
 	return (nData == PCA9685_MODE2_OUTDRV) ? pca9685::Output::DRIVER_TOTEMPOLE : pca9685::Output::DRIVER_OPENDRAIN;
 }
 
@@ -187,13 +205,59 @@ void PCA9685::Write(const uint32_t nChannel, const uint16_t nOn, const uint16_t
 
 	if (nChannel <= 15) {
 		reg = static_cast<uint8_t>(PCA9685_REG_LED0_ON_L + (nChannel << 2));
+		m_nOn[nChannel] = nOn;
+		m_nOff[nChannel] = nOff;
+		m_nDirty &= static_cast<uint16_t>(~(1U << nChannel));
 	} else {
 		reg = PCA9685_REG_ALL_LED_ON_L;
+
+		for (uint32_t i = 0; i < pca9685::PWM_CHANNELS; i++) {
+			m_nOn[i] = nOn;
+			m_nOff[i] = nOff;
+		}
+
+		m_nDirty = 0;
 	}
 
 	I2cWriteReg(reg, nOn, nOff);
 }
 
+void PCA9685::Update() {
+	if (m_nDirty == 0) {
+		return;
+	}
+
+	uint32_t nDirty = m_nDirty;
+	m_nDirty = 0;
+
+	char buffer[1 + 4 * pca9685::PWM_CHANNELS];
+
+	I2cSetup();
+
+	while (nDirty != 0) {
+		const auto nFirst = static_cast<uint32_t>(__builtin_ctz(nDirty));
+		auto nLast = nFirst;
+
+		while ((nLast < (pca9685::PWM_CHANNELS - 1)) && ((nDirty & (1U << (nLast + 1))) != 0)) {
+			nLast++;
+		}
+
+		buffer[0] = static_cast<char>(PCA9685_REG_LED0_ON_L + (nFirst << 2));
+		auto *pBuffer = &buffer[1];
+
+		for (auto nChannel = nFirst; nChannel <= nLast; nChannel++) {
+			*pBuffer++ = static_cast<char>(m_nOn[nChannel] & 0xFF);
+			*pBuffer++ = static_cast<char>(m_nOn[nChannel] >> 8);
+			*pBuffer++ = static_cast<char>(m_nOff[nChannel] & 0xFF);
+			*pBuffer++ = static_cast<char>(m_nOff[nChannel] >> 8);
+		}
+
+		FUNC_PREFIX(i2c_write(buffer, static_cast<uint32_t>(pBuffer - buffer)));
+
+		nDirty &= ~(((2U << nLast) - 1) & ~((1U << nFirst) - 1));
+	}
+}
+
 void PCA9685::Write(const uint32_t nChannel, const uint16_t nValue) {
 	Write(nChannel, static_cast<uint16_t>(0), nValue);
 }
@@ -233,16 +297,21 @@ void PCA9685::Read(uint16_t *pOn, uint16_t *pOff) {
 
 void PCA9685::SetFullOn(const uint32_t nChannel, const bool bMode) {
 	uint8_t reg;
+	uint8_t Data;
 
 	if (nChannel <= 15) {
 		reg = static_cast<uint8_t>(PCA9685_REG_LED0_ON_H + (nChannel << 2));
+		Data = static_cast<uint8_t>(m_nOn[nChannel] >> 8);
+		Data = bMode ? (Data | 0x10) : (Data & 0xEF);
+		m_nOn[nChannel] = static_cast<uint16_t>((m_nOn[nChannel] & 0xFF) | (Data << 8));
 	} else {
 		reg = PCA9685_REG_ALL_LED_ON_H;
-	}
+		Data = bMode ? 0x10 : 0x00;
 
-	uint8_t Data = I2cReadReg(reg);
-
-	Data = bMode ? (Data | 0x10) : (Data & 0xEF);
+		for (uint32_t i = 0; i < pca9685::PWM_CHANNELS; i++) {
+			m_nOn[i] = static_cast<uint16_t>((m_nOn[i] & 0xFF) | (Data << 8));
+		}
+	}
 
 	I2cWriteReg(reg, Data);
 
@@ -254,16 +323,21 @@ void PCA9685::SetFullOn(const uint32_t nChannel, const bool bMode) {
 
 void PCA9685::SetFullOff(const uint32_t nChannel, const bool bMode) {
 	uint8_t reg;
+	uint8_t Data;
 
 	if (nChannel <= 15) {
 		reg = static_cast<uint8_t>(PCA9685_REG_LED0_OFF_H + (nChannel << 2));
+		Data = static_cast<uint8_t>(m_nOff[nChannel] >> 8);
+		Data = bMode ? (Data | 0x10) : (Data & 0xEF);
+		m_nOff[nChannel] = static_cast<uint16_t>((m_nOff[nChannel] & 0xFF) | (Data << 8));
 	} else {
 		reg = PCA9685_REG_ALL_LED_OFF_H;
-	}
+		Data = bMode ? 0x10 : 0x00;
 
-	uint8_t Data = I2cReadReg(reg);
-
-	Data = bMode ? (Data | 0x10) : (Data & 0xEF);
+		for (uint32_t i = 0; i < pca9685::PWM_CHANNELS; i++) {
+			m_nOff[i] = static_cast<uint16_t>((m_nOff[i] & 0xFF) | (Data << 8));
+		}
+	}
 
 	I2cWriteReg(reg, Data);
 }
@@ -347,7 +421,7 @@ void PCA9685::Dump() {
 }
 
 void PCA9685::AutoIncrement(bool bMode) {
-	auto nData = I2cReadReg(PCA9685_REG_MODE1);
+	auto nData = m_nMode1;
 
 	nData &= static_cast<uint8_t>(~PCA9685_MODE1_AI);	// 0 Register Auto-Increment disabled. {default}
 
@@ -355,6 +429,7 @@ void PCA9685::AutoIncrement(bool bMode) {
 		nData |= PCA9685_MODE1_AI;	// 1 Register Auto-Increment enabled.
 	}
 
+	m_nMode1 = nData;
 	I2cWriteReg(PCA9685_REG_MODE1, nData);
 }
 
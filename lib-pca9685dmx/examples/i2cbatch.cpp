@@ -0,0 +1,301 @@
+/**
+ * @file i2cbatch.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * PCA9685DmxLed on a mock I2C bus.
+ * The mock bus is a register model of the PCA9685 (Auto-Increment, ALL_LED),
+ * it counts the transfers, the bytes and the reads.
+ * - Verify: the PWM duty cycle of all channels after each DMX frame.
+ * - Compare: per changed channel transfers (Set) against the staged runs (Stage, Update).
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "pca9685dmxled.h"
+#include "hal_i2c.h"
+#include "configstore.h"
+
+namespace mock {
+static constexpr uint32_t DEVICES = 64;
+static constexpr uint8_t MODE1_AI = 1U << 5;
+
+struct Device {
+	uint8_t reg[256];
+	uint8_t nPointer;
+	bool bInitialized;
+};
+
+static Device s_Devices[DEVICES];
+static uint8_t s_nAddress;
+static uint32_t s_nTransfers;
+static uint32_t s_nBytes;
+static uint32_t s_nReads;
+static uint32_t s_nClocks;
+
+static Device& device() {
+	assert(s_nAddress >= pca9685::I2C_ADDRESS_DEFAULT);
+	auto& device = s_Devices[s_nAddress - pca9685::I2C_ADDRESS_DEFAULT];
+
+	if (!device.bInitialized) {
+		memset(device.reg, 0, sizeof(device.reg));
+		device.reg[0x00] = 0x11;	// MODE1, SLEEP | ALLCALL
+		device.reg[0x01] = 0x04;	// MODE2, OUTDRV
+		device.reg[0xFE] = 0x1E;	// PRE_SCALE, 200 Hz
+		device.bInitialized = true;
+	}
+
+	return device;
+}
+
+static void transfer(uint32_t nLength) {
+	s_nTransfers++;
+	s_nBytes += 1 + nLength;
+	s_nClocks += 1 + (1 + nLength) * 9 + 1;	// START, address and data with ACK, STOP
+}
+
+static void reset_counters() {
+	s_nTransfers = 0;
+	s_nBytes = 0;
+	s_nReads = 0;
+	s_nClocks = 0;
+}
+
+static uint32_t duty(uint32_t nBoard, uint32_t nChannel) {
+	const auto *pReg = &s_Devices[nBoard].reg[0x06 + 4 * nChannel];
+	const auto nOn = static_cast<uint32_t>(pReg[0] | (pReg[1] << 8));
+	const auto nOff = static_cast<uint32_t>(pReg[2] | (pReg[3] << 8));
+
+	if (nOff & 0x1000) {
+		return 0;
+	}
+
+	if (nOn & 0x1000) {
+		return 4096;
+	}
+
+	return ((nOff & 0xFFF) - (nOn & 0xFFF)) & 0xFFF;
+}
+}  // namespace mock
+
+void i2c_begin() {}
+void i2c_set_baudrate(__attribute__((unused)) uint32_t nBaudrate) {}
+
+void i2c_set_address(uint8_t nAddress) {
+	mock::s_nAddress = nAddress;
+}
+
+uint8_t i2c_write(const char *pBuffer, uint32_t nLength) {
+	mock::transfer(nLength);
+
+	auto& device = mock::device();
+
+	if (nLength == 0) {
+		return 0;
+	}
+
+	device.nPointer = static_cast<uint8_t>(pBuffer[0]);
+
+	for (uint32_t i = 1; i < nLength; i++) {
+		const auto nReg = device.nPointer;
+		const auto nData = static_cast<uint8_t>(pBuffer[i]);
+
+		if ((nReg >= 0xFA) && (nReg <= 0xFD)) {
+			for (uint32_t nChannel = 0; nChannel < pca9685::PWM_CHANNELS; nChannel++) {
+				device.reg[0x06 + 4 * nChannel + (nReg - 0xFA)] = nData;
+			}
+		} else {
+			device.reg[nReg] = nData;
+		}
+
+		if (device.reg[0x00] & mock::MODE1_AI) {
+			device.nPointer++;
+		}
+	}
+
+	return 0;
+}
+
+uint8_t i2c_read(char *pBuffer, uint32_t nLength) {
+	mock::transfer(nLength);
+	mock::s_nReads++;
+
+	auto& device = mock::device();
+
+	for (uint32_t i = 0; i < nLength; i++) {
+		pBuffer[i] = static_cast<char>(device.reg[device.nPointer]);
+
+		if (device.reg[0x00] & mock::MODE1_AI) {
+			device.nPointer++;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Stand-in, the DMX start address is not saved
+ */
+ConfigStore *ConfigStore::s_pThis;
+void ConfigStore::Update(__attribute__((unused)) configstore::Store store, __attribute__((unused)) uint32_t nOffset, __attribute__((unused)) const void *pData, __attribute__((unused)) uint32_t nDataLength, __attribute__((unused)) uint32_t nSetList, __attribute__((unused)) uint32_t nOffsetSetList) {}
+
+static constexpr uint32_t BOARDS = 16;
+static uint32_t s_nErrors;
+
+static uint32_t expected_duty(uint8_t nValue) {
+	if (nValue == 0xFF) {
+		return 4096;
+	}
+
+	return static_cast<uint32_t>((nValue << 4) | (nValue >> 4));
+}
+
+static void verify(const uint8_t *pDmxData, const char *pTest) {
+	for (uint32_t i = 0; i < BOARDS * pca9685::PWM_CHANNELS; i++) {
+		const auto nDuty = mock::duty(i / pca9685::PWM_CHANNELS, i % pca9685::PWM_CHANNELS);
+
+		if (nDuty != expected_duty(pDmxData[i])) {
+			if (s_nErrors++ < 10) {
+				printf("FAIL %s: channel %u duty %u expected %u\n", pTest, i, nDuty, expected_duty(pDmxData[i]));
+			}
+		}
+	}
+}
+
+static void report(const char *pTest) {
+	printf("%-36s %5u %6u %5u %8.1f\n", pTest, mock::s_nTransfers, mock::s_nBytes, mock::s_nReads, mock::s_nClocks / 400.0);
+}
+
+int main() {
+	pca9685dmx::Configuration configuration;
+	configuration.nMode = 0;
+	configuration.nAddress = pca9685::I2C_ADDRESS_DEFAULT;
+	configuration.nChannelCount = BOARDS * pca9685::PWM_CHANNELS;
+	configuration.nDmxStartAddress = 1;
+	configuration.bUse8Bit = true;
+	configuration.led.nLedPwmFrequency = pca9685::pwmled::DEFAULT_FREQUENCY;
+	configuration.led.invert = pca9685::Invert::OUTPUT_NOT_INVERTED;
+	configuration.led.output = pca9685::Output::DRIVER_TOTEMPOLE;
+
+	mock::reset_counters();
+
+	PCA9685DmxLed dmxLed(configuration);
+
+	printf("%u boards, %u channels 8-bit, I2C 400 kHz\n\n", BOARDS, configuration.nChannelCount);
+	printf("%-36s %5s %6s %5s %8s\n", "", "xfers", "bytes", "reads", "bus ms");
+	report("Initialization");
+
+	std::mt19937 rng(20240601);
+	static uint8_t dmxData[lightset::dmx::UNIVERSE_SIZE];
+
+	/*
+	 * Staged, as PCA9685DmxLed::SetData
+	 */
+
+	for (uint32_t i = 0; i < lightset::dmx::UNIVERSE_SIZE; i++) {
+		dmxData[i] = static_cast<uint8_t>(rng());
+	}
+
+	dmxData[0] = 0x00;
+	dmxData[1] = 0xFF;
+
+	mock::reset_counters();
+	dmxLed.SetData(0, dmxData, lightset::dmx::UNIVERSE_SIZE);
+	report("SetData, all channels changed");
+	verify(dmxData, "all channels");
+
+	mock::reset_counters();
+	dmxLed.SetData(0, dmxData, lightset::dmx::UNIVERSE_SIZE);
+	report("SetData, nothing changed");
+	verify(dmxData, "nothing changed");
+
+	// A RGB fixture on each board
+	for (uint32_t j = 0; j < BOARDS; j++) {
+		for (uint32_t i = 4; i < 7; i++) {
+			dmxData[j * pca9685::PWM_CHANNELS + i] ^= 0x5A;
+		}
+	}
+
+	mock::reset_counters();
+	dmxLed.SetData(0, dmxData, lightset::dmx::UNIVERSE_SIZE);
+	report("SetData, 3 channels each board");
+	verify(dmxData, "3 channels");
+
+	uint32_t nChanged = 0;
+
+	for (uint32_t nFrame = 0; nFrame < 1000; nFrame++) {
+		for (uint32_t i = 0; i < BOARDS * pca9685::PWM_CHANNELS; i++) {
+			if ((rng() % 4) == 0) {
+				dmxData[i] = static_cast<uint8_t>(rng());
+				nChanged++;
+			}
+		}
+
+		if (nFrame == 0) {
+			mock::reset_counters();
+		}
+
+		// Split in two parts, the second part with doUpdate
+		dmxLed.SetData(0, dmxData, lightset::dmx::UNIVERSE_SIZE, false);
+		dmxLed.Sync(false);
+		verify(dmxData, "random");
+	}
+
+	printf("%-36s %5u %6u %5u %8.1f\n", "SetData, 25% random (per frame)", mock::s_nTransfers / 1000, mock::s_nBytes / 1000, mock::s_nReads, mock::s_nClocks / 400.0 / 1000);
+
+	/*
+	 * Reference, one transfer for each changed channel
+	 */
+
+	PCA9685PWMLed *pPWMLed[BOARDS];
+
+	for (uint32_t j = 0; j < BOARDS; j++) {
+		pPWMLed[j] = new PCA9685PWMLed(static_cast<uint8_t>(pca9685::I2C_ADDRESS_DEFAULT + j));
+	}
+
+	for (uint32_t i = 0; i < BOARDS * pca9685::PWM_CHANNELS; i++) {
+		dmxData[i] = static_cast<uint8_t>(~dmxData[i]);
+	}
+
+	mock::reset_counters();
+
+	for (uint32_t i = 0; i < BOARDS * pca9685::PWM_CHANNELS; i++) {
+		pPWMLed[i / pca9685::PWM_CHANNELS]->Set(i % pca9685::PWM_CHANNELS, dmxData[i]);
+	}
+
+	report("Set for each channel, all changed");
+	verify(dmxData, "reference");
+
+	for (uint32_t j = 0; j < BOARDS; j++) {
+		delete pPWMLed[j];
+	}
+
+	printf("\n%u channel changes in 1000 random frames\n", nChanged);
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
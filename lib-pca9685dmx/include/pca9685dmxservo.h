@@ -44,7 +44,11 @@ public:
 
 	void SetData(uint32_t nPortIndex, const uint8_t *pDmxData, uint32_t nLength, const bool doUpdate = true) override;
 	void Sync(__attribute__((unused)) const uint32_t nPortIndex) override {};
-	void Sync(__attribute__((unused)) const bool doForce = false) override {};
+	void Sync(const bool doForce = false) override {
+		if (__builtin_expect((!doForce), 1)) {
+			Update();
+		}
+	}
 
 	bool SetDmxStartAddress(const uint16_t nDmxStartAddress) override {
 		assert((nDmxStartAddress != 0) && (nDmxStartAddress <= lightset::dmx::UNIVERSE_SIZE));
@@ -68,6 +72,13 @@ public:
 
 	void Print() override;
 
+private:
+	void Update() {
+		for (uint32_t j = 0; j < m_nBoardInstances; j++) {
+			m_pServo[j]->Update();
+		}
+	}
+
 private:
 	uint16_t m_nBoardInstances;
 	uint16_t m_nDmxFootprint;
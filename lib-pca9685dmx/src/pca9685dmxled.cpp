@@ -102,7 +102,7 @@ void PCA9685DmxLed::Stop([[maybe_unused]] const uint32_t nPortIndex) {
 	DEBUG_EXIT
 }
 
-void PCA9685DmxLed::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t *pDmxData, uint32_t nLength, [[maybe_unused]] const bool doUpdate) {
+void PCA9685DmxLed::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t *pDmxData, uint32_t nLength, const bool doUpdate) {
 	assert(pDmxData != nullptr);
 	assert(nLength <= lightset::dmx::UNIVERSE_SIZE);
 
@@ -122,9 +122,9 @@ void PCA9685DmxLed::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t
 					*pPreviousData = *pCurrentData;
 					const auto value = *pCurrentData;
 #ifndef NDEBUG
-					printf("m_pPWMLed[%u]->SetDmx(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
+					printf("m_pPWMLed[%u]->Stage(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
 #endif
-					m_pPWMLed[j]->Set(i, value);
+					m_pPWMLed[j]->Stage(i, value);
 				}
 				pCurrentData++;
 				pPreviousData++;
@@ -147,9 +147,9 @@ void PCA9685DmxLed::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t
 					const auto *pData = reinterpret_cast<const uint8_t *>(pCurrentData);
 					const auto value = static_cast<uint16_t>((static_cast<uint32_t>(pData[0]) << 4) | static_cast<uint32_t>(pData[1]));
 #ifndef NDEBUG
-					printf("m_pPWMLed[%u]->SetDmx(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
+					printf("m_pPWMLed[%u]->Stage(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
 #endif
-					m_pPWMLed[j]->Set(i, value);
+					m_pPWMLed[j]->Stage(i, value);
 				}
 				pCurrentData++;
 				pPreviousData++;
@@ -157,6 +157,10 @@ void PCA9685DmxLed::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t
 			}
 		}
 	}
+
+	if (doUpdate) {
+		Update();
+	}
 }
 
 bool PCA9685DmxLed::GetSlotInfo(uint16_t nSlotOffset, lightset::SlotInfo& tSlotInfo) {
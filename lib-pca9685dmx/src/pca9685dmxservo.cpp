@@ -88,7 +88,7 @@ PCA9685DmxServo::~PCA9685DmxServo() {
 	DEBUG_EXIT
 }
 
-void PCA9685DmxServo::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t* pDmxData, uint32_t nLength, [[maybe_unused]] const bool doUpdate) {
+void PCA9685DmxServo::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_t* pDmxData, uint32_t nLength, const bool doUpdate) {
 	assert(pDmxData != nullptr);
 	assert(nLength <= lightset::dmx::UNIVERSE_SIZE);
 
@@ -108,9 +108,9 @@ void PCA9685DmxServo::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_
 					*pPreviousData = *pCurrentData;
 					const auto value = *pCurrentData;
 #ifndef NDEBUG
-					printf("m_pServo[%u]->SetDmx(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
+					printf("m_pServo[%u]->Stage(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
 #endif
-					m_pServo[j]->Set(i, value);
+					m_pServo[j]->Stage(i, value);
 				}
 				pCurrentData++;
 				pPreviousData++;
@@ -133,9 +133,9 @@ void PCA9685DmxServo::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_
 					const auto *pData = reinterpret_cast<const uint8_t *>(pCurrentData);
 					const auto value = static_cast<uint16_t>((static_cast<uint32_t>(pData[0]) << 4) | static_cast<uint32_t>(pData[1]));
 #ifndef NDEBUG
-					printf("m_pServo[%u]->SetDmx(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
+					printf("m_pServo[%u]->Stage(CHANNEL(%u), %u)\n", j, i, static_cast<uint32_t>(value));
 #endif
-					m_pServo[j]->Set(i, value);
+					m_pServo[j]->Stage(i, value);
 				}
 				pCurrentData++;
 				pPreviousData++;
@@ -143,6 +143,10 @@ void PCA9685DmxServo::SetData([[maybe_unused]] uint32_t nPortIndex, const uint8_
 			}
 		}
 	}
+
+	if (doUpdate) {
+		Update();
+	}
 }
 
 void PCA9685DmxServo::Print() {
@@ -38,16 +38,29 @@ struct DevicesParamsConst {
 	static const char COUNT[];
 	static const char GROUPING_COUNT[];
 
+	static const char LAYOUT[];
+	static const char LAYOUT_WIDTH[];
+	static const char LAYOUT_ROTATE[];
+
 	static const char SPI_SPEED_HZ[];
 
 	static const char GLOBAL_BRIGHTNESS[];
 
 	static const char ACTIVE_OUT[];
+	static const char REFRESH_RATE_MAX[];
 
 	static const char TEST_PATTERN[];
 
 	static const char GAMMA_CORRECTION[];
 	static const char GAMMA_VALUE[];
+
+	static const char INPUT_16BIT[];
+	static const char DITHERING[];
+	static const char WHITE_EXTRACTION[];
+	static const char WHITE_BALANCE_RED[];
+	static const char WHITE_BALANCE_GREEN[];
+	static const char WHITE_BALANCE_BLUE[];
+	static const char WHITE_BALANCE_WHITE[];
 };
 
 #endif /* DEVICESPARAMSCONST_H_ */
@@ -0,0 +1,118 @@
+/**
+ * @file jsontokenizer.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef JSONTOKENIZER_H_
+#define JSONTOKENIZER_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace jsontokenizer {
+enum class Type : uint8_t {
+	STRING, NUMBER, LITERAL, OBJECT, ARRAY
+};
+
+/**
+ * Points into the buffer which is tokenized, nothing is copied.
+ * STRING: the characters between the quotes, the escapes are not decoded.
+ * LITERAL: true, false or null.
+ * OBJECT and ARRAY: including the brackets.
+ */
+struct Token {
+	const char *pText;
+	uint32_t nLength;
+	Type type;
+};
+
+inline bool equals(const Token& token, const char *pString) {
+	return (strncmp(token.pText, pString, token.nLength) == 0) && (pString[token.nLength] == '\0');
+}
+
+/**
+ * true is 1, false is 0
+ */
+bool get_uint32(const Token& token, uint32_t& nValue);
+}  // namespace jsontokenizer
+
+/**
+ * Walks through the members of one JSON object.
+ * A member value of type OBJECT can be walked with a new JsonTokenizer.
+ * With NextKey, the value is not scanned: a nested object can be walked
+ * directly from GetText(), the remaining members are then not walked.
+ */
+
+class JsonTokenizer {
+public:
+	JsonTokenizer(const char *pJson, uint32_t nLength);
+
+	bool Next(jsontokenizer::Token& key, jsontokenizer::Token& value) {
+		return NextKey(key) && NextValue(value);
+	}
+
+	/**
+	 * Stops at the first character of the member value
+	 */
+	bool NextKey(jsontokenizer::Token& key);
+	bool NextValue(jsontokenizer::Token& value) {
+		if (m_bError || m_bDone) {
+			return false;
+		}
+		return Value(value);
+	}
+
+	const char *GetText() const {
+		return m_pJson;
+	}
+
+	uint32_t GetLength() const {
+		return static_cast<uint32_t>(m_pEnd - m_pJson);
+	}
+
+	bool IsError() const {
+		return m_bError;
+	}
+
+private:
+	void SkipSpace() {
+		while ((m_pJson < m_pEnd) && ((*m_pJson == ' ') || (*m_pJson == '\t') || (*m_pJson == '\r') || (*m_pJson == '\n'))) {
+			m_pJson++;
+		}
+	}
+	bool String(jsontokenizer::Token& token);
+	bool Value(jsontokenizer::Token& value);
+	bool Error() {
+		m_bError = true;
+		return false;
+	}
+
+private:
+	const char *m_pJson;
+	const char *m_pEnd;
+	bool m_bFirst { true };
+	bool m_bError { false };
+	bool m_bDone { false };
+};
+
+#endif /* JSONTOKENIZER_H_ */
@@ -0,0 +1,127 @@
+/**
+ * @file jsonwriter.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef JSONWRITER_H_
+#define JSONWRITER_H_
+
+#include <cstdint>
+
+namespace jsonwriter {
+static constexpr uint32_t MAX_DEPTH = 16;
+}  // namespace jsonwriter
+
+/**
+ * Streaming JSON writer, the separators are handled by the writer.
+ *
+ * With a flush function, a full buffer is handed over and the writer continues
+ * at the start of the buffer: the output size is not limited by the buffer.
+ * Without a flush function, an element that does not fit is dropped together
+ * with all following elements. The open objects and arrays are still closed,
+ * so the output is always valid JSON.
+ */
+
+class JsonWriter {
+public:
+	typedef void (*FlushFunctionPtr)(void *, const char *, uint32_t);
+
+	JsonWriter(char *pBuffer, uint32_t nBufferSize, FlushFunctionPtr pFlush = nullptr, void *p = nullptr);
+
+	void ObjectBegin(const char *pKey = nullptr) {
+		Begin(pKey, '{', false);
+	}
+	void ObjectEnd() {
+		End();
+	}
+
+	void ArrayBegin(const char *pKey = nullptr) {
+		Begin(pKey, '[', true);
+	}
+	void ArrayEnd() {
+		End();
+	}
+
+	/**
+	 * A nullptr key is an array element
+	 */
+	void Add(const char *pKey, const char *pString);
+	void Add(const char *pKey, const char *pString, uint32_t nMaxLength);
+	void Add(const char *pKey, uint32_t nValue);
+	void Add(const char *pKey, int32_t nValue);
+	void AddIpAddress(const char *pKey, uint32_t nIpAddress);
+	/**
+	 * The value is valid JSON already
+	 */
+	void AddRaw(const char *pKey, const char *pJson, uint32_t nLength);
+
+	/**
+	 * Closes the open objects and arrays.
+	 * Returns the number of bytes in the buffer, these are not flushed.
+	 */
+	uint32_t Finish();
+
+	uint32_t GetSize() const {
+		return m_nSize;
+	}
+
+	bool IsTruncated() const {
+		return m_bTruncated;
+	}
+
+private:
+	void Begin(const char *pKey, const char cOpen, const bool isArray);
+	void End();
+	bool Element(const char *pKey);
+	bool Put(const char c) {
+		if (__builtin_expect((m_nSize < m_nLimit), 1)) {
+			m_pBuffer[m_nSize++] = c;
+			return true;
+		}
+		return Put(&c, 1);
+	}
+	bool Put(const char *pData, uint32_t nLength);
+	bool PutString(const char *pString, uint32_t nMaxLength);
+	bool PutUint(uint32_t nValue);
+	void Mark() {
+		m_nMarkSize = m_nSize;
+		m_nMarkFirst = m_nFirst;
+	}
+	void Rollback();
+
+private:
+	char *m_pBuffer;
+	uint32_t m_nBufferSize;
+	uint32_t m_nLimit;
+	uint32_t m_nSize { 0 };
+	FlushFunctionPtr m_pFlush;
+	void *m_p;
+	uint32_t m_nDepth { 0 };
+	uint32_t m_nFirst { 1 };	// Bit n is set when the container at depth n is still empty
+	uint32_t m_nArray { 0 };	// Bit n is set when the container at depth n is an array
+	uint32_t m_nMarkSize { 0 };
+	uint32_t m_nMarkFirst { 0 };
+	bool m_bTruncated { false };
+};
+
+#endif /* JSONWRITER_H_ */
@@ -35,8 +35,14 @@ public:
 #if !defined(DISABLE_FS)
 	bool Read(const char *pFileName);
 #endif	
+	/**
+	 * A buffer starting with '{' is JSON, each member is a line "key=value".
+	 */
 	void Read(const char *pBuffer, unsigned nLength);
 
+private:
+	void ReadJson(const char *pJson, unsigned nLength, const bool bIsFile);
+
 private:
     CallbackFunctionPtr m_pCallBack;
     void *m_p;
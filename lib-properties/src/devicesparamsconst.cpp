@@ -37,14 +37,27 @@ const char DevicesParamsConst::LED_T1H[] = "led_t1h";
 const char DevicesParamsConst::COUNT[] = "led_count";
 const char DevicesParamsConst::GROUPING_COUNT[] = "led_group_count";
 
+const char DevicesParamsConst::LAYOUT[] = "led_layout";
+const char DevicesParamsConst::LAYOUT_WIDTH[] = "led_layout_width";
+const char DevicesParamsConst::LAYOUT_ROTATE[] = "led_layout_rotate";
+
 const char DevicesParamsConst::SPI_SPEED_HZ[] = "clock_speed_hz";
 
 const char DevicesParamsConst::GLOBAL_BRIGHTNESS[] = "global_brightness";
 
 const char DevicesParamsConst::ACTIVE_OUT[] = "active_out";
+const char DevicesParamsConst::REFRESH_RATE_MAX[] = "refresh_rate_max";
 
 const char DevicesParamsConst::TEST_PATTERN[] = "test_pattern";
 
 const char DevicesParamsConst::GAMMA_CORRECTION[] = "gamma_correction";
 const char DevicesParamsConst::GAMMA_VALUE[] = "gamma_value";
 
+const char DevicesParamsConst::INPUT_16BIT[] = "input_16bit";
+const char DevicesParamsConst::DITHERING[] = "dithering";
+const char DevicesParamsConst::WHITE_EXTRACTION[] = "white_extraction";
+const char DevicesParamsConst::WHITE_BALANCE_RED[] = "white_balance_red";
+const char DevicesParamsConst::WHITE_BALANCE_GREEN[] = "white_balance_green";
+const char DevicesParamsConst::WHITE_BALANCE_BLUE[] = "white_balance_blue";
+const char DevicesParamsConst::WHITE_BALANCE_WHITE[] = "white_balance_white";
+
@@ -0,0 +1,217 @@
+/**
+ * @file jsontokenizer.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#include "jsontokenizer.h"
+
+namespace jsontokenizer {
+bool get_uint32(const Token& token, uint32_t& nValue) {
+	if (token.type == Type::LITERAL) {
+		if (equals(token, "true")) {
+			nValue = 1;
+			return true;
+		}
+
+		if (equals(token, "false")) {
+			nValue = 0;
+			return true;
+		}
+
+		return false;
+	}
+
+	if (((token.type != Type::NUMBER) && (token.type != Type::STRING)) || (token.nLength == 0) || (token.nLength > 10)) {
+		return false;
+	}
+
+	uint64_t nTmp = 0;
+
+	for (uint32_t i = 0; i < token.nLength; i++) {
+		const auto nDigit = static_cast<uint32_t>(token.pText[i] - '0');
+
+		if (nDigit > 9) {
+			return false;
+		}
+
+		nTmp = nTmp * 10 + nDigit;
+	}
+
+	if (nTmp > UINT32_MAX) {
+		return false;
+	}
+
+	nValue = static_cast<uint32_t>(nTmp);
+	return true;
+}
+}  // namespace jsontokenizer
+
+using namespace jsontokenizer;
+
+JsonTokenizer::JsonTokenizer(const char *pJson, uint32_t nLength) : m_pJson(pJson), m_pEnd(pJson + nLength) {
+	assert(pJson != nullptr);
+
+	SkipSpace();
+
+	if ((m_pJson < m_pEnd) && (*m_pJson == '{')) {
+		m_pJson++;
+	} else {
+		m_bError = true;
+	}
+}
+
+bool JsonTokenizer::NextKey(Token& key) {
+	if (m_bError || m_bDone) {
+		return false;
+	}
+
+	SkipSpace();
+
+	if (m_pJson >= m_pEnd) {
+		return Error();
+	}
+
+	if (*m_pJson == '}') {
+		m_bDone = true;
+		return false;
+	}
+
+	if (!m_bFirst) {
+		if (*m_pJson != ',') {
+			return Error();
+		}
+
+		m_pJson++;
+		SkipSpace();
+	}
+
+	m_bFirst = false;
+
+	if (!String(key)) {
+		return false;
+	}
+
+	SkipSpace();
+
+	if ((m_pJson >= m_pEnd) || (*m_pJson != ':')) {
+		return Error();
+	}
+
+	m_pJson++;
+	SkipSpace();
+
+	return m_pJson < m_pEnd ? true : Error();
+}
+
+bool JsonTokenizer::String(Token& token) {
+	if ((m_pJson >= m_pEnd) || (*m_pJson != '"')) {
+		return Error();
+	}
+
+	const auto *pText = ++m_pJson;
+
+	while (m_pJson < m_pEnd) {
+		if (*m_pJson == '"') {
+			token.pText = pText;
+			token.nLength = static_cast<uint32_t>(m_pJson - pText);
+			token.type = Type::STRING;
+			m_pJson++;
+			return true;
+		}
+
+		if (*m_pJson == '\\') {
+			m_pJson++;
+		}
+
+		m_pJson++;
+	}
+
+	return Error();
+}
+
+bool JsonTokenizer::Value(Token& value) {
+	if (m_pJson >= m_pEnd) {
+		return Error();
+	}
+
+	const auto c = *m_pJson;
+
+	if (c == '"') {
+		return String(value);
+	}
+
+	value.pText = m_pJson;
+
+	if ((c == '{') || (c == '[')) {
+		// The nested value is skipped, the strings can have brackets
+		uint32_t nDepth = 0;
+		bool isString = false;
+
+		while (m_pJson < m_pEnd) {
+			const auto d = *m_pJson++;
+
+			if (isString) {
+				if (d == '\\') {
+					m_pJson++;
+				} else if (d == '"') {
+					isString = false;
+				}
+			} else if (d == '"') {
+				isString = true;
+			} else if ((d == '{') || (d == '[')) {
+				nDepth++;
+			} else if ((d == '}') || (d == ']')) {
+				if (--nDepth == 0) {
+					value.nLength = static_cast<uint32_t>(m_pJson - value.pText);
+					value.type = (c == '{') ? Type::OBJECT : Type::ARRAY;
+					return true;
+				}
+			}
+		}
+
+		return Error();
+	}
+
+	while ((m_pJson < m_pEnd) && (*m_pJson != ',') && (*m_pJson != '}') && (*m_pJson != ']')
+			&& (*m_pJson != ' ') && (*m_pJson != '\t') && (*m_pJson != '\r') && (*m_pJson != '\n')) {
+		m_pJson++;
+	}
+
+	value.nLength = static_cast<uint32_t>(m_pJson - value.pText);
+
+	if ((c == '-') || ((c >= '0') && (c <= '9'))) {
+		value.type = Type::NUMBER;
+		return true;
+	}
+
+	if (equals(value, "true") || equals(value, "false") || equals(value, "null")) {
+		value.type = Type::LITERAL;
+		return true;
+	}
+
+	return Error();
+}
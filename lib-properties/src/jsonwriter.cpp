@@ -0,0 +1,292 @@
+/**
+ * @file jsonwriter.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#include "jsonwriter.h"
+
+JsonWriter::JsonWriter(char *pBuffer, uint32_t nBufferSize, FlushFunctionPtr pFlush, void *p) :
+	m_pBuffer(pBuffer), m_nBufferSize(nBufferSize), m_nLimit(nBufferSize), m_pFlush(pFlush), m_p(p) {
+	assert(pBuffer != nullptr);
+	assert(nBufferSize > jsonwriter::MAX_DEPTH);
+}
+
+void JsonWriter::Begin(const char *pKey, const char cOpen, const bool isArray) {
+	assert((m_nDepth + 1) < jsonwriter::MAX_DEPTH);
+
+	if (m_bTruncated) {
+		return;
+	}
+
+	Mark();
+
+	// Without a flush the closing character is reserved
+	if (m_pFlush == nullptr) {
+		m_nLimit--;
+	}
+
+	if (!Element(pKey) || !Put(cOpen)) {
+		if (m_pFlush == nullptr) {
+			m_nLimit++;
+		}
+		Rollback();
+		return;
+	}
+
+	m_nDepth++;
+
+	const auto nBit = 1U << m_nDepth;
+
+	m_nFirst |= nBit;
+
+	if (isArray) {
+		m_nArray |= nBit;
+	} else {
+		m_nArray &= ~nBit;
+	}
+}
+
+void JsonWriter::End() {
+	if (m_bTruncated) {
+		return;
+	}
+
+	assert(m_nDepth > 0);
+
+	const auto c = ((m_nArray >> m_nDepth) & 1U) ? ']' : '}';
+
+	m_nDepth--;
+
+	if (m_pFlush == nullptr) {
+		m_nLimit++;
+	}
+
+	Put(c);
+}
+
+void JsonWriter::Add(const char *pKey, const char *pString) {
+	Add(pKey, pString, UINT32_MAX);
+}
+
+void JsonWriter::Add(const char *pKey, const char *pString, uint32_t nMaxLength) {
+	assert(pString != nullptr);
+
+	if (m_bTruncated) {
+		return;
+	}
+
+	Mark();
+
+	if (!Element(pKey) || !PutString(pString, nMaxLength)) {
+		Rollback();
+	}
+}
+
+void JsonWriter::Add(const char *pKey, uint32_t nValue) {
+	if (m_bTruncated) {
+		return;
+	}
+
+	Mark();
+
+	if (!Element(pKey) || !PutUint(nValue)) {
+		Rollback();
+	}
+}
+
+void JsonWriter::Add(const char *pKey, int32_t nValue) {
+	if (m_bTruncated) {
+		return;
+	}
+
+	Mark();
+
+	if (nValue < 0) {
+		if (!Element(pKey) || !Put('-') || !PutUint(0U - static_cast<uint32_t>(nValue))) {
+			Rollback();
+		}
+		return;
+	}
+
+	if (!Element(pKey) || !PutUint(static_cast<uint32_t>(nValue))) {
+		Rollback();
+	}
+}
+
+void JsonWriter::AddIpAddress(const char *pKey, uint32_t nIpAddress) {
+	if (m_bTruncated) {
+		return;
+	}
+
+	Mark();
+
+	if (!Element(pKey) || !Put('"')
+			|| !PutUint(nIpAddress & 0xFF) || !Put('.')
+			|| !PutUint((nIpAddress >> 8) & 0xFF) || !Put('.')
+			|| !PutUint((nIpAddress >> 16) & 0xFF) || !Put('.')
+			|| !PutUint(nIpAddress >> 24) || !Put('"')) {
+		Rollback();
+	}
+}
+
+void JsonWriter::AddRaw(const char *pKey, const char *pJson, uint32_t nLength) {
+	assert(pJson != nullptr);
+
+	if (m_bTruncated) {
+		return;
+	}
+
+	Mark();
+
+	if (!Element(pKey) || !Put(pJson, nLength)) {
+		Rollback();
+	}
+}
+
+uint32_t JsonWriter::Finish() {
+	// There is room for the closing characters, also after a truncation
+	while (m_nDepth > 0) {
+		const auto c = ((m_nArray >> m_nDepth) & 1U) ? ']' : '}';
+
+		m_nDepth--;
+
+		if (m_pFlush == nullptr) {
+			m_nLimit++;
+		}
+
+		Put(c);
+	}
+
+	assert(m_nSize <= m_nBufferSize);
+	return m_nSize;
+}
+
+bool JsonWriter::Element(const char *pKey) {
+	const auto nBit = 1U << m_nDepth;
+
+	if (m_nFirst & nBit) {
+		m_nFirst &= ~nBit;
+	} else if (!Put(',')) {
+		return false;
+	}
+
+	if (pKey != nullptr) {
+		return PutString(pKey, UINT32_MAX) && Put(':');
+	}
+
+	return true;
+}
+
+bool JsonWriter::Put(const char *pData, uint32_t nLength) {
+	while (nLength != 0) {
+		// The reserved closing character can bring the limit below the size
+		if (m_nSize >= m_nLimit) {
+			if (m_pFlush == nullptr) {
+				return false;
+			}
+
+			m_pFlush(m_p, m_pBuffer, m_nSize);
+			m_nSize = 0;
+		}
+
+		auto nCopy = m_nLimit - m_nSize;
+
+		if (nCopy > nLength) {
+			nCopy = nLength;
+		}
+
+		memcpy(&m_pBuffer[m_nSize], pData, nCopy);
+		m_nSize += nCopy;
+		pData += nCopy;
+		nLength -= nCopy;
+	}
+
+	return true;
+}
+
+bool JsonWriter::PutString(const char *pString, uint32_t nMaxLength) {
+	static constexpr char HEX[] = "0123456789abcdef";
+
+	if (!Put('"')) {
+		return false;
+	}
+
+	const auto *pEnd = pString;
+
+	for (;;) {
+		// The characters which do not need an escape are copied as one run
+		const auto *pRun = pEnd;
+
+		while ((nMaxLength != 0) && (static_cast<uint8_t>(*pEnd) >= 0x20) && (*pEnd != '"') && (*pEnd != '\\')) {
+			pEnd++;
+			nMaxLength--;
+		}
+
+		if (!Put(pRun, static_cast<uint32_t>(pEnd - pRun))) {
+			return false;
+		}
+
+		if ((nMaxLength == 0) || (*pEnd == '\0')) {
+			break;
+		}
+
+		const auto c = static_cast<uint8_t>(*pEnd++);
+		nMaxLength--;
+
+		char escape[6] = { '\\', static_cast<char>(c), '0', '0', HEX[c >> 4], HEX[c & 0xF] };
+		uint32_t nEscapeLength = 2;
+
+		if (c < 0x20) {
+			escape[1] = 'u';
+			nEscapeLength = 6;
+		}
+
+		if (!Put(escape, nEscapeLength)) {
+			return false;
+		}
+	}
+
+	return Put('"');
+}
+
+bool JsonWriter::PutUint(uint32_t nValue) {
+	char digits[10];
+	auto *pDigit = &digits[sizeof(digits)];
+
+	do {
+		*--pDigit = static_cast<char>('0' + (nValue % 10));
+		nValue /= 10;
+	} while (nValue != 0);
+
+	return Put(pDigit, static_cast<uint32_t>(&digits[sizeof(digits)] - pDigit));
+}
+
+void JsonWriter::Rollback() {
+	m_nSize = m_nMarkSize;
+	m_nFirst = m_nMarkFirst;
+	m_bTruncated = true;
+}
@@ -23,11 +23,13 @@
  */
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <cassert>
 
 #include "readconfigfile.h"
+#include "jsontokenizer.h"
 
 #include "debug.h"
 
@@ -96,6 +98,12 @@ void ReadConfigFile::Read(const char *pBuffer, unsigned nLength) {
 
 	debug_dump(pBuffer, nLength);
 
+	if (*pSrc == '{') {
+		ReadJson(pSrc, nLength, true);
+		DEBUG_EXIT
+		return;
+	}
+
 	while (nLength != 0) {
 		char *pLine = &buffer[0];
 
@@ -125,3 +133,114 @@ void ReadConfigFile::Read(const char *pBuffer, unsigned nLength) {
 
 	DEBUG_EXIT
 }
+
+/**
+ * The escapes are decoded, \uXXXX to UTF-8.
+ * Returns false for a control character, a surrogate or an invalid escape.
+ */
+
+static bool unescape(const char *pSrc, uint32_t nLength, char *&pDst) {
+	for (uint32_t i = 0; i < nLength; i++) {
+		if (pSrc[i] != '\\') {
+			*pDst++ = pSrc[i];
+			continue;
+		}
+
+		if (++i == nLength) {
+			return false;
+		}
+
+		const auto c = pSrc[i];
+
+		if ((c == '"') || (c == '\\') || (c == '/')) {
+			*pDst++ = c;
+			continue;
+		}
+
+		if ((c != 'u') || ((i + 4) >= nLength)) {
+			return false;
+		}
+
+		uint32_t nCode = 0;
+
+		for (uint32_t j = 1; j <= 4; j++) {
+			const auto h = pSrc[i + j];
+			uint32_t nNibble;
+
+			if ((h >= '0') && (h <= '9')) {
+				nNibble = static_cast<uint32_t>(h - '0');
+			} else if (((h | 0x20) >= 'a') && ((h | 0x20) <= 'f')) {
+				nNibble = static_cast<uint32_t>((h | 0x20) - 'a' + 10);
+			} else {
+				return false;
+			}
+
+			nCode = (nCode << 4) | nNibble;
+		}
+
+		i += 4;
+
+		if ((nCode < 0x20) || ((nCode >= 0xD800) && (nCode <= 0xDFFF))) {
+			return false;
+		}
+
+		if (nCode < 0x80) {
+			*pDst++ = static_cast<char>(nCode);
+		} else if (nCode < 0x800) {
+			*pDst++ = static_cast<char>(0xC0 | (nCode >> 6));
+			*pDst++ = static_cast<char>(0x80 | (nCode & 0x3F));
+		} else {
+			*pDst++ = static_cast<char>(0xE0 | (nCode >> 12));
+			*pDst++ = static_cast<char>(0x80 | ((nCode >> 6) & 0x3F));
+			*pDst++ = static_cast<char>(0x80 | (nCode & 0x3F));
+		}
+	}
+
+	return true;
+}
+
+/**
+ * There is no conversion of the whole buffer, the members are handed over one by one.
+ * The file name member {"network.txt":{...}} is optional, the inner object is walked in place.
+ * A member with an escape that cannot be a line of a .txt file is skipped.
+ */
+
+void ReadConfigFile::ReadJson(const char *pJson, unsigned nLength, const bool bIsFile) {
+	JsonTokenizer json(pJson, nLength);
+	jsontokenizer::Token key, value;
+	char buffer[MAX_LINE_LENGTH];
+
+	while (json.NextKey(key)) {
+		if (bIsFile && (json.GetText()[0] == '{')) {
+			ReadJson(json.GetText(), json.GetLength(), false);
+			return;
+		}
+
+		if (!json.NextValue(value)) {
+			return;
+		}
+
+		if ((value.type == jsontokenizer::Type::OBJECT) || (value.type == jsontokenizer::Type::ARRAY)
+				|| (key.nLength == 0) || ((key.nLength + 1 + value.nLength) >= MAX_LINE_LENGTH)) {
+			continue;
+		}
+
+		memcpy(buffer, key.pText, key.nLength);
+		auto *pLine = &buffer[key.nLength];
+		*pLine++ = '=';
+
+		if (value.type == jsontokenizer::Type::LITERAL) {
+			if (jsontokenizer::equals(value, "null")) {
+				continue;
+			}
+			*pLine++ = (value.pText[0] == 't') ? '1' : '0';
+		} else if (!unescape(value.pText, value.nLength, pLine)) {
+			DEBUG_PUTS("Invalid escape");
+			continue;
+		}
+
+		*pLine = '\0';
+		DEBUG_PUTS(&buffer[0]);
+		m_pCallBack(m_p, &buffer[0]);
+	}
+}
@@ -0,0 +1,581 @@
+/**
+ * @file benchmark.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The remote configuration JSON: the snprintf and convert_json_file reference
+ * (as before the JsonWriter and the JsonTokenizer) against the new code.
+ * - Verify: the same output for the fixed endpoints; the escaping; a truncated
+ *   buffer is still valid JSON; a TOD and a storage directory larger than
+ *   the HTTP buffer are streamed complete; the same "key=value" lines for a POST.
+ * - Benchmark: ns per request.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "jsonwriter.h"
+#include "jsontokenizer.h"
+#include "readconfigfile.h"
+#include "properties.h"
+#include "sscan.h"
+
+namespace remoteconfig {
+namespace storage {
+void json_get_directory(JsonWriter& writer);
+}  // namespace storage
+}  // namespace remoteconfig
+
+static constexpr uint32_t BUFFER_SIZE = 1440;	// HttpDhandleRequest m_Content
+static constexpr uint32_t TOD_UIDS = 200;
+static constexpr uint32_t STORAGE_FILES = 300;
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s\n", pTest);
+		}
+	}
+}
+
+template<typename F>
+static double bench(F f, uint32_t nCount) {
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		f(i);
+	}
+
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) / nCount;
+}
+
+/*
+ * The device, as the stand-ins for Network, RemoteConfig, Hardware and FirmwareVersion
+ */
+
+static constexpr uint32_t IP = 0x7802A8C0;	// 192.168.2.120
+static const char *s_pDisplayName = "Stage left";
+static const char *s_pNode = "Art-Net 4";
+static const char *s_pOutput = "DMX";
+static constexpr uint32_t OUTPUTS = 4;
+static constexpr char SOFTWARE_VERSION[3] = { '2', '.', '0' };
+static constexpr char BUILD_DATE[11] = { 'J', 'u', 'n', ' ', ' ', '1', ' ', '2', '0', '2', '4' };
+static constexpr char BUILD_TIME[8] = { '1', '2', ':', '0', '0', ':', '0', '0' };
+static const char *s_pBoard = "Orange Pi One";
+static uint32_t s_nUptime = 86400;
+
+static uint8_t s_Tod[TOD_UIDS][6];
+
+/*
+ * Reference
+ */
+
+static uint32_t reference_get_list(char *pOutBuffer, const uint32_t nOutBufferSize) {
+	return static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize,
+			"{\"list\":{\"ip\":\"%d.%d.%d.%d\",\"name\":\"%s\",\"node\":{\"type\":\"%s\",\"port\":{\"type\":\"%s\",\"count\":%d}}}}",
+			IP & 0xFF, (IP >> 8) & 0xFF, (IP >> 16) & 0xFF, IP >> 24,
+			s_pDisplayName, s_pNode, s_pOutput, OUTPUTS));
+}
+
+static uint32_t reference_get_version(char *pOutBuffer, const uint32_t nOutBufferSize) {
+	return static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize,
+			"{\"version\":\"%.*s\",\"board\":\"%s\",\"build\":{\"date\":\"%.*s\",\"time\":\"%.*s\"}}",
+			static_cast<int>(sizeof(SOFTWARE_VERSION)), SOFTWARE_VERSION, s_pBoard,
+			static_cast<int>(sizeof(BUILD_DATE)), BUILD_DATE,
+			static_cast<int>(sizeof(BUILD_TIME)), BUILD_TIME));
+}
+
+// The trailing "\n" is gone
+static uint32_t reference_get_uptime(char *pOutBuffer, const uint32_t nOutBufferSize) {
+	return static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize, "{\"uptime\":%u}\n", s_nUptime));
+}
+
+static uint32_t reference_get_tod(char *pOutBuffer, const uint32_t nOutBufferSize) {
+	const auto nBufferSize = nOutBufferSize - 2U;
+	auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nBufferSize, "{\"port\":\"%c\",\"tod\":[" , 'A'));
+	auto *pTod = &pOutBuffer[nLength];
+	const auto nSize = static_cast<int32_t>(nBufferSize - nLength);
+	int32_t nTodLength = 0;
+
+	for (uint32_t nCount = 0; nCount < TOD_UIDS; nCount++) {
+		const auto *uid = s_Tod[nCount];
+		nTodLength += snprintf(&pTod[nTodLength], static_cast<size_t>(nSize - nTodLength),
+				"\"%.2x%.2x:%.2x%.2x%.2x%.2x\",",
+				uid[0], uid[1], uid[2], uid[3], uid[4], uid[5]);
+	}
+
+	nLength += static_cast<uint32_t>(nTodLength - 1);
+	pOutBuffer[nLength++] = ']';
+	pOutBuffer[nLength++] = '}';
+	return nLength;
+}
+
+static uint32_t reference_get_storage(char *pOutBuffer, const uint32_t nOutBufferSize) {
+	const auto nBufferSize = nOutBufferSize - 2U;
+	auto *dirp = opendir("storage");
+	auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nBufferSize, "{\"label\":\"%s\",\"files\":[", (dirp != nullptr) ? "storage" : "No storage"));
+
+	if (dirp != nullptr) {
+		struct dirent *dp;
+
+		while ((dp = readdir(dirp)) != nullptr) {
+			if ((dp->d_type == DT_DIR) || (dp->d_name[0] == '.')) {
+				continue;
+			}
+
+			const auto nSize = nBufferSize - nLength;
+			const auto nCharacters = static_cast<uint32_t>(snprintf(&pOutBuffer[nLength], nSize, "\"%s\",", dp->d_name));
+
+			if (nCharacters > nSize) {
+				break;
+			}
+
+			nLength += nCharacters;
+
+			if (nLength >= nBufferSize) {
+				break;
+			}
+		}
+
+		if (pOutBuffer[nLength - 1] == ',') {
+			nLength--;
+		}
+
+		closedir(dirp);
+	}
+
+	pOutBuffer[nLength++] = ']';
+	pOutBuffer[nLength++] = '}';
+	return nLength;
+}
+
+/*
+ * New, as in remoteconfigjson.cpp and json_get_tod.cpp
+ */
+
+static void get_list(JsonWriter& writer) {
+	writer.ObjectBegin();
+	writer.ObjectBegin("list");
+	writer.AddIpAddress("ip", IP);
+	writer.Add("name", s_pDisplayName);
+	writer.ObjectBegin("node");
+	writer.Add("type", s_pNode);
+	writer.ObjectBegin("port");
+	writer.Add("type", s_pOutput);
+	writer.Add("count", OUTPUTS);
+	writer.ObjectEnd();
+	writer.ObjectEnd();
+	writer.ObjectEnd();
+	writer.ObjectEnd();
+}
+
+static void get_version(JsonWriter& writer) {
+	writer.ObjectBegin();
+	writer.Add("version", SOFTWARE_VERSION, sizeof(SOFTWARE_VERSION));
+	writer.Add("board", s_pBoard);
+	writer.ObjectBegin("build");
+	writer.Add("date", BUILD_DATE, sizeof(BUILD_DATE));
+	writer.Add("time", BUILD_TIME, sizeof(BUILD_TIME));
+	writer.ObjectEnd();
+	writer.ObjectEnd();
+}
+
+static void get_uptime(JsonWriter& writer) {
+	writer.ObjectBegin();
+	writer.Add("uptime", s_nUptime);
+	writer.ObjectEnd();
+}
+
+static void get_tod(JsonWriter& writer) {
+	static constexpr char HEX[] = "0123456789abcdef";
+	const char port[1] = { 'A' };
+
+	writer.ObjectBegin();
+	writer.Add("port", port, 1);
+	writer.ArrayBegin("tod");
+
+	for (uint32_t nIndex = 0; nIndex < TOD_UIDS; nIndex++) {
+		const auto *uid = s_Tod[nIndex];
+		char text[13];
+		auto *p = text;
+
+		for (uint32_t i = 0; i < 6; i++) {
+			*p++ = HEX[uid[i] >> 4];
+			*p++ = HEX[uid[i] & 0xF];
+
+			if (i == 1) {
+				*p++ = ':';
+			}
+		}
+
+		writer.Add(nullptr, text, sizeof(text));
+	}
+
+	writer.ArrayEnd();
+	writer.ObjectEnd();
+}
+
+/*
+ * The chunked response: the flushed buffers are collected
+ */
+
+struct Response {
+	char data[16384];
+	uint32_t nLength;
+	uint32_t nChunks;
+};
+
+static void response_flush(void *p, const char *pData, uint32_t nLength) {
+	auto *pResponse = reinterpret_cast<Response *>(p);
+
+	if ((pResponse->nLength + nLength) <= sizeof(pResponse->data)) {
+		memcpy(&pResponse->data[pResponse->nLength], pData, nLength);
+	}
+
+	pResponse->nLength += nLength;
+	pResponse->nChunks++;
+}
+
+template<typename F>
+static uint32_t response_get(F f, Response& response) {
+	static char content[BUFFER_SIZE];
+	response.nLength = 0;
+	response.nChunks = 0;
+
+	JsonWriter writer(content, sizeof(content), response_flush, &response);
+	f(writer);
+	response_flush(&response, content, writer.Finish());
+	return response.nLength;
+}
+
+/*
+ * Valid JSON: the objects are walked with the tokenizer, the arrays have no empty elements
+ */
+
+static bool is_valid(const char *pJson, uint32_t nLength) {
+	if ((nLength < 2) || (pJson[0] != '{') || (pJson[nLength - 1] != '}')) {
+		return false;
+	}
+
+	JsonTokenizer json(pJson, nLength);
+	jsontokenizer::Token key, value;
+
+	while (json.Next(key, value)) {
+		if ((value.type == jsontokenizer::Type::OBJECT) && !is_valid(value.pText, value.nLength)) {
+			return false;
+		}
+
+		if (value.type == jsontokenizer::Type::ARRAY) {
+			for (uint32_t i = 1; i < value.nLength; i++) {
+				const auto c = value.pText[i];
+				const auto d = value.pText[i - 1];
+				if (((d == '[') && (c == ',')) || ((d == ',') && ((c == ']') || (c == ',')))) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return !json.IsError();
+}
+
+static uint32_t count_strings(const char *pJson, uint32_t nLength) {
+	uint32_t nQuotes = 0;
+
+	for (uint32_t i = 0; i < nLength; i++) {
+		nQuotes += (pJson[i] == '"');
+	}
+
+	return nQuotes / 2;
+}
+
+/*
+ * POST
+ */
+
+struct Lines {
+	char data[1024];
+	uint32_t nLength;
+};
+
+static void lines_callback(void *p, const char *pLine) {
+	auto *pLines = reinterpret_cast<Lines *>(p);
+	const auto nLength = static_cast<uint32_t>(strlen(pLine));
+
+	if ((pLines->nLength + nLength + 1) < sizeof(pLines->data)) {
+		memcpy(&pLines->data[pLines->nLength], pLine, nLength);
+		pLines->nLength += nLength;
+		pLines->data[pLines->nLength++] = '\n';
+	}
+}
+
+static constexpr char POST_FILE[] =
+		"{\"network.txt\":{\"use_static_ip\":0,\"ip_address\":\"192.168.2.120\",\"net_mask\":\"255.255.255.0\","
+		"\"default_gateway\":\"192.168.2.1\",\"hostname\":\"artnet-node\",\"ntp_server\":\"0.0.0.0\"}}";
+
+static constexpr char POST_ACTION[] = "{\"identify\":1}";
+
+static uint32_t reference_action(char *pBuffer) {
+	memcpy(pBuffer, POST_ACTION, sizeof(POST_ACTION) - 1);
+	const auto nJsonLength = properties::convert_json_file(pBuffer, sizeof(POST_ACTION) - 1, true);
+
+	if (nJsonLength <= 0) {
+		return UINT32_MAX;
+	}
+
+	pBuffer[nJsonLength - 1] = '\0';
+	uint8_t value8;
+
+	if (Sscan::Uint8(pBuffer, "reboot", value8) == Sscan::OK) {
+		return 0x100 | value8;
+	} else if (Sscan::Uint8(pBuffer, "display", value8) == Sscan::OK) {
+		return 0x200 | value8;
+	} else if (Sscan::Uint8(pBuffer, "identify", value8) == Sscan::OK) {
+		return 0x300 | value8;
+	}
+
+	return UINT32_MAX;
+}
+
+static uint32_t new_action(const char *pJson) {
+	JsonTokenizer json(pJson, sizeof(POST_ACTION) - 1);
+	jsontokenizer::Token key, value;
+	uint32_t nValue;
+
+	if (!json.Next(key, value) || !jsontokenizer::get_uint32(value, nValue)) {
+		return UINT32_MAX;
+	}
+
+	if (jsontokenizer::equals(key, "reboot")) {
+		return 0x100 | nValue;
+	} else if (jsontokenizer::equals(key, "display")) {
+		return 0x200 | nValue;
+	} else if (jsontokenizer::equals(key, "identify")) {
+		return 0x300 | nValue;
+	}
+
+	return UINT32_MAX;
+}
+
+int main(int argc, char **argv) {
+	const uint32_t nCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+
+	static char reference[8192];
+	static char content[BUFFER_SIZE];
+	static Response response;
+	uint32_t nSink = 0;
+
+	for (uint32_t i = 0; i < TOD_UIDS; i++) {
+		s_Tod[i][0] = 0x7F;
+		s_Tod[i][1] = 0xF0;
+		s_Tod[i][2] = 0x00;
+		s_Tod[i][3] = static_cast<uint8_t>(i * 37);
+		s_Tod[i][4] = static_cast<uint8_t>(i >> 8);
+		s_Tod[i][5] = static_cast<uint8_t>(i);
+	}
+
+	/*
+	 * Verify
+	 */
+
+	auto same = [&](uint32_t nReference, uint32_t nLength) {
+		return (nReference == nLength) && (memcmp(reference, content, nLength) == 0);
+	};
+
+	auto buffered = [&](void (*f)(JsonWriter&)) {
+		JsonWriter writer(content, sizeof(content));
+		f(writer);
+		return writer.Finish();
+	};
+
+	check(same(reference_get_list(reference, sizeof(reference)), buffered(get_list)), "list");
+	check(same(reference_get_version(reference, sizeof(reference)), buffered(get_version)), "version");
+	// The uptime response ends with a new line, as the handler does
+	auto buffered_uptime = [&]() {
+		auto nLength = buffered(get_uptime);
+		content[nLength++] = '\n';
+		return nLength;
+	};
+
+	check(same(reference_get_uptime(reference, sizeof(reference)), buffered_uptime()), "uptime");
+
+	{
+		JsonWriter writer(content, sizeof(content));
+		writer.ObjectBegin();
+		writer.Add("name", "a\"b\\c\x01");
+		writer.Add("offset", static_cast<int32_t>(-12));
+		writer.ArrayBegin("empty");
+		writer.ArrayEnd();
+		const auto nLength = writer.Finish();
+		static constexpr char EXPECTED[] = "{\"name\":\"a\\\"b\\\\c\\u0001\",\"offset\":-12,\"empty\":[]}";
+		check((nLength == sizeof(EXPECTED) - 1) && (memcmp(content, EXPECTED, nLength) == 0), "escape");
+		check(is_valid(content, nLength), "escape valid");
+	}
+
+	// Every buffer size: the elements which do not fit are dropped, the output stays valid
+	uint32_t nFull = 0;
+
+	for (uint32_t nSize = sizeof(content); nSize > jsonwriter::MAX_DEPTH; nSize = (nSize == sizeof(content)) ? 160 : nSize - 1) {
+		JsonWriter writer(content, nSize);
+		writer.ObjectBegin();
+		writer.Add("label", "storage");
+		writer.ObjectBegin("port");
+		writer.ArrayBegin("tod");
+
+		for (uint32_t i = 0; i < 8; i++) {
+			writer.Add(nullptr, "7ff0:00000001");
+		}
+
+		writer.ArrayEnd();
+		writer.Add("count", static_cast<uint32_t>(8));
+		const auto nLength = writer.Finish();
+
+		if (nSize == sizeof(content)) {
+			nFull = nLength;
+		}
+
+		check((nLength <= nSize) && is_valid(content, nLength), "truncated valid");
+		check(writer.IsTruncated() == (nSize < nFull), "truncated");
+	}
+
+	// The TOD is larger than the HTTP buffer
+	const auto nTodReference = reference_get_tod(reference, sizeof(reference));
+	const auto nTodLength = response_get(get_tod, response);
+	check((nTodReference == nTodLength) && (memcmp(reference, response.data, nTodLength) == 0), "tod");
+	check(is_valid(response.data, nTodLength) && (count_strings(response.data, nTodLength) == 3 + TOD_UIDS), "tod valid");
+	printf("TOD %u UIDs: %u bytes, %u chunks (the reference needs a %u bytes buffer)\n", TOD_UIDS, nTodLength, response.nChunks, nTodReference);
+
+	// The storage directory
+	char directory[] = "/tmp/remoteconfigXXXXXX";
+	const auto isStorage = (mkdtemp(directory) != nullptr) && (chdir(directory) == 0) && (mkdir("storage", 0700) == 0);
+	check(isStorage, "storage");
+
+	for (uint32_t i = 0; isStorage && (i < STORAGE_FILES); i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "storage/show%03u.txt", i);
+		auto *fp = fopen(name, "w");
+		if (fp != nullptr) {
+			fclose(fp);
+		}
+	}
+
+	const auto nStorageReference = reference_get_storage(reference, BUFFER_SIZE);
+	const auto nStorageLength = response_get(remoteconfig::storage::json_get_directory, response);
+	const auto nReferenceFiles = count_strings(reference, nStorageReference) - 3;
+	const auto nFiles = count_strings(response.data, nStorageLength) - 3;
+	check(is_valid(response.data, nStorageLength) && (nFiles == STORAGE_FILES), "storage");
+	printf("Storage %u files: %u bytes, %u chunks, %u files (the reference truncates at %u files)\n", STORAGE_FILES, nStorageLength, response.nChunks, nFiles, nReferenceFiles);
+
+	// POST: the same lines for the Params callback
+	static char buffer[sizeof(POST_FILE)];
+	static Lines linesReference, linesNew;
+
+	auto post_reference = [&]() {
+		memcpy(buffer, POST_FILE, sizeof(POST_FILE) - 1);
+		const auto nLength = properties::convert_json_file(buffer, sizeof(POST_FILE) - 1, false);
+		linesReference.nLength = 0;
+		ReadConfigFile config(lines_callback, &linesReference);
+		config.Read(buffer, static_cast<unsigned>(nLength));
+	};
+
+	// As RemoteConfig::HandleSet: the file name is found, the inner object is read in place once
+	auto post_new = [&]() {
+		linesNew.nLength = 0;
+		JsonTokenizer json(POST_FILE, sizeof(POST_FILE) - 1);
+		jsontokenizer::Token key;
+
+		if (json.NextKey(key) && (json.GetText()[0] == '{')) {
+			ReadConfigFile config(lines_callback, &linesNew);
+			config.Read(json.GetText(), json.GetLength());
+		}
+	};
+
+	post_reference();
+	post_new();
+	check((linesReference.nLength != 0) && (linesReference.nLength == linesNew.nLength) && (memcmp(linesReference.data, linesNew.data, linesNew.nLength) == 0), "post");
+	// The escapes are decoded, a member with a control character is skipped
+	{
+		static constexpr char ESCAPES[] = "{\"a.txt\":{\"name\":\"x\\u00e9\\/\\u20acy\",\"bad\":\"a\\nb\",\"ctrl\":\"\\u0001\",\"quote\":\"q\\\"z\\\\\"}}";
+		static constexpr char EXPECTED[] = "name=x\xc3\xa9/\xe2\x82\xacy\nquote=q\"z\\\n";
+		static Lines lines;
+		ReadConfigFile config(lines_callback, &lines);
+		config.Read(ESCAPES, sizeof(ESCAPES) - 1);
+		check((lines.nLength == sizeof(EXPECTED) - 1) && (memcmp(lines.data, EXPECTED, lines.nLength) == 0), "unescape");
+	}
+
+	check((reference_action(buffer) == 0x301) && (new_action(POST_ACTION) == 0x301), "action");
+
+	/*
+	 * Benchmark
+	 */
+
+	puts("Request               reference        new  (ns)");
+
+	auto row = [](const char *pName, double fReference, double fNew) {
+		printf("%-18s  %10.1f %10.1f   x%.1f\n", pName, fReference, fNew, fReference / fNew);
+	};
+
+	row("GET list",
+			bench([&](uint32_t) { nSink += reference_get_list(content, sizeof(content)); }, nCount),
+			bench([&](uint32_t) { nSink += buffered(get_list); }, nCount));
+	row("GET version",
+			bench([&](uint32_t) { nSink += reference_get_version(content, sizeof(content)); }, nCount),
+			bench([&](uint32_t) { nSink += buffered(get_version); }, nCount));
+	row("GET uptime",
+			bench([&](uint32_t i) { s_nUptime = i; nSink += reference_get_uptime(content, sizeof(content)); }, nCount),
+			bench([&](uint32_t i) { s_nUptime = i; nSink += buffered_uptime(); }, nCount));
+	row("GET rdm/tod",
+			bench([&](uint32_t) { nSink += reference_get_tod(reference, sizeof(reference)); }, nCount / 20),
+			bench([&](uint32_t) { nSink += response_get(get_tod, response); }, nCount / 20));
+	row("GET storage",
+			bench([&](uint32_t) { nSink += reference_get_storage(reference, BUFFER_SIZE); }, nCount / 1000),
+			bench([&](uint32_t) { nSink += response_get(remoteconfig::storage::json_get_directory, response); }, nCount / 1000));
+	row("POST network.txt",
+			bench([&](uint32_t) { post_reference(); nSink += linesReference.nLength; }, nCount),
+			bench([&](uint32_t) { post_new(); nSink += linesNew.nLength; }, nCount));
+	row("POST action",
+			bench([&](uint32_t) { nSink += reference_action(buffer); }, nCount),
+			bench([&](uint32_t) { nSink += new_action(POST_ACTION); }, nCount));
+
+	if (isStorage) {
+		for (uint32_t i = 0; i < STORAGE_FILES; i++) {
+			char name[32];
+			snprintf(name, sizeof(name), "storage/show%03u.txt", i);
+			unlink(name);
+		}
+		rmdir("storage");
+		rmdir(directory);
+	}
+
+	printf("Verify: %s (%u)\n", (s_nErrors == 0) ? "PASS" : "FAIL", nSink & 1);
+	return (s_nErrors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -28,6 +28,7 @@
 
 namespace http {
 static constexpr uint32_t BUFSIZE = 1440;
+static constexpr uint32_t WRITE_TIMEOUT_MILLIS = 2000;	///< The peer does not take the rest of the response
 enum class Status {
 	OK = 200,
 	BAD_REQUEST = 400,
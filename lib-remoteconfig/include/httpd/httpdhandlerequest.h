@@ -42,6 +42,12 @@ public:
 
 	void HandleRequest(const uint32_t nBytesReceived, char *pRequestHeaderResponse);
 
+	/**
+	 * @return true when the response is sent completely
+	 */
+	bool Flush();
+	static bool IsPending();
+
 private:
 	http::Status ParseRequest();
 	http::Status ParseMethod(char *pLine);
@@ -49,6 +55,13 @@ private:
 	http::Status HandleGet();
 	http::Status HandleGetTxt();
 	http::Status HandlePost(bool hasDataOnly);
+	void WriteHeader(const char *pStatusMsg);
+	void WriteChunk(const char *pData, const uint32_t nLength);
+	void Write(const void *pData, const uint32_t nLength);
+
+	static void staticJsonFlush(void *p, const char *pData, uint32_t nLength) {
+		static_cast<HttpDeamonHandleRequest *>(p)->WriteChunk(pData, nLength);
+	}
 
 private:
 	uint32_t m_nConnectionHandle;
@@ -68,6 +81,8 @@ private:
 
 	bool m_bContentTypeJson { false };
 	bool m_IsAction { false };
+	bool m_bChunked { false };
+	bool m_bWriteIncomplete { false };
 
 	static char m_Content[http::BUFSIZE];
 };
@@ -28,12 +28,19 @@
 
 #include <cstdint>
 
+class JsonWriter;
+
+/**
+ * The functions with a JsonWriter can stream their output,
+ * there is no limit on the size.
+ */
+
 namespace remoteconfig {
-uint32_t json_get_list(char *pOutBuffer, const uint32_t nOutBufferSize);
-uint32_t json_get_version(char *pOutBuffer, const uint32_t nOutBufferSize);
-uint32_t json_get_uptime(char *pOutBuffer, const uint32_t nOutBufferSize);
-uint32_t json_get_display(char *pOutBuffer, const uint32_t nOutBufferSize);
-uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize);
+void json_get_list(JsonWriter& writer);
+void json_get_version(JsonWriter& writer);
+void json_get_uptime(JsonWriter& writer);
+void json_get_display(JsonWriter& writer);
+void json_get_directory(JsonWriter& writer);
 namespace net {
 uint32_t json_get_phystatus(char *pOutBuffer, const uint32_t nOutBufferSize);
 }  // namespace net
@@ -41,10 +48,10 @@ namespace rdm {
 uint32_t json_get_rdm(char *pOutBuffer, const uint32_t nOutBufferSize);
 uint32_t json_get_queue(char *pOutBuffer, const uint32_t nOutBufferSize);
 uint32_t json_get_portstatus(char *pOutBuffer, const uint32_t nOutBufferSize);
-uint32_t json_get_tod(const char cPort, char *pOutBuffer, const uint32_t nOutBufferSize);
+void json_get_tod(const char cPort, JsonWriter& writer);
 }  // namespace rdm
 namespace storage {
-uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize);
+void json_get_directory(JsonWriter& writer);
 }  // namespace storage
 namespace dsa {
 uint32_t json_get_portstatus(char *pOutBuffer, const uint32_t nOutBufferSize);
@@ -52,7 +59,7 @@ uint32_t json_get_vlantable(char *pOutBuffer, const uint32_t nOutBufferSize);
 }  // namespace dsa
 namespace showfile {
 uint32_t json_get_status(char *pOutBuffer, const uint32_t nOutBufferSize);
-uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize);
+void json_get_directory(JsonWriter& writer);
 void json_set_status(const char *pBuffer, const uint32_t nBufferSize);
 }  // namespace showfile
 }  // namespace remoteconfig
@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <ctype.h>
 #include <cassert>
 
@@ -35,9 +36,9 @@
 
 #include "remoteconfig.h"
 #include "remoteconfigjson.h"
-#include "properties.h"
-#include "sscan.h"
 #include "propertiesconfig.h"
+#include "jsonwriter.h"
+#include "jsontokenizer.h"
 
 #include "hardware.h"
 #include "network.h"
@@ -56,6 +57,16 @@ extern uint32_t get_file_content(const char *fileName, char *pDst, http::content
 
 char HttpDeamonHandleRequest::m_Content[http::BUFSIZE];
 
+/*
+ * The part of a response which does not fit in the transmit ring.
+ * There is one response in progress, HttpDaemon::Run does not read
+ * a new request before it is sent.
+ */
+static char s_Pending[http::BUFSIZE + 16];	///< A chunk with its size line and CRLF
+static uint32_t s_nPendingOffset;
+static uint32_t s_nPendingLength;
+static uint32_t s_nPendingMillis;			///< The last progress
+
 static constexpr char s_contentType[static_cast<uint32_t>(http::contentTypes::NOT_DEFINED)][32] =
 	{ "text/html", "text/css", "text/javascript", "application/json" };
 
@@ -122,21 +133,141 @@ void HttpDeamonHandleRequest::HandleRequest(const uint32_t nBytesReceived, char
 				"</html>\n", static_cast<uint32_t>(m_Status), pStatusMsg, pStatusMsg));
 	}
 
-	uint8_t nLength;
-	const int nHeaderLength = snprintf(m_RequestHeaderResponse, http::BUFSIZE - 1U,
-			"HTTP/1.1 %u %s\r\n"
-			"Server: %s\r\n"
-			"Content-Type: %s\r\n"
-			"Content-Length: %u\r\n"
-			"Connection: close\r\n"
-			"\r\n", static_cast<uint32_t>(m_Status), pStatusMsg, Hardware::Get()->GetBoardName(nLength), m_pContentType, m_nContentLength);
-
-	Network::Get()->TcpWrite(m_nHandle, reinterpret_cast<uint8_t *>(m_RequestHeaderResponse), static_cast<uint16_t>(nHeaderLength), m_nConnectionHandle);
-	Network::Get()->TcpWrite(m_nHandle, reinterpret_cast<uint8_t *>(m_Content), static_cast<uint16_t>(m_nContentLength), m_nConnectionHandle);
+	if (m_bChunked) {
+		// The header and the first chunks are sent already
+		if (m_nContentLength != 0) {
+			WriteChunk(m_Content, m_nContentLength);
+		}
+
+		Write("0\r\n\r\n", 5);
+		m_bChunked = false;
+	} else {
+		WriteHeader(pStatusMsg);
+		Write(m_Content, m_nContentLength);
+	}
+
+	Network::Get()->TcpSetCork(m_nHandle, m_nConnectionHandle, false);
 	DEBUG_PRINTF("m_nContentLength=%u", m_nContentLength);
 
 	m_Status = http::Status::UNKNOWN_ERROR;
 	m_RequestMethod = http::RequestMethod::UNKNOWN;
+	m_bWriteIncomplete = false;
+}
+
+/**
+ * The response is chunked when the content does not fit in m_Content
+ */
+
+void HttpDeamonHandleRequest::WriteHeader(const char *pStatusMsg) {
+	uint8_t nLength;
+	int nHeaderLength;
+
+	if (m_bChunked) {
+		nHeaderLength = snprintf(m_RequestHeaderResponse, http::BUFSIZE - 1U,
+				"HTTP/1.1 %u %s\r\n"
+				"Server: %s\r\n"
+				"Content-Type: %s\r\n"
+				"Transfer-Encoding: chunked\r\n"
+				"Connection: close\r\n"
+				"\r\n", static_cast<uint32_t>(m_Status), pStatusMsg, Hardware::Get()->GetBoardName(nLength), m_pContentType);
+	} else {
+		nHeaderLength = snprintf(m_RequestHeaderResponse, http::BUFSIZE - 1U,
+				"HTTP/1.1 %u %s\r\n"
+				"Server: %s\r\n"
+				"Content-Type: %s\r\n"
+				"Content-Length: %u\r\n"
+				"Connection: close\r\n"
+				"\r\n", static_cast<uint32_t>(m_Status), pStatusMsg, Hardware::Get()->GetBoardName(nLength), m_pContentType, m_nContentLength);
+	}
+
+	// The header and the content go out in full segments
+	Network::Get()->TcpSetCork(m_nHandle, m_nConnectionHandle, true);
+	Write(m_RequestHeaderResponse, static_cast<uint32_t>(nHeaderLength));
+}
+
+void HttpDeamonHandleRequest::WriteChunk(const char *pData, const uint32_t nLength) {
+	if (!m_bChunked) {
+		m_bChunked = true;
+		WriteHeader("OK");
+	}
+
+	char chunkSize[8];
+	const auto nChunkSizeLength = snprintf(chunkSize, sizeof(chunkSize), "%x\r\n", static_cast<unsigned int>(nLength));
+
+	Write(chunkSize, static_cast<uint32_t>(nChunkSizeLength));
+	Write(pData, nLength);
+	Write("\r\n", 2);
+}
+
+/**
+ * The transmit ring is not waited for: the bytes which do not fit are kept
+ * and HttpDaemon::Run writes these when there is space.
+ * When these do not fit either, the rest of the response is dropped.
+ * A chunked response then has no last chunk, the client sees it is incomplete.
+ */
+
+void HttpDeamonHandleRequest::Write(const void *pData, const uint32_t nLength) {
+	if (m_bWriteIncomplete) {
+		return;
+	}
+
+	const auto *pSource = reinterpret_cast<const char *>(pData);
+	uint32_t nQueued = 0;
+
+	if (s_nPendingLength == 0) {
+		nQueued = Network::Get()->TcpWrite(m_nHandle, reinterpret_cast<const uint8_t *>(pSource), static_cast<uint16_t>(nLength), m_nConnectionHandle);
+
+		if (nQueued == nLength) {
+			return;
+		}
+
+		s_nPendingOffset = 0;
+		s_nPendingMillis = Hardware::Get()->Millis();
+	}
+
+	const auto nRest = nLength - nQueued;
+
+	if ((s_nPendingLength + nRest) > sizeof(s_Pending)) {
+		DEBUG_PUTS("Write incomplete");
+		m_bWriteIncomplete = true;
+		return;
+	}
+
+	memcpy(&s_Pending[s_nPendingLength], &pSource[nQueued], nRest);
+	s_nPendingLength += nRest;
+}
+
+bool HttpDeamonHandleRequest::Flush() {
+	const auto nSpace = Network::Get()->TcpWriteSpace(m_nHandle, m_nConnectionHandle);
+	const auto nMillis = Hardware::Get()->Millis();
+
+	if (nSpace != 0) {
+		const auto nLength = std::min(nSpace, s_nPendingLength - s_nPendingOffset);
+		const auto nQueued = Network::Get()->TcpWrite(m_nHandle, reinterpret_cast<const uint8_t *>(&s_Pending[s_nPendingOffset]), static_cast<uint16_t>(nLength), m_nConnectionHandle);
+
+		if (nQueued != 0) {
+			s_nPendingOffset += nQueued;
+			s_nPendingMillis = nMillis;
+		}
+	}
+
+	if (s_nPendingOffset == s_nPendingLength) {
+		s_nPendingLength = 0;
+		return true;
+	}
+
+	// The connection is gone, or the peer does not take data
+	if ((nMillis - s_nPendingMillis) > http::WRITE_TIMEOUT_MILLIS) {
+		DEBUG_PUTS("Write timeout");
+		s_nPendingLength = 0;
+		return true;
+	}
+
+	return false;
+}
+
+bool HttpDeamonHandleRequest::IsPending() {
+	return s_nPendingLength != 0;
 }
 
 http::Status HttpDeamonHandleRequest::ParseRequest() {
@@ -281,25 +412,30 @@ http::Status HttpDeamonHandleRequest::HandleGet() {
 	if (memcmp(m_pUri, "/json/", 6) == 0) {
 		m_pContentType = s_contentType[static_cast<uint32_t>(http::contentTypes::APPLICATION_JSON)];
 		const auto *pGet = &m_pUri[6];
+		// A full buffer goes out as a chunk
+		JsonWriter writer(m_Content, sizeof(m_Content), staticJsonFlush, this);
+
 		switch (http::get_uint(pGet)) {
 		case http::json::get::LIST:
-			nLength = remoteconfig::json_get_list(m_Content, sizeof(m_Content));
+			remoteconfig::json_get_list(writer);
 			break;
 		case http::json::get::VERSION:
-			nLength = remoteconfig::json_get_version(m_Content, sizeof(m_Content));
+			remoteconfig::json_get_version(writer);
 			break;
 		case http::json::get::UPTIME:
 			if (!RemoteConfig::Get()->IsEnableUptime()) {
 				DEBUG_PUTS("Status::BAD_REQUEST");
 				return http::Status::BAD_REQUEST;
 			}
-			nLength = remoteconfig::json_get_uptime(m_Content, sizeof(m_Content));
+			remoteconfig::json_get_uptime(writer);
+			nLength = writer.Finish();
+			m_Content[nLength++] = '\n';	// The uptime response ends with a new line
 			break;
 		case http::json::get::DISPLAY:
-			nLength = remoteconfig::json_get_display(m_Content, sizeof(m_Content));
+			remoteconfig::json_get_display(writer);
 			break;
 		case http::json::get::DIRECTORY:
-			nLength = remoteconfig::json_get_directory(m_Content, sizeof(m_Content));
+			remoteconfig::json_get_directory(writer);
 			break;
 #if defined (RDM_CONTROLLER)
 		case http::json::get::RDM:
@@ -330,7 +466,7 @@ http::Status HttpDeamonHandleRequest::HandleGet() {
 				case http::json::get::TOD: {
 					const auto *pTod = &pRdm[4];
 					if (isQuestionMark && isalpha(static_cast<int>(pTod[0])))  {
-						nLength = remoteconfig::rdm::json_get_tod(pTod[0], m_Content, sizeof(m_Content));
+						remoteconfig::rdm::json_get_tod(pTod[0], writer);
 					}
 				}
 					break;
@@ -344,7 +480,7 @@ http::Status HttpDeamonHandleRequest::HandleGet() {
 				const auto *pStorage = &pGet[8];
 				switch (http::get_uint(pStorage)) {
 				case http::json::get::DIRECTORY:
-					nLength = remoteconfig::storage::json_get_directory(m_Content, sizeof(m_Content));
+					remoteconfig::storage::json_get_directory(writer);
 					break;
 				default:
 					break;
@@ -374,7 +510,7 @@ http::Status HttpDeamonHandleRequest::HandleGet() {
 					nLength = remoteconfig::showfile::json_get_status(m_Content, sizeof(m_Content));
 					break;
 				case http::json::get::DIRECTORY:
-					nLength = remoteconfig::showfile::json_get_directory(m_Content, sizeof(m_Content));
+					remoteconfig::showfile::json_get_directory(writer);
 					break;
 				default:
 					break;
@@ -387,6 +523,10 @@ http::Status HttpDeamonHandleRequest::HandleGet() {
 			}
 			break;
 		}
+
+		if (nLength == 0) {
+			nLength = writer.Finish();
+		}
 	}
 #if defined (ENABLE_CONTENT)
 	else if (strcmp(m_pUri, "/") == 0) {
@@ -422,7 +562,8 @@ http::Status HttpDeamonHandleRequest::HandleGet() {
 	}
 #endif
 
-	if (nLength == 0) {
+	// A chunked response can end with a full chunk
+	if ((nLength == 0) && !m_bChunked) {
 		DEBUG_EXIT
 		return http::Status::NOT_FOUND;
 	}
@@ -499,20 +640,19 @@ http::Status HttpDeamonHandleRequest::HandlePost(bool hasDataOnly) {
 	DEBUG_PRINTF("%d|%.*s|->%d", m_nFileDataLength, m_nFileDataLength, m_pFileData, m_IsAction);
 
 	if (m_IsAction) {
-		auto const nJsonLength = properties::convert_json_file(m_pFileData, m_nFileDataLength, true);
+		// The first member is the action
+		JsonTokenizer json(m_pFileData, m_nFileDataLength);
+		jsontokenizer::Token key, value;
 
-		if (nJsonLength <= 0) {
+		if (!json.Next(key, value)) {
 			DEBUG_PUTS("Status::BAD_REQUEST");
 			return http::Status::BAD_REQUEST;
 		}
 
-		m_pFileData[nJsonLength - 1] = '\0';
-		debug_dump(m_pFileData, nJsonLength);
-
-		uint8_t value8;
+		uint32_t nValue;
 
-		if (Sscan::Uint8(m_pFileData, "reboot", value8) == Sscan::OK) {
-			if (value8 != 0) {
+		if (jsontokenizer::equals(key, "reboot") && jsontokenizer::get_uint32(value, nValue)) {
+			if (nValue != 0) {
 				if (!RemoteConfig::Get()->IsEnableReboot()) {
 					DEBUG_PUTS("Status::BAD_REQUEST");
 					return http::Status::BAD_REQUEST;
@@ -521,26 +661,26 @@ http::Status HttpDeamonHandleRequest::HandlePost(bool hasDataOnly) {
 				RemoteConfig::Get()->Reboot();
 				__builtin_unreachable();
 			}
-		} else if (Sscan::Uint8(m_pFileData, "display", value8) == Sscan::OK) {
-			Display::Get()->SetSleep(value8 == 0);
-			DEBUG_PRINTF("Display::Get()->SetSleep(%d)", value8 == 0);
-		} else if (Sscan::Uint8(m_pFileData, "identify", value8) == Sscan::OK) {
-			if (value8 != 0) {
+		} else if (jsontokenizer::equals(key, "display") && jsontokenizer::get_uint32(value, nValue)) {
+			Display::Get()->SetSleep(nValue == 0);
+			DEBUG_PRINTF("Display::Get()->SetSleep(%d)", nValue == 0);
+		} else if (jsontokenizer::equals(key, "identify") && jsontokenizer::get_uint32(value, nValue)) {
+			if (nValue != 0) {
 				Hardware::Get()->SetMode(hardware::ledblink::Mode::FAST);
 			} else {
 				Hardware::Get()->SetMode(hardware::ledblink::Mode::NORMAL);
 			}
-			DEBUG_PRINTF("identify=%d", value8 != 0);
+			DEBUG_PRINTF("identify=%d", nValue != 0);
 		}
 #if defined (RDM_CONTROLLER)
-		else if (Sscan::Uint8(m_pFileData, "rdm", value8) == Sscan::OK) {
-			ArtNetNode::Get()->SetRdm(!(value8 != 1));
+		else if (jsontokenizer::equals(key, "rdm") && jsontokenizer::get_uint32(value, nValue)) {
+			ArtNetNode::Get()->SetRdm(nValue == 1);
 			DEBUG_PRINTF("rdm=%d", ArtNetNode::Get()->GetRdm());
 		}
 #endif
 #if defined (NODE_SHOWFILE)
-		else if (memcmp(m_pFileData, "show=", 5) == 0) {
-			remoteconfig::showfile::json_set_status(m_pFileData, nJsonLength);
+		else if (jsontokenizer::equals(key, "show")) {
+			remoteconfig::showfile::json_set_status(m_pFileData, m_nFileDataLength);
 		}
 #endif
 		else {
@@ -23,22 +23,21 @@
  * THE SOFTWARE.
  */
 
-#include <cstdio>
 #include <cstdint>
-#include <cassert>
 #include <dirent.h>
 #ifndef NDEBUG
-# include <errno.h>
+# include <cstdio>
 #endif
 
+#include "jsonwriter.h"
+
 namespace remoteconfig {
 namespace storage {
 static bool filter(const char *pName) {
 	return *pName == '.';
 }
 
-uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize) {
-	const auto nBufferSize = nOutBufferSize - 2U;
+void json_get_directory(JsonWriter& writer) {
 #if defined (__linux__) || defined (__APPLE__)
 	auto *dirp = opendir("storage");
 #elif defined (CONFIG_USB_HOST_MSC)
@@ -50,45 +49,30 @@ uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize) {
 	perror("opendir");
 #endif
 
-	auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nBufferSize, "{\"label\":\"%s\",\"files\":[", (dirp != nullptr) ? "storage" : "No storage"));
+	writer.ObjectBegin();
+	writer.Add("label", (dirp != nullptr) ? "storage" : "No storage");
+	writer.ArrayBegin("files");
 
 	if (dirp != nullptr) {
 		struct dirent *dp;
-		do {
-			if ((dp = readdir(dirp)) != nullptr) {
-				if (dp->d_type == DT_DIR) {
-					continue;
-				}
-
-				if (filter(dp->d_name)) {
-					continue;
-				}
-
-				const auto nSize = nBufferSize - nLength;
-				const auto nCharacters = static_cast<uint32_t>(snprintf(&pOutBuffer[nLength], nSize, "\"%s\",", dp->d_name));
-
-				if (nCharacters > nSize) {
-					break;
-				}
 
-				nLength+=nCharacters;
+		while ((dp = readdir(dirp)) != nullptr) {
+			if (dp->d_type == DT_DIR) {
+				continue;
+			}
 
-				if (nLength >= nBufferSize) {
-					break;
-				}
+			if (filter(dp->d_name)) {
+				continue;
 			}
-		} while (dp != nullptr);
 
-		if (pOutBuffer[nLength - 1] == ',') {
-			nLength--;
+			writer.Add(nullptr, dp->d_name);
 		}
-	}
 
-	pOutBuffer[nLength++] = ']';
-	pOutBuffer[nLength++] = '}';
+		closedir(dirp);
+	}
 
-	assert(nLength <= nOutBufferSize);
-	return nLength;
+	writer.ArrayEnd();
+	writer.ObjectEnd();
 }
 }  // namespace storage
 }  // namespace remoteconfig
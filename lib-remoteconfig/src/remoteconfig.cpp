@@ -45,8 +45,8 @@
 #endif
 #include "display.h"
 
-#include "properties.h"
 #include "propertiesconfig.h"
+#include "jsontokenizer.h"
 
 #include "remoteconfigjson.h"
 
@@ -914,19 +914,28 @@ void RemoteConfig::HandleSet(void *pBuffer, uint32_t nBufferLength) {
 	} else if (nBufferLength <= remoteconfig::udp::BUFFER_SIZE){
 		if (PropertiesConfig::IsJSON() && (reinterpret_cast<char *>(pBuffer)[0] == '{')) {
 			DEBUG_PUTS("JSON");
-			int c;
-			assert(nBufferLength > 1);
-			if ((c = properties::convert_json_file(reinterpret_cast<char *>(pBuffer), static_cast<uint16_t>(nBufferLength - 1U), false)) <= 0) {
+			/*
+			 * {"network.txt":{...}}
+			 * The Params read the members of the inner object in place, there is no conversion to text.
+			 * The inner object is not scanned here, the Params tokenizer stops at its closing bracket.
+			 */
+			JsonTokenizer json(reinterpret_cast<char *>(pBuffer), nBufferLength);
+			jsontokenizer::Token key;
+
+			if (!json.NextKey(key) || (json.GetText()[0] != '{')) {
 				DEBUG_EXIT
 				return;
 			}
-			debug_dump(pBuffer, static_cast<uint16_t>(c));
-			m_nBytesReceived = static_cast<uint16_t>(c);
+
+			nLength = key.nLength;
+			nIndex = GetIndex(key.pText, nLength);
+			s_pUdpBuffer = const_cast<char *>(json.GetText());
+			m_nBytesReceived = json.GetLength();
 		} else {
 			m_nBytesReceived = static_cast<uint16_t>(nBufferLength);
+			s_pUdpBuffer = reinterpret_cast<char *>(pBuffer);
+			nIndex = GetIndex(&s_pUdpBuffer[1], nBufferLength);
 		}
-		s_pUdpBuffer = reinterpret_cast<char *>(pBuffer);
-		nIndex = GetIndex(&s_pUdpBuffer[1], nBufferLength);
 	} else {
 		DEBUG_EXIT
 		return;
@@ -24,9 +24,9 @@
  */
 
 #include <cstdint>
-#include <cstdio>
 
 #include "remoteconfig.h"
+#include "jsonwriter.h"
 #include "hardware.h"
 #include "network.h"
 #include "display.h"
@@ -34,116 +34,121 @@
 
 namespace remoteconfig {
 
-uint32_t json_get_list(char *pOutBuffer, const uint32_t nOutBufferSize) {
-	const auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize,
-						"{\"list\":{\"ip\":\"" IPSTR "\",\"name\":\"%s\",\"node\":{\"type\":\"%s\",\"port\":{\"type\":\"%s\",\"count\":%d}}}}",
-						IP2STR(Network::Get()->GetIp()),
-						RemoteConfig::Get()->GetDisplayName(),
-						RemoteConfig::Get()->GetStringNode(),
-						RemoteConfig::Get()->GetStringOutput(),
-						RemoteConfig::Get()->GetOutputs()));
-
-	return nLength;
+void json_get_list(JsonWriter& writer) {
+	writer.ObjectBegin();
+	writer.ObjectBegin("list");
+	writer.AddIpAddress("ip", Network::Get()->GetIp());
+	writer.Add("name", RemoteConfig::Get()->GetDisplayName());
+	writer.ObjectBegin("node");
+	writer.Add("type", RemoteConfig::Get()->GetStringNode());
+	writer.ObjectBegin("port");
+	writer.Add("type", RemoteConfig::Get()->GetStringOutput());
+	writer.Add("count", static_cast<uint32_t>(RemoteConfig::Get()->GetOutputs()));
+	writer.ObjectEnd();
+	writer.ObjectEnd();
+	writer.ObjectEnd();
+	writer.ObjectEnd();
 }
 
-uint32_t json_get_version(char *pOutBuffer, const uint32_t nOutBufferSize) {
+void json_get_version(JsonWriter& writer) {
 	const auto *pVersion = FirmwareVersion::Get()->GetVersion();
 	uint8_t nHwTextLength;
 
-	const auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize,
-					"{\"version\":\"%.*s\",\"board\":\"%s\",\"build\":{\"date\":\"%.*s\",\"time\":\"%.*s\"}}",
-					firmwareversion::length::SOFTWARE_VERSION, pVersion->SoftwareVersion,
-					Hardware::Get()->GetBoardName(nHwTextLength),
-					firmwareversion::length::GCC_DATE, pVersion->BuildDate,
-					firmwareversion::length::GCC_TIME, pVersion->BuildTime));
-	return nLength;
+	writer.ObjectBegin();
+	writer.Add("version", pVersion->SoftwareVersion, firmwareversion::length::SOFTWARE_VERSION);
+	writer.Add("board", Hardware::Get()->GetBoardName(nHwTextLength));
+	writer.ObjectBegin("build");
+	writer.Add("date", pVersion->BuildDate, firmwareversion::length::GCC_DATE);
+	writer.Add("time", pVersion->BuildTime, firmwareversion::length::GCC_TIME);
+	writer.ObjectEnd();
+	writer.ObjectEnd();
 }
 
-uint32_t json_get_uptime(char *pOutBuffer, const uint32_t nOutBufferSize) {
-	const auto nUptime = Hardware::Get()->GetUpTime();
-	const auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize, "{\"uptime\":%u}\n", nUptime));
-	return nLength;
+void json_get_uptime(JsonWriter& writer) {
+	writer.ObjectBegin();
+	writer.Add("uptime", Hardware::Get()->GetUpTime());
+	writer.ObjectEnd();
 }
 
-uint32_t json_get_display(char *pOutBuffer, const uint32_t nOutBufferSize) {
-	const bool isOn = !(Display::Get()->isSleep());
-	const auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize, "{\"display\":%d}", isOn));
-	return nLength;
+void json_get_display(JsonWriter& writer) {
+	writer.ObjectBegin();
+	writer.Add("display", static_cast<uint32_t>(!Display::Get()->isSleep()));
+	writer.ObjectEnd();
 }
 
-uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize) {
-	const auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nOutBufferSize,
-			"{\"files\":{"
+static constexpr char s_Directory[] =
+	"{\"files\":{"
 #if defined (NODE_ARTNET)
-			"\"artnet.txt\":\"Art-Net\","
+	"\"artnet.txt\":\"Art-Net\","
 #endif
 #if defined (NODE_E131)
-			"\"e131.txt\":\"sACN E1.31\","
+	"\"e131.txt\":\"sACN E1.31\","
 #endif
 #if defined (NODE_OSC_CLIENT)
-			"\"oscclnt.txt\":\"OSC Client\","
+	"\"oscclnt.txt\":\"OSC Client\","
 #endif
 #if defined (NODE_OSC_SERVER)
-			"\"osc.txt\":\"OSC Server\","
+	"\"osc.txt\":\"OSC Server\","
 #endif
 #if defined (NODE_LTC_SMPTE)
-			"\"ltc.txt\":\"LTC SMPTE\","
-			"\"ldisplay.txt\":\"Display\","
-			"\"tcnet.txt\":\"TCNet\","
-			"\"gps.txt\":\"GPS\","
-			"\"etc.txt\":\"ETC gateway\","
+	"\"ltc.txt\":\"LTC SMPTE\","
+	"\"ldisplay.txt\":\"Display\","
+	"\"tcnet.txt\":\"TCNet\","
+	"\"gps.txt\":\"GPS\","
+	"\"etc.txt\":\"ETC gateway\","
 #endif
 #if defined(NODE_SHOWFILE)
-			"\"show.txt\":\"Showfile\","
+	"\"show.txt\":\"Showfile\","
 #endif
 #if defined(NODE_NODE)
-			"\"node.txt\":\"Node\","
-			"\"artnet.txt\":\"Art-Net\","
-			"\"e131.txt\":\"sACN E1.31\","
+	"\"node.txt\":\"Node\","
+	"\"artnet.txt\":\"Art-Net\","
+	"\"e131.txt\":\"sACN E1.31\","
 #endif
 #if defined (OUTPUT_DMX_SEND)
-			"\"params.txt\":\"DMX Transmit\","
+	"\"params.txt\":\"DMX Transmit\","
 #endif
 #if defined (OUTPUT_DMX_PIXEL)
-			"\"devices.txt\":\"DMX Pixel\","
+	"\"devices.txt\":\"DMX Pixel\","
 #endif
 #if defined (OUTPUT_DMX_TLC59711)
-			"\"devices.txt\":\"DMX TLC59711\","
+	"\"devices.txt\":\"DMX TLC59711\","
 #endif
 #if defined (OUTPUT_DMX_PCA9685)
-			"\"pca9685.txt\":\"DMX PCA9685\","
+	"\"pca9685.txt\":\"DMX PCA9685\","
 #endif
 #if defined (OUTPUT_DMX_MONITOR)
-			"\"mon.txt\":\"DMX Monitor\","
+	"\"mon.txt\":\"DMX Monitor\","
 #endif
 #if defined (OUTPUT_DMX_SERIAL)
-			"\"serial.txt\":\"DMX Serial\","
+	"\"serial.txt\":\"DMX Serial\","
 #endif
 #if defined (OUTPUT_RGB_PANEL)
-			"\"rgbpanel.txt\":\"RGB panel\","
+	"\"rgbpanel.txt\":\"RGB panel\","
 #endif
 #if defined (OUTPUT_DMX_STEPPER)
-			"\"sparkfun.txt\":\"SparkFun\","
-			"\"motor0.txt\":\"Stepper 1\","
-			"\"motor1.txt\":\"Stepper 2\","
-			"\"motor2.txt\":\"Stepper 3\","
-			"\"motor3.txt\":\"Stepper 4\","
-			"\"motor4.txt\":\"Stepper 5\","
-			"\"motor5.txt\":\"Stepper 6\","
-			"\"motor6.txt\":\"Stepper 7\","
-			"\"motor7.txt\":\"Stepper 8\","
+	"\"sparkfun.txt\":\"SparkFun\","
+	"\"motor0.txt\":\"Stepper 1\","
+	"\"motor1.txt\":\"Stepper 2\","
+	"\"motor2.txt\":\"Stepper 3\","
+	"\"motor3.txt\":\"Stepper 4\","
+	"\"motor4.txt\":\"Stepper 5\","
+	"\"motor5.txt\":\"Stepper 6\","
+	"\"motor6.txt\":\"Stepper 7\","
+	"\"motor7.txt\":\"Stepper 8\","
 #endif
 #if defined (RDM_RESPONDER)
-			"\"rdm_device.txt\":\"RDM Device\","
-			"\"sensors.txt\":\"RDM Sensors\","
+	"\"rdm_device.txt\":\"RDM Device\","
+	"\"sensors.txt\":\"RDM Sensors\","
 #endif
 #if defined(DISPLAY_UDF)
-			"\"display.txt\":\"Display UDF\","
+	"\"display.txt\":\"Display UDF\","
 #endif
-			"\"network.txt\":\"Network\","
-			"\"rconfig.txt\":\"Remote configuration\""
-			"}}"
-			));
-	return nLength;
+	"\"network.txt\":\"Network\","
+	"\"rconfig.txt\":\"Remote configuration\""
+	"}}";
+
+void json_get_directory(JsonWriter& writer) {
+	writer.AddRaw(nullptr, s_Directory, sizeof(s_Directory) - 1);
 }
 }  // namespace remoteconfig
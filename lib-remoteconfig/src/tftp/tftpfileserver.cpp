@@ -105,28 +105,29 @@ size_t TFTPFileServer::FileRead([[maybe_unused]] void* pBuffer, [[maybe_unused]]
 }
 
 size_t TFTPFileServer::FileWrite(const void *pBuffer, size_t nCount, unsigned nBlockNumber) {
-	DEBUG_PRINTF("pBuffer=%p, nCount=%d, nBlockNumber=%d (%d)", pBuffer, nCount, nBlockNumber, m_nSize / 512);
+	const auto nBlockSize = GetBlockSize();
 
-	if (nBlockNumber > (m_nSize / 512)) {
+	DEBUG_PRINTF("pBuffer=%p, nCount=%d, nBlockNumber=%d (%d)", pBuffer, nCount, nBlockNumber, m_nSize / nBlockSize);
+
+	assert(nBlockNumber != 0);
+
+	const auto nOffset = (nBlockNumber - 1) * nBlockSize;
+
+	if ((nOffset + nCount) > m_nSize) {
 		m_nFileSize = 0;
 		return 0;
 	}
 
-	assert(nBlockNumber != 0);
-
 	if (nBlockNumber == 1) {
 		if (!is_valid(pBuffer)) {
 			return 0;
 		}
 	}
 
-	const auto nOffset = (nBlockNumber - 1) * 512U;
-
-	assert((nOffset + nCount) <= m_nSize);
-
 	memcpy(&m_pBuffer[nOffset], pBuffer, nCount);
 
-	m_nFileSize += nCount; //FIXME BUG When in retry ?
+	// The blocks are written in sequence only, duplicates are discarded by the TFTPDaemon
+	m_nFileSize = nOffset + nCount;
 
 	Display::Get()->Progress();
 
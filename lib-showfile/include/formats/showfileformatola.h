@@ -65,6 +65,8 @@ public:
 	void ShowFileStop() {
 		DEBUG_ENTRY
 
+		ShowFileProtocol::DmxSync();
+
 		DEBUG_EXIT
 	}
 
@@ -63,7 +63,7 @@ public:
 	}
 
 	void DmxOut(uint16_t nUniverse, const uint8_t *pDmxData, uint32_t nLength) {
-		m_ArtNetController.HandleDmxOut(nUniverse, pDmxData, nLength);
+		m_ArtNetController.HandleDmxOutQueued(nUniverse, pDmxData, nLength);
 	}
 
 	void DmxSync() {
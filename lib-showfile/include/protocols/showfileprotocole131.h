@@ -62,7 +62,7 @@ public:
 	}
 
 	void DmxOut(const uint16_t nUniverse, const uint8_t *pDmxData, const uint32_t nLength) {
-		m_E131Controller.HandleDmxOut(nUniverse, pDmxData, nLength);
+		m_E131Controller.HandleDmxOutQueued(nUniverse, pDmxData, nLength);
 	}
 
 	void DmxSync() {
@@ -63,6 +63,8 @@ public:
 		return fwrite(pBuffer, 1, nCount, m_pFile);
 	}
 
+	uint32_t FileSize() override;
+
 	void Exit() override;
 
 private:
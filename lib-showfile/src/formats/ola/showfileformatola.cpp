@@ -44,13 +44,11 @@ void ShowFileFormat::ShowFileRun() {
 				ShowFileProtocol::DmxOut(m_nUniverse, m_DmxData, m_nDmxDataLength);
 			}
 		} else if (m_OlaParseCode == OlaParseCode::TIME) {
-			if (m_nDelayMillis != 0) {
-				if (m_nDmxDataLength != 0) {
-					ShowFileProtocol::DmxSync();
-				}
-			}
+			ShowFileProtocol::DmxSync();
 			m_OlaState = OlaState::TIME_WAITING;
 		} else if (m_OlaParseCode == OlaParseCode::EOFILE) {
+			ShowFileProtocol::DmxSync();
+
 			if (m_bDoLoop) {
 				fseek(m_pShowFile, 0L, SEEK_SET);
 			} else {
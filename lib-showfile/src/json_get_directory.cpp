@@ -23,44 +23,35 @@
  * THE SOFTWARE.
  */
 
-#include <cstdio>
 #include <cstdint>
-#include <cassert>
-#include <dirent.h>
 
 #include "showfile.h"
+#include "jsonwriter.h"
 
 namespace remoteconfig {
 namespace showfile {
 
-uint32_t json_get_directory(char *pOutBuffer, const uint32_t nOutBufferSize) {
-	const auto nBufferSize = nOutBufferSize - 2U;
-	auto nLength = static_cast<uint32_t>(snprintf(pOutBuffer, nBufferSize, "{\"shows\":["));
+void json_get_directory(JsonWriter& writer) {
+	char show[4];
 
-	for (uint32_t nShows = 0; nShows < ShowFile::Get()->GetShows(); nShows++) {
-		const auto nSize = nBufferSize - nLength;
-		const auto nCharacters = static_cast<uint32_t>(snprintf(&pOutBuffer[nLength], nSize, "\"%d\",", ShowFile::Get()->GetShowFile(nShows)));
+	writer.ObjectBegin();
+	writer.ArrayBegin("shows");
 
-		if (nCharacters > nSize) {
-			break;
-		}
+	for (uint32_t nShows = 0; nShows < ShowFile::Get()->GetShows(); nShows++) {
+		// The show numbers are strings, as before
+		auto nShow = static_cast<uint32_t>(ShowFile::Get()->GetShowFile(nShows));
+		auto *p = &show[sizeof(show)];
 
-		nLength+=nCharacters;
+		do {
+			*--p = static_cast<char>('0' + (nShow % 10));
+			nShow /= 10;
+		} while ((nShow != 0) && (p != show));
 
-		if (nLength >= nBufferSize) {
-			break;
-		}
+		writer.Add(nullptr, p, static_cast<uint32_t>(&show[sizeof(show)] - p));
 	}
 
-	if (pOutBuffer[nLength - 1] == ',') {
-		nLength--;
-	}
-
-	pOutBuffer[nLength++] = ']';
-	pOutBuffer[nLength++] = '}';
-
-	assert(nLength <= nOutBufferSize);
-	return nLength;
+	writer.ArrayEnd();
+	writer.ObjectEnd();
 }
 }  // namespace showfile
 }  // namespace remoteconfig
@@ -63,3 +63,22 @@ bool ShowFileTFTP::FileCreate(const char *pFileName, [[maybe_unused]] tftp::Mode
 	m_pFile = fopen(pFileName, "w+");
 	return (m_pFile != nullptr);
 }
+
+uint32_t ShowFileTFTP::FileSize() {
+	if (m_pFile == nullptr) {
+		return 0;
+	}
+
+	const auto nPosition = ftell(m_pFile);
+
+	if ((nPosition < 0) || (fseek(m_pFile, 0, SEEK_END) != 0)) {
+		return 0;
+	}
+
+	const auto nSize = ftell(m_pFile);
+
+	fseek(m_pFile, nPosition, SEEK_SET);
+
+	DEBUG_PRINTF("nSize=%ld", nSize);
+	return nSize < 0 ? 0 : static_cast<uint32_t>(nSize);
+}
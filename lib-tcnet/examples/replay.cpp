@@ -0,0 +1,389 @@
+/**
+ * @file replay.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Replay of a TCNet capture through the layer clock.
+ * The frame edges of one layer are compared: one frame per Time packet received
+ * (the packet arrival is the frame edge), and the local clock polled every 100 us.
+ * The capture is a pcap file (Ethernet or Linux cooked), the Time packets on port 60001.
+ * A capture can be generated: sender clock +50 ppm, a Time packet every 25 ms,
+ * network jitter up to 8 ms.
+ * Usage: replay capture.pcap [layer 1|2|3|4|A|B|M|C] [fps 24|25|29|30]
+ *        replay --generate capture.pcap [seconds] [pitch]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+
+#include "tcnetpackets.h"
+#include "tcnettimecode.h"
+#include "tcnetclock.h"
+
+namespace pcap {
+static constexpr uint32_t MAGIC = 0xa1b2c3d4;
+static constexpr uint32_t MAGIC_NANOSECONDS = 0xa1b23c4d;
+static constexpr uint32_t LINKTYPE_ETHERNET = 1;
+static constexpr uint32_t LINKTYPE_LINUX_SLL = 113;
+
+struct GlobalHeader {
+	uint32_t nMagic;
+	uint16_t nVersionMajor;
+	uint16_t nVersionMinor;
+	int32_t nThisZone;
+	uint32_t nSigFigs;
+	uint32_t nSnapLength;
+	uint32_t nLinkType;
+};
+
+struct RecordHeader {
+	uint32_t nSeconds;
+	uint32_t nSubSeconds;
+	uint32_t nIncludedLength;
+	uint32_t nOriginalLength;
+};
+}  // namespace pcap
+
+static constexpr uint16_t PORT_TIME = 60001;
+static constexpr uint32_t POLL_MICROS = 100;
+
+struct Stats {
+	const char *pName;
+	uint32_t nEdges;
+	uint32_t nSkipped;
+	uint32_t nBackwards;
+	uint32_t nIntervals;
+	double fSum;
+	double fSumSquares;
+	double fMin;
+	double fMax;
+	int64_t nFramePrevious;
+	uint32_t nMicrosPrevious;
+
+	void Edge(int64_t nFrame, uint32_t nMicros) {
+		if (nEdges != 0) {
+			const auto nDelta = nFrame - nFramePrevious;
+
+			if (nDelta == 1) {
+				const auto fInterval = static_cast<double>(nMicros - nMicrosPrevious) / 1000.0;
+				fSum += fInterval;
+				fSumSquares += fInterval * fInterval;
+				fMin = (nIntervals == 0) ? fInterval : fmin(fMin, fInterval);
+				fMax = (nIntervals == 0) ? fInterval : fmax(fMax, fInterval);
+				nIntervals++;
+			} else if (nDelta > 1) {
+				nSkipped += static_cast<uint32_t>(nDelta - 1);
+			} else {
+				nBackwards++;
+			}
+		}
+
+		nEdges++;
+		nFramePrevious = nFrame;
+		nMicrosPrevious = nMicros;
+	}
+
+	void Print() const {
+		if (nIntervals < 2) {
+			printf("%-14s no frames\n", pName);
+			return;
+		}
+
+		const auto fMean = fSum / nIntervals;
+		const auto fStdDev = sqrt(fmax(0.0, (fSumSquares / nIntervals) - (fMean * fMean)));
+
+		printf("%-14s edges %6u  interval %6.2f ms  stddev %5.2f ms  min %6.2f  max %6.2f  skipped %4u  backwards %u\n",
+				pName, nEdges, fMean, fStdDev, fMin, fMax, nSkipped, nBackwards);
+	}
+};
+
+static int64_t frame_index(const struct TTCNetTimeCode& timeCode) {
+	static constexpr uint32_t FPS[4] = { 24, 25, 30, 30 };
+	const auto nFps = FPS[timeCode.nType & 0x3];
+	return (((static_cast<int64_t>(timeCode.nHours) * 60 + timeCode.nMinutes) * 60 + timeCode.nSeconds) * nFps) + timeCode.nFrames;
+}
+
+static uint32_t random_next() {
+	static uint32_t s_nRandom = 0x12345678;
+	s_nRandom = s_nRandom * 1664525U + 1013904223U;
+	return s_nRandom >> 8;
+}
+
+/*
+ * The UDP payload of a Time packet, nullptr for any other packet
+ */
+static const uint8_t *time_packet(const uint8_t *pFrame, uint32_t nLength, uint32_t nLinkType, uint32_t& nPayloadLength) {
+	uint32_t nOffset;
+	uint16_t nEtherType;
+
+	if (nLinkType == pcap::LINKTYPE_ETHERNET) {
+		if (nLength < 14) {
+			return nullptr;
+		}
+		nEtherType = static_cast<uint16_t>((pFrame[12] << 8) | pFrame[13]);
+		nOffset = 14;
+		if ((nEtherType == 0x8100) && (nLength >= 18)) {
+			nEtherType = static_cast<uint16_t>((pFrame[16] << 8) | pFrame[17]);
+			nOffset = 18;
+		}
+	} else if (nLinkType == pcap::LINKTYPE_LINUX_SLL) {
+		if (nLength < 16) {
+			return nullptr;
+		}
+		nEtherType = static_cast<uint16_t>((pFrame[14] << 8) | pFrame[15]);
+		nOffset = 16;
+	} else {
+		return nullptr;
+	}
+
+	if ((nEtherType != 0x0800) || (nLength < (nOffset + 20 + 8))) {
+		return nullptr;
+	}
+
+	const auto *pIp = &pFrame[nOffset];
+	const auto nIpHeaderLength = static_cast<uint32_t>(pIp[0] & 0x0F) * 4;
+
+	if ((pIp[9] != 17) || (nLength < (nOffset + nIpHeaderLength + 8))) {
+		return nullptr;
+	}
+
+	const auto *pUdp = &pIp[nIpHeaderLength];
+	const auto nDestinationPort = static_cast<uint16_t>((pUdp[2] << 8) | pUdp[3]);
+
+	if (nDestinationPort != PORT_TIME) {
+		return nullptr;
+	}
+
+	nPayloadLength = nLength - (nOffset + nIpHeaderLength + 8);
+
+	if ((nPayloadLength < TCNET_PACKET_TIME_LENGTH_MIN) || (memcmp(&pUdp[8 + offsetof(struct TTCNetPacketManagementHeader, Header)], "TCN", 3) != 0)) {
+		return nullptr;
+	}
+
+	if (pUdp[8 + offsetof(struct TTCNetPacketManagementHeader, MessageType)] != TCNET_MESSAGE_TYPE_TIME) {
+		return nullptr;
+	}
+
+	return &pUdp[8];
+}
+
+static int generate(const char *pFileName, uint32_t nSeconds, double fPitch) {
+	auto *pFile = fopen(pFileName, "wb");
+
+	if (pFile == nullptr) {
+		perror(pFileName);
+		return EXIT_FAILURE;
+	}
+
+	const pcap::GlobalHeader globalHeader = { pcap::MAGIC, 2, 4, 0, 0, 65535, pcap::LINKTYPE_ETHERNET };
+	fwrite(&globalHeader, sizeof(globalHeader), 1, pFile);
+
+	static constexpr uint32_t HEADERS = 14 + 20 + 8;
+	uint8_t frame[HEADERS + sizeof(struct TTCNetPacketTime)];
+	memset(frame, 0, sizeof(frame));
+
+	frame[12] = 0x08;						// IPv4
+	frame[14] = 0x45;
+	frame[14 + 9] = 17;						// UDP
+	frame[14 + 20 + 2] = PORT_TIME >> 8;
+	frame[14 + 20 + 3] = PORT_TIME & 0xFF;
+
+	auto *pPacket = reinterpret_cast<struct TTCNetPacketTime *>(&frame[HEADERS]);
+	memcpy(pPacket->ManagementHeader.Header, "TCN", 3);
+	pPacket->ManagementHeader.ProtocolVersionMajor = 3;
+	pPacket->ManagementHeader.ProtocolVersionMinor = 3;
+	pPacket->ManagementHeader.MessageType = TCNET_MESSAGE_TYPE_TIME;
+	pPacket->ManagementHeader.NodeType = TCNET_TYPE_MASTER;
+	pPacket->SMPTEMode = 30;
+	pPacket->L1LayerState = tcnet::layerstate::PLAYING;
+	pPacket->LMLayerState = tcnet::layerstate::PLAYING;
+
+	uint64_t nArrivalPrevious = 0;
+	uint32_t nPackets = 0;
+
+	for (uint64_t nSend = 1000000; nSend < (static_cast<uint64_t>(nSeconds + 1) * 1000000); nSend += 25000) {
+		const auto nSendJitter = random_next() % 1000;
+		const auto nLocal = nSend + nSendJitter;
+		const auto nSender = static_cast<uint64_t>(static_cast<double>(nLocal) * (1.0 + 50e-6)) + 123456789U;
+		const auto fLayerMillis = static_cast<double>(nLocal - 1000000) * fPitch / 1000.0;
+
+		pPacket->ManagementHeader.TimeStamp = static_cast<uint32_t>(nSender);
+		pPacket->ManagementHeader.SEQ++;
+		pPacket->L1Time = static_cast<uint32_t>(fLayerMillis) + 3600000;
+		pPacket->LMTime = static_cast<uint32_t>(fLayerMillis) + 60000;
+
+		// Network delay: most packets are fast, some are queued behind other traffic
+		auto nDelay = 300 + (random_next() % 500);
+
+		if ((random_next() % 100) < 30) {
+			nDelay += random_next() % 8000;
+		}
+
+		auto nArrival = nLocal + nDelay;
+
+		if (nArrival <= nArrivalPrevious) {
+			nArrival = nArrivalPrevious + 10;
+		}
+
+		nArrivalPrevious = nArrival;
+
+		const pcap::RecordHeader recordHeader = { static_cast<uint32_t>(nArrival / 1000000), static_cast<uint32_t>(nArrival % 1000000), sizeof(frame), sizeof(frame) };
+		fwrite(&recordHeader, sizeof(recordHeader), 1, pFile);
+		fwrite(frame, sizeof(frame), 1, pFile);
+		nPackets++;
+	}
+
+	fclose(pFile);
+
+	printf("%s: %u Time packets, %u seconds, pitch %.3f\n", pFileName, nPackets, nSeconds, fPitch);
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s capture.pcap [layer] [fps]\n       %s --generate capture.pcap [seconds] [pitch]\n", argv[0], argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (strcmp(argv[1], "--generate") == 0) {
+		if (argc < 3) {
+			return EXIT_FAILURE;
+		}
+		const auto nSeconds = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 60U;
+		const auto fPitch = (argc > 4) ? atof(argv[4]) : 1.0;
+		return generate(argv[2], nSeconds, fPitch);
+	}
+
+	uint32_t nLayer = 6;	// Layer M
+
+	if (argc > 2) {
+		static constexpr char LAYERS[] = "1234ABMC";
+		const auto nChar = ((argv[2][0] >= 'a') && (argv[2][0] <= 'z')) ? static_cast<char>(argv[2][0] - 0x20) : argv[2][0];
+		const auto *p = (nChar != '\0') ? strchr(LAYERS, nChar) : nullptr;
+
+		if (p == nullptr) {
+			fprintf(stderr, "Invalid layer %s\n", argv[2]);
+			return EXIT_FAILURE;
+		}
+
+		nLayer = static_cast<uint32_t>(p - LAYERS);
+	}
+
+	auto tType = TCNET_TIMECODE_TYPE_SMPTE_30FPS;
+
+	if (argc > 3) {
+		switch (atoi(argv[3])) {
+		case 24: tType = TCNET_TIMECODE_TYPE_FILM; break;
+		case 25: tType = TCNET_TIMECODE_TYPE_EBU_25FPS; break;
+		case 29: tType = TCNET_TIMECODE_TYPE_DF; break;
+		default: break;
+		}
+	}
+
+	auto *pFile = fopen(argv[1], "rb");
+
+	if (pFile == nullptr) {
+		perror(argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	pcap::GlobalHeader globalHeader;
+
+	if ((fread(&globalHeader, sizeof(globalHeader), 1, pFile) != 1) || ((globalHeader.nMagic != pcap::MAGIC) && (globalHeader.nMagic != pcap::MAGIC_NANOSECONDS))) {
+		fprintf(stderr, "%s: not a pcap file (little endian)\n", argv[1]);
+		fclose(pFile);
+		return EXIT_FAILURE;
+	}
+
+	Stats packet { "Per packet", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	Stats clock { "Layer clock", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+	TCNetClock layerClock;
+	uint32_t nPackets = 0;
+	uint32_t nMicrosPrevious = 0;
+	int64_t nFrameClock = -1;
+
+	static uint8_t buffer[65536];
+	pcap::RecordHeader recordHeader;
+
+	while (fread(&recordHeader, sizeof(recordHeader), 1, pFile) == 1) {
+		if ((recordHeader.nIncludedLength > sizeof(buffer)) || (fread(buffer, recordHeader.nIncludedLength, 1, pFile) != 1)) {
+			break;
+		}
+
+		uint32_t nPayloadLength;
+		const auto *pPayload = time_packet(buffer, recordHeader.nIncludedLength, globalHeader.nLinkType, nPayloadLength);
+
+		if (pPayload == nullptr) {
+			continue;
+		}
+
+		const auto nSubMicros = (globalHeader.nMagic == pcap::MAGIC_NANOSECONDS) ? recordHeader.nSubSeconds / 1000 : recordHeader.nSubSeconds;
+		const auto nMicros = recordHeader.nSeconds * 1000000U + nSubMicros;
+
+		uint32_t nTimeStamp, nLayerMillis;
+		memcpy(&nTimeStamp, &pPayload[offsetof(struct TTCNetPacketManagementHeader, TimeStamp)], sizeof(uint32_t));
+		memcpy(&nLayerMillis, &pPayload[offsetof(struct TTCNetPacketTime, L1Time) + nLayer * sizeof(uint32_t)], sizeof(uint32_t));
+		const auto nLayerState = pPayload[offsetof(struct TTCNetPacketTime, L1LayerState) + nLayer];
+
+		// The local clock is running in between the packets
+		if (layerClock.IsValid()) {
+			for (auto nPoll = nMicrosPrevious + POLL_MICROS; static_cast<int32_t>(nMicros - nPoll) > 0; nPoll += POLL_MICROS) {
+				struct TTCNetTimeCode timeCode;
+				tcnet::millis_to_timecode(layerClock.GetMillis(nPoll), tType, timeCode);
+				const auto nFrame = frame_index(timeCode);
+
+				if (nFrame != nFrameClock) {
+					nFrameClock = nFrame;
+					clock.Edge(nFrame, nPoll);
+				}
+			}
+		}
+
+		layerClock.Update(nTimeStamp, nLayerMillis, nLayerState, nMicros);
+		nMicrosPrevious = nMicros;
+
+		struct TTCNetTimeCode timeCode;
+		tcnet::millis_to_timecode(nLayerMillis, tType, timeCode);
+		const auto nFrame = frame_index(timeCode);
+
+		if ((packet.nEdges == 0) || (nFrame != packet.nFramePrevious)) {
+			packet.Edge(nFrame, nMicros);
+		}
+
+		nPackets++;
+	}
+
+	fclose(pFile);
+
+	printf("%s: %u Time packets, layer %c, %u fps, rate %.4f\n", argv[1], nPackets, "1234ABMC"[nLayer], tType == TCNET_TIMECODE_TYPE_DF ? 29U : (tType == TCNET_TIMECODE_TYPE_FILM ? 24U : (tType == TCNET_TIMECODE_TYPE_EBU_25FPS ? 25U : 30U)),
+			static_cast<double>(layerClock.GetRate()) / tcnet::clock::RATE_ONE);
+	packet.Print();
+	clock.Print();
+
+	return EXIT_SUCCESS;
+}
@@ -30,6 +30,7 @@
 
 #include "tcnetpackets.h"
 #include "tcnettimecode.h"
+#include "tcnetclock.h"
 
 enum class TCNetLayer {
 	LAYER_1,
@@ -43,6 +44,10 @@ enum class TCNetLayer {
 	LAYER_UNDEFINED
 };
 
+namespace tcnet {
+static constexpr uint32_t LAYERS = static_cast<uint32_t>(TCNetLayer::LAYER_UNDEFINED);
+}  // namespace tcnet
+
 class TCNet {
 public:
 	TCNet(TTCNetNodeType tNodeType = TCNET_TYPE_SLAVE);
@@ -85,6 +90,23 @@ public:
 		m_pTCNetTimeCode = pTCNetTimeCode;
 	}
 
+	/**
+	 * All the layers are tracked, the handler is called for the selected layer only.
+	 * @return false when there is no time received for the layer
+	 */
+	bool GetTimeCode(TCNetLayer tLayer, struct TTCNetTimeCode& timeCode);
+	uint32_t GetLayerMillis(TCNetLayer tLayer);
+
+	uint8_t GetLayerState(TCNetLayer tLayer) const {
+		const auto nLayer = static_cast<uint32_t>(tLayer);
+
+		if (nLayer >= tcnet::LAYERS) {
+			return tcnet::layerstate::IDLE;
+		}
+
+		return m_Clocks[nLayer].GetLayerState();
+	}
+
 public:
 	static char GetLayerName(TCNetLayer tLayer);
 	static TCNetLayer GetLayer(char nChar);
@@ -95,10 +117,12 @@ public:
 
 private:
 	void HandlePort60000Incoming();
-	void HandlePort60001Incoming();
+	void HandlePort60001Incoming(uint32_t nBytesReceived);
 	void HandlePort60002Incoming();
 	void HandlePortUnicastIncoming();
 	void HandleOptInOutgoing();
+	void HandleTimeCodeOutgoing();
+	void GetPacketTimeCode(uint32_t nLayer, struct TTCNetTimeCode& timeCode);
 
 	void DumpManagementHeader();
 	void DumpOptIn();
@@ -124,12 +148,14 @@ private:
 	uint32_t m_nCurrentMillis { 0 };
 	uint32_t m_nPreviousMillis { 0 };
 	TCNetLayer m_tLayer = TCNetLayer::LAYER_M;
-	uint32_t *m_pLTime { nullptr };
-	TTCNetPacketTimeTimeCode *m_pLTimeCode { nullptr };
 	bool m_bUseTimeCode = false;
+	bool m_bTimeReceived { false };
 	TCNetTimeCode *m_pTCNetTimeCode { nullptr };
-	float m_fTypeDivider { 1000.0F / 30 };
 	TTCNetTimeCodeType m_tTimeCodeType;
+	TCNetClock m_Clocks[tcnet::LAYERS];
+	TTCNetPacketTimeTimeCode m_LayerTimeCodes[tcnet::LAYERS];
+	uint8_t m_nSMPTEMode { 0 };
+	struct TTCNetTimeCode m_TimeCodePrevious;
 	uint8_t m_nSeqTimeMessage { 0 };
 
 	static TCNet *s_pThis;
@@ -0,0 +1,129 @@
+/**
+ * @file tcnetclock.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TCNETCLOCK_H_
+#define TCNETCLOCK_H_
+
+#include <cstdint>
+
+#include "tcnettimecode.h"
+
+namespace tcnet {
+namespace layerstate {
+static constexpr uint8_t IDLE = 0;
+static constexpr uint8_t PLAYING = 3;
+static constexpr uint8_t LOOPING = 4;
+static constexpr uint8_t PAUSED = 5;
+static constexpr uint8_t STOPPED = 6;
+}  // namespace layerstate
+
+namespace clock {
+static constexpr uint32_t RATE_ONE = (1U << 24);				///< Q8.24, 1.0 is normal speed
+static constexpr uint32_t RATE_WINDOW_MICROS = 500000;			///< Remote time between two rate measurements
+static constexpr uint32_t JUMP_MICROS = 250000;					///< A larger phase error is a seek, cue or loop
+static constexpr uint32_t HOLDOVER_MICROS = 1000000;			///< Free running without updates
+static constexpr uint32_t PHASE_SHIFT = 3;						///< Phase correction 1/8 per update
+static constexpr uint32_t DELAY_SHIFT = 8;						///< Upward leak of the minimum delay filter
+}  // namespace clock
+
+/**
+ * Integer only, frames = milliseconds * frame rate / 1000
+ */
+inline void millis_to_timecode(uint32_t nMillis, TTCNetTimeCodeType tType, struct TTCNetTimeCode& timeCode) {
+	static constexpr uint32_t FRAME_RATE_100[4] = { 2400, 2500, 2997, 3000 };
+
+	const auto nHours = nMillis / 3600000U;
+	nMillis -= nHours * 3600000U;
+	const auto nMinutes = nMillis / 60000U;
+	nMillis -= nMinutes * 60000U;
+	const auto nSeconds = nMillis / 1000U;
+	nMillis -= nSeconds * 1000U;
+
+	timeCode.nFrames = static_cast<uint8_t>((nMillis * FRAME_RATE_100[tType & 0x3]) / 100000U);
+	timeCode.nSeconds = static_cast<uint8_t>(nSeconds);
+	timeCode.nMinutes = static_cast<uint8_t>(nMinutes);
+	timeCode.nHours = static_cast<uint8_t>(nHours);
+	timeCode.nType = static_cast<uint8_t>(tType);
+}
+}  // namespace tcnet
+
+/**
+ * Local clock for one TCNet layer.
+ *
+ * The layer time in a Time packet belongs to the TimeStamp of the sender,
+ * not to the moment the packet is received. The offset between the two clocks
+ * is a minimum filter of (receive time - TimeStamp), so that the network jitter
+ * only adds a delay that is filtered out. The speed (pitch) of the layer is
+ * measured with the TimeStamps only. The local clock is corrected with a
+ * fraction of the phase error, and is running in between the packets.
+ */
+class TCNetClock {
+public:
+	void Reset() {
+		m_bValid = false;
+	}
+
+	void Update(uint32_t nTimeStamp, uint32_t nLayerMillis, uint8_t nLayerState, uint32_t nMicros);
+
+	/**
+	 * @return The layer time in milliseconds, at local time nMicros.
+	 * When running, the time is not going back within a jump threshold.
+	 */
+	uint32_t GetMillis(uint32_t nMicros);
+
+	bool IsValid() const {
+		return m_bValid;
+	}
+
+	bool IsRunning() const {
+		return m_bRunning;
+	}
+
+	uint8_t GetLayerState() const {
+		return m_nLayerState;
+	}
+
+	uint32_t GetRate() const {
+		return m_nRate;
+	}
+
+private:
+	int64_t Predict(uint32_t nMicros) const;
+
+private:
+	int64_t m_nPosition { 0 };			///< Layer time in microseconds, at m_nMicros
+	uint32_t m_nMicros { 0 };
+	uint32_t m_nRate { tcnet::clock::RATE_ONE };
+	uint32_t m_nDelay { 0 };			///< Local time - remote TimeStamp
+	uint32_t m_nRateTimeStamp { 0 };
+	uint32_t m_nRateLayerMillis { 0 };
+	uint32_t m_nMillisPrevious { 0 };
+	uint8_t m_nLayerState { tcnet::layerstate::IDLE };
+	bool m_bValid { false };
+	bool m_bRunning { false };
+	bool m_bRateValid { false };
+};
+
+#endif /* TCNETCLOCK_H_ */
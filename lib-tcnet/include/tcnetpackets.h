@@ -31,6 +31,7 @@
 #define TCNETPACKETS_H_
 
 #include <cstdint>
+#include <cstddef>
 
 enum TTCNetMessageType {
 	TCNET_MESSAGE_TYPE_OPTIN = 2,
@@ -240,6 +241,11 @@ struct TTCNetPacketTime {
 	uint8_t Reserved2;							// 162:1
 } PACKED;
 
+/**
+ * The Time packet is used up to and including the time codes, the fields that follow are optional
+ */
+static constexpr auto TCNET_PACKET_TIME_LENGTH_MIN = offsetof(struct TTCNetPacketTime, LCTimeCode) + sizeof(struct TTCNetPacketTimeTimeCode);
+
 struct TTCNetPacket {
 	union {
 		struct TTCNetPacketManagementHeader ManagementHeader;
@@ -24,6 +24,7 @@
  */
 
 #include <cstdint>
+#include <cstddef>
 #include <cstring>
 #include <cassert>
 
@@ -39,6 +40,8 @@
 
 static constexpr char NODE_NAME_DEFAULT[] = "AvV-OPi";
 
+static_assert(offsetof(struct TTCNetPacketTime, L1TimeCode) + tcnet::LAYERS * sizeof(struct TTCNetPacketTimeTimeCode) == TCNET_PACKET_TIME_LENGTH_MIN);
+
 TCNet *TCNet::s_pThis = nullptr;
 
 TCNet::TCNet(TTCNetNodeType tNodeType) {
@@ -119,56 +122,122 @@ void TCNet::HandlePort60000Incoming() {
 	}
 }
 
-void TCNet::HandlePort60001Incoming() {
-	if (__builtin_expect((m_pTCNetTimeCode != nullptr), 1)) {
-		const auto *pPacketTime = reinterpret_cast<struct TTCNetPacketTime *>(m_pReceiveBuffer);
-		if (static_cast<TTCNetMessageType>(pPacketTime->ManagementHeader.MessageType) == TCNET_MESSAGE_TYPE_TIME) {
-			struct TTCNetTimeCode TimeCode;
-
-			if (!m_bUseTimeCode) {
-				auto nTime = *m_pLTime;
-
-				const auto nHours = nTime / 3600000;
-				nTime -= nHours * 3600000;
-				const auto nMinutes = nTime / 60000;
-				nTime -= nMinutes * 60000;
-				const auto nSeconds = nTime / 1000;
-				const auto nMillis = nTime - nSeconds * 1000;
-				const auto nFrames = static_cast<uint32_t>(static_cast<float>(nMillis) / m_fTypeDivider);
-
-				TimeCode.nFrames = static_cast<uint8_t>(nFrames);
-				TimeCode.nSeconds = static_cast<uint8_t>(nSeconds);
-				TimeCode.nMinutes = static_cast<uint8_t>(nMinutes);
-				TimeCode.nHours = static_cast<uint8_t>(nHours);
-				TimeCode.nType = m_tTimeCodeType;
-			} else {
-				TimeCode.nFrames = m_pLTimeCode->Frames;
-				TimeCode.nSeconds = m_pLTimeCode->Seconds;
-				TimeCode.nMinutes = m_pLTimeCode->Minutes;
-				TimeCode.nHours = m_pLTimeCode->Hours;
-
-				uint8_t nSMPTEMode = m_pLTimeCode->SMPTEMode;
-
-				if (nSMPTEMode < 24) {
-					nSMPTEMode = pPacketTime->SMPTEMode;
-				}
-
-				if (nSMPTEMode == 24) {
-					TimeCode.nType = TCNET_TIMECODE_TYPE_FILM;
-				} else if (nSMPTEMode == 25) {
-					TimeCode.nType = TCNET_TIMECODE_TYPE_EBU_25FPS;
-				} else if (nSMPTEMode == 29) {
-					TimeCode.nType = TCNET_TIMECODE_TYPE_DF;
-				} else if (nSMPTEMode == 30) {
-					TimeCode.nType = TCNET_TIMECODE_TYPE_SMPTE_30FPS;
-				} else {
-					TimeCode.nType = TCNET_TIMECODE_TYPE_EBU_25FPS;
-				}
-			}
-
-			m_pTCNetTimeCode->Handler(&TimeCode);
+static TTCNetTimeCodeType timecode_type(uint8_t nSMPTEMode) {
+	switch (nSMPTEMode) {
+	case 24:
+		return TCNET_TIMECODE_TYPE_FILM;
+	case 29:
+		return TCNET_TIMECODE_TYPE_DF;
+	case 30:
+		return TCNET_TIMECODE_TYPE_SMPTE_30FPS;
+	default:
+		break;
+	}
+
+	return TCNET_TIMECODE_TYPE_EBU_25FPS;
+}
+
+void TCNet::GetPacketTimeCode(uint32_t nLayer, struct TTCNetTimeCode& timeCode) {
+	const auto& layerTimeCode = m_LayerTimeCodes[nLayer];
+
+	timeCode.nFrames = layerTimeCode.Frames;
+	timeCode.nSeconds = layerTimeCode.Seconds;
+	timeCode.nMinutes = layerTimeCode.Minutes;
+	timeCode.nHours = layerTimeCode.Hours;
+	timeCode.nType = static_cast<uint8_t>(timecode_type(layerTimeCode.SMPTEMode < 24 ? m_nSMPTEMode : layerTimeCode.SMPTEMode));
+}
+
+/*
+ * All the layers are updated. The layer time belongs to the TimeStamp in the header,
+ * the clock of each layer removes the network jitter.
+ */
+
+void TCNet::HandlePort60001Incoming(uint32_t nBytesReceived) {
+	const auto *pPacketTime = reinterpret_cast<struct TTCNetPacketTime *>(m_pReceiveBuffer);
+
+	if ((nBytesReceived < TCNET_PACKET_TIME_LENGTH_MIN) || (static_cast<TTCNetMessageType>(pPacketTime->ManagementHeader.MessageType) != TCNET_MESSAGE_TYPE_TIME)) {
+		return;
+	}
+
+	const auto nMicros = Hardware::Get()->Micros();
+	const auto nTimeStamp = pPacketTime->ManagementHeader.TimeStamp;
+
+	for (uint32_t nLayer = 0; nLayer < tcnet::LAYERS; nLayer++) {
+		uint32_t nLayerMillis;
+		memcpy(&nLayerMillis, &m_pReceiveBuffer[offsetof(struct TTCNetPacketTime, L1Time) + nLayer * sizeof(uint32_t)], sizeof(uint32_t));
+		const auto nLayerState = m_pReceiveBuffer[offsetof(struct TTCNetPacketTime, L1LayerState) + nLayer];
+
+		m_Clocks[nLayer].Update(nTimeStamp, nLayerMillis, nLayerState, nMicros);
+		memcpy(&m_LayerTimeCodes[nLayer], &m_pReceiveBuffer[offsetof(struct TTCNetPacketTime, L1TimeCode) + nLayer * sizeof(struct TTCNetPacketTimeTimeCode)], sizeof(struct TTCNetPacketTimeTimeCode));
+	}
+
+	m_nSMPTEMode = pPacketTime->SMPTEMode;
+	m_bTimeReceived = true;
+}
+
+/*
+ * The handler is called on each frame edge of the local clock,
+ * and for each Time packet received, so that a paused layer is still seen as active.
+ */
+
+void TCNet::HandleTimeCodeOutgoing() {
+	if (__builtin_expect((m_pTCNetTimeCode == nullptr), 0)) {
+		return;
+	}
+
+	const auto nLayer = static_cast<uint32_t>(m_tLayer);
+	struct TTCNetTimeCode timeCode;
+
+	if (m_bUseTimeCode) {
+		if (!m_bTimeReceived) {
+			return;
 		}
+
+		GetPacketTimeCode(nLayer, timeCode);
+	} else {
+		auto& clock = m_Clocks[nLayer];
+
+		if (!clock.IsValid()) {
+			return;
+		}
+
+		tcnet::millis_to_timecode(clock.GetMillis(Hardware::Get()->Micros()), m_tTimeCodeType, timeCode);
+
+		if (!m_bTimeReceived && (memcmp(&timeCode, &m_TimeCodePrevious, sizeof(struct TTCNetTimeCode)) == 0)) {
+			return;
+		}
+	}
+
+	m_bTimeReceived = false;
+	memcpy(&m_TimeCodePrevious, &timeCode, sizeof(struct TTCNetTimeCode));
+
+	m_pTCNetTimeCode->Handler(&timeCode);
+}
+
+bool TCNet::GetTimeCode(TCNetLayer tLayer, struct TTCNetTimeCode& timeCode) {
+	const auto nLayer = static_cast<uint32_t>(tLayer);
+
+	if ((nLayer >= tcnet::LAYERS) || !m_Clocks[nLayer].IsValid()) {
+		return false;
+	}
+
+	if (m_bUseTimeCode) {
+		GetPacketTimeCode(nLayer, timeCode);
+	} else {
+		tcnet::millis_to_timecode(m_Clocks[nLayer].GetMillis(Hardware::Get()->Micros()), m_tTimeCodeType, timeCode);
 	}
+
+	return true;
+}
+
+uint32_t TCNet::GetLayerMillis(TCNetLayer tLayer) {
+	const auto nLayer = static_cast<uint32_t>(tLayer);
+
+	if (nLayer >= tcnet::LAYERS) {
+		return 0;
+	}
+
+	return m_Clocks[nLayer].GetMillis(Hardware::Get()->Micros());
 }
 
 void TCNet::HandlePort60002Incoming() {
@@ -201,7 +270,7 @@ void TCNet::Run() {
 	auto nBytesReceived = Network::Get()->RecvFrom(m_aHandles[1], const_cast<const void**>(reinterpret_cast<void **>(&m_pReceiveBuffer)), &m_nIpAddressFrom, &nForeignPort);
 
 	if (nBytesReceived != 0) {
-		HandlePort60001Incoming();
+		HandlePort60001Incoming(nBytesReceived);
 	}
 
 	nBytesReceived = Network::Get()->RecvFrom(m_aHandles[0], const_cast<const void**>(reinterpret_cast<void **>(&m_pReceiveBuffer)), &m_nIpAddressFrom, &nForeignPort);
@@ -226,6 +295,8 @@ void TCNet::Run() {
 	}
 #endif
 
+	HandleTimeCodeOutgoing();
+
 	m_nCurrentMillis = Hardware::Get()->Millis();
 
 	if (__builtin_expect(((m_nCurrentMillis - m_nPreviousMillis) >= 1000), 0)) {
@@ -240,13 +311,8 @@ void TCNet::SetLayer(TCNetLayer tLayer) {
 		m_bUseTimeCode = true;
 	}
 
-	auto *pPacketTime = reinterpret_cast<struct TTCNetPacketTime *>(m_pReceiveBuffer);
-
 	m_tLayer = tLayer;
-	m_pLTime = &pPacketTime->L1Time + static_cast<uint32_t>(tLayer);
-	m_pLTimeCode =
-			reinterpret_cast<struct TTCNetPacketTimeTimeCode *>((reinterpret_cast<uintptr_t>((&pPacketTime->L1TimeCode))
-					+ static_cast<uintptr_t>(tLayer) * sizeof(struct TTCNetPacketTimeTimeCode)));
+	memset(&m_TimeCodePrevious, 0xFF, sizeof(struct TTCNetTimeCode));
 }
 
 void TCNet::SetNodeName(const char *pNodeName) {
@@ -316,22 +382,8 @@ TCNetLayer TCNet::GetLayer(char nChar) {
 }
 
 void TCNet::SetTimeCodeType(TTCNetTimeCodeType tType) {
-	switch (tType) {
-	case TCNET_TIMECODE_TYPE_FILM:
-		m_fTypeDivider = 1000.0f / 24;
-		break;
-	case TCNET_TIMECODE_TYPE_EBU_25FPS:
-		m_fTypeDivider = 1000.0f / 25;
-		break;
-	case TCNET_TIMECODE_TYPE_DF:
-		m_fTypeDivider = 1000.0f / 29.97f;
-		break;
-	case TCNET_TIMECODE_TYPE_SMPTE_30FPS:
-		m_fTypeDivider = 1000.0f / 30;
-		break;
-	default:
+	if (tType > TCNET_TIMECODE_TYPE_SMPTE_30FPS) {
 		return;
-		break;
 	}
 
 	m_tTimeCodeType = tType;
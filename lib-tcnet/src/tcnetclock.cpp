@@ -0,0 +1,151 @@
+/**
+ * @file tcnetclock.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+
+#include "tcnetclock.h"
+
+#include "debug.h"
+
+using namespace tcnet;
+
+int64_t TCNetClock::Predict(uint32_t nMicros) const {
+	if (!m_bRunning) {
+		return m_nPosition;
+	}
+
+	auto nElapsed = nMicros - m_nMicros;
+
+	if (nElapsed > clock::HOLDOVER_MICROS) {
+		nElapsed = clock::HOLDOVER_MICROS;
+	}
+
+	return m_nPosition + static_cast<int64_t>((static_cast<uint64_t>(nElapsed) * m_nRate) >> 24);
+}
+
+void TCNetClock::Update(uint32_t nTimeStamp, uint32_t nLayerMillis, uint8_t nLayerState, uint32_t nMicros) {
+	const auto bRunning = (nLayerState == layerstate::PLAYING) || (nLayerState == layerstate::LOOPING);
+	const auto nDelay = nMicros - nTimeStamp;
+
+	/*
+	 * Minimum filter: a packet with less network delay pulls the estimate down,
+	 * the slow upward leak follows the drift between the two clocks.
+	 */
+
+	if (!m_bValid) {
+		m_nDelay = nDelay;
+	} else {
+		const auto nDifference = static_cast<int32_t>(nDelay - m_nDelay);
+
+		if ((nDifference < 0) || (nDifference > static_cast<int32_t>(clock::HOLDOVER_MICROS))) {
+			m_nDelay = nDelay;
+		} else {
+			m_nDelay += static_cast<uint32_t>(nDifference) >> clock::DELAY_SHIFT;
+		}
+	}
+
+	// The speed is measured with the sender time stamps only, there is no network jitter
+	if (!bRunning) {
+		m_bRateValid = false;
+	} else if (!m_bRateValid) {
+		m_bRateValid = true;
+		m_nRateTimeStamp = nTimeStamp;
+		m_nRateLayerMillis = nLayerMillis;
+	} else {
+		const auto nDeltaTimeStamp = nTimeStamp - m_nRateTimeStamp;
+
+		if (nDeltaTimeStamp >= clock::RATE_WINDOW_MICROS) {
+			const auto nDeltaMillis = static_cast<int32_t>(nLayerMillis - m_nRateLayerMillis);
+
+			if ((nDeltaMillis > 0) && (nDeltaTimeStamp < clock::HOLDOVER_MICROS)) {
+				const auto nRate = static_cast<uint32_t>((static_cast<uint64_t>(nDeltaMillis) * 1000U << 24) / nDeltaTimeStamp);
+
+				if (nRate < (4 * clock::RATE_ONE)) {
+					m_nRate = static_cast<uint32_t>(static_cast<int32_t>(m_nRate) + ((static_cast<int32_t>(nRate) - static_cast<int32_t>(m_nRate)) / 4));
+				}
+			}
+
+			m_nRateTimeStamp = nTimeStamp;
+			m_nRateLayerMillis = nLayerMillis;
+		}
+	}
+
+	// The layer time belongs to the moment nTimeStamp + m_nDelay in local time
+	auto nMeasured = static_cast<int64_t>(nLayerMillis) * 1000;
+
+	if (bRunning) {
+		nMeasured += static_cast<int64_t>((static_cast<uint64_t>(nDelay - m_nDelay) * m_nRate) >> 24);
+	}
+
+	if (m_bValid && m_bRunning && bRunning) {
+		const auto nPredicted = Predict(nMicros);
+		const auto nError = nMeasured - nPredicted;
+
+		if ((nError < -static_cast<int64_t>(clock::JUMP_MICROS)) || (nError > static_cast<int64_t>(clock::JUMP_MICROS))) {
+			DEBUG_PRINTF("Jump %d", static_cast<int>(nError));
+			m_nPosition = nMeasured;
+			m_nMillisPrevious = 0;
+			m_nRateTimeStamp = nTimeStamp;
+			m_nRateLayerMillis = nLayerMillis;
+		} else {
+			m_nPosition = nPredicted + (nError / (1 << clock::PHASE_SHIFT));
+		}
+	} else {
+		m_nPosition = nMeasured;
+		m_nMillisPrevious = 0;
+
+		if (!m_bValid) {
+			m_nRate = clock::RATE_ONE;
+		}
+	}
+
+	m_nMicros = nMicros;
+	m_nLayerState = nLayerState;
+	m_bRunning = bRunning;
+	m_bValid = true;
+}
+
+uint32_t TCNetClock::GetMillis(uint32_t nMicros) {
+	if (!m_bValid) {
+		return 0;
+	}
+
+	const auto nPosition = Predict(nMicros);
+
+	if (nPosition <= 0) {
+		return 0;
+	}
+
+	auto nMillis = static_cast<uint32_t>(nPosition / 1000);
+
+	// The phase correction must not give a frame twice
+	if (m_bRunning && (nMillis < m_nMillisPrevious) && ((m_nMillisPrevious - nMillis) < (clock::JUMP_MICROS / 1000))) {
+		nMillis = m_nMillisPrevious;
+	}
+
+	m_nMillisPrevious = nMillis;
+
+	return nMillis;
+}
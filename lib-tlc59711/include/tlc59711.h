@@ -28,6 +28,10 @@
 #ifndef TLC59711_H_
 #define TLC59711_H_
 
+#if defined (USE_SPI_DMA)
+# include "hal_spi.h"
+#endif
+
 struct TLC59711SpiSpeed {
 	static constexpr uint32_t DEFAULT = 5000000;	// 5 MHz
 	static constexpr uint32_t MAX = 10000000;		// 10 MHz
@@ -78,13 +82,35 @@ public:
 
 	void SetRgb(uint8_t nOut, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
 
+	/**
+	 * The chain is a shift register, a frame is always sent complete.
+	 * An unchanged frame is not sent.
+	 */
 	void Update();
 	void Blackout();
 
+#if defined (USE_SPI_DMA)
+	bool IsUpdating() {
+		return FUNC_PREFIX(spi_dma_tx_is_active());
+	}
+#else
+	bool IsUpdating() const {
+		return false;
+	}
+#endif
+
 	void Dump();
 
 private:
 	void UpdateFirst32();
+	void Send(const uint16_t *pBuffer);
+
+	void SetBuffer(const uint32_t nIndex, const uint16_t nValue) {
+		if (m_pBuffer[nIndex] != nValue) {
+			m_pBuffer[nIndex] = nValue;
+			m_bIsChanged = true;
+		}
+	}
 
 private:
 	uint8_t m_nBoards;
@@ -93,6 +119,11 @@ private:
 	uint16_t *m_pBuffer { nullptr };
 	uint16_t *m_pBufferBlackout { nullptr };
 	uint32_t m_nBufSize { 0 };
+	bool m_bIsChanged { true };
+#if defined (USE_SPI_DMA)
+	uint8_t *m_pDmaBuffer[2];
+	uint32_t m_nDmaBufferIndex { 0 };
+#endif
 };
 
 #endif /* TLC59711_H_ */
@@ -100,9 +100,30 @@ TLC59711::TLC59711(uint8_t nBoards, uint32_t nSpiSpeedHz):
 	SetGbcBlue(TLC59711_GS_DEFAULT);
 
 	memcpy(m_pBufferBlackout, m_pBuffer, m_nBufSize * 2);
+
+#if defined (USE_SPI_DMA)
+	uint32_t nSize;
+
+	m_pDmaBuffer[0] = const_cast<uint8_t *>(FUNC_PREFIX(spi_dma_tx_prepare(&nSize)));
+	assert(m_pDmaBuffer[0] != nullptr);
+
+	const auto nSizeHalf = (nSize / 2) & static_cast<uint32_t>(~3);
+	assert((m_nBufSize * 2) <= nSizeHalf);
+
+	m_pDmaBuffer[1] = m_pDmaBuffer[0] + nSizeHalf;
+#endif
 }
 
 TLC59711::~TLC59711() {
+#if defined (USE_SPI_DMA)
+	while (FUNC_PREFIX(spi_dma_tx_is_active())) {
+		asm volatile ("isb" ::: "memory");
+	}
+#endif
+
+	delete[] m_pBufferBlackout;
+	m_pBufferBlackout = nullptr;
+
 	delete[] m_pBuffer;
 	m_pBuffer = nullptr;
 }
@@ -124,7 +145,7 @@ void TLC59711::Set(uint32_t nChannel, uint16_t nValue) {
 
 	if (nBoardIndex < m_nBoards) {
 		const uint32_t nIndex = 2 + (nBoardIndex * TLC59711Channels::U16BIT) + ((12 * nBoardIndex) + 11 - nChannel);
-		m_pBuffer[nIndex] = __builtin_bswap16(nValue);
+		SetBuffer(nIndex, __builtin_bswap16(nValue));
 	}
 #ifndef NDEBUG
 	else {
@@ -152,7 +173,7 @@ void TLC59711::Set(uint32_t nChannel, uint8_t nValue) {
 
 	if (nBoardIndex < m_nBoards) {
 		const uint32_t nIndex = 2 + (nBoardIndex * TLC59711Channels::U16BIT) + ((12 * nBoardIndex) + 11 - nChannel);
-		m_pBuffer[nIndex] = static_cast<uint16_t>((nValue << 8) | nValue);
+		SetBuffer(nIndex, static_cast<uint16_t>((nValue << 8) | nValue));
 	}
 #ifndef NDEBUG
 	else {
@@ -168,9 +189,9 @@ void TLC59711::SetRgb(uint8_t nOut, uint16_t nRed, uint16_t nGreen, uint16_t nBl
 
 	if (nBoardIndex < m_nBoards) {
 		uint32_t nIndex = 2 + (nBoardIndex * TLC59711Channels::U16BIT) + (((4 * nBoardIndex) +3 - nOut) * 3);
-		m_pBuffer[nIndex++] = __builtin_bswap16(nBlue);
-		m_pBuffer[nIndex++] = __builtin_bswap16(nGreen);
-		m_pBuffer[nIndex] = __builtin_bswap16(nRed);
+		SetBuffer(nIndex++, __builtin_bswap16(nBlue));
+		SetBuffer(nIndex++, __builtin_bswap16(nGreen));
+		SetBuffer(nIndex, __builtin_bswap16(nRed));
 	}
 #ifndef NDEBUG
 	else {
@@ -186,9 +207,9 @@ void TLC59711::SetRgb(uint8_t nOut, uint8_t nRed, uint8_t nGreen, uint8_t nBlue)
 
 	if (nBoardIndex < m_nBoards) {
 		uint32_t nIndex = 2 + (nBoardIndex * TLC59711Channels::U16BIT) + (((4 * nBoardIndex) + 3 - nOut) * 3);
-		m_pBuffer[nIndex++] = static_cast<uint16_t>((nBlue << 8) | nBlue);
-		m_pBuffer[nIndex++] = static_cast<uint16_t>((nGreen << 8) | nGreen);
-		m_pBuffer[nIndex] = static_cast<uint16_t>((nRed << 8) | nRed);
+		SetBuffer(nIndex++, static_cast<uint16_t>((nBlue << 8) | nBlue));
+		SetBuffer(nIndex++, static_cast<uint16_t>((nGreen << 8) | nGreen));
+		SetBuffer(nIndex, static_cast<uint16_t>((nRed << 8) | nRed));
 	}
 #ifndef NDEBUG
 	else {
@@ -305,8 +326,8 @@ void TLC59711::SetGbcBlue(uint8_t nValue) {
 void TLC59711::UpdateFirst32() {
 	for (uint32_t i = 0; i < m_nBoards; i++) {
 		const auto nIndex = TLC59711Channels::U16BIT * i;
-		m_pBuffer[nIndex] = __builtin_bswap16(static_cast<uint16_t>((m_nFirst32 >> 16)));
-		m_pBuffer[nIndex + 1] = __builtin_bswap16(static_cast<uint16_t>(m_nFirst32));
+		SetBuffer(nIndex, __builtin_bswap16(static_cast<uint16_t>((m_nFirst32 >> 16))));
+		SetBuffer(nIndex + 1, __builtin_bswap16(static_cast<uint16_t>(m_nFirst32)));
 	}
 }
 
@@ -352,17 +373,50 @@ void TLC59711::Dump() {
 void TLC59711::Update() {
 	assert(m_pBuffer != nullptr);
 
-	FUNC_PREFIX(spi_chipSelect(SPI_CS_NONE));
-	FUNC_PREFIX(spi_set_speed_hz(m_nSpiSpeedHz));
-	FUNC_PREFIX(spi_setDataMode(SPI_MODE0));
-	FUNC_PREFIX(spi_writenb(reinterpret_cast<char *>(m_pBuffer), m_nBufSize * 2));
+	if (!m_bIsChanged) {
+		return;
+	}
+
+	m_bIsChanged = false;
+
+	Send(m_pBuffer);
 }
 
 void TLC59711::Blackout() {
 	assert(m_pBufferBlackout != nullptr);
 
+	Send(m_pBufferBlackout);
+
+	// The next Update() restores the output
+	m_bIsChanged = true;
+}
+
+void TLC59711::Send(const uint16_t *pBuffer) {
+	const auto nLength = m_nBufSize * 2;
+
+#if defined (USE_SPI_DMA)
+	/*
+	 * Double buffering: the frame is copied while the previous frame is still sent.
+	 * The bus may not be configured during a transfer.
+	 */
+	auto *pDmaBuffer = m_pDmaBuffer[m_nDmaBufferIndex];
+	m_nDmaBufferIndex ^= 1;
+
+	memcpy(pDmaBuffer, pBuffer, nLength);
+
+	while (FUNC_PREFIX(spi_dma_tx_is_active())) {
+		asm volatile ("isb" ::: "memory");
+	}
+#endif
+
+	// The bus is shared with the L6470 drivers. The H3 HAL writes a changed configuration only.
 	FUNC_PREFIX(spi_chipSelect(SPI_CS_NONE));
 	FUNC_PREFIX(spi_set_speed_hz(m_nSpiSpeedHz));
 	FUNC_PREFIX(spi_setDataMode(SPI_MODE0));
-	FUNC_PREFIX(spi_writenb(reinterpret_cast<char *>(m_pBufferBlackout), m_nBufSize * 2));
+
+#if defined (USE_SPI_DMA)
+	FUNC_PREFIX(spi_dma_tx_start(pDmaBuffer, nLength));
+#else
+	FUNC_PREFIX(spi_writenb(reinterpret_cast<const char *>(pBuffer), nLength));
+#endif
 }
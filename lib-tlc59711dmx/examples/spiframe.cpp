@@ -0,0 +1,184 @@
+/**
+ * @file spiframe.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * TLC59711Dmx on a mock SPI bus, it counts the frames and the bytes sent.
+ * - Verify: the grayscale data of the last frame sent, after each DMX frame.
+ * - Measure: bytes per DMX frame for a stream where most frames are repeated.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "tlc59711dmx.h"
+#include "hal_spi.h"
+#include "configstore.h"
+
+namespace mock {
+static uint8_t s_Frame[2048];
+static uint32_t s_nFrameLength;
+static uint32_t s_nFrames;
+static uint32_t s_nBytes;
+static uint32_t s_nSetups;
+
+static void reset_counters() {
+	s_nFrames = 0;
+	s_nBytes = 0;
+	s_nSetups = 0;
+}
+}  // namespace mock
+
+void spi_begin() {}
+void spi_write(__attribute__((unused)) uint16_t nData) {}
+void spi_transfern(__attribute__((unused)) const char *pData, __attribute__((unused)) uint32_t nLength) {}
+
+void spi_chipSelect(__attribute__((unused)) uint8_t nChipSelect) {
+	mock::s_nSetups++;
+}
+
+void spi_setDataMode(__attribute__((unused)) uint8_t nMode) {}
+void spi_set_speed_hz(__attribute__((unused)) uint32_t nSpeedHz) {}
+
+void spi_writenb(const char *pData, uint32_t nLength) {
+	assert(nLength <= sizeof(mock::s_Frame));
+	memcpy(mock::s_Frame, pData, nLength);
+	mock::s_nFrameLength = nLength;
+	mock::s_nFrames++;
+	mock::s_nBytes += nLength;
+}
+
+/*
+ * Stand-ins, the DMX start address is not saved, Print() is with the params
+ */
+void TLC59711Dmx::Print() {}
+ConfigStore *ConfigStore::s_pThis;
+void ConfigStore::Update(__attribute__((unused)) configstore::Store store, __attribute__((unused)) uint32_t nOffset, __attribute__((unused)) const void *pData, __attribute__((unused)) uint32_t nDataLength, __attribute__((unused)) uint32_t nSetList, __attribute__((unused)) uint32_t nOffsetSetList) {}
+
+static constexpr uint32_t LEDS = 32;	// RGB, 8 boards
+static constexpr uint32_t CHANNELS = LEDS * 3;
+static constexpr uint32_t FRAMES = 4400;	// 100 seconds at 44 Hz
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nFrame) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s frame %u\n", pTest, nFrame);
+		}
+	}
+}
+
+/*
+ * The first board in the buffer is the last board in the chain.
+ * Each board: 32 bits command, then 12 channels of 16 bits, channel 11 first.
+ */
+static uint16_t sent_value(uint32_t nChannel) {
+	const auto nBoard = nChannel / TLC59711Channels::OUT;
+	const auto nWord = 2 + (nBoard * TLC59711Channels::U16BIT) + ((TLC59711Channels::OUT * nBoard) + 11 - nChannel);
+	return static_cast<uint16_t>((mock::s_Frame[nWord * 2] << 8) | mock::s_Frame[nWord * 2 + 1]);
+}
+
+static void verify(const uint8_t *pDmxData, bool isBlackout, const char *pTest, uint32_t nFrame) {
+	for (uint32_t i = 0; i < CHANNELS; i++) {
+		const auto nExpected = isBlackout ? 0 : static_cast<uint16_t>((pDmxData[i] << 8) | pDmxData[i]);
+		check(sent_value(i) == nExpected, pTest, nFrame);
+	}
+
+	for (uint32_t nBoard = 0; nBoard < (CHANNELS / TLC59711Channels::OUT); nBoard++) {
+		check((mock::s_Frame[nBoard * TLC59711Channels::U16BIT * 2] >> 2) == 0x25, "command", nFrame);
+	}
+}
+
+int main() {
+	TLC59711Dmx tlc59711Dmx;
+	tlc59711Dmx.SetType(tlc59711::Type::RGB);
+	tlc59711Dmx.SetCount(LEDS);
+	tlc59711Dmx.Start();
+
+	std::mt19937 rng(20240601);
+	static uint8_t dmxData[lightset::dmx::UNIVERSE_SIZE];
+
+	/*
+	 * Every frame is sent by Art-Net / sACN, a scene change every 2 seconds,
+	 * a 1 second fade on 6 channels every 5 seconds
+	 */
+
+	mock::reset_counters();
+
+	uint32_t nChangedFrames = 0;
+
+	for (uint32_t nFrame = 0; nFrame < FRAMES; nFrame++) {
+		auto isChanged = false;
+
+		if ((nFrame % 88) == 0) {
+			for (uint32_t i = 0; i < CHANNELS; i++) {
+				dmxData[i] = static_cast<uint8_t>(rng());
+			}
+			isChanged = true;
+		}
+
+		if ((nFrame % 220) < 44) {
+			for (uint32_t i = 0; i < 6; i++) {
+				dmxData[i] = static_cast<uint8_t>((nFrame % 220) * 5);
+			}
+			isChanged = true;
+		}
+
+		nChangedFrames += isChanged ? 1 : 0;
+
+		const auto nFramesBefore = mock::s_nFrames;
+
+		// As with a LightSetChain: the output at the sync point
+		tlc59711Dmx.SetData(0, dmxData, lightset::dmx::UNIVERSE_SIZE, false);
+		tlc59711Dmx.Sync(false);
+
+		check((mock::s_nFrames - nFramesBefore) == (isChanged ? 1U : 0U), "skip unchanged", nFrame);
+		verify(dmxData, false, "frame", nFrame);
+	}
+
+	const auto nBytesPerFrame = (CHANNELS / TLC59711Channels::OUT) * TLC59711Channels::U16BIT * 2;
+
+	printf("%u boards, %u bytes per SPI frame\n\n", CHANNELS / TLC59711Channels::OUT, nBytesPerFrame);
+	printf("%u DMX frames, %u changed\n", FRAMES, nChangedFrames);
+	printf("  SPI frames sent : %u (was %u)\n", mock::s_nFrames, FRAMES);
+	printf("  bytes per DMX frame : %.1f (was %u)\n", static_cast<double>(mock::s_nBytes) / FRAMES, nBytesPerFrame);
+	printf("  bus setups : %u\n", mock::s_nSetups);
+
+	/*
+	 * Blackout, then the output is restored without a DMX change
+	 */
+
+	tlc59711Dmx.Blackout(true);
+	verify(dmxData, true, "blackout", 0);
+	tlc59711Dmx.SetData(0, dmxData, lightset::dmx::UNIVERSE_SIZE);
+	verify(dmxData, true, "blackout, no output", 0);
+	tlc59711Dmx.Blackout(false);
+	verify(dmxData, false, "blackout restored", 0);
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
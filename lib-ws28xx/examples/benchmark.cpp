@@ -0,0 +1,100 @@
+/**
+ * @file benchmark.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Runs each pattern headless and reports the time to render and encode one frame.
+ * Usage: benchmark [pixel count] [frames]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+
+#include "hardware.h"
+#include "pixelconfiguration.h"
+#include "pixelpatterns.h"
+#include "ws28xx.h"
+
+static uint64_t micros() {
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return (static_cast<uint64_t>(tv.tv_sec) * 1000000U) + static_cast<uint64_t>(tv.tv_usec);
+}
+
+int main(int argc, char **argv) {
+	const auto nCount = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 0)) : 680U;
+	const auto nFrames = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 1000U;
+
+	Hardware hw;
+
+	static constexpr pixel::Type TYPES[] = { pixel::Type::WS2812B, pixel::Type::SK6812W, pixel::Type::APA102 };
+
+	for (const auto type : TYPES) {
+		PixelConfiguration pixelConfiguration;
+		pixelConfiguration.SetType(type);
+		pixelConfiguration.SetCount(nCount);
+
+		WS28xx ws28xx(pixelConfiguration);
+		PixelPatterns pixelPatterns(1);
+
+		printf("%s, %u pixels, %u frames\n", PixelType::GetType(type), nCount, nFrames);
+
+		for (auto i = static_cast<uint32_t>(pixelpatterns::Pattern::RAINBOW_CYCLE); i < static_cast<uint32_t>(pixelpatterns::Pattern::LAST); i++) {
+			const auto pattern = static_cast<pixelpatterns::Pattern>(i);
+
+			switch (pattern) {
+			case pixelpatterns::Pattern::RAINBOW_CYCLE:
+				pixelPatterns.RainbowCycle(0, 0);
+				break;
+			case pixelpatterns::Pattern::THEATER_CHASE:
+				pixelPatterns.TheaterChase(0, pixelPatterns.Colour(255, 0, 0), pixelPatterns.Colour(0, 0, 255), 0);
+				break;
+			case pixelpatterns::Pattern::COLOR_WIPE:
+				pixelPatterns.ColourWipe(0, pixelPatterns.Colour(0, 255, 0), 0);
+				break;
+			case pixelpatterns::Pattern::SCANNER:
+				pixelPatterns.Scanner(0, pixelPatterns.Colour(255, 255, 255), 0);
+				break;
+			case pixelpatterns::Pattern::FADE:
+				pixelPatterns.Fade(0, pixelPatterns.Colour(255, 0, 0), pixelPatterns.Colour(0, 0, 255), 64, 0);
+				break;
+			default:
+				break;
+			}
+
+			const auto nStart = micros();
+
+			for (uint32_t nFrame = 0; nFrame < nFrames; nFrame++) {
+				pixelPatterns.Run();
+			}
+
+			const auto nNanos = static_cast<uint32_t>(((micros() - nStart) * 1000U) / nFrames);
+
+			printf(" %-14s %8u ns/frame\n", PixelPatterns::GetName(pattern), nNanos);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file timing.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The timing model of WS28xxMulti (H3, 8 ports on one SPI DMA stream).
+ * - Verify: the transfer size of the model is the buffer size of the driver.
+ * - Report: the achievable frames per second, for a full frame, for a frame
+ *   sent up to the last changed pixel, and with a maximum refresh rate.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+
+#include "pixelconfiguration.h"
+#include "pixeltype.h"
+#include "ws28xxmultitiming.h"
+
+using namespace ws28xxmulti;
+
+static uint32_t s_nErrors;
+
+static void check(bool isOk, const char *pTest, uint32_t nIteration) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s iteration %u\n", pTest, nIteration);
+		}
+	}
+}
+
+/*
+ * As in the constructor of WS28xxMulti
+ */
+static uint32_t driver_buffer_size(const PixelConfiguration& pixelConfiguration, const uint32_t nLedsPerPixel) {
+	const auto nCount = pixelConfiguration.GetCount();
+	const auto type = pixelConfiguration.GetType();
+	auto nBufSize = nCount * nLedsPerPixel;
+
+	if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822) || (type == pixel::Type::P9813)) {
+		nBufSize += nCount;
+		nBufSize += 8;
+	}
+
+	return (nBufSize * 8) + 1;
+}
+
+static double fps(const uint32_t nMicros, const uint32_t nRefreshRateMax) {
+	auto nFrameMicros = nMicros;
+
+	if (nRefreshRateMax != 0) {
+		nFrameMicros = std::max(nFrameMicros, 1000000U / nRefreshRateMax);
+	}
+
+	return 1000000.0 / nFrameMicros;
+}
+
+int main() {
+	static constexpr pixel::Type TYPES[] = { pixel::Type::WS2812B, pixel::Type::SK6812W, pixel::Type::WS2801, pixel::Type::APA102 };
+	static constexpr uint32_t COUNTS[] = { 50, 170, 340, 510, 680 };
+	static constexpr uint32_t CHANGED[] = { 100, 50, 10 };	// % of the pixels, the last changed pixel
+	static constexpr uint32_t REFRESH_RATE_MAX = 40;
+
+	uint32_t nIteration = 0;
+
+	puts("Type      Count  Board     Bytes   Frame(us)     100%      50%      10%  max 40Hz  (fps)");
+
+	for (const auto type : TYPES) {
+		for (const auto nCount : COUNTS) {
+			for (uint32_t nBoard = 0; nBoard < 2; nBoard++) {
+				const auto hasCPLD = (nBoard == 1);
+
+				PixelConfiguration pixelConfiguration;
+				pixelConfiguration.SetType(type);
+				pixelConfiguration.SetCount(nCount);
+
+				uint32_t nLedsPerPixel;
+				pixelConfiguration.Validate(nLedsPerPixel);
+
+				// The RTZ output does not depend on the board
+				if (pixelConfiguration.IsRTZProtocol() && hasCPLD) {
+					continue;
+				}
+
+				const auto nValidatedCount = pixelConfiguration.GetCount();
+				const auto nBytes = timing::get_transfer_bytes(type, nValidatedCount);
+
+				check(nBytes == driver_buffer_size(pixelConfiguration, nLedsPerPixel), "buffer size", nIteration);
+
+				const auto nSpeedHz = timing::get_spi_speed_hz(pixelConfiguration, hasCPLD);
+				const auto nFullMicros = timing::get_transfer_micros(nBytes, nSpeedHz);
+
+				printf("%-8s %6u  %-8s %6u %11u ", PixelType::GetType(type), nValidatedCount, pixelConfiguration.IsRTZProtocol() ? "-" : (hasCPLD ? "CPLD" : "74-logic"), nBytes, nFullMicros);
+
+				auto nPreviousMicros = nFullMicros;
+
+				for (const auto nChanged : CHANGED) {
+					const auto nPixels = std::max(1U, (nValidatedCount * nChanged) / 100);
+					const auto nMicros = timing::is_truncatable(type) ? timing::get_transfer_micros(timing::get_transfer_bytes(type, nPixels), nSpeedHz) : nFullMicros;
+
+					check(nMicros <= nPreviousMicros, "truncated", nIteration);
+					nPreviousMicros = nMicros;
+
+					printf(" %8.1f", fps(nMicros, 0));
+				}
+
+				const auto fLimited = fps(timing::get_transfer_micros(timing::get_transfer_bytes(type, 1), nSpeedHz), REFRESH_RATE_MAX);
+				check(fLimited <= REFRESH_RATE_MAX + 0.01, "refresh rate maximum", nIteration);
+
+				printf(" %9.1f\n", fLimited);
+
+				nIteration++;
+			}
+		}
+	}
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
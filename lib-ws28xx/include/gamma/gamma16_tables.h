@@ -0,0 +1,102 @@
+/**
+ * @file gamma16_tables.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef GAMMA16_TABLES_H_
+#define GAMMA16_TABLES_H_
+
+#include <cstdint>
+
+#include "gamma10offset0_16.h"
+#include "gamma20offset0_16.h"
+#include "gamma21offset0_16.h"
+#include "gamma22offset0_16.h"
+#include "gamma23offset0_16.h"
+#include "gamma24offset0_16.h"
+#include "gamma25offset0_16.h"
+
+#include "gamma_tables.h"
+#include "pixeltype.h"
+
+namespace gamma16 {
+static constexpr auto ENTRIES = 257U;
+
+inline static const uint16_t *get_table_default(const pixel::Type type) {
+	if ((type == pixel::Type::WS2801) || (type == pixel::Type::APA102) || (type == pixel::Type::SK9822)) {
+		return gamma25_0_16;
+	}
+
+	if (type == pixel::Type::P9813) {
+		return gamma10_0_16;
+	}
+
+	return gamma22_0_16;
+}
+
+inline static const uint16_t *get_table(const uint32_t nValue) {
+	switch (nValue) {
+	case 20:
+		return gamma20_0_16;
+		break;
+	case 21:
+		return gamma21_0_16;
+		break;
+	case 22:
+		return gamma22_0_16;
+		break;
+	case 23:
+		return gamma23_0_16;
+		break;
+	case 24:
+		return gamma24_0_16;
+		break;
+	case 25:
+		return gamma25_0_16;
+		break;
+	default:
+		return gamma10_0_16;
+		break;
+	}
+}
+
+/**
+ * Linear interpolation between the table entries, the 16-bit input is (index << 8) + fraction.
+ * In the last segment the fraction is divided by 255, 0xFFFF gives the last entry.
+ */
+inline static uint16_t get_value(const uint16_t *pTable, const uint16_t nValue) {
+	const auto nIndex = static_cast<uint32_t>(nValue >> 8);
+	const auto nFraction = static_cast<uint32_t>(nValue & 0xFF);
+	const auto nLow = static_cast<uint32_t>(pTable[nIndex]);
+	const auto nDelta = static_cast<uint32_t>(pTable[nIndex + 1]) - nLow;
+
+	if (__builtin_expect((nIndex == 0xFF), 0)) {
+		return static_cast<uint16_t>(nLow + ((nDelta * nFraction) / 0xFF));
+	}
+
+	return static_cast<uint16_t>(nLow + ((nDelta * nFraction) >> 8));
+}
+
+}  // namespace gamma16
+
+#endif /* GAMMA16_TABLES_H_ */
@@ -0,0 +1,20 @@
+// gamma=2.0, offset=0.0, 16-bit, 257 entries: the input is (index << 8)
+static constexpr uint16_t gamma20_0_16[257] = {
+     0,     1,     4,     9,    16,    25,    36,    49,    64,    81,   100,   121,   144,   169,   196,   225,
+   256,   289,   324,   361,   400,   441,   484,   529,   576,   625,   676,   729,   784,   841,   900,   961,
+  1024,  1089,  1156,  1225,  1296,  1369,  1444,  1521,  1600,  1681,  1764,  1849,  1936,  2025,  2116,  2209,
+  2304,  2401,  2500,  2601,  2704,  2809,  2916,  3025,  3136,  3249,  3364,  3481,  3600,  3721,  3844,  3969,
+  4096,  4225,  4356,  4489,  4624,  4761,  4900,  5041,  5184,  5329,  5476,  5625,  5776,  5929,  6084,  6241,
+  6400,  6561,  6724,  6889,  7056,  7225,  7396,  7569,  7744,  7921,  8100,  8281,  8464,  8649,  8836,  9025,
+  9216,  9409,  9604,  9801, 10000, 10201, 10404, 10609, 10816, 11025, 11236, 11449, 11664, 11881, 12100, 12321,
+ 12544, 12769, 12996, 13225, 13456, 13689, 13924, 14161, 14400, 14641, 14884, 15129, 15376, 15625, 15876, 16129,
+ 16384, 16641, 16900, 17161, 17424, 17689, 17956, 18225, 18496, 18769, 19044, 19321, 19600, 19881, 20164, 20449,
+ 20736, 21025, 21316, 21609, 21904, 22201, 22500, 22801, 23104, 23409, 23716, 24025, 24336, 24649, 24964, 25281,
+ 25600, 25921, 26244, 26569, 26896, 27225, 27556, 27889, 28224, 28561, 28900, 29241, 29584, 29929, 30276, 30625,
+ 30976, 31329, 31684, 32041, 32400, 32761, 33123, 33488, 33855, 34224, 34595, 34968, 35343, 35720, 36099, 36480,
+ 36863, 37248, 37635, 38024, 38415, 38808, 39203, 39600, 39999, 40400, 40803, 41208, 41615, 42024, 42435, 42848,
+ 43263, 43680, 44099, 44520, 44943, 45368, 45795, 46224, 46655, 47088, 47523, 47960, 48399, 48840, 49283, 49728,
+ 50175, 50624, 51075, 51528, 51983, 52440, 52899, 53360, 53823, 54288, 54755, 55224, 55695, 56168, 56643, 57120,
+ 57599, 58080, 58563, 59048, 59535, 60024, 60515, 61008, 61503, 62000, 62499, 63000, 63503, 64008, 64515, 65024,
+ 65535
+};
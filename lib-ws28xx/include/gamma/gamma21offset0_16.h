@@ -0,0 +1,20 @@
+// gamma=2.1, offset=0.0, 16-bit, 257 entries: the input is (index << 8)
+static constexpr uint16_t gamma21_0_16[257] = {
+     0,     1,     2,     6,    11,    17,    25,    34,    45,    58,    72,    88,   106,   125,   147,   169,
+   194,   220,   248,   278,   310,   343,   379,   416,   455,   495,   538,   582,   628,   676,   726,   778,
+   832,   887,   945,  1004,  1065,  1128,  1193,  1260,  1329,  1400,  1472,  1547,  1623,  1702,  1782,  1865,
+  1949,  2035,  2123,  2213,  2306,  2400,  2496,  2594,  2694,  2796,  2900,  3006,  3114,  3224,  3336,  3450,
+  3566,  3684,  3804,  3926,  4050,  4176,  4304,  4434,  4566,  4701,  4837,  4975,  5115,  5258,  5402,  5549,
+  5697,  5848,  6000,  6155,  6312,  6471,  6632,  6795,  6960,  7127,  7296,  7467,  7641,  7816,  7994,  8173,
+  8355,  8539,  8725,  8913,  9103,  9295,  9489,  9686,  9884, 10085, 10288, 10492, 10699, 10908, 11120, 11333,
+ 11549, 11766, 11986, 12208, 12432, 12658, 12886, 13117, 13349, 13584, 13821, 14060, 14301, 14544, 14789, 15037,
+ 15287, 15538, 15792, 16049, 16307, 16568, 16830, 17095, 17362, 17631, 17903, 18176, 18452, 18730, 19010, 19292,
+ 19576, 19863, 20152, 20443, 20736, 21031, 21329, 21628, 21930, 22234, 22540, 22849, 23160, 23472, 23788, 24105,
+ 24424, 24746, 25070, 25396, 25724, 26055, 26387, 26722, 27059, 27399, 27740, 28084, 28430, 28778, 29129, 29481,
+ 29836, 30193, 30553, 30914, 31278, 31644, 32012, 32383, 32756, 33131, 33508, 33887, 34269, 34653, 35039, 35427,
+ 35818, 36211, 36606, 37003, 37403, 37805, 38209, 38615, 39024, 39435, 39848, 40263, 40681, 41101, 41523, 41948,
+ 42374, 42803, 43234, 43668, 44104, 44542, 44982, 45424, 45869, 46316, 46766, 47217, 47671, 48127, 48586, 49047,
+ 49510, 49975, 50443, 50912, 51385, 51859, 52336, 52815, 53296, 53780, 54265, 54754, 55244, 55737, 56232, 56729,
+ 57229, 57730, 58235, 58741, 59250, 59761, 60274, 60790, 61308, 61828, 62351, 62876, 63403, 63933, 64464, 64999,
+ 65535
+};
@@ -0,0 +1,20 @@
+// gamma=2.2, offset=0.0, 16-bit, 257 entries: the input is (index << 8)
+static constexpr uint16_t gamma22_0_16[257] = {
+     0,     0,     2,     4,     7,    11,    17,    24,    32,    41,    52,    64,    78,    93,   110,   128,
+   147,   168,   191,   215,   240,   267,   296,   327,   359,   392,   428,   465,   504,   544,   586,   630,
+   676,   723,   772,   823,   875,   930,   986,  1044,  1104,  1165,  1229,  1294,  1361,  1430,  1501,  1574,
+  1648,  1725,  1803,  1884,  1966,  2050,  2136,  2224,  2314,  2406,  2500,  2595,  2693,  2793,  2895,  2998,
+  3104,  3212,  3322,  3433,  3547,  3663,  3781,  3900,  4022,  4146,  4272,  4400,  4530,  4663,  4797,  4933,
+  5072,  5212,  5355,  5499,  5646,  5795,  5946,  6099,  6255,  6412,  6572,  6733,  6897,  7063,  7231,  7402,
+  7574,  7749,  7926,  8105,  8286,  8469,  8655,  8843,  9033,  9225,  9419,  9616,  9815, 10016, 10219, 10425,
+ 10632, 10842, 11054, 11269, 11486, 11705, 11926, 12149, 12375, 12603, 12833, 13066, 13301, 13538, 13777, 14019,
+ 14263, 14509, 14758, 15009, 15262, 15517, 15775, 16035, 16298, 16563, 16830, 17099, 17371, 17645, 17922, 18201,
+ 18482, 18765, 19051, 19339, 19630, 19923, 20218, 20516, 20816, 21119, 21424, 21731, 22040, 22352, 22667, 22984,
+ 23303, 23624, 23949, 24275, 24604, 24935, 25269, 25605, 25943, 26284, 26628, 26973, 27322, 27672, 28026, 28381,
+ 28739, 29100, 29462, 29828, 30196, 30566, 30939, 31314, 31692, 32072, 32454, 32840, 33227, 33617, 34010, 34405,
+ 34802, 35202, 35605, 36010, 36417, 36827, 37240, 37655, 38072, 38493, 38915, 39340, 39768, 40198, 40631, 41066,
+ 41503, 41944, 42387, 42832, 43280, 43730, 44183, 44639, 45097, 45557, 46020, 46486, 46954, 47425, 47899, 48374,
+ 48853, 49334, 49818, 50304, 50793, 51284, 51778, 52275, 52774, 53276, 53780, 54287, 54796, 55308, 55823, 56341,
+ 56860, 57383, 57908, 58436, 58966, 59499, 60035, 60573, 61114, 61657, 62203, 62752, 63303, 63857, 64414, 64973,
+ 65535
+};
@@ -0,0 +1,20 @@
+// gamma=2.3, offset=0.0, 16-bit, 257 entries: the input is (index << 8)
+static constexpr uint16_t gamma23_0_16[257] = {
+     0,     0,     1,     2,     5,     8,    12,    17,    23,    30,    38,    47,    57,    69,    82,    96,
+   111,   128,   146,   165,   186,   208,   232,   257,   283,   311,   340,   371,   404,   438,   473,   510,
+   549,   589,   631,   674,   719,   766,   815,   865,   917,   970,  1026,  1083,  1141,  1202,  1264,  1328,
+  1394,  1462,  1532,  1603,  1676,  1751,  1828,  1907,  1988,  2070,  2155,  2241,  2330,  2420,  2512,  2606,
+  2702,  2800,  2900,  3003,  3107,  3213,  3321,  3431,  3543,  3657,  3774,  3892,  4012,  4135,  4259,  4386,
+  4515,  4646,  4779,  4914,  5051,  5190,  5332,  5475,  5621,  5769,  5919,  6072,  6226,  6383,  6542,  6703,
+  6867,  7032,  7200,  7370,  7543,  7717,  7894,  8073,  8255,  8438,  8624,  8813,  9003,  9196,  9391,  9589,
+  9789,  9991, 10195, 10402, 10611, 10823, 11037, 11253, 11472, 11693, 11917, 12142, 12371, 12601, 12834, 13070,
+ 13308, 13548, 13791, 14036, 14284, 14534, 14786, 15041, 15299, 15559, 15821, 16086, 16354, 16624, 16896, 17171,
+ 17448, 17728, 18011, 18296, 18583, 18873, 19166, 19461, 19759, 20059, 20362, 20667, 20975, 21286, 21599, 21915,
+ 22233, 22554, 22877, 23203, 23532, 23864, 24197, 24534, 24873, 25215, 25560, 25907, 26256, 26609, 26964, 27322,
+ 27682, 28045, 28411, 28780, 29151, 29524, 29901, 30280, 30662, 31047, 31434, 31824, 32217, 32612, 33011, 33412,
+ 33815, 34222, 34631, 35043, 35458, 35875, 36295, 36718, 37144, 37573, 38004, 38438, 38875, 39315, 39757, 40203,
+ 40651, 41102, 41555, 42012, 42471, 42933, 43398, 43866, 44337, 44810, 45287, 45766, 46248, 46733, 47221, 47711,
+ 48205, 48701, 49201, 49703, 50208, 50716, 51227, 51740, 52257, 52776, 53299, 53824, 54352, 54884, 55418, 55955,
+ 56495, 57038, 57583, 58132, 58684, 59238, 59796, 60357, 60920, 61487, 62056, 62628, 63204, 63782, 64363, 64948,
+ 65535
+};
@@ -0,0 +1,20 @@
+// gamma=2.4, offset=0.0, 16-bit, 257 entries: the input is (index << 8)
+static constexpr uint16_t gamma24_0_16[257] = {
+     0,     0,     1,     2,     3,     5,     8,    12,    16,    21,    27,    34,    42,    51,    61,    72,
+    84,    98,   112,   128,   144,   162,   181,   202,   223,   246,   271,   296,   324,   352,   382,   413,
+   446,   480,   516,   553,   591,   632,   673,   717,   761,   808,   856,   906,   957,  1010,  1065,  1121,
+  1179,  1239,  1301,  1364,  1429,  1496,  1565,  1635,  1707,  1782,  1857,  1935,  2015,  2096,  2180,  2265,
+  2352,  2442,  2533,  2626,  2721,  2818,  2917,  3018,  3121,  3226,  3333,  3442,  3553,  3667,  3782,  3899,
+  4019,  4141,  4264,  4390,  4518,  4648,  4781,  4915,  5052,  5191,  5332,  5475,  5621,  5768,  5918,  6071,
+  6225,  6382,  6541,  6702,  6866,  7032,  7200,  7371,  7544,  7719,  7896,  8076,  8259,  8443,  8631,  8820,
+  9012,  9206,  9403,  9602,  9804, 10008, 10214, 10423, 10635, 10849, 11065, 11284, 11506, 11730, 11956, 12185,
+ 12417, 12651, 12887, 13126, 13368, 13613, 13860, 14109, 14361, 14616, 14873, 15133, 15396, 15661, 15929, 16200,
+ 16473, 16749, 17027, 17308, 17592, 17879, 18168, 18460, 18755, 19053, 19353, 19656, 19962, 20270, 20581, 20895,
+ 21212, 21532, 21854, 22179, 22507, 22838, 23172, 23508, 23847, 24189, 24534, 24882, 25233, 25586, 25943, 26302,
+ 26664, 27029, 27397, 27768, 28142, 28518, 28898, 29281, 29666, 30055, 30446, 30840, 31237, 31638, 32041, 32447,
+ 32856, 33269, 33684, 34102, 34523, 34948, 35375, 35805, 36238, 36675, 37114, 37557, 38002, 38451, 38903, 39357,
+ 39815, 40276, 40740, 41207, 41678, 42151, 42628, 43107, 43590, 44076, 44565, 45057, 45552, 46051, 46553, 47058,
+ 47566, 48077, 48591, 49109, 49630, 50154, 50681, 51211, 51745, 52282, 52822, 53365, 53912, 54462, 55015, 55572,
+ 56131, 56694, 57260, 57830, 58403, 58979, 59558, 60141, 60727, 61316, 61909, 62505, 63104, 63707, 64313, 64922,
+ 65535
+};
@@ -0,0 +1,20 @@
+// gamma=2.5, offset=0.0, 16-bit, 257 entries: the input is (index << 8)
+static constexpr uint16_t gamma25_0_16[257] = {
+     0,     0,     0,     1,     2,     3,     6,     8,    11,    15,    20,    25,    31,    38,    46,    54,
+    64,    74,    86,    98,   112,   126,   142,   159,   176,   195,   215,   237,   259,   283,   308,   334,
+   362,   391,   421,   453,   486,   520,   556,   594,   632,   673,   714,   758,   803,   849,   897,   946,
+   998,  1050,  1105,  1161,  1219,  1278,  1339,  1402,  1467,  1533,  1601,  1671,  1743,  1816,  1892,  1969,
+  2048,  2129,  2212,  2296,  2383,  2472,  2562,  2655,  2749,  2846,  2944,  3045,  3147,  3252,  3358,  3467,
+  3578,  3691,  3805,  3923,  4042,  4163,  4287,  4412,  4540,  4670,  4803,  4937,  5074,  5213,  5354,  5498,
+  5644,  5792,  5942,  6095,  6250,  6407,  6567,  6729,  6894,  7061,  7230,  7402,  7576,  7752,  7931,  8113,
+  8297,  8483,  8672,  8864,  9058,  9254,  9453,  9655,  9859, 10066, 10275, 10487, 10701, 10918, 11138, 11360,
+ 11585, 11813, 12043, 12276, 12511, 12750, 12991, 13235, 13481, 13730, 13982, 14237, 14494, 14754, 15017, 15283,
+ 15552, 15823, 16097, 16374, 16654, 16937, 17223, 17511, 17803, 18097, 18394, 18694, 18997, 19303, 19612, 19924,
+ 20238, 20556, 20877, 21200, 21527, 21857, 22189, 22525, 22864, 23205, 23550, 23898, 24249, 24603, 24960, 25320,
+ 25684, 26050, 26419, 26792, 27168, 27547, 27929, 28314, 28702, 29094, 29489, 29887, 30288, 30692, 31100, 31511,
+ 31925, 32342, 32763, 33186, 33613, 34044, 34478, 34915, 35355, 35798, 36245, 36696, 37149, 37606, 38066, 38530,
+ 38997, 39467, 39941, 40418, 40899, 41383, 41870, 42361, 42856, 43353, 43855, 44359, 44867, 45379, 45894, 46413,
+ 46935, 47460, 47989, 48522, 49058, 49598, 50141, 50688, 51238, 51792, 52350, 52911, 53475, 54044, 54615, 55191,
+ 55770, 56353, 56939, 57529, 58123, 58720, 59321, 59926, 60534, 61147, 61762, 62382, 63005, 63632, 64263, 64897,
+ 65535
+};
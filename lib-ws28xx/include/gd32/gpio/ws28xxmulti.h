@@ -39,6 +39,22 @@ public:
 
 	void SetPixel(const uint32_t nPortIndex, const uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
 	void SetPixel(const uint32_t nPortIndex, const uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
+	/**
+	 * Encodes nCount pixels of a port in one call.
+	 * @param pFrame RGB, 3 bytes per pixel. RGBW, 4 bytes per pixel, for SK6812W.
+	 */
+	void SetPixels(const uint32_t nPortIndex, const uint32_t nPixelIndex, const uint8_t *pFrame, const uint32_t nCount) {
+		if (m_PixelConfiguration.GetType() == pixel::Type::SK6812W) {
+			for (uint32_t i = 0; i < nCount; i++, pFrame += 4) {
+				SetPixel(nPortIndex, nPixelIndex + i, pFrame[0], pFrame[1], pFrame[2], pFrame[3]);
+			}
+			return;
+		}
+
+		for (uint32_t i = 0; i < nCount; i++, pFrame += 3) {
+			SetPixel(nPortIndex, nPixelIndex + i, pFrame[0], pFrame[1], pFrame[2]);
+		}
+	}
 
 	bool IsUpdating();
 
@@ -29,6 +29,7 @@
 #include <cstdint>
 
 #include "pixelconfiguration.h"
+#include "ws28xxmultitiming.h"
 #include "gamma/gamma_tables.h"
 
 #include "h3_spi.h"
@@ -43,15 +44,74 @@ public:
 
 	void SetPixel(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
 	void SetPixel(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
+	/**
+	 * Encodes nCount pixels of a port in one call.
+	 * @param pFrame RGB, 3 bytes per pixel. RGBW, 4 bytes per pixel, for SK6812W.
+	 */
+	void SetPixels(uint32_t nPortIndex, uint32_t nPixelIndex, const uint8_t *pFrame, uint32_t nCount);
 
 	bool IsUpdating() {
 		return h3_spi_dma_tx_is_active();  // returns TRUE while DMA operation is active
 	}
 
+	/**
+	 * Sends the pixels up to the last changed pixel. With a maximum refresh rate,
+	 * a frame arriving too early is kept pending, it is started with Run() or FrameBegin().
+	 */
 	void Update();
 	void Blackout();
 	void FullOn();
 
+	void Run() {
+		if (__builtin_expect((!m_bUpdatePending), 1)) {
+			return;
+		}
+
+		if (!IsUpdating() && ((H3_TIMER->AVS_CNT1 - m_nStartMicros) >= m_nFrameMicrosMin)) {
+			m_bUpdatePending = false;
+			Start();
+		}
+	}
+
+	/**
+	 * Call before the first pixel of a next frame is written in the buffer.
+	 * The pending frame is started, or when it cannot be started yet,
+	 * it is replaced by the next frame. A frame is never sent torn.
+	 */
+	void FrameBegin() {
+		if (__builtin_expect((m_bUpdatePending), 0)) {
+			m_bUpdatePending = false;
+
+			if (!IsUpdating() && ((H3_TIMER->AVS_CNT1 - m_nStartMicros) >= m_nFrameMicrosMin)) {
+				Start();
+			} else {
+				m_nFramesCoalesced++;
+			}
+		}
+	}
+
+	/**
+	 * The number of pixels changed since the last transfer, for a port
+	 */
+	uint32_t GetDirtyPixels(const uint32_t nPortIndex) const {
+		return m_nDirtyPixels[nPortIndex & 0x7];
+	}
+
+	uint32_t GetFramesSkipped() const {
+		return m_nFramesSkipped;
+	}
+
+	uint32_t GetFramesDeferred() const {
+		return m_nFramesDeferred;
+	}
+
+	/**
+	 * @return Pending frames replaced by a newer frame, before being sent
+	 */
+	uint32_t GetFramesCoalesced() const {
+		return m_nFramesCoalesced;
+	}
+
 	pixel::Type GetType() const {
 		return m_PixelConfiguration.GetType();
 	}
@@ -80,11 +140,34 @@ private:
 	void SetupBuffers();
 	void SetPixel4Bytes(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
 	void SetColour(const uint32_t nPortIndex, const uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
+	void Start();
+
+	void SetDirty(const uint32_t nPortIndex, const uint32_t nPixelIndex) {
+		if (nPixelIndex >= m_nDirtyPixels[nPortIndex]) {
+			m_nDirtyPixels[nPortIndex] = nPixelIndex + 1;
+		}
+	}
+
+	void SetDirtyAll() {
+		for (auto& nDirtyPixels : m_nDirtyPixels) {
+			nDirtyPixels = m_nPixels;
+		}
+	}
 
 private:
 	PixelConfiguration m_PixelConfiguration;
 	bool m_hasCPLD { false };
+	bool m_bIsTruncatable { false };
+	bool m_bUpdatePending { false };
 	uint32_t m_nBufSize { 0 };
+	uint32_t m_nPixels { 0 };	///< The pixel indexes in the buffer, including the start and end frame
+	uint32_t m_nDirtyPixels[8] { 0 };
+	uint32_t m_nFrameMicrosMin { 0 };
+	uint32_t m_nStartMicros { 0 };
+	uint32_t m_nFullMicros { 0 };
+	uint32_t m_nFramesSkipped { 0 };
+	uint32_t m_nFramesDeferred { 0 };
+	uint32_t m_nFramesCoalesced { 0 };
 
 	uint8_t *const m_pBuffer { reinterpret_cast<uint8_t *>(H3_SRAM_A1_BASE + 4096) };
 	uint8_t *m_pDmaBuffer { nullptr };
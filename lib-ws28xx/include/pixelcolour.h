@@ -0,0 +1,156 @@
+/**
+ * @file pixelcolour.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PIXELCOLOUR_H_
+#define PIXELCOLOUR_H_
+
+#include <cstdint>
+#include <cassert>
+
+#include "pixelconfiguration.h"
+#include "pixeltype.h"
+#include "gamma/gamma16_tables.h"
+
+/**
+ * The 16-bit colour pipeline: gamma correction, white extraction and white balance
+ * in 16-bit linear light, then the 8-bit LED values, with optional temporal dithering.
+ */
+class PixelColour {
+public:
+	PixelColour() = default;
+	~PixelColour();
+
+	void Setup(const PixelConfiguration& pixelConfiguration);
+
+	bool IsDithering() const {
+		return m_pFrame != nullptr;
+	}
+
+	/**
+	 * In place, to 16-bit linear light.
+	 * @param aColour red, green, blue and white. Without a white input, aColour[pixel::colour::WHITE] is 0.
+	 */
+	void Convert(uint16_t aColour[pixel::colour::COUNT]) const {
+		for (uint32_t nColour = 0; nColour < pixel::colour::COUNT; nColour++) {
+			aColour[nColour] = gamma16::get_value(m_pGammaTable, aColour[nColour]);
+		}
+
+		if (m_bWhiteExtraction) {
+			auto nWhite = aColour[pixel::colour::RED];
+
+			if (aColour[pixel::colour::GREEN] < nWhite) {
+				nWhite = aColour[pixel::colour::GREEN];
+			}
+
+			if (aColour[pixel::colour::BLUE] < nWhite) {
+				nWhite = aColour[pixel::colour::BLUE];
+			}
+
+			aColour[pixel::colour::RED] = static_cast<uint16_t>(aColour[pixel::colour::RED] - nWhite);
+			aColour[pixel::colour::GREEN] = static_cast<uint16_t>(aColour[pixel::colour::GREEN] - nWhite);
+			aColour[pixel::colour::BLUE] = static_cast<uint16_t>(aColour[pixel::colour::BLUE] - nWhite);
+			aColour[pixel::colour::WHITE] = nWhite;
+		}
+
+		for (uint32_t nColour = 0; nColour < pixel::colour::COUNT; nColour++) {
+			aColour[nColour] = static_cast<uint16_t>((static_cast<uint32_t>(aColour[nColour]) * m_Gain[nColour]) >> 8);
+		}
+	}
+
+	/**
+	 * The 8-bit values for the nLeds LEDs of a pixel, in the order of pLinear.
+	 * With dithering, the linear values are kept for Render(nPixelIndex, pOutput).
+	 */
+	template<uint32_t nLeds>
+	void Render(uint32_t nPixelIndex, const uint16_t *pLinear, uint8_t *pOutput) {
+		assert(nLeds == m_nLedsPerPixel);
+
+		if (m_pFrame == nullptr) {
+			for (uint32_t i = 0; i < nLeds; i++) {
+				pOutput[i] = Round(pLinear[i]);
+			}
+			return;
+		}
+
+		auto *pFrame = &m_pFrame[nPixelIndex * nLeds];
+		auto *pResidual = &m_pResidual[nPixelIndex * nLeds];
+
+		for (uint32_t i = 0; i < nLeds; i++) {
+			pFrame[i] = pLinear[i];
+			pOutput[i] = Dither(pLinear[i], pResidual[i]);
+		}
+	}
+
+	/**
+	 * The kept values of a pixel rendered for the next frame
+	 */
+	template<uint32_t nLeds>
+	void Render(uint32_t nPixelIndex, uint8_t *pOutput) {
+		assert(nLeds == m_nLedsPerPixel);
+
+		const auto *pFrame = &m_pFrame[nPixelIndex * nLeds];
+		auto *pResidual = &m_pResidual[nPixelIndex * nLeds];
+
+		for (uint32_t i = 0; i < nLeds; i++) {
+			pOutput[i] = Dither(pFrame[i], pResidual[i]);
+		}
+	}
+
+	uint32_t GetLedsPerPixel() const {
+		return m_nLedsPerPixel;
+	}
+
+	static uint8_t Round(uint16_t nValue) {
+		const auto nRounded = (static_cast<uint32_t>(nValue) + 0x80) >> 8;
+		return static_cast<uint8_t>(nRounded > 0xFF ? 0xFF : nRounded);
+	}
+
+	/**
+	 * The rounding error is carried to the next frame: over n frames the sum of
+	 * the 8-bit values is within one 8-bit step of n times the 16-bit value.
+	 */
+	static uint8_t Dither(uint16_t nValue, uint8_t& nResidual) {
+		const auto nSum = static_cast<uint32_t>(nValue) + nResidual;
+
+		if (__builtin_expect((nSum > 0xFFFF), 0)) {
+			nResidual = 0;
+			return 0xFF;
+		}
+
+		nResidual = static_cast<uint8_t>(nSum);
+		return static_cast<uint8_t>(nSum >> 8);
+	}
+
+private:
+	const uint16_t *m_pGammaTable { gamma10_0_16 };
+	uint16_t *m_pFrame { nullptr };
+	uint8_t *m_pResidual { nullptr };
+	uint32_t m_nCount { 0 };
+	uint32_t m_nLedsPerPixel { 3 };
+	uint32_t m_Gain[pixel::colour::COUNT] { 0x100, 0x100, 0x100, 0x100 };
+	bool m_bWhiteExtraction { false };
+};
+
+#endif /* PIXELCOLOUR_H_ */
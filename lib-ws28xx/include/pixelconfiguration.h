@@ -30,6 +30,7 @@
 
 #include "pixeltype.h"
 #include "gamma/gamma_tables.h"
+#include "gamma/gamma16_tables.h"
 
 class PixelConfiguration {
 public:
@@ -109,6 +110,66 @@ public:
 		return m_pGammaTable;
 	}
 
+	const uint16_t *GetGammaTable16() const {
+		return m_pGammaTable16;
+	}
+
+	/**
+	 * Frame to frame temporal dithering of the 16-bit colour values
+	 */
+	void SetEnableDithering(bool doEnable) {
+		m_bEnableDithering = doEnable;
+	}
+
+	bool IsEnableDithering() const {
+		return m_bEnableDithering;
+	}
+
+	/**
+	 * The gain per colour, pixel::colour::RED .. WHITE, applied in linear light. 0xFF is unity.
+	 */
+	void SetWhiteBalance(uint32_t nColour, uint8_t nGain) {
+		if (nColour < pixel::colour::COUNT) {
+			m_WhiteBalance[nColour] = nGain;
+		}
+	}
+
+	uint8_t GetWhiteBalance(uint32_t nColour) const {
+		if (nColour < pixel::colour::COUNT) {
+			return m_WhiteBalance[nColour];
+		}
+		return 0xFF;
+	}
+
+	/**
+	 * RGB input for RGBW pixels, the white LED takes the common part of red, green and blue
+	 */
+	void SetEnableWhiteExtraction(bool doEnable) {
+		m_bEnableWhiteExtraction = doEnable;
+	}
+
+	bool IsEnableWhiteExtraction() const {
+		return m_bEnableWhiteExtraction;
+	}
+
+	/**
+	 * The maximum refresh rate of the outputs, 0 is unlimited
+	 */
+	void SetRefreshRateMax(uint32_t nRefreshRateMax) {
+		m_nRefreshRateMax = nRefreshRateMax;
+	}
+
+	uint32_t GetRefreshRateMax() const {
+		return m_nRefreshRateMax;
+	}
+
+	/**
+	 * Set by Validate: the pixels are written with the 16-bit colour pipeline
+	 */
+	bool IsColour16() const {
+		return m_bIsColour16;
+	}
+
 	void Validate(uint32_t& nLedsPerPixel);
 
 	void Print();
@@ -126,13 +187,19 @@ private:
 	uint32_t m_nCount { pixel::defaults::COUNT };
 	pixel::Map m_map { pixel::Map::UNDEFINED };
 	uint32_t m_nClockSpeedHz { 0 };
+	uint32_t m_nRefreshRateMax { 0 };
 	uint8_t m_nLowCode { 0 };
 	uint8_t m_nHighCode { 0 };
 	uint8_t m_nGlobalBrightness { 0xFF };
 	uint8_t m_nGammaValue { 0 };
 	bool m_bEnableGammaCorrection { false };
 	bool m_bIsRTZProtocol { true };
+	bool m_bEnableDithering { false };
+	bool m_bEnableWhiteExtraction { false };
+	bool m_bIsColour16 { false };
+	uint8_t m_WhiteBalance[pixel::colour::COUNT] { 0xFF, 0xFF, 0xFF, 0xFF };
 	const uint8_t *m_pGammaTable { gamma10_0 };
+	const uint16_t *m_pGammaTable16 { gamma10_0_16 };
 };
 
 #endif /* PIXELCONFIGURATION_H_ */
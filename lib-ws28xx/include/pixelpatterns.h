@@ -57,7 +57,7 @@ enum class Direction {
 class PixelPatterns {
 public:
 	PixelPatterns(uint32_t nActivePorts);
-	~PixelPatterns() = default;
+	~PixelPatterns();
 
 	static const char* GetName(pixelpatterns::Pattern pattern);
 
@@ -90,48 +90,58 @@ private:
 
 	bool PortUpdate(uint32_t nPortIndex, uint32_t nMillis);
 
-	uint32_t Wheel(uint8_t nWheelPos);
 	void Increment(uint32_t nPortIndex);
 	void Reverse(uint32_t nPortIndex);
 
-	void SetPixelColour(__attribute__((unused)) uint32_t nPortIndex, uint32_t nPixelIndex, uint32_t nColour) {
+	uint8_t *GetFrame(uint32_t nPortIndex, uint32_t nPixelIndex = 0) {
+		return &m_pFrame[((nPortIndex * m_nCount) + nPixelIndex) * m_nBytesPerPixel];
+	}
+
+	/**
+	 * Writes one pixel into the frame
+	 * @return the next pixel
+	 */
+	uint8_t *SetPixelColour(uint8_t *pPixel, uint32_t nColour) {
 		const auto nRed = Red(nColour);
 		const auto nGreen = Green(nColour);
 		const auto nBlue = Blue(nColour);
-#if defined (PIXELPATTERNS_MULTI)
-		if (m_pOutput->GetType() != pixel::Type::SK6812W) {
-			m_pOutput->SetPixel(nPortIndex, nPixelIndex, nRed, nGreen, nBlue);
-		} else {
-			if ((nRed == nGreen) && (nGreen == nBlue)) {
-				m_pOutput->SetPixel(nPortIndex, nPixelIndex, 0x00, 0x00, 0x00, nRed);
-			} else {
-				m_pOutput->SetPixel(nPortIndex, nPixelIndex, nRed, nGreen, nBlue, 0x00);
-			}
+
+		if (m_nBytesPerPixel == 3) {
+			pPixel[0] = nRed;
+			pPixel[1] = nGreen;
+			pPixel[2] = nBlue;
+			return pPixel + 3;
 		}
-#else
-		if (m_pOutput->GetType() != pixel::Type::SK6812W) {
-			m_pOutput->SetPixel(nPixelIndex, nRed, nGreen, nBlue);
+
+		if ((nRed == nGreen) && (nGreen == nBlue)) {
+			pPixel[0] = 0x00;
+			pPixel[1] = 0x00;
+			pPixel[2] = 0x00;
+			pPixel[3] = nRed;
 		} else {
-			if ((nRed == nGreen) && (nGreen == nBlue)) {
-				m_pOutput->SetPixel(nPixelIndex, 0x00, 0x00, 0x00, nRed);
-			} else {
-				m_pOutput->SetPixel(nPixelIndex, nRed, nGreen, nBlue, 0x00);
-			}
+			pPixel[0] = nRed;
+			pPixel[1] = nGreen;
+			pPixel[2] = nBlue;
+			pPixel[3] = 0x00;
 		}
-#endif
-	}
 
-	void ColourSet(uint32_t nPortIndex, uint32_t nColour) {
-		for (uint32_t i = 0; i < m_nCount; i++) {
-			SetPixelColour(nPortIndex, i, nColour);
-		}
+		return pPixel + 4;
 	}
 
-    uint32_t DimColour(uint32_t nColour) {
-        return Colour(static_cast<uint8_t>(Red(nColour) >> 1), static_cast<uint8_t>(Green(nColour) >> 1), static_cast<uint8_t>(Blue(nColour) >> 1));
-    }
+	void ColourSet(uint32_t nPortIndex, uint32_t nColour);
+
+	/**
+	 * Hands the frame pixels to the output driver, in one call.
+	 */
+	void Output(uint32_t nPortIndex, uint32_t nPixelIndex, uint32_t nCount) {
+#if defined (PIXELPATTERNS_MULTI)
+		m_pOutput->SetPixels(nPortIndex, nPixelIndex, GetFrame(nPortIndex, nPixelIndex), nCount);
+#else
+		m_pOutput->SetPixels(nPixelIndex, GetFrame(nPortIndex, nPixelIndex), nCount);
+#endif
+	}
 
-    uint8_t Red(uint32_t nColour) {
+	uint8_t Red(uint32_t nColour) {
 		return (nColour >> 16) & 0xFF;
 	}
 
@@ -145,6 +155,7 @@ private:
 
 	void Clear(uint32_t nPortIndex) {
 		ColourSet(nPortIndex, 0);
+		Output(nPortIndex, 0, m_nCount);
 	}
 
 private:
@@ -155,6 +166,7 @@ private:
 #endif
 	static uint32_t m_nActivePorts;
 	static uint32_t m_nCount;
+	static uint32_t m_nBytesPerPixel;
 
 	struct PortConfig {
 		uint32_t nLastUpdate;
@@ -169,7 +181,10 @@ private:
 
 	static PortConfig m_PortConfig[pixelpatterns::MAX_PORTS];
 
-	static uint32_t *m_pScannerColours;
+	/**
+	 * One contiguous RGB(W) frame for all the ports.
+	 */
+	static uint8_t *m_pFrame;
 };
 
 #endif /* PIXELPATTERNS_H_ */
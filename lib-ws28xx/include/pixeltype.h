@@ -72,6 +72,13 @@ static constexpr uint32_t default_hz = 4000000;	///< 4 MHz
 }  // namespace p9813
 }  // namespace speed
 }  // namespace spi
+namespace colour {
+static constexpr uint32_t RED = 0;
+static constexpr uint32_t GREEN = 1;
+static constexpr uint32_t BLUE = 2;
+static constexpr uint32_t WHITE = 3;
+static constexpr uint32_t COUNT = 4;
+}  // namespace colour
 namespace defaults {
 static constexpr auto TYPE = Type::WS2812B;
 static constexpr auto COUNT = 170;
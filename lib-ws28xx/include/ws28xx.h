@@ -29,6 +29,7 @@
 #include <cstdint>
 
 #include "pixelconfiguration.h"
+#include "pixelcolour.h"
 
 #if defined (USE_SPI_DMA)
 # include "hal_spi.h"
@@ -41,17 +42,74 @@ public:
 
 	void SetPixel(uint32_t nIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
 	void SetPixel(uint32_t nIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
+	/**
+	 * Encodes nCount pixels in one call.
+	 * @param pFrame RGB, 3 bytes per pixel. RGBW, 4 bytes per pixel, for SK6812W.
+	 */
+	void SetPixels(uint32_t nPixelIndex, const uint8_t *pFrame, uint32_t nCount);
+	/**
+	 * The 16-bit colour pipeline, see PixelColour. The map is applied here.
+	 * Without a white input for RGBW pixels, nWhite is 0.
+	 */
+	void SetPixel16(uint32_t nPixelIndex, uint16_t nRed, uint16_t nGreen, uint16_t nBlue, uint16_t nWhite = 0);
+
+	bool IsDithering() const {
+		return m_PixelColour.IsDithering();
+	}
+
+	/**
+	 * The next dithering step of the kept 16-bit frame, followed by Update()
+	 */
+	void Dither();
 
 #if defined ( USE_SPI_DMA )
 	bool IsUpdating () {
 		return FUNC_PREFIX (spi_dma_tx_is_active());
 	}
+
+	/**
+	 * Starts the pending frame when the previous transfer is completed.
+	 * Call from the main loop.
+	 */
+	void Run() {
+		if (__builtin_expect((m_bUpdatePending), 0)) {
+			if (!IsUpdating()) {
+				m_bUpdatePending = false;
+				Start();
+			}
+		}
+	}
+
+	/**
+	 * Call before the first pixel of a next frame is written in the back buffer.
+	 * The pending frame is started, or when the transfer is still active,
+	 * it is replaced by the next frame. A frame is never sent torn.
+	 */
+	void FrameBegin() {
+		if (__builtin_expect((m_bUpdatePending), 0)) {
+			m_bUpdatePending = false;
+
+			if (!IsUpdating()) {
+				Start();
+			} else {
+				m_nFramesCoalesced++;
+			}
+		}
+	}
 #else
 	bool IsUpdating() const {
 		return false;
 	}
+
+	void Run() {}
+	void FrameBegin() {}
 #endif
 
+	/**
+	 * With USE_SPI_DMA the pixels are written in the back buffer, also while
+	 * the front buffer is being sent. When the transfer is still active, the frame
+	 * is pending: it is started with Run() or FrameBegin().
+	 */
 	void Update();
 	void Blackout();
 	void FullOn();
@@ -68,6 +126,20 @@ public:
 		return m_PixelConfiguration.GetMap();
 	}
 
+	/**
+	 * @return Pending frames replaced by a newer frame, before being sent
+	 */
+	uint32_t GetFramesCoalesced() const {
+		return m_nFramesCoalesced;
+	}
+
+	/**
+	 * @return Pending frames discarded by Blackout() or FullOn()
+	 */
+	uint32_t GetFramesDropped() const {
+		return m_nFramesDropped;
+	}
+
 	static WS28xx *Get() {
 		return s_pThis;
 	}
@@ -75,12 +147,27 @@ public:
 private:
 	void SetupBuffers();
 	void SetColorWS28xx(uint32_t nOffset, uint8_t nValue);
+	void WritePixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
+	void WritePixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
+#if defined ( USE_SPI_DMA )
+	void Start();
+	void WaitUpdated();
+#endif
 
 private:
 	PixelConfiguration m_PixelConfiguration;
+	PixelColour m_PixelColour;
 	uint32_t m_nBufSize;
 	uint8_t *m_pBuffer { nullptr };
+#if defined ( USE_SPI_DMA )
+	uint8_t *m_pDmaBuffer[2];				///< The halves of the DMA coherent buffer, m_pBuffer is the back buffer
+	uint32_t m_nBack { 0 };
+	bool m_bUpdatePending { false };
+#else
 	uint8_t *m_pBlackoutBuffer { nullptr };
+#endif
+	uint32_t m_nFramesCoalesced { 0 };
+	uint32_t m_nFramesDropped { 0 };
 
 	static WS28xx *s_pThis;
 };
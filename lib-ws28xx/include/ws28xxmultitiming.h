@@ -0,0 +1,94 @@
+/**
+ * @file ws28xxmultitiming.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef WS28XXMULTITIMING_H_
+#define WS28XXMULTITIMING_H_
+
+#include <cstdint>
+
+#include "pixelconfiguration.h"
+#include "pixeltype.h"
+
+/**
+ * The timing of WS28xxMulti: the 8 ports share one SPI DMA transfer,
+ * each byte holds one bit for each port.
+ */
+namespace ws28xxmulti {
+namespace timing {
+static constexpr uint32_t KEEP_ALIVE_MICROS = 1000000;	///< Unchanged pixels are sent again at least once a second
+
+inline static bool is_spi_start_end_frame(const pixel::Type type) {
+	return (type == pixel::Type::APA102) || (type == pixel::Type::SK9822) || (type == pixel::Type::P9813);
+}
+
+/**
+ * The transfer can end after the last changed pixel: the pixels behind it keep their values.
+ * APA102, SK9822 and P9813 need the end frame, these are always sent in full.
+ */
+inline static bool is_truncatable(const pixel::Type type) {
+	return !is_spi_start_end_frame(type);
+}
+
+/**
+ * The DMA bytes for one pixel index
+ */
+inline static uint32_t get_pixel_bytes(const pixel::Type type) {
+	if ((type == pixel::Type::SK6812W) || is_spi_start_end_frame(type)) {
+		return pixel::single::RGBW;
+	}
+
+	return pixel::single::RGB;
+}
+
+/**
+ * @param nPixels The pixels sent, the same for all ports
+ * @return The bytes of the DMA transfer, including the trailing reset byte
+ */
+inline static uint32_t get_transfer_bytes(const pixel::Type type, const uint32_t nPixels) {
+	if (is_spi_start_end_frame(type)) {
+		return 1U + ((2U + nPixels) * get_pixel_bytes(type));
+	}
+
+	return 1U + (nPixels * get_pixel_bytes(type));
+}
+
+/**
+ * @param pixelConfiguration Validated
+ */
+inline static uint32_t get_spi_speed_hz(const PixelConfiguration& pixelConfiguration, const bool hasCPLD) {
+	if (pixelConfiguration.IsRTZProtocol()) {
+		return pixelConfiguration.GetClockSpeedHz();
+	}
+
+	return pixelConfiguration.GetClockSpeedHz() * (hasCPLD ? 6 : 4);
+}
+
+inline static uint32_t get_transfer_micros(const uint32_t nBytes, const uint32_t nSpeedHz) {
+	return static_cast<uint32_t>((static_cast<uint64_t>(nBytes) * 8U * 1000000U) / nSpeedHz);
+}
+}  // namespace timing
+}  // namespace ws28xxmulti
+
+#endif /* WS28XXMULTITIMING_H_ */
@@ -53,6 +53,8 @@ WS28xx::WS28xx(PixelConfiguration& pixelConfiguration): m_PixelConfiguration(pix
 	m_PixelConfiguration.Validate(nLedsPerPixel);
 	m_PixelConfiguration.Dump();
 
+	m_PixelColour.Setup(m_PixelConfiguration);
+
 	const auto nCount = m_PixelConfiguration.GetCount();
 
 	m_nBufSize = nCount * nLedsPerPixel;
@@ -84,7 +86,8 @@ WS28xx::WS28xx(PixelConfiguration& pixelConfiguration): m_PixelConfiguration(pix
 
 WS28xx::~WS28xx() {
 #if defined( USE_SPI_DMA )
-	m_pBlackoutBuffer = nullptr;
+	m_pDmaBuffer[0] = nullptr;
+	m_pDmaBuffer[1] = nullptr;
 	m_pBuffer = nullptr;
 #else
 	if (m_pBlackoutBuffer != nullptr) {
@@ -107,13 +110,15 @@ void WS28xx::SetupBuffers() {
 #if defined( USE_SPI_DMA )
 	uint32_t nSize;
 
-	m_pBuffer = const_cast<uint8_t*>(FUNC_PREFIX (spi_dma_tx_prepare(&nSize)));
-	assert(m_pBuffer != nullptr);
+	m_pDmaBuffer[0] = const_cast<uint8_t*>(FUNC_PREFIX (spi_dma_tx_prepare(&nSize)));
+	assert(m_pDmaBuffer[0] != nullptr);
 
 	const auto nSizeHalf = nSize / 2;
 	assert(m_nBufSize <= nSizeHalf);
 
-	m_pBlackoutBuffer = m_pBuffer + (nSizeHalf & static_cast<uint32_t>(~3));
+	m_pDmaBuffer[1] = m_pDmaBuffer[0] + (nSizeHalf & static_cast<uint32_t>(~3));
+	m_nBack = 0;
+	m_pBuffer = m_pDmaBuffer[0];
 #else
 	assert(m_pBuffer == nullptr);
 	m_pBuffer = new uint8_t[m_nBufSize];
@@ -124,7 +129,11 @@ void WS28xx::SetupBuffers() {
 	assert(m_pBlackoutBuffer != nullptr);
 #endif
 
+#if defined( USE_SPI_DMA )
+	DEBUG_PRINTF("m_nBufSize=%u, m_pDmaBuffer={%p, %p}", m_nBufSize, m_pDmaBuffer[0], m_pDmaBuffer[1]);
+#else
 	DEBUG_PRINTF("m_nBufSize=%u, m_pBuffer=%p, m_pBlackoutBuffer=%p", m_nBufSize, m_pBuffer, m_pBlackoutBuffer);
+#endif
 
 	const auto type = m_PixelConfiguration.GetType();
 	const auto nCount = m_PixelConfiguration.GetCount();
@@ -143,18 +152,67 @@ void WS28xx::SetupBuffers() {
 		}
 	} else {
 		m_pBuffer[0] = 0x00;
-		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0 : m_PixelConfiguration.GetLowCode(), m_nBufSize);
+		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0 : m_PixelConfiguration.GetLowCode(), m_nBufSize - 1);
 	}
 
+#if defined( USE_SPI_DMA )
+	memcpy(m_pDmaBuffer[1], m_pDmaBuffer[0], m_nBufSize);
+#else
 	memcpy(m_pBlackoutBuffer, m_pBuffer, m_nBufSize);
+#endif
 
 	DEBUG_EXIT
 }
 
+#if defined( USE_SPI_DMA )
+/**
+ * The back buffer becomes the front buffer, the new back buffer continues with the frame sent.
+ */
+void WS28xx::Start() {
+	auto *pFront = m_pBuffer;
+
+	FUNC_PREFIX(spi_dma_tx_start(pFront, m_nBufSize));
+
+	m_nBack ^= 1;
+	m_pBuffer = m_pDmaBuffer[m_nBack];
+
+	memcpy(m_pBuffer, pFront, m_nBufSize);
+}
+
+/**
+ * Waits for the transfer to complete, a pending frame is discarded.
+ */
+void WS28xx::WaitUpdated() {
+	do {
+# if defined (__arm__)
+		asm volatile ("isb" ::: "memory");
+# endif
+	} while (FUNC_PREFIX(spi_dma_tx_is_active()));
+
+	if (m_bUpdatePending) {
+		m_bUpdatePending = false;
+		m_nFramesDropped++;
+	}
+}
+#endif
+
 void WS28xx::Update() {
 #if defined( USE_SPI_DMA )
-	assert(!IsUpdating());
-	FUNC_PREFIX(spi_dma_tx_start(m_pBuffer, m_nBufSize));
+	if (IsUpdating()) {
+		if (m_bUpdatePending) {
+			m_nFramesCoalesced++;
+		}
+		m_bUpdatePending = true;
+		return;
+	}
+
+	// The pending frame is sent with this frame
+	if (m_bUpdatePending) {
+		m_bUpdatePending = false;
+		m_nFramesCoalesced++;
+	}
+
+	Start();
 #else
 	FUNC_PREFIX(spi_writenb(reinterpret_cast<char *>(m_pBuffer), m_nBufSize));
 #endif
@@ -163,15 +221,15 @@ void WS28xx::Update() {
 void WS28xx::Blackout() {
 	DEBUG_ENTRY
 
-#if defined( USE_SPI_DMA )
-	// Can be called any time.
-	do {
-		asm volatile ("isb" ::: "memory");
-	} while (FUNC_PREFIX(spi_dma_tx_is_active()));
-#endif
-
 	auto *pBuffer = m_pBuffer;
+
+#if defined( USE_SPI_DMA )
+	// Can be called any time. The front buffer is free, the back buffer is kept.
+	WaitUpdated();
+	m_pBuffer = m_pDmaBuffer[m_nBack ^ 1];
+#else
 	m_pBuffer = m_pBlackoutBuffer;
+#endif
 
 	const auto type = m_PixelConfiguration.GetType();
 	const auto nCount = m_PixelConfiguration.GetCount();
@@ -190,16 +248,15 @@ void WS28xx::Blackout() {
 		}
 	} else {
 		m_pBuffer[0] = 0x00;
-		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0 : m_PixelConfiguration.GetLowCode(), m_nBufSize);
+		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0 : m_PixelConfiguration.GetLowCode(), m_nBufSize - 1);
 	}
 
-	Update();
-
 #if defined( USE_SPI_DMA )
+	FUNC_PREFIX(spi_dma_tx_start(m_pBuffer, m_nBufSize));
 	// A blackout may not be interrupted.
-	do {
-		asm volatile ("isb" ::: "memory");
-	} while (FUNC_PREFIX(spi_dma_tx_is_active()));
+	WaitUpdated();
+#else
+	Update();
 #endif
 
 	m_pBuffer = pBuffer;
@@ -212,9 +269,7 @@ void WS28xx::FullOn() {
 
 #if defined( USE_SPI_DMA )
 	// Can be called any time.
-	do {
-		asm volatile ("isb" ::: "memory");
-	} while (FUNC_PREFIX(spi_dma_tx_is_active()));
+	WaitUpdated();
 #endif
 
 	const auto type = m_PixelConfiguration.GetType();
@@ -234,16 +289,14 @@ void WS28xx::FullOn() {
 		}
 	} else {
 		m_pBuffer[0] = 0x00;
-		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0xFF : m_PixelConfiguration.GetHighCode(), m_nBufSize);
+		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0xFF : m_PixelConfiguration.GetHighCode(), m_nBufSize - 1);
 	}
 
 	Update();
 
 #if defined( USE_SPI_DMA )
 	// May not be interrupted.
-	do {
-		asm volatile ("isb" ::: "memory");
-	} while (FUNC_PREFIX(spi_dma_tx_is_active()));
+	WaitUpdated();
 #endif
 
 	DEBUG_EXIT
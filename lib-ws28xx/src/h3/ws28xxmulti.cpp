@@ -32,12 +32,16 @@
 
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
+#include <array>
+#include <utility>
 #include <cstdio>
 #include <cassert>
 
 #include "ws28xxmulti.h"
 #include "pixelconfiguration.h"
 #include "pixeltype.h"
+#include "ws28xxmultitiming.h"
 
 #include "hal_gpio.h"
 #include "hal_spi.h"
@@ -80,21 +84,28 @@ WS28xxMulti::WS28xxMulti(PixelConfiguration& pixelConfiguration): m_PixelConfigu
 
 	SetupHC595(ReverseBits(nLowCode), ReverseBits(nHighCode));
 
-	if (m_PixelConfiguration.IsRTZProtocol()) {
-		SetupSPI(m_PixelConfiguration.GetClockSpeedHz());
-	} else {
-		if (m_hasCPLD) {
-			SetupSPI(m_PixelConfiguration.GetClockSpeedHz() * 6);
-		} else {
-			SetupSPI(m_PixelConfiguration.GetClockSpeedHz() * 4);
-		}
-	}
+	const auto nSpeedHz = ws28xxmulti::timing::get_spi_speed_hz(m_PixelConfiguration, m_hasCPLD);
+
+	SetupSPI(nSpeedHz);
 
 	m_nBufSize++;
 
+	assert(m_nBufSize == ws28xxmulti::timing::get_transfer_bytes(type, nCount));
+
+	m_bIsTruncatable = ws28xxmulti::timing::is_truncatable(type);
+	m_nPixels = ws28xxmulti::timing::is_spi_start_end_frame(type) ? (2U + nCount) : nCount;
+
+	const auto nRefreshRateMax = m_PixelConfiguration.GetRefreshRateMax();
+
+	if (nRefreshRateMax != 0) {
+		m_nFrameMicrosMin = 1000000U / nRefreshRateMax;
+	}
+
 	SetupBuffers();
+	SetDirtyAll();
 
 	printf("Board: %s\n", m_hasCPLD ? "CPLD" : "74-logic");
+	printf("Frame: %u us\n", ws28xxmulti::timing::get_transfer_micros(m_nBufSize, nSpeedHz));
 }
 
 WS28xxMulti::~WS28xxMulti() {
@@ -218,66 +229,84 @@ uint8_t WS28xxMulti::ReverseBits(uint8_t nBits) {
 	return static_cast<uint8_t>((output >> 24));
 }
 
-#define BIT_SET(a,b) 	((a) |= static_cast<uint8_t>((1<<(b))))
-#define BIT_CLEAR(a,b) 	((a) &= static_cast<uint8_t>(~(1<<(b))))
+/**
+ * @return Not zero when the bit has changed
+ */
+static inline uint32_t set_port_bit(uint8_t& nByte, const uint8_t nPortMask, const bool isSet) {
+	const auto nPrevious = nByte;
+	nByte = isSet ? static_cast<uint8_t>(nPrevious | nPortMask) : static_cast<uint8_t>(nPrevious & ~nPortMask);
+	return nPrevious ^ nByte;
+}
+
+/*
+ * The 8 bytes of a colour byte in the buffer, for port 0: byte j holds bit (7 - j) of the colour
+ */
+static constexpr uint64_t bit_slice(uint32_t nColour) {
+	uint64_t nSlice = 0;
+
+	for (uint32_t j = 0; j < 8; j++) {
+		nSlice |= static_cast<uint64_t>((nColour >> (7 - j)) & 0x1) << (8 * j);
+	}
+
+	return nSlice;
+}
+
+template<uint32_t... N>
+static constexpr auto make_bit_slices(std::integer_sequence<uint32_t, N...>) {
+	return std::array<uint64_t, sizeof...(N)>{ { bit_slice(N)... } };
+}
+
+static constexpr auto s_BitSlices = make_bit_slices(std::make_integer_sequence<uint32_t, 256>{});
+
+/**
+ * Writes the 8 bytes of a colour byte for one port. pBuffer is 8 bytes aligned.
+ * @return Not zero when a bit has changed
+ */
+static inline uint64_t set_port_bits(uint8_t *pBuffer, const uint32_t nPortIndex, const uint8_t nColour) {
+	auto *pSlice = reinterpret_cast<uint64_t *>(pBuffer);
+	const auto nPrevious = *pSlice;
+	*pSlice = (nPrevious & ~(UINT64_C(0x0101010101010101) << nPortIndex)) | (s_BitSlices[nColour] << nPortIndex);
+	return nPrevious ^ *pSlice;
+}
 
 void WS28xxMulti::SetColour(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nColour1, uint8_t nColour2, uint8_t nColour3) {
 	uint32_t j = 0;
 	const uint32_t k = nPixelIndex * pixel::single::RGB;
+	const auto nPortMask = static_cast<uint8_t>(1U << nPortIndex);
+	uint32_t nChanged = 0;
 
 	for (uint8_t mask = 0x80; mask != 0; mask = static_cast<uint8_t>(mask >> 1)) {
-		if (mask & nColour1) {
-			BIT_SET(m_pBuffer[k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[k + j], nPortIndex);
-		}
-		if (mask & nColour2) {
-			BIT_SET(m_pBuffer[8 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[8 + k + j], nPortIndex);
-		}
-		if (mask & nColour3) {
-			BIT_SET(m_pBuffer[16 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[16 + k + j], nPortIndex);
-		}
+		nChanged |= set_port_bit(m_pBuffer[k + j], nPortMask, mask & nColour1);
+		nChanged |= set_port_bit(m_pBuffer[8 + k + j], nPortMask, mask & nColour2);
+		nChanged |= set_port_bit(m_pBuffer[16 + k + j], nPortMask, mask & nColour3);
 
 		j++;
 	}
+
+	if (nChanged != 0) {
+		SetDirty(nPortIndex, nPixelIndex);
+	}
 }
 
 void WS28xxMulti::SetPixel4Bytes(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite) {
 	const auto k = nPixelIndex * pixel::single::RGBW;
+	const auto nPortMask = static_cast<uint8_t>(1U << nPortIndex);
+	uint32_t nChanged = 0;
 	uint32_t j = 0;
 
 	for (uint8_t mask = 0x80; mask != 0; mask = static_cast<uint8_t>(mask >> 1)) {
 		// GRBW
-		if (mask & nGreen) {
-			BIT_SET(m_pBuffer[k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[k + j], nPortIndex);
-		}
-
-		if (mask & nRed) {
-			BIT_SET(m_pBuffer[8 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[8 + k + j], nPortIndex);
-		}
-
-		if (mask & nBlue) {
-			BIT_SET(m_pBuffer[16 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[16 + k + j], nPortIndex);
-		}
-
-		if (mask & nWhite) {
-			BIT_SET(m_pBuffer[24 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[24 + k + j], nPortIndex);
-		}
+		nChanged |= set_port_bit(m_pBuffer[k + j], nPortMask, mask & nGreen);
+		nChanged |= set_port_bit(m_pBuffer[8 + k + j], nPortMask, mask & nRed);
+		nChanged |= set_port_bit(m_pBuffer[16 + k + j], nPortMask, mask & nBlue);
+		nChanged |= set_port_bit(m_pBuffer[24 + k + j], nPortMask, mask & nWhite);
 
 		j++;
 	}
+
+	if (nChanged != 0) {
+		SetDirty(nPortIndex, nPixelIndex);
+	}
 }
 
 void WS28xxMulti::SetPixel(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue) {
@@ -317,36 +346,64 @@ void WS28xxMulti::SetPixel(uint32_t nPortIndex, uint32_t nPixelIndex, uint8_t nR
 	nBlue = pGammaTable[nBlue];
 	nWhite = pGammaTable[nWhite];
 
-	const auto k = nPixelIndex * pixel::single::RGBW;
-	uint32_t j = 0;
+	SetPixel4Bytes(nPortIndex, nPixelIndex, nRed, nGreen, nBlue, nWhite);
+}
 
-	for (uint8_t mask = 0x80; mask != 0; mask = static_cast<uint8_t>(mask >> 1)) {
-		// GRBW
-		if (mask & nGreen) {
-			BIT_SET(m_pBuffer[k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[k + j], nPortIndex);
+void WS28xxMulti::SetPixels(uint32_t nPortIndex, uint32_t nPixelIndex, const uint8_t *pFrame, uint32_t nCount) {
+	assert(nPixelIndex + nCount <= m_PixelConfiguration.GetCount());
+
+	const auto type = m_PixelConfiguration.GetType();
+	uint32_t nDirtyPixels = 0;
+
+	/*
+	 * The pixel run is written directly in the buffer, 8 bytes per colour byte
+	 */
+
+	if (type == Type::SK6812W) {
+		const auto pGammaTable = m_PixelConfiguration.GetGammaTable();
+		auto *pBuffer = &m_pBuffer[nPixelIndex * pixel::single::RGBW];
+
+		for (uint32_t i = 0; i < nCount; i++, pFrame += 4, pBuffer += pixel::single::RGBW) {
+			// GRBW
+			auto nChanged = set_port_bits(&pBuffer[0], nPortIndex, pGammaTable[pFrame[1]]);
+			nChanged |= set_port_bits(&pBuffer[8], nPortIndex, pGammaTable[pFrame[0]]);
+			nChanged |= set_port_bits(&pBuffer[16], nPortIndex, pGammaTable[pFrame[2]]);
+			nChanged |= set_port_bits(&pBuffer[24], nPortIndex, pGammaTable[pFrame[3]]);
+
+			if (nChanged != 0) {
+				nDirtyPixels = nPixelIndex + i + 1;
+			}
 		}
 
-		if (mask & nRed) {
-			BIT_SET(m_pBuffer[8 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[8 + k + j], nPortIndex);
+		if (nDirtyPixels != 0) {
+			SetDirty(nPortIndex, nDirtyPixels - 1);
 		}
+		return;
+	}
+
+	if ((m_PixelConfiguration.IsRTZProtocol()) || (type == Type::WS2801)) {
+		auto *pBuffer = &m_pBuffer[nPixelIndex * pixel::single::RGB];
+
+		for (uint32_t i = 0; i < nCount; i++, pFrame += 3, pBuffer += pixel::single::RGB) {
+			auto nChanged = set_port_bits(&pBuffer[0], nPortIndex, pFrame[0]);
+			nChanged |= set_port_bits(&pBuffer[8], nPortIndex, pFrame[1]);
+			nChanged |= set_port_bits(&pBuffer[16], nPortIndex, pFrame[2]);
 
-		if (mask & nBlue) {
-			BIT_SET(m_pBuffer[16 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[16 + k + j], nPortIndex);
+			if (nChanged != 0) {
+				nDirtyPixels = nPixelIndex + i + 1;
+			}
 		}
 
-		if (mask & nWhite) {
-			BIT_SET(m_pBuffer[24 + k + j], nPortIndex);
-		} else {
-			BIT_CLEAR(m_pBuffer[24 + k + j], nPortIndex);
+		if (nDirtyPixels != 0) {
+			SetDirty(nPortIndex, nDirtyPixels - 1);
 		}
+		return;
+	}
 
-		j++;
+	// APA102, SK9822 and P9813, a start frame and a brightness or flag byte per pixel
+
+	for (uint32_t i = 0; i < nCount; i++, pFrame += 3) {
+		SetPixel(nPortIndex, nPixelIndex + i, pFrame[0], pFrame[1], pFrame[2]);
 	}
 }
 
@@ -368,11 +425,54 @@ inline void memcpy64(void *dest, void const *src, size_t n) {
 }
 
 void WS28xxMulti::Update() {
+	if (m_nFrameMicrosMin != 0) {
+		if (FUNC_PREFIX(spi_dma_tx_is_active()) || ((H3_TIMER->AVS_CNT1 - m_nStartMicros) < m_nFrameMicrosMin)) {
+			m_bUpdatePending = true;
+			m_nFramesDeferred++;
+			return;
+		}
+
+		m_bUpdatePending = false;
+	}
+
+	Start();
+}
+
+void WS28xxMulti::Start() {
 	assert(!FUNC_PREFIX(spi_dma_tx_is_active()));
 
-	memcpy64(m_pDmaBuffer, reinterpret_cast<void *>(H3_SRAM_A1_BASE + 4096), m_nBufSize);
+	const auto nMicros = H3_TIMER->AVS_CNT1;
+	uint32_t nPixels = 0;
+
+	for (auto& nDirtyPixels : m_nDirtyPixels) {
+		nPixels = std::max(nPixels, nDirtyPixels);
+		nDirtyPixels = 0;
+	}
+
+	// The pixels are refreshed at least once a second, also when nothing has changed
+	const auto isKeepAlive = ((nMicros - m_nFullMicros) >= ws28xxmulti::timing::KEEP_ALIVE_MICROS);
+
+	if ((nPixels == 0) && !isKeepAlive) {
+		m_nFramesSkipped++;
+		return;
+	}
+
+	auto nLength = m_nBufSize;
+
+	if (m_bIsTruncatable && !isKeepAlive) {
+		nLength = ws28xxmulti::timing::get_transfer_bytes(m_PixelConfiguration.GetType(), nPixels);
+	}
 
-	FUNC_PREFIX(spi_dma_tx_start(m_pDmaBuffer, m_nBufSize));
+	if (nLength == m_nBufSize) {
+		m_nFullMicros = nMicros;
+	}
+
+	memcpy64(m_pDmaBuffer, m_pBuffer, nLength - 1);
+	m_pDmaBuffer[nLength - 1] = 0;	// Reset
+
+	m_nStartMicros = nMicros;
+
+	FUNC_PREFIX(spi_dma_tx_start(m_pDmaBuffer, nLength));
 }
 
 void WS28xxMulti::Blackout() {
@@ -385,6 +485,10 @@ void WS28xxMulti::Blackout() {
 
 	FUNC_PREFIX(spi_dma_tx_start(m_pDmaBufferBlackout, m_nBufSize));
 
+	// A pending frame would end the blackout. The next update sends all pixels.
+	m_bUpdatePending = false;
+	SetDirtyAll();
+
 	// A blackout may not be interrupted.
 	do {
 		asm volatile ("isb" ::: "memory");
@@ -423,7 +527,9 @@ void WS28xxMulti::FullOn() {
 		memset(m_pBuffer, 0xFF, m_nBufSize);
 	}
 
-	Update();
+	m_bUpdatePending = false;
+	SetDirtyAll();
+	Start();
 
 	// May not be interrupted.
 	do {
@@ -0,0 +1,197 @@
+/**
+ * @file ws28xx.cpp
+ *
+ */
+/* Copyright (C) 2023 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#if !defined(__clang__)	// Needed for compiling on MacOS
+# pragma GCC push_options
+# pragma GCC optimize ("O3")
+# pragma GCC optimize ("-funroll-loops")
+# pragma GCC optimize ("-fprefetch-loop-arrays")
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#include "ws28xx.h"
+#include "pixelconfiguration.h"
+
+#include "hal_spi.h"
+
+#include "debug.h"
+
+WS28xx *WS28xx::s_pThis;
+
+WS28xx::WS28xx(PixelConfiguration& pixelConfiguration): m_PixelConfiguration(pixelConfiguration) {
+	DEBUG_ENTRY
+
+	assert(s_pThis == nullptr);
+	s_pThis = this;
+
+	uint32_t nLedsPerPixel;
+	m_PixelConfiguration.Validate(nLedsPerPixel);
+	m_PixelConfiguration.Dump();
+
+	m_PixelColour.Setup(m_PixelConfiguration);
+
+	const auto nCount = m_PixelConfiguration.GetCount();
+
+	m_nBufSize = nCount * nLedsPerPixel;
+
+	if (m_PixelConfiguration.IsRTZProtocol()) {
+		m_nBufSize *= 8;
+		m_nBufSize += 1;
+	}
+
+	const auto type = m_PixelConfiguration.GetType();
+
+	if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822) || (type == pixel::Type::P9813)) {
+		m_nBufSize += nCount;
+		m_nBufSize += 8;
+	}
+
+	SetupBuffers();
+
+	FUNC_PREFIX(spi_begin());
+	FUNC_PREFIX(spi_set_speed_hz(m_PixelConfiguration.GetClockSpeedHz()));
+
+	DEBUG_EXIT
+}
+
+WS28xx::~WS28xx() {
+	if (m_pBlackoutBuffer != nullptr) {
+		delete [] m_pBlackoutBuffer;
+		m_pBlackoutBuffer = nullptr;
+	}
+
+	if (m_pBuffer != nullptr) {
+		delete [] m_pBuffer;
+		m_pBuffer = nullptr;
+	}
+
+	s_pThis = nullptr;
+}
+
+void WS28xx::SetupBuffers() {
+	DEBUG_ENTRY
+
+	assert(m_pBuffer == nullptr);
+	m_pBuffer = new uint8_t[m_nBufSize];
+	assert(m_pBuffer != nullptr);
+
+	assert(m_pBlackoutBuffer == nullptr);
+	m_pBlackoutBuffer = new uint8_t[m_nBufSize];
+	assert(m_pBlackoutBuffer != nullptr);
+
+	DEBUG_PRINTF("m_nBufSize=%u, m_pBuffer=%p, m_pBlackoutBuffer=%p", m_nBufSize, m_pBuffer, m_pBlackoutBuffer);
+
+	const auto type = m_PixelConfiguration.GetType();
+	const auto nCount = m_PixelConfiguration.GetCount();
+
+	if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822) || (type == pixel::Type::P9813)) {
+		memset(m_pBuffer, 0, 4);
+
+		for (uint32_t nPixelIndex = 0; nPixelIndex < nCount; nPixelIndex++) {
+			SetPixel(nPixelIndex, 0, 0, 0);
+		}
+
+		if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822)) {
+			memset(&m_pBuffer[m_nBufSize - 4], 0xFF, 4);
+		} else {
+			memset(&m_pBuffer[m_nBufSize - 4], 0, 4);
+		}
+	} else {
+		m_pBuffer[0] = 0x00;
+		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0 : m_PixelConfiguration.GetLowCode(), m_nBufSize - 1);
+	}
+
+	memcpy(m_pBlackoutBuffer, m_pBuffer, m_nBufSize);
+
+	DEBUG_EXIT
+}
+
+void WS28xx::Update() {
+	FUNC_PREFIX(spi_writenb(reinterpret_cast<char *>(m_pBuffer), m_nBufSize));
+}
+
+void WS28xx::Blackout() {
+	DEBUG_ENTRY
+
+	auto *pBuffer = m_pBuffer;
+	m_pBuffer = m_pBlackoutBuffer;
+
+	const auto type = m_PixelConfiguration.GetType();
+	const auto nCount = m_PixelConfiguration.GetCount();
+
+	if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822) || (type == pixel::Type::P9813)) {
+		memset(m_pBuffer, 0, 4);
+
+		for (uint32_t nPixelIndex = 0; nPixelIndex < nCount; nPixelIndex++) {
+			SetPixel(nPixelIndex, 0, 0, 0);
+		}
+
+		if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822)) {
+			memset(&m_pBuffer[m_nBufSize - 4], 0xFF, 4);
+		} else {
+			memset(&m_pBuffer[m_nBufSize - 4], 0, 4);
+		}
+	} else {
+		m_pBuffer[0] = 0x00;
+		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0 : m_PixelConfiguration.GetLowCode(), m_nBufSize - 1);
+	}
+
+	Update();
+
+	m_pBuffer = pBuffer;
+
+	DEBUG_EXIT
+}
+
+void WS28xx::FullOn() {
+	DEBUG_ENTRY
+
+	const auto type = m_PixelConfiguration.GetType();
+	const auto nCount = m_PixelConfiguration.GetCount();
+
+	if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822) || (type == pixel::Type::P9813)) {
+		memset(m_pBuffer, 0xFF, 4);
+
+		for (uint32_t nPixelIndex = 0; nPixelIndex < nCount; nPixelIndex++) {
+			SetPixel(nPixelIndex, 0xFF, 0xFF, 0xFF);
+		}
+
+		if ((type == pixel::Type::APA102) || (type == pixel::Type::SK9822)) {
+			memset(&m_pBuffer[m_nBufSize - 4], 0xFF, 4);
+		} else {
+			memset(&m_pBuffer[m_nBufSize - 4], 0, 4);
+		}
+	} else {
+		m_pBuffer[0] = 0x00;
+		memset(&m_pBuffer[1], type == pixel::Type::WS2801 ? 0xFF : m_PixelConfiguration.GetHighCode(), m_nBufSize - 1);
+	}
+
+	Update();
+
+	DEBUG_EXIT
+}
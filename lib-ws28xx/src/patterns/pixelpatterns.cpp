@@ -26,7 +26,11 @@
  * Based on https://learn.adafruit.com/multi-tasking-the-arduino-part-3?view=all
  */
 
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <array>
+#include <utility>
 #include <cassert>
 
 #include "pixelpatterns.h"
@@ -45,6 +49,27 @@ using namespace pixelpatterns;
 
 static constexpr char s_patternName[static_cast<uint32_t>(Pattern::LAST)][14] = { "None", "Rainbow cycle", "Theater chase", "Colour wipe", "Scanner", "Fade" };
 
+static constexpr uint32_t wheel(uint8_t nWheelPos) {
+	nWheelPos = static_cast<uint8_t>(255U - nWheelPos);
+
+	if (nWheelPos < 85) {
+		return static_cast<uint32_t>((255U - nWheelPos * 3U) << 16) | static_cast<uint32_t>(nWheelPos * 3U);
+	} else if (nWheelPos < 170U) {
+		nWheelPos = static_cast<uint8_t>(nWheelPos - 85U);
+		return static_cast<uint32_t>((nWheelPos * 3U) << 8) | static_cast<uint32_t>(255U - nWheelPos * 3U);
+	}
+
+	nWheelPos = static_cast<uint8_t>(nWheelPos - 170U);
+	return static_cast<uint32_t>((nWheelPos * 3U) << 16) | static_cast<uint32_t>((255U - nWheelPos * 3U) << 8);
+}
+
+template<uint32_t... N>
+static constexpr auto make_wheel(std::integer_sequence<uint32_t, N...>) {
+	return std::array<uint32_t, sizeof...(N)>{ { wheel(static_cast<uint8_t>(N))... } };
+}
+
+static constexpr auto s_Wheel = make_wheel(std::make_integer_sequence<uint32_t, 256>{});
+
 #if defined (PIXELPATTERNS_MULTI)
 WS28xxMulti *PixelPatterns::m_pOutput;
 #else
@@ -52,8 +77,9 @@ WS28xx *PixelPatterns::m_pOutput;
 #endif
 uint32_t PixelPatterns::m_nActivePorts;
 uint32_t PixelPatterns::m_nCount;
+uint32_t PixelPatterns::m_nBytesPerPixel;
 PixelPatterns::PortConfig PixelPatterns::m_PortConfig[pixelpatterns::MAX_PORTS];
-uint32_t *PixelPatterns::m_pScannerColours;
+uint8_t *PixelPatterns::m_pFrame;
 
 PixelPatterns::PixelPatterns(uint32_t nActivePorts) {
 	DEBUG_ENTRY
@@ -68,6 +94,14 @@ PixelPatterns::PixelPatterns(uint32_t nActivePorts) {
 
 	m_nActivePorts = std::min(MAX_PORTS, nActivePorts);
 	m_nCount = m_pOutput->GetCount();
+	m_nBytesPerPixel = (m_pOutput->GetType() == pixel::Type::SK6812W) ? 4 : 3;
+
+	assert(m_pFrame == nullptr);
+	const auto nFrameSize = MAX_PORTS * m_nCount * m_nBytesPerPixel;
+	m_pFrame = new uint8_t[nFrameSize];
+	assert(m_pFrame != nullptr);
+	memset(m_pFrame, 0, nFrameSize);
+
 	const auto nMillis = Hardware::Get()->Millis();
 
 	for (uint32_t i = 0; i < MAX_PORTS; i++) {
@@ -76,9 +110,15 @@ PixelPatterns::PixelPatterns(uint32_t nActivePorts) {
 		m_PortConfig[i].Direction = Direction::FORWARD;
 	}
 
+	DEBUG_PRINTF("m_nBytesPerPixel=%u, nFrameSize=%u", m_nBytesPerPixel, nFrameSize);
 	DEBUG_EXIT
 }
 
+PixelPatterns::~PixelPatterns() {
+	delete[] m_pFrame;
+	m_pFrame = nullptr;
+}
+
 const char* PixelPatterns::GetName(Pattern pattern) {
 	if (pattern < Pattern::LAST) {
 		return s_patternName[static_cast<uint32_t>(pattern)];
@@ -88,9 +128,14 @@ const char* PixelPatterns::GetName(Pattern pattern) {
 }
 
 void PixelPatterns::Run() {
+#if defined (PIXELPATTERNS_MULTI)
 	if (m_pOutput->IsUpdating()) {
 		return;
 	}
+#else
+	// Double buffered, a frame is written while the previous one is being sent
+	m_pOutput->Run();
+#endif
 
 	auto bIsUpdated = false;
 	const auto nMillis = Hardware::Get()->Millis();
@@ -135,6 +180,25 @@ bool PixelPatterns::PortUpdate(uint32_t nPortIndex, uint32_t nMillis) {
 	return true;
 }
 
+/**
+ * Fills the port frame with one colour: the first pixel is written,
+ * then the filled part is doubled until the frame is complete.
+ */
+void PixelPatterns::ColourSet(uint32_t nPortIndex, uint32_t nColour) {
+	auto *pFrame = GetFrame(nPortIndex);
+	const auto nSize = m_nCount * m_nBytesPerPixel;
+
+	if (nSize == 0) {
+		return;
+	}
+
+	SetPixelColour(pFrame, nColour);
+
+	for (auto nFilled = m_nBytesPerPixel; nFilled < nSize; nFilled *= 2) {
+		memcpy(&pFrame[nFilled], pFrame, std::min(nFilled, nSize - nFilled));
+	}
+}
+
 void PixelPatterns::RainbowCycle(uint32_t nPortIndex, uint32_t nInterval, pixelpatterns::Direction Direction) {
 	Clear(nPortIndex);
 
@@ -145,13 +209,20 @@ void PixelPatterns::RainbowCycle(uint32_t nPortIndex, uint32_t nInterval, pixelp
 	m_PortConfig[nPortIndex].Direction = Direction;
 }
 
+/**
+ * The wheel position is a 16.16 fixed-point accumulator, which replaces the per pixel division.
+ */
 void PixelPatterns::RainbowCycleUpdate(uint32_t nPortIndex) {
-	const auto nIndex = m_PortConfig[nPortIndex].nPixelIndex;
+	const auto nStep = (256U << 16) / m_nCount;
+	auto nWheelPos = m_PortConfig[nPortIndex].nPixelIndex << 16;
+	auto *pPixel = GetFrame(nPortIndex);
 
 	for (uint32_t i = 0; i < m_nCount; i++) {
-		SetPixelColour(nPortIndex, i, Wheel(((i * 256U / m_nCount) + nIndex) & 0xFF));
+		pPixel = SetPixelColour(pPixel, s_Wheel[(nWheelPos >> 16) & 0xFF]);
+		nWheelPos += nStep;
 	}
 
+	Output(nPortIndex, 0, m_nCount);
 	Increment(nPortIndex);
 }
 
@@ -168,18 +239,20 @@ void PixelPatterns::TheaterChase(uint32_t nPortIndex, uint32_t nColour1, uint32_
 }
 
 void PixelPatterns::TheaterChaseUpdate(uint32_t nPortIndex) {
-	const auto Colour1 = m_PortConfig[nPortIndex].nColour1;
-	const auto Colour2 = m_PortConfig[nPortIndex].nColour2;
-	const auto Index = m_PortConfig[nPortIndex].nPixelIndex;
+	const auto nColour1 = m_PortConfig[nPortIndex].nColour1;
+	const auto nColour2 = m_PortConfig[nPortIndex].nColour2;
+	auto nPhase = m_PortConfig[nPortIndex].nPixelIndex % 3;
+	auto *pPixel = GetFrame(nPortIndex);
 
 	for (uint32_t i = 0; i < m_nCount; i++) {
-		if ((i + Index) % 3 == 0) {
-			SetPixelColour(nPortIndex, i, Colour1);
-		} else {
-			SetPixelColour(nPortIndex, i, Colour2);
+		pPixel = SetPixelColour(pPixel, nPhase == 0 ? nColour1 : nColour2);
+
+		if (++nPhase == 3) {
+			nPhase = 0;
 		}
 	}
 
+	Output(nPortIndex, 0, m_nCount);
 	Increment(nPortIndex);
 }
 
@@ -198,7 +271,8 @@ void PixelPatterns::ColourWipeUpdate(uint32_t nPortIndex) {
 	const auto nColour1 = m_PortConfig[nPortIndex].nColour1;
 	const auto nIndex = m_PortConfig[nPortIndex].nPixelIndex;
 
-	SetPixelColour(nPortIndex, nIndex, nColour1);
+	SetPixelColour(GetFrame(nPortIndex, nIndex), nColour1);
+	Output(nPortIndex, nIndex, 1);
 	Increment(nPortIndex);
 }
 
@@ -210,36 +284,40 @@ void PixelPatterns::Scanner(uint32_t nPortIndex, uint32_t nColour1, uint32_t nIn
 	m_PortConfig[nPortIndex].nTotalSteps= static_cast<uint16_t>((m_nCount - 1U) * 2);
     m_PortConfig[nPortIndex].nColour1 = nColour1;
     m_PortConfig[nPortIndex].nPixelIndex = 0;
-
-
-    if (m_pScannerColours == nullptr) {
-    	m_pScannerColours = new uint32_t[m_nCount];
-    	assert(m_pScannerColours != nullptr);
-    	for (uint32_t i = 0; i < m_nCount; i++) {
-    		m_pScannerColours[i] = 0;
-    	}
-    }
 }
 
+/**
+ * The trail is dimmed in the frame itself, 4 channels at a time.
+ */
 void PixelPatterns::ScannerUpdate(uint32_t nPortIndex) {
 	const auto nColour1 = m_PortConfig[nPortIndex].nColour1;
 	const auto nTotalSteps = m_PortConfig[nPortIndex].nTotalSteps;
 	const auto nIndex = m_PortConfig[nPortIndex].nPixelIndex;
 
-	for (uint32_t i = 0; i < m_nCount; i++) {
-		if (i == nIndex) {
-			SetPixelColour(nPortIndex, i, nColour1);
-			m_pScannerColours[i] = nColour1;
-		} else if (i == nTotalSteps - nIndex) {
-			SetPixelColour(nPortIndex, i, nColour1);
-			m_pScannerColours[i] = nColour1;
-		} else {
-			const auto nDimColour = DimColour(m_pScannerColours[i]);
-			SetPixelColour(nPortIndex, i, nDimColour);
-			m_pScannerColours[i] = nDimColour;
-		}
+	auto *pFrame = GetFrame(nPortIndex);
+	const auto nSize = m_nCount * m_nBytesPerPixel;
+	uint32_t i = 0;
+
+	for (; i + 4 <= nSize; i += 4) {
+		uint32_t nValue;
+		memcpy(&nValue, &pFrame[i], 4);
+		nValue = (nValue >> 1) & 0x7F7F7F7F;
+		memcpy(&pFrame[i], &nValue, 4);
+	}
+
+	for (; i < nSize; i++) {
+		pFrame[i] = static_cast<uint8_t>(pFrame[i] >> 1);
+	}
+
+	if (nIndex < m_nCount) {
+		SetPixelColour(GetFrame(nPortIndex, nIndex), nColour1);
+	}
+
+	if (nTotalSteps - nIndex < m_nCount) {
+		SetPixelColour(GetFrame(nPortIndex, nTotalSteps - nIndex), nColour1);
 	}
 
+	Output(nPortIndex, 0, m_nCount);
 	Increment(nPortIndex);
 }
 
@@ -255,34 +333,24 @@ void PixelPatterns::Fade(uint32_t nPortIndex, uint32_t nColour1, uint32_t nColou
     m_PortConfig[nPortIndex].Direction = Direction;
 }
 
+/**
+ * The interpolation weight is a 0.16 fixed-point value: one division per frame.
+ */
 void PixelPatterns::FadeUpdate(uint32_t nPortIndex) {
 	const auto nColour1 = m_PortConfig[nPortIndex].nColour1;
 	const auto nColour2 = m_PortConfig[nPortIndex].nColour2;
-	const auto nTotalSteps = m_PortConfig[nPortIndex].nTotalSteps;
-	const auto nIndex =  m_PortConfig[nPortIndex].nPixelIndex;
+	const auto nWeight2 = (m_PortConfig[nPortIndex].nPixelIndex << 16) / m_PortConfig[nPortIndex].nTotalSteps;
+	const auto nWeight1 = (1U << 16) - nWeight2;
 
-	const auto nRed = static_cast<uint8_t>(((Red(nColour1) * (nTotalSteps - nIndex)) + (Red(nColour2) * nIndex)) / nTotalSteps);
-	const auto nGreen = static_cast<uint8_t>(((Green(nColour1) * (nTotalSteps - nIndex)) + (Green(nColour2) * nIndex)) / nTotalSteps);
-	const auto nBlue = static_cast<uint8_t>(((Blue(nColour1) * (nTotalSteps - nIndex)) + (Blue(nColour2) * nIndex)) / nTotalSteps);
+	const auto nRed = static_cast<uint8_t>(((Red(nColour1) * nWeight1) + (Red(nColour2) * nWeight2)) >> 16);
+	const auto nGreen = static_cast<uint8_t>(((Green(nColour1) * nWeight1) + (Green(nColour2) * nWeight2)) >> 16);
+	const auto nBlue = static_cast<uint8_t>(((Blue(nColour1) * nWeight1) + (Blue(nColour2) * nWeight2)) >> 16);
 
 	ColourSet(nPortIndex, Colour(nRed, nGreen, nBlue));
+	Output(nPortIndex, 0, m_nCount);
 	Increment(nPortIndex);
 }
 
-uint32_t PixelPatterns::Wheel(uint8_t nWheelPos) {
-	nWheelPos = static_cast<uint8_t>(255U - nWheelPos);
-
-	if (nWheelPos < 85) {
-		return Colour(static_cast<uint8_t>(255U - nWheelPos * 3), 0, static_cast<uint8_t>(nWheelPos * 3));
-	} else if (nWheelPos < 170U) {
-		nWheelPos = static_cast<uint8_t>(nWheelPos - 85U);
-		return Colour(0, static_cast<uint8_t>(nWheelPos * 3), static_cast<uint8_t>(255U - nWheelPos * 3));
-	} else {
-		nWheelPos = static_cast<uint8_t>(nWheelPos - 170U);
-		return Colour(static_cast<uint8_t>(nWheelPos * 3), static_cast<uint8_t>(255U - nWheelPos * 3), 0);
-	}
-}
-
 void PixelPatterns::Increment(uint32_t nPortIndex) {
 	if (m_PortConfig[nPortIndex].Direction == Direction::FORWARD) {
 		m_PortConfig[nPortIndex].nPixelIndex++;
@@ -32,6 +32,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <cassert>
 
 #include "ws28xx.h"
@@ -39,6 +40,23 @@
 
 #include "gamma/gamma_tables.h"
 
+/**
+ * The 4 RTZ code bytes for each nibble, MSB first
+ */
+static void rtz_codes(uint8_t aCodes[16][4], const uint8_t nLowCode, const uint8_t nHighCode) {
+	for (uint32_t nNibble = 0; nNibble < 16; nNibble++) {
+		for (uint32_t nBit = 0; nBit < 4; nBit++) {
+			aCodes[nNibble][nBit] = (nNibble & (0x8U >> nBit)) ? nHighCode : nLowCode;
+		}
+	}
+}
+
+static inline uint8_t *rtz_encode(uint8_t *pBuffer, const uint8_t aCodes[16][4], const uint8_t nValue) {
+	memcpy(pBuffer, aCodes[nValue >> 4], 4);
+	memcpy(pBuffer + 4, aCodes[nValue & 0xF], 4);
+	return pBuffer + 8;
+}
+
 void WS28xx::SetColorWS28xx(uint32_t nOffset, uint8_t nValue) {
 	assert(m_PixelConfiguration.GetType() != pixel::Type::WS2801);
 	assert(m_pBuffer != nullptr);
@@ -64,10 +82,10 @@ void WS28xx::SetPixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_
 
 	const auto pGammaTable = m_PixelConfiguration.GetGammaTable();
 
-	nRed = pGammaTable[nRed];
-	nGreen = pGammaTable[nGreen];
-	nBlue = pGammaTable[nBlue];
+	WritePixel(nPixelIndex, pGammaTable[nRed], pGammaTable[nGreen], pGammaTable[nBlue]);
+}
 
+void WS28xx::WritePixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue) {
 	if (m_PixelConfiguration.IsRTZProtocol()) {
 		const auto nOffset = nPixelIndex * 24U;
 
@@ -128,11 +146,10 @@ void WS28xx::SetPixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_
 
 	const auto pGammaTable = m_PixelConfiguration.GetGammaTable();
 
-	nRed = pGammaTable[nRed];
-	nGreen = pGammaTable[nGreen];
-	nBlue = pGammaTable[nBlue];
-	nWhite = pGammaTable[nWhite];
+	WritePixel(nPixelIndex, pGammaTable[nRed], pGammaTable[nGreen], pGammaTable[nBlue], pGammaTable[nWhite]);
+}
 
+void WS28xx::WritePixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite) {
 	const auto nOffset = nPixelIndex * 32U;
 
 	SetColorWS28xx(nOffset, nGreen);
@@ -140,3 +157,94 @@ void WS28xx::SetPixel(uint32_t nPixelIndex, uint8_t nRed, uint8_t nGreen, uint8_
 	SetColorWS28xx(nOffset + 16, nBlue);
 	SetColorWS28xx(nOffset + 24, nWhite);
 }
+
+void WS28xx::SetPixels(uint32_t nPixelIndex, const uint8_t *pFrame, uint32_t nCount) {
+	assert(nPixelIndex + nCount <= m_PixelConfiguration.GetCount());
+	assert(m_pBuffer != nullptr);
+
+	const auto pGammaTable = m_PixelConfiguration.GetGammaTable();
+	const auto type = m_PixelConfiguration.GetType();
+
+	if (!m_PixelConfiguration.IsRTZProtocol()) {
+		for (uint32_t i = 0; i < nCount; i++, pFrame += 3) {
+			SetPixel(nPixelIndex + i, pFrame[0], pFrame[1], pFrame[2]);
+		}
+		return;
+	}
+
+	uint8_t aCodes[16][4];
+	rtz_codes(aCodes, m_PixelConfiguration.GetLowCode(), m_PixelConfiguration.GetHighCode());
+
+	if (type == pixel::Type::SK6812W) {
+		auto *pBuffer = &m_pBuffer[1 + nPixelIndex * 32U];
+
+		for (uint32_t i = 0; i < nCount; i++, pFrame += 4) {
+			pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[1]]);
+			pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[0]]);
+			pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[2]]);
+			pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[3]]);
+		}
+		return;
+	}
+
+	auto *pBuffer = &m_pBuffer[1 + nPixelIndex * 24U];
+
+	for (uint32_t i = 0; i < nCount; i++, pFrame += 3) {
+		pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[0]]);
+		pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[1]]);
+		pBuffer = rtz_encode(pBuffer, aCodes, pGammaTable[pFrame[2]]);
+	}
+}
+
+/**
+ * For each pixel::Map, the colour in each position of the pixel, as WS28xxDmx does for 8-bit input
+ */
+static constexpr uint8_t s_MapOrder[static_cast<uint32_t>(pixel::Map::UNDEFINED)][3] = {
+		{ 0, 1, 2 },	// RGB
+		{ 0, 2, 1 },	// RBG
+		{ 1, 0, 2 },	// GRB
+		{ 2, 0, 1 },	// GBR
+		{ 1, 2, 0 },	// BRG
+		{ 2, 1, 0 }		// BGR
+};
+
+void WS28xx::SetPixel16(uint32_t nPixelIndex, uint16_t nRed, uint16_t nGreen, uint16_t nBlue, uint16_t nWhite) {
+	assert(nPixelIndex < m_PixelConfiguration.GetCount());
+
+	uint16_t aColour[pixel::colour::COUNT] = { nRed, nGreen, nBlue, nWhite };
+	uint8_t aOutput[pixel::colour::COUNT];
+
+	m_PixelColour.Convert(aColour);
+
+	if (m_PixelColour.GetLedsPerPixel() == 4) {
+		m_PixelColour.Render<4>(nPixelIndex, aColour, aOutput);
+		WritePixel(nPixelIndex, aOutput[0], aOutput[1], aOutput[2], aOutput[3]);
+		return;
+	}
+
+	assert(m_PixelConfiguration.GetMap() < pixel::Map::UNDEFINED);
+	const auto *pOrder = s_MapOrder[static_cast<uint32_t>(m_PixelConfiguration.GetMap())];
+	const uint16_t aLinear[3] = { aColour[pOrder[0]], aColour[pOrder[1]], aColour[pOrder[2]] };
+
+	m_PixelColour.Render<3>(nPixelIndex, aLinear, aOutput);
+	WritePixel(nPixelIndex, aOutput[0], aOutput[1], aOutput[2]);
+}
+
+void WS28xx::Dither() {
+	assert(m_PixelColour.IsDithering());
+
+	const auto nCount = m_PixelConfiguration.GetCount();
+	uint8_t aOutput[pixel::colour::COUNT];
+
+	if (m_PixelColour.GetLedsPerPixel() == 4) {
+		for (uint32_t nPixelIndex = 0; nPixelIndex < nCount; nPixelIndex++) {
+			m_PixelColour.Render<4>(nPixelIndex, aOutput);
+			WritePixel(nPixelIndex, aOutput[0], aOutput[1], aOutput[2], aOutput[3]);
+		}
+	} else {
+		for (uint32_t nPixelIndex = 0; nPixelIndex < nCount; nPixelIndex++) {
+			m_PixelColour.Render<3>(nPixelIndex, aOutput);
+			WritePixel(nPixelIndex, aOutput[0], aOutput[1], aOutput[2]);
+		}
+	}
+}
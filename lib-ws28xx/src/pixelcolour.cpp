@@ -0,0 +1,82 @@
+/**
+ * @file pixelcolour.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cassert>
+
+#include "pixelcolour.h"
+#include "pixelconfiguration.h"
+#include "pixeltype.h"
+
+#include "debug.h"
+
+PixelColour::~PixelColour() {
+	if (m_pFrame != nullptr) {
+		delete [] m_pFrame;
+		m_pFrame = nullptr;
+	}
+
+	if (m_pResidual != nullptr) {
+		delete [] m_pResidual;
+		m_pResidual = nullptr;
+	}
+}
+
+void PixelColour::Setup(const PixelConfiguration& pixelConfiguration) {
+	DEBUG_ENTRY
+
+	m_pGammaTable = pixelConfiguration.GetGammaTable16();
+	m_nCount = pixelConfiguration.GetCount();
+	m_nLedsPerPixel = (pixelConfiguration.GetType() == pixel::Type::SK6812W) ? 4 : 3;
+	m_bWhiteExtraction = pixelConfiguration.IsEnableWhiteExtraction();
+
+	for (uint32_t nColour = 0; nColour < pixel::colour::COUNT; nColour++) {
+		const auto nGain = pixelConfiguration.GetWhiteBalance(nColour);
+		m_Gain[nColour] = (nGain == 0) ? 0 : nGain + 1U;
+	}
+
+	if (pixelConfiguration.IsEnableDithering() && (m_pFrame == nullptr)) {
+		m_pFrame = new uint16_t[m_nCount * m_nLedsPerPixel];
+		assert(m_pFrame != nullptr);
+
+		m_pResidual = new uint8_t[m_nCount * m_nLedsPerPixel];
+		assert(m_pResidual != nullptr);
+
+		for (uint32_t i = 0; i < (m_nCount * m_nLedsPerPixel); i++) {
+			m_pFrame[i] = 0;
+		}
+
+		/*
+		 * A different start residual for each LED, neighbouring
+		 * pixels with the same value do not step at the same frame.
+		 */
+		for (uint32_t i = 0; i < (m_nCount * m_nLedsPerPixel); i++) {
+			m_pResidual[i] = static_cast<uint8_t>(i * 151U);
+		}
+	}
+
+	DEBUG_PRINTF("m_nLedsPerPixel=%u, m_pFrame=%p", m_nLedsPerPixel, reinterpret_cast<void *>(m_pFrame));
+	DEBUG_EXIT
+}
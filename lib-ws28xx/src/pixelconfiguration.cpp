@@ -114,6 +114,26 @@ void PixelConfiguration::Validate(uint32_t& nLedsPerPixel) {
 		m_pGammaTable = gamma10_0;
 	}
 
+	if (m_bEnableGammaCorrection) {
+		if (m_nGammaValue == 0) {
+			m_pGammaTable16 = gamma16::get_table_default(m_type);
+		} else {
+			m_pGammaTable16 = gamma16::get_table(m_nGammaValue);
+		}
+	} else {
+		m_pGammaTable16 = gamma10_0_16;
+	}
+
+	if (m_type != Type::SK6812W) {
+		m_bEnableWhiteExtraction = false;
+	}
+
+	m_bIsColour16 = m_bEnableDithering || m_bEnableWhiteExtraction;
+
+	for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+		m_bIsColour16 |= (m_WhiteBalance[nColour] != 0xFF);
+	}
+
 	DEBUG_EXIT
 }
 
@@ -141,5 +161,14 @@ void PixelConfiguration::Print() {
 	}
 
 	printf(" Gamma correction %s\n", m_bEnableGammaCorrection ? "Yes" :  "No");
+
+	if (m_bIsColour16) {
+		printf(" Colour 16-bit : Dithering %s, White extraction %s\n", m_bEnableDithering ? "Yes" : "No", m_bEnableWhiteExtraction ? "Yes" : "No");
+		printf(" White balance : %u %u %u %u\n", m_WhiteBalance[colour::RED], m_WhiteBalance[colour::GREEN], m_WhiteBalance[colour::BLUE], m_WhiteBalance[colour::WHITE]);
+	}
 	printf(" Clock: %u Hz\n", m_nClockSpeedHz);
+
+	if (m_nRefreshRateMax != 0) {
+		printf(" Refresh rate maximum: %u Hz\n", m_nRefreshRateMax);
+	}
 }
@@ -0,0 +1,280 @@
+/**
+ * @file dither.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The 16-bit colour pipeline.
+ * - Verify: the dithering error stays within one 8-bit step for every 16-bit value,
+ *   the 16-bit gamma curves, white balance and white extraction, and WS28xxDmx
+ *   with 16-bit input (the output is captured with a mock SPI).
+ * - Benchmark: WS28xxDmx::SetData, 8-bit against the 16-bit colour pipeline, ns per frame.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include "ws28xxdmx.h"
+#include "pixeldmxconfiguration.h"
+#include "pixelcolour.h"
+#include "hal_spi.h"
+#include "configstore.h"
+
+static uint32_t s_nErrors;
+static uint8_t s_Output[8192];
+
+extern "C" {
+void spi_begin() {}
+void spi_set_speed_hz([[maybe_unused]] uint32_t nSpeedHz) {}
+void spi_writenb(const char *pBuffer, uint32_t nLength) {
+	memcpy(s_Output, pBuffer, std::min(nLength, static_cast<uint32_t>(sizeof(s_Output))));
+}
+}
+
+ConfigStore *ConfigStore::s_pThis;
+void ConfigStore::Update(__attribute__((unused)) configstore::Store store, __attribute__((unused)) uint32_t nOffset, __attribute__((unused)) const void *pData, __attribute__((unused)) uint32_t nDataLength, __attribute__((unused)) uint32_t nSetList, __attribute__((unused)) uint32_t nOffsetSetList) {}
+
+static void check(bool isOk, const char *pTest, uint32_t nValue) {
+	if (!isOk) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL %s value %u\n", pTest, nValue);
+		}
+	}
+}
+
+template<typename F>
+static double bench(F f, uint32_t nCount) {
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		f(i);
+	}
+
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) / nCount;
+}
+
+static constexpr uint32_t PIXELS = 170;
+
+/*
+ * Not <random>: <cmath> declares gamma(), that is also the namespace of the gamma tables
+ */
+static uint32_t s_nSeed = 20240601;
+
+static uint32_t rng() {
+	s_nSeed ^= s_nSeed << 13;
+	s_nSeed ^= s_nSeed >> 17;
+	s_nSeed ^= s_nSeed << 5;
+	return s_nSeed;
+}
+
+int main(int argc, char **argv) {
+	const uint32_t nFrames = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 1024;
+
+	/*
+	 * Error accumulation: after n frames the residual is n * value + start residual - 256 * sum,
+	 * it must stay in [0, 255]. Above 0xFF00 the output is 255.
+	 */
+
+	for (uint32_t nValue = 0; nValue <= 0xFFFF; nValue++) {
+		uint8_t nResidual = static_cast<uint8_t>(rng());
+		const auto nStart = static_cast<int64_t>(nResidual);
+		int64_t nSum = 0;
+		auto isOk = true;
+
+		for (uint32_t nFrame = 1; nFrame <= nFrames; nFrame++) {
+			nSum += PixelColour::Dither(static_cast<uint16_t>(nValue), nResidual);
+
+			if (nValue < 0xFF00) {
+				const auto nError = static_cast<int64_t>(nFrame) * nValue + nStart - 256 * nSum;
+				isOk &= (nError >= 0) && (nError < 256) && (nError == nResidual);
+			}
+		}
+
+		if (nValue >= 0xFF00) {
+			isOk &= (nSum >= static_cast<int64_t>(nFrames - 1) * 255);
+		}
+
+		check(isOk, "dither error", nValue);
+	}
+
+	/*
+	 * Gamma: monotonic, and the low levels that the 8-bit table crushes to 0
+	 */
+
+	static constexpr uint32_t GAMMA[] = { 10, 20, 21, 22, 23, 24, 25 };
+
+	for (const auto nGamma : GAMMA) {
+		const auto *pTable = gamma16::get_table(nGamma);
+		auto isOk = (gamma16::get_value(pTable, 0) == 0) && (gamma16::get_value(pTable, 0xFFFF) == 0xFFFF);
+
+		for (uint32_t i = 1; i <= 0xFFFF; i++) {
+			isOk &= (gamma16::get_value(pTable, static_cast<uint16_t>(i - 1)) <= gamma16::get_value(pTable, static_cast<uint16_t>(i)));
+		}
+
+		check(isOk, "gamma monotonic", nGamma);
+	}
+
+	uint32_t nCrushed8 = 0;
+	uint32_t nCrushed16 = 0;
+
+	for (uint32_t i = 1; i < 256; i++) {
+		nCrushed8 += (gamma22_0[i] == 0);
+		nCrushed16 += (gamma16::get_value(gamma22_0_16, static_cast<uint16_t>(i * 0x101)) == 0);
+	}
+
+	printf("Gamma 2.2, 8-bit DMX levels > 0 with output 0: 8-bit table %u, 16-bit %u\n", nCrushed8, nCrushed16);
+	// DMX 1 is 0.3 in 16-bit
+	check(nCrushed16 <= 1, "gamma 16-bit low levels", nCrushed16);
+
+	/*
+	 * White balance and white extraction
+	 */
+
+	{
+		PixelConfiguration pixelConfiguration;
+		pixelConfiguration.SetType(pixel::Type::SK6812W);
+		pixelConfiguration.SetEnableWhiteExtraction(true);
+		pixelConfiguration.SetWhiteBalance(pixel::colour::BLUE, 127);
+		uint32_t nLedsPerPixel;
+		pixelConfiguration.Validate(nLedsPerPixel);
+
+		PixelColour pixelColour;
+		pixelColour.Setup(pixelConfiguration);
+
+		uint16_t aColour[pixel::colour::COUNT] = { 0xFFFF, 0x8000, 0x8000, 0 };
+		pixelColour.Convert(aColour);
+
+		check(pixelConfiguration.IsColour16(), "colour 16-bit", 0);
+		check((aColour[pixel::colour::RED] == 0x7FFF) && (aColour[pixel::colour::GREEN] == 0) && (aColour[pixel::colour::BLUE] == 0) && (aColour[pixel::colour::WHITE] == 0x8000), "white extraction", aColour[pixel::colour::WHITE]);
+
+		uint16_t aBlue[pixel::colour::COUNT] = { 0, 0, 0xFFFF, 0 };
+		pixelColour.Convert(aBlue);
+		check(aBlue[pixel::colour::BLUE] == 0x7FFF, "white balance", aBlue[pixel::colour::BLUE]);
+	}
+
+	/*
+	 * WS28xxDmx, 16-bit input with dithering. WS2801 is raw RGB in the output buffer.
+	 * Without USE_SPI_DMA the dithering advances with each frame received.
+	 */
+
+	{
+		PixelDmxConfiguration pixelDmxConfiguration;
+		pixelDmxConfiguration.SetType(pixel::Type::WS2801);
+		pixelDmxConfiguration.SetMap(pixel::Map::RGB);
+		pixelDmxConfiguration.SetCount(PIXELS);
+		pixelDmxConfiguration.SetEnableInput16Bit(true);
+		pixelDmxConfiguration.SetEnableDithering(true);
+
+		auto *pPixelDmx = new WS28xxDmx(pixelDmxConfiguration);
+
+		check(pPixelDmx->GetUniverses() == 2, "universes", pPixelDmx->GetUniverses());
+		check(pPixelDmx->GetDmxFootprint() == PIXELS * 6, "footprint", pPixelDmx->GetDmxFootprint());
+
+		lightset::SlotInfo slotInfo;
+		pPixelDmx->GetSlotInfo(3, slotInfo);
+		check((slotInfo.nType == 0x01) && (slotInfo.nCategory == 2), "slot info fine", 3);
+		pPixelDmx->GetSlotInfo(4, slotInfo);
+		check((slotInfo.nType == 0x00) && (slotInfo.nCategory == 0x0207), "slot info blue", 4);
+
+		static constexpr uint16_t VALUES[] = { 0x0180, 0x0040, 0x7FC0 };	// 1.5, 0.25, 127.75
+		static constexpr uint32_t FRAMES = 256;
+		uint8_t data[lightset::dmx::UNIVERSE_SIZE];
+		uint32_t aSum[3] = { 0, 0, 0 };
+
+		for (uint32_t i = 0; (i + 6) <= sizeof(data); i += 6) {
+			for (uint32_t nColour = 0; nColour < 3; nColour++) {
+				data[i + nColour * 2] = static_cast<uint8_t>(VALUES[nColour] >> 8);
+				data[i + nColour * 2 + 1] = static_cast<uint8_t>(VALUES[nColour]);
+			}
+		}
+
+		for (uint32_t nFrame = 0; nFrame < FRAMES; nFrame++) {
+			pPixelDmx->SetData(0, data, 85 * 6, true);
+			pPixelDmx->SetData(1, data, 85 * 6, true);
+
+			for (uint32_t nColour = 0; nColour < 3; nColour++) {
+				aSum[nColour] += s_Output[(PIXELS - 1) * 3 + nColour];
+			}
+		}
+
+		for (uint32_t nColour = 0; nColour < 3; nColour++) {
+			check(aSum[nColour] == (VALUES[nColour] * FRAMES) >> 8, "WS28xxDmx 16-bit average", aSum[nColour]);
+		}
+
+		delete pPixelDmx;
+	}
+
+	/*
+	 * Benchmark, WS2812B
+	 */
+
+	puts("ns per frame (170 pixels, 1 universe)");
+
+	struct Test {
+		const char *pName;
+		bool bDithering;
+		uint8_t nWhiteBalance;
+	};
+
+	static constexpr Test TESTS[] = {
+			{ "8-bit", false, 0xFF },
+			{ "16-bit, white balance", false, 0xF0 },
+			{ "16-bit, dithering", true, 0xFF }
+	};
+
+	uint8_t data[lightset::dmx::UNIVERSE_SIZE];
+
+	for (uint32_t i = 0; i < sizeof(data); i++) {
+		data[i] = static_cast<uint8_t>(rng());
+	}
+
+	double f8Bit = 0;
+
+	for (const auto& test : TESTS) {
+		PixelDmxConfiguration pixelDmxConfiguration;
+		pixelDmxConfiguration.SetType(pixel::Type::WS2812B);
+		pixelDmxConfiguration.SetCount(PIXELS);
+		pixelDmxConfiguration.SetEnableGammaCorrection(true);
+		pixelDmxConfiguration.SetEnableDithering(test.bDithering);
+		pixelDmxConfiguration.SetWhiteBalance(pixel::colour::BLUE, test.nWhiteBalance);
+
+		auto *pPixelDmx = new WS28xxDmx(pixelDmxConfiguration);
+
+		const auto f = bench([&](uint32_t i) { data[0] = static_cast<uint8_t>(i); pPixelDmx->SetData(0, data, PIXELS * 3, true); }, 20000);
+
+		if (!test.bDithering && (test.nWhiteBalance == 0xFF)) {
+			f8Bit = f;
+		}
+
+		printf("%-24s %8.1f  x%.2f\n", test.pName, f, f8Bit / f);
+
+		delete pPixelDmx;
+	}
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
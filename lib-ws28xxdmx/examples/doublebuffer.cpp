@@ -0,0 +1,240 @@
+/**
+ * @file doublebuffer.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * WS28xxDmx with a mock SPI DMA transport, the transfer time is configurable.
+ * 680 pixels, 4 universes per frame. The universes of a frame arrive 500 us apart.
+ * - Double buffered: the universes are written while a frame is being sent.
+ * - Before: a universe is dropped when the transfer is active.
+ * Verify: no transfer is started while active, the front buffer is not written
+ * while being sent, no frame is torn, and the output ends with the last frame.
+ *
+ * Usage: doublebuffer [transfer us] [frame period us] [frames]
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "ws28xxdmx.h"
+#include "pixeldmxconfiguration.h"
+#include "hal_spi.h"
+#include "configstore.h"
+
+static constexpr uint32_t PIXELS = 680;
+static constexpr uint32_t UNIVERSES = 4;
+static constexpr uint32_t PIXELS_UNIVERSE = 170;
+static constexpr uint32_t UNIVERSE_MICROS = 500;
+static constexpr uint32_t STEP_MICROS = 50;		///< Main loop
+
+static uint32_t s_nNow;
+static uint32_t s_nTransferMicros;
+static uint32_t s_nTransferEnd;
+static uint32_t s_nErrors;
+
+alignas(4) static uint8_t s_DmaBuffer[64 * 1024];
+static const uint8_t *s_pFront;
+static uint32_t s_nFrontLength;
+static uint8_t s_Front[PIXELS * 3];
+
+struct Statistics {
+	uint32_t nTransfers;
+	uint32_t nTorn;				///< Universes of different frames
+	uint32_t nUniversesDropped;
+};
+
+static Statistics s_Statistics;
+
+/*
+ * The frame tag of a universe is its first pixel
+ */
+static uint8_t tag(uint32_t nFrame) {
+	return static_cast<uint8_t>(1 + (nFrame % 250));
+}
+
+extern "C" {
+void spi_dma_begin() {}
+void spi_dma_set_speed_hz([[maybe_unused]] uint32_t nSpeedHz) {}
+
+const uint8_t *spi_dma_tx_prepare(uint32_t *pSize) {
+	*pSize = sizeof(s_DmaBuffer);
+	return s_DmaBuffer;
+}
+
+/*
+ * A busy wait takes time
+ */
+bool spi_dma_tx_is_active() {
+	if (static_cast<int32_t>(s_nNow - s_nTransferEnd) < 0) {
+		s_nNow++;
+		return true;
+	}
+
+	return false;
+}
+
+void spi_dma_tx_start(const uint8_t *pBuffer, uint32_t nLength) {
+	if (spi_dma_tx_is_active()) {
+		s_nErrors++;
+		puts("FAIL transfer started while active");
+	}
+
+	s_pFront = pBuffer;
+	s_nFrontLength = nLength;
+	memcpy(s_Front, pBuffer, nLength);
+	s_nTransferEnd = s_nNow + s_nTransferMicros;
+
+	s_Statistics.nTransfers++;
+
+	for (uint32_t nUniverse = 1; nUniverse < UNIVERSES; nUniverse++) {
+		if (pBuffer[nUniverse * PIXELS_UNIVERSE * 3] != pBuffer[0]) {
+			s_Statistics.nTorn++;
+			break;
+		}
+	}
+}
+}
+
+/*
+ * The DMA reads the front buffer until the transfer is completed
+ */
+static void check_front() {
+	if ((static_cast<int32_t>(s_nNow - s_nTransferEnd) < 0) && (memcmp(s_pFront, s_Front, s_nFrontLength) != 0)) {
+		if (s_nErrors++ < 10) {
+			printf("FAIL front buffer written at %u us\n", s_nNow);
+		}
+	}
+}
+
+ConfigStore *ConfigStore::s_pThis;
+void ConfigStore::Update(__attribute__((unused)) configstore::Store store, __attribute__((unused)) uint32_t nOffset, __attribute__((unused)) const void *pData, __attribute__((unused)) uint32_t nDataLength, __attribute__((unused)) uint32_t nSetList, __attribute__((unused)) uint32_t nOffsetSetList) {}
+
+static void run(WS28xxDmx& pixelDmx, bool isDoubleBuffered, uint32_t nFramePeriod, uint32_t nFrames) {
+	static uint8_t data[lightset::dmx::UNIVERSE_SIZE];
+	s_Statistics = Statistics {};
+
+	const auto nCoalesced = WS28xx::Get()->GetFramesCoalesced();
+	const auto nEnd = nFrames * nFramePeriod + 2 * s_nTransferMicros;
+	uint32_t nFrame = 0;
+	uint32_t nUniverse = 0;
+	const auto nStart = s_nNow;
+
+	for (uint32_t t = 0; t < nEnd; t += STEP_MICROS) {
+		s_nNow = nStart + t;
+
+		while ((nFrame < nFrames) && (t >= (nFrame * nFramePeriod + nUniverse * UNIVERSE_MICROS))) {
+			if (isDoubleBuffered || !spi_dma_tx_is_active()) {
+				memset(data, tag(nFrame), PIXELS_UNIVERSE * 3);
+				pixelDmx.SetData(nUniverse, data, PIXELS_UNIVERSE * 3, true);
+			} else {
+				s_Statistics.nUniversesDropped++;
+			}
+
+			if (++nUniverse == UNIVERSES) {
+				nUniverse = 0;
+				nFrame++;
+			}
+		}
+
+		if (isDoubleBuffered) {
+			pixelDmx.Run();
+		}
+
+		check_front();
+	}
+
+	// The output ends with the last frame
+	auto isLastFrame = true;
+
+	for (uint32_t i = 0; i < PIXELS * 3; i++) {
+		isLastFrame &= (s_Front[i] == tag(nFrames - 1));
+	}
+
+	if (isDoubleBuffered && !isLastFrame) {
+		s_nErrors++;
+		puts("FAIL the output is not the last frame");
+	}
+
+	if (isDoubleBuffered && (s_Statistics.nTorn != 0)) {
+		s_nErrors++;
+		puts("FAIL torn frames");
+	}
+
+	printf("%-16s %9u %9u %9u %11u %9s\n", isDoubleBuffered ? "double buffered" : "before",
+			s_Statistics.nTransfers, s_Statistics.nTorn, s_Statistics.nUniversesDropped,
+			WS28xx::Get()->GetFramesCoalesced() - nCoalesced, isLastFrame ? "yes" : "no");
+}
+
+int main(int argc, char **argv) {
+	s_nTransferMicros = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 20400;	// 680 WS2812 pixels
+	const uint32_t nFramePeriod = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 16667;
+	const uint32_t nFrames = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 6000;
+
+	PixelDmxConfiguration pixelDmxConfiguration;
+	pixelDmxConfiguration.SetType(pixel::Type::WS2801);
+	pixelDmxConfiguration.SetCount(PIXELS);
+
+	WS28xxDmx pixelDmx(pixelDmxConfiguration);
+
+	printf("Transfer %u us, frame period %u us, %u frames of %u universes\n\n", s_nTransferMicros, nFramePeriod, nFrames, UNIVERSES);
+	puts("                 transfers      torn   dropped   coalesced      last");
+
+	// The old SetData: a universe is dropped while the transfer is active
+	run(pixelDmx, false, nFramePeriod, nFrames);
+	run(pixelDmx, true, nFramePeriod, nFrames);
+
+	// Blackout while a frame is being sent and pending
+	static uint8_t data[lightset::dmx::UNIVERSE_SIZE];
+	memset(data, 0x55, sizeof(data));
+
+	for (uint32_t nUniverse = 0; nUniverse < UNIVERSES; nUniverse++) {
+		pixelDmx.SetData(nUniverse, data, PIXELS_UNIVERSE * 3, true);
+	}
+
+	for (uint32_t nUniverse = 0; nUniverse < UNIVERSES; nUniverse++) {
+		data[0] = 0x66;
+		pixelDmx.SetData(nUniverse, data, PIXELS_UNIVERSE * 3, true);
+	}
+
+	const auto nDropped = WS28xx::Get()->GetFramesDropped();
+	pixelDmx.Blackout(true);
+
+	if ((s_Front[0] != 0) || (WS28xx::Get()->GetFramesDropped() != nDropped + 1)) {
+		s_nErrors++;
+		puts("FAIL blackout");
+	}
+
+	pixelDmx.Blackout(false);
+
+	if (s_Front[0] != 0x66) {
+		s_nErrors++;
+		puts("FAIL blackout off");
+	}
+
+	printf("\nVerify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
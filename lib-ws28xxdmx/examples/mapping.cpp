@@ -0,0 +1,242 @@
+/**
+ * @file mapping.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * The pixel mapping table.
+ * - Verify: the zig-zag and rotation generators, the CSV loader, and
+ *   WS28xxDmx with a layout (the output is captured with a mock SPI).
+ * - Benchmark: WS28xxDmx::SetData, mapped against linear, ns per frame.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include "ws28xxdmx.h"
+#include "pixeldmxconfiguration.h"
+#include "pixeldmxmapping.h"
+#include "hal_spi.h"
+#include "configstore.h"
+
+static uint32_t s_nErrors;
+static uint8_t s_Output[8192];
+
+extern "C" {
+void spi_begin() {}
+void spi_set_speed_hz([[maybe_unused]] uint32_t nSpeedHz) {}
+void spi_writenb(const char *pBuffer, uint32_t nLength) {
+	memcpy(s_Output, pBuffer, std::min(nLength, static_cast<uint32_t>(sizeof(s_Output))));
+}
+}
+
+ConfigStore *ConfigStore::s_pThis;
+void ConfigStore::Update(__attribute__((unused)) configstore::Store store, __attribute__((unused)) uint32_t nOffset, __attribute__((unused)) const void *pData, __attribute__((unused)) uint32_t nDataLength, __attribute__((unused)) uint32_t nSetList, __attribute__((unused)) uint32_t nOffsetSetList) {}
+
+static void check(bool isOk, const char *pTest) {
+	if (!isOk) {
+		s_nErrors++;
+		printf("FAIL %s\n", pTest);
+	}
+}
+
+static bool is_equal(const PixelDmxMapping& mapping, const uint16_t *pExpected) {
+	return memcmp(mapping.GetTable(), pExpected, mapping.GetCount() * sizeof(uint16_t)) == 0;
+}
+
+template<typename F>
+static double bench(F f, uint32_t nCount) {
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < nCount; i++) {
+		f(i);
+	}
+
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()) / nCount;
+}
+
+static constexpr uint32_t WIDTH = 34;
+static constexpr uint32_t PIXELS = 680;			///< 34 x 20, 4 universes
+static constexpr uint32_t UNIVERSES = 4;
+static constexpr uint32_t PIXELS_UNIVERSE = 170;
+
+static void send_frame(WS28xxDmx& pixelDmx, uint32_t nFrame) {
+	uint8_t data[PIXELS_UNIVERSE * 3];
+
+	for (uint32_t nUniverse = 0; nUniverse < UNIVERSES; nUniverse++) {
+		for (uint32_t i = 0; i < PIXELS_UNIVERSE; i++) {
+			const auto nPixel = nUniverse * PIXELS_UNIVERSE + i;
+			data[i * 3 + 0] = static_cast<uint8_t>(nPixel);
+			data[i * 3 + 1] = static_cast<uint8_t>(nPixel >> 8);
+			data[i * 3 + 2] = static_cast<uint8_t>(nFrame);
+		}
+
+		pixelDmx.SetData(nUniverse, data, sizeof(data), true);
+	}
+}
+
+int main(int argc, char **argv) {
+	const uint32_t nFrames = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 20000;
+
+	/*
+	 * Generators
+	 */
+
+	{
+		PixelDmxMapping mapping(12);	// 4 x 3
+
+		mapping.ZigZag(4);
+		static constexpr uint16_t ZIGZAG[] = { 0, 1, 2, 3, 7, 6, 5, 4, 8, 9, 10, 11 };
+		check(is_equal(mapping, ZIGZAG), "zigzag");
+
+		// Four times 90 degrees, the DMX data width alternates
+		for (uint32_t i = 0; i < 4; i++) {
+			mapping.Rotate((i & 1) ? 3 : 4, 90);
+		}
+		check(is_equal(mapping, ZIGZAG), "rotate 4 x 90");
+
+		mapping.Rotate(4, 90);
+		mapping.Rotate(3, 90);
+		PixelDmxMapping mapping180(12);
+		mapping180.ZigZag(4);
+		mapping180.Rotate(4, 180);
+		check(is_equal(mapping, mapping180.GetTable()), "rotate 2 x 90");
+	}
+
+	{
+		PixelDmxMapping mapping(6);		// 3 x 2
+		mapping.Rotate(3, 90);
+		static constexpr uint16_t ROTATE90[] = { 3, 0, 4, 1, 5, 2 };
+		check(is_equal(mapping, ROTATE90), "rotate 90");
+
+		mapping.Linear();
+		mapping.Rotate(3, 270);
+		static constexpr uint16_t ROTATE270[] = { 2, 5, 1, 4, 0, 3 };
+		check(is_equal(mapping, ROTATE270), "rotate 270");
+	}
+
+	/*
+	 * CSV
+	 */
+
+	{
+		PixelDmxMapping mapping(6);
+
+		static constexpr char CSV[] = "# Sculpture\n3, 2;1\r\n\t5 # end\n";
+		static constexpr uint16_t TABLE[] = { 3, 2, 1, 5, 0, 4 };
+		check(mapping.Load(CSV, sizeof(CSV) - 1) && is_equal(mapping, TABLE), "csv");
+
+		static constexpr char DUPLICATE[] = "3,2,3";
+		check(!mapping.Load(DUPLICATE, sizeof(DUPLICATE) - 1) && mapping.IsLinear(), "csv duplicate");
+
+		static constexpr char RANGE[] = "0,6";
+		check(!mapping.Load(RANGE, sizeof(RANGE) - 1) && mapping.IsLinear(), "csv range");
+
+		static constexpr char INVALID[] = "0,x";
+		check(!mapping.Load(INVALID, sizeof(INVALID) - 1) && mapping.IsLinear(), "csv invalid");
+
+		static constexpr char TOO_MANY[] = "0,1,2,3,4,5,0";
+		check(!mapping.Load(TOO_MANY, sizeof(TOO_MANY) - 1) && mapping.IsLinear(), "csv too many");
+	}
+
+	/*
+	 * WS28xxDmx, WS2801 is raw RGB in the output buffer
+	 */
+
+	{
+		PixelDmxConfiguration pixelDmxConfiguration;
+		pixelDmxConfiguration.SetType(pixel::Type::WS2801);
+		pixelDmxConfiguration.SetMap(pixel::Map::RGB);
+		pixelDmxConfiguration.SetCount(PIXELS);
+		pixelDmxConfiguration.SetLayout(pixeldmxconfiguration::Layout::ZIGZAG);
+		pixelDmxConfiguration.SetLayoutWidth(WIDTH);
+		pixelDmxConfiguration.SetLayoutRotate(90);
+
+		auto *pPixelDmx = new WS28xxDmx(pixelDmxConfiguration);
+
+		PixelDmxMapping mapping(PIXELS);
+		mapping.ZigZag(WIDTH);
+		mapping.Rotate(WIDTH, 90);
+
+		send_frame(*pPixelDmx, 1);
+
+		auto isOk = true;
+
+		for (uint32_t nPixel = 0; nPixel < PIXELS; nPixel++) {
+			const auto *pOutput = &s_Output[mapping.GetTable()[nPixel] * 3];
+			isOk &= (pOutput[0] == static_cast<uint8_t>(nPixel)) && (pOutput[1] == static_cast<uint8_t>(nPixel >> 8)) && (pOutput[2] == 1);
+		}
+
+		check(isOk, "WS28xxDmx layout");
+
+		delete pPixelDmx;
+	}
+
+	/*
+	 * Benchmark, WS2812B
+	 */
+
+	puts("ns per frame (680 pixels, 4 universes)");
+
+	struct Test {
+		const char *pName;
+		pixeldmxconfiguration::Layout layout;
+		uint16_t nRotate;
+	};
+
+	static constexpr Test TESTS[] = {
+			{ "linear", pixeldmxconfiguration::Layout::LINEAR, 0 },
+			{ "zigzag", pixeldmxconfiguration::Layout::ZIGZAG, 0 },
+			{ "zigzag, rotate 90", pixeldmxconfiguration::Layout::ZIGZAG, 90 }
+	};
+
+	double fLinear = 0;
+
+	for (const auto& test : TESTS) {
+		PixelDmxConfiguration pixelDmxConfiguration;
+		pixelDmxConfiguration.SetType(pixel::Type::WS2812B);
+		pixelDmxConfiguration.SetCount(PIXELS);
+		pixelDmxConfiguration.SetLayout(test.layout);
+		pixelDmxConfiguration.SetLayoutWidth(WIDTH);
+		pixelDmxConfiguration.SetLayoutRotate(test.nRotate);
+
+		auto *pPixelDmx = new WS28xxDmx(pixelDmxConfiguration);
+
+		const auto f = bench([&](uint32_t i) { send_frame(*pPixelDmx, i); }, nFrames);
+
+		if (test.layout == pixeldmxconfiguration::Layout::LINEAR) {
+			fLinear = f;
+		}
+
+		printf("%-20s %9.1f  %5.1f Mpixel/s  x%.2f\n", test.pName, f, PIXELS * 1000.0 / f, fLinear / f);
+
+		delete pPixelDmx;
+	}
+
+	printf("Verify: %s\n", (s_nErrors == 0) ? "PASS" : "FAIL");
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
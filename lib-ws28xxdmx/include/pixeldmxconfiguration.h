@@ -35,6 +35,10 @@ struct PortInfo {
 	uint32_t nBeginIndexPort[4];
 	uint32_t nProtocolPortIndexLast;
 };
+
+enum class Layout : uint8_t {
+	LINEAR, ZIGZAG, TABLE, UNDEFINED
+};
 }  // namespace pixeldmxconfiguration
 
 class PixelDmxConfiguration: public PixelConfiguration {
@@ -71,6 +75,41 @@ public:
 		return m_nDmxStartAddress;
 	}
 
+	void SetLayout(pixeldmxconfiguration::Layout layout) {
+		m_Layout = layout;
+	}
+
+	pixeldmxconfiguration::Layout GetLayout() const {
+		return m_Layout;
+	}
+
+	void SetLayoutWidth(uint16_t nLayoutWidth) {
+		m_nLayoutWidth = nLayoutWidth;
+	}
+
+	uint16_t GetLayoutWidth() const {
+		return m_nLayoutWidth;
+	}
+
+	void SetLayoutRotate(uint16_t nLayoutRotate) {
+		m_nLayoutRotate = nLayoutRotate;
+	}
+
+	uint16_t GetLayoutRotate() const {
+		return m_nLayoutRotate;
+	}
+
+	/**
+	 * Two DMX channels for each colour, coarse and fine
+	 */
+	void SetEnableInput16Bit(bool doEnable) {
+		m_bEnableInput16Bit = doEnable;
+	}
+
+	bool IsEnableInput16Bit() const {
+		return m_bEnableInput16Bit;
+	}
+
 	void Validate(uint32_t nPortsMax, uint32_t& nLedsPerPixel, pixeldmxconfiguration::PortInfo& portInfo);
 
 	void Print();
@@ -81,6 +120,10 @@ private:
 	uint32_t m_nGroups { pixel::defaults::COUNT };
 	uint32_t m_nUniverses;
 	uint16_t m_nDmxStartAddress { 1 };
+	uint16_t m_nLayoutWidth { 0 };
+	uint16_t m_nLayoutRotate { 0 };
+	pixeldmxconfiguration::Layout m_Layout { pixeldmxconfiguration::Layout::LINEAR };
+	bool m_bEnableInput16Bit { false };
 };
 
 #endif /* PIXELDMXCONFIGURATION_H_ */
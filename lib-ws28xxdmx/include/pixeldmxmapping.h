@@ -0,0 +1,112 @@
+/**
+ * @file pixeldmxmapping.h
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PIXELDMXMAPPING_H_
+#define PIXELDMXMAPPING_H_
+
+#include <cstdint>
+
+#include "pixeldmxconfiguration.h"
+
+namespace pixeldmxmapping {
+static constexpr char FILE_NAME[] = "pixelmap.csv";
+static constexpr char LAYOUT[static_cast<uint32_t>(pixeldmxconfiguration::Layout::UNDEFINED)][8] = { "linear", "zigzag", "table" };
+}  // namespace pixeldmxmapping
+
+/**
+ * The precompiled mapping table: pixel index in the DMX data -> pixel index on the output.
+ * The table is a permutation of the pixels of one output port.
+ *
+ * A layout is a matrix of nWidth pixels per row. The DMX data is row by row,
+ * left to right, top to bottom.
+ */
+class PixelDmxMapping {
+public:
+	PixelDmxMapping(uint32_t nCount);
+	~PixelDmxMapping();
+
+	/**
+	 * Generates the table for the layout of the configuration.
+	 * @return false when the table is linear, then it is not needed.
+	 */
+	bool Setup(const PixelDmxConfiguration& pixelDmxConfiguration);
+
+	void Linear();
+
+	/**
+	 * Serpentine wiring: the even rows are left to right, the odd rows are right to left.
+	 */
+	void ZigZag(uint32_t nWidth);
+
+	/**
+	 * The DMX data is rotated clockwise in steps of 90 degrees.
+	 * With 90 and 270 degrees, the width of the DMX data is the height of the layout.
+	 */
+	void Rotate(uint32_t nWidth, uint32_t nDegrees);
+
+	/**
+	 * The output pixel index for each pixel of the DMX data, in DMX order.
+	 * The numbers are separated by a comma, a semicolon, white space or a new line.
+	 * A '#' is a comment until the end of the line.
+	 * The pixels that are not in the list follow in output order.
+	 * @return false on an invalid or a duplicate index, then the table is linear.
+	 */
+	bool Load(const char *pBuffer, uint32_t nLength);
+#if !defined(DISABLE_FS)
+	bool Read(const char *pFileName);
+#endif
+
+	bool IsLinear() const;
+
+	const uint16_t *GetTable() const {
+		return m_pTable;
+	}
+
+	uint32_t GetCount() const {
+		return m_nCount;
+	}
+
+	void Print();
+
+	static const char *GetLayout(pixeldmxconfiguration::Layout layout);
+	static pixeldmxconfiguration::Layout GetLayout(const char *pString);
+
+private:
+	void ParseBegin();
+	bool Parse(const char c);
+	bool ParseEnd();
+
+private:
+	uint32_t m_nCount;
+	uint16_t *m_pTable;
+	uint16_t *m_pScratch;
+	uint32_t m_nEntries { 0 };
+	uint32_t m_nValue { 0 };
+	bool m_bIsValue { false };
+	bool m_bIsComment { false };
+	bool m_bIsError { false };
+};
+
+#endif /* PIXELDMXMAPPING_H_ */
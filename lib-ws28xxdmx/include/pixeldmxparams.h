@@ -53,6 +53,11 @@ struct Params {
 	uint8_t nLowCode;										///< 1	  21
 	uint8_t nHighCode;										///< 1	  22
 	uint16_t nStartUniverse[pixeldmxparams::MAX_PORTS];		///< 16   38
+	uint8_t nLayout;										///< 1	  39
+	uint16_t nLayoutWidth;									///< 2	  41
+	uint16_t nLayoutRotate;									///< 2	  43
+	uint8_t nWhiteBalance[pixel::colour::COUNT];			///< 4	  47
+	uint8_t nRefreshRateMax;								///< 1	  48
 }__attribute__((packed));
 
 static_assert(sizeof(struct Params) <= 64, "struct Params is too large");
@@ -71,7 +76,17 @@ struct Mask {
 	static constexpr auto LOW_CODE = (1U << 10);
 	static constexpr auto HIGH_CODE = (1U << 11);
 	static constexpr auto START_UNI_PORT_1 = (1U << 12);
+	static constexpr auto LAYOUT = (1U << 20);
+	static constexpr auto LAYOUT_WIDTH = (1U << 21);
+	static constexpr auto LAYOUT_ROTATE = (1U << 22);
+	static constexpr auto INPUT_16BIT = (1U << 23);
+	static constexpr auto DITHERING = (1U << 24);
+	static constexpr auto WHITE_EXTRACTION = (1U << 25);
+	static constexpr auto WHITE_BALANCE_RED = (1U << 26);	///< .. WHITE_BALANCE_WHITE (1U << 29), in pixel::colour order
+	static constexpr auto REFRESH_RATE_MAX = (1U << 30);
 };
+
+static_assert((Mask::START_UNI_PORT_1 << MAX_PORTS) <= Mask::LAYOUT, "Mask::START_UNI_PORT overlaps Mask::LAYOUT");
 }  // pixeldmxparams
 
 class PixelDmxParamsStore {
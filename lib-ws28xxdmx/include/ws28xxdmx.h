@@ -34,6 +34,7 @@
 #include "ws28xx.h"
 
 #include "pixeldmxconfiguration.h"
+#include "pixeldmxmapping.h"
 #include "pixelpatterns.h"
 
 class WS28xxDmx final: public LightSet {
@@ -50,6 +51,7 @@ public:
 		if (__builtin_expect((!doForce), 1)) {
 			assert(m_pWS28xx != nullptr);
 			m_pWS28xx->Update();
+			m_bIsFrameComplete = true;
 		}
 	}
 
@@ -63,8 +65,26 @@ public:
 	void Blackout(bool bBlackout) override;
 	void FullOn() override;
 
+	/**
+	 * Starts the pending frame, call from the main loop.
+	 * With dithering, each completed transfer is followed by the next dithering step of the last complete frame.
+	 */
+	void Run() {
+		m_pWS28xx->Run();
+#if defined (USE_SPI_DMA)
+		if (m_bIsDithering && m_bIsFrameComplete && !m_bBlackout && !m_pWS28xx->IsUpdating()) {
+			m_pWS28xx->Dither();
+			m_pWS28xx->Update();
+		}
+#endif
+	}
+
 	void Print() override {
 		m_pixelDmxConfiguration.Print();
+
+		if (m_pMapping != nullptr) {
+			m_pMapping->Print();
+		}
 	}
 
 	pixel::Type GetType() const {
@@ -108,6 +128,19 @@ public:
 		return s_pThis;
 	}
 
+private:
+	/**
+	 * The pixel index on the output, for a pixel index in the DMX data
+	 */
+	uint32_t PixelIndex(const uint32_t nPixelIndex) const {
+		if (__builtin_expect((m_pMap == nullptr), 1)) {
+			return nPixelIndex;
+		}
+		return m_pMap[nPixelIndex];
+	}
+
+	void SetPixels16(const uint8_t *pData, uint32_t nLength, uint32_t d, uint32_t beginIndex, uint32_t endIndex);
+
 private:
 	PixelDmxConfiguration m_pixelDmxConfiguration;
 	pixeldmxconfiguration::PortInfo m_PortInfo;
@@ -117,9 +150,14 @@ private:
 	uint16_t m_nDmxFootprint;
 
 	WS28xx *m_pWS28xx { nullptr };
+	PixelDmxMapping *m_pMapping { nullptr };
+	const uint16_t *m_pMap { nullptr };
 
 	bool m_bIsStarted { false };
 	bool m_bBlackout { false };
+	bool m_bIsColour16 { false };
+	bool m_bIsDithering { false };
+	bool m_bIsFrameComplete { false };		///< All universes of the frame are in the output, none since
 
 	static WS28xxDmx *s_pThis;
 };
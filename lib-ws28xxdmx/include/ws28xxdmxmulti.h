@@ -35,6 +35,7 @@
 #include "ws28xxmulti.h"
 
 #include "pixeldmxconfiguration.h"
+#include "pixeldmxmapping.h"
 #include "pixelpatterns.h"
 
 #include "logic_analyzer.h"
@@ -125,8 +126,21 @@ public:
 	void Blackout(bool bBlackout) override;
 	void FullOn() override;
 
+	/**
+	 * Sends a frame held back by the maximum refresh rate, when no next frame is being written
+	 */
+	void Run() {
+#if defined (H3)
+		m_pWS28xxMulti->Run();
+#endif
+	}
+
 	void Print() override {
 		m_pixelDmxConfiguration.Print();
+
+		if (m_pMapping != nullptr) {
+			m_pMapping->Print();
+		}
 	}
 
 	pixel::Type GetType() const {
@@ -176,6 +190,15 @@ public:
 
 private:
 	void SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLength);
+	/**
+	 * The pixel index on the output, for a pixel index in the DMX data
+	 */
+	uint32_t PixelIndex(const uint32_t nPixelIndex) const {
+		if (__builtin_expect((m_pMap == nullptr), 1)) {
+			return nPixelIndex;
+		}
+		return m_pMap[nPixelIndex];
+	}
 
 private:
 	PixelDmxConfiguration m_pixelDmxConfiguration;
@@ -183,6 +206,8 @@ private:
 	uint32_t m_nChannelsPerPixel;
 
 	WS28xxMulti *m_pWS28xxMulti { nullptr };
+	PixelDmxMapping *m_pMapping { nullptr };
+	const uint16_t *m_pMap { nullptr };
 
 	uint32_t m_bIsStarted { 0 };
 	bool m_bBlackout { false };
@@ -38,6 +38,7 @@
 #include "lightset.h"
 
 #include "pixeldmxconfiguration.h"
+#include "pixeldmxmapping.h"
 #include "pixeldmxstore.h"
 
 #if defined (PIXELDMXSTARTSTOP_GPIO)
@@ -61,6 +62,20 @@ WS28xxDmx::WS28xxDmx(PixelDmxConfiguration& pixelDmxConfiguration): m_pixelDmxCo
 
 	m_nDmxStartAddress = m_pixelDmxConfiguration.GetDmxStartAddress();
 	m_nDmxFootprint = static_cast<uint16_t>(m_nChannelsPerPixel * m_pixelDmxConfiguration.GetGroups());
+	m_bIsColour16 = m_pixelDmxConfiguration.IsColour16() || m_pixelDmxConfiguration.IsEnableInput16Bit();
+	m_bIsDithering = m_pWS28xx->IsDithering();
+
+	if ((m_pixelDmxConfiguration.GetLayout() != pixeldmxconfiguration::Layout::LINEAR) || (m_pixelDmxConfiguration.GetLayoutRotate() != 0)) {
+		m_pMapping = new PixelDmxMapping(m_pixelDmxConfiguration.GetCount());
+		assert(m_pMapping != nullptr);
+
+		if (m_pMapping->Setup(m_pixelDmxConfiguration)) {
+			m_pMap = m_pMapping->GetTable();
+		} else {
+			delete m_pMapping;
+			m_pMapping = nullptr;
+		}
+	}
 
 #if defined (PIXELDMXSTARTSTOP_GPIO)
 	FUNC_PREFIX(gpio_fsel(PIXELDMXSTARTSTOP_GPIO, GPIO_FSEL_OUTPUT));
@@ -75,6 +90,10 @@ WS28xxDmx::WS28xxDmx(PixelDmxConfiguration& pixelDmxConfiguration): m_pixelDmxCo
 WS28xxDmx::~WS28xxDmx() {
 	DEBUG_ENTRY
 
+	delete m_pMapping;
+	m_pMapping = nullptr;
+	m_pMap = nullptr;
+
 	delete m_pWS28xx;
 	m_pWS28xx = nullptr;
 
@@ -109,9 +128,8 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 	assert(pData != nullptr);
 	assert(nLength <= lightset::dmx::UNIVERSE_SIZE);
 
-	if (m_pWS28xx->IsUpdating()) {
-		return;
-	}
+	// A pending frame is started or replaced before a next universe is written in the back buffer
+	m_pWS28xx->FrameBegin();
 
 	uint32_t d = 0;
 
@@ -124,15 +142,19 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 		d = static_cast<uint32_t>(m_pixelDmxConfiguration.GetDmxStartAddress() - 1);
 	}
 
+	m_bIsFrameComplete = false;
+
 	const auto nGroupingCount = m_pixelDmxConfiguration.GetGroupingCount();
 
-	if (m_nChannelsPerPixel == 3) {
+	if (m_bIsColour16) {
+		SetPixels16(pData, nLength, d, beginIndex, endIndex);
+	} else if (m_nChannelsPerPixel == 3) {
 		switch (m_pixelDmxConfiguration.GetMap()) {
 		case pixel::Map::RGB:
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d + 0], pData[d + 1], pData[d + 2]);
+					m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d + 0], pData[d + 1], pData[d + 2]);
 				}
 				d = d + 3;
 			}
@@ -141,7 +163,7 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d + 0], pData[d + 2], pData[d + 1]);
+					m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d + 0], pData[d + 2], pData[d + 1]);
 				}
 				d = d + 3;
 			}
@@ -150,7 +172,7 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d + 1], pData[d + 0], pData[d + 2]);
+					m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d + 1], pData[d + 0], pData[d + 2]);
 				}
 				d = d + 3;
 			}
@@ -159,7 +181,7 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d + 2], pData[d + 0], pData[d + 1]);
+					m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d + 2], pData[d + 0], pData[d + 1]);
 				}
 				d = d + 3;
 			}
@@ -168,7 +190,7 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d + 1], pData[d + 2], pData[d + 0]);
+					m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d + 1], pData[d + 2], pData[d + 0]);
 				}
 				d = d + 3;
 			}
@@ -177,7 +199,7 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d + 2], pData[d + 1], pData[d + 0]);
+					m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d + 2], pData[d + 1], pData[d + 0]);
 				}
 				d = d + 3;
 			}
@@ -192,7 +214,7 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 		for (auto j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 			auto const nPixelIndexStart = (j * nGroupingCount);
 			for (uint32_t k = 0; k < nGroupingCount; k++) {
-				m_pWS28xx->SetPixel(nPixelIndexStart + k, pData[d], pData[d + 1], pData[d + 2], pData[d + 3]);
+				m_pWS28xx->SetPixel(PixelIndex(nPixelIndexStart + k), pData[d], pData[d + 1], pData[d + 2], pData[d + 3]);
 			}
 			d = d + 4;
 		}
@@ -203,28 +225,63 @@ void WS28xxDmx::SetData(uint32_t nPortIndex, const uint8_t *pData, uint32_t nLen
 			return;
 		}
 		m_pWS28xx->Update();
+		m_bIsFrameComplete = true;
 	}
 }
 
-void WS28xxDmx::Blackout(bool bBlackout) {
-	m_bBlackout = bBlackout;
+void WS28xxDmx::SetPixels16(const uint8_t *pData, uint32_t nLength, uint32_t d, uint32_t beginIndex, uint32_t endIndex) {
+	const auto nGroupingCount = m_pixelDmxConfiguration.GetGroupingCount();
+
+	if (m_pixelDmxConfiguration.IsEnableInput16Bit()) {
+		const auto nColours = m_nChannelsPerPixel / 2;
+
+		for (auto j = beginIndex; (j < endIndex) && (d < nLength); j++) {
+			uint16_t aColour[pixel::colour::COUNT] = { 0, 0, 0, 0 };
+
+			for (uint32_t nColour = 0; nColour < nColours; nColour++) {
+				aColour[nColour] = static_cast<uint16_t>((pData[d] << 8) | pData[d + 1]);
+				d = d + 2;
+			}
+
+			auto const nPixelIndexStart = (j * nGroupingCount);
+			for (uint32_t k = 0; k < nGroupingCount; k++) {
+				m_pWS28xx->SetPixel16(PixelIndex(nPixelIndexStart + k), aColour[0], aColour[1], aColour[2], aColour[3]);
+			}
+		}
 
-	while (m_pWS28xx->IsUpdating()) {
-		// wait for completion
+		return;
+	}
+
+	const auto nColours = m_nChannelsPerPixel;
+
+	for (auto j = beginIndex; (j < endIndex) && (d < nLength); j++) {
+		uint16_t aColour[pixel::colour::COUNT] = { 0, 0, 0, 0 };
+
+		for (uint32_t nColour = 0; nColour < nColours; nColour++) {
+			aColour[nColour] = static_cast<uint16_t>(pData[d] * 0x101);
+			d = d + 1;
+		}
+
+		auto const nPixelIndexStart = (j * nGroupingCount);
+		for (uint32_t k = 0; k < nGroupingCount; k++) {
+			m_pWS28xx->SetPixel16(PixelIndex(nPixelIndexStart + k), aColour[0], aColour[1], aColour[2], aColour[3]);
+		}
 	}
+}
+
+void WS28xxDmx::Blackout(bool bBlackout) {
+	m_bBlackout = bBlackout;
 
 	if (bBlackout) {
 		m_pWS28xx->Blackout();
 	} else {
 		m_pWS28xx->Update();
+		m_bIsFrameComplete = true;
 	}
 }
 
 void WS28xxDmx::FullOn() {
-	while (m_pWS28xx->IsUpdating()) {
-		// wait for completion
-	}
-
+	m_bIsFrameComplete = false;
 	m_pWS28xx->FullOn();
 }
 
@@ -257,9 +314,21 @@ bool WS28xxDmx::GetSlotInfo(uint16_t nSlotOffset, lightset::SlotInfo& slotInfo)
 		return false;
 	}
 
+	auto nColour = nSlotOffset % m_nChannelsPerPixel;
+
+	if (m_pixelDmxConfiguration.IsEnableInput16Bit()) {
+		if (nColour & 0x1) {
+			slotInfo.nType = 0x01;	// ST_SEC_FINE
+			slotInfo.nCategory = static_cast<uint16_t>(nSlotOffset - 1);	// The primary slot
+			return true;
+		}
+
+		nColour = nColour / 2;
+	}
+
 	slotInfo.nType = 0x00;	// ST_PRIMARY
 
-	switch (nSlotOffset % m_nChannelsPerPixel) {
+	switch (nColour) {
 		case 0:
 			slotInfo.nCategory = 0x0205; // SD_COLOR_ADD_RED
 			break;
@@ -38,6 +38,7 @@
 
 #include "pixeldmxparams.h"
 #include "pixeldmxconfiguration.h"
+#include "pixeldmxmapping.h"
 
 #if defined (PIXELDMXSTARTSTOP_GPIO)
 # include "hal_gpio.h"
@@ -55,6 +56,18 @@ WS28xxDmxMulti::WS28xxDmxMulti(PixelDmxConfiguration& pixelDmxConfiguration): m_
 	m_pWS28xxMulti = new WS28xxMulti(pixelDmxConfiguration);
 	assert(m_pWS28xxMulti != nullptr);
 
+	if ((m_pixelDmxConfiguration.GetLayout() != pixeldmxconfiguration::Layout::LINEAR) || (m_pixelDmxConfiguration.GetLayoutRotate() != 0)) {
+		m_pMapping = new PixelDmxMapping(m_pixelDmxConfiguration.GetCount());
+		assert(m_pMapping != nullptr);
+
+		if (m_pMapping->Setup(m_pixelDmxConfiguration)) {
+			m_pMap = m_pMapping->GetTable();
+		} else {
+			delete m_pMapping;
+			m_pMapping = nullptr;
+		}
+	}
+
 #if defined (PIXELDMXSTARTSTOP_GPIO)
 	FUNC_PREFIX(gpio_fsel(PIXELDMXSTARTSTOP_GPIO, GPIO_FSEL_OUTPUT));
 	FUNC_PREFIX(gpio_clr(PIXELDMXSTARTSTOP_GPIO));
@@ -66,6 +79,10 @@ WS28xxDmxMulti::WS28xxDmxMulti(PixelDmxConfiguration& pixelDmxConfiguration): m_
 }
 
 WS28xxDmxMulti::~WS28xxDmxMulti() {
+	delete m_pMapping;
+	m_pMapping = nullptr;
+	m_pMap = nullptr;
+
 	delete m_pWS28xxMulti;
 	m_pWS28xxMulti = nullptr;
 }
@@ -109,6 +126,11 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 	const auto nSwitch = nPortIndex - (nOutIndex * nUniverses);
 #endif
 
+#if defined (H3)
+	// A pending frame is started or replaced before a next universe is written in the buffer
+	m_pWS28xxMulti->FrameBegin();
+#endif
+
 	const auto nGroups = m_pixelDmxConfiguration.GetGroups();
 	const auto beginIndex = m_PortInfo.nBeginIndexPort[nSwitch];
 	const auto endIndex = std::min(nGroups, (beginIndex + (nLength / m_nChannelsPerPixel)));
@@ -123,7 +145,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d + 0], pData[d + 1], pData[d + 2]);
+					m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d + 0], pData[d + 1], pData[d + 2]);
 				}
 				d = d + 3;
 			}
@@ -132,7 +154,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d + 0], pData[d + 2], pData[d + 1]);
+					m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d + 0], pData[d + 2], pData[d + 1]);
 				}
 				d = d + 3;
 			}
@@ -141,7 +163,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d + 1], pData[d + 0], pData[d + 2]);
+					m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d + 1], pData[d + 0], pData[d + 2]);
 				}
 				d = d + 3;
 			}
@@ -150,7 +172,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d + 2], pData[d + 0], pData[d + 1]);
+					m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d + 2], pData[d + 0], pData[d + 1]);
 				}
 				d = d + 3;
 			}
@@ -159,7 +181,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d + 1], pData[d + 2], pData[d + 0]);
+					m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d + 1], pData[d + 2], pData[d + 0]);
 				}
 				d = d + 3;
 			}
@@ -168,7 +190,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 			for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 				auto const nPixelIndexStart = (j * nGroupingCount);
 				for (uint32_t k = 0; k < nGroupingCount; k++) {
-					m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d + 2], pData[d + 1], pData[d + 0]);
+					m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d + 2], pData[d + 1], pData[d + 0]);
 				}
 				d = d + 3;
 			}
@@ -183,7 +205,7 @@ void WS28xxDmxMulti::SetData(uint32_t nPortIndex, const uint8_t* pData, uint32_t
 		for (uint32_t j = beginIndex; (j < endIndex) && (d < nLength); j++) {
 			auto const nPixelIndexStart = (j * nGroupingCount);
 			for (uint32_t k = 0; k < nGroupingCount; k++) {
-				m_pWS28xxMulti->SetPixel(nOutIndex, nPixelIndexStart + k, pData[d], pData[d + 1], pData[d + 2], pData[d + 3]);
+				m_pWS28xxMulti->SetPixel(nOutIndex, PixelIndex(nPixelIndexStart + k), pData[d], pData[d + 1], pData[d + 2], pData[d + 3]);
 			}
 			d = d + 4;
 		}
@@ -34,6 +34,7 @@
 #include <cassert>
 
 #include "pixeldmxparams.h"
+#include "pixeldmxmapping.h"
 #include "pixeltype.h"
 #include "pixelpatterns.h"
 #include "pixelconfiguration.h"
@@ -54,6 +55,13 @@
 using namespace pixel;
 using namespace lightset;
 
+static constexpr const char *WHITE_BALANCE[colour::COUNT] = {
+		DevicesParamsConst::WHITE_BALANCE_RED,
+		DevicesParamsConst::WHITE_BALANCE_GREEN,
+		DevicesParamsConst::WHITE_BALANCE_BLUE,
+		DevicesParamsConst::WHITE_BALANCE_WHITE
+};
+
 PixelDmxParams::PixelDmxParams() {
 	m_Params.nSetList = 0;
 	m_Params.nType = static_cast<uint8_t>(pixel::defaults::TYPE);
@@ -68,6 +76,15 @@ PixelDmxParams::PixelDmxParams() {
 	m_Params.nHighCode = 0;
 	m_Params.nGammaValue = 0;
 	m_Params.nTestPattern = 0;
+	m_Params.nLayout = static_cast<uint8_t>(pixeldmxconfiguration::Layout::LINEAR);
+	m_Params.nLayoutWidth = 0;
+	m_Params.nLayoutRotate = 0;
+
+	for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+		m_Params.nWhiteBalance[nColour] = 0xFF;
+	}
+
+	m_Params.nRefreshRateMax = 0;
 
 	for (uint32_t nPortIndex = 0; nPortIndex < pixeldmxparams::MAX_PORTS; nPortIndex++) {
 		m_Params.nStartUniverse[nPortIndex] = static_cast<uint16_t>(1 + (nPortIndex * 4));
@@ -198,6 +215,43 @@ void PixelDmxParams::callbackFunction(const char *pLine) {
 		return;
 	}
 
+	nLength = 6;
+	if (Sscan::Char(pLine, DevicesParamsConst::LAYOUT, cBuffer, nLength) == Sscan::OK) {
+		cBuffer[nLength] = '\0';
+		const auto layout = PixelDmxMapping::GetLayout(cBuffer);
+
+		if ((layout != pixeldmxconfiguration::Layout::UNDEFINED) && (layout != pixeldmxconfiguration::Layout::LINEAR)) {
+			m_Params.nLayout = static_cast<uint8_t>(layout);
+			m_Params.nSetList |= pixeldmxparams::Mask::LAYOUT;
+		} else {
+			m_Params.nLayout = static_cast<uint8_t>(pixeldmxconfiguration::Layout::LINEAR);
+			m_Params.nSetList &= ~pixeldmxparams::Mask::LAYOUT;
+		}
+		return;
+	}
+
+	if (Sscan::Uint16(pLine, DevicesParamsConst::LAYOUT_WIDTH, nValue16) == Sscan::OK) {
+		if (nValue16 > 1 && nValue16 <= std::max(max::ledcount::RGB, max::ledcount::RGBW)) {
+			m_Params.nLayoutWidth = nValue16;
+			m_Params.nSetList |= pixeldmxparams::Mask::LAYOUT_WIDTH;
+		} else {
+			m_Params.nLayoutWidth = 0;
+			m_Params.nSetList &= ~pixeldmxparams::Mask::LAYOUT_WIDTH;
+		}
+		return;
+	}
+
+	if (Sscan::Uint16(pLine, DevicesParamsConst::LAYOUT_ROTATE, nValue16) == Sscan::OK) {
+		if ((nValue16 == 90) || (nValue16 == 180) || (nValue16 == 270)) {
+			m_Params.nLayoutRotate = nValue16;
+			m_Params.nSetList |= pixeldmxparams::Mask::LAYOUT_ROTATE;
+		} else {
+			m_Params.nLayoutRotate = 0;
+			m_Params.nSetList &= ~pixeldmxparams::Mask::LAYOUT_ROTATE;
+		}
+		return;
+	}
+
 	uint32_t nValue32;
 
 	if (Sscan::Uint32(pLine, DevicesParamsConst::SPI_SPEED_HZ, nValue32) == Sscan::OK) {
@@ -257,6 +311,17 @@ void PixelDmxParams::callbackFunction(const char *pLine) {
 		}
 		return;
 	}
+
+	if (Sscan::Uint8(pLine, DevicesParamsConst::REFRESH_RATE_MAX, nValue8) == Sscan::OK) {
+		m_Params.nRefreshRateMax = nValue8;
+
+		if (nValue8 != 0) {
+			m_Params.nSetList |= pixeldmxparams::Mask::REFRESH_RATE_MAX;
+		} else {
+			m_Params.nSetList &= ~pixeldmxparams::Mask::REFRESH_RATE_MAX;
+		}
+		return;
+	}
 #endif
 
 	if (Sscan::Uint8(pLine, DevicesParamsConst::TEST_PATTERN, nValue8) == Sscan::OK) {
@@ -286,6 +351,47 @@ void PixelDmxParams::callbackFunction(const char *pLine) {
 		} else {
 			m_Params.nGammaValue = nValue;
 		}
+		return;
+	}
+
+	if (Sscan::Uint8(pLine, DevicesParamsConst::INPUT_16BIT, nValue8) == Sscan::OK) {
+		if (nValue8 != 0) {
+			m_Params.nSetList |= pixeldmxparams::Mask::INPUT_16BIT;
+		} else {
+			m_Params.nSetList &= ~pixeldmxparams::Mask::INPUT_16BIT;
+		}
+		return;
+	}
+
+	if (Sscan::Uint8(pLine, DevicesParamsConst::DITHERING, nValue8) == Sscan::OK) {
+		if (nValue8 != 0) {
+			m_Params.nSetList |= pixeldmxparams::Mask::DITHERING;
+		} else {
+			m_Params.nSetList &= ~pixeldmxparams::Mask::DITHERING;
+		}
+		return;
+	}
+
+	if (Sscan::Uint8(pLine, DevicesParamsConst::WHITE_EXTRACTION, nValue8) == Sscan::OK) {
+		if (nValue8 != 0) {
+			m_Params.nSetList |= pixeldmxparams::Mask::WHITE_EXTRACTION;
+		} else {
+			m_Params.nSetList &= ~pixeldmxparams::Mask::WHITE_EXTRACTION;
+		}
+		return;
+	}
+
+	for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+		if (Sscan::Uint8(pLine, WHITE_BALANCE[nColour], nValue8) == Sscan::OK) {
+			if (nValue8 != 0xFF) {
+				m_Params.nWhiteBalance[nColour] = nValue8;
+				m_Params.nSetList |= (pixeldmxparams::Mask::WHITE_BALANCE_RED << nColour);
+			} else {
+				m_Params.nWhiteBalance[nColour] = 0xFF;
+				m_Params.nSetList &= ~(pixeldmxparams::Mask::WHITE_BALANCE_RED << nColour);
+			}
+			return;
+		}
 	}
 }
 
@@ -338,6 +444,22 @@ void PixelDmxParams::Builder(const struct pixeldmxparams::Params *ptWS28xxParams
 	builder.AddComment("Grouping");
 	builder.Add(DevicesParamsConst::GROUPING_COUNT, m_Params.nGroupingCount, isMaskSet(pixeldmxparams::Mask::GROUPING_COUNT));
 
+	builder.AddComment("Layout: linear, zigzag or table (pixelmap.csv)");
+	builder.Add(DevicesParamsConst::LAYOUT, PixelDmxMapping::GetLayout(static_cast<pixeldmxconfiguration::Layout>(m_Params.nLayout)), isMaskSet(pixeldmxparams::Mask::LAYOUT));
+	builder.Add(DevicesParamsConst::LAYOUT_WIDTH, m_Params.nLayoutWidth, isMaskSet(pixeldmxparams::Mask::LAYOUT_WIDTH));
+	builder.Add(DevicesParamsConst::LAYOUT_ROTATE, m_Params.nLayoutRotate, isMaskSet(pixeldmxparams::Mask::LAYOUT_ROTATE));
+
+#if defined (PARAMS_INLCUDE_ALL) || !defined(OUTPUT_DMX_PIXEL_MULTI)
+	builder.AddComment("Colour: 16-bit input (coarse, fine), dithering, RGB to RGBW, white balance (255 is 1.0)");
+	builder.Add(DevicesParamsConst::INPUT_16BIT, isMaskSet(pixeldmxparams::Mask::INPUT_16BIT));
+	builder.Add(DevicesParamsConst::DITHERING, isMaskSet(pixeldmxparams::Mask::DITHERING));
+	builder.Add(DevicesParamsConst::WHITE_EXTRACTION, isMaskSet(pixeldmxparams::Mask::WHITE_EXTRACTION));
+
+	for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+		builder.Add(WHITE_BALANCE[nColour], m_Params.nWhiteBalance[nColour], isMaskSet(pixeldmxparams::Mask::WHITE_BALANCE_RED << nColour));
+	}
+#endif
+
 	builder.AddComment("Clock based chips");
 	builder.Add(DevicesParamsConst::SPI_SPEED_HZ, m_Params.nSpiSpeedHz, isMaskSet(pixeldmxparams::Mask::SPI_SPEED));
 
@@ -354,6 +476,7 @@ void PixelDmxParams::Builder(const struct pixeldmxparams::Params *ptWS28xxParams
 	}
 #if defined (PARAMS_INLCUDE_ALL) || defined(OUTPUT_DMX_PIXEL_MULTI)
 	builder.Add(DevicesParamsConst::ACTIVE_OUT, m_Params.nActiveOutputs, isMaskSet(pixeldmxparams::Mask::ACTIVE_OUT));
+	builder.Add(DevicesParamsConst::REFRESH_RATE_MAX, m_Params.nRefreshRateMax, isMaskSet(pixeldmxparams::Mask::REFRESH_RATE_MAX));
 #endif
 
 	builder.AddComment("Test pattern");
@@ -404,6 +527,26 @@ void PixelDmxParams::Set(PixelDmxConfiguration *pPixelDmxConfiguration) {
 		}
 	}
 
+	// Colour
+
+	if (isMaskSet(pixeldmxparams::Mask::INPUT_16BIT)) {
+		pPixelDmxConfiguration->SetEnableInput16Bit(true);
+	}
+
+	if (isMaskSet(pixeldmxparams::Mask::DITHERING)) {
+		pPixelDmxConfiguration->SetEnableDithering(true);
+	}
+
+	if (isMaskSet(pixeldmxparams::Mask::WHITE_EXTRACTION)) {
+		pPixelDmxConfiguration->SetEnableWhiteExtraction(true);
+	}
+
+	for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+		if (isMaskSet(pixeldmxparams::Mask::WHITE_BALANCE_RED << nColour)) {
+			pPixelDmxConfiguration->SetWhiteBalance(nColour, m_Params.nWhiteBalance[nColour]);
+		}
+	}
+
 	// Dmx
 
 	if (isMaskSet(pixeldmxparams::Mask::DMX_START_ADDRESS)) {
@@ -414,10 +557,28 @@ void PixelDmxParams::Set(PixelDmxConfiguration *pPixelDmxConfiguration) {
 		pPixelDmxConfiguration->SetGroupingCount(m_Params.nGroupingCount);
 	}
 
+	// Layout
+
+	if (isMaskSet(pixeldmxparams::Mask::LAYOUT)) {
+		pPixelDmxConfiguration->SetLayout(static_cast<pixeldmxconfiguration::Layout>(m_Params.nLayout));
+	}
+
+	if (isMaskSet(pixeldmxparams::Mask::LAYOUT_WIDTH)) {
+		pPixelDmxConfiguration->SetLayoutWidth(m_Params.nLayoutWidth);
+	}
+
+	if (isMaskSet(pixeldmxparams::Mask::LAYOUT_ROTATE)) {
+		pPixelDmxConfiguration->SetLayoutRotate(m_Params.nLayoutRotate);
+	}
+
 #if defined (PARAMS_INLCUDE_ALL) || defined(OUTPUT_DMX_PIXEL_MULTI)
 	if (isMaskSet(pixeldmxparams::Mask::ACTIVE_OUT)) {
 		pPixelDmxConfiguration->SetOutputPorts(m_Params.nActiveOutputs);
 	}
+
+	if (isMaskSet(pixeldmxparams::Mask::REFRESH_RATE_MAX)) {
+		pPixelDmxConfiguration->SetRefreshRateMax(m_Params.nRefreshRateMax);
+	}
 #endif
 }
 
@@ -441,11 +602,22 @@ void PixelDmxParams::Dump() {
 	}
 
 	printf(" %s=%d\n", DevicesParamsConst::ACTIVE_OUT, m_Params.nActiveOutputs);
+	printf(" %s=%d\n", DevicesParamsConst::REFRESH_RATE_MAX, m_Params.nRefreshRateMax);
 	printf(" %s=%d\n", DevicesParamsConst::GROUPING_COUNT, m_Params.nGroupingCount);
+	printf(" %s=%s [%d]\n", DevicesParamsConst::LAYOUT, PixelDmxMapping::GetLayout(static_cast<pixeldmxconfiguration::Layout>(m_Params.nLayout)), m_Params.nLayout);
+	printf(" %s=%d\n", DevicesParamsConst::LAYOUT_WIDTH, m_Params.nLayoutWidth);
+	printf(" %s=%d\n", DevicesParamsConst::LAYOUT_ROTATE, m_Params.nLayoutRotate);
 	printf(" %s=%d\n", DevicesParamsConst::SPI_SPEED_HZ, m_Params.nSpiSpeedHz);
 	printf(" %s=%d\n", DevicesParamsConst::GLOBAL_BRIGHTNESS, m_Params.nGlobalBrightness);
 	printf(" %s=%d\n", LightSetParamsConst::DMX_START_ADDRESS, m_Params.nDmxStartAddress);
 	printf(" %s=%d\n", DevicesParamsConst::TEST_PATTERN, m_Params.nTestPattern);
 	printf(" %s=%d\n", DevicesParamsConst::GAMMA_CORRECTION, isMaskSet(pixeldmxparams::Mask::GAMMA_CORRECTION));
 	printf(" %s=%1.1f [%u]\n", DevicesParamsConst::GAMMA_VALUE, static_cast<float>(m_Params.nGammaValue) / 10, m_Params.nGammaValue);
+	printf(" %s=%d\n", DevicesParamsConst::INPUT_16BIT, isMaskSet(pixeldmxparams::Mask::INPUT_16BIT));
+	printf(" %s=%d\n", DevicesParamsConst::DITHERING, isMaskSet(pixeldmxparams::Mask::DITHERING));
+	printf(" %s=%d\n", DevicesParamsConst::WHITE_EXTRACTION, isMaskSet(pixeldmxparams::Mask::WHITE_EXTRACTION));
+
+	for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+		printf(" %s=%u\n", WHITE_BALANCE[nColour], m_Params.nWhiteBalance[nColour]);
+	}
 }
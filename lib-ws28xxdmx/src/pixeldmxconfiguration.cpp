@@ -33,6 +33,9 @@
 #include <cassert>
 
 #include "pixeldmxconfiguration.h"
+#include "pixeldmxmapping.h"
+
+#include "lightset.h"
 
 #include "debug.h"
 
@@ -45,6 +48,17 @@ using namespace pixel;
 void PixelDmxConfiguration::Validate(uint32_t nPortsMax, uint32_t& nLedsPerPixel, pixeldmxconfiguration::PortInfo& portInfo) {
 	DEBUG_ENTRY
 
+	// The 16-bit colour pipeline is for a single output
+	if (nPortsMax > 1) {
+		m_bEnableInput16Bit = false;
+		SetEnableDithering(false);
+		SetEnableWhiteExtraction(false);
+
+		for (uint32_t nColour = 0; nColour < colour::COUNT; nColour++) {
+			SetWhiteBalance(nColour, 0xFF);
+		}
+	}
+
 	PixelConfiguration::Validate(nLedsPerPixel);
 
 	if (!IsRTZProtocol()) {
@@ -56,16 +70,28 @@ void PixelDmxConfiguration::Validate(uint32_t nPortsMax, uint32_t& nLedsPerPixel
 		PixelConfiguration::Validate(nLedsPerPixel);
 	}
 
-	portInfo.nBeginIndexPort[0] = 0;
+	/*
+	 * The DMX channels per pixel: RGB input for RGBW pixels with white extraction,
+	 * coarse and fine with 16-bit input.
+	 */
+	if (IsEnableWhiteExtraction()) {
+		nLedsPerPixel = 3;
+	}
 
-	if (GetType() == Type::SK6812W) {
-		portInfo.nBeginIndexPort[1] = 128;
-		portInfo.nBeginIndexPort[2] = 256;
-		portInfo.nBeginIndexPort[3] = 384;
-	} else {
-		portInfo.nBeginIndexPort[1] = 170;
-		portInfo.nBeginIndexPort[2] = 340;
-		portInfo.nBeginIndexPort[3] = 510;
+	if (m_bEnableInput16Bit) {
+		nLedsPerPixel *= 2;
+
+		const auto nCountMax = 4U * (lightset::dmx::UNIVERSE_SIZE / nLedsPerPixel);
+
+		if (GetCount() > nCountMax) {
+			SetCount(nCountMax);
+		}
+	}
+
+	const auto nPixelsPerUniverse = lightset::dmx::UNIVERSE_SIZE / nLedsPerPixel;
+
+	for (uint32_t nIndex = 0; nIndex < 4; nIndex++) {
+		portInfo.nBeginIndexPort[nIndex] = nIndex * nPixelsPerUniverse;
 	}
 
 	if ((m_nGroupingCount == 0) || (m_nGroupingCount > GetCount())) {
@@ -99,4 +125,12 @@ void PixelDmxConfiguration::Print() {
 	puts("Pixel DMX configuration");
 	printf(" Outputs : %d\n", m_nOutputPorts);
 	printf(" Grouping count : %d [Groups : %d]\n", m_nGroupingCount, m_nGroups);
+
+	if (m_bEnableInput16Bit) {
+		puts(" Input : 16-bit");
+	}
+
+	if ((m_Layout != pixeldmxconfiguration::Layout::LINEAR) || (m_nLayoutRotate != 0)) {
+		printf(" Layout : %s [Width : %d, Rotate : %d]\n", PixelDmxMapping::GetLayout(m_Layout), m_nLayoutWidth, m_nLayoutRotate);
+	}
 }
@@ -0,0 +1,328 @@
+/**
+ * @file pixeldmxmapping.cpp
+ *
+ */
+/* Copyright (C) 2024 by Arjan van Vught mailto:info@orangepi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cassert>
+
+#include "pixeldmxmapping.h"
+#include "pixeldmxconfiguration.h"
+
+#include "debug.h"
+
+using namespace pixeldmxconfiguration;
+
+PixelDmxMapping::PixelDmxMapping(uint32_t nCount) : m_nCount(nCount) {
+	DEBUG_ENTRY
+
+	assert(nCount != 0);
+	assert(nCount <= UINT16_MAX);
+
+	m_pTable = new uint16_t[nCount];
+	assert(m_pTable != nullptr);
+
+	m_pScratch = new uint16_t[nCount];
+	assert(m_pScratch != nullptr);
+
+	Linear();
+
+	DEBUG_EXIT
+}
+
+PixelDmxMapping::~PixelDmxMapping() {
+	delete[] m_pScratch;
+	m_pScratch = nullptr;
+
+	delete[] m_pTable;
+	m_pTable = nullptr;
+}
+
+bool PixelDmxMapping::Setup(const PixelDmxConfiguration& pixelDmxConfiguration) {
+	DEBUG_ENTRY
+
+	const auto nWidth = pixelDmxConfiguration.GetLayoutWidth();
+
+	Linear();
+
+	switch (pixelDmxConfiguration.GetLayout()) {
+	case Layout::ZIGZAG:
+		ZigZag(nWidth);
+		break;
+	case Layout::TABLE:
+#if !defined(DISABLE_FS)
+		Read(pixeldmxmapping::FILE_NAME);
+#endif
+		break;
+	default:
+		break;
+	}
+
+	Rotate(nWidth, pixelDmxConfiguration.GetLayoutRotate());
+
+	DEBUG_EXIT
+	return !IsLinear();
+}
+
+void PixelDmxMapping::Linear() {
+	for (uint32_t i = 0; i < m_nCount; i++) {
+		m_pTable[i] = static_cast<uint16_t>(i);
+	}
+}
+
+/*
+ * The pixels after the last complete row are linear
+ */
+void PixelDmxMapping::ZigZag(uint32_t nWidth) {
+	if ((nWidth < 2) || (nWidth > m_nCount)) {
+		return;
+	}
+
+	const auto nHeight = m_nCount / nWidth;
+
+	for (uint32_t y = 1; y < nHeight; y += 2) {
+		auto *pRow = &m_pTable[y * nWidth];
+
+		for (uint32_t x = 0; x < (nWidth / 2); x++) {
+			const auto nTemp = pRow[x];
+			pRow[x] = pRow[nWidth - 1 - x];
+			pRow[nWidth - 1 - x] = nTemp;
+		}
+	}
+}
+
+/*
+ * Layout pixel (x, y) is in the DMX data at:
+ *  90: (H - 1 - y, x), the DMX data is H wide
+ * 180: (W - 1 - x, H - 1 - y)
+ * 270: (y, W - 1 - x), the DMX data is H wide
+ */
+void PixelDmxMapping::Rotate(uint32_t nWidth, uint32_t nDegrees) {
+	nDegrees %= 360;
+
+	if ((nWidth == 0) || (nWidth > m_nCount) || (nDegrees == 0) || ((nDegrees % 90) != 0)) {
+		return;
+	}
+
+	const auto nHeight = m_nCount / nWidth;
+
+	memcpy(m_pScratch, m_pTable, m_nCount * sizeof(m_pTable[0]));
+
+	for (uint32_t y = 0; y < nHeight; y++) {
+		for (uint32_t x = 0; x < nWidth; x++) {
+			uint32_t nDmxIndex;
+
+			if (nDegrees == 90) {
+				nDmxIndex = x * nHeight + (nHeight - 1 - y);
+			} else if (nDegrees == 180) {
+				nDmxIndex = (nHeight - 1 - y) * nWidth + (nWidth - 1 - x);
+			} else {
+				nDmxIndex = (nWidth - 1 - x) * nHeight + y;
+			}
+
+			m_pTable[nDmxIndex] = m_pScratch[y * nWidth + x];
+		}
+	}
+}
+
+bool PixelDmxMapping::Load(const char *pBuffer, uint32_t nLength) {
+	DEBUG_ENTRY
+	assert(pBuffer != nullptr);
+
+	ParseBegin();
+
+	while (nLength-- != 0) {
+		if (!Parse(*pBuffer++)) {
+			break;
+		}
+	}
+
+	const auto isValid = ParseEnd();
+
+	DEBUG_EXIT
+	return isValid;
+}
+
+#if !defined(DISABLE_FS)
+bool PixelDmxMapping::Read(const char *pFileName) {
+	DEBUG_ENTRY
+	assert(pFileName != nullptr);
+
+	auto *fp = fopen(pFileName, "r");
+
+	if (fp == nullptr) {
+		DEBUG_EXIT
+		return false;
+	}
+
+	ParseBegin();
+
+	int c;
+
+	while ((c = fgetc(fp)) != EOF) {
+		if (!Parse(static_cast<char>(c))) {
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	const auto isValid = ParseEnd();
+
+	DEBUG_EXIT
+	return isValid;
+}
+#endif
+
+void PixelDmxMapping::ParseBegin() {
+	m_nEntries = 0;
+	m_nValue = 0;
+	m_bIsValue = false;
+	m_bIsComment = false;
+	m_bIsError = false;
+}
+
+bool PixelDmxMapping::Parse(const char c) {
+	if (m_bIsComment) {
+		m_bIsComment = (c != '\n');
+		return true;
+	}
+
+	if ((c >= '0') && (c <= '9')) {
+		m_nValue = (m_nValue * 10) + static_cast<uint32_t>(c - '0');
+		m_bIsValue = true;
+
+		if (m_nValue >= m_nCount) {
+			m_bIsError = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	if (m_bIsValue) {
+		if (m_nEntries == m_nCount) {
+			m_bIsError = true;
+			return false;
+		}
+
+		m_pScratch[m_nEntries++] = static_cast<uint16_t>(m_nValue);
+		m_nValue = 0;
+		m_bIsValue = false;
+	}
+
+	if (c == '#') {
+		m_bIsComment = true;
+		return true;
+	}
+
+	if ((c == ',') || (c == ';') || (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) {
+		return true;
+	}
+
+	m_bIsError = true;
+	return false;
+}
+
+bool PixelDmxMapping::ParseEnd() {
+	if (!m_bIsError) {
+		Parse('\n');
+	}
+
+	if (m_bIsError) {
+		DEBUG_PUTS("Invalid mapping");
+		Linear();
+		return false;
+	}
+
+	// Duplicates, and the pixels that are not in the list
+	const auto nWords = (m_nCount + 31) / 32;
+	auto *pUsed = new uint32_t[nWords];
+	assert(pUsed != nullptr);
+	memset(pUsed, 0, nWords * sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < m_nEntries; i++) {
+		const auto nIndex = m_pScratch[i];
+		const auto nMask = 1U << (nIndex & 31);
+
+		if ((pUsed[nIndex / 32] & nMask) != 0) {
+			DEBUG_PRINTF("Duplicate %u", nIndex);
+			delete[] pUsed;
+			Linear();
+			return false;
+		}
+
+		pUsed[nIndex / 32] |= nMask;
+	}
+
+	auto nEntries = m_nEntries;
+
+	for (uint32_t nIndex = 0; nIndex < m_nCount; nIndex++) {
+		if ((pUsed[nIndex / 32] & (1U << (nIndex & 31))) == 0) {
+			m_pScratch[nEntries++] = static_cast<uint16_t>(nIndex);
+		}
+	}
+
+	delete[] pUsed;
+
+	assert(nEntries == m_nCount);
+	memcpy(m_pTable, m_pScratch, m_nCount * sizeof(m_pTable[0]));
+
+	return true;
+}
+
+bool PixelDmxMapping::IsLinear() const {
+	for (uint32_t i = 0; i < m_nCount; i++) {
+		if (m_pTable[i] != i) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void PixelDmxMapping::Print() {
+	printf(" Mapping : %u pixels [%u %u %u ...]\n", m_nCount, m_pTable[0], m_nCount > 1 ? m_pTable[1] : 0, m_nCount > 2 ? m_pTable[2] : 0);
+}
+
+const char *PixelDmxMapping::GetLayout(Layout layout) {
+	if (layout < Layout::UNDEFINED) {
+		return pixeldmxmapping::LAYOUT[static_cast<uint32_t>(layout)];
+	}
+
+	return "Undefined";
+}
+
+Layout PixelDmxMapping::GetLayout(const char *pString) {
+	assert(pString != nullptr);
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(Layout::UNDEFINED); i++) {
+		if (strcasecmp(pString, pixeldmxmapping::LAYOUT[i]) == 0) {
+			return static_cast<Layout>(i);
+		}
+	}
+
+	return Layout::UNDEFINED;
+}
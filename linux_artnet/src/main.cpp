@@ -51,6 +51,9 @@
 
 #include "dmxmonitor.h"
 #include "dmxmonitorparams.h"
+#if defined (ARTNET_HAVE_DMXIN)
+# include "dmx.h"
+#endif
 
 #include "configstore.h"
 
@@ -100,6 +103,10 @@ int main(int argc, char **argv) {
 	fw.Print();
 	nw.Print();
 
+#if defined (ARTNET_HAVE_DMXIN)
+	Dmx dmx;
+#endif
+
 	ArtNetNode node;
 
 	ArtNetParams artnetParams;
@@ -145,7 +152,13 @@ int main(int argc, char **argv) {
 			if (nPortIndex == 0) {
 				node.SetRdm(static_cast<uint32_t>(0), true);
 			}
-		} else {
+		}
+#if defined (ARTNET_HAVE_DMXIN)
+		else if ((portDirection == lightset::PortDir::INPUT) && (nPortIndex < dmx::config::max::IN)) {
+			node.SetUniverse(nPortIndex, lightset::PortDir::INPUT, nAddress);
+		}
+#endif
+		else {
 			node.SetUniverse(nPortIndex, lightset::PortDir::DISABLE, nAddress);
 		}
 	}
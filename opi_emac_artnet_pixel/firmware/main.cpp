@@ -235,6 +235,7 @@ void main() {
 		llrpOnlyDevice.Run();
 #endif
 		configStore.Flash();
+		pixelDmx.Run();
 		if (__builtin_expect((PixelTestPattern::GetPattern() != pixelpatterns::Pattern::NONE), 0)) {
 			pixelTestPattern.Run();
 		}
@@ -242,6 +242,7 @@ void main() {
 		llrpOnlyDevice.Run();
 #endif
 		configStore.Flash();
+		pixelDmxMulti.Run();
 		if (__builtin_expect((PixelTestPattern::GetPattern() != pixelpatterns::Pattern::NONE), 0)) {
 			pixelTestPattern.Run();
 		}
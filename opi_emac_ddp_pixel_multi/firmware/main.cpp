@@ -185,6 +185,7 @@ void main() {
 		ddpDisplay.Run();
 		remoteConfig.Run();
 		configStore.Flash();
+		pixelDmxMulti.Run();
 		if (__builtin_expect((PixelTestPattern::GetPattern() != pixelpatterns::Pattern::NONE), 0)) {
 			pixelTestPattern.Run();
 		}
@@ -46,6 +46,12 @@ void display_emac_status(const bool isLinkUp) {
 
 void display_ip() {
 	Display::Get()->ClearEndOfLine();
+
+	if (Network::Get()->IsDhcpUsed() && (Network::Get()->GetIp() == 0)) {
+		Display::Get()->Printf(3, "DHCP pending");
+		return;
+	}
+
 	Display::Get()->Printf(3, IPSTR "/%d %c", IP2STR(Network::Get()->GetIp()), static_cast<int>(Network::Get()->GetNetmaskCIDR()), Network::Get()->GetAddressingMode());
 }
 
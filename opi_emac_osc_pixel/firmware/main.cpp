@@ -161,6 +161,7 @@ void main() {
 		server.Run();
 		remoteConfig.Run();
 		configStore.Flash();
+		pixelDmx.Run();
 		if (__builtin_expect((PixelTestPattern::GetPattern() != pixelpatterns::Pattern::NONE), 0)) {
 			pixelTestPattern.Run();
 		}
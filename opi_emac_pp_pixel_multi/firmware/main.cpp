@@ -184,6 +184,7 @@ void main() {
 		pp.Run();
 		remoteConfig.Run();
 		configStore.Flash();
+		pixelDmxMulti.Run();
 		if (__builtin_expect((PixelTestPattern::GetPattern() != pixelpatterns::Pattern::NONE), 0)) {
 			pixelTestPattern.Run();
 		}
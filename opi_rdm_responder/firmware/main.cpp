@@ -224,6 +224,7 @@ void main() {
 		nw.Run();
 		remoteConfig.Run();
 #endif
+		pixelDmx.Run();
 		if (__builtin_expect((PixelTestPattern::GetPattern() != pixelpatterns::Pattern::NONE), 0)) {
 			pixelTestPattern.Run();
 		}
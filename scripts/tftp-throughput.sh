@@ -0,0 +1,34 @@
+#!/bin/bash
+# Measures the TFTP upload throughput of a show file for a range of block sizes (RFC 2348).
+# Usage: tftp-throughput.sh <host> <file> [blksize ...]
+# The node must be built with the show file option, the TFTP server is enabled with OSC.
+# For Linux builds run the node in a separate network namespace, as the TFTP server binds
+# to the port number of the client.
+
+HOST=$1
+FILE=$2
+shift 2
+BLOCK_SIZES=${@:-512 1024 1396 1468}
+
+if [ -z "$HOST" ] || [ ! -f "$FILE" ]; then
+	echo "Usage: $0 <host> <file> [blksize ...]"
+	exit 1
+fi
+
+SIZE=$(stat -c %s "$FILE")
+
+# /showfile/tftp ,i 1
+printf '/showfile/tftp\0\0,i\0\0\0\0\0\1' | nc -u -w 1 $HOST 8000
+
+for BLKSIZE in $BLOCK_SIZES
+	do
+		START=$(date +%s%N)
+		curl -s -T "$FILE" --tftp-blksize $BLKSIZE tftp://$HOST/show99.txt || { echo -e "\e[31mblksize=$BLKSIZE failed\e[0m"; continue; }
+		END=$(date +%s%N)
+		MILLIS=$(( (END - START) / 1000000 ))
+		echo -e "\e[33mblksize=$BLKSIZE\e[0m $SIZE bytes in $MILLIS ms, $(( SIZE / (MILLIS + 1) )) kB/s"
+		sleep 0.5
+	done
+
+# /showfile/tftp ,i 0
+printf '/showfile/tftp\0\0,i\0\0\0\0\0\0' | nc -u -w 1 $HOST 8000